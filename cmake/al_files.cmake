@@ -6,6 +6,9 @@ set(core_headers
   include/al/core/app/al_AudioApp.hpp
   include/al/core/app/al_DistributedApp.hpp
   include/al/core/app/al_FPS.hpp
+  include/al/core/app/al_FramePipeline.hpp
+  include/al/core/app/al_FrameProfiler.hpp
+  include/al/core/app/al_PipelinedWindowApp.hpp
   include/al/core/app/al_WindowApp.hpp
   include/al/core/graphics/al_BufferObject.hpp
   include/al/core/graphics/al_DefaultShaders.hpp
@@ -20,6 +23,7 @@ set(core_headers
   include/al/core/graphics/al_Lens.hpp
   include/al/core/graphics/al_Light.hpp
   include/al/core/graphics/al_Mesh.hpp
+  include/al/core/graphics/al_MeshTopology.hpp
   include/al/core/graphics/al_OpenGL.hpp
   include/al/core/graphics/al_RenderManager.hpp
   include/al/core/graphics/al_Shader.hpp
@@ -28,12 +32,15 @@ set(core_headers
   include/al/core/graphics/al_VAO.hpp
   include/al/core/graphics/al_VAOMesh.hpp
   include/al/core/graphics/al_Viewpoint.hpp
+  include/al/core/io/al_AudioCallbackProfiler.hpp
   include/al/core/io/al_AudioIO.hpp
   include/al/core/io/al_AudioIOData.hpp
+  include/al/core/io/al_AudioOutputStage.hpp
   include/al/core/io/al_ControlNav.hpp
   include/al/core/io/al_CSVReader.hpp
   include/al/core/io/al_File.hpp
   include/al/core/io/al_MIDI.hpp
+  include/al/core/io/al_OfflineAudioBackend.hpp
   include/al/core/io/al_Window.hpp
   include/al/core/math/al_Constants.hpp
   include/al/core/math/al_Mat.hpp
@@ -41,12 +48,15 @@ set(core_headers
   include/al/core/math/al_Quat.hpp
   include/al/core/math/al_StdRandom.hpp
   include/al/core/math/al_Vec.hpp
+  include/al/core/math/al_VecBatch.hpp
   include/al/core/protocol/al_OSC.hpp
   include/al/core/sound/al_Ambisonics.hpp
   include/al/core/sound/al_AudioScene.hpp
   include/al/core/sound/al_Biquad.hpp
+  include/al/core/sound/al_ConvolutionReverb.hpp
   include/al/core/sound/al_Crossover.hpp
   include/al/core/sound/al_Dbap.hpp
+  include/al/core/sound/al_FilterBank.hpp
   include/al/core/sound/al_Lbap.hpp
   include/al/core/sound/al_Reverb.hpp
   include/al/core/sound/al_Spatializer.hpp
@@ -57,14 +67,19 @@ set(core_headers
   include/al/core/spatial/al_Pose.hpp
   include/al/core/system/al_PeriodicThread.hpp
   include/al/core/system/al_Printing.hpp
+  include/al/core/system/al_SharedMemory.hpp
   include/al/core/system/al_Thread.hpp
   include/al/core/system/al_Time.hpp
   include/al/core/types/al_Color.hpp
+  include/al/core/types/al_LockFreeQueue.hpp
+  include/al/core/types/al_TripleBuffer.hpp
 )
 
 set(core_sources
   ${al_path}/src/core/app/al_AudioApp.cpp
   ${al_path}/src/core/app/al_FPS.cpp
+  ${al_path}/src/core/app/al_FramePipeline.cpp
+  ${al_path}/src/core/app/al_FrameProfiler.cpp
   ${al_path}/src/core/app/al_WindowApp.cpp
   ${al_path}/src/core/graphics/al_BufferObject.cpp
   ${al_path}/src/core/graphics/al_DefaultShaders.cpp
@@ -79,6 +94,7 @@ set(core_sources
   ${al_path}/src/core/graphics/al_Lens.cpp
   ${al_path}/src/core/graphics/al_Light.cpp
   ${al_path}/src/core/graphics/al_Mesh.cpp
+  ${al_path}/src/core/graphics/al_MeshTopology.cpp
   ${al_path}/src/core/graphics/al_OpenGL.cpp
   ${al_path}/src/core/graphics/al_RenderManager.cpp
   ${al_path}/src/core/graphics/al_Shader.cpp
@@ -87,20 +103,29 @@ set(core_sources
   ${al_path}/src/core/graphics/al_VAO.cpp
   ${al_path}/src/core/graphics/al_VAOMesh.cpp
   ${al_path}/src/core/graphics/al_Viewpoint.cpp
+  ${al_path}/src/core/io/al_AudioCallbackProfiler.cpp
   ${al_path}/src/core/io/al_AudioIO.cpp
   ${al_path}/src/core/io/al_AudioIOData.cpp
+  ${al_path}/src/core/io/al_AudioOutputStage.cpp
   ${al_path}/src/core/io/al_ControlNav.cpp
   ${al_path}/src/core/io/al_CSVReader.cpp
   ${al_path}/src/core/io/al_File.cpp
   ${al_path}/src/core/io/al_MIDI.cpp
+  ${al_path}/src/core/io/al_OfflineAudioBackend.cpp
   ${al_path}/src/core/io/al_Window.cpp
   ${al_path}/src/core/io/al_WindowGLFW.cpp
   ${al_path}/src/core/math/al_StdRandom.cpp
+  ${al_path}/src/core/math/al_Random.cpp
+  ${al_path}/src/core/math/al_VecBatch.cpp
+  ${al_path}/src/core/math/al_VecBatchAVX.cpp
   ${al_path}/src/core/protocol/al_OSC.cpp
   ${al_path}/src/core/sound/al_Ambisonics.cpp
   ${al_path}/src/core/sound/al_AudioScene.cpp
   ${al_path}/src/core/sound/al_Biquad.cpp
+  ${al_path}/src/core/sound/al_ConvolutionReverb.cpp
   ${al_path}/src/core/sound/al_Dbap.cpp
+  ${al_path}/src/core/sound/al_FilterBank.cpp
+  ${al_path}/src/core/sound/al_FilterBankAVX.cpp
   ${al_path}/src/core/sound/al_Vbap.cpp
   ${al_path}/src/core/sound/al_Spatializer.cpp
   ${al_path}/src/core/sound/al_StereoPanner.cpp
@@ -108,6 +133,7 @@ set(core_sources
   ${al_path}/src/core/spatial/al_Pose.cpp
   ${al_path}/src/core/system/al_PeriodicThread.cpp
   ${al_path}/src/core/system/al_Printing.cpp
+  ${al_path}/src/core/system/al_SharedMemory.cpp
   ${al_path}/src/core/system/al_ThreadNative.cpp
   ${al_path}/src/core/system/al_Time.cpp
   ${al_path}/src/core/types/al_Color.cpp
@@ -116,6 +142,7 @@ set(core_sources
 set(util_headers
   include/al/util/al_Array.h
   include/al/util/al_Array.hpp
+  include/al/util/al_BVH.hpp
   include/al/util/imgui/al_Imgui.hpp
   include/al/util/imgui/imgui_impl_glfw_gl3.h
   include/al/util/ui/al_Composition.hpp
@@ -133,17 +160,20 @@ set(util_headers
   include/al/util/ui/al_ControlGUI.hpp
   include/al/util/scene/al_SynthSequencer.hpp
   include/al/util/scene/al_SynthRecorder.hpp
+  include/al/util/scene/al_SynthEventLog.hpp
   include/al/util/scene/al_DynamicScene.hpp
   include/al/util/scene/al_DistributedScene.hpp
   include/al/util/scene/al_PolySynth.hpp
   include/al/util/scene/al_SequencerMIDI.hpp
   include/al/util/al_Toml.hpp
+  include/al/util/al_TextureLoader.hpp
   include/al/util/sound/al_OutputMaster.hpp
 )
 
 set(util_sources
   ${al_path}/src/util/al_Array_C.c
   ${al_path}/src/util/al_Array.cpp
+  ${al_path}/src/util/al_BVH.cpp
   ${al_path}/src/util/imgui/al_Imgui.cpp
   ${al_path}/src/util/imgui/imgui_impl_glfw_gl3.cpp
   ${al_path}/src/util/ui/al_Composition.cpp
@@ -160,9 +190,11 @@ set(util_sources
   ${al_path}/src/util/ui/al_ControlGUI.cpp
   ${al_path}/src/util/scene/al_SynthSequencer.cpp
   ${al_path}/src/util/scene/al_SynthRecorder.cpp
+  ${al_path}/src/util/scene/al_SynthEventLog.cpp
   ${al_path}/src/util/scene/al_DynamicScene.cpp
   ${al_path}/src/util/scene/al_PolySynth.cpp
   ${al_path}/src/util/al_Toml.cpp
+  ${al_path}/src/util/al_TextureLoader.cpp
   ${al_path}/src/util/sound/al_OutputMaster.cpp
 )
 
@@ -193,6 +225,7 @@ endforeach(src_file IN LISTS module_sources)
 #  include/al/glv/al_GLV.hpp
 #  include/al/glv/glv.h
 #  include/al/glv/glv_behavior.h
+#  include/al/glv/glv_batch.h
 #  include/al/glv/glv_buttons.h
 #  include/al/glv/glv_conf.h
 #  include/al/glv/glv_core.h
@@ -210,6 +243,7 @@ endforeach(src_file IN LISTS module_sources)
 #set(glv_sources
 #  src/glv/al_GLV_draw.cpp
 #  src/glv/al_GLV_wrapper.cpp
+#  src/glv/glv_batch.cpp
 #  src/glv/glv_buttons.cpp
 #  src/glv/glv_core.cpp
 #  src/glv/glv_font.cpp
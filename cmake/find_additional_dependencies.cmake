@@ -127,3 +127,11 @@ if (USE_MPI AND MPI_CXX_FOUND)
 #  list(APPEND ADDITIONAL_HEADERS ${al_path}/include/al/util/al_Font.hpp)
 #  list(APPEND ADDITIONAL_SOURCES ${al_path}/src/util/al_Font.cpp)
 endif()
+
+if (AL_LINUX)
+  # shm_open() for al_SharedMemory lives in librt on older glibc
+  find_library(RT_LIBRARY rt)
+  if (RT_LIBRARY)
+    list(APPEND ADDITIONAL_LIBRARIES ${RT_LIBRARY})
+  endif()
+endif (AL_LINUX)
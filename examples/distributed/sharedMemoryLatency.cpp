@@ -0,0 +1,156 @@
+/*
+Allolib Example: Shared memory state latency
+
+Description:
+Measures the time from publishing a state frame to a reader consuming it,
+comparing SharedMemoryRing (used by DistributedApp when transport = "shm")
+against sending the same frame over UDP on the loopback interface.
+
+Both readers block waiting for the next frame, as a renderer waiting for
+state would.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "al/core/system/al_SharedMemory.hpp"
+
+#ifndef AL_WINDOWS
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+using namespace al;
+
+struct State {
+  int64_t timestamp;
+  int64_t frame;
+  char payload[1008]; // 1 KB frames
+};
+
+static int64_t nowNsec() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char *name, std::vector<int64_t> &latencies) {
+  if (latencies.size() == 0) {
+    std::cout << name << ": no frames received" << std::endl;
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  double mean = 0;
+  for (auto l : latencies) {
+    mean += l;
+  }
+  mean /= latencies.size();
+  std::cout << name << " (" << latencies.size() << " frames)"
+            << " mean " << mean / 1000.0 << " us"
+            << " p50 " << latencies[latencies.size() / 2] / 1000.0 << " us"
+            << " p99 " << latencies[latencies.size() * 99 / 100] / 1000.0 << " us"
+            << " max " << latencies.back() / 1000.0 << " us" << std::endl;
+}
+
+#ifndef AL_WINDOWS
+
+static void benchSharedMemory(int numFrames) {
+  SharedMemoryRing writer;
+  if (!writer.create("al_shm_latency", sizeof(State), 8)) {
+    std::cout << "Could not create shared memory" << std::endl;
+    return;
+  }
+  SharedMemoryRing reader;
+  reader.open("al_shm_latency"); // Separate mapping, as another process would have
+  int id = reader.addReader();
+
+  std::vector<int64_t> latencies;
+  latencies.reserve(numFrames);
+  std::thread readerThread([&]() {
+    State s;
+    while ((int) latencies.size() < numFrames) {
+      if (reader.wait(id, 0.5)) {
+        while (reader.consume(id, &s, sizeof(State))) {
+          latencies.push_back(nowNsec() - s.timestamp);
+        }
+      } else {
+        break;
+      }
+    }
+  });
+
+  State s;
+  std::memset(&s, 0, sizeof(State));
+  for (int i = 0; i < numFrames; i++) {
+    s.frame = i;
+    s.timestamp = nowNsec();
+    writer.publish(&s, sizeof(State));
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+  }
+  readerThread.join();
+  report("Shared memory", latencies);
+}
+
+static void benchUdp(int numFrames) {
+  int recvSocket = socket(AF_INET, SOCK_DGRAM, 0);
+  int sendSocket = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(19123);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(recvSocket, (sockaddr *) &addr, sizeof(addr)) != 0) {
+    std::cout << "Could not bind UDP socket" << std::endl;
+    close(recvSocket);
+    close(sendSocket);
+    return;
+  }
+  timeval tv {0, 500000};
+  setsockopt(recvSocket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  std::vector<int64_t> latencies;
+  latencies.reserve(numFrames);
+  std::thread readerThread([&]() {
+    State s;
+    while ((int) latencies.size() < numFrames) {
+      if (recv(recvSocket, &s, sizeof(State), 0) != sizeof(State)) {
+        break;
+      }
+      latencies.push_back(nowNsec() - s.timestamp);
+    }
+  });
+
+  State s;
+  std::memset(&s, 0, sizeof(State));
+  for (int i = 0; i < numFrames; i++) {
+    s.frame = i;
+    s.timestamp = nowNsec();
+    sendto(sendSocket, &s, sizeof(State), 0, (sockaddr *) &addr, sizeof(addr));
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+  }
+  readerThread.join();
+  close(recvSocket);
+  close(sendSocket);
+  report("UDP loopback", latencies);
+}
+
+#endif
+
+int main() {
+#ifdef AL_WINDOWS
+  std::cout << "Shared memory transport is not available on Windows" << std::endl;
+#else
+  const int numFrames = 5000;
+  std::cout << "Publish to consume latency, " << sizeof(State) << " byte frames" << std::endl;
+  benchSharedMemory(numFrames);
+  benchUdp(numFrames);
+#endif
+  return 0;
+}
@@ -0,0 +1,126 @@
+/*
+Allocore Example: Mesh topology benchmark
+
+Description:
+Measures smoothing, normal generation and subdivision of a 164k vertex
+icosphere using a MeshTopology, against the previous implementations that
+built std::map and std::set adjacency on every call. Also measures Loop
+subdivision on one and on all hardware threads. Does not open a window.
+*/
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <set>
+
+#include "al/core/graphics/al_MeshTopology.hpp"
+#include "al/core/graphics/al_Shapes.hpp"
+
+using namespace al;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Milliseconds per call of f, on a fresh copy of mesh each time
+template <class F>
+static double timeMs(const Mesh &mesh, F f) {
+  const int iterations = 5;
+  double total = 0;
+  for (int i = 0; i < iterations; i++) {
+    Mesh m = mesh;
+    auto start = std::chrono::steady_clock::now();
+    f(m);
+    total += secondsSince(start);
+  }
+  return total / iterations * 1000.0;
+}
+
+// Previous Mesh::smooth, with equal weighting
+static void mapSmooth(Mesh &m) {
+  std::map<int, std::set<int>> nodes;
+  for (size_t i = 0; i < m.indices().size(); i += 3) {
+    int i0 = m.indices()[i], i1 = m.indices()[i + 1], i2 = m.indices()[i + 2];
+    nodes[i0].insert(i1);
+    nodes[i0].insert(i2);
+    nodes[i1].insert(i2);
+    nodes[i1].insert(i0);
+    nodes[i2].insert(i0);
+    nodes[i2].insert(i1);
+  }
+  Mesh::Vertices vertsCopy(m.vertices());
+  for (const auto &node : nodes) {
+    Mesh::Vertex sum(0, 0, 0);
+    for (auto adj : node.second) sum += vertsCopy[adj];
+    sum /= node.second.size();
+    m.vertices()[node.first] = sum;
+  }
+}
+
+// Previous subdivide, with a map from edge to midpoint
+static void mapSubdivide(Mesh &m) {
+  std::map<uint64_t, unsigned> cache;
+  Mesh::Index newIndex = m.vertices().size();
+  Mesh::Indices oldIndices(m.indices());
+  m.indices().clear();
+  for (unsigned j = 0; j < oldIndices.size(); j += 3) {
+    Mesh::Index *corner = &oldIndices[j];
+    Mesh::Index mid[3];
+    for (unsigned i = 0; i < 3; ++i) {
+      uint64_t i1 = corner[i], i2 = corner[(i + 1) % 3];
+      uint64_t key = i1 < i2 ? (i1 << 32) | i2 : (i2 << 32) | i1;
+      auto it = cache.find(key);
+      if (it != cache.end()) {
+        mid[i] = it->second;
+      } else {
+        cache[key] = newIndex;
+        m.vertex((m.vertices()[i1] + m.vertices()[i2]) * 0.5);
+        mid[i] = newIndex++;
+      }
+    }
+    Mesh::Index newIndices[] = {corner[0], mid[0], mid[2], corner[1], mid[1], mid[0],
+                                corner[2], mid[2], mid[1], mid[0],    mid[1], mid[2]};
+    m.index(newIndices, 12);
+  }
+}
+
+int main() {
+  Mesh sphere;
+  addIcosphere(sphere, 1, 7);
+  std::cout << sphere.vertices().size() << " vertices, " << sphere.indices().size() / 3
+            << " triangles (ms per call)" << std::endl;
+
+  MeshTopology topology;
+  std::cout << "  build topology:         "
+            << timeMs(sphere, [&](Mesh &m) { topology.build(m); }) << std::endl;
+
+  std::cout << "  smooth, map/set:        " << timeMs(sphere, mapSmooth) << std::endl;
+  std::cout << "  smooth, Mesh::smooth:   "
+            << timeMs(sphere, [](Mesh &m) { m.smooth(); }) << std::endl;
+  std::cout << "  smooth, built topology: "
+            << timeMs(sphere, [&](Mesh &m) { topology.smooth(m); }) << std::endl;
+  std::cout << "  smooth, all threads:    "
+            << timeMs(sphere, [&](Mesh &m) { topology.smooth(m, 1, 0, 0); }) << std::endl;
+
+  std::cout << "  normals, Mesh:          "
+            << timeMs(sphere, [](Mesh &m) { m.generateNormals(); }) << std::endl;
+  std::cout << "  normals, all threads:   "
+            << timeMs(sphere, [&](Mesh &m) { topology.generateNormals(m, true, false, 0); })
+            << std::endl;
+
+  Mesh small;
+  addIcosphere(small, 1, 5);
+  std::cout << small.vertices().size() << " vertices subdivided twice (ms per call)"
+            << std::endl;
+  std::cout << "  subdivide, map:         " << timeMs(small, [](Mesh &m) {
+    mapSubdivide(m);
+    mapSubdivide(m);
+  }) << std::endl;
+  std::cout << "  subdivide, topology:    "
+            << timeMs(small, [](Mesh &m) { subdivide(m, 2); }) << std::endl;
+  std::cout << "  Loop, 1 thread:         "
+            << timeMs(small, [](Mesh &m) { subdivideLoop(m, 2, 1); }) << std::endl;
+  std::cout << "  Loop, all threads:      "
+            << timeMs(small, [](Mesh &m) { subdivideLoop(m, 2, 0); }) << std::endl;
+  return 0;
+}
@@ -0,0 +1,102 @@
+/*
+Allocore Example: Mesh weld benchmark
+
+Description:
+Welds triangle soups of 100k, 1M and 10M vertices, as produced by importing
+unindexed geometry or scans. Compares the previous Mesh::compress, which
+used a tree of std::maps, with the hashing Mesh::compress and with
+Mesh::weld using a tolerance, on one and on all hardware threads. The map
+version is skipped for the largest mesh. Does not open a window.
+*/
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+
+#include "al/core/graphics/al_Mesh.hpp"
+
+using namespace al;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Previous Mesh::compress, without attributes
+static void mapCompress(Mesh &m) {
+  typedef std::map<float, int> Zmap;
+  typedef std::map<float, Zmap> Ymap;
+  typedef std::map<float, Ymap> Xmap;
+  Xmap xmap;
+  Mesh old(m);
+  for (int i = m.vertices().size() - 1; i >= 0; i--) {
+    Mesh::Vertex &v = m.vertices()[i];
+    xmap[v.x][v.y][v.z] = i;
+  }
+  std::map<int, int> imap;
+  m.reset();
+  for (size_t i = 0; i < old.vertices().size(); i++) {
+    Mesh::Vertex &v = old.vertices()[i];
+    int idx = xmap[v.x][v.y][v.z];
+    auto it = imap.find(idx);
+    if (it != imap.end()) {
+      m.index(it->second);
+    } else {
+      int newidx = m.vertices().size();
+      m.vertex(v);
+      imap[idx] = newidx;
+      m.index(newidx);
+    }
+  }
+}
+
+// Triangle soup of a bumpy grid with about numVertices vertices, six per cell
+static void makeSoup(Mesh &m, size_t numVertices, float jitter) {
+  int n = int(std::sqrt(numVertices / 6.0)) + 1;
+  m.reset();
+  m.vertices().reserve(size_t(n - 1) * (n - 1) * 6);
+  auto pos = [&](int i, int j, int k) {
+    // Copies of a vertex are moved apart by less than jitter
+    float d = jitter * float((k * 7919) % 13) / 13.f;
+    return Vec3f(i + d, j, std::sin(i * 0.1f) * std::cos(j * 0.1f));
+  };
+  int k = 0;
+  for (int j = 0; j < n - 1; j++) {
+    for (int i = 0; i < n - 1; i++) {
+      m.vertex(pos(i, j, k++));
+      m.vertex(pos(i + 1, j, k++));
+      m.vertex(pos(i + 1, j + 1, k++));
+      m.vertex(pos(i, j, k++));
+      m.vertex(pos(i + 1, j + 1, k++));
+      m.vertex(pos(i, j + 1, k++));
+    }
+  }
+}
+
+template <class F>
+static void timeIt(const char *name, const Mesh &soup, F f) {
+  Mesh m = soup;
+  auto start = std::chrono::steady_clock::now();
+  f(m);
+  double ms = secondsSince(start) * 1000.0;
+  std::cout << "  " << name << ms << " ms, " << m.vertices().size() << " vertices left"
+            << std::endl;
+}
+
+int main() {
+  for (size_t numVertices : {100000, 1000000, 10000000}) {
+    Mesh exact, near;
+    makeSoup(exact, numVertices, 0);
+    makeSoup(near, numVertices, 0.001f);
+    std::cout << exact.vertices().size() << " vertices" << std::endl;
+
+    if (numVertices <= 1000000) {
+      timeIt("compress, map:          ", exact, mapCompress);
+    }
+    timeIt("compress:               ", exact, [](Mesh &m) { m.compress(); });
+    timeIt("weld exact, all threads: ", exact, [](Mesh &m) { m.weld(0, 0, 0, 0); });
+    timeIt("weld 0.01, 1 thread:    ", near, [](Mesh &m) { m.weld(0.01f); });
+    timeIt("weld 0.01, all threads: ", near, [](Mesh &m) { m.weld(0.01f, 0, 0, 0); });
+  }
+  return 0;
+}
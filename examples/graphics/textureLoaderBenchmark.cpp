@@ -0,0 +1,81 @@
+/*
+Allocore Example: Texture loader benchmark
+
+Description:
+Writes a set of PNG images and measures how fast TextureLoader decodes them
+with different numbers of threads.
+
+Uploading is not measured as it needs a graphics context, see the
+TextureUploadScheduler for how uploads are split across frames.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "al/util/al_TextureLoader.hpp"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_STATIC
+#include "module/img/stb_image_write.h"
+
+using namespace al;
+
+int main() {
+  const int numImages = 32;
+  const int size = 1024;
+
+  std::vector<std::string> paths;
+  std::vector<uint8_t> pixels(size * size * 4);
+  for (int i = 0; i < numImages; i++) {
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        uint8_t *p = pixels.data() + (y * size + x) * 4;
+        p[0] = (uint8_t) (x + i);
+        p[1] = (uint8_t) (y * i);
+        p[2] = (uint8_t) ((x ^ y) + i);
+        p[3] = 255;
+      }
+    }
+    paths.push_back("textureLoaderBenchmark_" + std::to_string(i) + ".png");
+    stbi_write_png(paths.back().c_str(), size, size, 4, pixels.data(), size * 4);
+  }
+  std::cout << "Decoding " << numImages << " " << size << "x" << size << " images" << std::endl;
+
+  unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  double singleThreadTime = 0;
+  for (unsigned int threads = 1; threads <= maxThreads; threads *= 2) {
+    TextureLoader loader(threads);
+    // Run twice, first pass warms up the file cache
+    for (int pass = 0; pass < 2; pass++) {
+      auto start = std::chrono::steady_clock::now();
+      std::vector<TextureHandle> handles;
+      for (auto &path : paths) {
+        handles.push_back(loader.load(path));
+      }
+      loader.waitForDecodes();
+      double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      for (auto &handle : handles) {
+        if (handle.failed()) {
+          std::cout << "Failed to decode " << handle.path() << std::endl;
+        }
+      }
+      if (threads == 1 && pass == 1) {
+        singleThreadTime = time;
+      }
+      if (pass == 1) {
+        std::cout << threads << " threads: " << time << " s "
+                  << numImages / time << " images/s "
+                  << (singleThreadTime > 0 ? singleThreadTime / time : 1.0) << "x" << std::endl;
+      }
+    }
+  }
+
+  for (auto &path : paths) {
+    std::remove(path.c_str());
+  }
+  return 0;
+}
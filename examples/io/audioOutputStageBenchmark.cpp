@@ -0,0 +1,92 @@
+/*
+Allocore Example: Audio output stage benchmark
+
+Description:
+Compares the separate gain, NaN, clip and interleave passes that the audio
+backends used to make on every buffer with the fused AudioOutputStage
+kernels, for a range of channel counts and buffer sizes. All processing
+flags are enabled, as they are by default in AudioIO.
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "al/core/io/al_AudioOutputStage.hpp"
+
+using namespace al;
+
+// Output processing as done by the backends before AudioOutputStage
+static void legacyOutput(float *buffer, float *output, int channels, int frames,
+                         float gainPrev, float gainNext) {
+  float dgain = (gainNext - gainPrev) / frames;
+  for (int j = 0; j < channels; ++j) {
+    float *out = buffer + j * frames;
+    float gain = gainPrev;
+    for (int i = 0; i < frames; ++i) {
+      out[i] *= gain;
+      gain += dgain;
+    }
+  }
+  for (int i = 0; i < frames * channels; ++i) {
+    float &s = buffer[i];
+    if (s != s) s = 0.f;
+  }
+  for (int i = 0; i < frames * channels; ++i) {
+    float &s = buffer[i];
+    if (s < -1.f)
+      s = -1.f;
+    else if (s > 1.f)
+      s = 1.f;
+  }
+  for (int frame = 0; frame < frames; frame++) {
+    for (int i = 0; i < channels; i++) {
+      *output++ = buffer[i * frames + frame];
+    }
+  }
+}
+
+template <class Function>
+static double nanosecondsPerSample(Function function, int channels, int frames) {
+  // Run for about the same number of samples in every configuration
+  int iterations = std::max(100, 20000000 / (channels * frames));
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    function();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return 1e9 * seconds / ((double)iterations * channels * frames);
+}
+
+int main() {
+  printf("Instruction set: %s\n", AudioOutputStage::instructionSet());
+  printf("%8s %8s %14s %14s %8s\n", "channels", "frames", "legacy ns/smp",
+         "fused ns/smp", "speedup");
+  int flags = AudioOutputStage::GAIN | AudioOutputStage::ZERO_NANS | AudioOutputStage::CLIP;
+  for (int channels : {2, 8, 32, 128}) {
+    for (int frames : {64, 256, 1024}) {
+      std::vector<float> source(channels * frames);
+      for (size_t i = 0; i < source.size(); i++) {
+        source[i] = 1.5f * std::sin(0.01f * i);
+      }
+      std::vector<float> buffer(source);
+      std::vector<float> output(channels * frames);
+
+      double legacy = nanosecondsPerSample([&]() {
+        // The legacy passes work in place, so the callback output has to be
+        // restored each time, as the user callback would have written it
+        std::copy(source.begin(), source.end(), buffer.begin());
+        legacyOutput(buffer.data(), output.data(), channels, frames, 0.9f, 1.0f);
+      }, channels, frames);
+      double fused = nanosecondsPerSample([&]() {
+        std::copy(source.begin(), source.end(), buffer.begin());
+        AudioOutputStage::interleave(flags, buffer.data(), output.data(), channels,
+                                     frames, 0.9f, 1.0f);
+      }, channels, frames);
+      printf("%8d %8d %14.3f %14.3f %7.2fx\n", channels, frames, legacy, fused,
+             legacy / fused);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,148 @@
+/*
+Allolib Example: CSVReader benchmark
+
+Description:
+Writes a synthetic CSV file and compares the time to load it and extract a
+column using CSVReader against a row by row parser that stores each row in
+its own allocation, as CSVReader did before it stored data by column.
+
+Usage: csvreaderBenchmark [number of rows]   (default 10 million)
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "al/core/io/al_CSVReader.hpp"
+
+typedef struct {
+  char s[32];
+  int64_t id;
+  double x, y, z;
+  bool b;
+} Row;
+
+static const size_t rowLength = 32 + 8 + 3 * 8 + 1;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Row by row parser equivalent to the previous implementation of CSVReader
+static double legacyReadSum(std::string fileName, size_t &numRows) {
+  std::vector<char *> data;
+  std::ifstream f(fileName);
+  std::string line;
+  getline(f, line); // Column names
+  while (getline(f, line)) {
+    if (line.size() == 0) {
+      continue;
+    }
+    std::stringstream ss(line);
+    char *row = new char[rowLength];
+    memset(row, 0, rowLength);
+    data.push_back(row);
+    size_t offset = 0;
+    std::string field;
+    std::getline(ss, field, ',');
+    memcpy(row, field.data(), std::min<size_t>(31, field.size()));
+    offset += 32;
+    std::getline(ss, field, ',');
+    int64_t intValue = std::atoi(field.data());
+    memcpy(row + offset, &intValue, sizeof(int64_t));
+    offset += 8;
+    for (int i = 0; i < 3; i++) {
+      std::getline(ss, field, ',');
+      double value = std::atof(field.data());
+      memcpy(row + offset, &value, sizeof(double));
+      offset += 8;
+    }
+    std::getline(ss, field, ',');
+    row[offset] = field == "True" || field == "true" || field == "1";
+  }
+  // getColumn(2)
+  std::vector<double> column;
+  for (auto row : data) {
+    column.push_back(*(double *) (row + 40));
+  }
+  double sum = 0;
+  for (auto value : column) {
+    sum += value;
+  }
+  for (auto row : data) {
+    delete[] row;
+  }
+  numRows = data.size();
+  return sum;
+}
+
+static double readSum(std::string fileName, unsigned int numThreads, size_t &numRows) {
+  CSVReader reader;
+  reader.setNumThreads(numThreads);
+  reader.addType(CSVReader::STRING);
+  reader.addType(CSVReader::INTEGER);
+  reader.addType(CSVReader::REAL);
+  reader.addType(CSVReader::REAL);
+  reader.addType(CSVReader::REAL);
+  reader.addType(CSVReader::BOOLEAN);
+  reader.readFile(fileName);
+  double sum = 0;
+  for (auto value : reader.getColumn(2)) {
+    sum += value;
+  }
+  numRows = reader.numRows();
+  return sum;
+}
+
+int main(int argc, char *argv[]) {
+  size_t numRows = 10000000;
+  if (argc > 1) {
+    numRows = std::strtoull(argv[1], nullptr, 10);
+  }
+  std::string fileName = "csvreaderBenchmark.csv";
+
+  std::cout << "Writing " << numRows << " rows to " << fileName << std::endl;
+  {
+    FILE *f = fopen(fileName.c_str(), "w");
+    if (!f) {
+      std::cout << "Could not write " << fileName << std::endl;
+      return -1;
+    }
+    fprintf(f, "name,id,x,y,z,flag\n");
+    srand(0);
+    for (size_t i = 0; i < numRows; i++) {
+      fprintf(f, "sensor%zu,%zu,%.6f,%.6f,%.6f,%s\n", i % 64, i,
+              rand() / (double) RAND_MAX * 100.0 - 50.0,
+              rand() / (double) RAND_MAX,
+              rand() / (double) RAND_MAX * 1e4,
+              (i % 3) ? "True" : "False");
+    }
+    fclose(f);
+  }
+
+  size_t rows = 0;
+  auto start = std::chrono::steady_clock::now();
+  double sum = legacyReadSum(fileName, rows);
+  double legacyTime = secondsSince(start);
+  std::cout << "Row by row:      " << legacyTime << " s (" << rows << " rows, sum " << sum << ")" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  sum = readSum(fileName, 1, rows);
+  double singleTime = secondsSince(start);
+  std::cout << "CSVReader 1 thread: " << singleTime << " s (" << rows << " rows, sum " << sum << ")"
+            << " speedup " << legacyTime / singleTime << "x" << std::endl;
+
+  unsigned int numThreads = std::thread::hardware_concurrency();
+  start = std::chrono::steady_clock::now();
+  sum = readSum(fileName, numThreads, rows);
+  double parallelTime = secondsSince(start);
+  std::cout << "CSVReader " << numThreads << " threads: " << parallelTime << " s (" << rows << " rows, sum " << sum << ")"
+            << " speedup " << legacyTime / parallelTime << "x" << std::endl;
+
+  std::remove(fileName.c_str());
+  return 0;
+}
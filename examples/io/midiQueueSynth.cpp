@@ -0,0 +1,95 @@
+/*
+Allocore Example: Sample accurate MIDI synth
+
+Description:
+MIDI input is queued with the time each message arrives and processed in the
+audio callback, where notes are triggered at the frame within the buffer
+that matches their timing instead of at the start of the buffer.
+*/
+
+#include "Gamma/Envelope.h"
+#include "Gamma/Oscillator.h"
+
+#include "al/core.hpp"
+#include "al/core/io/al_MIDI.hpp"
+#include "al/util/scene/al_PolySynth.hpp"
+
+using namespace al;
+
+class SineEnv : public SynthVoice {
+public:
+  SineEnv() {
+    mAmpEnv.curve(0);
+    mAmpEnv.sustainPoint(1);
+  }
+
+  SineEnv &freq(float v) {
+    mOsc.freq(v);
+    return *this;
+  }
+  SineEnv &amp(float v) {
+    mAmp = v;
+    return *this;
+  }
+
+  void onProcess(AudioIOData &io) override {
+    while (io()) {
+      float s = mOsc() * mAmpEnv() * mAmp;
+      io.out(0) += s;
+      io.out(1) += s;
+    }
+    if (mAmpEnv.done()) free();
+  }
+
+  void onTriggerOn() override { mAmpEnv.reset(); }
+  void onTriggerOff() override { mAmpEnv.release(); }
+
+protected:
+  float mAmp{0.2f};
+  gam::Sine<> mOsc;
+  gam::Env<2> mAmpEnv{0.f, 0.005f, 1.f, 0.5f, 0.f};
+};
+
+struct MyApp : public App {
+  MIDIIn midiIn;
+  MIDIMessageQueue midiQueue;
+  PolySynth synth;
+
+  void onCreate() override {
+    if (midiIn.getPortCount() > 0) {
+      // The queue receives the messages on the MIDI thread
+      midiQueue.bindTo(midiIn);
+      int port = midiIn.getPortCount() - 1;
+      midiIn.openPort(port);
+      printf("Opened port to %s\n", midiIn.getPortName(port).c_str());
+    } else {
+      printf("Error: No MIDI devices found.\n");
+    }
+  }
+
+  void onSound(AudioIOData &io) override {
+    midiQueue.audioBlock(io.framesPerBuffer(), io.framesPerSecond());
+    MIDIMessage m(0, 0, 0);
+    int offsetFrames;
+    while (midiQueue.pop(m, offsetFrames)) {
+      if (m.type() == MIDIByte::NOTE_ON && m.velocity() > 0) {
+        SineEnv *voice = synth.getVoice<SineEnv>();
+        voice->freq(noteToHz(m.noteNumber())).amp(m.velocity() * 0.2);
+        synth.triggerOn(voice, offsetFrames, m.noteNumber());
+      } else if (m.type() == MIDIByte::NOTE_OFF ||
+                 m.type() == MIDIByte::NOTE_ON) {
+        synth.triggerOff(m.noteNumber());
+      }
+    }
+    synth.render(io);
+  }
+};
+
+int main() {
+  MyApp app;
+  // Pre-allocate voices, so none are allocated in the audio callback
+  app.synth.allocatePolyphony<SineEnv>(32);
+  app.initAudio(44100., 256, 2, 0);
+  gam::Domain::master().spu(app.audioIO().framesPerSecond());
+  app.start();
+}
@@ -0,0 +1,76 @@
+/*
+Allocore Example: Offline audio benchmark
+
+Description:
+Renders a bank of sine oscillators with the offline audio backend, as fast
+as possible, and reports how many times faster than real time each voice
+count renders. No audio device is needed, so this can run on CI machines.
+
+Any AudioApp can be rendered offline the same way by placing an audio.toml
+file next to the application with:
+
+    backend = "offline"
+    offlineDuration = 10.0
+    offlineOutputFile = "render.wav"
+
+Usage: offlineAudioBenchmark [output.wav]
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "al/core/io/al_AudioIO.hpp"
+
+using namespace al;
+
+struct SineBank {
+  std::vector<double> phases;
+  std::vector<double> increments;
+
+  void resize(int voices, double sampleRate) {
+    phases.assign(voices, 0.0);
+    increments.resize(voices);
+    for (int i = 0; i < voices; i++) {
+      increments[i] = 2.0 * M_PI * (110.0 + 10.0 * i) / sampleRate;
+    }
+  }
+};
+
+static void sineBankCallback(AudioIOData &io) {
+  SineBank &bank = io.user<SineBank>();
+  float scale = 0.5f / bank.phases.size();
+  while (io()) {
+    float sum = 0;
+    for (size_t i = 0; i < bank.phases.size(); i++) {
+      sum += std::sin(bank.phases[i]);
+      bank.phases[i] += bank.increments[i];
+      if (bank.phases[i] > 2.0 * M_PI) bank.phases[i] -= 2.0 * M_PI;
+    }
+    io.out(0) = io.out(1) = sum * scale;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  const double duration = 10.0;
+  const double sampleRate = 44100;
+  printf("%8s %12s %10s\n", "voices", "realtime x", "cpu");
+  for (int voices : {1, 10, 100, 1000}) {
+    SineBank bank;
+    bank.resize(voices, sampleRate);
+
+    AudioIO io;
+    OfflineAudioConfig config;
+    config.duration = duration;
+    if (argc > 1 && voices == 100) {
+      config.outputFile = argv[1];
+    }
+    io.offline(config);
+    io.init(sineBankCallback, &bank, 512, sampleRate, 2, 0);
+    io.start();
+    io.offlineBackend().wait();
+    printf("%8d %12.1f %10.4f\n", voices, io.offlineBackend().realtimeFactor(), io.cpu());
+    io.close();
+  }
+  return 0;
+}
@@ -0,0 +1,71 @@
+/*
+Allocore Example: Random bulk generation benchmark
+
+Description:
+Measures generating uniform and normal variates and points in a ball one at
+a time against filling arrays with the bulk functions of rnd::Random, for
+the Tausworthe, linear congruential and Philox generators.
+*/
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "al/core/math/al_Random.hpp"
+#include "al/core/math/al_Vec.hpp"
+
+using namespace al;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Millions of values per second of f(), which generates n values
+template <class F>
+static double throughput(size_t n, F f) {
+  const int iterations = 2000;
+  f(); // Warm up
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    f();
+  }
+  return n * iterations / secondsSince(start) / 1e6;
+}
+
+template <class RNG>
+static void run(const char *name) {
+  const size_t n = 4096;
+  std::vector<uint32_t> bits(n);
+  std::vector<float> values(n);
+  std::vector<Vec3f> points(n);
+  rnd::Random<RNG> rng(1);
+  float sink = 0; // Keeps the single value loops from being optimized away
+
+  std::cout << name << " (millions per second, single / bulk)" << std::endl;
+  std::cout.precision(0);
+  std::cout << std::fixed;
+  std::cout << "  integers: "
+            << throughput(n, [&]() {
+                 uint32_t sum = 0;
+                 for (size_t i = 0; i < n; i++) sum += rng.rng()();
+                 sink += sum;
+               }) << " / "
+            << throughput(n, [&]() { rng.rng()(bits.data(), n); }) << std::endl;
+  std::cout << "  uniform:  "
+            << throughput(n, [&]() { for (size_t i = 0; i < n; i++) values[i] = rng.uniform(); })
+            << " / " << throughput(n, [&]() { rng.uniform(values.data(), n); }) << std::endl;
+  std::cout << "  normal:   "
+            << throughput(n, [&]() { for (size_t i = 0; i < n; i++) values[i] = rng.normal(); })
+            << " / " << throughput(n, [&]() { rng.normal(values.data(), n); }) << std::endl;
+  std::cout << "  ball<3>:  "
+            << throughput(n, [&]() { for (size_t i = 0; i < n; i++) rng.ball(points[i]); })
+            << " / " << throughput(n, [&]() { rng.ball(points.data(), n); }) << std::endl;
+  if (sink == 1.f) std::cout << std::endl;
+}
+
+int main() {
+  run<rnd::Tausworthe>("Tausworthe");
+  run<rnd::LinCon>("LinCon");
+  run<rnd::Philox>("Philox");
+  return 0;
+}
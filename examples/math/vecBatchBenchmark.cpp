@@ -0,0 +1,95 @@
+/*
+Allocore Example: VecBatch benchmark
+
+Description:
+Measures the throughput of the VecBatch array operations for each instruction
+set available on this machine, against calling the Vec, Quat and Mat
+functions in a loop. Arrays of 1024 elements are used so the data stays in
+the cache.
+*/
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "al/core/math/al_VecBatch.hpp"
+
+using namespace al;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Millions of elements per second of f(), which processes n elements
+template <class F>
+static double throughput(size_t n, F f) {
+  const int iterations = 2000;
+  f(); // Warm up
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    f();
+  }
+  return n * iterations / secondsSince(start) / 1e6;
+}
+
+template <class T>
+static void run(const char *typeName) {
+  const size_t n = 1024;
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<T> uniform(-1, 1);
+  std::vector<Vec<3, T>> a(n), b(n), out(n);
+  std::vector<Quat<T>> qa(n), qb(n), qout(n);
+  std::vector<T> dots(n);
+  for (size_t i = 0; i < n; i++) {
+    a[i] = Vec<3, T>(uniform(rng), uniform(rng), uniform(rng));
+    b[i] = Vec<3, T>(uniform(rng), uniform(rng), uniform(rng));
+    qa[i] = Quat<T>().fromEuler(uniform(rng), uniform(rng), uniform(rng));
+    qb[i] = Quat<T>().fromEuler(uniform(rng), uniform(rng), uniform(rng));
+  }
+  Quat<T> q = qa[0];
+  Mat<4, T> m = Mat<4, T>::identity();
+  m(0, 3) = 1; // Translation
+
+  std::cout << typeName << " (millions of elements per second)" << std::endl;
+  std::cout << "            rotate  rotate each  transform  normalize    dot   quat mul" << std::endl;
+  auto print = [](const char *name, double r, double re, double t, double nrm,
+                  double d, double qm) {
+    std::cout.precision(0);
+    std::cout << std::fixed << "  " << name << r << "\t" << re << "\t" << t
+              << "\t" << nrm << "\t" << d << "\t" << qm << std::endl;
+  };
+
+  print("loop:    ",
+        throughput(n, [&]() { for (size_t i = 0; i < n; i++) out[i] = q.rotate(a[i]); }),
+        throughput(n, [&]() { for (size_t i = 0; i < n; i++) out[i] = qa[i].rotate(a[i]); }),
+        throughput(n, [&]() {
+          for (size_t i = 0; i < n; i++) out[i] = Vec<3, T>(m * Vec<4, T>(a[i], 1));
+        }),
+        throughput(n, [&]() { for (size_t i = 0; i < n; i++) out[i] = a[i].normalized(); }),
+        throughput(n, [&]() { for (size_t i = 0; i < n; i++) dots[i] = a[i].dot(b[i]); }),
+        throughput(n, [&]() { for (size_t i = 0; i < n; i++) qout[i] = qa[i] * qb[i]; }));
+
+  for (auto set : VecBatch::instructionSets()) {
+    VecBatch::useInstructionSet(set);
+    std::string name = std::string(set) + ":         ";
+    print(name.substr(0, 9).c_str(),
+          throughput(n, [&]() { VecBatch::rotate(q, a.data(), out.data(), n); }),
+          throughput(n, [&]() { VecBatch::rotate(qa.data(), a.data(), out.data(), n); }),
+          throughput(n, [&]() { VecBatch::transform(m, a.data(), out.data(), n); }),
+          throughput(n, [&]() {
+            out = a;
+            VecBatch::normalize(out.data(), n);
+          }),
+          throughput(n, [&]() { VecBatch::dot(a.data(), b.data(), dots.data(), n); }),
+          throughput(n, [&]() { VecBatch::multiply(qa.data(), qb.data(), qout.data(), n); }));
+  }
+  VecBatch::useInstructionSet(VecBatch::instructionSets()[0]);
+}
+
+int main() {
+  std::cout << "Using " << VecBatch::instructionSet() << " by default" << std::endl;
+  run<float>("Vec3f / Quatf");
+  run<double>("Vec3d / Quatd");
+  return 0;
+}
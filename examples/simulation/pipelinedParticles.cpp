@@ -0,0 +1,81 @@
+/*
+Allocore Example: Pipelined particles
+
+Description:
+Particles orbiting a few moving attractors, simulated on a worker thread
+while the previous frame renders. The simulation state is kept in a plain
+struct that is handed to rendering through a triple buffer. Press 'p' to
+print the time spent in each stage of the frame loop.
+*/
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "al/core/app/al_PipelinedWindowApp.hpp"
+#include "al/core/math/al_Random.hpp"
+
+using namespace al;
+
+struct ParticleState {
+  std::vector<Vec3f> pos;
+  std::vector<Vec3f> vel;
+  double time = 0;
+};
+
+struct MyApp : PipelinedWindowApp<ParticleState> {
+  Mesh mesh{Mesh::POINTS};
+
+  void onCreate() override {
+    const int N = 20000;
+    state().pos.resize(N);
+    state().vel.resize(N);
+    for (int i = 0; i < N; i++) {
+      state().pos[i] = rnd::ball<Vec3f>();
+      state().vel[i] = rnd::ball<Vec3f>() * 0.1f;
+    }
+  }
+
+  // Runs on the simulation thread
+  void onSimulate(double dt, ParticleState& s) override {
+    s.time += dt;
+    Vec3f attractors[3];
+    for (int k = 0; k < 3; k++) {
+      double phase = s.time * 0.3 + k * 2.1;
+      attractors[k] = Vec3f(std::cos(phase), std::sin(phase * 1.3), 0) * 0.6f;
+    }
+    for (size_t i = 0; i < s.pos.size(); i++) {
+      Vec3f acc(0, 0, 0);
+      for (auto& a : attractors) {
+        Vec3f r = a - s.pos[i];
+        float d = std::max(r.mag(), 0.1f);
+        acc += r / (d * d * d) * 0.02f;
+      }
+      s.vel[i] += acc * dt;
+      s.pos[i] += s.vel[i] * dt;
+    }
+  }
+
+  // Runs on the main thread with the state simulated in the previous frame
+  void onDraw(Graphics& g, const ParticleState& s) override {
+    mesh.reset();
+    for (auto& p : s.pos) mesh.vertex(p);
+    g.clear(0);
+    g.camera(Viewpoint::IDENTITY);
+    g.pointSize(2);
+    g.color(1, 0.8, 0.5, 1);
+    g.draw(mesh);
+  }
+
+  void onKeyDown(Keyboard const& k) override {
+    if (k.key() == 'p') pipeline().stats().print();
+  }
+};
+
+int main() {
+  MyApp app;
+  app.dimensions(800, 800);
+  app.start();
+  app.pipeline().stats().print();
+  return 0;
+}
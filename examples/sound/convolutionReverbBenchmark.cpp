@@ -0,0 +1,82 @@
+/*
+Allocore Example: Convolution reverb benchmark
+
+Description:
+Measures the time taken by ConvolutionReverb to process a stereo audio
+buffer for impulse responses from 0.5 to 10 seconds long. Buffers are
+processed at the rate an audio device would request them, so the worker
+thread has the same time to compute tail partitions as it would in an audio
+callback. Reports the mean and maximum time per buffer as a fraction of the
+buffer duration, with all partitions computed in the calling thread and with
+the tail computed by the worker.
+
+Usage: convolutionReverbBenchmark [framesPerBuffer]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "al/core/sound/al_ConvolutionReverb.hpp"
+
+using namespace al;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+  const double sampleRate = 48000;
+  unsigned int blockSize = argc > 1 ? std::atoi(argv[1]) : 256;
+  double blockSeconds = blockSize / sampleRate;
+  int numBlocks = int(2.0 / blockSeconds);
+
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> uniform(-1, 1);
+  std::vector<float> left(blockSize), right(blockSize);
+  float *buffers[2] = {left.data(), right.data()};
+
+  std::printf("Stereo, %u frame buffers at %.0f Hz, %s\n", blockSize, sampleRate,
+              ConvolutionReverb::instructionSet());
+  std::printf("IR (s)  partitions  worker  mean load  max load  late tails\n");
+  for (double irSeconds : {0.5, 1.0, 2.0, 5.0, 10.0}) {
+    // Exponentially decaying noise
+    uint32_t irLength = uint32_t(irSeconds * sampleRate);
+    std::vector<float> irLeft(irLength), irRight(irLength);
+    for (uint32_t i = 0; i < irLength; i++) {
+      float decay = std::exp(-6.9f * i / irLength);
+      irLeft[i] = uniform(rng) * decay * 0.05f;
+      irRight[i] = uniform(rng) * decay * 0.05f;
+    }
+
+    for (bool tailThread : {false, true}) {
+      ConvolutionReverb reverb;
+      reverb.configure(blockSize, {irLeft.data(), irRight.data()}, irLength, tailThread);
+      double total = 0, maxTime = 0;
+      auto deadline = std::chrono::steady_clock::now();
+      for (int b = 0; b < numBlocks; b++) {
+        for (unsigned int i = 0; i < blockSize; i++) {
+          left[i] = uniform(rng) * 0.5f;
+          right[i] = uniform(rng) * 0.5f;
+        }
+        auto blockStart = std::chrono::steady_clock::now();
+        reverb.process(buffers, 2, blockSize);
+        double t = secondsSince(blockStart);
+        total += t;
+        maxTime = std::max(maxTime, t);
+        deadline += std::chrono::microseconds(int64_t(blockSeconds * 1e6));
+        std::this_thread::sleep_until(deadline);
+      }
+      std::printf("%6.1f  %10u  %6s  %8.1f%%  %7.1f%%  %10llu\n", irSeconds,
+                  reverb.numPartitions(), tailThread ? "yes" : "no",
+                  100 * total / numBlocks / blockSeconds, 100 * maxTime / blockSeconds,
+                  (unsigned long long)reverb.lateTails());
+    }
+  }
+  return 0;
+}
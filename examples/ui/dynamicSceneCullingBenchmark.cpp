@@ -0,0 +1,89 @@
+/*
+Allocore Example: DynamicScene culling benchmark
+
+Description:
+Measures the cost of culling 10000 voices of a DynamicScene against the view
+frustum, for a single view and for the six cube face projections of an omni
+renderer. Does not open a window, the graphics matrices are built directly.
+*/
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "al/util/scene/al_DynamicScene.hpp"
+
+using namespace al;
+
+class BenchmarkVoice : public PositionedVoice {
+public:
+  virtual void update(double dt) override { mUpdates++; }
+  int mUpdates {0};
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+  const int numVoices = 10000;
+  const int iterations = 200;
+
+  DynamicScene scene(0, PolySynth::TIME_MASTER_ASYNC);
+  scene.allocatePolyphony<BenchmarkVoice>(numVoices);
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> uniform(-50.0f, 50.0f);
+  for (int i = 0; i < numVoices; i++) {
+    auto *voice = scene.getVoice<BenchmarkVoice>();
+    voice->pose().pos() = Vec3d(uniform(rng), uniform(rng), uniform(rng));
+    voice->size() = 0.5f;
+    scene.triggerOn(voice);
+  }
+  scene.update(0); // Activate voices
+
+  Matrix4f projection = Matrix4f::perspective(90.0f, 1.0f, 0.1f, 1000.0f);
+  // Views looking along the six cube faces, like an omni renderer's projections
+  Matrix4f faces[6] = {
+    Matrix4f::identity(),
+    Matrix4f::rotate(M_PI, 0, 1, 0),
+    Matrix4f::rotate(M_PI / 2, 0, 1, 0),
+    Matrix4f::rotate(-M_PI / 2, 0, 1, 0),
+    Matrix4f::rotate(M_PI / 2, 1, 0, 0),
+    Matrix4f::rotate(-M_PI / 2, 1, 0, 0)
+  };
+
+  std::cout << numVoices << " voices" << std::endl;
+
+  auto run = [&](const char *name, int numViews) {
+    scene.resetCullingStats();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      for (int view = 0; view < numViews; view++) {
+        scene.cullVoices(faces[view], projection);
+      }
+    }
+    double time = secondsSince(start) / iterations;
+    auto stats = scene.cullingStats();
+    std::cout << "  " << name << ": " << time * 1e6 << " us per frame, "
+              << time * 1e9 / (numVoices * numViews) << " ns per voice, "
+              << double(stats.drawn) / (iterations * numViews) << " of " << numVoices
+              << " voices visible per view (frustum culled "
+              << double(stats.frustumCulled) / (iterations * numViews)
+              << ", distance culled " << double(stats.distanceCulled) / (iterations * numViews)
+              << ")" << std::endl;
+  };
+
+  scene.setFrustumCulling(true);
+  run("Frustum, 1 view       ", 1);
+  run("Frustum, 6 projections", 6);
+  scene.setMaxDrawDistance(40);
+  run("Frustum + distance 40 ", 6);
+  scene.setLodCallback([](PositionedVoice &, float distance) { return distance < 20; });
+  run("With LOD callback     ", 6);
+
+  // Culled voices keep updating
+  auto start = std::chrono::steady_clock::now();
+  scene.update(0.01);
+  std::cout << "  Update of all voices: " << secondsSince(start) * 1e6 << " us" << std::endl;
+  return 0;
+}
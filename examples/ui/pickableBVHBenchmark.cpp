@@ -0,0 +1,111 @@
+/*
+Allocore Example: Pickable BVH benchmark
+
+Description:
+Measures ray picking through the PickableManager's bounding volume
+hierarchy against testing every pickable, for 1000, 10000 and 100000
+pickables. Also measures refitting after moving 1% of the pickables and
+rebuilding the hierarchy in the background. Does not open a window.
+*/
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+
+#include "al/util/ui/al_PickableManager.hpp"
+
+using namespace al;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+  Mesh box;
+  addCube(box, false, 0.05f);
+
+  for (int numPickables : {1000, 10000, 100000}) {
+    std::mt19937 rng(numPickables);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    float extent = 2.0f * std::cbrt(float(numPickables)) * 0.1f;
+
+    std::unique_ptr<Pickable[]> pickables(new Pickable[numPickables]);
+    PickableManager manager;
+    for (int i = 0; i < numPickables; i++) {
+      pickables[i].set(box);
+      pickables[i].pose = Pose(Vec3f(uniform(rng), uniform(rng), uniform(rng)) * extent,
+                               Quatf().fromEuler(uniform(rng), uniform(rng), uniform(rng)));
+      manager << pickables[i];
+    }
+
+    const int numRays = 1000;
+    std::vector<Rayd> rays;
+    for (int i = 0; i < numRays; i++) {
+      rays.push_back(Rayd(Vec3d(0, 0, extent * 3),
+                          Vec3d(uniform(rng) * 0.3, uniform(rng) * 0.3, -1)));
+    }
+
+    std::cout << numPickables << " pickables" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    manager.updateBVH();
+    std::cout << "  Build:            " << secondsSince(start) * 1000.0 << " ms, depth "
+              << manager.bvh().depth() << ", cost " << manager.bvh().cost() << std::endl;
+
+    int hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto &ray : rays) {
+      hits += manager.intersect(ray).hit ? 1 : 0;
+    }
+    double bvhTime = secondsSince(start) / numRays;
+    std::cout << "  BVH query:        " << bvhTime * 1e6 << " us (" << hits << " hits)" << std::endl;
+
+    // Linear search is slow for large counts, use fewer rays
+    int linearRays = numPickables >= 100000 ? 20 : 200;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < linearRays; i++) {
+      manager.intersectAll(rays[i]);
+    }
+    double linearTime = secondsSince(start) / linearRays;
+    std::cout << "  Linear query:     " << linearTime * 1e6 << " us, speedup "
+              << linearTime / bvhTime << "x" << std::endl;
+
+    // Move 1% of the pickables, then query to refit
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numPickables; i += 100) {
+      pickables[i].pose.setPos(Vec3f(uniform(rng), uniform(rng), uniform(rng)) * extent);
+    }
+    manager.updateBVH();
+    std::cout << "  Move 1% + refit:  " << secondsSince(start) * 1000.0 << " ms, cost "
+              << manager.bvh().cost() << std::endl;
+
+    // Move everything, so refitting degrades the tree, and rebuild
+    for (int i = 0; i < numPickables; i++) {
+      pickables[i].pose.setPos(Vec3f(uniform(rng), uniform(rng), uniform(rng)) * extent);
+    }
+    manager.updateBVH();
+    float refitCost = manager.bvh().cost();
+    start = std::chrono::steady_clock::now();
+    if (!manager.bvh().rebuilding()) {
+      manager.bvh().rebuildAsync();
+    }
+    double queryWhileRebuilding = 0;
+    int queries = 0;
+    // intersect() swaps in the new tree once it is ready
+    while (manager.bvh().rebuilding()) {
+      auto queryStart = std::chrono::steady_clock::now();
+      manager.intersect(rays[queries % numRays]);
+      queryWhileRebuilding += secondsSince(queryStart);
+      queries++;
+    }
+    std::cout << "  Background build: " << secondsSince(start) * 1000.0 << " ms, cost "
+              << refitCost << " -> " << manager.bvh().cost() << ", " << queries
+              << " queries answered meanwhile";
+    if (queries > 0) {
+      std::cout << " (" << queryWhileRebuilding / queries * 1e6 << " us each)";
+    }
+    std::cout << std::endl;
+  }
+  return 0;
+}
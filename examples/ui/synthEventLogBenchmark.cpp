@@ -0,0 +1,89 @@
+/*
+Allolib Example: Synth event log throughput
+
+Description:
+Pushes 50,000 trigger events per second into a SynthEventLog from a thread
+that wakes once per audio buffer, as an audio callback would. Reports how
+many events reached the file, how many were dropped and the worst time spent
+logging in a single buffer. The log is then read back to check it is
+complete.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+
+#include "al/util/scene/al_SynthEventLog.hpp"
+
+using namespace al;
+
+class BenchVoice : public SynthVoice {
+public:
+  Parameter freq {"freq", "", 440.0};
+  Parameter amp {"amp", "", 0.5};
+  Parameter attack {"attack", "", 0.01};
+  Parameter release {"release", "", 0.2};
+  Parameter pan {"pan", "", 0.0};
+
+  BenchVoice() {
+    registerTriggerParameters(freq, amp, attack, release, pan);
+  }
+};
+
+int main() {
+  const double eventsPerSecond = 50000;
+  const double seconds = 5.0;
+  const double sampleRate = 44100;
+  const int framesPerBuffer = 256;
+  const double bufferPeriod = framesPerBuffer / sampleRate;
+  const int eventsPerBuffer = int(eventsPerSecond * bufferPeriod) + 1;
+  const int numBuffers = int(seconds / bufferPeriod);
+  std::string fileName = "benchmark.synthLog";
+
+  BenchVoice voice;
+  SynthEventLog log;
+  if (!log.open(fileName)) {
+    return -1;
+  }
+
+  std::vector<double> bufferTimes;
+  bufferTimes.reserve(numBuffers);
+  auto nextBuffer = std::chrono::steady_clock::now();
+  int eventCount = 0;
+  for (int buffer = 0; buffer < numBuffers; buffer++) {
+    double time = buffer * bufferPeriod;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < eventsPerBuffer; i += 2) {
+      voice.id(eventCount);
+      voice.freq.set(220.0 + (eventCount % 100));
+      log.logTriggerOn(&voice, time);
+      log.logTriggerOff(eventCount, time + bufferPeriod * 0.5);
+      eventCount++;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    bufferTimes.push_back(elapsed.count());
+    nextBuffer += std::chrono::microseconds(int(bufferPeriod * 1e6));
+    std::this_thread::sleep_until(nextBuffer);
+  }
+  log.close();
+
+  std::sort(bufferTimes.begin(), bufferTimes.end());
+  uint64_t pushed = log.eventsWritten() + log.eventsDropped();
+  std::cout << "Pushed " << pushed << " events in " << seconds << " s ("
+            << pushed / seconds << " events/s)" << std::endl;
+  std::cout << "Written: " << log.eventsWritten()
+            << " Dropped: " << log.eventsDropped() << std::endl;
+  std::cout << "Time logging per buffer (" << eventsPerBuffer << " events):"
+            << " p50 " << bufferTimes[bufferTimes.size() / 2] * 1e6 << " us"
+            << " p99 " << bufferTimes[bufferTimes.size() * 99 / 100] * 1e6 << " us"
+            << " max " << bufferTimes.back() * 1e6 << " us"
+            << " (buffer period " << bufferPeriod * 1e6 << " us)" << std::endl;
+
+  std::vector<SynthEvent> events;
+  SynthEventLog::read(fileName, events);
+  std::cout << "Read back " << events.size() << " events" << std::endl;
+  std::remove(fileName.c_str());
+  return 0;
+}
@@ -77,7 +77,12 @@
 
 */
 
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 // #include "al/core/graphics/al_Graphics.hpp"
 #include "al/core/types/al_Color.hpp"
 #include "al/core/graphics/al_Mesh.hpp"
@@ -139,8 +144,21 @@ public:
 
 
 	/// Import an asset
+
+	/// If a cache directory has been set, a binary cache of the processed
+	/// scene is written there on first import. Later imports of the same file
+	/// with the same preset map the cache and do not run the importer.
 	static Scene * import(const std::string& path, ImportPreset preset = MAX_QUALITY);
 
+	/// Set directory for scene caches. An empty string disables caching (default).
+	static void cacheDirectory(const std::string& directory);
+
+	/// Get directory for scene caches
+	static std::string cacheDirectory();
+
+	/// Whether the scene was loaded from a cache file
+	bool fromCache() const;
+
 
 	/// Return number of meshes in scene
 	unsigned int meshes() const;
@@ -198,6 +216,52 @@ protected:
 	Scene(Impl * impl);
 };
 
+
+/// Imports scenes in a background thread
+
+/// Request all assets needed at startup with prefetch(), then collect them
+/// with take() when they are needed. Scenes are imported in the order they
+/// were requested, using the cache if one has been set with
+/// Scene::cacheDirectory().
+/// @ingroup allocore
+class ScenePrefetcher {
+public:
+	ScenePrefetcher();
+
+	/// Stops loading. Scenes not taken are deleted.
+	~ScenePrefetcher();
+
+	/// Queue a scene for import
+	void prefetch(const std::string& path, Scene::ImportPreset preset = Scene::MAX_QUALITY);
+
+	/// Whether a queued scene has finished loading
+	bool ready(const std::string& path);
+
+	/// Wait for a queued scene and take ownership of it
+
+	/// @return nullptr if the import failed or path was not queued
+	Scene * take(const std::string& path);
+
+private:
+	struct Request {
+		std::string path;
+		Scene::ImportPreset preset;
+	};
+	struct Result {
+		bool done {false};
+		Scene * scene {nullptr};
+	};
+
+	void loaderFunction();
+
+	std::thread mThread;
+	std::mutex mLock;
+	std::condition_variable mCondition;
+	std::deque<Request> mRequests;
+	std::map<std::string, Result> mResults;
+	bool mRunning {true};
+};
+
 } // al::
 
 #endif /* include guard */
@@ -0,0 +1,178 @@
+#ifndef INCLUDE_AL_GRAPHICS_ASSET_CACHE_HPP
+#define INCLUDE_AL_GRAPHICS_ASSET_CACHE_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012-2019. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+	File description:
+	Binary cache of imported 3D asset scenes
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "al_ext/assets3d/al_Asset.hpp"
+
+namespace al {
+
+/**
+ * @brief Binary image of an imported Scene
+ *
+ * Holds the processed meshes, materials and node names of a Scene in a single
+ * block of memory. Vertex attributes and indices are stored as contiguous
+ * arrays aligned to 16 bytes, ready to be copied into a Mesh or uploaded to
+ * the GPU.
+ *
+ * The block is written to disk as is, and mapped back into memory with map(),
+ * so loading a cached scene does not parse the file or run assimp. The cache
+ * file records the hash and size of the source file and the import preset,
+ * and map() rejects caches that do not match. map() also rejects caches whose
+ * arrays fall outside the file or whose indices refer to missing vertices,
+ * so a damaged cache falls back to importing the source.
+ *
+ * Build a cache by calling the add functions followed by finish().
+ */
+class SceneCache {
+public:
+  static const uint32_t version = 1;
+
+  SceneCache() {}
+  ~SceneCache();
+
+  SceneCache(const SceneCache &) = delete;
+  SceneCache &operator=(const SceneCache &) = delete;
+
+  /// Add a mesh. Pointers that are nullptr mark attributes the mesh does not have.
+  void addMesh(const std::string &name, unsigned int materialIndex, Mesh::Primitive primitive,
+               unsigned int numVertices, const Vec3f *positions, const Vec3f *normals,
+               const Color *colors, const Vec2f *texCoords,
+               const std::vector<unsigned int> &indices);
+
+  void addMaterial(const Scene::Material &material);
+
+  void addNode(const std::string &name);
+
+  void setBounds(const Vec3f &min, const Vec3f &max) { mMin = min; mMax = max; }
+
+  void setNumTextures(unsigned int numTextures) { mNumTextures = numTextures; }
+
+  /// Lay out added data in a single block. Must be called before reading.
+  void finish(uint64_t sourceHash, uint64_t sourceSize, int preset);
+
+  /// Write block to file. The file is replaced atomically.
+  bool write(const std::string &path) const;
+
+  /**
+   * @brief Map a cache file into memory
+   * @return false if file does not exist, is damaged or was not created from
+   * a source with this hash, size and preset.
+   */
+  bool map(const std::string &path, uint64_t sourceHash, uint64_t sourceSize, int preset);
+
+  bool valid() const { return mData != nullptr; }
+
+  unsigned int meshes() const;
+  std::string meshName(unsigned int i) const;
+  unsigned int meshMaterial(unsigned int i) const;
+  Mesh::Primitive meshPrimitive(unsigned int i) const;
+  unsigned int meshVertices(unsigned int i) const;
+  unsigned int meshIndices(unsigned int i) const;
+  const Vec3f *positions(unsigned int i) const;
+  const Vec3f *normals(unsigned int i) const; ///< nullptr if mesh has no normals
+  const Color *colors(unsigned int i) const; ///< nullptr if mesh has no colors
+  const Vec2f *texCoords(unsigned int i) const; ///< nullptr if mesh has no texture coordinates
+  const unsigned int *indices(unsigned int i) const;
+
+  unsigned int materials() const;
+  void material(unsigned int i, Scene::Material &material) const;
+
+  unsigned int nodes() const;
+  std::string nodeName(unsigned int i) const;
+
+  unsigned int textures() const;
+
+  void getBounds(Vec3f &min, Vec3f &max) const;
+
+  /// Size in bytes of cache data
+  size_t size() const { return mSize; }
+
+  /**
+   * @brief Hash the contents of a file
+   * @return false if file could not be read
+   */
+  static bool hashFile(const std::string &path, uint64_t &hash, uint64_t &size);
+
+  /// File name of the cache for a source file in cache directory
+  static std::string cachePath(const std::string &cacheDirectory, const std::string &sourcePath,
+                               uint64_t sourceHash, int preset);
+
+private:
+  struct Header;
+  struct MeshRecord;
+  struct MaterialRecord;
+  struct StringRecord;
+
+  struct PendingMesh {
+    std::string name;
+    unsigned int materialIndex;
+    Mesh::Primitive primitive;
+    std::vector<Vec3f> positions;
+    std::vector<Vec3f> normals;
+    std::vector<Color> colors;
+    std::vector<Vec2f> texCoords;
+    std::vector<unsigned int> indices;
+  };
+
+  const Header *header() const;
+  const MeshRecord *meshRecord(unsigned int i) const;
+  std::string string(const StringRecord &record) const;
+  void unmap();
+
+  // Data added before finish()
+  std::vector<PendingMesh> mPendingMeshes;
+  std::vector<Scene::Material> mPendingMaterials;
+  std::vector<std::string> mPendingNodes;
+  Vec3f mMin, mMax;
+  unsigned int mNumTextures {0};
+
+  std::vector<char> mBlock; // Owned data, when not mapped
+  const char *mData {nullptr};
+  size_t mSize {0};
+  void *mMapped {nullptr};
+};
+
+} // al::
+
+#endif
@@ -0,0 +1,93 @@
+/*
+Allocore Example: Scene cache benchmark
+
+Description:
+Compares the time to import a model and extract its meshes without a cache,
+on the first import with a cache (cold) and on later imports that map the
+cache (warm). Then prefetches all the models given in the background.
+
+Usage: assetCacheBenchmark [model files...]   (default data/ducky.obj)
+*/
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "al/core/io/al_File.hpp"
+#include "al_ext/assets3d/al_Asset.hpp"
+
+using namespace al;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double timeLoad(const std::string& path, size_t& numVertices, bool& fromCache) {
+  auto start = std::chrono::steady_clock::now();
+  Scene* scene = Scene::import(path);
+  if (!scene) {
+    return -1;
+  }
+  Mesh mesh;
+  scene->meshAll(mesh);
+  double time = secondsSince(start);
+  numVertices = mesh.vertices().size();
+  fromCache = scene->fromCache();
+  delete scene;
+  return time;
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++) {
+    paths.push_back(argv[i]);
+  }
+  if (paths.size() == 0) {
+    paths.push_back("data/ducky.obj");
+  }
+  std::string cacheDirectory = "assetCacheBenchmark";
+
+  for (auto& path : paths) {
+    size_t numVertices = 0;
+    bool fromCache = false;
+    std::cout << path << std::endl;
+
+    Scene::cacheDirectory("");
+    double uncached = timeLoad(path, numVertices, fromCache);
+    if (uncached < 0) {
+      std::cout << "  Could not import" << std::endl;
+      continue;
+    }
+    std::cout << "  No cache: " << uncached << " s (" << numVertices << " vertices)" << std::endl;
+
+    Dir::removeRecursively(cacheDirectory);
+    Scene::cacheDirectory(cacheDirectory);
+    double cold = timeLoad(path, numVertices, fromCache);
+    std::cout << "  Cold:     " << cold << " s" << (fromCache ? " (from cache!)" : "") << std::endl;
+
+    double warm = 0;
+    const int warmRuns = 5;
+    for (int i = 0; i < warmRuns; i++) {
+      warm += timeLoad(path, numVertices, fromCache);
+    }
+    warm /= warmRuns;
+    std::cout << "  Warm:     " << warm << " s" << (fromCache ? "" : " (cache not used!)")
+              << " speedup " << uncached / warm << "x" << std::endl;
+  }
+
+  // All caches are warm now, load them all in the background
+  auto start = std::chrono::steady_clock::now();
+  {
+    ScenePrefetcher prefetcher;
+    for (auto& path : paths) {
+      prefetcher.prefetch(path);
+    }
+    for (auto& path : paths) {
+      delete prefetcher.take(path);
+    }
+  }
+  std::cout << "Prefetched " << paths.size() << " scenes in " << secondsSince(start) << " s" << std::endl;
+
+  Dir::removeRecursively(cacheDirectory);
+  return 0;
+}
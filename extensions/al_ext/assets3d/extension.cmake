@@ -13,9 +13,11 @@ else()
   
   set(THIS_EXTENSION_SRC
     "${CMAKE_CURRENT_LIST_DIR}/src/al_Asset.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/src/al_AssetCache.cpp"
   )
   set(THIS_EXTENSION_HEADERS
     "${CMAKE_CURRENT_LIST_DIR}/al_Asset.hpp"
+    "${CMAKE_CURRENT_LIST_DIR}/al_AssetCache.hpp"
   )
 
   set(THIS_EXTENSION_LIBRARIES
@@ -42,4 +44,15 @@ else()
 
   message("libs: ${CURRENT_EXTENSION_LIBRARIES}")
 
+  # unit tests
+  add_executable(assetCacheTests ${CMAKE_CURRENT_LIST_DIR}/unitTests/utAssetCache.cpp)
+  target_link_libraries(assetCacheTests al ${THIS_EXTENSION_LIBRARY_NAME} ${THIS_EXTENSION_LIBRARIES})
+  target_include_directories(assetCacheTests PUBLIC "${CMAKE_CURRENT_SOURCE_DIR}/external/catch" ${ASSIMP_INCLUDE_DIR})
+  set_target_properties(assetCacheTests PROPERTIES
+    CXX_STANDARD 14
+    CXX_STANDARD_REQUIRED ON
+    )
+  add_test(NAME assetCacheTests
+    COMMAND $<TARGET_FILE:assetCacheTests> ${TEST_ARGS})
+
 endif()
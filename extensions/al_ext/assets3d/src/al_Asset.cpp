@@ -1,4 +1,5 @@
 #include "al_ext/assets3d/al_Asset.hpp"
+#include "al_ext/assets3d/al_AssetCache.hpp"
 // #include "al/core/graphics/al_Graphics.hpp"
 
 #include "assimp/Importer.hpp"
@@ -11,6 +12,7 @@
 
 #include <stdio.h>
 #include <map>
+#include <memory>
 #include <algorithm> // min,max
 
 using namespace al;
@@ -56,9 +58,11 @@ int countNodes(const aiNode * n) {
 
 class Scene::Node::Impl {
 public:
-	Impl(const aiNode * node) : node(node) {}
+	Impl(const aiNode * node) : node(node), name(node->mName.data) {}
+	Impl(const std::string& name) : node(nullptr), name(name) {}
 	
-	const aiNode * node;
+	const aiNode * node; // nullptr if scene was loaded from cache
+	std::string name;
 };
 
 
@@ -69,8 +73,15 @@ public:
 		addNode(scene->mRootNode, 0);
 	}
 	
+	Impl(std::unique_ptr<SceneCache> sceneCache) : scene(nullptr), cache(std::move(sceneCache)) {
+		nodes.resize(cache->nodes());
+		for (unsigned int i=0; i<cache->nodes(); i++) {
+			nodes[i].mImpl = new Scene::Node::Impl(cache->nodeName(i));
+		}
+	}
+	
 	~Impl() {
-		aiReleaseImport(scene);
+		if (scene) aiReleaseImport(scene);
 	}
 	
 	int addNode(const aiNode * n, int idx) {
@@ -82,7 +93,8 @@ public:
 		return idx;
 	}
 	
-	const aiScene * scene;
+	const aiScene * scene; // nullptr if scene was loaded from cache
+	std::unique_ptr<SceneCache> cache;
 	
 	std::map<const aiNode *, int> nodeMap;
 	std::vector<Node> nodes;
@@ -113,7 +125,7 @@ Scene::Node :: Node() : mImpl(0) {}
 Scene::Node :: ~Node() { if (mImpl) delete mImpl; }
 
 std::string Scene::Node :: name() const {
-	return std::string(mImpl->node->mName.data);
+	return mImpl->name;
 }
 
 void Scene::verbose(bool b) {
@@ -121,7 +133,80 @@ void Scene::verbose(bool b) {
 }
 
 
+static std::mutex cacheDirectoryLock;
+static std::string cacheDirectoryPath;
+
+void Scene::cacheDirectory(const std::string& directory) {
+	std::lock_guard<std::mutex> lk(cacheDirectoryLock);
+	cacheDirectoryPath = directory;
+}
+
+std::string Scene::cacheDirectory() {
+	std::lock_guard<std::mutex> lk(cacheDirectoryLock);
+	return cacheDirectoryPath;
+}
+
+static_assert(sizeof(aiVector3D) == sizeof(Vec3f), "aiVector3D must match Vec3f");
+static_assert(sizeof(aiColor4D) == sizeof(Color), "aiColor4D must match Color");
+
+static void writeSceneCache(const Scene& s, const aiScene * scene, const std::string& cacheFile,
+                            uint64_t hash, uint64_t size, int preset) {
+	SceneCache cache;
+	for (unsigned int i=0; i<scene->mNumMeshes; i++) {
+		const aiMesh * amesh = scene->mMeshes[i];
+		Mesh::Primitive prim = Mesh::POINTS;
+		if (amesh->mNumFaces > 0) {
+			switch(amesh->mFaces[0].mNumIndices) {
+				case 2: prim = Mesh::LINES; break;
+				case 3: prim = Mesh::TRIANGLES; break;
+				default: prim = Mesh::POINTS; break;
+			}
+		}
+		std::vector<Vec2f> texCoords;
+		if (amesh->mTextureCoords[0]) {
+			texCoords.resize(amesh->mNumVertices);
+			for (unsigned int v=0; v<amesh->mNumVertices; v++) {
+				texCoords[v] = vec2FromAIVector3D(amesh->mTextureCoords[0][v]);
+			}
+		}
+		std::vector<unsigned int> indices;
+		for (unsigned int t=0; t<amesh->mNumFaces; t++) {
+			const aiFace& face = amesh->mFaces[t];
+			indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
+		}
+		cache.addMesh(amesh->mName.data, amesh->mMaterialIndex, prim, amesh->mNumVertices,
+		              reinterpret_cast<const Vec3f *>(amesh->mVertices),
+		              reinterpret_cast<const Vec3f *>(amesh->mNormals),
+		              reinterpret_cast<const Color *>(amesh->mColors[0]),
+		              amesh->mTextureCoords[0] ? texCoords.data() : nullptr,
+		              indices);
+	}
+	for (unsigned int i=0; i<s.materials(); i++) {
+		cache.addMaterial(s.material(i));
+	}
+	for (unsigned int i=0; i<s.nodes(); i++) {
+		cache.addNode(s.node(i).name());
+	}
+	Vec3f min, max;
+	s.getBounds(min, max);
+	cache.setBounds(min, max);
+	cache.setNumTextures(s.textures());
+	cache.finish(hash, size, preset);
+	cache.write(cacheFile);
+}
+
 Scene * Scene :: import(const std::string& path, ImportPreset preset) {
+	std::string cacheDir = cacheDirectory();
+	std::string cacheFile;
+	uint64_t hash = 0, size = 0;
+	if (cacheDir.size() > 0 && SceneCache::hashFile(path, hash, size)) {
+		cacheFile = SceneCache::cachePath(cacheDir, path, hash, preset);
+		std::unique_ptr<SceneCache> cache(new SceneCache);
+		if (cache->map(cacheFile, hash, size, preset)) {
+			return new Scene(new Impl(std::move(cache)));
+		}
+	}
+
 	initLogStream();
 	int flags=0;
 	switch (preset) {
@@ -139,6 +224,9 @@ Scene * Scene :: import(const std::string& path, ImportPreset preset) {
 	if (scene) {
 		Impl * impl = new Impl(scene);
 		Scene * s = new Scene(impl);
+		if (cacheFile.size() > 0) {
+			writeSceneCache(*s, scene, cacheFile, hash, size, preset);
+		}
 		return s;
 	} else {
         return nullptr;
@@ -148,6 +236,14 @@ Scene * Scene :: import(const std::string& path, ImportPreset preset) {
 
 Scene :: Scene(Impl * impl) : mImpl(impl) {
 	
+	if (mImpl->cache) {
+		mMaterials.resize(materials());
+		for (unsigned int i=0; i<materials(); i++) {
+			mImpl->cache->material(i, mMaterials[i]);
+		}
+		return;
+	}
+
 	mMaterials.resize(materials());
 	for (unsigned int i=0; i<materials(); i++) {
 		Scene::Material& m = mMaterials[i];
@@ -234,11 +330,35 @@ Scene :: ~Scene() {
 	delete mImpl;
 }
 
+bool Scene :: fromCache() const {
+	return mImpl->cache != nullptr;
+}
+
 unsigned int Scene :: meshes() const {
+	if (mImpl->cache) return mImpl->cache->meshes();
 	return mImpl->scene->mNumMeshes;
 }
 
 void Scene :: mesh(unsigned int i, Mesh& mesh) const {
+	if (mImpl->cache && i < meshes()) {
+		const SceneCache& cache = *mImpl->cache;
+		const Vec3f * positions = cache.positions(i);
+		const Vec3f * normals = cache.normals(i);
+		const Color * colors = cache.colors(i);
+		const Vec2f * texCoords = cache.texCoords(i);
+		const unsigned int * indices = cache.indices(i);
+		unsigned int numIndices = cache.meshIndices(i);
+		mesh.primitive(cache.meshPrimitive(i));
+		mesh.vertices().reserve(mesh.vertices().size() + numIndices);
+		for (unsigned int k = 0; k < numIndices; k++) {
+			unsigned int index = indices[k];
+			if (colors) mesh.color(colors[index]);
+			if (normals) mesh.normal(normals[index]);
+			if (texCoords) mesh.texCoord(texCoords[index]);
+			mesh.vertex(positions[index]);
+		}
+		return;
+	}
 	if (i < meshes()) {
 		aiMesh * amesh = mImpl->scene->mMeshes[i];
 		if (amesh) {
@@ -281,6 +401,24 @@ void Scene :: mesh(unsigned int i, Mesh& mesh) const {
 }
 
 void Scene :: meshAlt(unsigned int i, Mesh& mesh) const {
+	if (mImpl->cache && i < meshes()) {
+		// Cached arrays are already in the layout used by Mesh
+		const SceneCache& cache = *mImpl->cache;
+		unsigned int numVertices = cache.meshVertices(i);
+		mesh.primitive(cache.meshPrimitive(i));
+		if (cache.colors(i)) {
+			mesh.colors().insert(mesh.colors().end(), cache.colors(i), cache.colors(i) + numVertices);
+		}
+		if (cache.normals(i)) {
+			mesh.normals().insert(mesh.normals().end(), cache.normals(i), cache.normals(i) + numVertices);
+		}
+		if (cache.texCoords(i)) {
+			mesh.texCoord2s().insert(mesh.texCoord2s().end(), cache.texCoords(i), cache.texCoords(i) + numVertices);
+		}
+		mesh.vertices().insert(mesh.vertices().end(), cache.positions(i), cache.positions(i) + numVertices);
+		mesh.indices().insert(mesh.indices().end(), cache.indices(i), cache.indices(i) + cache.meshIndices(i));
+		return;
+	}
 	if (i < meshes()) {
 		aiMesh * amesh = mImpl->scene->mMeshes[i];
 		if (amesh) {
@@ -334,6 +472,9 @@ const Scene::Material& Scene :: material(unsigned int i) const {
 }
 
 unsigned int Scene :: meshMaterial(unsigned int i) const {
+	if (mImpl->cache) {
+		return i < meshes() ? mImpl->cache->meshMaterial(i) : 0;
+	}
 	if (i < meshes()) {
 		aiMesh * amesh = mImpl->scene->mMeshes[i];
 		if (amesh) {
@@ -344,6 +485,9 @@ unsigned int Scene :: meshMaterial(unsigned int i) const {
 }
 
 std::string Scene :: meshName(unsigned int i) const {
+	if (mImpl->cache) {
+		return i < meshes() ? mImpl->cache->meshName(i) : std::string();
+	}
 	if (i < meshes()) {
 		aiMesh * amesh = mImpl->scene->mMeshes[i];
 		if (amesh) {
@@ -354,10 +498,12 @@ std::string Scene :: meshName(unsigned int i) const {
 }
 
 unsigned int Scene :: materials() const {
+	if (mImpl->cache) return mImpl->cache->materials();
 	return mImpl->scene->mNumMaterials;
 }
 
 unsigned int Scene :: textures() const {
+	if (mImpl->cache) return mImpl->cache->textures();
 	return mImpl->scene->mNumTextures;
 }
 
@@ -395,6 +541,10 @@ void get_bounding_box_for_node(const aiScene * scene, const struct aiNode* nd, V
 }
 		
 void Scene :: getBounds(Vec3f& min, Vec3f& max) const {
+	if (mImpl->cache) {
+		mImpl->cache->getBounds(min, max);
+		return;
+	}
     aiMatrix4x4 trafo;
 	aiIdentityMatrix4(&trafo);
 	min.set(1e10f, 1e10f, 1e10f);
@@ -416,6 +566,26 @@ void dumpNode(aiNode * x, std::string indent) {
 void Scene :: print() const {
 	printf("==================================================\n");
 	printf("Scene\n");
+	if (mImpl->cache) {
+		const SceneCache& cache = *mImpl->cache;
+		printf("Loaded from cache (%zu bytes)\n", cache.size());
+		printf("%d Meshes\n", meshes());
+		for (unsigned int i=0; i<meshes(); i++) {
+			printf("\t%d: %s", i, cache.meshName(i).c_str());
+			printf("\t\t%d vertices, %d indices; material: %d; normals?%d colors?%d texcoords?%d\n", cache.meshVertices(i), cache.meshIndices(i), cache.meshMaterial(i), cache.normals(i) != nullptr, cache.colors(i) != nullptr, cache.texCoords(i) != nullptr);
+		}
+		printf("%d Materials\n", materials());
+		for (unsigned int i=0; i<materials(); i++) {
+			printf("\t%d: %s\n", i, mMaterials[i].name.c_str());
+		}
+		printf("%d Textures\n", textures());
+		printf("%d Nodes\n", nodes());
+		for (unsigned int i=0; i<nodes(); i++) {
+			printf("\tNode (%s)\n", node(i).name().c_str());
+		}
+		printf("==================================================\n");
+		return;
+	}
 	
 	printf("%d Meshes\n", meshes());
 	for (unsigned int i=0; i<mImpl->scene->mNumMeshes; i++) {
@@ -469,6 +639,68 @@ void Scene :: print() const {
 	
 	printf("==================================================\n");
 }
-		
-		
-		
+
+
+ScenePrefetcher :: ScenePrefetcher() {
+	initLogStream(); // Not thread safe, so initialize here
+	mThread = std::thread(&ScenePrefetcher::loaderFunction, this);
+}
+
+ScenePrefetcher :: ~ScenePrefetcher() {
+	{
+		std::unique_lock<std::mutex> lk(mLock);
+		mRunning = false;
+	}
+	mCondition.notify_all();
+	mThread.join();
+	for (auto& result : mResults) {
+		delete result.second.scene;
+	}
+}
+
+void ScenePrefetcher :: prefetch(const std::string& path, Scene::ImportPreset preset) {
+	{
+		std::unique_lock<std::mutex> lk(mLock);
+		if (mResults.find(path) != mResults.end()) {
+			return;
+		}
+		mResults[path] = Result();
+		mRequests.push_back({path, preset});
+	}
+	mCondition.notify_all();
+}
+
+bool ScenePrefetcher :: ready(const std::string& path) {
+	std::unique_lock<std::mutex> lk(mLock);
+	auto result = mResults.find(path);
+	return result != mResults.end() && result->second.done;
+}
+
+Scene * ScenePrefetcher :: take(const std::string& path) {
+	std::unique_lock<std::mutex> lk(mLock);
+	if (mResults.find(path) == mResults.end()) {
+		return nullptr;
+	}
+	mCondition.wait(lk, [&]() { return mResults[path].done; });
+	Scene * scene = mResults[path].scene;
+	mResults.erase(path);
+	return scene;
+}
+
+void ScenePrefetcher :: loaderFunction() {
+	std::unique_lock<std::mutex> lk(mLock);
+	while (true) {
+		mCondition.wait(lk, [&]() { return !mRunning || mRequests.size() > 0; });
+		if (!mRunning) {
+			break;
+		}
+		Request request = mRequests.front();
+		mRequests.pop_front();
+		lk.unlock();
+		Scene * scene = Scene::import(request.path, request.preset);
+		lk.lock();
+		mResults[request.path].scene = scene;
+		mResults[request.path].done = true;
+		mCondition.notify_all();
+	}
+}
@@ -0,0 +1,529 @@
+#include "al_ext/assets3d/al_AssetCache.hpp"
+#include "al/core/io/al_File.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#ifndef AL_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace al;
+
+namespace {
+
+const char kCacheMagic[8] = {'A', 'L', 'S', 'C', 'E', 'N', 'E', '\0'};
+const uint64_t kAlignment = 16;
+
+uint64_t align(uint64_t offset) {
+	return (offset + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+} // namespace
+
+struct SceneCache::StringRecord {
+	uint64_t offset;
+	uint64_t length;
+};
+
+struct SceneCache::Header {
+	char magic[8];
+	uint32_t version;
+	int32_t preset;
+	uint64_t sourceHash;
+	uint64_t sourceSize;
+	uint64_t totalSize;
+	uint32_t numMeshes;
+	uint32_t numMaterials;
+	uint32_t numNodes;
+	uint32_t numTextures;
+	float boundsMin[4];
+	float boundsMax[4];
+	uint64_t meshesOffset;
+	uint64_t materialsOffset;
+	uint64_t nodesOffset;
+};
+
+struct SceneCache::MeshRecord {
+	StringRecord name;
+	uint32_t materialIndex;
+	uint32_t primitive;
+	uint32_t numVertices;
+	uint32_t numIndices;
+	uint64_t positions;
+	uint64_t normals; // 0 if not present
+	uint64_t colors;
+	uint64_t texCoords;
+	uint64_t indices;
+};
+
+struct SceneCache::MaterialRecord {
+	static const int numTextures = 11;
+
+	StringRecord name;
+	StringRecord background;
+	StringRecord textures[numTextures];
+	int32_t useTexture[numTextures];
+	int32_t two_sided, wireframe, shading_model, blend_func;
+	float diffuse[4], ambient[4], specular[4], emissive[4], transparent[4], reflective[4];
+	float shininess, shininess_strength, opacity, reflectivity, refracti, bump_scaling;
+};
+
+namespace {
+
+// Texture properties in the order they are stored
+Scene::Material::TextureProperty *textureProperty(Scene::Material &m, int i) {
+	Scene::Material::TextureProperty *properties[] = {
+		&m.diffusemap, &m.ambientmap, &m.specularmap, &m.opacitymap, &m.emissivemap,
+		&m.shininessmap, &m.lightmap, &m.normalmap, &m.heightmap, &m.displacementmap,
+		&m.reflectionmap
+	};
+	return properties[i];
+}
+
+} // namespace
+
+SceneCache::~SceneCache() {
+	unmap();
+}
+
+void SceneCache::addMesh(const std::string &name, unsigned int materialIndex, Mesh::Primitive primitive,
+                         unsigned int numVertices, const Vec3f *positions, const Vec3f *normals,
+                         const Color *colors, const Vec2f *texCoords,
+                         const std::vector<unsigned int> &indices) {
+	mPendingMeshes.push_back(PendingMesh());
+	PendingMesh &mesh = mPendingMeshes.back();
+	mesh.name = name;
+	mesh.materialIndex = materialIndex;
+	mesh.primitive = primitive;
+	mesh.positions.assign(positions, positions + numVertices);
+	if (normals) {
+		mesh.normals.assign(normals, normals + numVertices);
+	}
+	if (colors) {
+		mesh.colors.assign(colors, colors + numVertices);
+	}
+	if (texCoords) {
+		mesh.texCoords.assign(texCoords, texCoords + numVertices);
+	}
+	mesh.indices = indices;
+}
+
+void SceneCache::addMaterial(const Scene::Material &material) {
+	mPendingMaterials.push_back(material);
+}
+
+void SceneCache::addNode(const std::string &name) {
+	mPendingNodes.push_back(name);
+}
+
+void SceneCache::finish(uint64_t sourceHash, uint64_t sourceSize, int preset) {
+	unmap();
+
+	// Lay out fixed size records first, then arrays and strings
+	uint64_t offset = align(sizeof(Header));
+	uint64_t meshesOffset = offset;
+	offset = align(offset + sizeof(MeshRecord) * mPendingMeshes.size());
+	uint64_t materialsOffset = offset;
+	offset = align(offset + sizeof(MaterialRecord) * mPendingMaterials.size());
+	uint64_t nodesOffset = offset;
+	offset = align(offset + sizeof(StringRecord) * mPendingNodes.size());
+
+	std::vector<MeshRecord> meshRecords(mPendingMeshes.size());
+	for (size_t i = 0; i < mPendingMeshes.size(); i++) {
+		PendingMesh &mesh = mPendingMeshes[i];
+		MeshRecord &record = meshRecords[i];
+		memset(&record, 0, sizeof(MeshRecord));
+		record.materialIndex = mesh.materialIndex;
+		record.primitive = mesh.primitive;
+		record.numVertices = (uint32_t) mesh.positions.size();
+		record.numIndices = (uint32_t) mesh.indices.size();
+		record.positions = offset;
+		offset = align(offset + sizeof(Vec3f) * mesh.positions.size());
+		if (mesh.normals.size() > 0) {
+			record.normals = offset;
+			offset = align(offset + sizeof(Vec3f) * mesh.normals.size());
+		}
+		if (mesh.colors.size() > 0) {
+			record.colors = offset;
+			offset = align(offset + sizeof(Color) * mesh.colors.size());
+		}
+		if (mesh.texCoords.size() > 0) {
+			record.texCoords = offset;
+			offset = align(offset + sizeof(Vec2f) * mesh.texCoords.size());
+		}
+		record.indices = offset;
+		offset = align(offset + sizeof(unsigned int) * mesh.indices.size());
+	}
+
+	// Strings are appended at the end
+	std::string strings;
+	uint64_t stringsOffset = offset;
+	auto addString = [&](const std::string &s) {
+		StringRecord record {stringsOffset + strings.size(), s.size()};
+		strings += s;
+		return record;
+	};
+	for (size_t i = 0; i < mPendingMeshes.size(); i++) {
+		meshRecords[i].name = addString(mPendingMeshes[i].name);
+	}
+	std::vector<MaterialRecord> materialRecords(mPendingMaterials.size());
+	for (size_t i = 0; i < mPendingMaterials.size(); i++) {
+		Scene::Material &m = mPendingMaterials[i];
+		MaterialRecord &record = materialRecords[i];
+		memset(&record, 0, sizeof(MaterialRecord));
+		record.name = addString(m.name);
+		record.background = addString(m.background);
+		for (int t = 0; t < MaterialRecord::numTextures; t++) {
+			record.useTexture[t] = textureProperty(m, t)->useTexture;
+			record.textures[t] = addString(textureProperty(m, t)->texture);
+		}
+		record.two_sided = m.two_sided;
+		record.wireframe = m.wireframe;
+		record.shading_model = m.shading_model;
+		record.blend_func = m.blend_func;
+		memcpy(record.diffuse, m.diffuse.components, sizeof(record.diffuse));
+		memcpy(record.ambient, m.ambient.components, sizeof(record.ambient));
+		memcpy(record.specular, m.specular.components, sizeof(record.specular));
+		memcpy(record.emissive, m.emissive.components, sizeof(record.emissive));
+		memcpy(record.transparent, m.transparent.components, sizeof(record.transparent));
+		memcpy(record.reflective, m.reflective.components, sizeof(record.reflective));
+		record.shininess = m.shininess;
+		record.shininess_strength = m.shininess_strength;
+		record.opacity = m.opacity;
+		record.reflectivity = m.reflectivity;
+		record.refracti = m.refracti;
+		record.bump_scaling = m.bump_scaling;
+	}
+	std::vector<StringRecord> nodeRecords;
+	for (auto &name : mPendingNodes) {
+		nodeRecords.push_back(addString(name));
+	}
+	uint64_t totalSize = stringsOffset + strings.size();
+
+	mBlock.assign(totalSize, 0);
+	char *block = mBlock.data();
+	Header header;
+	memset(&header, 0, sizeof(Header));
+	memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+	header.version = version;
+	header.preset = preset;
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.totalSize = totalSize;
+	header.numMeshes = (uint32_t) meshRecords.size();
+	header.numMaterials = (uint32_t) materialRecords.size();
+	header.numNodes = (uint32_t) nodeRecords.size();
+	header.numTextures = mNumTextures;
+	for (int i = 0; i < 3; i++) {
+		header.boundsMin[i] = mMin[i];
+		header.boundsMax[i] = mMax[i];
+	}
+	header.meshesOffset = meshesOffset;
+	header.materialsOffset = materialsOffset;
+	header.nodesOffset = nodesOffset;
+	memcpy(block, &header, sizeof(Header));
+	memcpy(block + meshesOffset, meshRecords.data(), sizeof(MeshRecord) * meshRecords.size());
+	memcpy(block + materialsOffset, materialRecords.data(), sizeof(MaterialRecord) * materialRecords.size());
+	memcpy(block + nodesOffset, nodeRecords.data(), sizeof(StringRecord) * nodeRecords.size());
+	for (size_t i = 0; i < mPendingMeshes.size(); i++) {
+		PendingMesh &mesh = mPendingMeshes[i];
+		MeshRecord &record = meshRecords[i];
+		memcpy(block + record.positions, mesh.positions.data(), sizeof(Vec3f) * mesh.positions.size());
+		if (record.normals) {
+			memcpy(block + record.normals, mesh.normals.data(), sizeof(Vec3f) * mesh.normals.size());
+		}
+		if (record.colors) {
+			memcpy(block + record.colors, mesh.colors.data(), sizeof(Color) * mesh.colors.size());
+		}
+		if (record.texCoords) {
+			memcpy(block + record.texCoords, mesh.texCoords.data(), sizeof(Vec2f) * mesh.texCoords.size());
+		}
+		memcpy(block + record.indices, mesh.indices.data(), sizeof(unsigned int) * mesh.indices.size());
+	}
+	memcpy(block + stringsOffset, strings.data(), strings.size());
+
+	mPendingMeshes.clear();
+	mPendingMaterials.clear();
+	mPendingNodes.clear();
+	mData = mBlock.data();
+	mSize = mBlock.size();
+}
+
+bool SceneCache::write(const std::string &path) const {
+	if (!mData) {
+		return false;
+	}
+	std::string directory = File::directory(path);
+	if (directory.size() > 0 && !File::isDirectory(directory)) {
+		Dir::make(directory);
+	}
+	// Write to temporary file so readers never see a partial cache
+	std::string tempPath = path + ".tmp";
+	FILE *f = fopen(tempPath.c_str(), "wb");
+	if (!f) {
+		std::cerr << "ERROR: Could not write scene cache " << path << std::endl;
+		return false;
+	}
+	bool ok = fwrite(mData, 1, mSize, f) == mSize;
+	ok = fclose(f) == 0 && ok;
+	if (ok) {
+		File::remove(path);
+		ok = rename(tempPath.c_str(), path.c_str()) == 0;
+	}
+	if (!ok) {
+		File::remove(tempPath);
+		std::cerr << "ERROR: Could not write scene cache " << path << std::endl;
+	}
+	return ok;
+}
+
+bool SceneCache::map(const std::string &path, uint64_t sourceHash, uint64_t sourceSize, int preset) {
+	unmap();
+#ifndef AL_WINDOWS
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(Header)) {
+		close(fd);
+		return false;
+	}
+	void *mem = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED) {
+		return false;
+	}
+	mMapped = mem;
+	mData = static_cast<const char *>(mem);
+	mSize = info.st_size;
+#else
+	FILE *f = fopen(path.c_str(), "rb");
+	if (!f) {
+		return false;
+	}
+	fseek(f, 0, SEEK_END);
+	long fileSize = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	if (fileSize < (long) sizeof(Header)) {
+		fclose(f);
+		return false;
+	}
+	mBlock.resize(fileSize);
+	bool ok = fread(mBlock.data(), 1, fileSize, f) == (size_t) fileSize;
+	fclose(f);
+	if (!ok) {
+		mBlock.clear();
+		return false;
+	}
+	mData = mBlock.data();
+	mSize = mBlock.size();
+#endif
+
+	// Arrays must be inside the file, without overflowing, and aligned as
+	// finish() lays them out
+	uint64_t size = mSize;
+	auto fits = [size](uint64_t offset, uint64_t count, uint64_t elementSize) {
+		return offset <= size && count <= (size - offset) / elementSize;
+	};
+	auto array = [&](uint64_t offset, uint64_t count, uint64_t elementSize) {
+		return offset % kAlignment == 0 && fits(offset, count, elementSize);
+	};
+	const Header *h = header();
+	bool valid = memcmp(h->magic, kCacheMagic, sizeof(kCacheMagic)) == 0
+	    && h->version == version && h->preset == preset && h->sourceHash == sourceHash
+	    && h->sourceSize == sourceSize && h->totalSize == mSize
+	    && array(h->meshesOffset, h->numMeshes, sizeof(MeshRecord))
+	    && array(h->materialsOffset, h->numMaterials, sizeof(MaterialRecord))
+	    && array(h->nodesOffset, h->numNodes, sizeof(StringRecord));
+	for (unsigned int i = 0; valid && i < h->numMeshes; i++) {
+		const MeshRecord *m = meshRecord(i);
+		valid = array(m->positions, m->numVertices, sizeof(Vec3f))
+		    && array(m->normals, m->numVertices, sizeof(Vec3f))
+		    && array(m->colors, m->numVertices, sizeof(Color))
+		    && array(m->texCoords, m->numVertices, sizeof(Vec2f))
+		    && array(m->indices, m->numIndices, sizeof(unsigned int))
+		    && fits(m->name.offset, m->name.length, 1);
+		// Meshes are drawn straight from the cache, so an index past the
+		// vertices would read outside the arrays
+		const unsigned int *meshIndices = indices(i);
+		for (uint32_t j = 0; valid && j < m->numIndices; j++) {
+			valid = meshIndices[j] < m->numVertices;
+		}
+	}
+	if (!valid) {
+		unmap();
+		return false;
+	}
+	return true;
+}
+
+void SceneCache::unmap() {
+#ifndef AL_WINDOWS
+	if (mMapped) {
+		munmap(mMapped, mSize);
+		mMapped = nullptr;
+	}
+#endif
+	mBlock.clear();
+	mBlock.shrink_to_fit();
+	mData = nullptr;
+	mSize = 0;
+}
+
+const SceneCache::Header *SceneCache::header() const {
+	return reinterpret_cast<const Header *>(mData);
+}
+
+const SceneCache::MeshRecord *SceneCache::meshRecord(unsigned int i) const {
+	return reinterpret_cast<const MeshRecord *>(mData + header()->meshesOffset) + i;
+}
+
+std::string SceneCache::string(const StringRecord &record) const {
+	if (record.offset + record.length > mSize) {
+		return std::string();
+	}
+	return std::string(mData + record.offset, record.length);
+}
+
+unsigned int SceneCache::meshes() const {
+	return mData ? header()->numMeshes : 0;
+}
+
+std::string SceneCache::meshName(unsigned int i) const {
+	return string(meshRecord(i)->name);
+}
+
+unsigned int SceneCache::meshMaterial(unsigned int i) const {
+	return meshRecord(i)->materialIndex;
+}
+
+Mesh::Primitive SceneCache::meshPrimitive(unsigned int i) const {
+	return (Mesh::Primitive) meshRecord(i)->primitive;
+}
+
+unsigned int SceneCache::meshVertices(unsigned int i) const {
+	return meshRecord(i)->numVertices;
+}
+
+unsigned int SceneCache::meshIndices(unsigned int i) const {
+	return meshRecord(i)->numIndices;
+}
+
+const Vec3f *SceneCache::positions(unsigned int i) const {
+	return reinterpret_cast<const Vec3f *>(mData + meshRecord(i)->positions);
+}
+
+const Vec3f *SceneCache::normals(unsigned int i) const {
+	const MeshRecord *m = meshRecord(i);
+	return m->normals ? reinterpret_cast<const Vec3f *>(mData + m->normals) : nullptr;
+}
+
+const Color *SceneCache::colors(unsigned int i) const {
+	const MeshRecord *m = meshRecord(i);
+	return m->colors ? reinterpret_cast<const Color *>(mData + m->colors) : nullptr;
+}
+
+const Vec2f *SceneCache::texCoords(unsigned int i) const {
+	const MeshRecord *m = meshRecord(i);
+	return m->texCoords ? reinterpret_cast<const Vec2f *>(mData + m->texCoords) : nullptr;
+}
+
+const unsigned int *SceneCache::indices(unsigned int i) const {
+	return reinterpret_cast<const unsigned int *>(mData + meshRecord(i)->indices);
+}
+
+unsigned int SceneCache::materials() const {
+	return mData ? header()->numMaterials : 0;
+}
+
+void SceneCache::material(unsigned int i, Scene::Material &m) const {
+	const MaterialRecord &record =
+	    reinterpret_cast<const MaterialRecord *>(mData + header()->materialsOffset)[i];
+	m.name = string(record.name);
+	m.background = string(record.background);
+	for (int t = 0; t < MaterialRecord::numTextures; t++) {
+		textureProperty(m, t)->useTexture = record.useTexture[t] != 0;
+		textureProperty(m, t)->texture = string(record.textures[t]);
+	}
+	m.two_sided = record.two_sided;
+	m.wireframe = record.wireframe;
+	m.shading_model = record.shading_model;
+	m.blend_func = record.blend_func;
+	memcpy(m.diffuse.components, record.diffuse, sizeof(record.diffuse));
+	memcpy(m.ambient.components, record.ambient, sizeof(record.ambient));
+	memcpy(m.specular.components, record.specular, sizeof(record.specular));
+	memcpy(m.emissive.components, record.emissive, sizeof(record.emissive));
+	memcpy(m.transparent.components, record.transparent, sizeof(record.transparent));
+	memcpy(m.reflective.components, record.reflective, sizeof(record.reflective));
+	m.shininess = record.shininess;
+	m.shininess_strength = record.shininess_strength;
+	m.opacity = record.opacity;
+	m.reflectivity = record.reflectivity;
+	m.refracti = record.refracti;
+	m.bump_scaling = record.bump_scaling;
+}
+
+unsigned int SceneCache::nodes() const {
+	return mData ? header()->numNodes : 0;
+}
+
+std::string SceneCache::nodeName(unsigned int i) const {
+	return string(reinterpret_cast<const StringRecord *>(mData + header()->nodesOffset)[i]);
+}
+
+unsigned int SceneCache::textures() const {
+	return mData ? header()->numTextures : 0;
+}
+
+void SceneCache::getBounds(Vec3f &min, Vec3f &max) const {
+	if (!mData) {
+		return;
+	}
+	min.set(header()->boundsMin[0], header()->boundsMin[1], header()->boundsMin[2]);
+	max.set(header()->boundsMax[0], header()->boundsMax[1], header()->boundsMax[2]);
+}
+
+bool SceneCache::hashFile(const std::string &path, uint64_t &hash, uint64_t &size) {
+	FILE *f = fopen(path.c_str(), "rb");
+	if (!f) {
+		return false;
+	}
+	// FNV-1a over 64 bit words
+	const uint64_t prime = 0x100000001b3ULL;
+	hash = 0xcbf29ce484222325ULL;
+	size = 0;
+	std::vector<uint64_t> buffer(1 << 17);
+	size_t bytesRead;
+	while ((bytesRead = fread(buffer.data(), 1, buffer.size() * sizeof(uint64_t), f)) > 0) {
+		size_t words = bytesRead / sizeof(uint64_t);
+		for (size_t i = 0; i < words; i++) {
+			hash = (hash ^ buffer[i]) * prime;
+		}
+		const unsigned char *tail = reinterpret_cast<const unsigned char *>(buffer.data() + words);
+		for (size_t i = 0; i < bytesRead % sizeof(uint64_t); i++) {
+			hash = (hash ^ tail[i]) * prime;
+		}
+		size += bytesRead;
+	}
+	bool ok = !ferror(f);
+	fclose(f);
+	hash ^= size;
+	return ok;
+}
+
+std::string SceneCache::cachePath(const std::string &cacheDirectory, const std::string &sourcePath,
+                                  uint64_t sourceHash, int preset) {
+	char hashText[17];
+	snprintf(hashText, sizeof(hashText), "%016llx", (unsigned long long) sourceHash);
+	std::stringstream name;
+	name << File::conformDirectory(cacheDirectory) << File::baseName(sourcePath)
+	     << "." << hashText << "." << preset << ".alscene";
+	return name.str();
+}
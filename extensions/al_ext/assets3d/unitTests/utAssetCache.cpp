@@ -0,0 +1,134 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "al_ext/assets3d/al_AssetCache.hpp"
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+using namespace al;
+
+TEST_CASE( "Scene cache round trip", "[SceneCache]" ) {
+  std::string path = "test_scene.alscene";
+
+  std::vector<Vec3f> positions {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}};
+  std::vector<Vec3f> normals(4, Vec3f(0, 0, 1));
+  std::vector<Vec2f> texCoords {{0, 0}, {1, 0}, {0, 1}, {1, 1}};
+  std::vector<unsigned int> indices {0, 1, 2, 2, 1, 3};
+
+  Scene::Material material;
+  material.name = "surface";
+  material.diffuse = Color(0.1f, 0.2f, 0.3f, 1.0f);
+  material.shininess = 12.0f;
+  material.normalmap.useTexture = true;
+  material.normalmap.texture = "normals.png";
+
+  {
+    SceneCache cache;
+    cache.addMesh("quad", 0, Mesh::TRIANGLES, 4, positions.data(), normals.data(),
+                  nullptr, texCoords.data(), indices);
+    cache.addMesh("points", 0, Mesh::POINTS, 2, positions.data(), nullptr,
+                  nullptr, nullptr, {0, 1});
+    cache.addMaterial(material);
+    cache.addNode("root");
+    cache.addNode("child");
+    cache.setBounds(Vec3f(0, 0, 0), Vec3f(1, 1, 0));
+    cache.finish(1234, 100, Scene::QUALITY);
+    REQUIRE(cache.write(path));
+  }
+
+  SceneCache cache;
+  REQUIRE(!cache.map(path, 1235, 100, Scene::QUALITY)); // Source changed
+  REQUIRE(!cache.map(path, 1234, 101, Scene::QUALITY)); // Source size changed
+  REQUIRE(!cache.map(path, 1234, 100, Scene::FAST)); // Different preset
+  REQUIRE(cache.map(path, 1234, 100, Scene::QUALITY));
+
+  REQUIRE(cache.meshes() == 2);
+  REQUIRE(cache.meshName(0) == "quad");
+  REQUIRE(cache.meshPrimitive(0) == Mesh::TRIANGLES);
+  REQUIRE(cache.meshVertices(0) == 4);
+  REQUIRE(cache.meshIndices(0) == 6);
+  REQUIRE(cache.colors(0) == nullptr);
+  REQUIRE(cache.normals(1) == nullptr);
+  REQUIRE(cache.texCoords(1) == nullptr);
+  for (int i = 0; i < 4; i++) {
+    REQUIRE(cache.positions(0)[i] == positions[i]);
+    REQUIRE(cache.normals(0)[i] == normals[i]);
+    REQUIRE(cache.texCoords(0)[i] == texCoords[i]);
+  }
+  for (int i = 0; i < 6; i++) {
+    REQUIRE(cache.indices(0)[i] == indices[i]);
+  }
+  REQUIRE((size_t) cache.positions(0) % 16 == 0);
+
+  REQUIRE(cache.materials() == 1);
+  Scene::Material m;
+  cache.material(0, m);
+  REQUIRE(m.name == "surface");
+  REQUIRE(m.diffuse.g == 0.2f);
+  REQUIRE(m.shininess == 12.0f);
+  REQUIRE(m.normalmap.useTexture);
+  REQUIRE(m.normalmap.texture == "normals.png");
+  REQUIRE(!m.diffusemap.useTexture);
+
+  REQUIRE(cache.nodes() == 2);
+  REQUIRE(cache.nodeName(1) == "child");
+  Vec3f min, max;
+  cache.getBounds(min, max);
+  REQUIRE(max == Vec3f(1, 1, 0));
+
+  // Out of range index is rejected
+  std::vector<char> data;
+  {
+    FILE *f = fopen(path.c_str(), "rb");
+    REQUIRE(f);
+    fseek(f, 0, SEEK_END);
+    data.resize(ftell(f));
+    fseek(f, 0, SEEK_SET);
+    REQUIRE(fread(data.data(), 1, data.size(), f) == data.size());
+    fclose(f);
+  }
+  size_t indexOffset = 0;
+  for (size_t i = 0; i + sizeof(unsigned int) * 6 <= data.size(); i += 16) {
+    if (memcmp(data.data() + i, indices.data(), sizeof(unsigned int) * 6) == 0) {
+      indexOffset = i;
+      break;
+    }
+  }
+  REQUIRE(indexOffset > 0);
+  auto writeCache = [&](const std::vector<char> &contents, size_t size) {
+    FILE *f = fopen(path.c_str(), "wb");
+    fwrite(contents.data(), 1, size, f);
+    fclose(f);
+  };
+  std::vector<char> badIndex = data;
+  unsigned int outOfRange = 4;
+  memcpy(badIndex.data() + indexOffset + 5 * sizeof(unsigned int), &outOfRange, sizeof(outOfRange));
+  writeCache(badIndex, badIndex.size());
+  SceneCache damaged;
+  REQUIRE(!damaged.map(path, 1234, 100, Scene::QUALITY));
+
+  // Truncated cache is rejected
+  writeCache(data, data.size() - 8);
+  SceneCache truncated;
+  REQUIRE(!truncated.map(path, 1234, 100, Scene::QUALITY));
+  std::remove(path.c_str());
+}
+
+TEST_CASE( "Scene cache file hash", "[SceneCache]" ) {
+  std::string path = "test_hash.txt";
+  FILE *f = fopen(path.c_str(), "wb");
+  fputs("v 0 0 0\nv 1 0 0\n", f);
+  fclose(f);
+  uint64_t hash1, size1, hash2, size2;
+  REQUIRE(SceneCache::hashFile(path, hash1, size1));
+  REQUIRE(size1 == 16);
+  f = fopen(path.c_str(), "wb");
+  fputs("v 0 0 0\nv 1 0 1\n", f);
+  fclose(f);
+  REQUIRE(SceneCache::hashFile(path, hash2, size2));
+  REQUIRE(hash1 != hash2);
+  REQUIRE(SceneCache::cachePath("cache", "data/model.obj", hash1, 2).find("cache/model.obj.") == 0);
+  std::remove(path.c_str());
+}
@@ -2,7 +2,7 @@
 #define OUTPUTRECORDER_H
 
 #include "al/core/io/al_AudioIOData.hpp"
-#include "al/soundfile/al_SoundfileBufferedRecord.hpp"
+#include "al_ext/soundfile/al_SoundfileBufferedRecord.hpp"
 
 #undef min
 #undef max
@@ -16,10 +16,12 @@ public:
 
   bool start(std::string fullPath, double frameRate, uint32_t numChannels,
              uint32_t bufferFrames = 4096,
-             Format format = Format::WAV, EncodingType encoding = EncodingType::PCM_16) {
-    mBuffers.clear();
+             Format format = Format::WAV, EncodingType encoding = EncodingType::PCM_16,
+             bool multiFile = false) {
+    // Allocated here so that the audio callback doesn't allocate
+    mBuffers.assign(numChannels, nullptr);
     return SoundFileBufferedRecord::open(fullPath, frameRate, numChannels,
-                                         bufferFrames, format, encoding);
+                                         bufferFrames, format, encoding, multiFile);
   }
 
   void stop() {
@@ -28,20 +30,17 @@ public:
 
   void onAudioCB(AudioIOData &io) {
     if (SoundFileBufferedRecord::opened()) {
-      if (mBuffers.size() == 0) {
-        // First run. Put output buffers in buffers array
-        // This needs to be done only once and assumes the buffers will always
-        // be in the same location
-        for(int i = 0; i < std::min(int(io.channelsOut()), mSf.channels()); i++) {
-          mBuffers.push_back(io.outBuffer(i));
-        }
+      // Output buffers are taken every time as they might move
+      uint32_t numChannels = std::min(uint32_t(io.channelsOut()), uint32_t(mBuffers.size()));
+      for(uint32_t i = 0; i < numChannels; i++) {
+        mBuffers[i] = io.outBuffer(i);
       }
-      SoundFileBufferedRecord::write(mBuffers, io.framesPerBuffer());
+      SoundFileBufferedRecord::write(mBuffers.data(), numChannels, io.framesPerBuffer());
     }
   }
 
 private:
-  std::vector<float *> mBuffers;
+  std::vector<const float *> mBuffers;
 };
 
 }
@@ -0,0 +1,258 @@
+#ifndef SAMPLECACHE_H
+#define SAMPLECACHE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "al/core/io/al_AudioIOData.hpp"
+
+namespace al
+{
+
+///
+/// \brief Audio data of a sound file held in memory
+///
+/// Samples are interleaved 32-bit float. Files that already contain raw 32-bit
+/// float data are mapped into memory instead of being read, other files are
+/// decoded when loaded. A Sample is never modified once loaded, so it can be
+/// read from any number of threads.
+///
+class Sample
+{
+public:
+  ~Sample();
+
+  Sample(const Sample &) = delete;
+  Sample &operator=(const Sample &) = delete;
+
+  const float *data() const { return mData; } ///< Interleaved samples
+  int frames() const { return mFrames; }
+  int channels() const { return mChannels; }
+  double frameRate() const { return mFrameRate; }
+  const std::string &path() const { return mPath; }
+
+  /// Size of the sample data in bytes
+  size_t bytes() const { return size_t(mFrames) * mChannels * sizeof(float); }
+
+  /// Returns true if data is mapped from the file rather than decoded
+  bool mapped() const { return mMapped != nullptr; }
+
+private:
+  friend class SampleCache;
+  Sample() {}
+
+  const float *mData {nullptr};
+  int mFrames {0};
+  int mChannels {0};
+  double mFrameRate {0};
+  std::string mPath;
+  std::unique_ptr<float[]> mDecoded;
+  void *mMapped {nullptr};
+  size_t mMappedSize {0};
+};
+
+///
+/// \brief Read handle to a Sample
+///
+/// Handles share the data held by the cache, copying a handle does not copy
+/// audio. A Sample is not evicted from the cache while a handle to it exists.
+///
+typedef std::shared_ptr<const Sample> SampleHandle;
+
+///
+/// \brief Process-wide cache of samples loaded from sound files
+///
+/// Each file is loaded once and shared by all handles to it. Samples without
+/// handles are kept loaded for reuse until the memory used by the cache goes
+/// over its budget, and are then evicted, least recently used first.
+///
+/// Files can be preloaded on a background thread with preload(), so that get()
+/// does not block on disk when a voice is triggered. get() and find() take a
+/// lock, so they should be called when a voice is triggered rather than for
+/// every audio block; reading from a handle does not lock.
+///
+class SampleCache
+{
+public:
+  ///
+  /// \param budgetBytes memory kept for samples that have no handles
+  ///
+  SampleCache(size_t budgetBytes = 512 * 1024 * 1024);
+  ~SampleCache();
+
+  SampleCache(const SampleCache &) = delete;
+  SampleCache &operator=(const SampleCache &) = delete;
+
+  ///
+  /// \brief Cache shared by the whole process
+  ///
+  static SampleCache &global();
+
+  ///
+  /// \brief Get handle to a sample, loading the file if it is not cached
+  /// \return nullptr if the file can't be loaded
+  ///
+  SampleHandle get(const std::string &path);
+
+  ///
+  /// \brief Get handle to a sample only if it is already loaded
+  ///
+  SampleHandle find(const std::string &path);
+
+  ///
+  /// \brief Load a file on the background thread
+  ///
+  void preload(const std::string &path);
+
+  /// Wait until all files passed to preload() have been loaded
+  void waitForPreload();
+
+  ///
+  /// \brief Set maximum memory used by samples before unused ones are evicted
+  ///
+  /// Samples with handles are never evicted, so memory used can be larger than
+  /// the budget.
+  ///
+  void budget(size_t bytes);
+  size_t budget() const { return mBudget; }
+
+  /// Memory used by loaded samples in bytes
+  size_t bytesUsed();
+
+  /// Number of loaded samples
+  size_t size();
+
+  /// Evict all samples that have no handles
+  void evictUnused();
+
+  ///
+  /// \brief Set whether raw float files are mapped into memory
+  ///
+  /// When false, all files are decoded into memory.
+  ///
+  void useMapping(bool use) { mUseMapping = use; }
+
+  /// Number of files loaded from disk since the cache was created
+  uint64_t loadCount() const { return mLoadCount; }
+
+private:
+  struct Entry {
+    std::shared_ptr<Sample> sample;
+    bool loading {true};
+    std::list<std::string>::iterator lru;
+  };
+
+  std::shared_ptr<Sample> load(const std::string &path);
+  bool mapFloatWav(const std::string &path, Sample &sample);
+  bool decode(const std::string &path, Sample &sample);
+  // Evict unused samples until within budget. Called with mLock held
+  void trim(size_t budget);
+  void preloadLoop();
+
+  std::mutex mLock;
+  std::condition_variable mLoaded;
+  std::unordered_map<std::string, Entry> mEntries;
+  std::list<std::string> mLru; // Most recently used first
+  size_t mBudget;
+  size_t mBytesUsed {0};
+  std::atomic<bool> mUseMapping {true};
+  std::atomic<uint64_t> mLoadCount {0};
+
+  std::thread mPreloadThread;
+  std::deque<std::string> mPreloadQueue;
+  std::condition_variable mPreloadCondVar;
+  std::condition_variable mPreloadDone;
+  int mPreloading {0};
+  bool mRunning {true};
+};
+
+///
+/// \brief Plays a Sample at a variable rate with interpolation
+///
+/// The player reads directly from the sample data of a handle, so any number
+/// of players can share a sample. Audio is added to the output, so players for
+/// several voices can write to the same buffers.
+///
+class SamplePlayer
+{
+public:
+  enum Interpolation {
+    NONE,   ///< Nearest lower frame
+    LINEAR, ///< Linear between two frames
+    CUBIC   ///< 4-point Hermite
+  };
+
+  SamplePlayer() {}
+  SamplePlayer(SampleHandle sample) { this->sample(sample); }
+
+  /// Set sample to play, from the start
+  void sample(SampleHandle s);
+  const SampleHandle &sample() const { return mSample; }
+
+  ///
+  /// \brief Set playback rate
+  ///
+  /// 1 plays at the original pitch if the sample and output frame rates are
+  /// the same, 2 plays an octave up.
+  ///
+  void rate(double r) { mRate = r; }
+  double rate() const { return mRate; }
+
+  /// Set rate from a pitch shift in semitones
+  void semitones(double s);
+
+  void loop(bool loop) { mLoop = loop; }
+  bool loop() const { return mLoop; }
+
+  void interpolation(Interpolation i) { mInterpolation = i; }
+  Interpolation interpolation() const { return mInterpolation; }
+
+  /// Set play position in frames
+  void position(double frame) { mPosition = frame; }
+  double position() const { return mPosition; }
+
+  /// Returns true when the end of a non-looping sample has been played
+  bool done() const;
+
+  ///
+  /// \brief Add sample to non-interleaved output buffers
+  /// \param out output buffers
+  /// \param numOutChannels number of output buffers
+  /// \param numFrames number of frames to write
+  /// \param gain gain applied to the sample
+  /// \return number of frames written, less than numFrames when done
+  ///
+  /// Sample channels are written to the output buffer with the same index,
+  /// mono samples are written to all output buffers.
+  ///
+  int process(float *const *out, int numOutChannels, int numFrames, float gain = 1.0f);
+
+  ///
+  /// \brief Add sample to the output of an audio callback
+  ///
+  /// Writes from the current frame of io to the end of the buffer, as a
+  /// SynthVoice onProcess() function does.
+  ///
+  int process(AudioIOData &io, float gain = 1.0f);
+
+private:
+  template<Interpolation I>
+  int processFrames(float *const *out, int numOutChannels, int numFrames, float gain);
+
+  SampleHandle mSample;
+  double mPosition {0};
+  double mRate {1};
+  bool mLoop {false};
+  Interpolation mInterpolation {LINEAR};
+};
+
+} // namespace al
+
+#endif // SAMPLECACHE_H
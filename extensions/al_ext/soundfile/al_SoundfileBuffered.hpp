@@ -11,6 +11,7 @@
 
 #include "Gamma/SoundFile.h"
 #include "al/core/types/al_SingleRWRingBuffer.hpp"
+#include "al_ext/soundfile/al_SoundfileStreamEngine.hpp"
 
 
 namespace al
@@ -20,11 +21,14 @@ namespace al
 /// \brief Read a soundfile with buffering on a low priority thread
 ///
 /// The SoundFileBuffered class is a wrapper around Gamma's SoundFile class.
-/// It reads the soundfile in a separate thread and reading is done from a
-/// lock-free ring buffer. This is the ideal way of reading a soundfile
-/// within an audio callback as it will provide the most efficient mechanism
-/// for low latency, high efficiency and drop-out free soundfile access.
+/// The soundfile is read by the I/O threads of a SoundFileStreamEngine and
+/// reading is done from a lock-free ring buffer. This is the ideal way of
+/// reading a soundfile within an audio callback as it will provide the most
+/// efficient mechanism for low latency, high efficiency and drop-out free
+/// soundfile access. read() does not lock or signal other threads.
 ///
+/// Streams share a single engine by default, so many files can be streamed
+/// at once without a thread per file.
 ///
 class SoundFileBuffered
 {
@@ -33,8 +37,10 @@ public:
   /// \param fullPath The full path to the audio file
   /// \param loop set to true if you want the sound file to start over when finished
   /// \param bufferFrames the size of the ring buffer. Set to larger if experiencing dropouts or if planning to read more samples, e.g. the audio buffer size is large.
+  /// \param engine the engine reading the file, or nullptr for the shared engine
   ///
-  SoundFileBuffered(std::string fullPath = std::string(), bool loop = false, int bufferFrames = 1024);
+  SoundFileBuffered(std::string fullPath = std::string(), bool loop = false, int bufferFrames = 8192,
+                    std::shared_ptr<SoundFileStreamEngine> engine = nullptr);
   ~SoundFileBuffered();
 
   bool open(std::string fullPath);
@@ -85,29 +91,57 @@ public:
   ///
   void setReadCallback(CallbackFunc func, void *userData);
 
+  ///
+  /// \brief Move the read position of the file
+  ///
+  /// The file is read from the new position within one poll interval of the
+  /// engine. Frames already in the ring buffer are read first. Safe to call
+  /// from the audio thread.
+  ///
   void seek(int frame);
 
   int currentPosition();
 
+  ///
+  /// \brief Number of reads that got fewer frames than requested before the end of the file
+  ///
+  int underruns() const { return mUnderruns.load(); }
+
+  ///
+  /// \brief Set engine used to read the file. Takes effect on next open()
+  ///
+  void setEngine(std::shared_ptr<SoundFileStreamEngine> engine) { mEngine = engine; }
+
 private:
-  bool mRunning;
+  friend class SoundFileStreamEngine;
+
   bool mLoop;
   std::atomic<int> mRepeats;
   std::atomic<int> mSeek;
   std::atomic<int> mCurPos; // Updated once per read buffer
-  std::mutex mLock;
-  std::condition_variable mCondVar;
-  std::thread *mReaderThread;
-  SingleRWRingBuffer *mRingBuffer;
+  int mFilePos {0}; // Next frame read from the file, used by engine threads
+  std::atomic<int> mUnderruns {0};
+  std::atomic<bool> mEndReached {false};
+  std::atomic<bool> mServicing {false}; // claimed by an engine thread
+  SingleRWRingBuffer *mRingBuffer {nullptr};
   int mBufferFrames;
+  int mFileBufferFrames {0};
 
   gam::SoundFile mSf;
   CallbackFunc mReadCallback;
   void *mCallbackData;
 
-  float *mFileBuffer; // Buffer to copy file samples to (in the reader thread before passing to ring buffer)
+  std::shared_ptr<SoundFileStreamEngine> mEngine;
+  SoundFileStreamEngine *mActiveEngine {nullptr};
+
+  float *mFileBuffer {nullptr}; // Buffer to copy file samples to (in the reader thread before passing to ring buffer)
 
-  static void readFunction(SoundFileBuffered *obj);
+  // Seconds of audio left in the ring buffer, or a negative value if less
+  // than minFraction of the ring buffer is free and more than urgentTime
+  // seconds are left, or the end of the file was reached.
+  double deadline(float minFraction, float urgentTime) const;
+  // Read from file into the ring buffer. Called by engine threads
+  void fill();
 };
 
 } // namespace al
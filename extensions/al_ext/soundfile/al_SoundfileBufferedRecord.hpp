@@ -1,5 +1,5 @@
-#ifndef SOUNDFILEBUFFERED_H
-#define SOUNDFILEBUFFERED_H
+#ifndef SOUNDFILEBUFFEREDRECORD_H
+#define SOUNDFILEBUFFEREDRECORD_H
 
 
 #include <mutex>
@@ -9,6 +9,7 @@
 #include <atomic>
 #include <functional>
 #include <algorithm>
+#include <vector>
 
 #include "Gamma/SoundFile.h"
 #include "al/core/types/al_SingleRWRingBuffer.hpp"
@@ -21,10 +22,14 @@ namespace al
 ///
 /// \brief Write a soundfile with buffering on a low priority thread
 ///
-/// The SoundFileBuffered class is a wrapper around Gamma's SoundFile class.
-/// It writes the soundfile in a separate thread and buffering is done with a
-/// lock-free ring buffer from the audio callback
+/// The SoundFileBufferedRecord class is a wrapper around Gamma's SoundFile
+/// class. It writes the soundfile in a separate thread and buffering is done
+/// with lock-free ring buffers from the audio callback.
 ///
+/// write() is safe to call from the audio thread: it does not allocate, lock
+/// or signal, and copies each channel into its own ring buffer with a single
+/// memcpy. The writer thread interleaves the channels and encodes them to the
+/// file. Channels can also be written to separate mono files.
 ///
 class SoundFileBufferedRecord
 {
@@ -33,79 +38,92 @@ public:
   typedef gam::SoundFile::Format Format;
   typedef gam::SoundFile::EncodingType EncodingType;
 
-  ///
-  /// \param fullPath The full path to the audio file
-  /// \param loop set to true if you want the sound file to start over when finished
-  /// \param bufferFrames the size of the ring buffer. Set to larger if experiencing dropouts or if planning to read more samples, e.g. the audio buffer size is large.
-  ///
   SoundFileBufferedRecord();
   ~SoundFileBufferedRecord();
 
+  ///
+  /// \param fullPath The full path to the audio file
+  /// \param frameRate frame rate of the file
+  /// \param numChannels number of channels to record
+  /// \param bufferFrames the size of the ring buffer. Set to larger if experiencing overruns, e.g. the audio buffer size is large.
+  /// \param format file format
+  /// \param encoding sample encoding, e.g. PCM_16, PCM_24 or FLOAT
+  /// \param multiFile write each channel to a mono file named by channelPath()
+  ///
   bool open(std::string fullPath, double frameRate, uint32_t numChannels,
             uint32_t bufferFrames = 8192,
-            Format format = Format::WAV, EncodingType encoding = EncodingType::PCM_16);
+            Format format = Format::WAV, EncodingType encoding = EncodingType::PCM_16,
+            bool multiFile = false);
 
+  /// Stop the writer thread after writing all buffered audio, and free buffers
   void cleanup();
 
   bool close();
 
+  ///
+  /// \brief Write audio file from separate audio buffers
+  /// \param buffers pointers to the buffer of each channel
+  /// \param numChannels number of buffers. Missing channels are written as silence
+  /// \param numFrames number of frames in each buffer
+  ///
+  /// If there is no room in the ring buffers for all frames, nothing is
+  /// written and an overrun is counted.
+  ///
+  void write(const float *const *buffers, uint32_t numChannels, size_t numFrames);
+
   ///
   /// \brief Write audio file from separate audio buffers
   /// \param buffers vector of buffers to write
   /// \param numFrames number of frames in each buffer
-  /// \return the number of frames actually read.
   ///
-  void write(std::vector<float *>buffers, size_t numFrames);
+  void write(const std::vector<float *> &buffers, size_t numFrames) {
+    write(buffers.data(), uint32_t(buffers.size()), numFrames);
+  }
 
   void setMaxWriteTime(float maxTime) {mMaxWriteTime = maxTime;}
 
   bool opened() const;								///< Returns whether the sound file is open
 
-//  typedef std::function<void(float *buffer, int numChannels,
-//                             int numFrames, void * userData)> CallbackFunc;
-
-//  ///
-//  /// \brief Set a function that will be called whenever samples are read
-//  ///
-//  /// The function func will be called whenever the low priority reader thread
-//  /// reads samples from the audio file. The callback function will get the
-//  /// samples that have just been read. This can be useful is the data is also
-//  /// required by another thread than the audio thread. For example if you want
-//  /// to display the audio data in addition to playing it. Bear in mind that if
-//  /// the process taking place in the callback function is too intensive it
-//  /// might produce an underrun in the ring buffer resulting in audio dropouts.
-//  /// If this is the case, use the callback to copy the data to a separate
-//  /// thread for processing.
-//  ///
-//  /// \param func the callback function
-//  /// \param userData the data to be passed to the callback
-//  ///
-//  void setWriteCallback(CallbackFunc func, void *userData);
+  uint32_t channels() const { return mChannels; }  ///< Number of channels recorded
 
   int currentPosition();
 
+  /// Number of writes dropped because the ring buffers were full
+  int overruns() const { return mOverruns.load(); }
+
+  ///
+  /// \brief Path of the file for a channel in multi file mode
+  ///
+  /// The channel number, counting from 1, is added before the extension,
+  /// e.g. "take.wav" becomes "take_1.wav".
+  ///
+  static std::string channelPath(std::string fullPath, uint32_t channel);
+
 protected:
-  bool mRunning;
+  std::atomic<bool> mRunning;
+  std::atomic<bool> mFinished {false}; // Max write time reached
   float mMaxWriteTime {0};
-//  std::atomic<int> mRepeats;
-//  std::atomic<int> mSeek;
-  std::atomic<int> mCurPos; // Updated once per read buffer
+  std::atomic<int> mCurPos; // Updated once per write buffer
+  std::atomic<int> mOverruns {0};
   std::mutex mLock;
   std::condition_variable mCondVar;
-  std::thread *mReaderThread {nullptr};
-  SingleRWRingBuffer *mRingBuffer {nullptr};
-  uint32_t mBufferFrames;
+  std::thread *mWriterThread {nullptr};
+  std::vector<std::unique_ptr<SingleRWRingBuffer>> mRingBuffers; // One per channel
+  uint32_t mBufferFrames {0};
+  uint32_t mChannels {0};
+  double mFrameRate {0};
 
-  gam::SoundFile mSf;
-//  CallbackFunc mReadCallback;
-//  void *mCallbackData;
+  std::vector<std::unique_ptr<gam::SoundFile>> mFiles; // One file, or one per channel
 
 private:
-  std::unique_ptr<float []> mFileBuffer; // Interleaved Buffer to copy file samples to (in the write thread before passing to ring buffer)
+  std::unique_ptr<float []> mSilence; // Written for missing channels
+  std::unique_ptr<float []> mPlanarBuffer; // Channels read from ring buffers (in the write thread)
+  std::unique_ptr<float []> mFileBuffer; // Interleaved buffer passed to the sound file (in the write thread)
 
-  static void writeFunction(SoundFileBufferedRecord *obj, std::condition_variable *cond, std::mutex *condMutex);
+  static void writeFunction(SoundFileBufferedRecord *obj);
+  size_t writeBlock(size_t maxFrames);
 };
 
 } // namespace al
 
-#endif // SOUNDFILEBUFFERED_H
+#endif // SOUNDFILEBUFFEREDRECORD_H
@@ -0,0 +1,96 @@
+#ifndef SOUNDFILESTREAMENGINE_H
+#define SOUNDFILESTREAMENGINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace al
+{
+
+class SoundFileBuffered;
+
+///
+/// \brief Pool of I/O threads filling the ring buffers of many SoundFileBuffered
+///
+/// Streaming each file from its own thread does not scale to hundreds of
+/// files: threads compete for the disk and each wakes up for small reads.
+/// The engine services all streams with a few threads. Streams are served
+/// by deadline, the time left until their ring buffer runs dry, and are
+/// only read once a large part of their ring buffer is free (or their
+/// deadline is close), so reads are long and sequential.
+///
+/// The audio thread never blocks or signals the I/O threads: reading from a
+/// stream only updates its ring buffer, and I/O threads poll the streams
+/// every pollInterval when there is nothing to do.
+///
+/// By default all SoundFileBuffered objects share the engine returned by
+/// shared(). Streams keep their engine alive, so it is destroyed after the
+/// last stream is closed.
+///
+class SoundFileStreamEngine
+{
+public:
+  ///
+  /// \param numThreads number of I/O threads
+  ///
+  SoundFileStreamEngine(unsigned numThreads = 2);
+  ~SoundFileStreamEngine();
+
+  ///
+  /// \brief Get engine shared by all streams, creating it if needed
+  ///
+  static std::shared_ptr<SoundFileStreamEngine> shared();
+
+  /// Start servicing a stream. Called by SoundFileBuffered::open()
+  void add(SoundFileBuffered *stream);
+
+  /// Stop servicing a stream, waiting if it is being read
+  void remove(SoundFileBuffered *stream);
+
+  size_t numStreams();
+  unsigned numThreads() const { return mNumThreads; }
+
+  ///
+  /// \brief Set fraction of a ring buffer that must be free before it is read
+  ///
+  /// Higher values give fewer, larger reads. A stream is always read when
+  /// less than urgentTime seconds of audio are left in its ring buffer.
+  ///
+  void minReadFraction(float f) { mMinReadFraction = f; }
+  void urgentTime(float seconds) { mUrgentTime = seconds; }
+
+  /// Set time I/O threads sleep when no stream needs reading
+  void pollInterval(float seconds) { mPollNanos = int64_t(seconds * 1e9); }
+
+  /// Number of reads made since the engine started
+  uint64_t readCount() const { return mReadCount; }
+
+private:
+  struct Candidate {
+    double deadline;
+    SoundFileBuffered *stream;
+  };
+
+  void ioLoop();
+  size_t claimStreams(std::vector<Candidate> &claimed);
+
+  unsigned mNumThreads;
+  std::vector<std::thread> mThreads;
+  std::vector<SoundFileBuffered *> mStreams;
+  std::mutex mLock;
+  std::condition_variable mCondVar;
+  bool mRunning {true};
+
+  std::atomic<float> mMinReadFraction {0.25f};
+  std::atomic<float> mUrgentTime {0.05f};
+  std::atomic<int64_t> mPollNanos {2000000};
+  std::atomic<uint64_t> mReadCount {0};
+};
+
+} // namespace al
+
+#endif // SOUNDFILESTREAMENGINE_H
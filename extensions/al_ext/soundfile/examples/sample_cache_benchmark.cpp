@@ -0,0 +1,150 @@
+/*
+Allocore Example: Sample cache benchmark
+
+Description:
+Plays 1000 simultaneous sample voices through a PolySynth, each voice reading
+one of a few shared samples from a SampleCache at its own pitch. Compares the
+time and memory taken to load a sample per voice against sharing cached
+samples, and reports the render time per audio buffer for each interpolation
+kernel as a fraction of the real time available. Test files are generated in
+the current directory and removed afterwards.
+
+Usage: sample_cache_benchmark [voices]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "al/core/io/al_AudioIOData.hpp"
+#include "al/util/scene/al_PolySynth.hpp"
+
+#include "al_ext/soundfile/al_SampleCache.hpp"
+
+#include "Gamma/SoundFile.h"
+
+using namespace al;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+class SampleVoice : public SynthVoice {
+public:
+  SamplePlayer player;
+  float gain {0.001f};
+
+  void onProcess(AudioIOData &io) override {
+    player.process(io, gain);
+    if (player.done()) {
+      free();
+    }
+  }
+};
+
+int main(int argc, char *argv[]) {
+  const int numFiles = 32;
+  const int fileFrames = 48000 * 4;
+  const int blockSize = 512;
+  const double sampleRate = 48000;
+  int numVoices = argc > 1 ? std::atoi(argv[1]) : 1000;
+
+  // Half the files are 16-bit and decoded, half are float and mapped
+  std::vector<std::string> paths;
+  std::vector<float> data(fileFrames * 2);
+  for (int f = 0; f < numFiles; f++) {
+    paths.push_back("sample_benchmark_" + std::to_string(f) + ".wav");
+    gam::SoundFile sf(paths.back());
+    sf.format(gam::SoundFile::WAV);
+    sf.encoding(f % 2 ? gam::SoundFile::FLOAT : gam::SoundFile::PCM_16);
+    sf.channels(2);
+    sf.frameRate(sampleRate);
+    if (!sf.openWrite()) {
+      std::cerr << "ERROR: could not write " << paths.back() << std::endl;
+      return -1;
+    }
+    for (int i = 0; i < fileFrames * 2; i++) {
+      data[i] = ((i * (f + 3)) % 3000) / 3000.0f - 0.5f;
+    }
+    sf.write(data.data(), fileFrames);
+    sf.close();
+  }
+
+  // Loading a copy per voice
+  {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SampleHandle> copies;
+    size_t bytes = 0;
+    for (int v = 0; v < numVoices; v++) {
+      SampleCache own;
+      own.useMapping(false);
+      copies.push_back(own.get(paths[v % numFiles]));
+      bytes += copies.back()->bytes();
+    }
+    std::printf("Per voice load:  %8.1f ms  %8.1f MB\n", secondsSince(start) * 1000,
+                bytes / 1048576.0);
+  }
+
+  // Shared cache, preloaded in the background
+  SampleCache &cache = SampleCache::global();
+  auto start = std::chrono::steady_clock::now();
+  for (auto &path : paths) {
+    cache.preload(path);
+  }
+  cache.waitForPreload();
+  std::vector<SampleHandle> samples;
+  for (int v = 0; v < numVoices; v++) {
+    samples.push_back(cache.get(paths[v % numFiles]));
+  }
+  std::printf("Shared cache:    %8.1f ms  %8.1f MB (%d loads)\n", secondsSince(start) * 1000,
+              cache.bytesUsed() / 1048576.0, int(cache.loadCount()));
+
+  AudioIOData io;
+  io.framesPerBuffer(blockSize);
+  io.framesPerSecond(sampleRate);
+  io.channelsIn(0);
+  io.channelsOut(2);
+  double blockSeconds = blockSize / sampleRate;
+  int numBlocks = int(2.0 / blockSeconds);
+
+  std::printf("%d voices, %d frame buffers\n", numVoices, blockSize);
+  std::printf("kernel   mean ms  max ms  real time load\n");
+  const char *names[] = {"none", "linear", "cubic"};
+  for (auto interpolation : {SamplePlayer::NONE, SamplePlayer::LINEAR, SamplePlayer::CUBIC}) {
+    PolySynth synth;
+    synth.allocatePolyphony<SampleVoice>(numVoices);
+    for (int v = 0; v < numVoices; v++) {
+      auto *voice = synth.getVoice<SampleVoice>();
+      voice->player.sample(samples[v]);
+      voice->player.interpolation(interpolation);
+      voice->player.semitones((v % 25) - 12 + 0.01 * (v % 7));
+      voice->player.loop(true);
+      synth.triggerOn(voice);
+    }
+
+    double total = 0, maxTime = 0;
+    for (int b = 0; b < numBlocks; b++) {
+      io.zeroOut();
+      io.frame(0);
+      auto blockStart = std::chrono::steady_clock::now();
+      synth.render(io);
+      double t = secondsSince(blockStart);
+      total += t;
+      maxTime = std::max(maxTime, t);
+    }
+    double mean = total / numBlocks;
+    std::printf("%-7s  %7.3f  %6.3f  %13.1f%%\n", names[interpolation], mean * 1000,
+                maxTime * 1000, 100 * mean / blockSeconds);
+    synth.allNotesOff();
+  }
+
+  samples.clear();
+  cache.evictUnused();
+  for (auto &path : paths) {
+    std::remove(path.c_str());
+  }
+  return 0;
+}
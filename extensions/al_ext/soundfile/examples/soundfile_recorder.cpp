@@ -34,8 +34,10 @@ struct MyApp : public App {
             io.out(0) = waveValue;
             io.out(1) = -waveValue; // Phase inverted
         }
-        // write the output buffers to the soundfile
-        soundFile.write({io.outBuffer(0), io.outBuffer(1)}, io.framesPerBuffer());
+        // write the output buffers to the soundfile. Passing an array of
+        // pointers avoids allocating in the audio callback
+        const float *buffers[2] = {io.outBuffer(0), io.outBuffer(1)};
+        soundFile.write(buffers, 2, io.framesPerBuffer());
     }
 };
 
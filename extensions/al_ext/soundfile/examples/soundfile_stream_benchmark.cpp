@@ -0,0 +1,111 @@
+/*
+Allocore Example: Soundfile stream benchmark
+
+Description:
+Streams many looping sound files at once through a SoundFileStreamEngine,
+reading them from a simulated audio thread that consumes 256 frames per
+stream every 5.8 ms, as a 44.1 kHz audio callback would. Reports underruns
+(reads that got fewer frames than asked for) and the number of disk reads
+for increasing numbers of streams. Test files are generated in the current
+directory and removed afterwards.
+
+Usage: soundfile_stream_benchmark [ioThreads] [seconds]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "al_ext/soundfile/al_SoundfileBuffered.hpp"
+
+#include "Gamma/SoundFile.h"
+
+using namespace al;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+  const int numFiles = 16;
+  const int fileFrames = 44100 * 10;
+  const int blockSize = 256;
+  const double sampleRate = 44100;
+  unsigned ioThreads = argc > 1 ? std::atoi(argv[1]) : 2;
+  double seconds = argc > 2 ? std::atof(argv[2]) : 5.0;
+
+  // Several distinct 16-bit stereo files, so reads are not all from one
+  // file in the page cache
+  std::vector<std::string> paths;
+  std::vector<float> data(fileFrames * 2);
+  for (int f = 0; f < numFiles; f++) {
+    paths.push_back("stream_benchmark_" + std::to_string(f) + ".wav");
+    gam::SoundFile sf(paths.back());
+    sf.format(gam::SoundFile::WAV);
+    sf.encoding(gam::SoundFile::PCM_16);
+    sf.channels(2);
+    sf.frameRate(sampleRate);
+    if (!sf.openWrite()) {
+      std::cerr << "ERROR: could not write " << paths.back() << std::endl;
+      return -1;
+    }
+    for (int i = 0; i < fileFrames * 2; i++) {
+      data[i] = ((i * (f + 1)) % 2000) / 2000.0f - 0.5f;
+    }
+    sf.write(data.data(), fileFrames);
+    sf.close();
+  }
+
+  std::cout << "I/O threads: " << ioThreads << "   block: " << blockSize
+            << " frames   duration: " << seconds << " s" << std::endl;
+  std::cout << "streams  underruns  reads/stream/s  late blocks" << std::endl;
+
+  for (int numStreams : {10, 100, 500, 1000}) {
+    auto engine = std::make_shared<SoundFileStreamEngine>(ioThreads);
+    std::vector<std::unique_ptr<SoundFileBuffered>> streams;
+    for (int i = 0; i < numStreams; i++) {
+      streams.emplace_back(new SoundFileBuffered(paths[i % numFiles], true, 8192, engine));
+    }
+    // Spread stream positions so their reads do not line up
+    for (int i = 0; i < numStreams; i++) {
+      streams[i]->seek((i * 7919) % fileFrames);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100 + numStreams / 2));
+
+    std::vector<float> buffer(blockSize * 2);
+    auto blockTime = std::chrono::nanoseconds(int64_t(1e9 * blockSize / sampleRate));
+    int numBlocks = int(seconds * sampleRate / blockSize);
+    int lateBlocks = 0;
+    uint64_t startReads = engine->readCount();
+    auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    for (int b = 0; b < numBlocks; b++) {
+      for (auto &s : streams) {
+        s->read(buffer.data(), blockSize);
+      }
+      next += blockTime;
+      if (std::chrono::steady_clock::now() > next) {
+        lateBlocks++;
+      }
+      std::this_thread::sleep_until(next);
+    }
+    double elapsed = secondsSince(start);
+
+    int underruns = 0;
+    for (auto &s : streams) {
+      underruns += s->underruns();
+    }
+    double readRate = (engine->readCount() - startReads) / (elapsed * numStreams);
+    std::printf("%7d  %9d  %14.1f  %11d\n", numStreams, underruns, readRate, lateBlocks);
+  }
+
+  for (auto &path : paths) {
+    std::remove(path.c_str());
+  }
+  return 0;
+}
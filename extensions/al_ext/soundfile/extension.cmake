@@ -10,12 +10,16 @@ else()
   set(THIS_EXTENSION_SRC
     ${CMAKE_CURRENT_LIST_DIR}/src/al_SoundfileBuffered.cpp
     ${CMAKE_CURRENT_LIST_DIR}/src/al_SoundfileBufferedRecord.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/al_SoundfileStreamEngine.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/al_SampleCache.cpp
   #  ${CMAKE_CURRENT_LIST_DIR}/src/al_AmbiFilePlayer.cpp
   )
 
   set(THIS_EXTENSION_HEADERS
     ${CMAKE_CURRENT_LIST_DIR}/al_SoundfileBuffered.hpp
     ${CMAKE_CURRENT_LIST_DIR}/al_SoundfileBufferedRecord.hpp
+    ${CMAKE_CURRENT_LIST_DIR}/al_SoundfileStreamEngine.hpp
+    ${CMAKE_CURRENT_LIST_DIR}/al_SampleCache.hpp
     ${CMAKE_CURRENT_LIST_DIR}/al_OutputRecorder.hpp
   #  ${CMAKE_CURRENT_LIST_DIR}/al_AmbiFilePlayer.hpp
   )
@@ -42,7 +46,7 @@ else()
 
   # unit tests
   add_executable(soundfileBufferedRecordTests ${CMAKE_CURRENT_LIST_DIR}/unitTests/utSoundfileBufferedRecord.cpp)
-  target_link_libraries(soundfileBufferedRecordTests al ${SPATIALAUDIO_LINK_LIBRARIES} )
+  target_link_libraries(soundfileBufferedRecordTests al ${THIS_EXTENSION_LIBRARY_NAME} ${THIS_EXTENSION_LIBRARIES})
   target_include_directories(soundfileBufferedRecordTests PUBLIC "${CMAKE_CURRENT_SOURCE_DIR}/external/catch")
   set_target_properties(soundfileBufferedRecordTests PROPERTIES
     CXX_STANDARD 14
@@ -51,4 +55,24 @@ else()
   add_test(NAME soundfileBufferedRecordTests
     COMMAND $<TARGET_FILE:soundfileBufferedRecordTests> ${TEST_ARGS})
 
+  add_executable(soundfileBufferedTests ${CMAKE_CURRENT_LIST_DIR}/unitTests/utSoundfileBuffered.cpp)
+  target_link_libraries(soundfileBufferedTests al ${THIS_EXTENSION_LIBRARY_NAME} ${THIS_EXTENSION_LIBRARIES})
+  target_include_directories(soundfileBufferedTests PUBLIC "${CMAKE_CURRENT_SOURCE_DIR}/external/catch")
+  set_target_properties(soundfileBufferedTests PROPERTIES
+    CXX_STANDARD 14
+    CXX_STANDARD_REQUIRED ON
+    )
+  add_test(NAME soundfileBufferedTests
+    COMMAND $<TARGET_FILE:soundfileBufferedTests> ${TEST_ARGS})
+
+  add_executable(sampleCacheTests ${CMAKE_CURRENT_LIST_DIR}/unitTests/utSampleCache.cpp)
+  target_link_libraries(sampleCacheTests al ${THIS_EXTENSION_LIBRARY_NAME} ${THIS_EXTENSION_LIBRARIES})
+  target_include_directories(sampleCacheTests PUBLIC "${CMAKE_CURRENT_SOURCE_DIR}/external/catch")
+  set_target_properties(sampleCacheTests PROPERTIES
+    CXX_STANDARD 14
+    CXX_STANDARD_REQUIRED ON
+    )
+  add_test(NAME sampleCacheTests
+    COMMAND $<TARGET_FILE:sampleCacheTests> ${TEST_ARGS})
+
 endif(NOT SNDFILE_LIBRARY)
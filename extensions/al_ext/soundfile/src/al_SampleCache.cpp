@@ -0,0 +1,441 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include "al_ext/soundfile/al_SampleCache.hpp"
+
+#include "Gamma/SoundFile.h"
+
+#ifndef AL_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace al;
+
+namespace {
+
+uint32_t readU32(const unsigned char *p) {
+  return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+uint16_t readU16(const unsigned char *p) {
+  return uint16_t(p[0] | (p[1] << 8));
+}
+
+bool littleEndian() {
+  const uint16_t value = 1;
+  return *reinterpret_cast<const unsigned char *>(&value) == 1;
+}
+
+template<SamplePlayer::Interpolation I>
+inline float interpolate(float xm1, float x0, float x1, float x2, float f) {
+  switch (I) {
+  case SamplePlayer::NONE:
+    return x0;
+  case SamplePlayer::LINEAR:
+    return x0 + f * (x1 - x0);
+  default: {
+    float c1 = 0.5f * (x1 - xm1);
+    float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+    float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+    return ((c3 * f + c2) * f + c1) * f + x0;
+  }
+  }
+}
+
+} // namespace
+
+Sample::~Sample()
+{
+#ifndef AL_WINDOWS
+  if (mMapped) {
+    munmap(mMapped, mMappedSize);
+  }
+#endif
+}
+
+SampleCache::SampleCache(size_t budgetBytes) :
+  mBudget(budgetBytes)
+{
+}
+
+SampleCache::~SampleCache()
+{
+  {
+    std::lock_guard<std::mutex> lk(mLock);
+    mRunning = false;
+    mPreloading -= int(mPreloadQueue.size());
+    mPreloadQueue.clear();
+  }
+  mPreloadCondVar.notify_all();
+  if (mPreloadThread.joinable()) {
+    mPreloadThread.join();
+  }
+}
+
+SampleCache &SampleCache::global()
+{
+  static SampleCache cache;
+  return cache;
+}
+
+SampleHandle SampleCache::get(const std::string &path)
+{
+  std::unique_lock<std::mutex> lk(mLock);
+  auto it = mEntries.find(path);
+  while (it != mEntries.end() && it->second.loading) {
+    // Another thread is loading this file
+    mLoaded.wait(lk);
+    it = mEntries.find(path);
+  }
+  if (it != mEntries.end()) {
+    mLru.splice(mLru.begin(), mLru, it->second.lru);
+    return it->second.sample;
+  }
+
+  mEntries[path] = Entry();
+  lk.unlock();
+  std::shared_ptr<Sample> sample = load(path);
+  lk.lock();
+  it = mEntries.find(path);
+  if (!sample) {
+    mEntries.erase(it);
+    mLoaded.notify_all();
+    return nullptr;
+  }
+  it->second.sample = sample;
+  it->second.loading = false;
+  mLru.push_front(path);
+  it->second.lru = mLru.begin();
+  mBytesUsed += sample->bytes();
+  mLoaded.notify_all();
+  // The new sample has a handle, so it is not evicted
+  trim(mBudget);
+  return sample;
+}
+
+SampleHandle SampleCache::find(const std::string &path)
+{
+  std::lock_guard<std::mutex> lk(mLock);
+  auto it = mEntries.find(path);
+  if (it == mEntries.end() || it->second.loading) {
+    return nullptr;
+  }
+  mLru.splice(mLru.begin(), mLru, it->second.lru);
+  return it->second.sample;
+}
+
+void SampleCache::preload(const std::string &path)
+{
+  {
+    std::lock_guard<std::mutex> lk(mLock);
+    if (mEntries.find(path) != mEntries.end()) {
+      return;
+    }
+    mPreloadQueue.push_back(path);
+    mPreloading++;
+    if (!mPreloadThread.joinable()) {
+      mPreloadThread = std::thread(&SampleCache::preloadLoop, this);
+    }
+  }
+  mPreloadCondVar.notify_one();
+}
+
+void SampleCache::waitForPreload()
+{
+  std::unique_lock<std::mutex> lk(mLock);
+  mPreloadDone.wait(lk, [this]() { return mPreloading == 0; });
+}
+
+void SampleCache::budget(size_t bytes)
+{
+  std::lock_guard<std::mutex> lk(mLock);
+  mBudget = bytes;
+  trim(mBudget);
+}
+
+size_t SampleCache::bytesUsed()
+{
+  std::lock_guard<std::mutex> lk(mLock);
+  return mBytesUsed;
+}
+
+size_t SampleCache::size()
+{
+  std::lock_guard<std::mutex> lk(mLock);
+  return mLru.size();
+}
+
+void SampleCache::evictUnused()
+{
+  std::lock_guard<std::mutex> lk(mLock);
+  trim(0);
+}
+
+void SampleCache::trim(size_t budget)
+{
+  auto it = mLru.end();
+  while (mBytesUsed > budget && it != mLru.begin()) {
+    --it;
+    auto entry = mEntries.find(*it);
+    // Only the cache holds samples with a use count of 1
+    if (entry->second.sample.use_count() == 1) {
+      mBytesUsed -= entry->second.sample->bytes();
+      mEntries.erase(entry);
+      it = mLru.erase(it);
+    }
+  }
+}
+
+void SampleCache::preloadLoop()
+{
+  std::unique_lock<std::mutex> lk(mLock);
+  while (mRunning) {
+    if (mPreloadQueue.empty()) {
+      mPreloadCondVar.wait(lk);
+      continue;
+    }
+    std::string path = mPreloadQueue.front();
+    mPreloadQueue.pop_front();
+    lk.unlock();
+    get(path);
+    lk.lock();
+    mPreloading--;
+    if (mPreloading == 0) {
+      mPreloadDone.notify_all();
+    }
+  }
+}
+
+std::shared_ptr<Sample> SampleCache::load(const std::string &path)
+{
+  std::shared_ptr<Sample> sample(new Sample);
+  sample->mPath = path;
+  if (!(mUseMapping && mapFloatWav(path, *sample)) && !decode(path, *sample)) {
+    std::cerr << "ERROR: Could not load sample " << path << std::endl;
+    return nullptr;
+  }
+  mLoadCount++;
+  return sample;
+}
+
+bool SampleCache::mapFloatWav(const std::string &path, Sample &sample)
+{
+#ifndef AL_WINDOWS
+  if (!littleEndian()) {
+    return false;
+  }
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size < 44) {
+    close(fd);
+    return false;
+  }
+  size_t size = info.st_size;
+  void *mem = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED) {
+    return false;
+  }
+  const unsigned char *file = static_cast<const unsigned char *>(mem);
+
+  // Find format and data chunks of a RIFF WAVE file
+  int format = 0, channels = 0, bits = 0;
+  uint32_t frameRate = 0;
+  size_t dataOffset = 0, dataSize = 0;
+  if (memcmp(file, "RIFF", 4) == 0 && memcmp(file + 8, "WAVE", 4) == 0) {
+    size_t offset = 12;
+    while (offset + 8 <= size && dataOffset == 0) {
+      const unsigned char *chunk = file + offset;
+      size_t chunkSize = readU32(chunk + 4);
+      if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && offset + 8 + chunkSize <= size) {
+        format = readU16(chunk + 8);
+        channels = readU16(chunk + 10);
+        frameRate = readU32(chunk + 12);
+        bits = readU16(chunk + 22);
+        if (format == 0xFFFE && chunkSize >= 40) { // WAVE_FORMAT_EXTENSIBLE
+          format = readU16(chunk + 32);
+        }
+      } else if (memcmp(chunk, "data", 4) == 0) {
+        dataOffset = offset + 8;
+        dataSize = std::min(chunkSize, size - dataOffset);
+      }
+      offset += 8 + chunkSize + (chunkSize & 1);
+    }
+  }
+  // Only 32-bit IEEE float data aligned for reading in place
+  if (format != 3 || bits != 32 || channels == 0 || dataOffset == 0
+      || dataOffset % sizeof(float) != 0) {
+    munmap(mem, size);
+    return false;
+  }
+  // Start reading pages in now, as the sample is about to be played
+  madvise(mem, size, MADV_WILLNEED);
+  sample.mMapped = mem;
+  sample.mMappedSize = size;
+  sample.mData = reinterpret_cast<const float *>(file + dataOffset);
+  sample.mChannels = channels;
+  sample.mFrames = int(dataSize / (channels * sizeof(float)));
+  sample.mFrameRate = frameRate;
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool SampleCache::decode(const std::string &path, Sample &sample)
+{
+  gam::SoundFile sf(path);
+  if (!sf.openRead()) {
+    return false;
+  }
+  int frames = sf.frames();
+  int channels = sf.channels();
+  if (channels <= 0) {
+    sf.close();
+    return false;
+  }
+  sample.mDecoded.reset(new float[size_t(frames) * channels]);
+  int framesRead = sf.read(sample.mDecoded.get(), frames);
+  sf.close();
+  sample.mData = sample.mDecoded.get();
+  sample.mFrames = framesRead > 0 ? framesRead : 0;
+  sample.mChannels = channels;
+  sample.mFrameRate = sf.frameRate();
+  return true;
+}
+
+void SamplePlayer::sample(SampleHandle s)
+{
+  mSample = s;
+  mPosition = 0;
+}
+
+void SamplePlayer::semitones(double s)
+{
+  mRate = std::pow(2.0, s / 12.0);
+}
+
+bool SamplePlayer::done() const
+{
+  return !mSample || (!mLoop && mPosition >= mSample->frames());
+}
+
+int SamplePlayer::process(float *const *out, int numOutChannels, int numFrames, float gain)
+{
+  if (!mSample || mSample->frames() == 0 || mRate <= 0) {
+    return 0;
+  }
+  switch (mInterpolation) {
+  case NONE:
+    return processFrames<NONE>(out, numOutChannels, numFrames, gain);
+  case LINEAR:
+    return processFrames<LINEAR>(out, numOutChannels, numFrames, gain);
+  default:
+    return processFrames<CUBIC>(out, numOutChannels, numFrames, gain);
+  }
+}
+
+int SamplePlayer::process(AudioIOData &io, float gain)
+{
+  // io.frame() is the frame before the next one to write
+  int start = int(io.frame() + 1);
+  int numFrames = int(io.framesPerBuffer()) - start;
+  int numOutChannels = std::min(int(io.channelsOut()), 64);
+  if (numFrames <= 0 || numOutChannels <= 0) {
+    return 0;
+  }
+  float *out[64];
+  for (int c = 0; c < numOutChannels; c++) {
+    out[c] = io.outBuffer(c) + start;
+  }
+  int written = process(out, numOutChannels, numFrames, gain);
+  io.frame(io.framesPerBuffer());
+  return written;
+}
+
+template<SamplePlayer::Interpolation I>
+int SamplePlayer::processFrames(float *const *out, int numOutChannels, int numFrames, float gain)
+{
+  const float *data = mSample->data();
+  const int frames = mSample->frames();
+  const int channels = mSample->channels();
+  const int outChannels = channels == 1 ? numOutChannels : std::min(channels, numOutChannels);
+  // Frames whose interpolation taps are all inside the sample
+  const int first = I == CUBIC ? 1 : 0;
+  const int last = frames - 1 - (I == CUBIC ? 2 : (I == LINEAR ? 1 : 0));
+
+  int written = 0;
+  while (written < numFrames) {
+    if (mLoop) {
+      if (mPosition >= frames) {
+        mPosition = std::fmod(mPosition, double(frames));
+      }
+    } else if (mPosition >= frames) {
+      break;
+    }
+    int index = int(mPosition);
+
+    if (index >= first && index <= last) {
+      // Fast path, no bounds checks
+      double remaining = std::ceil((last + 1 - mPosition) / mRate);
+      int count = remaining < numFrames - written ? int(remaining) : numFrames - written;
+      while (count > 0 && int(mPosition + (count - 1) * mRate) > last) {
+        count--;
+      }
+      for (int j = 0; j < count; j++) {
+        double pos = mPosition + j * mRate;
+        int i = int(pos);
+        float f = float(pos - i);
+        const float *s = data + size_t(i) * channels;
+        if (channels == 1) {
+          float v = gain * interpolate<I>(I == CUBIC ? s[-1] : 0.0f, s[0],
+                                          I != NONE ? s[1] : 0.0f, I == CUBIC ? s[2] : 0.0f, f);
+          for (int c = 0; c < outChannels; c++) {
+            out[c][written + j] += v;
+          }
+        } else {
+          for (int c = 0; c < outChannels; c++) {
+            out[c][written + j] += gain * interpolate<I>(
+                I == CUBIC ? s[c - channels] : 0.0f, s[c],
+                I != NONE ? s[c + channels] : 0.0f, I == CUBIC ? s[c + 2 * channels] : 0.0f, f);
+          }
+        }
+      }
+      if (count > 0) {
+        mPosition += count * mRate;
+        written += count;
+        continue;
+      }
+    }
+
+    // Frame near the edges of the sample. Taps wrap around when looping and
+    // are zero outside the sample otherwise.
+    float f = float(mPosition - index);
+    auto tap = [&](int i, int c) {
+      if (i < 0 || i >= frames) {
+        if (!mLoop) {
+          return 0.0f;
+        }
+        i = (i % frames + frames) % frames;
+      }
+      return data[size_t(i) * channels + c];
+    };
+    for (int c = 0; c < outChannels; c++) {
+      int sc = channels == 1 ? 0 : c;
+      out[c][written] += gain * interpolate<I>(tap(index - 1, sc), tap(index, sc),
+                                               tap(index + 1, sc), tap(index + 2, sc), f);
+    }
+    mPosition += mRate;
+    written++;
+  }
+  return written;
+}
@@ -2,16 +2,19 @@
 
 using namespace al;
 
-SoundFileBuffered::SoundFileBuffered(std::string fullPath, bool loop, int bufferFrames) :
-  mRunning(true),
+SoundFileBuffered::SoundFileBuffered(std::string fullPath, bool loop, int bufferFrames,
+                                     std::shared_ptr<SoundFileStreamEngine> engine) :
   mLoop(loop),
   mRepeats(0),
   mSeek(-1),
   mCurPos(0),
   mBufferFrames(bufferFrames),
-  mReadCallback(nullptr)
+  mReadCallback(nullptr),
+  mEngine(engine)
 {
-  open(fullPath);
+  if (fullPath.size() > 0) {
+    open(fullPath);
+  }
 }
 
 SoundFileBuffered::~SoundFileBuffered()
@@ -26,8 +29,20 @@ bool SoundFileBuffered::open(std::string fullPath)
   mSf.openRead();
   if (mSf.opened()) {
     mRingBuffer = new SingleRWRingBuffer(mBufferFrames * channels() * sizeof(float));
-    mReaderThread = new std::thread(readFunction, this);
-    mFileBuffer = new float[mBufferFrames * channels()];
+    // Reads fill all the free space in the ring buffer at once
+    mFileBufferFrames = mRingBuffer->writeSpace() / (channels() * sizeof(float));
+    mFileBuffer = new float[mFileBufferFrames * channels()];
+    mRepeats = 0;
+    mSeek = -1;
+    mCurPos = 0;
+    mFilePos = 0;
+    mUnderruns = 0;
+    mEndReached = false;
+    if (!mEngine) {
+      mEngine = SoundFileStreamEngine::shared();
+    }
+    mActiveEngine = mEngine.get();
+    mActiveEngine->add(this);
     return true;
   }
   return false;
@@ -37,12 +52,12 @@ bool SoundFileBuffered::close()
 {
 
   if (mSf.opened()) {
-    mRunning = false;
-    mCondVar.notify_one();
-    mReaderThread->join();
-    delete mReaderThread;
+    mActiveEngine->remove(this);
+    mActiveEngine = nullptr;
     delete mRingBuffer;
+    mRingBuffer = nullptr;
     delete[] mFileBuffer;
+    mFileBuffer = nullptr;
     mSf.close();
   }
   return true;
@@ -50,11 +65,13 @@ bool SoundFileBuffered::close()
 
 size_t SoundFileBuffered::read(float *buffer, int numFrames)
 {
+  if (!mRingBuffer) {
+    return 0;
+  }
   size_t bytesRead = mRingBuffer->read((char *) buffer, numFrames * channels() * sizeof(float));
-  if (bytesRead != numFrames * channels() * sizeof(float)) {
-    // TODO: handle underrun
+  if (bytesRead != numFrames * channels() * sizeof(float) && !mEndReached.load()) {
+    mUnderruns.fetch_add(1);
   }
-  mCondVar.notify_one();
   return bytesRead / (channels() * sizeof(float));
 }
 
@@ -63,34 +80,60 @@ bool SoundFileBuffered::opened() const
   return mSf.opened();
 }
 
-void SoundFileBuffered::readFunction(SoundFileBuffered  *obj)
+double SoundFileBuffered::deadline(float minFraction, float urgentTime) const
 {
-  while (obj->mRunning) {
-    std::unique_lock<std::mutex> lk(obj->mLock);
-    obj->mCondVar.wait(lk);
-    int framesToRead = obj->mRingBuffer->writeSpace() / (obj->channels() * sizeof(float));
-    int framesRead = obj->mSf.read(obj->mFileBuffer, framesToRead);
-    std::atomic_fetch_add(&(obj->mCurPos), framesRead);
-    int seek = obj->mSeek.load();
-    if (seek >= 0) { // Process seek request
-      obj->mSf.seek(seek, SEEK_SET);
-      obj->mSeek.store(-1);
-    }
-    if (framesRead != framesToRead) { // Final incomplete buffer in the file
-      framesRead += obj->mSf.read(obj->mFileBuffer + framesRead, framesToRead - framesRead);
-      if (obj->mLoop) {
-        obj->mSf.seek(0, SEEK_SET);
-        std::atomic_fetch_add(&(obj->mRepeats), 1);
-      }
+  if (mSeek.load() >= 0) {
+    return 0.0; // Serve seeks first
+  }
+  if (mEndReached.load()) {
+    return -1.0;
+  }
+  size_t frameBytes = channels() * sizeof(float);
+  double framesLeft = mRingBuffer->readSpace() / frameBytes;
+  double secondsLeft = framesLeft / frameRate();
+  size_t freeFrames = mRingBuffer->writeSpace() / frameBytes;
+  if (freeFrames == 0
+      || (freeFrames < minFraction * mFileBufferFrames && secondsLeft > urgentTime)) {
+    return -1.0;
+  }
+  return secondsLeft;
+}
+
+void SoundFileBuffered::fill()
+{
+  int seek = mSeek.exchange(-1);
+  if (seek >= 0) { // Process seek request before reading and looping
+    mSf.seek(seek, SEEK_SET);
+    mFilePos = seek;
+    mEndReached = false;
+  }
+  int framesToRead = mRingBuffer->writeSpace() / (channels() * sizeof(float));
+  if (framesToRead > mFileBufferFrames) {
+    framesToRead = mFileBufferFrames;
+  }
+  int framesRead = mSf.read(mFileBuffer, framesToRead);
+  int position = mFilePos + framesRead;
+  while (framesRead < framesToRead) { // Final incomplete buffer in the file
+    if (!mLoop || frames() == 0) {
+      mEndReached = true;
+      break;
     }
-    size_t written = obj->mRingBuffer->write((const char*) obj->mFileBuffer, framesRead * sizeof(float) * obj->channels());
-    //		if (written != framesRead * sizeof(float) * obj->channels()) {
-    //			// TODO handle overrun
-    //		}
-    if (obj->mReadCallback) {
-      obj->mReadCallback(obj->mFileBuffer, obj->mSf.channels(), framesRead, obj->mCallbackData);
+    mSf.seek(0, SEEK_SET);
+    std::atomic_fetch_add(&mRepeats, 1);
+    int framesLooped = mSf.read(mFileBuffer + framesRead * channels(), framesToRead - framesRead);
+    if (framesLooped <= 0) {
+      break;
     }
-    lk.unlock();
+    framesRead += framesLooped;
+    position = framesLooped;
+  }
+  mFilePos = position;
+  if (mSeek.load() < 0) { // Don't overwrite the position of a newer seek
+    mCurPos.store(position);
+  }
+  mRingBuffer->write((const char*) mFileBuffer, framesRead * sizeof(float) * channels());
+  if (mReadCallback) {
+    mReadCallback(mFileBuffer, mSf.channels(), framesRead, mCallbackData);
   }
 }
 
@@ -167,8 +210,10 @@ void SoundFileBuffered::seek(int frame)
   if (frame >= frames()) {
     frame = frames() - 1;
   }
-  mSeek.store(frame);
+  // Picked up by the next poll of the engine, so seeking does not signal
+  // other threads and can be done from the audio thread
   mCurPos.store(frame);
+  mSeek.store(frame);
 }
 
 int SoundFileBuffered::currentPosition()
@@ -1,4 +1,4 @@
-#include <cassert>
+#include <chrono>
 #include <iostream>
 
 #include "al_ext/soundfile/al_SoundfileBufferedRecord.hpp"
@@ -17,118 +17,173 @@ SoundFileBufferedRecord::~SoundFileBufferedRecord()
 }
 
 bool SoundFileBufferedRecord::open(std::string fullPath, double frameRate, uint32_t numChannels, uint32_t bufferFrames, Format format,
-                                   EncodingType encoding)
+                                   EncodingType encoding, bool multiFile)
 {
   close();
-  mSf.frameRate(frameRate);
-  mSf.channels(int(numChannels));
-  mSf.format(format);
-  mSf.encoding(encoding);
-  mBufferFrames = bufferFrames;
-
-  mRingBuffer = new SingleRWRingBuffer(mBufferFrames * numChannels * sizeof(float));
-  mFileBuffer = std::make_unique<float []>(mBufferFrames * numChannels);
-  std::condition_variable cond;
-  std::mutex condMutex;
-  {
-    std::unique_lock<std::mutex> lk(condMutex);
-    mReaderThread = new std::thread(writeFunction, this, &cond, &condMutex);
-    cond.wait(lk); // Wait for thread to have started
-  }
-
-  mSf.openWrite(fullPath);
-  if (!mSf.opened()) {
-    std::cerr << "ERROR opening sound file in " << __FUNCTION__ << std::endl;
-    cleanup();
+  if (numChannels == 0) {
+    std::cerr << "ERROR: no channels to record in " << __FUNCTION__ << std::endl;
     return false;
   }
+  uint32_t numFiles = multiFile ? numChannels : 1;
+  for (uint32_t i = 0; i < numFiles; i++) {
+    mFiles.emplace_back(new gam::SoundFile);
+    gam::SoundFile &sf = *mFiles.back();
+    sf.frameRate(frameRate);
+    sf.channels(multiFile ? 1 : int(numChannels));
+    sf.format(format);
+    sf.encoding(encoding);
+    std::string path = multiFile ? channelPath(fullPath, i + 1) : fullPath;
+    sf.openWrite(path);
+    if (!sf.opened()) {
+      std::cerr << "ERROR opening sound file " << path << " in " << __FUNCTION__ << std::endl;
+      close();
+      return false;
+    }
+  }
+
+  mChannels = numChannels;
+  mFrameRate = frameRate;
+  mBufferFrames = bufferFrames;
+  mCurPos = 0;
+  mOverruns = 0;
+  mFinished = false;
+  for (uint32_t c = 0; c < numChannels; c++) {
+    mRingBuffers.emplace_back(new SingleRWRingBuffer(mBufferFrames * sizeof(float)));
+  }
+  mSilence = std::make_unique<float []>(mBufferFrames);
+  mPlanarBuffer = std::make_unique<float []>(mBufferFrames * numChannels);
+  mFileBuffer = std::make_unique<float []>(mBufferFrames * numChannels);
+
+  mRunning = true;
+  mWriterThread = new std::thread(writeFunction, this);
   return true;
 }
 
 void SoundFileBufferedRecord::cleanup()
 {
-  if (mReaderThread &&  mRingBuffer) {
-    mRunning = false;
+  if (mWriterThread) {
+    {
+      std::lock_guard<std::mutex> lk(mLock);
+      mRunning = false;
+    }
     mCondVar.notify_one();
-    mReaderThread->join();
-    delete mReaderThread;
-    delete mRingBuffer;
-    mReaderThread = nullptr;
-    mRingBuffer = nullptr;
+    mWriterThread->join();
+    delete mWriterThread;
+    mWriterThread = nullptr;
   }
+  mRingBuffers.clear();
+  mSilence.reset();
+  mPlanarBuffer.reset();
+  mFileBuffer.reset();
 }
 
 bool SoundFileBufferedRecord::close()
 {
-
-  if (mSf.opened()) {
-    mSf.close();
+  // Write remaining audio before closing files
+  cleanup();
+  for (auto &sf : mFiles) {
+    if (sf->opened()) {
+      sf->close();
+    }
   }
+  mFiles.clear();
   return true;
 }
 
-void SoundFileBufferedRecord::write(std::vector<float *> buffers, size_t numFrames)
+void SoundFileBufferedRecord::write(const float *const *buffers, uint32_t numChannels, size_t numFrames)
 {
-  size_t channel = 0;
-  // FIXME we should do the interleaving in the writing thread
-  assert(buffers.size() == mSf.channels());
-  for(auto *buf: buffers) {
-    float *destBuf = mFileBuffer.get() + channel++;
-    for (size_t i = 0; i < numFrames; i++) {
-      *destBuf = *buf++;
-      destBuf += mSf.channels();
+  if (!mRunning || mFinished) {
+    return;
+  }
+  size_t bytes = numFrames * sizeof(float);
+  for (auto &ring : mRingBuffers) {
+    if (ring->writeSpace() < bytes) {
+      // Dropping the whole block keeps channels aligned. Reported by the
+      // writer thread, printing here could block the audio thread
+      mOverruns.fetch_add(1);
+      return;
     }
   }
-  size_t bytesWritten = mRingBuffer->write((char *) mFileBuffer.get(), numFrames * mSf.channels() * sizeof(float));
-  if (bytesWritten != numFrames * mSf.channels() * sizeof(float)) {
-    std::cerr << "Recording buffer overrun. Increase buffer size" << std::endl;
+  for (uint32_t c = 0; c < mChannels; c++) {
+    const float *src = c < numChannels ? buffers[c] : mSilence.get();
+    mRingBuffers[c]->write((const char *) src, bytes);
   }
-  mCondVar.notify_one();
-  return;
 }
 
 bool SoundFileBufferedRecord::opened() const
 {
-  return mSf.opened();
+  return mFiles.size() > 0 && mFiles[0]->opened();
 }
 
-void SoundFileBufferedRecord::writeFunction(SoundFileBufferedRecord  *obj, std::condition_variable *cond, std::mutex *condMutex)
+std::string SoundFileBufferedRecord::channelPath(std::string fullPath, uint32_t channel)
 {
-  obj->mRunning = true;
-  float *writeBuffer = new float[size_t(obj->mBufferFrames * obj->mSf.channels())];
-  condMutex->lock();
-  cond->notify_all(); // Signal thread is processing;
-  condMutex->unlock();
-  while (obj->mRunning) {
-    std::unique_lock<std::mutex> lk(obj->mLock);
-    obj->mCondVar.wait(lk);
-    int bytesToWrite = obj->mRingBuffer->read((char *) writeBuffer, obj->mSf.frameRate() * obj->mSf.channels() * sizeof(float));
-    int framesToWrite = bytesToWrite/(obj->mSf.channels() * sizeof(float));
-    int framesWritten = obj->mSf.write<float>(obj->mFileBuffer.get(), framesToWrite);
-//    std::cout << "Wrote " << framesWritten << std::endl;
-    std::atomic_fetch_add(&(obj->mCurPos), framesWritten);
-
-    if (obj->mMaxWriteTime > 0 && obj->mCurPos >= obj->mMaxWriteTime * obj->mSf.frameRate()) {
-      std::cout << "SoundFileBufferedRecord max time exceeded. Closing sound file" << std::endl;
-      obj->mRunning = false;
-      obj->mSf.close();
+  size_t dot = fullPath.find_last_of('.');
+  size_t slash = fullPath.find_last_of("/\\");
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+    dot = fullPath.size();
+  }
+  return fullPath.substr(0, dot) + "_" + std::to_string(channel) + fullPath.substr(dot);
+}
+
+size_t SoundFileBufferedRecord::writeBlock(size_t maxFrames)
+{
+  size_t frames = maxFrames;
+  for (auto &ring : mRingBuffers) {
+    frames = std::min(frames, ring->readSpace() / sizeof(float));
+  }
+  size_t maxPos = size_t(mMaxWriteTime * mFrameRate);
+  if (mMaxWriteTime > 0) {
+    size_t pos = size_t(mCurPos.load());
+    frames = pos < maxPos ? std::min(frames, maxPos - pos) : 0;
+  }
+  if (frames == 0) {
+    return 0;
+  }
+
+  // Channels are stored one after the other, frames long
+  float *planar = mPlanarBuffer.get();
+  for (uint32_t c = 0; c < mChannels; c++) {
+    mRingBuffers[c]->read((char *) (planar + c * frames), frames * sizeof(float));
+  }
+  if (mFiles.size() > 1) {
+    for (uint32_t c = 0; c < mChannels; c++) {
+      mFiles[c]->write<float>(planar + c * frames, int(frames));
     }
-    //		if (written != framesWritten * sizeof(float) * obj->channels()) {
-    //			// TODO handle overrun
-    //		}
-//    if (obj->mReadCallback) {
-//      obj->mReadCallback(obj->mFileBuffer, obj->mSf.channels(), framesWritten, obj->mCallbackData);
-//    }
-    lk.unlock();
-  }
-  delete[] writeBuffer;
+  } else {
+    interleave(mFileBuffer.get(), planar, int(frames), int(mChannels));
+    mFiles[0]->write<float>(mFileBuffer.get(), int(frames));
+  }
+  std::atomic_fetch_add(&mCurPos, int(frames));
+
+  if (mMaxWriteTime > 0 && size_t(mCurPos.load()) >= maxPos) {
+    std::cout << "SoundFileBufferedRecord max time exceeded. Stopped recording" << std::endl;
+    mFinished = true;
+  }
+  return frames;
 }
 
-//void SoundFileBufferedRecord::setWriteCallback(SoundFileBufferedRecord::CallbackFunc func, void *userData)
-//{
-//  mReadCallback = func;
-//  mCallbackData = userData;
-//}
+void SoundFileBufferedRecord::writeFunction(SoundFileBufferedRecord *obj)
+{
+  // Poll often enough to read the ring buffers well before they fill
+  auto pollTime = std::chrono::duration<double>(obj->mBufferFrames / obj->mFrameRate / 4.0);
+  int overrunsReported = 0;
+  while (true) {
+    // Anything written before close() is written to the file
+    bool running = obj->mRunning;
+    while (obj->writeBlock(obj->mBufferFrames) > 0) {
+    }
+    int overruns = obj->mOverruns.load();
+    if (overruns != overrunsReported) {
+      std::cerr << "Recording buffer overrun. Increase buffer size" << std::endl;
+      overrunsReported = overruns;
+    }
+    if (!running) {
+      break;
+    }
+    std::unique_lock<std::mutex> lk(obj->mLock);
+    obj->mCondVar.wait_for(lk, pollTime, [obj]() { return !obj->mRunning; });
+  }
+}
 
 int SoundFileBufferedRecord::currentPosition()
 {
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <chrono>
+
+#include "al_ext/soundfile/al_SoundfileStreamEngine.hpp"
+#include "al_ext/soundfile/al_SoundfileBuffered.hpp"
+
+using namespace al;
+
+// Maximum number of streams an I/O thread claims per scan. Keeps the most
+// urgent streams from waiting behind a long batch.
+static const size_t kMaxClaimedStreams = 8;
+
+SoundFileStreamEngine::SoundFileStreamEngine(unsigned numThreads) :
+  mNumThreads(numThreads > 0 ? numThreads : 1)
+{
+  for (unsigned i = 0; i < mNumThreads; i++) {
+    mThreads.emplace_back(&SoundFileStreamEngine::ioLoop, this);
+  }
+}
+
+SoundFileStreamEngine::~SoundFileStreamEngine()
+{
+  {
+    std::lock_guard<std::mutex> lk(mLock);
+    mRunning = false;
+  }
+  mCondVar.notify_all();
+  for (auto &t : mThreads) {
+    t.join();
+  }
+}
+
+std::shared_ptr<SoundFileStreamEngine> SoundFileStreamEngine::shared()
+{
+  static std::mutex sharedLock;
+  static std::weak_ptr<SoundFileStreamEngine> sharedEngine;
+  std::lock_guard<std::mutex> lk(sharedLock);
+  auto engine = sharedEngine.lock();
+  if (!engine) {
+    engine = std::make_shared<SoundFileStreamEngine>();
+    sharedEngine = engine;
+  }
+  return engine;
+}
+
+void SoundFileStreamEngine::add(SoundFileBuffered *stream)
+{
+  {
+    std::lock_guard<std::mutex> lk(mLock);
+    mStreams.push_back(stream);
+  }
+  mCondVar.notify_one();
+}
+
+void SoundFileStreamEngine::remove(SoundFileBuffered *stream)
+{
+  {
+    std::lock_guard<std::mutex> lk(mLock);
+    mStreams.erase(std::remove(mStreams.begin(), mStreams.end(), stream), mStreams.end());
+  }
+  // No thread can claim the stream now, wait for a read in progress
+  while (stream->mServicing.load()) {
+    std::this_thread::yield();
+  }
+}
+
+size_t SoundFileStreamEngine::numStreams()
+{
+  std::lock_guard<std::mutex> lk(mLock);
+  return mStreams.size();
+}
+
+size_t SoundFileStreamEngine::claimStreams(std::vector<Candidate> &claimed)
+{
+  claimed.clear();
+  float minFraction = mMinReadFraction.load();
+  float urgent = mUrgentTime.load();
+  for (auto *stream : mStreams) {
+    if (stream->mServicing.load()) {
+      continue;
+    }
+    double deadline = stream->deadline(minFraction, urgent);
+    if (deadline >= 0) {
+      claimed.push_back({deadline, stream});
+    }
+  }
+  // Earliest deadlines first
+  size_t count = std::min(claimed.size(), kMaxClaimedStreams);
+  std::partial_sort(claimed.begin(), claimed.begin() + count, claimed.end(),
+                    [](const Candidate &a, const Candidate &b) {
+    return a.deadline < b.deadline;
+  });
+  claimed.resize(count);
+  for (auto &c : claimed) {
+    c.stream->mServicing.store(true);
+  }
+  return count;
+}
+
+void SoundFileStreamEngine::ioLoop()
+{
+  std::vector<Candidate> claimed;
+  std::unique_lock<std::mutex> lk(mLock);
+  while (mRunning) {
+    if (claimStreams(claimed) == 0) {
+      mCondVar.wait_for(lk, std::chrono::nanoseconds(mPollNanos.load()));
+      continue;
+    }
+    lk.unlock();
+    for (auto &c : claimed) {
+      c.stream->fill();
+      c.stream->mServicing.store(false);
+    }
+    mReadCount.fetch_add(claimed.size());
+    lk.lock();
+  }
+}
@@ -0,0 +1,236 @@
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <string>
+
+#include "al_ext/soundfile/al_SampleCache.hpp"
+
+#include "Gamma/SoundFile.h"
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+using namespace std;
+
+static void writeFile(string path, const vector<float> &data, int channels,
+                      gam::SoundFile::EncodingType encoding) {
+  gam::SoundFile sf(path);
+  sf.format(gam::SoundFile::WAV);
+  sf.encoding(encoding);
+  sf.channels(channels);
+  sf.frameRate(48000);
+  REQUIRE(sf.openWrite());
+  sf.write(data.data(), int(data.size()) / channels);
+  sf.close();
+}
+
+// Frame i of channel c holds (i + 1) * (c + 1) / 1024
+static vector<float> ramp(int frames, int channels) {
+  vector<float> data(frames * channels);
+  for (int i = 0; i < frames; i++) {
+    for (int c = 0; c < channels; c++) {
+      data[i * channels + c] = (i + 1) * (c + 1) / 1024.0f;
+    }
+  }
+  return data;
+}
+
+TEST_CASE( "Load samples", "[SampleCache]" ) {
+  writeFile("float.wav", ramp(300, 2), 2, gam::SoundFile::FLOAT);
+  writeFile("pcm16.wav", ramp(300, 2), 2, gam::SoundFile::PCM_16);
+  al::SampleCache cache;
+
+  // 16-bit files are within quantization error
+  for (string path : {"float.wav", "pcm16.wav"}) {
+    float tolerance = path == "float.wav" ? 0.0f : 1.0f / 16384;
+    al::SampleHandle sample = cache.get(path);
+    REQUIRE(sample);
+    REQUIRE(sample->frames() == 300);
+    REQUIRE(sample->channels() == 2);
+    REQUIRE(sample->frameRate() == 48000);
+    REQUIRE(sample->bytes() == 300 * 2 * sizeof(float));
+    bool match = true;
+    for (int i = 0; i < 600; i++) {
+      match &= fabs(sample->data()[i] - ramp(300, 2)[i]) <= tolerance;
+    }
+    REQUIRE(match);
+  }
+#ifndef AL_WINDOWS
+  REQUIRE(cache.get("float.wav")->mapped());
+#endif
+  REQUIRE(!cache.get("pcm16.wav")->mapped());
+
+  // Decoded when mapping is disabled
+  al::SampleCache decoding;
+  decoding.useMapping(false);
+  REQUIRE(!decoding.get("float.wav")->mapped());
+  REQUIRE(decoding.get("float.wav")->data()[599] == ramp(300, 2)[599]);
+
+  REQUIRE(!cache.get("missing.wav"));
+  REQUIRE(cache.size() == 2);
+}
+
+TEST_CASE( "Share and evict samples", "[SampleCache]" ) {
+  const size_t sampleBytes = 1000 * sizeof(float);
+  for (int i = 0; i < 4; i++) {
+    writeFile("s" + to_string(i) + ".wav", ramp(1000, 1), 1, gam::SoundFile::PCM_16);
+  }
+  al::SampleCache cache(sampleBytes * 2);
+
+  // Handles share one copy of the data
+  al::SampleHandle a = cache.get("s0.wav");
+  al::SampleHandle b = cache.get("s0.wav");
+  REQUIRE(a.get() == b.get());
+  REQUIRE(cache.loadCount() == 1);
+  REQUIRE(cache.find("s0.wav").get() == a.get());
+  REQUIRE(!cache.find("s1.wav"));
+
+  // Unused samples stay cached within budget
+  cache.get("s1.wav");
+  REQUIRE(cache.size() == 2);
+  REQUIRE(cache.bytesUsed() == sampleBytes * 2);
+
+  // Over budget the least recently used unused sample is evicted
+  cache.get("s2.wav");
+  REQUIRE(cache.size() == 2);
+  REQUIRE(!cache.find("s1.wav"));
+  REQUIRE(cache.find("s2.wav"));
+
+  // Samples with handles are kept over budget
+  al::SampleHandle c = cache.get("s3.wav");
+  cache.budget(0);
+  REQUIRE(cache.size() == 2);
+  REQUIRE(cache.find("s0.wav"));
+  REQUIRE(cache.find("s3.wav"));
+  REQUIRE(cache.bytesUsed() == sampleBytes * 2);
+
+  a.reset();
+  b.reset();
+  cache.evictUnused();
+  REQUIRE(cache.size() == 1);
+  // Data stays valid while a handle exists
+  REQUIRE(c->data()[999] == Approx(ramp(1000, 1)[999]).margin(1.0 / 16384));
+  c.reset();
+  cache.evictUnused();
+  REQUIRE(cache.size() == 0);
+  REQUIRE(cache.bytesUsed() == 0);
+}
+
+TEST_CASE( "Preload samples", "[SampleCache]" ) {
+  vector<string> paths;
+  for (int i = 0; i < 8; i++) {
+    paths.push_back("pre" + to_string(i) + ".wav");
+    writeFile(paths.back(), ramp(20000, 2), 2, gam::SoundFile::PCM_16);
+  }
+  al::SampleCache cache;
+  for (auto &path : paths) {
+    cache.preload(path);
+  }
+  cache.preload("missing.wav");
+  cache.waitForPreload();
+  REQUIRE(cache.size() == 8);
+  for (auto &path : paths) {
+    REQUIRE(cache.find(path));
+  }
+  // Loading again uses the preloaded data
+  cache.get(paths[0]);
+  REQUIRE(cache.loadCount() == 8);
+}
+
+TEST_CASE( "Sample playback", "[SamplePlayer]" ) {
+  writeFile("play.wav", ramp(100, 1), 1, gam::SoundFile::FLOAT);
+  writeFile("play2.wav", ramp(100, 2), 2, gam::SoundFile::FLOAT);
+  al::SampleCache cache;
+  al::SampleHandle mono = cache.get("play.wav");
+  auto value = [](double frame) { return float((frame + 1) / 1024.0); };
+
+  vector<float> left(64), right(64);
+  float *out[2] = {left.data(), right.data()};
+
+  // Rate 1 reads frames exactly, mono to all channels
+  al::SamplePlayer player(mono);
+  for (auto i : {al::SamplePlayer::NONE, al::SamplePlayer::LINEAR, al::SamplePlayer::CUBIC}) {
+    player.interpolation(i);
+    player.position(0);
+    fill(left.begin(), left.end(), 0.0f);
+    fill(right.begin(), right.end(), 0.0f);
+    REQUIRE(player.process(out, 2, 64, 0.5f) == 64);
+    bool match = true;
+    for (int j = 0; j < 64; j++) {
+      match &= left[j] == 0.5f * value(j) && right[j] == left[j];
+    }
+    REQUIRE(match);
+  }
+
+  // Half rate interpolates between frames. A ramp is reproduced exactly by
+  // linear and cubic interpolation
+  for (auto i : {al::SamplePlayer::LINEAR, al::SamplePlayer::CUBIC}) {
+    player.interpolation(i);
+    player.position(10);
+    player.rate(0.5);
+    fill(left.begin(), left.end(), 0.0f);
+    player.process(out, 1, 64);
+    bool match = true;
+    for (int j = 0; j < 64; j++) {
+      match &= fabs(left[j] - value(10 + j * 0.5)) < 1e-6;
+    }
+    REQUIRE(match);
+    REQUIRE(player.position() == 42);
+  }
+  player.interpolation(al::SamplePlayer::NONE);
+  player.position(10.5);
+  player.rate(0.5);
+  fill(left.begin(), left.end(), 0.0f);
+  player.process(out, 1, 4);
+  REQUIRE(left[0] == value(10));
+  REQUIRE(left[1] == value(11));
+  REQUIRE(left[2] == value(11));
+
+  // Pitch shift an octave up, ending before the buffer is full
+  player.semitones(12);
+  REQUIRE(player.rate() == Approx(2.0));
+  player.interpolation(al::SamplePlayer::LINEAR);
+  player.position(0);
+  fill(left.begin(), left.end(), 0.0f);
+  REQUIRE(player.process(out, 1, 64) == 50);
+  REQUIRE(player.done());
+  REQUIRE(left[49] == Approx(value(98)));
+  REQUIRE(left[50] == 0);
+  REQUIRE(player.process(out, 1, 64) == 0);
+
+  // Looping continues from the start, interpolating across the loop point
+  player.loop(true);
+  player.rate(1.5);
+  player.position(97);
+  fill(left.begin(), left.end(), 0.0f);
+  REQUIRE(player.process(out, 1, 64) == 64);
+  REQUIRE(!player.done());
+  REQUIRE(left[0] == Approx(value(97)));
+  REQUIRE(left[1] == Approx(value(98) + 0.5 * (value(99) - value(98)))); // 98.5
+  REQUIRE(left[2] == Approx(value(0))); // 100 wraps to 0
+  REQUIRE(left[3] == Approx(value(1.5)));
+  REQUIRE(player.position() == Approx(fmod(97 + 64 * 1.5, 100)));
+
+  // Stereo samples are mixed channel to channel
+  al::SamplePlayer stereo(cache.get("play2.wav"));
+  fill(left.begin(), left.end(), 1.0f);
+  fill(right.begin(), right.end(), 0.0f);
+  stereo.process(out, 2, 64);
+  REQUIRE(left[5] == 1.0f + 6 / 1024.0f);
+  REQUIRE(right[5] == 12 / 1024.0f);
+
+  // Writing to an audio callback from its current frame
+  al::AudioIOData io;
+  io.framesPerBuffer(64);
+  io.framesPerSecond(48000);
+  io.channelsIn(0);
+  io.channelsOut(2);
+  io.zeroOut();
+  io.frame(16);
+  al::SamplePlayer voice(mono);
+  REQUIRE(voice.process(io) == 48);
+  REQUIRE(!io());
+  REQUIRE(io.out(0, 15) == 0);
+  REQUIRE(io.out(0, 16) == value(0));
+  REQUIRE(io.out(1, 63) == value(47));
+}
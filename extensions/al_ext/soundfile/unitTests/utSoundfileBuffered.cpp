@@ -0,0 +1,174 @@
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <memory>
+
+#include "al_ext/soundfile/al_SoundfileBuffered.hpp"
+
+#include "Gamma/SoundFile.h"
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+using namespace std;
+
+// Write a file where each sample holds its frame index and channel
+static void writeRamp(string path, int frames, int channels) {
+  gam::SoundFile sf(path);
+  sf.format(gam::SoundFile::WAV);
+  sf.encoding(gam::SoundFile::FLOAT);
+  sf.channels(channels);
+  sf.frameRate(44100);
+  REQUIRE(sf.openWrite());
+  vector<float> data(frames * channels);
+  for (int i = 0; i < frames; i++) {
+    for (int c = 0; c < channels; c++) {
+      data[i * channels + c] = (i % 10000) / 10000.0f + c * 2;
+    }
+  }
+  sf.write(data.data(), frames);
+  sf.close();
+}
+
+static float rampValue(int frame, int channel, int frames) {
+  return (frame % frames % 10000) / 10000.0f + channel * 2;
+}
+
+// Read numFrames frames, waiting for the engine to fill the ring buffer
+static int readAll(al::SoundFileBuffered &sf, float *buffer, int numFrames) {
+  int framesRead = 0;
+  for (int tries = 0; tries < 1000 && framesRead < numFrames; tries++) {
+    framesRead += sf.read(buffer + framesRead * sf.channels(), numFrames - framesRead);
+    if (framesRead < numFrames) {
+      this_thread::sleep_for(chrono::milliseconds(1));
+    }
+  }
+  return framesRead;
+}
+
+TEST_CASE( "Read file", "[SoundFileBuffered]" ) {
+  writeRamp("ramp.wav", 30000, 2);
+  al::SoundFileBuffered sf("ramp.wav", false, 4096);
+  REQUIRE(sf.opened());
+  REQUIRE(sf.channels() == 2);
+  REQUIRE(sf.frames() == 30000);
+
+  vector<float> buffer(30000 * 2);
+  REQUIRE(readAll(sf, buffer.data(), 30000) == 30000);
+  bool match = true;
+  for (int i = 0; i < 30000; i++) {
+    match &= buffer[i * 2] == rampValue(i, 0, 30000);
+    match &= buffer[i * 2 + 1] == rampValue(i, 1, 30000);
+  }
+  REQUIRE(match);
+  REQUIRE(sf.repeats() == 0);
+
+  // Nothing left to read at the end, which is not an underrun
+  int underruns = sf.underruns();
+  REQUIRE(sf.read(buffer.data(), 256) == 0);
+  REQUIRE(sf.underruns() == underruns);
+
+  // Seek back into the file
+  sf.seek(25000);
+  this_thread::sleep_for(chrono::milliseconds(20));
+  // Frames buffered before the seek are read first
+  int framesRead = 0;
+  float frame[2];
+  for (int tries = 0; tries < 100000 && framesRead < 6000; tries++) {
+    if (sf.read(frame, 1) == 1) {
+      if (frame[0] == rampValue(25000, 0, 30000)) {
+        break;
+      }
+      framesRead++;
+    }
+  }
+  REQUIRE(frame[0] == rampValue(25000, 0, 30000));
+  REQUIRE(readAll(sf, buffer.data(), 4999) == 4999);
+  REQUIRE(buffer[4998 * 2] == rampValue(29999, 0, 30000));
+  sf.close();
+  REQUIRE(!sf.opened());
+}
+
+TEST_CASE( "Loop file", "[SoundFileBuffered]" ) {
+  writeRamp("short.wav", 1000, 1);
+  al::SoundFileBuffered sf("short.wav", true, 2048);
+  vector<float> buffer(5500);
+  REQUIRE(readAll(sf, buffer.data(), 5500) == 5500);
+  bool match = true;
+  for (int i = 0; i < 5500; i++) {
+    match &= buffer[i] == rampValue(i, 0, 1000);
+  }
+  REQUIRE(match);
+  REQUIRE(sf.repeats() >= 5);
+}
+
+TEST_CASE( "Seek in a looping file", "[SoundFileBuffered]" ) {
+  writeRamp("short.wav", 1000, 1);
+  al::SoundFileBuffered sf("short.wav", true, 2048);
+  this_thread::sleep_for(chrono::milliseconds(20));
+  vector<float> buffer(2048);
+  REQUIRE(readAll(sf, buffer.data(), 2000) == 2000);
+  // The read after the seek wraps around the end of the file
+  sf.seek(900);
+  this_thread::sleep_for(chrono::milliseconds(20));
+  REQUIRE(sf.currentPosition() >= 0);
+  REQUIRE(sf.currentPosition() < 1000);
+  float frame = -1;
+  for (int tries = 0; tries < 100000 && frame != rampValue(900, 0, 1000); tries++) {
+    sf.read(&frame, 1);
+  }
+  REQUIRE(frame == rampValue(900, 0, 1000));
+  REQUIRE(readAll(sf, buffer.data(), 1500) == 1500);
+  bool match = true;
+  for (int i = 0; i < 1500; i++) {
+    match &= buffer[i] == rampValue(901 + i, 0, 1000);
+  }
+  REQUIRE(match);
+}
+
+TEST_CASE( "Many streams on a shared engine", "[SoundFileBuffered]" ) {
+  const int numStreams = 200;
+  const int blockSize = 256;
+  const int fileFrames = 44100;
+  writeRamp("stream.wav", fileFrames, 1);
+
+  auto engine = make_shared<al::SoundFileStreamEngine>(2);
+  vector<unique_ptr<al::SoundFileBuffered>> streams;
+  for (int i = 0; i < numStreams; i++) {
+    streams.emplace_back(new al::SoundFileBuffered("stream.wav", true, 8192, engine));
+    REQUIRE(streams.back()->opened());
+  }
+  REQUIRE(engine->numStreams() == numStreams);
+  // Let the engine fill the ring buffers before starting playback
+  this_thread::sleep_for(chrono::milliseconds(200));
+
+  // Read blocks in real time for half a second
+  vector<float> buffer(blockSize);
+  int position = 0;
+  bool match = true;
+  auto next = chrono::steady_clock::now();
+  for (int block = 0; block < 44100 / 2 / blockSize; block++) {
+    for (auto &s : streams) {
+      s->read(buffer.data(), blockSize);
+      match &= buffer[0] == rampValue(position, 0, fileFrames);
+    }
+    position += blockSize;
+    next += chrono::microseconds(1000000 * blockSize / 44100);
+    this_thread::sleep_until(next);
+  }
+  int underruns = 0;
+  for (auto &s : streams) {
+    underruns += s->underruns();
+  }
+  REQUIRE(underruns == 0);
+  REQUIRE(match);
+  // Streams are read in blocks of at least a quarter of the ring buffer
+  // (about 11 reads each), rather than once per audio block (86)
+  REQUIRE(engine->readCount() < numStreams * 20);
+
+  streams.clear();
+  REQUIRE(engine->numStreams() == 0);
+}
@@ -9,6 +9,7 @@
 #include "al/core/io/al_AudioIO.hpp"
 
 #include "al_ext/soundfile/al_SoundfileBufferedRecord.hpp"
+#include "al_ext/soundfile/al_OutputRecorder.hpp"
 
 #include "Gamma/SoundFile.h"
 
@@ -19,6 +20,35 @@
 
 using namespace std;
 
+// Count allocations made by the current thread, to check that the audio
+// thread path does not allocate
+static thread_local bool countAllocations = false;
+static atomic<int> allocations {0};
+
+void *operator new(size_t size) {
+  if (countAllocations) {
+    allocations++;
+  }
+  void *p = malloc(size);
+  if (!p) {
+    throw bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+static vector<float> readFile(string path, int &channels) {
+  gam::SoundFile sf(path);
+  sf.openRead();
+  channels = sf.channels();
+  vector<float> data(sf.frames() * sf.channels());
+  sf.read<float>(data.data(), sf.frames());
+  return data;
+}
+
 TEST_CASE( "Mono recorder", "[SoundFileBufferedRecord]" ) {
   al::SoundFileBufferedRecord soundFile;
 
@@ -60,3 +90,120 @@ TEST_CASE( "Mono recorder", "[SoundFileBufferedRecord]" ) {
     }
   }
 }
+
+TEST_CASE( "Planar recorder", "[SoundFileBufferedRecord]" ) {
+  const int numChannels = 4;
+  const int blockSize = 256;
+  const int numBlocks = 40;
+  al::SoundFileBufferedRecord soundFile;
+  REQUIRE(soundFile.open("planar.wav", 44100, numChannels, 8192,
+                         al::SoundFileBufferedRecord::Format::WAV,
+                         al::SoundFileBufferedRecord::EncodingType::FLOAT));
+
+  // Only three channels are passed, the fourth is silent
+  vector<vector<float>> blocks(numChannels, vector<float>(blockSize));
+  const float *buffers[numChannels];
+  for (int c = 0; c < numChannels; c++) {
+    buffers[c] = blocks[c].data();
+  }
+  allocations = 0;
+  for (int b = 0; b < numBlocks; b++) {
+    for (int c = 0; c < numChannels; c++) {
+      for (int i = 0; i < blockSize; i++) {
+        blocks[c][i] = ((b * blockSize + i) % 1000) / 1000.0f * (c + 1) * 0.25f;
+      }
+    }
+    countAllocations = true;
+    soundFile.write(buffers, numChannels - 1, blockSize);
+    countAllocations = false;
+    // About real time
+    this_thread::sleep_for(chrono::milliseconds(5));
+  }
+  REQUIRE(allocations == 0);
+  REQUIRE(soundFile.overruns() == 0);
+  soundFile.close();
+  REQUIRE(!soundFile.opened());
+
+  int channels;
+  vector<float> data = readFile("planar.wav", channels);
+  REQUIRE(channels == numChannels);
+  REQUIRE(data.size() == numBlocks * blockSize * numChannels);
+  bool match = true;
+  for (int i = 0; i < numBlocks * blockSize; i++) {
+    for (int c = 0; c < numChannels - 1; c++) {
+      match &= data[i * numChannels + c] == (i % 1000) / 1000.0f * (c + 1) * 0.25f;
+    }
+    match &= data[i * numChannels + numChannels - 1] == 0;
+  }
+  REQUIRE(match);
+
+  // Blocks that don't fit in the ring buffers are dropped
+  REQUIRE(soundFile.open("overrun.wav", 44100, 2, 1024));
+  vector<float> big(2048);
+  const float *bigBuffers[2] = {big.data(), big.data()};
+  soundFile.write(bigBuffers, 2, 2048);
+  REQUIRE(soundFile.overruns() == 1);
+  soundFile.write(bigBuffers, 2, 512);
+  soundFile.close();
+  REQUIRE(soundFile.currentPosition() == 512);
+}
+
+TEST_CASE( "Multi file recorder", "[SoundFileBufferedRecord]" ) {
+  REQUIRE(al::SoundFileBufferedRecord::channelPath("take.wav", 2) == "take_2.wav");
+  REQUIRE(al::SoundFileBufferedRecord::channelPath("dir.x/take", 1) == "dir.x/take_1");
+
+  al::SoundFileBufferedRecord soundFile;
+  REQUIRE(soundFile.open("multi.wav", 48000, 3, 4096,
+                         al::SoundFileBufferedRecord::Format::WAV,
+                         al::SoundFileBufferedRecord::EncodingType::FLOAT, true));
+  vector<float> block(3 * 128);
+  const float *buffers[3] = {block.data(), block.data() + 128, block.data() + 256};
+  for (int b = 0; b < 10; b++) {
+    for (int i = 0; i < 3 * 128; i++) {
+      block[i] = (i / 128 + 1) * 0.1f + b * 0.01f;
+    }
+    soundFile.write(buffers, 3, 128);
+  }
+  soundFile.close();
+
+  for (int c = 0; c < 3; c++) {
+    int channels;
+    vector<float> data = readFile("multi_" + to_string(c + 1) + ".wav", channels);
+    REQUIRE(channels == 1);
+    REQUIRE(data.size() == 1280);
+    REQUIRE(data[0] == (c + 1) * 0.1f);
+    REQUIRE(data[1279] == (c + 1) * 0.1f + 9 * 0.01f);
+  }
+}
+
+TEST_CASE( "Output recorder", "[OutputRecorder]" ) {
+  al::AudioIOData io;
+  io.framesPerBuffer(256);
+  io.framesPerSecond(44100);
+  io.channelsIn(0);
+  io.channelsOut(2);
+
+  al::OutputRecorder recorder;
+  REQUIRE(recorder.start("recorder.wav", 44100, 2, 8192,
+                         al::SoundFileBufferedRecord::Format::WAV,
+                         al::SoundFileBufferedRecord::EncodingType::FLOAT));
+  allocations = 0;
+  for (int b = 0; b < 20; b++) {
+    io.frame(0);
+    while (io()) {
+      io.out(0) = 0.5f;
+      io.out(1) = -0.25f;
+    }
+    countAllocations = true;
+    recorder.onAudioCB(io);
+    countAllocations = false;
+  }
+  REQUIRE(allocations == 0);
+  recorder.stop();
+
+  int channels;
+  vector<float> data = readFile("recorder.wav", channels);
+  REQUIRE(data.size() == 20 * 256 * 2);
+  REQUIRE(data[0] == 0.5f);
+  REQUIRE(data[data.size() - 1] == -0.25f);
+}
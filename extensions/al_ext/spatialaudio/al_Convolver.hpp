@@ -1,6 +1,11 @@
 #ifndef AL_CONVOLVER_H
 #define AL_CONVOLVER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <map>
 
@@ -17,13 +22,31 @@ using namespace std;
   *
   * Built on zita convolver, which implements a realtime multithreaded multichannel convolution algorithm using non-uniform partitioning.
   *
+  * IRs can be replaced while processing with swapIRs(). The new IRs are
+  * partitioned and transformed on a background thread, and the output then
+  * crossfades from the old IRs to the new ones over a number of blocks, so
+  * there are no dropouts or clicks.
+  *
   */
 
 class Convolver
 {
 
 public:
+  /// How processBuffer() waits for the convolution threads
+  enum ProcessMode {
+    /// Wait for all partitions to be computed in every block. Output is
+    /// complete and deterministic, but the calling thread may block on the
+    /// convolution threads. Use for offline rendering.
+    THROUGHPUT,
+    /// Never wait for the convolution threads. Partitions that are late
+    /// are missing from the output, which is reported by processBuffer()
+    /// returning false. Use in real-time audio callbacks.
+    LOW_LATENCY
+  };
+
   Convolver();
+  ~Convolver();
 
   /// @brief Sets up convolver. Must be called prior to processing.
   ///
@@ -51,17 +74,55 @@ public:
                  uint32_t basePartitionSize = 64, float density = 0.0f,
                  uint32_t options = 0);
 
+  /// @brief Buffer to write input channel to before processBuffer()
+  ///
+  /// Buffers are owned by the Convolver and do not move while it is configured.
   float *getInputBuffer(unsigned int index);
 
+  /// @brief Buffer holding output channel after processBuffer()
   float *getOutputBuffer(unsigned int index);
 
+  /// @brief Convolve one block of ioBufferSize frames
+  /// @return false if not configured, or if partitions were late in LOW_LATENCY mode
   bool processBuffer();
 
+  /// @brief Set how processBuffer() waits for the convolution threads. Default is THROUGHPUT
+  void processMode(ProcessMode mode) { mMode = mode; }
+  ProcessMode processMode() const { return mMode; }
+
+  /// @brief Replace IRs while processing
+  ///
+  /// The IRs are copied, and a new convolution engine is prepared on a
+  /// background thread. processBuffer() switches to it once it is ready,
+  /// with an equal-power crossfade. Channel routing is unchanged, so there
+  /// must be as many IRs as were passed to configure(), but their length can
+  /// change.
+  ///
+  /// With warmUp, both engines process the input for the length of the new
+  /// IRs before the crossfade starts, so that the new engine's output
+  /// includes the response to earlier input when it is faded in.
+  ///
+  /// @param[in] IRs The deinterleaved IR channels.
+  /// @param[in] IRlength The size of IRs
+  /// @param[in] fadeBlocks Length of the crossfade in blocks of ioBufferSize
+  /// @param[in] warmUp Run the new IRs before fading them in
+  /// @return false if not configured, the IRs don't match or a swap is already in progress
+  bool swapIRs(vector<float *> IRs, uint32_t IRlength, uint32_t fadeBlocks = 8,
+               bool warmUp = true);
+
+  /// @brief Returns true from swapIRs() until the crossfade has ended and the old IRs are released
+  bool swapping() const { return mSwapping.load(); }
+
   /// @brief Stops processing audio and cleans up convolver object.
   /// @return Returns true upon success.
   bool shutdown(void);
 
 private:
+  Convproc *createConvproc(vector<float *> &IRs, uint32_t IRlength);
+  static void destroyConvproc(Convproc *convproc);
+  void swapFunction();
+  void stopSwapThread();
+
   vector<unsigned int> m_activeChannels;
   vector<unsigned int> m_disabledChannels;
   int m_inputChannel;
@@ -72,8 +133,34 @@ private:
   vector<float *> mIRs;
   uint32_t mIRlength;
   map<uint32_t, vector<uint32_t>> mChannelMap;
+  uint32_t mBasePartitionSize {64};
+  float mDensity {0.0f};
+  uint32_t mOptions {0};
+  ProcessMode mMode {THROUGHPUT};
+
+  // Input and output buffers, which stay in place when IRs are swapped
+  vector<vector<float>> mInputs;
+  vector<vector<float>> mOutputs;
 
   Convproc *m_Convproc;
+
+  // IR swapping. The swap thread prepares mPrepared, processBuffer() takes
+  // it and fades out the old engine, then hands that to mRetired to be
+  // destroyed by the swap thread.
+  std::thread mSwapThread;
+  std::mutex mSwapLock;
+  std::condition_variable mSwapCondVar;
+  bool mSwapThreadRunning {false};
+  vector<vector<float>> mSwapIRs;  // Copy of IRs being prepared
+  uint32_t mSwapIRlength {0};
+  std::atomic<bool> mSwapping {false};
+  std::atomic<Convproc *> mPrepared {nullptr};
+  std::atomic<Convproc *> mRetired {nullptr};
+  Convproc *mFadeOut {nullptr};
+  int64_t mFadePosition {0}; // Negative while warming up
+  int64_t mWarmUpFrames {0};
+  vector<float> mFadeIn;   // Gains of the new engine, one per frame of the crossfade
+  vector<float> mFadeOutGains;
 };
 
 }
@@ -48,6 +48,8 @@
 #ifndef INC_AL_DECORRELATION_HPP
 #define INC_AL_DECORRELATION_HPP
 
+#include <string>
+
 #include <al/core/io/al_AudioIO.hpp>
 #include "al_Convolver.hpp"
 
@@ -68,6 +70,10 @@ public:
    *
    * This function calculates the IRs using the Kendall method for FIR random phase all-pass filters.
    *
+   * The random phase of each output channel comes from its own stream of a
+   * counter-based generator, so the IRs depend only on the seed and the
+   * parameters, not on the platform or on the order channels are computed.
+   *
    * @param io The AudioIO object for audio rendering
    * @param seed The seed for the random number generator used to calculate random phase. A value of -1 means seed to current time.
    * @param maxjump The maximum difference allowed (in radians) in the random phase between adjacent bins. A value of -1 means no limit.
@@ -137,11 +143,35 @@ public:
    */
   uint32_t getSize();
 
+  /**
+   * @brief Set the number of threads used to generate IRs
+   * @param numThreads Number of threads. 0 (the default) uses one per hardware thread.
+   */
+  void setNumThreads(unsigned int numThreads) { mNumThreads = numThreads; }
+
+  /**
+   * @brief Set a directory where generated IR banks are cached
+   *
+   * When set, IRs generated with a fixed seed are written to this directory
+   * and loaded from it the next time the same seed, parameters, IR length and
+   * number of outputs are configured. The directory must exist. An empty
+   * path (the default) disables the cache.
+   */
+  void setCacheDirectory(std::string path) { mCacheDirectory = path; }
+
+  /**
+   * @brief Returns true if the current IRs were loaded from the cache directory
+   */
+  bool irsFromCache() { return mIRsFromCache; }
+
   //	void processAudio(float *inputBuffer, float* outputBuffer, int index, int numSamples);
 
 private:
 
   void freeIRs();
+  void allocateIRs();
+  bool readCache(const std::string &path, const void *key, size_t keySize);
+  void writeCache(const std::string &path, const void *key, size_t keySize);
   void generateIRs(long seed = -1, float maxjump = -1.0, float phaseFactor = 1.0);
   void generateDeterministicIRs(long seed = -1,
                                 float deltaFreq = 30, float maxFreqDev = 10, float maxTau = 1.0,
@@ -154,6 +184,9 @@ private:
   std::map<uint32_t, vector<uint32_t>> mRoutingMap;
   Convolver mConv;
   long mSeed;
+  unsigned int mNumThreads {0};
+  std::string mCacheDirectory;
+  bool mIRsFromCache {false};
 };
 
 } // al::
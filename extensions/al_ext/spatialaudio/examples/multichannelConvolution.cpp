@@ -43,6 +43,8 @@ public:
     }
 
     // Setup convolver. Map input 0 to 0, 1
+    // The audio callback must not wait for the convolution threads
+    conv.processMode(Convolver::LOW_LATENCY);
     conv.configure(audioIO().framesPerBuffer(), IRchannels, numFrames, {{0, {0, 1}}});
   }
 
@@ -2,7 +2,8 @@
 #include <algorithm>
 #include <cstring>
 #include <cassert>
-#include <algorithm>
+#include <chrono>
+#include <cmath>
 
 
 //#include "zita-convolver-4.0.0/libs/zita-convolver.h"
@@ -14,6 +15,10 @@
 
 #include "al_ext/spatialaudio/al_Convolver.hpp"
 
+#ifndef M_PI
+#define M_PI		3.14159265358979323846
+#endif
+
 using namespace al;
 
 Convolver::Convolver() :
@@ -21,12 +26,18 @@ Convolver::Convolver() :
 {
 }
 
+Convolver::~Convolver()
+{
+  shutdown();
+}
+
 bool Convolver::configure(unsigned int ioBufferSize,
                           vector<float *> IRs, uint32_t IRlength,
                           map<uint32_t, vector<uint32_t>> channelRoutingMap,
                           uint32_t basePartitionSize, float density,
                           uint32_t options)
 {
+  shutdown();
   mNumInputs = channelRoutingMap.size();
   mBufferSize = ioBufferSize;
   mIRs = IRs;
@@ -37,8 +48,12 @@ bool Convolver::configure(unsigned int ioBufferSize,
     return false;
   }
   for (auto mapEntry: mChannelMap) {
+    if (mapEntry.first >= mNumInputs) {
+      std::cerr << "ERROR Convolver: invalid input index " << mapEntry.first << std::endl;
+      return false;
+    }
     for (auto outputIndex: mapEntry.second) {
-      if (outputIndex >= IRlength) {
+      if (outputIndex >= mIRs.size()) {
         std::cerr << "ERROR Convolver: invalid IR index " << outputIndex << std::endl;
         return false;
       }
@@ -48,64 +63,234 @@ bool Convolver::configure(unsigned int ioBufferSize,
     basePartitionSize = ioBufferSize;
     std::cout << "setting base partition size to ioBufferSize" <<std::endl;
   }
+  mBasePartitionSize = basePartitionSize;
+  mDensity = density;
+  mOptions = options;
 
-  if(m_Convproc != nullptr) {
-    delete m_Convproc;
+  m_Convproc = createConvproc(IRs, IRlength);
+  if (!m_Convproc) {
+    return false;
   }
-  m_Convproc = new Convproc;
-  m_Convproc->set_options(options);
+  mInputs.assign(mNumInputs, vector<float>(mBufferSize, 0.0f));
+  mOutputs.assign(mIRs.size(), vector<float>(mBufferSize, 0.0f));
+  return true;
+}
+
+Convproc *Convolver::createConvproc(vector<float *> &IRs, uint32_t IRlength)
+{
+  Convproc *convproc = new Convproc;
+  // Otherwise zita stops processing after a few late blocks in LOW_LATENCY
+  // mode. Blocks are never late in THROUGHPUT mode.
+  convproc->set_options(mOptions | Convproc::OPT_LATE_CONTIN);
 
-  int configResult = m_Convproc->configure(channelRoutingMap.size(), mIRs.size(),
-                                           mIRlength, mBufferSize,
-                                           basePartitionSize, (mIRlength/2 < Convproc::MAXPART)?mIRlength:Convproc::MAXPART,
-                                           density);
+  int configResult = convproc->configure(mNumInputs, IRs.size(),
+                                         IRlength, mBufferSize,
+                                         mBasePartitionSize, (IRlength/2 < Convproc::MAXPART)?IRlength:Convproc::MAXPART,
+                                         mDensity);
   if(configResult != 0){
     std::cerr << "ERROR convolution config failed" << std::endl;
-    m_Convproc->cleanup();
-    return false;
+    destroyConvproc(convproc);
+    return nullptr;
   }
   for (auto &routing: mChannelMap) {
     for (auto outputIndex: routing.second) {
-      if (m_Convproc->impdata_create(routing.first, outputIndex, 1, IRs[outputIndex], 0, IRlength) != 0) {
+      if (convproc->impdata_create(routing.first, outputIndex, 1, IRs[outputIndex], 0, IRlength) != 0) {
         std::cerr << "ERROR setting convolution engine routing" << std::endl;
-        m_Convproc->cleanup();
-        return false;
+        destroyConvproc(convproc);
+        return nullptr;
       }
     }
   }
-  if (m_Convproc->start_process(0, 0) != 0) {
-    m_Convproc->cleanup();
+  if (convproc->start_process(0, 0) != 0) {
     std::cerr << "ERROR starting convolution engine" << std::endl;
-    return false;
+    destroyConvproc(convproc);
+    return nullptr;
   }
-  return true;
+  return convproc;
+}
+
+void Convolver::destroyConvproc(Convproc *convproc)
+{
+  if (!convproc) {
+    return;
+  }
+  if (convproc->state() == Convproc::ST_PROC && convproc->stop_process() != 0) {
+    cerr << "Warning: could not stop process" << endl;
+  }
+  // cleanup() waits for the convolution threads to finish
+  if (convproc->cleanup() != 0) {
+    cerr << "Warning: cleanup failed" << endl;
+  }
+  delete convproc;
 }
 
 float *Convolver::getInputBuffer(unsigned int index) {
-  return m_Convproc->inpdata(index);
+  return index < mInputs.size() ? mInputs[index].data() : nullptr;
 }
 
 float *Convolver::getOutputBuffer(unsigned int index)
 {
-  return m_Convproc->outdata(index);
+  return index < mOutputs.size() ? mOutputs[index].data() : nullptr;
 }
 
 bool Convolver::processBuffer()
 {
-  //process
-  // TODO to sync or not to sync...
-  return m_Convproc->process(true) == 0;
+  if (!m_Convproc) {
+    return false;
+  }
+  // Only one swap is in progress at a time, so the engine faded out last
+  // has been retired by the time another one is prepared
+  if (!mFadeOut && mPrepared.load()) {
+    mFadeOut = m_Convproc;
+    m_Convproc = mPrepared.exchange(nullptr);
+    mFadePosition = -mWarmUpFrames;
+  }
+
+  // Zita moves its buffers every block, so they are copied to and from ours
+  size_t bytes = mBufferSize * sizeof(float);
+  for (size_t i = 0; i < mInputs.size(); i++) {
+    memcpy(m_Convproc->inpdata(i), mInputs[i].data(), bytes);
+    if (mFadeOut) {
+      memcpy(mFadeOut->inpdata(i), mInputs[i].data(), bytes);
+    }
+  }
+  bool sync = mMode == THROUGHPUT;
+  int result = m_Convproc->process(sync);
+  if (!mFadeOut) {
+    for (size_t o = 0; o < mOutputs.size(); o++) {
+      memcpy(mOutputs[o].data(), m_Convproc->outdata(o), bytes);
+    }
+    return result == 0;
+  }
+
+  result |= mFadeOut->process(sync);
+  for (size_t o = 0; o < mOutputs.size(); o++) {
+    float *out = mOutputs[o].data();
+    const float *newOut = m_Convproc->outdata(o);
+    const float *oldOut = mFadeOut->outdata(o);
+    for (unsigned int i = 0; i < mBufferSize; i++) {
+      int64_t pos = mFadePosition + i;
+      if (pos < 0) {
+        out[i] = oldOut[i];
+      } else if (pos < int64_t(mFadeIn.size())) {
+        out[i] = newOut[i] * mFadeIn[pos] + oldOut[i] * mFadeOutGains[pos];
+      } else {
+        out[i] = newOut[i];
+      }
+    }
+  }
+  mFadePosition += mBufferSize;
+  if (mFadePosition >= int64_t(mFadeIn.size())) {
+    // Stopping and deleting the engine waits for its threads
+    mRetired.store(mFadeOut);
+    mFadeOut = nullptr;
+  }
+  return result == 0;
 }
 
-bool Convolver::shutdown(void){
-  if(m_Convproc->stop_process() != 0){
-    cerr << "Warning: could not stop process" << endl;
+bool Convolver::swapIRs(vector<float *> IRs, uint32_t IRlength, uint32_t fadeBlocks,
+                        bool warmUp)
+{
+  if (!m_Convproc) {
+    std::cerr << "ERROR Convolver not configured in " << __FUNCTION__ << std::endl;
     return false;
   }
-  if(m_Convproc->cleanup() != 0){
-    cerr << "Warning: cleanup failed" << endl;
+  if (IRs.size() != mIRs.size()) {
+    std::cerr << "ERROR Convolver: expected " << mIRs.size() << " IRs in "
+              << __FUNCTION__ << std::endl;
+    return false;
+  }
+  if (mSwapping.exchange(true)) {
+    std::cerr << "ERROR Convolver: IR swap already in progress" << std::endl;
     return false;
   }
+  std::unique_lock<std::mutex> lk(mSwapLock);
+  mSwapIRs.clear();
+  for (auto ir: IRs) {
+    mSwapIRs.emplace_back(ir, ir + IRlength);
+  }
+  mSwapIRlength = IRlength;
+
+  // Not used by processBuffer() until the new engine is ready
+  size_t fadeFrames = size_t(fadeBlocks) * mBufferSize;
+  mFadeIn.resize(fadeFrames);
+  mFadeOutGains.resize(fadeFrames);
+  for (size_t i = 0; i < fadeFrames; i++) {
+    double phase = M_PI * 0.5 * (i + 0.5) / fadeFrames;
+    mFadeIn[i] = float(std::sin(phase));
+    mFadeOutGains[i] = float(std::cos(phase));
+  }
+  mWarmUpFrames = warmUp ? int64_t(IRlength) : 0;
+
+  if (!mSwapThreadRunning) {
+    mSwapThreadRunning = true;
+    mSwapThread = std::thread(&Convolver::swapFunction, this);
+  }
+  lk.unlock();
+  mSwapCondVar.notify_one();
   return true;
 }
 
+void Convolver::swapFunction()
+{
+  std::unique_lock<std::mutex> lk(mSwapLock);
+  while (mSwapThreadRunning) {
+    if (mSwapIRs.size() > 0) {
+      vector<vector<float>> irData;
+      irData.swap(mSwapIRs);
+      uint32_t IRlength = mSwapIRlength;
+      lk.unlock();
+      vector<float *> IRs;
+      for (auto &ir: irData) {
+        IRs.push_back(ir.data());
+      }
+      Convproc *convproc = createConvproc(IRs, IRlength);
+      if (convproc) {
+        mPrepared.store(convproc);
+      } else {
+        mSwapping = false;
+      }
+      lk.lock();
+      continue;
+    }
+    Convproc *retired = mRetired.exchange(nullptr);
+    if (retired) {
+      lk.unlock();
+      destroyConvproc(retired);
+      mSwapping = false;
+      lk.lock();
+      continue;
+    }
+    // processBuffer() doesn't signal, so poll for the retired engine
+    mSwapCondVar.wait_for(lk, std::chrono::milliseconds(10));
+  }
+}
+
+void Convolver::stopSwapThread()
+{
+  {
+    std::lock_guard<std::mutex> lk(mSwapLock);
+    if (!mSwapThreadRunning) {
+      return;
+    }
+    mSwapThreadRunning = false;
+  }
+  mSwapCondVar.notify_one();
+  mSwapThread.join();
+}
+
+bool Convolver::shutdown(void){
+  stopSwapThread();
+  bool wasConfigured = m_Convproc != nullptr;
+  destroyConvproc(mPrepared.exchange(nullptr));
+  destroyConvproc(mRetired.exchange(nullptr));
+  destroyConvproc(mFadeOut);
+  destroyConvproc(m_Convproc);
+  mFadeOut = nullptr;
+  m_Convproc = nullptr;
+  mSwapIRs.clear();
+  mSwapping = false;
+  mInputs.clear();
+  mOutputs.clear();
+  return wasConfigured;
+}
@@ -50,10 +50,17 @@
 #include <iostream>
 #include <cmath>
 #include <cstring>
+#include <cstdio>
+#include <cstdint>
 #include <cassert>
+#include <atomic>
+#include <functional>
+#include <thread>
 
 #include <Gamma/FFT.h>
 
+#include "al/core/io/al_File.hpp"
+#include "al/core/math/al_Random.hpp"
 #include "al_ext/spatialaudio/al_Decorrelation.hpp"
 
 using namespace al;
@@ -63,6 +70,100 @@ using namespace std;
 #define M_PI		3.14159265358979323846
 #endif
 
+namespace {
+
+// Identifies a bank of IRs in the cache. Stored at the start of cache files.
+struct IRBankKey {
+  char magic[4];
+  uint32_t version;
+  uint32_t method; // 0: random phase, 1: deterministic
+  uint32_t length;
+  uint32_t numOuts;
+  uint32_t reserved;
+  int64_t seed;
+  float params[5];
+};
+
+IRBankKey makeKey(uint32_t method, uint32_t length, uint32_t numOuts, long seed,
+                  std::initializer_list<float> params)
+{
+  IRBankKey key;
+  memset(&key, 0, sizeof(key)); // Padding is hashed and compared too
+  memcpy(key.magic, "ALDC", 4);
+  key.version = 1;
+  key.method = method;
+  key.length = length;
+  key.numOuts = numOuts;
+  key.seed = seed;
+  int i = 0;
+  for (float p: params) {
+    key.params[i++] = p;
+  }
+  return key;
+}
+
+std::string cachePath(const std::string &directory, const IRBankKey &key)
+{
+  if (directory.empty() || key.seed < 0) {
+    return std::string();
+  }
+  // FNV-1a hash of the key
+  uint64_t hash = 14695981039346656037ULL;
+  const unsigned char *bytes = (const unsigned char *) &key;
+  for (size_t i = 0; i < sizeof(key); i++) {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  char name[64];
+  snprintf(name, sizeof(name), "decorrelation_%016llx.bin", (unsigned long long) hash);
+  return File::conformDirectory(directory) + name;
+}
+
+// Computes the IR of each output from a spectrum filled in by fillSpectrum.
+// Outputs are split between threads, each reusing one FFT plan and buffer.
+void inverseFFTs(vector<float *> &irs, uint32_t length, unsigned int numThreads,
+                 const std::function<void(int, float *)> &fillSpectrum)
+{
+  std::atomic<int> nextIR(0);
+  auto worker = [&]() {
+    gam::RFFT<float> fftObj(length);
+    vector<float> complexSpectrum(length + 2);
+    int irIndex;
+    while ((irIndex = nextIR++) < (int) irs.size()) {
+      std::fill(complexSpectrum.begin(), complexSpectrum.end(), 0.0f);
+      fillSpectrum(irIndex, complexSpectrum.data());
+      fftObj.inverse(complexSpectrum.data(), true);
+      float *irdata = irs[irIndex];
+      for (uint32_t i = 1; i <= length; i++) {
+        irdata[i - 1] = complexSpectrum[i]/length;
+      }
+    }
+  };
+
+  if (numThreads == 0) {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  numThreads = std::max(1u, std::min(numThreads, (unsigned int) irs.size()));
+  vector<std::thread> threads;
+  for (unsigned int i = 1; i < numThreads; i++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto &t: threads) {
+    t.join();
+  }
+}
+
+// Random generator for the IR of one output, independent of other outputs
+rnd::Random<rnd::Philox> channelRandom(long seed, int irIndex)
+{
+  rnd::Random<rnd::Philox> rng(0);
+  rng.rng().seed(uint64_t(seed));
+  rng.rng().stream(irIndex);
+  return rng;
+}
+
+} // namespace
+
 Decorrelation::Decorrelation(uint32_t size) :
   mIRlength(size)
 {
@@ -80,13 +181,10 @@ long al::Decorrelation::getCurrentSeed()
 
 void Decorrelation::generateIRs(long seed, float maxjump, float phaseFactor)
 {
-  float *ampSpectrum = (float *) calloc(mIRlength, sizeof(float));
-  float *phsSpectrum = (float *) calloc(mIRlength, sizeof(float));
-  float *complexSpectrum = (float *) calloc(mIRlength * 2, sizeof(float));;
   //	#    max_jump -  is the maximum phase difference (in radians) between bins
   //	#             if -1, the random numbers are used directly (no jumping).
 
-  freeIRs();
+  allocateIRs();
 
   int n = mIRlength/2; // before mirroring
 
@@ -96,63 +194,51 @@ void Decorrelation::generateIRs(long seed, float maxjump, float phaseFactor)
   } else {
     mSeed = time(0);
   }
-  srand(mSeed);
-  for (int irIndex = 0; irIndex < mNumOuts; irIndex++) {
+
+  IRBankKey key = makeKey(0, mIRlength, mNumOuts, seed >= 0 ? mSeed : -1,
+                          {maxjump, phaseFactor});
+  std::string path = cachePath(mCacheDirectory, key);
+  mIRsFromCache = !path.empty() && readCache(path, &key, sizeof(key));
+  if (mIRsFromCache) {
+    return;
+  }
+
+  inverseFFTs(mIRs, mIRlength, mNumThreads, [&](int irIndex, float *complexSpectrum) {
+    rnd::Random<rnd::Philox> rng = channelRandom(mSeed, irIndex);
+
     // Fill in DC and Nyquist
-    ampSpectrum[0] = 1.0;
-    phsSpectrum[0] = 0.0;
-    complexSpectrum[0] = ampSpectrum[0] * cos(phsSpectrum[0]);
-    complexSpectrum[1] = ampSpectrum[0] * sin(phsSpectrum[0]);
-    complexSpectrum[(n*2)] = ampSpectrum[0] * cos(phsSpectrum[0]);
-    complexSpectrum[(n*2) + 1] = ampSpectrum[0] * sin(phsSpectrum[0]);
+    complexSpectrum[0] = 1.0;
+    complexSpectrum[1] = 0.0;
+    complexSpectrum[(n*2)] = 1.0;
+    complexSpectrum[(n*2) + 1] = 0.0;
 
     float old_phase = 0;
     for (int i=1; i < n; i++) {
-      ampSpectrum[i] = 1.0;
+      float phase;
       if (maxjump == -1.0) {
-        phsSpectrum[i] = ((rand() / (float) RAND_MAX) * M_PI)- (M_PI/2.0);
+        phase = (rng.uniform() * M_PI) - (M_PI/2.0);
       } else {
         // make phase only move +- limit
-        float delta = ((rand() / ((float) RAND_MAX)) * 2.0 * maxjump) - maxjump;
-        //				std::cout << "delta " << delta << std::endl;
+        float delta = rng.uniformS() * maxjump;
         float new_phase = old_phase + delta;
-        phsSpectrum[i] = new_phase * phaseFactor;
+        phase = new_phase * phaseFactor;
         old_phase = new_phase;
       }
 
-      complexSpectrum[i*2] = ampSpectrum[i] * cos(phsSpectrum[i]); // Real part
-      complexSpectrum[i*2 + 1] = ampSpectrum[i] * sin(phsSpectrum[i]); // Imaginary
-      //			std::cout << complexSpectrum[i*2] << ", " << complexSpectrum[i*2 + 1] << ",";
+      complexSpectrum[i*2] = cos(phase); // Real part
+      complexSpectrum[i*2 + 1] = sin(phase); // Imaginary
     }
+  });
 
-    //		std::cout << ".... " <<std::endl;
-    gam::RFFT<float> fftObj(mIRlength);
-
-    fftObj.inverse(complexSpectrum, true);
-    float *irdata = (float *) calloc(mIRlength, sizeof(float));
-
-    for (int i=1; i <= mIRlength; i++) {
-      irdata[i - 1] = complexSpectrum[i]/mIRlength;
-      //			std::cout << complexSpectrum[i]/mSize << "," << std::endl;
-    }
-    mIRs.push_back(irdata);
+  if (!path.empty()) {
+    writeCache(path, &key, sizeof(key));
   }
-
-  free(ampSpectrum);
-  free(phsSpectrum);
-  free(complexSpectrum);
 }
 
 void Decorrelation::generateDeterministicIRs(long seed, float deltaFreq, float maxFreqDev,
                                              float maxTau, float startPhase, float phaseDev)
 {
-  float *ampSpectrum = (float *) calloc(mIRlength, sizeof(float));
-  float *phsSpectrum = (float *) calloc(mIRlength, sizeof(float));
-  float *complexSpectrum = (float *) calloc(mIRlength * 2, sizeof(float));;
-  //	#    max_jump -  is the maximum phase difference (in radians) between bins
-  //	#             if -1, the random numbers are used directly (no jumping).
-
-  freeIRs();
+  allocateIRs();
 
   int n = mIRlength/2; // before mirroring
 
@@ -162,36 +248,67 @@ void Decorrelation::generateDeterministicIRs(long seed, float deltaFreq, float m
   } else {
     mSeed = time(0);
   }
-  srand(mSeed);
 
-  for (int irIndex = 0; irIndex < mNumOuts; irIndex++) {
-    float freq = deltaFreq + ((2.0 * maxFreqDev * rand() / (float) RAND_MAX) - maxFreqDev);
-    std::cout << "freq " << irIndex << ":" << freq << std::endl;
+  IRBankKey key = makeKey(1, mIRlength, mNumOuts, seed >= 0 ? mSeed : -1,
+                          {deltaFreq, maxFreqDev, maxTau, startPhase, phaseDev});
+  std::string path = cachePath(mCacheDirectory, key);
+  mIRsFromCache = !path.empty() && readCache(path, &key, sizeof(key));
+  if (mIRsFromCache) {
+    return;
+  }
+
+  inverseFFTs(mIRs, mIRlength, mNumThreads, [&](int irIndex, float *complexSpectrum) {
+    rnd::Random<rnd::Philox> rng = channelRandom(mSeed, irIndex);
+
+    float freq = deltaFreq + rng.uniformS() * maxFreqDev;
     for (int i=0; i < n + 1; i++) {
-      ampSpectrum[i] = 1.0;
-      float phaseOffset = startPhase + ((2.0 * phaseDev * rand() / (float) RAND_MAX) - phaseDev);
-      phsSpectrum[i] = maxTau * sin(phaseOffset + (2 * M_PI * i * freq / n));
+      float phaseOffset = startPhase + rng.uniformS() * phaseDev;
+      float phase = maxTau * sin(phaseOffset + (2 * M_PI * i * freq / n));
 
-      complexSpectrum[i*2] = ampSpectrum[i] * cos(phsSpectrum[i]); // Real part
-      complexSpectrum[i*2 + 1] = ampSpectrum[i] * sin(phsSpectrum[i]); // Imaginary
-      //			std::cout << complexSpectrum[i*2] << ", " << complexSpectrum[i*2 + 1] << ",";
+      complexSpectrum[i*2] = cos(phase); // Real part
+      complexSpectrum[i*2 + 1] = sin(phase); // Imaginary
     }
+  });
 
-    //		std::cout << ".... " <<std::endl;
-    gam::RFFT<float> fftObj(mIRlength);
+  if (!path.empty()) {
+    writeCache(path, &key, sizeof(key));
+  }
+}
 
-    fftObj.inverse(complexSpectrum, true);
-    float *irdata = (float *) calloc(mIRlength, sizeof(float));
+bool Decorrelation::readCache(const string &path, const void *key, size_t keySize)
+{
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+  vector<char> fileKey(keySize);
+  bool ok = fread(fileKey.data(), 1, keySize, file) == keySize
+      && memcmp(fileKey.data(), key, keySize) == 0;
+  for (unsigned int i = 0; ok && i < mIRs.size(); i++) {
+    ok = fread(mIRs[i], sizeof(float), mIRlength, file) == mIRlength;
+  }
+  fclose(file);
+  return ok;
+}
 
-    for (int i=1; i <= mIRlength; i++) {
-      irdata[i - 1] = complexSpectrum[i]/mIRlength;
-      //			std::cout << complexSpectrum[i]/mSize << "," << std::endl;
-    }
-    mIRs.push_back(irdata);
+void Decorrelation::writeCache(const string &path, const void *key, size_t keySize)
+{
+  // Write to a temporary file first, so a partial file is never read
+  std::string tmpPath = path + ".tmp";
+  FILE *file = fopen(tmpPath.c_str(), "wb");
+  if (!file) {
+    std::cerr << "ERROR: Decorrelation could not write IR cache to " << path << std::endl;
+    return;
+  }
+  bool ok = fwrite(key, 1, keySize, file) == keySize;
+  for (unsigned int i = 0; ok && i < mIRs.size(); i++) {
+    ok = fwrite(mIRs[i], sizeof(float), mIRlength, file) == mIRlength;
+  }
+  ok = (fclose(file) == 0) && ok;
+  if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+    std::cerr << "ERROR: Decorrelation could not write IR cache to " << path << std::endl;
+    remove(tmpPath.c_str());
   }
-  free(ampSpectrum);
-  free(phsSpectrum);
-  free(complexSpectrum);
 }
 
 //void Decorrelation::onAudioCB(al::AudioIOData &io)
@@ -232,6 +349,14 @@ uint32_t al::Decorrelation::getSize()
   return mIRlength;
 }
 
+void al::Decorrelation::allocateIRs()
+{
+  freeIRs();
+  for (unsigned int i = 0; i < mNumOuts; i++) {
+    mIRs.push_back((float *) calloc(mIRlength, sizeof(float)));
+  }
+}
+
 void al::Decorrelation::freeIRs()
 {
   for (unsigned int i = 0; i < mIRs.size(); i++){
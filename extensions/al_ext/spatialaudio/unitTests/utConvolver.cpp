@@ -5,6 +5,8 @@
 #include <iostream>
 #include <algorithm>
 #include <cstring>
+#include <chrono>
+#include <thread>
 
 #include "al/core/io/al_AudioIO.hpp"
 
@@ -121,6 +123,78 @@ TEST_CASE( "One to many", "[convolver]" ) {
   conv.shutdown();
 }
 
+TEST_CASE( "Swap IRs", "[convolver]" ) {
+  al::Convolver conv;
+  REQUIRE(conv.processMode() == al::Convolver::THROUGHPUT);
+
+  // A passes the input through, B delays and inverts it so that switching
+  // without a crossfade jumps by up to 0.9
+  const uint32_t lengthA = 256, lengthB = 512;
+  vector<float> IRA(lengthA, 0.0f), IRB(lengthB, 0.0f);
+  IRA[0] = 1.0f;
+  IRB[5] = -0.8f;
+  REQUIRE(conv.configure(BLOCK_SIZE, {IRA.data()}, lengthA, {{0,{0}}}));
+
+  auto input = [](int n) { return n < 0 ? 0.0f : 0.5f * float(sin(2 * M_PI * 440 * n / 44100.0)); };
+  vector<float> output;
+  int swapFrame = 20 * BLOCK_SIZE;
+  int swappedFrame = -1;
+  int maxBlocks = 20000;
+  for (int b = 0; b < maxBlocks; b++) {
+    if (b * BLOCK_SIZE == swapFrame) {
+      REQUIRE(conv.swapIRs({IRB.data()}, lengthB, 8));
+      REQUIRE(conv.swapping());
+      // One swap at a time, with matching IR count
+      REQUIRE(!conv.swapIRs({IRA.data()}, lengthA));
+    }
+    float *in = conv.getInputBuffer(0);
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+      in[i] = input(b * BLOCK_SIZE + i);
+    }
+    REQUIRE(conv.processBuffer());
+    float *out = conv.getOutputBuffer(0);
+    output.insert(output.end(), out, out + BLOCK_SIZE);
+    if (b * BLOCK_SIZE > swapFrame) {
+      if (swappedFrame < 0 && !conv.swapping()) {
+        swappedFrame = (b + 1) * BLOCK_SIZE;
+      }
+      if (swappedFrame >= 0 && b * BLOCK_SIZE > swappedFrame + 4 * BLOCK_SIZE) {
+        break;
+      }
+      // Preparation takes time in real time
+      this_thread::sleep_for(chrono::microseconds(100));
+    }
+  }
+  REQUIRE(swappedFrame > swapFrame);
+  REQUIRE(!conv.swapIRs({IRA.data(), IRB.data()}, lengthA));
+
+  // Only A before the swap was made, and only B once it has ended
+  bool matchA = true, matchB = true;
+  for (int n = 0; n < swapFrame; n++) {
+    matchA &= fabs(output[n] - input(n)) < 1e-5;
+  }
+  for (int n = swappedFrame; n < int(output.size()); n++) {
+    matchB &= fabs(output[n] + 0.8f * input(n - 5)) < 1e-5;
+  }
+  REQUIRE(matchA);
+  REQUIRE(matchB);
+
+  // No discontinuities: steps are no larger than those of the sine itself,
+  // 0.5 * 2 * pi * 440 / 44100 = 0.031, plus the change in crossfade gains
+  float maxStep = 0;
+  for (size_t n = 1; n < output.size(); n++) {
+    maxStep = max(maxStep, fabs(output[n] - output[n - 1]));
+  }
+  REQUIRE(maxStep < 0.05f);
+
+  // Input and output buffers don't move
+  float *in = conv.getInputBuffer(0);
+  conv.processBuffer();
+  REQUIRE(conv.getInputBuffer(0) == in);
+  conv.shutdown();
+  REQUIRE(!conv.processBuffer());
+}
+
 //TEST_CASE( "Vector mode", "[convolver]" ) {
 //  al::Convolver conv;
 //  al::AudioIO io(BLOCK_SIZE, 44100.0, NULL, NULL, 2, 2, al::AudioIO::DUMMY);
@@ -6,6 +6,7 @@
 #include <iostream>
 #include <cmath>
 
+#include "al/core/io/al_File.hpp"
 #include "al/core/system/al_Time.hpp"
 
 #include "al_ext/spatialaudio/al_Decorrelation.hpp"
@@ -207,6 +208,72 @@ TEST_CASE( "Parallel", "[decorrelation]" ) {
 //}
 
 
+TEST_CASE( "Threaded IR generation", "[decorrelation]" ) {
+  std::map<uint32_t, std::vector<uint32_t>> routing = {{0, {0, 1, 2, 3, 4, 5, 6, 7}},
+                                                       {1, {8, 9, 10, 11, 12, 13, 14, 15}}};
+  al::Decorrelation serial(512);
+  serial.setNumThreads(1);
+  serial.configure(256, routing, true, 77, 0.5);
+  al::Decorrelation threaded(512);
+  threaded.setNumThreads(6);
+  threaded.configure(256, routing, true, 77, 0.5);
+  for (int i = 0; i < 16; i++) {
+    REQUIRE(memcmp(serial.getIR(i), threaded.getIR(i), 512 * sizeof(float)) == 0);
+  }
+
+  // Each output has its own random stream, so IRs don't depend on the number of outputs
+  al::Decorrelation fewer(512);
+  fewer.configure(256, {{0, {0, 1, 2}}}, true, 77, 0.5);
+  for (int i = 0; i < 3; i++) {
+    REQUIRE(memcmp(serial.getIR(i), fewer.getIR(i), 512 * sizeof(float)) == 0);
+  }
+
+  serial.configureDeterministic(256, routing, true, 77, 20, 10, 1.0, 0.0, 0.5);
+  threaded.configureDeterministic(256, routing, true, 77, 20, 10, 1.0, 0.0, 0.5);
+  for (int i = 0; i < 16; i++) {
+    REQUIRE(memcmp(serial.getIR(i), threaded.getIR(i), 512 * sizeof(float)) == 0);
+  }
+}
+
+
+TEST_CASE( "IR cache", "[decorrelation]" ) {
+  std::string cacheDir = "decorrelation_cache_test";
+  al::Dir::removeRecursively(cacheDir);
+  REQUIRE(al::Dir::make(cacheDir));
+
+  al::Decorrelation uncached(256);
+  uncached.configure(256, {{0, {0, 1, 2, 3}}}, true, 5);
+
+  al::Decorrelation dec(256);
+  dec.setCacheDirectory(cacheDir);
+  dec.configure(256, {{0, {0, 1, 2, 3}}}, true, 5);
+  REQUIRE(!dec.irsFromCache());
+  dec.configure(256, {{0, {0, 1, 2, 3}}}, true, 5);
+  REQUIRE(dec.irsFromCache());
+  for (int i = 0; i < 4; i++) {
+    REQUIRE(memcmp(uncached.getIR(i), dec.getIR(i), 256 * sizeof(float)) == 0);
+  }
+
+  // Any change in seed, parameters or number of outputs generates new IRs
+  dec.configure(256, {{0, {0, 1, 2, 3}}}, true, 6);
+  REQUIRE(!dec.irsFromCache());
+  dec.configure(256, {{0, {0, 1, 2, 3}}}, true, 5, 0.5);
+  REQUIRE(!dec.irsFromCache());
+  dec.configure(256, {{0, {0, 1, 2}}}, true, 5);
+  REQUIRE(!dec.irsFromCache());
+  dec.configureDeterministic(256, {{0, {0, 1, 2, 3}}}, true, 5);
+  REQUIRE(!dec.irsFromCache());
+  dec.configureDeterministic(256, {{0, {0, 1, 2, 3}}}, true, 5);
+  REQUIRE(dec.irsFromCache());
+
+  // Time based seeds are not cached
+  dec.configure(256, {{0, {0, 1, 2, 3}}}, true, -1);
+  REQUIRE(!dec.irsFromCache());
+
+  al::Dir::removeRecursively(cacheDir);
+}
+
+
 TEST_CASE( "Deterministic IR", "[decorrelation]" ) {
 	int bufferSize = 32;
 	al::Decorrelation dec(32);
@@ -98,12 +98,19 @@ inline void App::start() {
   while (!WindowApp::shouldQuit()) {
     // to quit, call WindowApp::quit() or click close button of window,
     // or press ctrl + q
+    FrameProfiler& prof = FPS::profiler();
+    prof.begin("animate");
     preOnAnimate(dt_sec());
     onAnimate(dt_sec());
+    prof.end();
+    prof.begin("draw");
     preOnDraw();
     onDraw(mGraphics);
     postOnDraw();
+    prof.end();
+    prof.begin("swap");
     Window::refresh();
+    prof.end();
     FPS::tickFPS();
   }
 
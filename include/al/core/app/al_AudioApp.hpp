@@ -4,6 +4,8 @@
 /*  Keehong Youn, 2017, younkeehong@gmail.com
 */
 
+#include <string>
+
 #include "al/core/io/al_AudioIO.hpp"
 
 namespace al {
@@ -42,6 +44,29 @@ public:
   };
   virtual void initAudio(AudioIOConfig config = OUT_ONLY);
 
+  /// Read audio settings from a toml file. Called by initAudio() with
+  /// "audio.toml", if it exists. To render offline instead of using the
+  /// audio device set:
+  ///
+  ///     backend = "offline"
+  ///     offlineSpeed = 0.0      # multiple of real time, 0 is fastest
+  ///     offlineDuration = 10.0  # seconds, 0 renders until stopped
+  ///     offlineOutputFile = "render.wav"
+  ///     offlineInputFile = "input.wav"
+  ///     offlineVerbose = true   # print the render speed when done
+  ///
+  /// Offline rendering has no device to take defaults from.
+  /// initAudio(AudioIOConfig) uses the frames per buffer, frames per second
+  /// and channels already set on audioIO(), which can also be set with:
+  ///
+  ///     framesPerBuffer = 256
+  ///     framesPerSecond = 48000
+  ///     channelsOut = 2
+  ///     channelsIn = 0
+  ///
+  /// @return false if the file could not be read
+  bool loadAudioConfig(const std::string &fileName = "audio.toml");
+
   virtual void onSound(AudioIOData& io) {}
 
   bool usingAudio() const;
@@ -13,6 +13,7 @@
 #include "al/core/graphics/al_GLFW.hpp"
 #include "al/core/io/al_Window.hpp"
 #include "al/core/graphics/al_Graphics.hpp"
+#include "al/core/system/al_SharedMemory.hpp"
 #include "al/core/io/al_ControlNav.hpp"
 #include "al/sphere/al_OmniRenderer.hpp"
 #include "al/util/al_Toml.hpp"
@@ -20,6 +21,7 @@
 #include "al/util/scene/al_DynamicScene.hpp"
 #include "al/util/scene/al_DistributedScene.hpp"
 
+#include <chrono>
 #include <iostream>
 #include <map>
 
@@ -34,6 +36,11 @@
 
 /*
  * MPI and cuttlebone are optional.
+ *
+ * When all nodes run on the same host, state and parameter changes can be
+ * passed through shared memory instead of the network by setting
+ * transport = "shm" in distributed_app.toml. The segment name prefix can be
+ * set with the sharedMemoryName key.
 */
 
 namespace al {
@@ -70,6 +77,7 @@ public:
 
 
   ~DistributedApp() {
+      closeSharedMemory();
 #ifdef AL_USE_CUTTLEBONE
       if (mMaker) {
           mMaker->stop();
@@ -100,6 +108,18 @@ public:
       MPI_Get_processor_name(processor_name, &name_len);
 #endif
       TomlLoader appConfig("distributed_app.toml");
+      auto transport = appConfig.root->get_as<std::string>("transport");
+      if (transport) {
+        mUseSharedMemory = *transport == "shm";
+      } else if (appConfig.root->contains("transport")) {
+        std::cerr << "ERROR: transport must be a string" << std::endl;
+      }
+      auto sharedMemoryName = appConfig.root->get_as<std::string>("sharedMemoryName");
+      if (sharedMemoryName) {
+        mSharedMemoryName = *sharedMemoryName;
+      } else if (appConfig.root->contains("sharedMemoryName")) {
+        std::cerr << "ERROR: sharedMemoryName must be a string" << std::endl;
+      }
       auto nodesTable = appConfig.root->get_table_array("node");
       if (nodesTable) {
         for (const auto& table : *nodesTable)
@@ -176,8 +196,9 @@ public:
           //          mParameterServer->addListener("127.0.0.1", 9100);
           mParameterServer->startHandshakeServer(defaultAddress);
           for (auto member: mRoleMap) {
-            // Relay all parameters to renderers
-            if (member.second & ROLE_RENDERER) {
+            // Relay all parameters to renderers, unless they read them
+            // from shared memory
+            if (member.second & ROLE_RENDERER && !mUseSharedMemory) {
               std::cout << "Added renderer as listener " << member.first << ":" << receiverPort << std::endl;
               mParameterServer->addListener(member.first, receiverPort);
               continue;
@@ -375,6 +396,9 @@ public:
 
   ParameterServer &parameterServer() override { return *mParameterServer; }
 
+  /// True if state and parameters are passed through shared memory
+  bool usingSharedMemory() { return mUseSharedMemory; }
+
 //  static bool shouldRunDistributed() {
 //    TomlLoader appConfig("distributed_app.toml");
 
@@ -403,6 +427,46 @@ public:
   }
 private:
 
+  // Pass parameter changes received in shared memory to the parameter server
+  void receiveSharedMemoryParameters() {
+    if (!mParameterRing.isOpen()) {
+      if (!mParameterRing.open(mSharedMemoryName + "_params")) {
+        return;
+      }
+      mParameterReader = mParameterRing.addReader();
+      mLastParameterCheck = std::chrono::steady_clock::now();
+    }
+    char buffer[1024];
+    size_t size;
+    while (mParameterRing.consume(mParameterReader, buffer, sizeof(buffer), &size)) {
+      mParameterServer->parse(buffer, (int) size);
+    }
+    // Follow the simulator if it has been restarted and created a new segment
+    auto now = std::chrono::steady_clock::now();
+    if (now - mLastParameterCheck > std::chrono::milliseconds(500)) {
+      mLastParameterCheck = now;
+      if (mParameterRing.replaced()) {
+        mParameterRing.close(); // Also removes the reader
+        mParameterReader = -1;
+      }
+    }
+  }
+
+  // Release reader slots and remove segments created by this process
+  void closeSharedMemory() {
+    if (mSharedStateMaker) {
+      mSharedStateMaker->stop();
+    }
+    if (mSharedStateTaker) {
+      mSharedStateTaker->stop();
+    }
+    if (mParameterRing.isOpen() && mParameterRing.isOwner() && mParameterServer) {
+      mParameterServer->removeSharedMemoryListener(&mParameterRing);
+    }
+    mParameterRing.close();
+    mParameterReader = -1;
+  }
+
 #ifdef AL_BUILD_MPI
   // MPI data
   int world_size;
@@ -424,6 +488,13 @@ private:
   std::unique_ptr<cuttlebone::Maker<TSharedState>> mMaker;
   std::unique_ptr<cuttlebone::Taker<TSharedState>> mTaker;
 #endif
+  bool mUseSharedMemory {false};
+  std::string mSharedMemoryName {"allolib_distributed"};
+  std::unique_ptr<SharedStateMaker<TSharedState>> mSharedStateMaker;
+  std::unique_ptr<SharedStateTaker<TSharedState>> mSharedStateTaker;
+  SharedMemoryRing mParameterRing;
+  int mParameterReader {-1};
+  std::chrono::steady_clock::time_point mLastParameterCheck;
   std::shared_ptr<ParameterServer> mParameterServer;
 
   TomlLoader configLoader;
@@ -471,11 +542,17 @@ inline void DistributedApp<TSharedState>::start() {
     if (role() & ROLE_DESKTOP || role() & ROLE_SIMULATOR) {
       simulate(dt_sec());
       mQueuedStates = 1;
+      if (mSharedStateMaker) {
+        mSharedStateMaker->set(mState);
+      }
 #ifdef AL_USE_CUTTLEBONE
       if (mMaker) {
         mMaker->set(mState);
       }
 #endif
+    } else if (mSharedStateTaker) {
+      mQueuedStates = mSharedStateTaker->get(mState);
+      receiveSharedMemoryParameters();
     } else {
 #ifdef AL_USE_CUTTLEBONE
       if (mTaker) {
@@ -525,6 +602,7 @@ inline void DistributedApp<TSharedState>::start() {
 
   onExit(); // user defined
   postOnExit();
+  closeSharedMemory();
   if(hasRole(ROLE_AUDIO) || hasRole(ROLE_DESKTOP) || hasRole(ROLE_DESKTOP_REPLICA)) {
     AudioApp::endAudio(); // AudioApp
   }
@@ -536,8 +614,24 @@ inline void DistributedApp<TSharedState>::start() {
 template<class TSharedState>
 inline void DistributedApp<TSharedState>::preOnCreate() {
   append(mNavControl);
+  if (mUseSharedMemory) {
+    if (role() & ROLE_SIMULATOR) {
+      mSharedStateMaker = std::make_unique<SharedStateMaker<TSharedState>>(mSharedMemoryName + "_state");
+      if (!mSharedStateMaker->start()) {
+        std::cerr << "ERROR: Could not create shared memory for state" << std::endl;
+      }
+      if (mParameterRing.create(mSharedMemoryName + "_params", 1024, 1024)) {
+        mParameterServer->addSharedMemoryListener(&mParameterRing);
+      }
+    } else if (role() & ROLE_RENDERER || role() & ROLE_AUDIO) {
+      mSharedStateTaker = std::make_unique<SharedStateTaker<TSharedState>>(mSharedMemoryName + "_state");
+      mSharedStateTaker->start(); // Will keep trying to attach if simulator is not running
+    }
+  }
 #ifdef AL_USE_CUTTLEBONE
-  if (role() & ROLE_SIMULATOR) {
+  if (mUseSharedMemory) {
+    // State is passed through shared memory
+  } else if (role() & ROLE_SIMULATOR) {
       std::string broadcastAddress = configLoader.gets("broadcastAddress");
       mMaker = std::make_unique<cuttlebone::Maker<TSharedState>>(broadcastAddress.c_str());
       mMaker->start();
@@ -4,6 +4,9 @@
 /*  Keehong Youn, 2017, younkeehong@gmail.com
 */
 
+#include <cstdint>
+#include <functional>
+#include "al/core/app/al_FrameProfiler.hpp"
 #include "al/core/system/al_Time.hpp"
 
 namespace al {
@@ -14,9 +17,24 @@ public:
   al_nsec deltaTime;
   al_nsec start_of_loop = 0;
   double mFPSWanted = 60;
+
+  // Waiting for the next frame sleeps until spinTime before it and then
+  // spins, since sleeping often overshoots by hundreds of microseconds.
+  al_nsec spinTime = 300000;
+
+  // With adaptive pacing, when most frames in a window of adaptWindow frames
+  // are late, the target rate drops to fpsWanted/2, then /3, and so on up to
+  // maxDivisor. It goes back up when a whole window fits the faster rate.
+  bool adaptive = false;
+  int adaptWindow = 60;
+  int maxDivisor = 4;
+
   void fps(double f);
   double fpsWanted();
+  double fpsTarget(); // wanted rate after adaptation
   double fps();
+  void adaptiveFPS(bool v) { adaptive = v; }
+  uint64_t lateFrames() { return mLateFrames; } // since startFPS
   // get time
   double sec();
   double msec(); // millis
@@ -24,8 +42,27 @@ public:
   double dt_sec(); // in seconds
   void startFPS();
   void tickFPS();
+
+  // profiler of frame sections, its frames end at each tickFPS
+  FrameProfiler& profiler() { return mProfiler; }
+
+  // replace the clock and the sleep function, e.g. for testing
+  void timeSource(std::function<al_nsec()> now, std::function<void(al_nsec)> sleep);
+
+private:
+  void waitUntil(al_nsec t);
+  void adapt(al_nsec took);
+
+  FrameProfiler mProfiler;
+  std::function<al_nsec()> mNow {al_steady_time_nsec};
+  std::function<void(al_nsec)> mSleep {al_sleep_nsec};
+  int mDivisor = 1;
+  int mWindowFrames = 0;
+  int mWindowLate = 0;
+  al_nsec mWindowMaxTook = 0;
+  uint64_t mLateFrames = 0;
 };
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,334 @@
+#ifndef INCLUDE_AL_FRAME_PIPELINE_HPP
+#define INCLUDE_AL_FRAME_PIPELINE_HPP
+
+/*  Allocore --
+  Multimedia / virtual environment application class library
+
+  Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+  Copyright (C) 2012-2019. The Regents of the University of California.
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    Neither the name of the University of California nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  File description:
+  Frame loop running simulation on a worker thread while the previous
+  frame renders
+
+*/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "al/core/app/al_FPS.hpp"
+#include "al/core/types/al_TripleBuffer.hpp"
+
+namespace al {
+
+/// Timing of the stages of a frame loop, in seconds
+struct FrameStageStats {
+  struct Stage {
+    double last = 0;   ///< duration in last frame
+    double mean = 0;   ///< mean duration since reset
+    double max = 0;    ///< longest duration since reset
+    uint64_t count = 0;
+
+    void add(double seconds);
+  };
+
+  Stage simulate;  ///< onSimulate, on the simulation thread
+  Stage render;    ///< rendering, on the calling thread
+  Stage wait;      ///< time the calling thread waited for simulation
+  Stage present;   ///< presenting the frame, e.g. swapping window buffers
+  Stage frame;     ///< time between the start of consecutive frames
+
+  void reset();
+  void print() const;
+};
+
+
+/// Window operations needed by a frame loop
+
+/// Implemented by windowed apps; tests can implement it without a window.
+class FrameLoopTarget {
+public:
+  virtual ~FrameLoopTarget() {}
+
+  /// Whether the loop should end before the next frame
+  virtual bool loopShouldStop() = 0;
+
+  /// Show the rendered frame, e.g. by swapping window buffers
+  virtual void presentFrame() = 0;
+};
+
+
+/// Frame loop with simulation pipelined against rendering
+
+/// In a serial loop, each frame simulates then renders, so the frame time
+/// is the sum of both. A pipelined loop simulates frame N+1 on a worker
+/// thread while frame N renders on the calling thread, so the frame time
+/// becomes the longer of the two, at the cost of one frame of latency
+/// between simulation and display.
+///
+/// Simulation updates a state owned by the worker thread. Each simulated
+/// state is handed to the renderer through a TripleBuffer, so the renderer
+/// reads a complete state while the next one is being written. TState must
+/// be copy assignable and should contain everything rendering needs from
+/// the simulation.
+///
+/// By default the renderer waits for the simulation of the previous frame
+/// to finish, so every simulated state is rendered exactly once. With
+/// waitForSimulation(false), the renderer never blocks and draws the latest
+/// finished state, repeating it if simulation falls behind.
+///
+/// @ingroup allocore
+template <class TState>
+class FramePipeline {
+public:
+  typedef std::function<void(double dt, TState& state)> SimulateFunction;
+  typedef std::function<void(double dt, const TState& state)> RenderFunction;
+
+  FramePipeline() {}
+  ~FramePipeline() { stop(); }
+
+  FramePipeline(const FramePipeline&) = delete;
+  FramePipeline& operator=(const FramePipeline&) = delete;
+
+  /// Set function advancing the state by dt seconds. Runs on the worker thread
+  void onSimulate(const SimulateFunction& f) { mSimulate = f; }
+
+  /// Set function rendering a state. Runs on the thread calling frame()
+  void onRender(const RenderFunction& f) { mRender = f; }
+
+  /// Set whether simulation runs on a worker thread. Must be set before start()
+  void pipelined(bool v) { mPipelined = v; }
+  bool pipelined() const { return mPipelined; }
+
+  /// Set whether each frame waits for the simulation of the previous frame
+  void waitForSimulation(bool v) { mWaitForSimulation = v; }
+  bool waitForSimulation() const { return mWaitForSimulation; }
+
+  /// Start with an initial state, starting the worker thread if pipelined
+  void start(const TState& initial);
+
+  /// Stop the worker thread
+  void stop();
+
+  bool running() const { return mRunning; }
+
+  /// Render a frame and simulate the next one
+
+  /// In a pipelined loop, renders the last simulated state while the worker
+  /// simulates the next state by dt. Otherwise, simulates by dt and then
+  /// renders the result.
+  void frame(double dt);
+
+  /// Run frames until the target should stop, paced by fps
+
+  /// Calls start() with the current state if not already started.
+  void run(FrameLoopTarget& target, FPS& fps);
+
+  /// Number of simulation steps completed
+  uint64_t simulatedFrames() const { return mSimulatedFrames; }
+
+  FrameStageStats& stats() { return mStats; }
+  const FrameStageStats& stats() const { return mStats; }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  static double secondsSince(Clock::time_point t) {
+    return std::chrono::duration<double>(Clock::now() - t).count();
+  }
+
+  void simulateStep(double dt);
+  void workerLoop();
+  void collectSimulationTime();
+
+  SimulateFunction mSimulate;
+  RenderFunction mRender;
+  bool mPipelined {true};
+  bool mWaitForSimulation {true};
+  bool mRunning {false};
+
+  TState mSimState;              // owned by the simulating thread
+  TripleBuffer<TState> mStates;  // handoff from simulation to rendering
+
+  std::thread mWorker;
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  bool mBusy {false};       // a simulation step is requested or running
+  bool mQuit {false};
+  double mNextDt {0};
+  std::atomic<uint64_t> mSimulatedFrames {0};
+  std::atomic<int64_t> mSimulateNanos {0};
+  uint64_t mCollectedFrames {0};
+
+  FrameStageStats mStats;
+  Clock::time_point mLastFrameStart;
+  bool mFirstFrame {true};
+};
+
+
+// ---------- IMPLEMENTATION ---------------------------------------------------
+
+template <class TState>
+inline void FramePipeline<TState>::start(const TState& initial) {
+  stop();
+  mSimState = initial;
+  mStates.reset(initial);
+  mSimulatedFrames = 0;
+  mCollectedFrames = 0;
+  mFirstFrame = true;
+  mQuit = false;
+  mBusy = false;
+  if (mPipelined) {
+    mWorker = std::thread(&FramePipeline::workerLoop, this);
+  }
+  mRunning = true;
+}
+
+template <class TState>
+inline void FramePipeline<TState>::stop() {
+  if (mWorker.joinable()) {
+    {
+      std::lock_guard<std::mutex> lk(mMutex);
+      mQuit = true;
+    }
+    mCondition.notify_all();
+    mWorker.join();
+  }
+  mRunning = false;
+}
+
+template <class TState>
+inline void FramePipeline<TState>::simulateStep(double dt) {
+  auto t = Clock::now();
+  if (mSimulate) {
+    mSimulate(dt, mSimState);
+  }
+  mStates.writeBuffer() = mSimState;
+  mStates.publish();
+  mSimulateNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t).count();
+  ++mSimulatedFrames;
+}
+
+template <class TState>
+inline void FramePipeline<TState>::workerLoop() {
+  std::unique_lock<std::mutex> lk(mMutex);
+  while (true) {
+    mCondition.wait(lk, [this] { return mQuit || mBusy; });
+    if (mQuit) {
+      return;
+    }
+    double dt = mNextDt;
+    lk.unlock();
+    simulateStep(dt);
+    lk.lock();
+    mBusy = false;
+    mCondition.notify_all();
+  }
+}
+
+template <class TState>
+inline void FramePipeline<TState>::collectSimulationTime() {
+  uint64_t n = mSimulatedFrames;
+  if (n != mCollectedFrames) {
+    mStats.simulate.add(mSimulateNanos * 1e-9);
+    mCollectedFrames = n;
+  }
+}
+
+template <class TState>
+inline void FramePipeline<TState>::frame(double dt) {
+  auto frameStart = Clock::now();
+  if (!mFirstFrame) {
+    mStats.frame.add(std::chrono::duration<double>(frameStart - mLastFrameStart).count());
+  }
+  mFirstFrame = false;
+  mLastFrameStart = frameStart;
+
+  if (!mPipelined) {
+    simulateStep(dt);
+    collectSimulationTime();
+    mStates.update();
+    auto t = Clock::now();
+    if (mRender) {
+      mRender(dt, mStates.readBuffer());
+    }
+    mStats.render.add(secondsSince(t));
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lk(mMutex);
+    if (mWaitForSimulation) {
+      auto t = Clock::now();
+      mCondition.wait(lk, [this] { return !mBusy; });
+      mStats.wait.add(secondsSince(t));
+    }
+    collectSimulationTime();
+    // Take the newest state before the worker can publish another
+    mStates.update();
+    if (!mBusy) {
+      mNextDt = dt;
+      mBusy = true;
+      mCondition.notify_all();
+    }
+  }
+
+  auto t = Clock::now();
+  if (mRender) {
+    mRender(dt, mStates.readBuffer());
+  }
+  mStats.render.add(secondsSince(t));
+}
+
+template <class TState>
+inline void FramePipeline<TState>::run(FrameLoopTarget& target, FPS& fps) {
+  if (!mRunning) {
+    start(mSimState);
+  }
+  fps.startFPS();
+  while (!target.loopShouldStop()) {
+    frame(fps.dt_sec());
+    auto t = Clock::now();
+    target.presentFrame();
+    mStats.present.add(secondsSince(t));
+    fps.tickFPS();
+  }
+  stop();
+}
+
+} // al::
+
+#endif
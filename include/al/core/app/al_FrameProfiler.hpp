@@ -0,0 +1,179 @@
+#ifndef INCLUDE_AL_FRAME_PROFILER_HPP
+#define INCLUDE_AL_FRAME_PROFILER_HPP
+
+/*  Allocore --
+  Multimedia / virtual environment application class library
+
+  Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+  Copyright (C) 2012-2019. The Regents of the University of California.
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    Neither the name of the University of California nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  File description:
+  Timing of named sections of each frame, with rolling percentiles and
+  Chrome trace export
+
+*/
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "al/core/system/al_Time.hpp"
+
+namespace al {
+
+/// Profiler of named CPU sections within frames
+
+/// Sections are timed between begin() and end(), or by a Scope object, and
+/// may be nested. The time spent in each section is summed over a frame and
+/// kept for the last frames, from which mean and percentiles are computed.
+/// Individual section calls can also be recorded as a trace and written in
+/// the Chrome trace event format, to be viewed in chrome://tracing or
+/// Perfetto.
+///
+/// A profiler must be used from a single thread, normally the one running
+/// the frame loop. Times come from a clock function, which can be replaced
+/// for testing.
+///
+/// @ingroup allocore
+class FrameProfiler {
+public:
+  typedef std::function<al_nsec()> Clock;
+
+  /// Summary of a section over the recorded frames, in seconds
+  struct Stats {
+    std::string name;
+    double mean = 0;
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double max = 0;
+    size_t frames = 0;  ///< number of frames summarized
+  };
+
+  /// Times a section for the lifetime of the object
+  class Scope {
+  public:
+    Scope(FrameProfiler& p, const char* name) : mProfiler(p) { p.begin(name); }
+    ~Scope() { mProfiler.end(); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  private:
+    FrameProfiler& mProfiler;
+  };
+
+  /// @param[in] historyFrames  number of frames kept for statistics
+  FrameProfiler(size_t historyFrames = 240);
+
+  /// Set function returning the current time in nanoseconds
+  void clock(const Clock& c) { mClock = c; }
+  al_nsec now() const { return mClock(); }
+
+  /// Set whether sections are timed
+  void enable(bool v) { mEnabled = v; }
+  bool enabled() const { return mEnabled; }
+
+  /// Set number of frames kept for statistics. Clears the history
+  void historyFrames(size_t n);
+  size_t historyFrames() const { return mHistoryFrames; }
+
+  /// Start timing a section
+  void begin(const char* name);
+
+  /// Stop timing the section last begun
+  void end();
+
+  /// End the current frame, adding section times to the history
+
+  /// Sections not used in a frame count as zero for that frame. The time
+  /// since the previous call is recorded as a section named "frame".
+  void endFrame();
+
+  /// Get statistics of a section, with zero frames if it is unknown
+  Stats stats(const std::string& name) const;
+
+  /// Get statistics of all sections, in order of first use
+  std::vector<Stats> stats() const;
+
+  /// Print statistics of all sections in milliseconds
+  void print() const;
+
+  /// Clear section history and trace
+  void reset();
+
+  /// Set whether individual section calls are recorded for a trace
+
+  /// @param[in] v          whether to record
+  /// @param[in] maxEvents  events kept; recording stops when reached
+  void recordTrace(bool v, size_t maxEvents = 100000);
+  bool recordingTrace() const { return mRecordTrace; }
+
+  /// Number of recorded trace events
+  size_t traceSize() const { return mTrace.size(); }
+
+  /// Write recorded trace as Chrome trace event JSON
+  bool writeTrace(const std::string& path) const;
+
+private:
+  struct Section {
+    std::string name;
+    al_nsec frameTotal = 0;         // time in current frame
+    std::vector<al_nsec> history;   // ring of frame totals
+  };
+  struct Open {
+    int section;
+    al_nsec start;
+  };
+  struct TraceEvent {
+    int section;
+    int depth;
+    al_nsec start;
+    al_nsec duration;
+  };
+
+  int sectionIndex(const char* name);
+  Stats summarize(const Section& s) const;
+
+  Clock mClock;
+  bool mEnabled = true;
+  size_t mHistoryFrames;
+  size_t mFrames = 0;         // frames ended since reset
+  al_nsec mLastFrameEnd = -1;
+  std::vector<Section> mSections;
+  std::vector<Open> mOpen;
+
+  bool mRecordTrace = false;
+  size_t mMaxTraceEvents = 0;
+  std::vector<TraceEvent> mTrace;
+};
+
+} // al::
+
+#endif
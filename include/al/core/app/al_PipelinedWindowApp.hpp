@@ -0,0 +1,80 @@
+#ifndef INCLUDE_AL_PIPELINED_WINDOWAPP_HPP
+#define INCLUDE_AL_PIPELINED_WINDOWAPP_HPP
+
+// Single window app that simulates the next frame on a worker thread while
+// the current frame renders. See FramePipeline.
+
+#include "al/core/app/al_FramePipeline.hpp"
+#include "al/core/app/al_WindowApp.hpp"
+
+namespace al {
+
+/// Window app with simulation pipelined against rendering
+
+/// Instead of onAnimate/onDraw, override onSimulate to advance a TState on
+/// a worker thread and onDraw(Graphics&, const TState&) to render it. The
+/// state displayed lags simulation by one frame. onSimulate must not use
+/// OpenGL, and should only touch data in the state or private to the
+/// simulation. onAnimate is still called on the render thread before each
+/// onDraw, for things like navigation.
+///
+/// Call pipeline().pipelined(false) before start() to run both on the main
+/// thread, e.g. to compare timing with pipeline().stats().
+///
+/// @ingroup allocore
+template <class TState>
+class PipelinedWindowApp : public WindowApp, public FrameLoopTarget {
+public:
+  PipelinedWindowApp();
+
+  /// Initial state for the simulation, can be set up to onCreate()
+  TState& state() { return mInitialState; }
+
+  /// Advance the state by dt seconds. Called on the simulation thread
+  virtual void onSimulate(double dt, TState& state) {}
+
+  /// Draw a simulated state. Called on the main thread
+  virtual void onDraw(Graphics& g, const TState& state) {}
+  using WindowApp::onDraw;
+
+  FramePipeline<TState>& pipeline() { return mPipeline; }
+
+  void start() override;
+
+  bool loopShouldStop() override { return WindowApp::shouldQuit(); }
+  void presentFrame() override { Window::refresh(); }
+
+private:
+  TState mInitialState;
+  FramePipeline<TState> mPipeline;
+};
+
+
+// ---------- IMPLEMENTATION ---------------------------------------------------
+
+template <class TState>
+inline PipelinedWindowApp<TState>::PipelinedWindowApp() {
+  mPipeline.onSimulate([this](double dt, TState& s) { onSimulate(dt, s); });
+  mPipeline.onRender([this](double dt, const TState& s) {
+    onAnimate(dt);
+    onDraw(mGraphics, s);
+  });
+}
+
+template <class TState>
+inline void PipelinedWindowApp<TState>::start() {
+  glfw::init(is_verbose);
+  onInit();
+  Window::create(is_verbose);
+  mGraphics.init();
+  onCreate();
+  mPipeline.start(mInitialState);
+  mPipeline.run(*this, *this);
+  onExit();
+  Window::destroy();
+  glfw::terminate(is_verbose);
+}
+
+}  // namespace al
+
+#endif
@@ -112,9 +112,37 @@ public:
 
   // destructive edits to internal vertices:
 
+  /// Attributes that must also match for vertices to be welded
+  enum WeldAttribute {
+    WELD_NORMALS = 1,
+    WELD_COLORS = 2,
+    WELD_TEXCOORDS = 4
+  };
+
   /// Generates indices for a set of vertices
+
+  /// Vertices with equal positions are merged into the first of them. This
+  /// is weld(0) on a mesh without indices.
   void compress();
 
+  /// Merge vertices lying within a distance of each other
+
+  /// Each vertex is merged into the first earlier vertex, itself not merged,
+  /// within epsilon. The remaining vertices keep their order, attributes and
+  /// positions. Indices are remapped, or generated if the mesh has none.
+  /// Vertices are found through a hash table of quantized positions, so the
+  /// cost is linear in the number of vertices. Triangles may become
+  /// degenerate and are not removed.
+  /// @param[in] epsilon    maximum distance between merged vertices, 0 to
+  ///                merge only equal positions
+  /// @param[in] attributes  bitwise-or of WeldAttribute flags for attributes
+  ///                that must also match
+  /// @param[in] attributeEpsilon  maximum difference per component of
+  ///                matching attributes
+  /// @param[in] numThreads  number of threads, 0 for one per hardware thread
+  /// \returns number of vertices removed
+  size_t weld(float epsilon=0, int attributes=0, float attributeEpsilon=0, unsigned numThreads=1);
+
   /// Convert indices (if any) to flat vertex buffers
   void decompress();
 
@@ -213,7 +241,8 @@ public:
 
   /// This smooths a triangle mesh using Laplacian (low-pass) filtering.
   /// New vertex positions are a weighted sum of their nearest neighbors. 
-  /// The number of vertices is not changed.
+  /// The number of vertices is not changed. To smooth repeatedly, build a
+  /// MeshTopology once and call its smooth method instead.
   /// @param[in] amount    interpolation fraction between original and smoothed result
   /// @param[in] weighting  0 = equal weight, 1 = inverse distance weight
   void smooth(float amount=1, int weighting=0);
@@ -0,0 +1,184 @@
+#ifndef INCLUDE_AL_GRAPHICS_MESH_TOPOLOGY_HPP
+#define INCLUDE_AL_GRAPHICS_MESH_TOPOLOGY_HPP
+
+/*  Allocore --
+  Multimedia / virtual environment application class library
+
+  Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+  Copyright (C) 2012-2019. The Regents of the University of California.
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+    Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+    Neither the name of the University of California nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  File description:
+  Connectivity of triangle meshes stored in flat arrays
+
+*/
+
+#include <functional>
+#include <vector>
+#include "al/core/graphics/al_Mesh.hpp"
+
+namespace al{
+
+/// Connectivity of an indexed triangle mesh
+
+/// The topology is built in linear time from the triangle indices. Triangle
+/// edges are bucket sorted by vertex to find the unique edges, from which
+/// vertex neighbors and the faces around each vertex are stored in compressed
+/// (CSR) arrays. No per-element allocation is done, and rebuilding a topology
+/// reuses its arrays, so it can be rebuilt every frame for procedural
+/// geometry. A topology stays valid while the mesh indices are unchanged;
+/// vertex positions may change freely.
+///
+/// Algorithms using the topology accept a number of threads. A value of 1
+/// runs serially and 0 uses one thread per hardware thread. Results do not
+/// depend on the number of threads.
+///
+/// @ingroup allocore
+class MeshTopology {
+public:
+  typedef Mesh::Index Index;
+
+  /// Value of an index that refers to no element
+  static const Index none = ~Index(0);
+
+  /// Undirected edge between two vertices, with v0 <= v1
+  struct Edge { Index v0, v1; };
+
+  MeshTopology(){}
+
+  /// @param[in] m    indexed triangle mesh
+  MeshTopology(const Mesh& m){ build(m); }
+
+  /// Build topology of an indexed triangle mesh
+
+  /// \returns false if the mesh is not made of indexed triangles
+  ///
+  bool build(const Mesh& m);
+
+  /// Build topology from triangle indices
+
+  /// @param[in] indices      three vertex indices per triangle
+  /// @param[in] numIndices   number of indices, truncated to a multiple of 3
+  /// @param[in] numVertices  number of vertices referred to by indices
+  void build(const Index * indices, size_t numIndices, size_t numVertices);
+
+
+  size_t numVertices() const { return mNumVertices; }
+  size_t numFaces() const { return mFaces.size()/3; }
+  size_t numEdges() const { return mEdges.size(); }
+
+  /// Get vertex indices of triangles, three per face
+  const std::vector<Index>& faces() const { return mFaces; }
+
+  /// Get unique edges, sorted by first and then second vertex
+  const std::vector<Edge>& edges() const { return mEdges; }
+
+  /// Get edge between corners i and i+1 (mod 3) of face f
+  Index faceEdge(Index f, int i) const { return mFaceEdges[f*3 + i]; }
+
+  /// Get the first or second face adjacent to an edge, or none
+  Index edgeFace(Index e, int side) const {
+    Index c = mEdgeCorners[e*2 + side];
+    return c == none ? none : c/3;
+  }
+
+  /// Get vertex opposite to an edge in its first or second face, or none
+  Index edgeOpposite(Index e, int side) const {
+    Index c = mEdgeCorners[e*2 + side];
+    return c == none ? none : mFaces[c - c%3 + (c+2)%3];
+  }
+
+  /// Whether an edge has exactly one face
+
+  /// Edges shared by more than two faces are reported as boundaries too, so
+  /// that algorithms treat them as creases.
+  bool isBoundary(Index e) const { return mEdgeCorners[e*2 + 1] == none; }
+
+  /// Get number of distinct vertices connected to a vertex by edges
+  unsigned valence(Index v) const { return mNeighborOffsets[v+1] - mNeighborOffsets[v]; }
+
+  /// Get vertices connected to a vertex, in ascending order
+  const Index * neighbors(Index v) const { return &mNeighbors[mNeighborOffsets[v]]; }
+
+  /// Get number of faces using a vertex
+  unsigned numVertexFaces(Index v) const { return mVertexFaceOffsets[v+1] - mVertexFaceOffsets[v]; }
+
+  /// Get faces using a vertex, in ascending order
+  const Index * vertexFaces(Index v) const { return &mVertexFaces[mVertexFaceOffsets[v]]; }
+
+
+  /// Laplacian smoothing of vertex positions
+
+  /// Same result as Mesh::smooth without building the adjacency each call.
+  /// @param[in,out] m    mesh this topology was built from
+  /// @param[in] amount    interpolation fraction between original and smoothed result
+  /// @param[in] weighting  0 = equal weight, 1 = inverse distance weight
+  /// @param[in] numThreads  number of threads to use
+  void smooth(Mesh& m, float amount=1, int weighting=0, unsigned numThreads=1) const;
+
+  /// Generate averaged vertex normals
+
+  /// Same result as Mesh::generateNormals on an indexed triangle mesh. Each
+  /// vertex gathers the normals of its faces, so vertices can be processed
+  /// in parallel.
+  /// @param[in,out] m    mesh this topology was built from
+  /// @param[in] normalize    whether to normalize normals
+  /// @param[in] equalWeightPerFace  whether to weight face normals equally
+  ///                rather than by face area
+  /// @param[in] numThreads  number of threads to use
+  void generateNormals(Mesh& m, bool normalize=true, bool equalWeightPerFace=false, unsigned numThreads=1) const;
+
+private:
+  size_t mNumVertices = 0;
+  std::vector<Index> mFaces;
+  std::vector<Edge> mEdges;
+  std::vector<Index> mFaceEdges;          // 3 per face
+  std::vector<Index> mEdgeCorners;        // 2 per edge, corner = 3*face + i
+  std::vector<Index> mNeighborOffsets;    // numVertices + 1
+  std::vector<Index> mNeighbors;
+  std::vector<Index> mVertexFaceOffsets;  // numVertices + 1
+  std::vector<Index> mVertexFaces;
+
+  // Edge sorting buffers, kept to avoid allocating on rebuild
+  std::vector<Index> mCornerMin, mCornerMax;
+  std::vector<Index> mSortOffsets, mSortedCorners;
+};
+
+
+/// Call f(begin, end) on consecutive ranges covering [0, n) from several threads
+
+/// @param[in] n      number of items
+/// @param[in] numThreads  number of threads, 0 for one per hardware thread
+/// @param[in] f      function called once per range
+void parallelRanges(size_t n, unsigned numThreads, const std::function<void(size_t, size_t)>& f);
+
+} // al::
+
+#endif
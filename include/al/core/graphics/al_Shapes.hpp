@@ -103,6 +103,31 @@ int addIcosahedron(Mesh& m, float radius=1);
 int addIcosphere(Mesh& m, double radius=1, int divisions=2);
 
 
+/// Subdivide indexed triangles
+
+/// Each triangle is split into four triangles formed from its vertices and
+/// edge midpoints. Only vertex positions are added.
+///
+/// @param[in,out]  m    Mesh with indexed triangles
+/// @param[in]    iterations  Number of times to subdivide
+/// @param[in]    normalize  Whether to place midpoints at the average
+///              distance of the edge vertices from the origin
+void subdivide(Mesh& m, unsigned iterations=1, bool normalize=false);
+
+
+/// Subdivide indexed triangles using Loop subdivision
+
+/// Each triangle is split into four, and vertices are moved so that the mesh
+/// converges to a smooth surface. Boundary edges are kept as curves, and
+/// vertices where boundaries meet are kept in place. Only vertex positions
+/// are computed; normals should be generated again afterwards.
+///
+/// @param[in,out]  m    Mesh with indexed triangles
+/// @param[in]    iterations  Number of times to subdivide
+/// @param[in]    numThreads  Number of threads, 0 for one per hardware thread
+void subdivideLoop(Mesh& m, unsigned iterations=1, unsigned numThreads=1);
+
+
 /// Add sphere as indexed triangles
 
 /// Vertices go stack-by-stack, then slice-by-slice. The stacks start at the
@@ -311,6 +311,13 @@ class Texture : public GPUObject {
     submit(pixels.data(), Texture::RGBA, Texture::FLOAT);
   }
 
+  /// Copy client pixels to a region of a 2D texture
+  /// If a pixel unpack buffer is bound, pixels is an offset into the buffer.
+  /// Mipmaps are not updated, call generateMipmap() after the last region.
+  void submitRegion(const void* pixels, unsigned int x, unsigned int y,
+                    unsigned int w, unsigned int h,
+                    unsigned int format, unsigned int type);
+
   // update the changes in params or settings
   // void update(bool force=false);
 
@@ -0,0 +1,236 @@
+#ifndef INCLUDE_AL_AUDIOCALLBACKPROFILER_HPP
+#define INCLUDE_AL_AUDIOCALLBACKPROFILER_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012-2019. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+	File description:
+	Timing of audio callbacks against their deadline
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "al/core/protocol/al_OSC.hpp"
+
+namespace al {
+
+/**
+ * @brief Measures how close audio callbacks come to their deadline
+ *
+ * Every AudioIO has a profiler, available through AudioIOData::profiler().
+ * When it is enabled, AudioIO times every call to processAudio() against the
+ * buffer period and keeps a histogram of the ratio between
+ * them (the load). Device xruns are counted with their time, and code in the
+ * callback can time named sections with AudioSectionTimer. DynamicScene and
+ * OutputMaster report the built in sections.
+ *
+ * All recording is lock free and done from the audio thread; stats() can be
+ * called from any other thread. When disabled, recording costs a single
+ * relaxed atomic load.
+ *
+ * The profiler can be queried over OSC by registering it with a
+ * ParameterServer:
+ * @code
+    audioIO().profiler()->enable();
+    parameterServer.registerOSCConsumer(audioIO().profiler(), "/audioProfiler");
+ * @endcode
+ * Then send "/audioProfiler/request" with a port to receive the stats at that
+ * port of the sender, "/audioProfiler/enable" with 0 or 1 and
+ * "/audioProfiler/reset". Stats are only sent to another host if its address
+ * is passed before the port and has been allowed with replyAddress().
+ *
+ * @ingroup allocore
+ */
+class AudioCallbackProfiler : public osc::MessageConsumer {
+ public:
+  /// Built in sections
+  enum Section {
+    VOICES = 0,       ///< DynamicScene voice processing
+    SPATIALIZER,      ///< DynamicScene spatializer
+    POST_PROCESSING,  ///< PolySynth/DynamicScene post processing callbacks
+    OUTPUT_MASTER,    ///< OutputMaster
+    NUM_BUILTIN_SECTIONS
+  };
+
+  static const int maxSections = 16;
+  /// Histogram bins cover loads of 0 to 200% in 5% steps. The last bin counts
+  /// callbacks that took twice the buffer period or more
+  static const int histogramBins = 41;
+  static const int maxXrunTimes = 64;
+
+  struct SectionStats {
+    std::string name;
+    uint64_t callbacks;    ///< Callbacks in which the section ran
+    double meanSeconds;    ///< Mean time per callback where the section ran
+    double maxSeconds;     ///< Longest time in a single callback
+  };
+
+  struct Stats {
+    uint64_t callbacks;
+    uint64_t lateCallbacks;  ///< Callbacks that took longer than the buffer period
+    double meanLoad;         ///< Mean callback duration / buffer period
+    double maxLoad;
+    std::vector<uint64_t> histogram;
+    uint64_t xruns;
+    std::vector<double> xrunTimes;  ///< Seconds since profiler creation, oldest first
+    std::vector<SectionStats> sections;
+  };
+
+  AudioCallbackProfiler();
+
+  void enable(bool enable = true) { mEnabled.store(enable, std::memory_order_relaxed); }
+  bool enabled() const { return mEnabled.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Add a named section
+   * @return section id to pass to AudioSectionTimer, or -1 if there are too
+   * many sections
+   *
+   * Should not be called while audio is running.
+   */
+  int addSection(const std::string &name);
+
+  /// Called by AudioIO when a callback starts
+  void beginCallback() { mCallbackStart = now(); }
+  /// Called by AudioIO when a callback ends
+  void endCallback(double periodSeconds);
+
+  /// Add time to a section in the current callback. Can be called from
+  /// several threads.
+  void addSectionTime(int section, int64_t nanoseconds) {
+    mSections[section].current.fetch_add(nanoseconds, std::memory_order_relaxed);
+  }
+
+  /// Record a device xrun. Called by AudioIO whether the profiler is enabled or not
+  void reportXrun();
+
+  /// Read stats. Values may be a few callbacks apart from each other
+  Stats stats() const;
+
+  /**
+   * @brief Clear stats
+   *
+   * Can be called from any thread. The counters are cleared by the audio
+   * thread at the end of the next callback or xrun, so that they have a
+   * single writer. Until then stats() reports them as cleared.
+   */
+  void reset();
+
+  /// Send stats as OSC messages prefixed with rootOSCPath
+  void send(osc::Send &sender, const std::string &rootOSCPath);
+
+  bool consumeMessage(osc::Message &m, std::string rootOSCPath) override;
+
+  /// Allow "request" messages to ask for stats to be sent to this address,
+  /// as well as to their sender
+  void replyAddress(const std::string &address);
+
+  static int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+ private:
+  void applyReset();
+
+  struct SectionData {
+    std::string name;
+    std::atomic<int64_t> current {0};  // Time in callback in progress
+    std::atomic<uint64_t> callbacks {0};
+    std::atomic<uint64_t> totalNanos {0};
+    std::atomic<uint64_t> maxNanos {0};
+  };
+
+  std::atomic<bool> mEnabled {false};
+  std::atomic<bool> mResetRequested {false};
+  int64_t mStartTime;
+  int64_t mCallbackStart {0};
+
+  std::atomic<uint64_t> mCallbacks {0};
+  std::atomic<uint64_t> mLateCallbacks {0};
+  std::atomic<double> mLoadSum {0.0};
+  std::atomic<double> mMaxLoad {0.0};
+  std::atomic<uint64_t> mHistogram[histogramBins];
+
+  std::atomic<uint64_t> mXruns {0};
+  std::atomic<double> mXrunTimes[maxXrunTimes];
+
+  std::mutex mSectionLock;  // Protects adding sections
+  std::atomic<int> mNumSections {NUM_BUILTIN_SECTIONS};
+  SectionData mSections[maxSections];
+
+  std::mutex mReplyLock;
+  std::string mReplyAddress;
+};
+
+/**
+ * @brief Adds the time until it goes out of scope to a profiler section
+ *
+ * Does nothing if profiler is nullptr or disabled.
+ * @code
+    void onAudioCB(AudioIOData &io) override {
+      AudioSectionTimer timer(io.profiler(), mySection);
+      ...
+    }
+ * @endcode
+ */
+class AudioSectionTimer {
+ public:
+  AudioSectionTimer(AudioCallbackProfiler *profiler, int section)
+      : mProfiler(profiler && profiler->enabled() ? profiler : nullptr),
+        mSection(section) {
+    if (mProfiler) mStart = AudioCallbackProfiler::now();
+  }
+
+  ~AudioSectionTimer() {
+    if (mProfiler) {
+      mProfiler->addSectionTime(mSection, AudioCallbackProfiler::now() - mStart);
+    }
+  }
+
+ private:
+  AudioCallbackProfiler *mProfiler;
+  int mSection;
+  int64_t mStart {0};
+};
+
+}  // al::
+
+#endif
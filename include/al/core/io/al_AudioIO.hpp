@@ -42,12 +42,16 @@
 	Andres Cabrera, 2017 mantaraya36@gmail.com
 */
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "al/core/io/al_AudioCallbackProfiler.hpp"
 #include "al/core/io/al_AudioIOData.hpp"
+#include "al/core/io/al_OfflineAudioBackend.hpp"
 
 namespace al {
 
@@ -233,6 +237,26 @@ class AudioIO : public AudioIOData {
   double time() const;  ///< Get current stream time in seconds
   double time(int frame) const;  ///< Get current stream time in seconds of frame
 
+  /// Number of buffers the device reported as underflowed or overflowed
+  uint64_t underflows() const { return mUnderflows.load(std::memory_order_relaxed); }
+  /// Count an underflow. Called by the backend from the audio thread
+  void reportUnderflow() {
+    mUnderflows.fetch_add(1, std::memory_order_relaxed);
+    mCallbackProfiler.reportXrun();
+  }
+
+  /// AudioOutputStage flags for the current gain, clipOut and zeroNANs settings
+  int outputStageFlags() const;
+
+  /// Render offline instead of using the audio device. Closes the stream if open
+  void offline(const OfflineAudioConfig &config);
+  /// Go back to using the audio device
+  void online();
+  /// Returns true if rendering offline
+  bool offline() const { return mOffline != nullptr; }
+  /// Offline backend. Only valid if offline() is true
+  OfflineAudioBackend &offlineBackend() { return *mOffline; }
+
   /// Add an AudioCallback handler (internal callback is always called first)
   AudioIO &append(AudioCallback &v);
   AudioIO &prepend(AudioCallback &v);
@@ -256,6 +280,8 @@ class AudioIO : public AudioIOData {
   bool mClipOut;      // whether to clip output between -1 and 1
   bool mAutoZeroOut;  // whether to automatically zero output buffers each block
   std::vector<AudioCallback *> mAudioCallbacks;
+  std::atomic<uint64_t> mUnderflows{0};
+  AudioCallbackProfiler mCallbackProfiler;
 
   //	void init(int outChannels, int inChannels);			//
   void reopen();  // reopen stream (restarts stream if needed)
@@ -263,6 +289,7 @@ class AudioIO : public AudioIOData {
   void operator=(const AudioIO &) = delete;  // Disallow copy
 
   std::unique_ptr<AudioBackend> mBackend;
+  std::unique_ptr<OfflineAudioBackend> mOffline;
 };
 
 }  // al::
@@ -150,6 +150,8 @@ inline AudioDeviceInfo::StreamMode operator|(
   return static_cast<AudioDeviceInfo::StreamMode>(+a | +b);
 }
 
+class AudioCallbackProfiler;
+
 /// Audio data to be sent to callback
 /// Audio buffers are guaranteed to be stored in a contiguous non-interleaved
 /// format, i.e., frames are tightly packed per channel.
@@ -230,6 +232,9 @@ class AudioIOData {
   double secondsPerBuffer() const;  ///< Get seconds/buffer of audio I/O stream
 
   void user(void* v) { mUser = v; }      ///< Set user data
+
+  /// Profiler of the AudioIO driving this callback. nullptr if there is none
+  AudioCallbackProfiler* profiler() const { return mProfiler; }
   void frame(unsigned int v) { assert(v >= 0); mFrame = v - 1; }  ///< Set frame count for next iteration
   void zeroBus();                        ///< Zeros all the bus buffers
   void zeroOut();  ///< Zeros all the internal output buffers
@@ -259,6 +264,7 @@ class AudioIOData {
 
  protected:
   void* mUser;  // User specified data
+  AudioCallbackProfiler* mProfiler {nullptr};
   mutable unsigned int mFrame;
   unsigned int mFramesPerBuffer;
   double mFramesPerSecond;
@@ -0,0 +1,89 @@
+#ifndef INCLUDE_AL_AUDIOOUTPUTSTAGE_HPP
+#define INCLUDE_AL_AUDIOOUTPUTSTAGE_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012-2019. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+	File description:
+	Fused processing of audio buffers going to and from devices
+*/
+
+namespace al {
+
+/**
+ * @brief Buffer conversion between AudioIO and audio devices
+ *
+ * The output functions apply the optional ramped gain, NaN zeroing and
+ * clipping and copy the result into the device buffer in a single pass.
+ * Channels are processed four at a time using SSE or NEON where available.
+ * The source buffers are not modified.
+ *
+ * A kernel specialized for each combination of flags is selected through a
+ * table, so there is no per sample branching.
+ *
+ * @ingroup allocore
+ */
+struct AudioOutputStage {
+  enum Flags {
+    GAIN = 1,       ///< Ramp gain from gainStart to gainEnd over the buffer
+    ZERO_NANS = 2,  ///< Replace NaNs with 0
+    CLIP = 4        ///< Clip between -1 and 1
+  };
+
+  /**
+   * @brief Process channels and write them interleaved
+   * @param[in] flags combination of Flags
+   * @param[in] src planar channels, each framesPerBuffer samples long
+   * @param[out] dst interleaved output, channels * frames samples
+   */
+  static void interleave(int flags, const float *src, float *dst,
+                         int channels, int frames,
+                         float gainStart = 1.f, float gainEnd = 1.f);
+
+  /// Process channels and write each to its own buffer in dst
+  static void planar(int flags, const float *src, float *const *dst,
+                     int channels, int frames,
+                     float gainStart = 1.f, float gainEnd = 1.f);
+
+  /// Copy interleaved src into planar dst
+  static void deinterleave(const float *src, float *dst, int channels,
+                           int frames);
+
+  /// Name of the instruction set used by the kernels
+  static const char *instructionSet();
+};
+
+}  // al::
+
+#endif
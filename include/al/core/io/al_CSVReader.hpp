@@ -50,6 +50,7 @@
 #include <sstream>
 #include <algorithm>
 #include <cstring>
+#include <cstdint>
 
 /**
  * @brief The CSVReader class reads simple CSV files
@@ -57,13 +58,17 @@
  * To use, first create a CSVReader object and call addType() to add the type of a
  * column. Then call readFile().
  *
- * Once the file is in memory it can be read as columns of floats using
- * getColumn(). Or the whole CSV data can be copied to memory by defining
- * a struct that will hold the values from each row from the csv file and calling
- * copyToStruct() to create a vector with the data from the CSV file.
+ * Once the file is in memory it can be read as columns using getColumn(),
+ * which returns a view of the data without copying it. Or the whole CSV data
+ * can be copied to memory by defining a struct that will hold the values from
+ * each row from the csv file and calling copyToStruct() to create a vector
+ * with the data from the CSV file.
+ *
+ * The file is memory mapped and split into chunks at line boundaries that are
+ * parsed in parallel. Data is stored by column in contiguous arrays.
  *
  * This reader is currently very naive (but efficient) and might choke with
- * complex or malformed CSV files.
+ * complex or malformed CSV files. Quoted fields are not supported.
  *
  * \code
 typedef struct {
@@ -92,8 +97,7 @@ int main(int argc, char *argv[]) {
                   << std::endl;
     }
 
-    std::vector<double> column1 = reader.getColumn(1);
-    for(auto value: column1) {
+    for(auto value: reader.getColumn(1)) {
         std::cout << value << std::endl;
     }
     std::cout << " Num rows:" << rows.size() << std::endl;
@@ -111,6 +115,32 @@ public:
     IGNORE_COLUMN
   } DataType;
 
+  /**
+   * @brief View of a column stored in the reader
+   *
+   * Valid until the next call to readFile() or until the reader is
+   * destroyed. Converts implicitly to std::vector to get a copy.
+   */
+  template<class T>
+  class ColumnSpan {
+  public:
+    ColumnSpan() {}
+    ColumnSpan(const T *data, size_t size) : mData(data), mSize(size) {}
+
+    const T *data() const { return mData; }
+    size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+    const T *begin() const { return mData; }
+    const T *end() const { return mData + mSize; }
+    const T &operator[](size_t i) const { return mData[i]; }
+
+    operator std::vector<T>() const { return std::vector<T>(begin(), end()); }
+
+  private:
+    const T *mData {nullptr};
+    size_t mSize {0};
+  };
+
   CSVReader() {
     // TODO We could automatically add types by trying to parse the file
   }
@@ -137,9 +167,19 @@ public:
   }
 
   /**
-     * @brief getColumn returns a column from the csv file
-     * @param index column index
-     * @return vector with the data
+   * @brief Set the number of threads used to parse a file
+   * @param numThreads 0 uses one thread per hardware core
+   *
+   * Small files are always parsed in a single thread.
+   */
+  void setNumThreads(unsigned int numThreads) { mNumThreads = numThreads; }
+
+  /**
+     * @brief copy rows to a vector of structs
+     *
+     * The members of DataStruct must be laid out in the order of the
+     * columns, with no padding between them. STRING columns take 32 bytes,
+     * INTEGER and REAL 8 bytes and BOOLEAN 1 byte.
      */
   template<class DataStruct>
   std::vector<DataStruct> copyToStruct() {
@@ -147,22 +187,34 @@ public:
     if (sizeof(DataStruct) < calculateRowLength()) {
       return output;
     }
-    for (auto row: mData) {
-      DataStruct newValues;
+    output.resize(mNumRows);
+    for (size_t row = 0; row < mNumRows; row++) {
+      DataStruct &newValues = output[row];
       memset(&newValues, 0, sizeof(DataStruct));
-      memcpy(&newValues, row, sizeof(newValues));
-      output.push_back(newValues);
+      copyRow(row, reinterpret_cast<char *>(&newValues));
     }
 
     return output;
   }
 
   /**
-     * @brief getColumn returns a column from the csv file
+     * @brief getColumn returns a REAL column from the csv file
      * @param index column index
-     * @return vector with the data
+     * @return view of the data. Empty if column is not of type REAL
      */
-  std::vector<double> getColumn(int index);
+  ColumnSpan<double> getColumn(int index) { return getColumnAs<double>(index, REAL); }
+
+  /// Returns an INTEGER column. Empty if column is not of type INTEGER
+  ColumnSpan<int64_t> getIntegerColumn(int index) { return getColumnAs<int64_t>(index, INTEGER); }
+
+  /// Returns a BOOLEAN column. Empty if column is not of type BOOLEAN
+  ColumnSpan<bool> getBooleanColumn(int index) { return getColumnAs<bool>(index, BOOLEAN); }
+
+  /// Returns the value of a STRING column in a row. nullptr if column is not of type STRING
+  const char *getString(int index, size_t row);
+
+  /// Number of data rows read by readFile()
+  size_t numRows() { return mNumRows; }
 
   /**
          * @brief get names of the columns in CSV file
@@ -176,13 +228,29 @@ public:
 
 private:
 
+  template<class T>
+  ColumnSpan<T> getColumnAs(int index, DataType type) {
+    if (index < 0 || index >= (int) mColumns.size() || mColumnTypes[index] != type) {
+      std::cerr << "ERROR: CSVReader column " << index << " is not of requested type" << std::endl;
+      return ColumnSpan<T>();
+    }
+    return ColumnSpan<T>(reinterpret_cast<const T *>(mColumns[index].data()), mNumRows);
+  }
+
   size_t calculateRowLength();
+  size_t typeSize(DataType type);
+  void copyRow(size_t row, char *dest);
+  void parseLines(const char *begin, const char *end, size_t firstRow, bool commaSeparated);
+  void parseField(const char *begin, const char *end, size_t column, size_t row);
 
   const size_t maxStringSize = 32;
 
   std::vector<std::string> mColumnNames;
   std::vector<DataType> mDataTypes;
-  std::vector<char *> mData;
+  std::vector<DataType> mColumnTypes; // Types used in last call to readFile()
+  std::vector<std::vector<char>> mColumns; // Column major storage
+  size_t mNumRows {0};
+  unsigned int mNumThreads {0};
 
   std::string mBasePath;
 };
@@ -1,9 +1,14 @@
 #ifndef INCLUDE_AL_IO_MIDI_HPP
 #define INCLUDE_AL_IO_MIDI_HPP
 
+#include <atomic>
+#include <condition_variable>
 #include <exception>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include <queue>
 
@@ -22,6 +27,8 @@
 #include "RtMidi.h"
 #undef NOMINMAX
 
+#include "al/core/system/al_Time.hpp"
+
 namespace al{
 
 // Internal classes to maintain backward compatibility
@@ -206,6 +213,189 @@ protected:
 };
 
 
+/// Timestamped queue of MIDI messages for sample accurate processing
+
+/// Messages are stamped with the host time (al_steady_time()) when they
+/// arrive on the MIDI thread and stored in a lock-free queue. The audio
+/// callback calls audioBlock() to track the times of its callbacks with a
+/// DelayLockedLoop, then pop() to get the messages received during the
+/// previous buffer, together with the frame offset at which they arrived.
+/// Messages are delayed by one buffer plus a jitter margin so that they keep
+/// their relative timing instead of being quantized to the start of the
+/// buffer:
+/// \code
+///   void onSound(AudioIOData& io) override {
+///     midiQueue.audioBlock(io.framesPerBuffer(), io.framesPerSecond());
+///     MIDIMessage m(0, 0, 0);
+///     int offsetFrames;
+///     while (midiQueue.pop(m, offsetFrames)) {
+///       if (m.type() == MIDIByte::NOTE_ON) {
+///         auto *voice = synth.getVoice<MyVoice>();
+///         synth.triggerOn(voice, offsetFrames, m.noteNumber());
+///       }
+///     }
+///     synth.render(io);
+///   }
+/// \endcode
+/// Several inputs can be bound to the same queue. Sysex data is not queued.
+///
+/// Handlers that are not real-time safe can read the queue from another
+/// thread with the untimed pop(), see MIDIMessageDispatcher. A queue has a
+/// single reader, which must use either the timed or the untimed pop().
+///
+/// @ingroup allocore
+class MIDIMessageQueue : public MIDIMessageHandler {
+public:
+
+	/// @param[in] capacity  maximum number of messages waiting in the queue
+	MIDIMessageQueue(unsigned capacity = 1024);
+
+	/// Queue a message received from a bound input, stamped with the current time
+	void onMIDIMessage(const MIDIMessage& m) override;
+
+	/// Queue a message with the host time in seconds it was received at
+
+	/// Can be called from several threads at once and never waits for
+	/// them or for the reader. Returns false if the queue is full.
+	bool push(const MIDIMessage& m, al_sec hostTime);
+
+	/// Start processing an audio buffer. Call once at the start of each audio callback
+
+	/// @param[in] framesPerBuffer  frames in the buffer
+	/// @param[in] framesPerSecond  sampling rate
+	/// @param[in] hostTime         host time of the callback
+	void audioBlock(unsigned framesPerBuffer, double framesPerSecond,
+	                al_sec hostTime = al_steady_time());
+
+	/// Get the next message due in the current audio buffer
+
+	/// @param[out] m             the message
+	/// @param[out] offsetFrames  frame within the buffer where the message is due
+	/// @return false when there are no more messages for this buffer
+	bool pop(MIDIMessage& m, int& offsetFrames);
+
+	/// Get the next message in the queue, whatever its time
+
+	/// The time stamp of the message is the host time it was queued at.
+	/// @return false if the queue is empty
+	bool pop(MIDIMessage& m);
+
+	/// Restart the tracking of callback times, e.g. after an xrun
+	void resetClock(){ mClock.reset(); }
+
+	/// Set extra delay in seconds to absorb audio callbacks that run early
+
+	/// Messages that arrive after the callback their time is due in are
+	/// moved to the start of the next buffer. The margin should be larger
+	/// than the jitter of the audio callbacks. Default is 1 ms.
+	void jitterMargin(al_sec v){ mJitterMargin = v; }
+	al_sec jitterMargin() const { return mJitterMargin; }
+
+	/// Set bandwidth in Hz of the callback time tracking. Lower values smooth more jitter. Default is 0.1 Hz
+	void clockBandwidth(double hz){ mBandwidth = hz; mClock.setBandwidth(hz); }
+
+	/// Get the loop tracking the callback times
+	const DelayLockedLoop& clock() const { return mClock; }
+
+	/// Get the number of messages dropped because the queue was full
+	unsigned dropped() const { return mDropped.load(); }
+
+protected:
+	struct Event {
+		al_sec time;
+		unsigned port;
+		unsigned char bytes[3];
+	};
+
+	// A slot is free for the write with ticket t when its sequence is t and
+	// holds its event when the sequence is t + 1
+	struct Slot {
+		std::atomic<size_t> sequence;
+		Event event;
+	};
+
+	bool read(Event& e);
+
+	std::unique_ptr<Slot[]> mSlots;
+	size_t mCapacity;
+	std::atomic<size_t> mUsed {0}; // slots written or being written, not read yet
+	std::atomic<size_t> mWrite {0}; // next write ticket
+	size_t mRead {0}; // next ticket to read, only used by the reader
+	std::atomic<unsigned> mDropped {0};
+
+	DelayLockedLoop mClock {512. / 44100., 0.1};
+	double mBandwidth {0.1};
+	al_sec mJitterMargin {0.001};
+	al_sec mBlockStart {0}, mBlockEnd {0}; // host times of messages due in the buffer
+	unsigned mFramesPerBuffer {0};
+	Event mPending;
+	bool mHasPending {false};
+};
+
+
+/// Passes the messages of a MIDIMessageQueue to a handler from a worker thread
+
+/// Handlers that lock, allocate or print, such as ParameterMIDI and
+/// PresetMIDI, should not run on the MIDI input thread, where they delay
+/// other inputs and the time stamps of later messages. Bind the inputs to
+/// queue() instead of the handler. The MIDI thread then only queues the
+/// message and wakes the worker thread, without taking a lock, and the
+/// worker calls the handler. The worker sleeps while no messages arrive.
+///
+/// @ingroup allocore
+class MIDIMessageDispatcher {
+public:
+
+	/// @param[in] handler       handler called from the worker thread
+	/// @param[in] pollInterval  longest time in seconds the worker sleeps.
+	///                          Bounds the delay if a wake up is missed.
+	MIDIMessageDispatcher(MIDIMessageHandler& handler, al_sec pollInterval = 0.01);
+
+	~MIDIMessageDispatcher();
+
+	/// Start the worker thread. Does nothing if it is running
+	void start();
+
+	/// Stop the worker thread, after it has passed the messages waiting
+	void stop();
+
+	/// Pass the messages waiting in the queue to the handler
+
+	/// Called by the worker thread. Can be called from another thread
+	/// when the worker is not running.
+	void process();
+
+	bool running() const { return mRunning.load(); }
+
+	/// Get the queue MIDI inputs are bound to
+	MIDIMessageQueue& queue(){ return mQueue; }
+
+private:
+	// Queue that wakes the worker when a bound input queues a message
+	class WakingQueue : public MIDIMessageQueue {
+	public:
+		WakingQueue(MIDIMessageDispatcher& d) : mDispatcher(d) {}
+		void onMIDIMessage(const MIDIMessage& m) override {
+			MIDIMessageQueue::onMIDIMessage(m);
+			mDispatcher.wake();
+		}
+	private:
+		MIDIMessageDispatcher& mDispatcher;
+	};
+
+	void wake();
+
+	MIDIMessageHandler& mHandler;
+	WakingQueue mQueue {*this};
+	al_sec mPollInterval;
+	std::thread mThread;
+	std::atomic<bool> mRunning {false};
+	std::atomic<bool> mPending {false};
+	std::mutex mLock;
+	std::condition_variable mCondition;
+};
+
+
 } // al::
 
 #endif
@@ -0,0 +1,162 @@
+#ifndef INCLUDE_AL_OFFLINEAUDIOBACKEND_HPP
+#define INCLUDE_AL_OFFLINEAUDIOBACKEND_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012-2019. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+	File description:
+	Audio backend that renders faster than real time without a device
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace al {
+
+class AudioIO;
+
+/// Settings for offline rendering
+///
+/// @ingroup allocore
+struct OfflineAudioConfig {
+  /// Speed as multiple of real time. 0 renders as fast as possible
+  double speed {0.0};
+  /// Seconds to render. 0 renders until the stream is stopped
+  double duration {0.0};
+  /// File to write output to. Files ending in .wav are written as 32 bit
+  /// float WAV, anything else as raw interleaved 32 bit floats. Empty
+  /// discards the output.
+  std::string outputFile;
+  /// File to read input from, WAV (16, 24, 32 bit or float) or raw
+  /// interleaved 32 bit floats. Input is silent after the file ends.
+  std::string inputFile;
+  /// Print the rendered duration and speed when rendering ends
+  bool verbose {false};
+};
+
+/**
+ * @brief Drives an AudioIO from its own thread instead of an audio device
+ *
+ * Calls AudioIO::processAudio() back to back, or paced to a multiple of real
+ * time, so patches can be rendered deterministically for tests, benchmarks
+ * and bounces on machines without audio hardware.
+ *
+ * Use through AudioIO::offline()
+ *
+ * @ingroup allocore
+ */
+class OfflineAudioBackend {
+ public:
+  OfflineAudioBackend(const OfflineAudioConfig &config);
+  ~OfflineAudioBackend();
+
+  const OfflineAudioConfig &config() const { return mConfig; }
+
+  /// Set number of channels. -1 opens the default of 2 channels
+  void channels(int num, bool forOutput);
+  int inDeviceChans() const { return mChannelsIn; }
+  int outDeviceChans() const { return mChannelsOut; }
+
+  bool open(int framesPerSecond, int framesPerBuffer, AudioIO *io);
+  bool close();
+  bool start();
+  bool stop();
+  bool isOpen() const { return mOpen; }
+  bool isRunning() const { return mRunning; }
+
+  /// Stream time in seconds of rendered audio
+  double time() const;
+
+  /// Fraction of the buffer duration spent in the last callback
+  double cpu() const { return mCpu.load(); }
+
+  /**
+   * @brief Block until the configured duration has been rendered
+   * @return false if no duration is set
+   */
+  bool wait();
+
+  uint64_t framesRendered() const { return mFramesRendered.load(); }
+
+  /// Seconds of audio rendered per second of wall clock time
+  double realtimeFactor() const { return mRealtimeFactor.load(); }
+
+ private:
+  void renderThread();
+  bool openInput();
+  size_t readInput(float *interleaved, size_t frames);
+  bool openOutput();
+  void closeOutput();
+
+  OfflineAudioConfig mConfig;
+  int mChannelsIn {0};
+  int mChannelsOut {2};
+  int mFramesPerSecond {44100};
+  int mFramesPerBuffer {512};
+  AudioIO *mIO {nullptr};
+
+  bool mOpen {false};
+  std::atomic<bool> mRunning {false};
+  std::atomic<bool> mStopRequested {false};
+  std::thread mThread;
+  std::mutex mLock;
+  std::condition_variable mDoneCondition;
+
+  std::atomic<uint64_t> mFramesRendered {0};
+  std::atomic<double> mRealtimeFactor {0.0};
+  std::atomic<double> mCpu {0.0};
+
+  // Input file
+  FILE *mInputFile {nullptr};
+  int mInputChannels {0};
+  int mInputFormat {0};
+  int mInputBytesPerSample {4};
+  uint64_t mInputBytesLeft {0};
+  std::vector<char> mInputRaw;
+
+  // Output file
+  FILE *mOutputFile {nullptr};
+  bool mOutputWav {false};
+  uint64_t mOutputBytes {0};
+};
+
+}  // al::
+
+#endif
@@ -60,6 +60,7 @@ namespace rnd{
 class LinCon;
 class MulLinCon;
 class Tausworthe;
+class Philox;
 template<class RNG> class Random;
 
 
@@ -70,6 +71,17 @@ inline static uint32_t seed(){
 }
 
 
+/// Convert uniform random integers to standard normal variates
+
+/// Uses the Box-Muller transform on each pair of integers, with polynomial
+/// approximations of log, sin and cos accurate to about 1e-7. Processes four
+/// pairs at a time using SSE2 or NEON where available.
+/// @param[in]  bits  n uniform random integers
+/// @param[out] dst   n normal variates
+/// @param[in]  n     number of values, must be even
+void uintToNormal(const uint32_t * bits, float * dst, size_t n);
+
+
 /// Random distribution generator
 ///
 /// @ingroup allocore
@@ -153,11 +165,40 @@ public:
   void shuffle(T * arr, uint32_t len);
 
 
+
+  // Bulk generation:
+  // These fill arrays in blocks, using the RNG's bulk operator() so its
+  // lanes and the conversions can be vectorized by the compiler. They
+  // consume the RNG's sequence like the single value functions, but are not
+  // guaranteed to return the same values.
+
+  /// Fill dst with n uniform randoms in [0, 1)
+  void uniform(float * dst, size_t n);
+
+  /// Fill dst with n uniform randoms in [-1, 1)
+  void uniformS(float * dst, size_t n);
+
+  /// Fill dst with n standard normal variates
+
+  /// Uses uintToNormal() instead of the rejection loop of normal().
+  void normal(float * dst, size_t n);
+
+  /// Fill points with n points within a unit ball, N values per point
+  template <int N, class T>
+  void ball(T * points, size_t n);
+
+  /// Fill points with n points within a unit ball
+  template <template<int,class> class VecType, int N, class T>
+  void ball(VecType<N,T> * points, size_t n){ ball<N>(&points[0][0], n); }
+
+
   // DEPRECATED:
   float gaussian(){ return normal(); }
   template <class T> void gaussian(T& y1, T& y2){ normal(y1,y2); }
 protected:
   RNG mRNG;
+
+  static const size_t blockSize = 256; // values per block of bulk generation
 };
 
 
@@ -190,6 +231,12 @@ public:
     return mVal = mVal*mMul + mAdd;
   }
 
+  /// Generate the next n uniform random integers into dst
+
+  /// Same sequence as n calls to operator(). Runs four lanes that each step
+  /// four values ahead, which the compiler can vectorize.
+  void operator()(uint32_t * dst, size_t n);
+
   /// Set seed
   void seed(uint32_t v){ mVal=v; }
 
@@ -240,6 +287,12 @@ public:
     return mVal *= mMul;
   }
 
+  /// Generate the next n uniform random integers into dst
+
+  /// Same sequence as n calls to operator(), computed in four lanes like
+  /// LinCon.
+  void operator()(uint32_t * dst, size_t n);
+
   /// Set seed
   void seed(uint32_t v){ mVal=v; }
 
@@ -288,6 +341,13 @@ public:
   /// Generate next uniform random integer in [0, 2^32)
   uint32_t operator()();
 
+  /// Generate the next n uniform random integers into dst
+
+  /// Same sequence as n calls to operator(). Each value depends on the
+  /// previous one, so this is not vectorized; use Philox for faster bulk
+  /// generation.
+  void operator()(uint32_t * dst, size_t n);
+
   /// Set seed
   void seed(uint32_t v);
 
@@ -299,6 +359,87 @@ private:
   void iterate();
 };
 
+
+
+/// Counter-based uniform pseudo-random number generator (Philox4x32-10).
+
+/// Each block of four outputs is a function of the key (the seed), a stream
+/// number and the block's position in the stream, so any position of any
+/// stream can be reached directly and blocks are generated independently,
+/// in several lanes at a time by the bulk operator(). Giving each thread
+/// its own stream makes parallel generation reproducible:
+/// \code
+///   Random<Philox> rng(seed);
+///   rng.rng().stream(threadIndex);
+/// \endcode
+/// It is based on the paper
+/// J. K. Salmon, M. A. Moraes, R. O. Dror, D. E. Shaw, "Parallel Random
+/// Numbers: As Easy as 1, 2, 3", SC11 (2011).
+///
+/// @ingroup allocore
+class Philox{
+public:
+
+  /// Default constructor uses a randomly generated seed
+  Philox(){ seed(al::rnd::seed()); }
+
+  /// @param[in] seed    Initial seed value
+  /// @param[in] stream  Stream number
+  Philox(uint64_t seed, uint64_t stream=0){ this->seed(seed); this->stream(stream); }
+
+
+  /// Generate next uniform random integer in [0, 2^32)
+  uint32_t operator()(){
+    if(mIndex == 4){
+      blocks<1>(mCounter++, mBuffer);
+      mIndex = 0;
+    }
+    return mBuffer[mIndex++];
+  }
+
+  /// Generate the next n uniform random integers into dst
+
+  /// Same sequence as n calls to operator().
+  void operator()(uint32_t * dst, size_t n);
+
+  /// Set seed, restarting the current stream
+  void seed(uint64_t v){
+    mKey[0] = uint32_t(v);
+    mKey[1] = uint32_t(v >> 32);
+    position(0);
+  }
+
+  /// Select stream, starting at its beginning
+  void stream(uint64_t v){ mStream = v; position(0); }
+
+  /// Get stream number
+  uint64_t stream() const { return mStream; }
+
+  /// Jump to a position in the stream, in number of values generated
+  void position(uint64_t v){
+    mCounter = v / 4;
+    mIndex = 4;
+    if(v % 4){
+      blocks<1>(mCounter++, mBuffer);
+      mIndex = int(v % 4);
+    }
+  }
+
+  /// Get position in the stream, in number of values generated
+  uint64_t position() const { return mCounter * 4 - (4 - mIndex); }
+
+  /// Compute L consecutive blocks of four values starting at block counter
+  template <int L>
+  void blocks(uint64_t counter, uint32_t * out) const;
+
+private:
+  uint32_t mKey[2];
+  uint64_t mStream;
+  uint64_t mCounter; // next block to generate
+  uint32_t mBuffer[4];
+  int mIndex;        // next value in mBuffer, 4 when empty
+};
+
 // Implementation_______________________________________________________________
 
 inline Tausworthe::Tausworthe(){ seed(al::rnd::seed()); }
@@ -330,6 +471,81 @@ inline void Tausworthe::iterate(){
   s4 = ((s4 & 0xffffff80) << 13) ^ (((s4 <<  3) ^ s4) >> 12);
 }
 
+inline void Tausworthe::operator()(uint32_t * dst, size_t n){
+  for(size_t i=0; i<n; ++i) dst[i] = (*this)();
+}
+
+inline void LinCon::operator()(uint32_t * dst, size_t n){
+  size_t i=0;
+  if(n >= 8){
+    // x[i+4] = mul4 x[i] + add4
+    uint32_t mul2 = mMul*mMul;
+    uint32_t mul4 = mul2*mul2;
+    uint32_t add4 = mAdd*(mul2*mMul + mul2 + mMul + 1);
+    uint32_t lane[4];
+    for(int j=0; j<4; ++j) lane[j] = (*this)();
+    size_t end = n - n % 4;
+    for(; i < end; i+=4){
+      for(int j=0; j<4; ++j){
+        dst[i+j] = lane[j];
+        lane[j] = lane[j]*mul4 + add4;
+      }
+    }
+    mVal = dst[end-1];
+  }
+  for(; i<n; ++i) dst[i] = (*this)();
+}
+
+inline void MulLinCon::operator()(uint32_t * dst, size_t n){
+  size_t i=0;
+  if(n >= 8){
+    uint32_t mul2 = mMul*mMul;
+    uint32_t mul4 = mul2*mul2;
+    uint32_t lane[4];
+    for(int j=0; j<4; ++j) lane[j] = (*this)();
+    size_t end = n - n % 4;
+    for(; i < end; i+=4){
+      for(int j=0; j<4; ++j){
+        dst[i+j] = lane[j];
+        lane[j] *= mul4;
+      }
+    }
+    mVal = dst[end-1];
+  }
+  for(; i<n; ++i) dst[i] = (*this)();
+}
+
+template <int L>
+void Philox::blocks(uint64_t counter, uint32_t * out) const {
+  // Lanes are stored as separate arrays so the rounds vectorize
+  uint32_t c0[L], c1[L], c2[L], c3[L];
+  for(int l=0; l<L; ++l){
+    uint64_t c = counter + l;
+    c0[l] = uint32_t(c);
+    c1[l] = uint32_t(c >> 32);
+    c2[l] = uint32_t(mStream);
+    c3[l] = uint32_t(mStream >> 32);
+  }
+  uint32_t k0 = mKey[0], k1 = mKey[1];
+  for(int r=0; r<10; ++r){
+    for(int l=0; l<L; ++l){
+      uint64_t p0 = uint64_t(0xD2511F53) * c0[l];
+      uint64_t p1 = uint64_t(0xCD9E8D57) * c2[l];
+      c0[l] = uint32_t(p1 >> 32) ^ c1[l] ^ k0;
+      c1[l] = uint32_t(p1);
+      c2[l] = uint32_t(p0 >> 32) ^ c3[l] ^ k1;
+      c3[l] = uint32_t(p0);
+    }
+    k0 += 0x9E3779B9;
+    k1 += 0xBB67AE85;
+  }
+  for(int l=0; l<L; ++l){
+    out[4*l  ] = c0[l];
+    out[4*l+1] = c1[l];
+    out[4*l+2] = c2[l];
+    out[4*l+3] = c3[l];
+  }
+}
 
 template <class RNG>
 template <int N, class T>
@@ -368,6 +584,73 @@ template <class T> void Random<RNG>::normal(T& y1, T& y2){
   y2 = T(x2 * w);
 }
 
+template <class RNG>
+const size_t Random<RNG>::blockSize;
+
+template <class RNG>
+void Random<RNG>::uniform(float * dst, size_t n){
+  uint32_t bits[blockSize];
+  while(n){
+    size_t m = n < blockSize ? n : blockSize;
+    mRNG(bits, m);
+    // Integer to float conversions vectorize, unlike the bit punning of
+    // uintToUnit, and keep 24 instead of 23 bits of the integer
+    for(size_t i=0; i<m; ++i) dst[i] = float(bits[i] >> 8) * (1.f/16777216.f);
+    dst += m;
+    n -= m;
+  }
+}
+
+template <class RNG>
+void Random<RNG>::uniformS(float * dst, size_t n){
+  uint32_t bits[blockSize];
+  while(n){
+    size_t m = n < blockSize ? n : blockSize;
+    mRNG(bits, m);
+    for(size_t i=0; i<m; ++i) dst[i] = float(int32_t(bits[i]) >> 8) * (1.f/8388608.f);
+    dst += m;
+    n -= m;
+  }
+}
+
+template <class RNG>
+void Random<RNG>::normal(float * dst, size_t n){
+  uint32_t bits[blockSize];
+  float last[2];
+  while(n){
+    size_t m = n < blockSize ? n : blockSize;
+    size_t even = m - (m & 1);
+    mRNG(bits, m + (m & 1));
+    uintToNormal(bits, dst, even);
+    if(m & 1){
+      uintToNormal(bits + even, last, 2);
+      dst[even] = last[0];
+    }
+    dst += m;
+    n -= m;
+  }
+}
+
+template <class RNG>
+template <int N, class T>
+void Random<RNG>::ball(T * points, size_t n){
+  const size_t candidates = blockSize / N;
+  float c[blockSize];
+  size_t count = 0;
+  while(count < n){
+    uniformS(c, candidates * N);
+    for(size_t i=0; i<candidates && count<n; ++i){
+      const float * v = c + i*N;
+      float w = 0.f;
+      for(int j=0; j<N; ++j) w += v[j]*v[j];
+      if(w < 1.f){ // inside unit ball
+        for(int j=0; j<N; ++j) points[count*N + j] = T(v[j]);
+        ++count;
+      }
+    }
+  }
+}
+
 template <class RNG>
 inline float Random<RNG>::triangle(){
   union {float f; uint32_t i;} u,v;
@@ -429,47 +712,47 @@ using StdRandom = al::rnd::Random<StdRnd>;
 namespace rnd {
 
 template<>
-float StdRandom::uniform() {
+inline float StdRandom::uniform() {
     return mRNG();
 }
 
 template<>
 template<typename T>
-T StdRandom::uniform(T const& hi) {
+inline T StdRandom::uniform(T const& hi) {
     return static_cast<T>(mRNG(float(hi)));
 }
 
 template<>
 template<typename T>
-T StdRandom::uniform(T const& hi, T const& lo) {
+inline T StdRandom::uniform(T const& hi, T const& lo) {
     return static_cast<T>(mRNG(float(lo), float(hi)));
 }
 
 template<>
-float StdRandom::uniformS() {
+inline float StdRandom::uniformS() {
     return mRNG(-1.0f, 1.0f);
 }
 
 template<>
 template<typename T>
-T StdRandom::uniformS(T const& lim) {
+inline T StdRandom::uniformS(T const& lim) {
     return static_cast<T>(mRNG(float(-lim), float(lim)));
 }
 
 template <>
-float StdRandom::triangle() {
+inline float StdRandom::triangle() {
     return 0.5f * (uniformS() + uniformS());
 }
 
 template <>
-float StdRandom::sign(float x) {
+inline float StdRandom::sign(float x) {
     static float arr[2] = {-1.0f, 1.0f};
     return x * arr[mRNG.randi(0, 1)];
 }
 
 template <>
 template <class T>
-void StdRandom::shuffle(T * arr, uint32_t len) {
+inline void StdRandom::shuffle(T * arr, uint32_t len) {
     for (uint32_t i = len-1; i > 0; i -= 1) {
         uint32_t j = mRNG.randi(i+1);
         T t = arr[i];
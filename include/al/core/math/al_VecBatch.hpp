@@ -0,0 +1,124 @@
+#ifndef INCLUDE_AL_VECBATCH_HPP
+#define INCLUDE_AL_VECBATCH_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012-2019. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+	File description:
+	Rotation, transformation and normalization of arrays of vectors and
+	quaternions using SIMD instructions
+*/
+
+#include <cstddef>
+#include <vector>
+
+#include "al/core/math/al_Mat.hpp"
+#include "al/core/math/al_Quat.hpp"
+#include "al/core/math/al_Vec.hpp"
+
+namespace al {
+
+/**
+ * @brief Operations on arrays of Vec3f, Vec3d and Quat
+ *
+ * Each function applies the same operation as the corresponding Vec, Quat or
+ * Mat member to n consecutive elements. The arrays are processed several
+ * elements at a time using AVX, SSE2 or NEON. AVX kernels are compiled
+ * separately and only used when the CPU supports them, so binaries built on
+ * x86 run on any machine. Results can differ from the scalar functions in
+ * the last bit.
+ *
+ * Output arrays may be the same as the input arrays.
+ *
+ * @code
+ * std::vector<Vec3f> positions(1000);
+ * VecBatch::rotate(listenerPose.quat().conj(), positions.data(),
+ *                  positions.data(), positions.size());
+ * @endcode
+ *
+ * @ingroup allocore
+ */
+struct VecBatch {
+  /// out[i] = q.rotate(in[i])
+  static void rotate(const Quatf &q, const Vec3f *in, Vec3f *out, size_t n);
+  static void rotate(const Quatd &q, const Vec3d *in, Vec3d *out, size_t n);
+
+  /// out[i] = q[i].rotate(in[i])
+  static void rotate(const Quatf *q, const Vec3f *in, Vec3f *out, size_t n);
+  static void rotate(const Quatd *q, const Vec3d *in, Vec3d *out, size_t n);
+
+  /**
+   * @brief Multiply by a 4x4 matrix, out[i] = (m * Vec4(in[i], w)).xyz
+   *
+   * Use w = 1 for points and w = 0 for directions. There is no perspective
+   * divide.
+   */
+  static void transform(const Mat4f &m, const Vec3f *in, Vec3f *out, size_t n,
+                        float w = 1.f);
+  static void transform(const Mat4d &m, const Vec3d *in, Vec3d *out, size_t n,
+                        double w = 1.);
+
+  /// v[i].normalize(), zero length vectors become (1, 0, 0)
+  static void normalize(Vec3f *v, size_t n);
+  static void normalize(Vec3d *v, size_t n);
+
+  /// q[i].normalize()
+  static void normalize(Quatf *q, size_t n);
+  static void normalize(Quatd *q, size_t n);
+
+  /// out[i] = a[i].dot(b[i])
+  static void dot(const Vec3f *a, const Vec3f *b, float *out, size_t n);
+  static void dot(const Vec3d *a, const Vec3d *b, double *out, size_t n);
+
+  /// out[i] = a[i] * b[i]
+  static void multiply(const Quatf *a, const Quatf *b, Quatf *out, size_t n);
+  static void multiply(const Quatd *a, const Quatd *b, Quatd *out, size_t n);
+
+  /// Name of the instruction set in use: "AVX", "SSE2", "NEON" or "scalar"
+  static const char *instructionSet();
+
+  /// Instruction sets available on this machine, fastest first
+  static std::vector<const char *> instructionSets();
+
+  /**
+   * @brief Select the instruction set for all threads
+   *
+   * The fastest available instruction set is used by default. This is
+   * meant for testing and benchmarking.
+   * @return false if the instruction set is not available
+   */
+  static bool useInstructionSet(const char *name);
+};
+
+}  // al::
+
+#endif
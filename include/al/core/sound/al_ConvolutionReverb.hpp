@@ -0,0 +1,209 @@
+#ifndef INCLUDE_AL_CONVOLUTIONREVERB_HPP
+#define INCLUDE_AL_CONVOLUTIONREVERB_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012-2019. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+	File description:
+	Multichannel convolution with uniformly partitioned impulse responses
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "al/core/io/al_AudioIOData.hpp"
+
+namespace gam {
+template <class T>
+class RFFT;
+}
+
+namespace al {
+
+/**
+ * @brief Multichannel convolution reverb without external dependencies
+ *
+ * Each channel is convolved with its impulse response (IR) using uniformly
+ * partitioned overlap-save convolution. Input is processed in blocks of
+ * partitionSize frames with no added latency. The IRs are split into
+ * partitions of the same size, and the spectrum of each partition is
+ * multiplied with the spectrum of a past input block kept in a
+ * frequency-domain delay line. Only one forward and one inverse FFT are needed
+ * per block and channel whatever the IR length.
+ *
+ * The first headPartitions partitions are computed in the audio thread. The
+ * rest, the tail, only need input from earlier blocks and are computed ahead
+ * of time by a worker thread. If the tail of a block is not ready when the
+ * block is processed, the audio thread computes it itself, without waiting
+ * for the worker, so output is always complete and is the same when
+ * rendering offline. lateTails() counts these blocks; if it grows, increase
+ * headPartitions.
+ *
+ * As an AudioCallback, it processes the output channels of an AudioIOData in
+ * place, e.g. after the voices of a PolySynth:
+ * @code
+ *   ConvolutionReverb reverb;
+ *   reverb.configure(512, {irLeft, irRight}, irLength);
+ *   synth.append(reverb);
+ * @endcode
+ * The buffer size of the audio device must be a multiple of the partition
+ * size. Otherwise onAudioCB() reports an error once and leaves the output
+ * unprocessed.
+ *
+ * @ingroup allocore
+ */
+class ConvolutionReverb : public AudioCallback {
+public:
+  ConvolutionReverb();
+  ~ConvolutionReverb();
+
+  /**
+   * @brief Prepare IRs for processing
+   * @param[in] partitionSize frames in each partition, a power of two. Blocks
+   * passed to process() must be a multiple of this size
+   * @param[in] IRs one IR per channel. Channels with the same IR pointer
+   * share its spectra
+   * @param[in] IRlength number of frames in each IR
+   * @param[in] tailThread compute the tail partitions in a worker thread
+   * @param[in] headPartitions partitions computed in the audio thread when
+   * using the worker thread. The worker has about this many blocks of time to
+   * compute each tail.
+   * @return false if the parameters are invalid
+   *
+   * Must not be called while processing.
+   */
+  bool configure(uint32_t partitionSize, std::vector<float *> IRs,
+                 uint32_t IRlength, bool tailThread = true,
+                 uint32_t headPartitions = 4);
+
+  /**
+   * @brief Convolve channels in place
+   * @param[in,out] buffers one buffer per channel
+   * @param[in] numChannels channels past the configured channels are not processed
+   * @param[in] numFrames a multiple of the partition size
+   * @return false if not configured or numFrames is not a multiple of the
+   * partition size. Buffers are not modified then.
+   */
+  bool process(float *const *buffers, unsigned int numChannels,
+               unsigned int numFrames);
+
+  /// Convolve the output channels of io in place. Prints an error the first
+  /// time io.framesPerBuffer() is not a multiple of the partition size.
+  void onAudioCB(AudioIOData &io) override;
+
+  /// Set gain of the input in the output. Default is 0
+  void dry(float gain) { mDry = gain; }
+  float dry() const { return mDry; }
+
+  /// Set gain of the convolution in the output. Default is 1
+  void wet(float gain) { mWet = gain; }
+  float wet() const { return mWet; }
+
+  /// Clear the input history. Must not be called while processing
+  void reset();
+
+  unsigned int numChannels() const { return mChannelIR.size(); }
+  uint32_t partitionSize() const { return mPartitionSize; }
+  uint32_t numPartitions() const { return mNumPartitions; }
+
+  /// Partitions computed in the audio thread
+  uint32_t headPartitions() const { return mHeadPartitions; }
+
+  /// Number of blocks for which the worker thread was late and the audio
+  /// thread computed the tail
+  uint64_t lateTails() const { return mLateTails.load(); }
+
+  /// Name of the instruction set used to multiply spectra
+  static const char *instructionSet();
+
+private:
+  // Spectra are stored as a block of real parts followed by a block of
+  // imaginary parts, each mSpectrumStride floats, zero padded past the
+  // Nyquist bin so that they can be processed four bins at a time
+  float *fdlSpectrum(size_t channel, int64_t block);
+  float *irSpectrum(size_t channel, uint32_t partition);
+  float *tailSpectrum(size_t channel, int64_t block);
+
+  // Accumulates the products of partitions [begin, end) for a block
+  void multiplyPartitions(size_t channel, int64_t block, uint32_t begin,
+                          uint32_t end, float *accum);
+  void computeTail(int64_t block);
+  void processBlock(float *const *buffers, unsigned int numChannels);
+
+  void startWorker();
+  void stopWorker();
+  void workerFunction();
+
+  uint32_t mPartitionSize {0};
+  uint32_t mNumPartitions {0};
+  uint32_t mHeadPartitions {0};
+  size_t mSpectrumStride {0};
+  float mDry {0.0f};
+  float mWet {1.0f};
+
+  std::unique_ptr<gam::RFFT<float>> mFFT;
+  std::vector<float> mFFTBuffer;  // Used by the audio thread
+  std::vector<float> mAccum;
+
+  std::vector<uint32_t> mChannelIR;  // Index into mIRSpectra of each channel
+  std::vector<std::vector<float>> mIRSpectra;  // numPartitions spectra per IR
+  std::vector<std::vector<float>> mFDL;  // numPartitions input spectra per channel
+  std::vector<std::vector<float>> mHistory;  // Previous input block per channel
+  std::vector<std::vector<float>> mTails;  // headPartitions tail spectra per channel
+  std::vector<float *> mBuffers;  // For onAudioCB()
+  std::vector<float *> mBlockBuffers;  // Position of each partition in process()
+  bool mBufferSizeReported {false};
+
+  int64_t mBlock {0};  // Block being processed
+  // Tails are computed in order by whichever thread claims them. A tail is
+  // ready when its slot holds its block number.
+  std::atomic<int64_t> mBlocksDone {0};
+  std::atomic<int64_t> mTailClaimed {-1};
+  std::unique_ptr<std::atomic<int64_t>[]> mTailReady;
+  std::atomic<uint64_t> mLateTails {0};
+
+  std::thread mWorker;
+  std::mutex mWorkerLock;
+  std::condition_variable mWorkerCondVar;
+  bool mWorkerRunning {false};
+};
+
+}  // al::
+
+#endif
@@ -43,17 +43,17 @@
 	Graham Wakefield, 2010, grrrwaaa@gmail.com
 */
 
-/*
-
-*/
-#include <stdio.h>
-#include <float.h>
+#include <cmath>
+#include <limits>
 #include "al/core/math/al_Constants.hpp"
 
 namespace al {
 
 ///
+/// Cross-over shelf filter whose low and high outputs sum to an allpass
 ///
+/// For many channels, CrossoverBank in al_FilterBank.hpp computes the same
+/// output for several channels at once.
 ///
 /// @ingroup allocore
 template<typename T=double>
@@ -66,23 +66,58 @@ public:
 	Crossover(T f=(T)600, T fs=(T)44100.) { freq(f, fs); clear(); }
 
 	/// process one sample and return hi/lo shelf
-	void next(const T in, T * lo, T * hi);
+	void next(const T in, T * lo, T * hi) {
+		step(in, mZ0, mZ1, mZ2, *lo, *hi);
+	}
+
+	/// process a block of n samples. Same as calling next() for each sample
+	void process(const T * in, T * lo, T * hi, int n) {
+		T z0 = mZ0, z1 = mZ1, z2 = mZ2;
+		for (int i = 0; i < n; i++) {
+			step(in[i], z0, z1, z2, lo[i], hi[i]);
+		}
+		mZ0 = z0; mZ1 = z1; mZ2 = z2;
+	}
 
 	void clear() { mZ0=(T)0; mZ1=(T)0; mZ2=(T)0; }
 
+	/// coefficients set by freq()
+	T c0() const { return mC0; }
+	T c1() const { return mC1; }
+
+	/// offset added to the filter states to avoid denormals
+	static T denormOffset() { return std::numeric_limits<T>::epsilon() * T(2); }
+
 protected:
 	// coefficients and history
 	T mC0, mC1, mZ0, mZ1, mZ2;
 
+	void step(const T in, T &z0, T &z1, T &z2, T &lo, T &hi) const {
+		const T v0 = in - mC0 * z0;
+		const T x0 = z0 + mC0 * v0;
+
+		const T v1 = mC1 * (in - z1);
+		const T x1 = v1 + z1;
+
+		const T v2 = mC1 * (x1 - z2);
+		const T x2 = v2 + z2;
+
+		z0 = v0 + denormOffset();
+		z1 = v1 + x1 + denormOffset();
+		z2 = v2 + x2 + denormOffset();
+
+		lo = x2;
+		hi = x0 - x2;
+	}
 };
 
 
 template<>
-void Crossover<double> :: freq(double f, double fs) {
+inline void Crossover<double> :: freq(double f, double fs) {
 	double rad = M_PI * 2. * f / fs;
 	double cosine = cos(rad);
 	double sine = sin(rad);
-	if (abs(c) > 0.0001) {
+	if (std::fabs(cosine) > 0.0001) {
 		mC0 = (sine - 1.)/cosine;
 	} else {
 		mC0 = cosine * 0.5;
@@ -91,28 +126,7 @@ void Crossover<double> :: freq(double f, double fs) {
 }
 
 template<>
-inline void Crossover<double> :: next(const double in, double * lo, double * hi) {
-	static const double denorm_offset = DBL_EPSILON*2.;
-
-	const double v0 = in - mC0 * mZ0;
-	const double x0 = mZ0 + mC0 * v0;
-
-	const double v1 = mC1 * (in - mZ1);
-	const double x1 = v1 + mZ1;
-
-	const double v2 = mC1 * (x1 - mZ2);
-	const double x2 = v2 + mZ2;
-
-	mZ0 = v0 + denorm_offset;
-	mZ1 = v1 + x1 + denorm_offset;
-	mZ2 = v2 + x2 + denorm_offset;
-
-	*lo = x2;
-	*hi = x0 - x2;
-}
-
-template<>
-void Crossover<float> :: freq(float f, float fs) {
+inline void Crossover<float> :: freq(float f, float fs) {
 	float rad = M_PI * 2.f * f / fs;
 	float cosine = cosf(rad);
 	float sine = sinf(rad);
@@ -121,28 +135,7 @@ void Crossover<float> :: freq(float f, float fs) {
 	} else {
 		mC0 = cosine * 0.5f;
 	}
-	mC1 = (1f + mC0) * 0.5f;
-}
-
-template<>
-inline void Crossover<float> :: next(const float in, float * lo, float * hi) {
-	static const float denorm_offset = FLT_EPSILON*2.;
-
-	const float v0 = in - mC0 * mZ0;
-	const float x0 = mZ0 + mC0 * v0;
-
-	const float v1 = mC1 * (in - mZ1);
-	const float x1 = v1 + mZ1;
-
-	const float v2 = mC1 * (x1 - mZ2);
-	const float x2 = v2 + mZ2;
-
-	mZ0 = v0 + denorm_offset;
-	mZ1 = v1 + x1 + denorm_offset;
-	mZ2 = v2 + x2 + denorm_offset;
-
-	*lo = x2;
-	*hi = x0 - x2;
+	mC1 = (1.f + mC0) * 0.5f;
 }
 
 } // al::
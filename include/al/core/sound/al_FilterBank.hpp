@@ -0,0 +1,212 @@
+#ifndef INCLUDE_AL_FILTERBANK_HPP
+#define INCLUDE_AL_FILTERBANK_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012-2019. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+	File description:
+	Banks of biquad and crossover filters processing several channels at a time
+	using SIMD instructions
+*/
+
+#include <vector>
+
+namespace al {
+
+struct FilterBankKernels;
+
+/**
+ * @brief Base of filter banks that run one filter per channel
+ *
+ * Channels are processed in groups of lanes() channels, one channel in each
+ * lane of a SIMD register: 8 with AVX, 4 with SSE2 or NEON and 1 otherwise.
+ * Coefficients and states are stored structure-of-arrays across the channels
+ * of a group. AVX kernels are compiled separately and only used when the CPU
+ * supports them. Every instruction set gives the same results, bit for bit,
+ * as the per-sample functions.
+ *
+ * @ingroup allocore
+ */
+class FilterBank {
+public:
+  unsigned int numChannels() const { return mChannels; }
+
+  /// Channels processed at a time by this bank
+  unsigned int lanes() const;
+
+  /// Name of the instruction set used by banks resized from now on: "AVX",
+  /// "SSE2", "NEON" or "scalar"
+  static const char *instructionSet();
+
+  /// Instruction sets available on this machine, fastest first
+  static std::vector<const char *> instructionSets();
+
+  /**
+   * @brief Select the instruction set for banks resized from now on
+   *
+   * The fastest available instruction set is used by default. This is
+   * meant for testing and benchmarking.
+   * @return false if the instruction set is not available
+   */
+  static bool useInstructionSet(const char *name);
+
+protected:
+  FilterBank();
+
+  // Picks the kernels and returns the number of channel groups
+  unsigned int setup(unsigned int numChannels);
+
+  // Frames processed at a time in process(). Samples of a group are
+  // interleaved into buffers on the stack of this many frames.
+  static const unsigned int CHUNK = 64;
+
+  const FilterBankKernels *mKernels;
+  unsigned int mChannels {0};
+};
+
+/**
+ * @brief Cascades of biquad filters, one per channel
+ *
+ * Each channel runs numStages biquads in transposed direct form II:
+ * @code
+ *   y = b0 * x + z1;
+ *   z1 = b1 * x - a1 * y + z2;
+ *   z2 = b2 * x - a2 * y;
+ * @endcode
+ *
+ * Two Butterworth stages give the Linkwitz-Riley filters used for bass
+ * management:
+ * @code
+ *   BiquadBank lowpass(numChannels, 2);
+ *   lowpass.lowpass(80, sampleRate);
+ *   lowpass.process(in, out, numChannels, numFrames);
+ * @endcode
+ *
+ * @ingroup allocore
+ */
+class BiquadBank : public FilterBank {
+public:
+  BiquadBank(unsigned int numChannels = 0, unsigned int numStages = 1);
+
+  /// Set the number of channels and stages. Coefficients and states are reset
+  void resize(unsigned int numChannels, unsigned int numStages = 1);
+
+  /// Set the coefficients of one stage of one channel. a0 is 1.
+  void coefficients(unsigned int channel, unsigned int stage, float b0,
+                    float b1, float b2, float a1, float a2);
+
+  /// Set all stages of all channels to a Butterworth low pass
+  void lowpass(double frequency, double sampleRate);
+
+  /// Set all stages of all channels to a Butterworth high pass
+  void highpass(double frequency, double sampleRate);
+
+  /// Clear the filter states
+  void clear();
+
+  /// Filter one sample of one channel
+  float next(unsigned int channel, float in);
+
+  /**
+   * @brief Filter blocks of audio
+   * @param[in] in one buffer per channel
+   * @param[out] out one buffer per channel, can be the same as in
+   * @param[in] numChannels channels past the bank's channels are not processed
+   * @param[in] numFrames frames in each buffer
+   */
+  void process(const float *const *in, float *const *out,
+               unsigned int numChannels, unsigned int numFrames);
+
+  unsigned int numStages() const { return mStages; }
+
+private:
+  // Coefficient k of a stage is at mCoefs[((group * stages + stage) * 5 + k)
+  // * lanes + lane] and state k at the same place in mStates with 2 values
+  float *coef(unsigned int channel, unsigned int stage);
+  float *state(unsigned int channel, unsigned int stage);
+  void butterworth(double frequency, double sampleRate, bool lowpass);
+
+  unsigned int mStages {0};
+  std::vector<float> mCoefs;
+  std::vector<float> mStates;
+};
+
+/**
+ * @brief Crossover filters, one per channel
+ *
+ * Each channel gives the same output, bit for bit, as a Crossover<float>
+ * with the same frequency.
+ *
+ * @ingroup allocore
+ */
+class CrossoverBank : public FilterBank {
+public:
+  CrossoverBank(unsigned int numChannels = 0);
+
+  /// Set the number of channels. Frequencies and states are reset
+  void resize(unsigned int numChannels);
+
+  /// Set the crossover frequency of all channels
+  void freq(float frequency, float sampleRate);
+
+  /// Set the crossover frequency of one channel
+  void freq(unsigned int channel, float frequency, float sampleRate);
+
+  /// Clear the filter states
+  void clear();
+
+  /// Filter one sample of one channel
+  void next(unsigned int channel, float in, float &lo, float &hi);
+
+  /**
+   * @brief Split blocks of audio into low and high bands
+   * @param[in] in one buffer per channel
+   * @param[out] lo one buffer per channel, can be the same as in
+   * @param[out] hi one buffer per channel
+   * @param[in] numChannels channels past the bank's channels are not processed
+   * @param[in] numFrames frames in each buffer
+   */
+  void process(const float *const *in, float *const *lo, float *const *hi,
+               unsigned int numChannels, unsigned int numFrames);
+
+private:
+  // c0 and c1 of a channel are at mCoefs[(group * 2 + k) * lanes + lane] and
+  // its three states at mStates[(group * 3 + k) * lanes + lane]
+  std::vector<float> mCoefs;
+  std::vector<float> mStates;
+};
+
+}  // al::
+
+#endif
@@ -78,6 +78,15 @@ public:
 	/// Get absolute index of write tap
 	int pos() const { return mPos; }
 
+	/// Get pointer to the elements
+	T * elems(){ return mBuf; }
+	const T * elems() const { return mBuf; }
+
+	/// Move write tap forward by n elements, at most size(), without writing
+	void advance(int n){
+		mPos += n; if(mPos >= size()) mPos -= size();
+	}
+
 
 	/// Read value at delay i
 	const T& read(int i) const {
@@ -227,6 +236,103 @@ public:
 				- mDly22.read(121)) * gain;
 	}
 
+	/// Compute wet stereo output from a block of dry mono input
+
+	/// The output is the same as calling operator() for each sample. The input
+	/// diffusion is applied to chunks of samples one stage at a time. The tank
+	/// is run in runs of samples in which none of its delay-lines wrap, so
+	/// positions are only checked between runs.
+	///
+	/// @param[ in] in		dry input samples
+	/// @param[out] out1	wet output samples 1
+	/// @param[out] out2	wet output samples 2
+	/// @param[ in] n		number of samples
+	/// @param[ in] gain	gain of output
+	void process(const T * in, T * out1, T * out2, int n, T gain = T(0.6)){
+		const T dfDcy1 = -mDfDcy1, dfDcy2 = mDfDcy2;
+		const T decay = mDecay;
+		// Local copies of the one-pole filters, kept in registers
+		OnePole op1 = mOP1, op2 = mOP2;
+		T x[64];
+		while(n > 0){
+			const int chunk = n < 64 ? n : 64;
+			for(int k = 0; k < chunk; ++k) x[k] = in[k] * T(0.5);
+			delay(mPreDelay, x, chunk);
+			for(int k = 0; k < chunk; ++k) x[k] = mOPIn(x[k]);
+			allpass(mAPIn1, x, chunk, mDfIn1);
+			allpass(mAPIn2, x, chunk, mDfIn1);
+			allpass(mAPIn3, x, chunk, mDfIn2);
+			allpass(mAPIn4, x, chunk, mDfIn2);
+
+			for(int done = 0; done < chunk;){
+				Run run(chunk - done);
+				const T * v = x + done;
+				const T * back12 = run.tap(mDly12, mDly12.size()-1);
+				const T * back22 = run.tap(mDly22, mDly22.size()-1);
+				T * apDecay11 = run.writer(mAPDecay11);
+				T * dly11 = run.writer(mDly11);
+				T * apDecay12 = run.writer(mAPDecay12);
+				T * dly12 = run.writer(mDly12);
+				T * apDecay21 = run.writer(mAPDecay21);
+				T * dly21 = run.writer(mDly21);
+				T * apDecay22 = run.writer(mAPDecay22);
+				T * dly22 = run.writer(mDly22);
+
+				// Output taps, read after the writes of each sample
+				const T * o1a = run.tap(mDly21, 266, 1);
+				const T * o1b = run.tap(mDly21, 2974, 1);
+				const T * o1c = run.tap(mAPDecay22, 1913, 1);
+				const T * o1d = run.tap(mDly22, 1996, 1);
+				const T * o1e = run.tap(mDly11, 1990, 1);
+				const T * o1f = run.tap(mAPDecay12, 187, 1);
+				const T * o1g = run.tap(mDly12, 1066, 1);
+				const T * o2a = run.tap(mDly11, 353, 1);
+				const T * o2b = run.tap(mDly11, 3627, 1);
+				const T * o2c = run.tap(mAPDecay12, 1228, 1);
+				const T * o2d = run.tap(mDly12, 2673, 1);
+				const T * o2e = run.tap(mDly21, 2111, 1);
+				const T * o2f = run.tap(mAPDecay22, 335, 1);
+				const T * o2g = run.tap(mDly22, 121, 1);
+
+				const int len = run.size();
+				T * o1 = out1 + done;
+				T * o2 = out2 + done;
+				for(int k = 0; k < len; ++k){
+					T a = v[k] + back22[k] * decay;
+					T b = v[k] + back12[k] * decay;
+
+					a = allpass(apDecay11[k], a, dfDcy1);
+					T d = dly11[k]; dly11[k] = a; a = d;
+					a = op1(a) * decay;
+					a = allpass(apDecay12[k], a, dfDcy2);
+					dly12[k] = a;
+
+					b = allpass(apDecay21[k], b, dfDcy1);
+					d = dly21[k]; dly21[k] = b; b = d;
+					b = op2(b) * decay;
+					b = allpass(apDecay22[k], b, dfDcy2);
+					dly22[k] = b;
+
+					o1[k] = (o1a[k] + o1b[k] - o1c[k] + o1d[k] - o1e[k] - o1f[k] - o1g[k]) * gain;
+					o2[k] = (o2a[k] + o2b[k] - o2c[k] + o2d[k] - o2e[k] - o2f[k] - o2g[k]) * gain;
+				}
+
+				mAPDecay11.advance(len);
+				mDly11.advance(len);
+				mAPDecay12.advance(len);
+				mDly12.advance(len);
+				mAPDecay21.advance(len);
+				mDly21.advance(len);
+				mAPDecay22.advance(len);
+				mDly22.advance(len);
+				done += len;
+			}
+			in += chunk; out1 += chunk; out2 += chunk;
+			n -= chunk;
+		}
+		mOP1 = op1; mOP2 = op2;
+	}
+
 	/// Compute wet/dry mix stereo output from dry mono input
 
 	/// @param[in,out] inout1		the input sample and wet/dry output 1
@@ -273,6 +379,70 @@ protected:
 		T mO1, mA0, mB1;
 	};
 
+	// Run of samples in which the elements of each delay-line used by
+	// process() are at fixed offsets from their first position. The run is
+	// shortened so that none of them pass the end of their buffer.
+	class Run{
+	public:
+		Run(int n): mLen(n){}
+
+		int size() const { return mLen; }
+
+		/// Element at the write tap
+		template <int N>
+		T * writer(StaticDelayLine<N,T>& d){ return at(d, d.pos()); }
+
+		/// Element at delay i, before (after = 0) or after (after = 1) the
+		/// write of the same sample
+		template <int N>
+		const T * tap(StaticDelayLine<N,T>& d, int i, int after = 0){
+			int ind = d.pos() + after - i;
+			if(ind < 0) ind += N;
+			else if(ind >= N) ind -= N;
+			return at(d, ind);
+		}
+
+	private:
+		template <int N>
+		T * at(StaticDelayLine<N,T>& d, int ind){
+			if(N - ind < mLen) mLen = N - ind;
+			return d.elems() + ind;
+		}
+		int mLen;
+	};
+
+	// Same as StaticDelayLine::allpass() on the element at the write tap
+	static T allpass(T& elem, T v, T ffd){
+		T d = elem;
+		T r = v + d*(-ffd);
+		elem = r;
+		return d + r*ffd;
+	}
+
+	// Same as StaticDelayLine::operator() on each of n samples, in place
+	template <int N>
+	static void delay(StaticDelayLine<N,T>& dl, T * x, int n){
+		while(n > 0){
+			T * e = dl.elems() + dl.pos();
+			const int len = n < N - dl.pos() ? n : N - dl.pos();
+			for(int k = 0; k < len; ++k){ T d = e[k]; e[k] = x[k]; x[k] = d; }
+			dl.advance(len);
+			x += len; n -= len;
+		}
+	}
+
+	// Same as StaticDelayLine::allpass() on each of n samples, in place
+	template <int N>
+	static void allpass(StaticDelayLine<N,T>& dl, T * x, int n, T ffd){
+		while(n > 0){
+			T * e = dl.elems() + dl.pos();
+			const int len = n < N - dl.pos() ? n : N - dl.pos();
+			for(int k = 0; k < len; ++k) x[k] = allpass(e[k], x[k], ffd);
+			dl.advance(len);
+			x += len; n -= len;
+		}
+	}
+
 	T mDfIn1, mDfIn2, mDfDcy1, mDfDcy2, mDecay;
 
 	StaticDelayLine<  10,T> mPreDelay;
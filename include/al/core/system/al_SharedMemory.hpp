@@ -0,0 +1,308 @@
+#ifndef INCLUDE_AL_SHARED_MEMORY_HPP
+#define INCLUDE_AL_SHARED_MEMORY_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012-2019. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+	File description:
+	Frame ring in POSIX shared memory for passing state between processes
+	running on the same host
+*/
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace al {
+
+/**
+ * @brief Single writer, multiple reader ring of fixed size frames placed in
+ * POSIX shared memory.
+ *
+ * Each slot in the ring is protected by a sequence lock, so the writer never
+ * blocks on readers. Readers register a cursor in the shared segment and
+ * consume frames in order, or skip directly to the latest frame. A reader
+ * that falls more than numSlots() behind the writer is moved forward and the
+ * skipped frames are counted as overruns.
+ *
+ * Readers can block in wait() until a new frame is published. On Linux this
+ * uses a futex on the shared segment, on other POSIX systems it falls back to
+ * short sleeps. Shared memory is not available on Windows, create() and
+ * open() will return false there.
+ *
+ * @code
+    // Writer process
+    SharedMemoryRing ring;
+    ring.create("my_ring", sizeof(State));
+    ring.publish(&state, sizeof(State));
+
+    // Reader process
+    SharedMemoryRing ring;
+    ring.open("my_ring");
+    int reader = ring.addReader();
+    if (ring.wait(reader, 0.1)) {
+      ring.consume(reader, &state, sizeof(State));
+    }
+ * @endcode
+ *
+ * @ingroup allocore
+ */
+class SharedMemoryRing {
+public:
+
+  SharedMemoryRing() {}
+  ~SharedMemoryRing();
+
+  SharedMemoryRing(const SharedMemoryRing &) = delete;
+  SharedMemoryRing &operator=(const SharedMemoryRing &) = delete;
+
+  /**
+   * @brief Create a new shared segment. Will replace an existing segment
+   * with the same name.
+   * @param name name of the segment. A leading '/' is added if missing
+   * @param slotSize maximum size in bytes of each frame
+   * @param numSlots number of frames held in the ring
+   * @param maxReaders maximum number of simultaneous readers
+   * @return true if segment was created and mapped
+   */
+  bool create(std::string name, size_t slotSize,
+              unsigned int numSlots = 8, unsigned int maxReaders = 16);
+
+  /**
+   * @brief Map an existing segment created by another process.
+   * @return false if the segment does not exist or is not a valid ring
+   */
+  bool open(std::string name);
+
+  /// Unmap the segment. Removes the readers added through this object, and
+  /// the segment name if this object created it.
+  void close();
+
+  /**
+   * @brief Check if the writer has closed the segment or replaced it with a
+   * new one under the same name, e.g. after a restart.
+   *
+   * The old mapping stays valid but no new frames will be published to it.
+   * Close and open() again to follow the writer. Makes system calls, so call
+   * it when no frames have arrived for a while rather than on every frame.
+   */
+  bool replaced() const;
+
+  bool isOpen() const { return mHeader != nullptr; }
+
+  bool isOwner() const { return mOwner; }
+
+  size_t slotSize() const;
+  unsigned int numSlots() const;
+  unsigned int maxReaders() const;
+
+  /**
+   * @brief Write a frame to the ring and wake waiting readers.
+   *
+   * The futex is only woken if a reader is blocked in wait(), so publishing
+   * to a ring no one waits on makes no system call.
+   * @return false if size is larger than slotSize() or ring is not open
+   *
+   * Only one thread in one process may publish to a ring.
+   */
+  bool publish(const void *data, size_t size);
+
+  /// Number of frames published since the ring was created
+  uint64_t framesPublished() const;
+
+  /**
+   * @brief Register a reader cursor in the segment.
+   * @return reader id to use in calls to consume(), or -1 if all reader slots
+   * are taken. The new reader starts at the current write position.
+   *
+   * Readers are removed by removeReader() or close(). Slots left by processes
+   * that exited without removing their readers are reclaimed when all slots
+   * are taken.
+   */
+  int addReader();
+
+  void removeReader(int reader);
+
+  /**
+   * @brief Copy the next unread frame for this reader.
+   * @param size if not nullptr, receives the size of the frame
+   * @return true if a frame was copied
+   */
+  bool consume(int reader, void *dest, size_t maxSize, size_t *size = nullptr);
+
+  /**
+   * @brief Copy the most recent frame, skipping any older unread frames.
+   * @return number of frames that had been published since the last call,
+   * 0 if there was no new frame.
+   */
+  int consumeLatest(int reader, void *dest, size_t maxSize, size_t *size = nullptr);
+
+  /// Number of frames published that reader has not consumed yet
+  uint64_t pending(int reader) const;
+
+  /// Number of frames dropped because reader fell behind the writer
+  uint64_t overruns(int reader) const;
+
+  /**
+   * @brief Block until a frame not yet consumed by reader is available
+   * @param timeoutSec maximum time to wait
+   * @return true if a frame is available
+   */
+  bool wait(int reader, double timeoutSec);
+
+private:
+  struct Header;
+  struct Reader;
+  struct Slot;
+
+  Reader *reader(int index) const;
+  Slot *slot(uint64_t frame) const;
+  bool readFrame(uint64_t frame, void *dest, size_t maxSize, size_t *size);
+
+  std::string mName;
+  Header *mHeader {nullptr};
+  size_t mMappedSize {0};
+  bool mOwner {false};
+  uint64_t mDevice {0}; // Identity of the mapped segment
+  uint64_t mInode {0};
+  std::vector<int> mReaders; // Added through this object
+};
+
+/**
+ * @brief Publishes a state object through a SharedMemoryRing
+ *
+ * Equivalent to cuttlebone's Maker for processes on the same host. TState
+ * must be safe to copy with memcpy.
+ */
+template<class TState>
+class SharedStateMaker {
+public:
+  SharedStateMaker(std::string name, unsigned int numSlots = 4) :
+    mName(name), mNumSlots(numSlots) {}
+
+  bool start() { return mRing.create(mName, sizeof(TState), mNumSlots); }
+
+  void stop() { mRing.close(); }
+
+  void set(const TState &state) { mRing.publish(&state, sizeof(TState)); }
+
+  SharedMemoryRing &ring() { return mRing; }
+
+private:
+  std::string mName;
+  unsigned int mNumSlots;
+  SharedMemoryRing mRing;
+};
+
+/**
+ * @brief Receives state objects published by a SharedStateMaker
+ *
+ * Equivalent to cuttlebone's Taker for processes on the same host. If the
+ * maker has not created the segment when start() is called, get() will keep
+ * trying to attach. If no state arrives for half a second, get() checks
+ * whether the maker has created a new segment and attaches to it.
+ */
+template<class TState>
+class SharedStateTaker {
+public:
+  SharedStateTaker(std::string name) : mName(name) {}
+
+  ~SharedStateTaker() { stop(); }
+
+  bool start() { return attach(); }
+
+  void stop() {
+    if (mRing.isOpen() && mReader >= 0) {
+      mRing.removeReader(mReader);
+    }
+    mReader = -1;
+    mRing.close();
+  }
+
+  /**
+   * @brief Copy latest state
+   * @return number of states published since last call
+   */
+  int get(TState &state) {
+    if (mReader < 0 && !attach()) {
+      return 0;
+    }
+    int count = mRing.consumeLatest(mReader, &state, sizeof(TState));
+    if (count > 0) {
+      mLastState = std::chrono::steady_clock::now();
+    } else if (std::chrono::steady_clock::now() - mLastState > std::chrono::milliseconds(500)) {
+      mLastState = std::chrono::steady_clock::now();
+      if (mRing.replaced()) {
+        stop();
+        attach();
+      }
+    }
+    return count;
+  }
+
+  /// Block until a new state is available or timeout expires
+  bool wait(double timeoutSec) {
+    if (mReader < 0 && !attach()) {
+      return false;
+    }
+    return mRing.wait(mReader, timeoutSec);
+  }
+
+  SharedMemoryRing &ring() { return mRing; }
+
+private:
+  bool attach() {
+    if (!mRing.isOpen() && !mRing.open(mName)) {
+      return false;
+    }
+    if (mRing.slotSize() < sizeof(TState)) {
+      mRing.close();
+      return false;
+    }
+    mReader = mRing.addReader();
+    mLastState = std::chrono::steady_clock::now();
+    return mReader >= 0;
+  }
+
+  std::string mName;
+  SharedMemoryRing mRing;
+  int mReader {-1};
+  std::chrono::steady_clock::time_point mLastState;
+};
+
+} // al::
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef INCLUDE_AL_TRIPLE_BUFFER_HPP
+#define INCLUDE_AL_TRIPLE_BUFFER_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012-2019. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+	File description:
+	Three buffers passing the latest value from one thread to another
+	without locking
+*/
+
+#include <atomic>
+#include <cstdint>
+
+namespace al {
+
+/**
+ * @brief Single writer, single reader triple buffer
+ *
+ * The writer fills the write buffer and publishes it. The reader updates to
+ * the most recently published buffer and reads it for as long as it needs.
+ * Neither side ever waits for the other or copies data: publishing and
+ * updating only swap buffer indices. Values published while the reader is
+ * not updating are dropped, so the reader always sees the latest complete
+ * value.
+ *
+ * @ingroup allocore
+ */
+template<class T>
+class TripleBuffer {
+public:
+
+  TripleBuffer(const T &initial = T()) {
+    for (auto &b : mBuffers) {
+      b = initial;
+    }
+  }
+
+  TripleBuffer(const TripleBuffer &) = delete;
+  TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+  /// Buffer to fill before publish(). Writer thread only
+  T &writeBuffer() { return mBuffers[mWrite]; }
+
+  /// Make the write buffer available to the reader. Writer thread only
+  void publish() {
+    mWrite = mMiddle.exchange(uint8_t(mWrite | FRESH), std::memory_order_acq_rel) & INDEX;
+  }
+
+  /// Switch to the latest published buffer. Reader thread only
+
+  /// Returns false and keeps the current read buffer if nothing was
+  /// published since the last update.
+  bool update() {
+    if (!(mMiddle.load(std::memory_order_relaxed) & FRESH)) {
+      return false;
+    }
+    mRead = mMiddle.exchange(mRead, std::memory_order_acq_rel) & INDEX;
+    return true;
+  }
+
+  /// Buffer last obtained with update(). Reader thread only
+  const T &readBuffer() const { return mBuffers[mRead]; }
+
+  /// Set all buffers. Must not be called while other threads use the buffer
+  void reset(const T &value) {
+    for (auto &b : mBuffers) {
+      b = value;
+    }
+    mWrite = 0;
+    mRead = 2;
+    mMiddle.store(1, std::memory_order_relaxed);
+  }
+
+private:
+  static const uint8_t INDEX = 3;
+  static const uint8_t FRESH = 4;
+
+  T mBuffers[3];
+  uint8_t mWrite {0};
+  uint8_t mRead {2};
+  alignas(64) std::atomic<uint8_t> mMiddle {1};
+};
+
+} // al::
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef INC_GLV_BATCH_H
+#define INC_GLV_BATCH_H
+
+/*	Graphics Library of Views (GLV) - GUI Building Toolkit
+	See COPYRIGHT file for authors and license information */
+
+#include <vector>
+#include "al/core/graphics/al_Mesh.hpp"
+#include "al/core/types/al_Color.hpp"
+
+namespace glv {
+
+/// List of colored vertices, three per triangle
+struct BatchVertices{
+	std::vector<al::Vec3f> positions;
+	std::vector<al::Color> colors;
+
+	void clear(){ positions.clear(); colors.clear(); }
+	int size() const { return int(positions.size()); }
+};
+
+
+/// Geometry of a View kept between frames, rebuilt only when it changes
+struct DrawCache{
+	BatchVertices vertices;
+	bool dirty = true;				// rebuild requested
+	unsigned flags = 0;				// state the geometry was built with
+	float w = -1, h = -1;
+	al::Color colors[5];
+};
+
+
+/// Accumulates GLV geometry for drawing the whole GUI in one call
+
+/// All primitives, including lines and font strokes, are turned into colored
+/// triangles in pixel coordinates, so the frame can be streamed into one
+/// vertex buffer and drawn with a single draw call. Geometry is generated
+/// on the CPU only, so it can be built and measured without a GL context.
+class DrawBatch{
+public:
+
+	DrawBatch();
+
+	/// Start a new frame, clearing geometry and drawing state
+	void reset();
+
+	/// Set color of subsequent primitives
+	void color(const al::Color& c){ mColor = c; }
+
+	/// Set width, in pixels, of subsequent lines
+	void lineWidth(float v){ mLineWidth = v; }
+
+	void pushMatrix();
+	void popMatrix();
+	void loadIdentity();
+	void translate(float x, float y);
+	void rotate(float degrees);		///< Rotate about the z axis
+
+	/// Add filled rectangle
+	void rectangle(float l, float t, float r, float b);
+
+	/// Add rectangle outline, with edges centered on the given coordinates
+	void frame(float l, float t, float r, float b);
+
+	/// Add line segment
+	void line(float x0, float y0, float x1, float y1);
+
+	/// Add line segments between pairs of vertices
+	void lines(const al::Vec3f * vertices, int count);
+
+	/// Add grid lines dividing a rectangle
+	void grid(float l, float t, float w, float h, float divx, float divy, bool incEnds=true);
+
+	/// Redirect primitives to a vertex list, such as a View's cache
+
+	/// Passing nullptr restores output to the frame geometry.
+	///
+	void target(BatchVertices * v){ mTarget = v ? v : &mFrame; }
+
+	/// Append vertices to the frame geometry, translated by (dx, dy)
+	void append(const BatchVertices& v, float dx, float dy);
+
+	/// Get geometry of the frame as a triangle mesh
+	const BatchVertices& vertices() const { return mFrame; }
+
+	/// Get number of Views whose geometry was rebuilt this frame
+	int rebuilt() const { return mRebuilt; }
+	void countRebuilt(){ ++mRebuilt; }
+
+private:
+	struct Transform{
+		float m[6];	// 2x3 affine matrix, row major
+		void apply(float& x, float& y) const {
+			float tx = m[0]*x + m[1]*y + m[2];
+			y = m[3]*x + m[4]*y + m[5];
+			x = tx;
+		}
+	};
+
+	BatchVertices mFrame;
+	BatchVertices * mTarget;
+	std::vector<Transform> mStack;
+	al::Color mColor;
+	float mLineWidth;
+	int mRebuilt;
+
+	void quad(float x0, float y0, float x1, float y1,
+			  float x2, float y2, float x3, float y3);
+};
+
+} // glv::
+
+#endif
@@ -12,6 +12,7 @@
 #include "al/glv/glv_notification.h"
 // #include "al/glv/glv_color.h"
 #include "al/core/types/al_Color.hpp"
+#include "al/glv/glv_batch.h"
 #include "al/glv/glv_font.h"
 #include "al/glv/glv_model.h"
 #include "al/glv/glv_util.h"
@@ -527,12 +528,22 @@ public:
 	View& anchor(space_t mx, space_t my);		///< Set translation factors relative to parent resize amount
 	View& anchor(Place::t parentPlace);			///< Set translation factors relative to parent resize amount
 
+	/// Request the View's geometry to be rebuilt on the next frame
+
+	/// Views with cached drawing are rebuilt automatically when their size,
+	/// properties or colors change, when their value or selection changes
+	/// and when they receive events. Call this when drawing depends on other
+	/// state.
+	View& dirty(){ mDrawCache.dirty = true; return *this; }
+
 	View& disable(Property::t p);				///< Disable property flag(s)
 	View& enable(Property::t p);				///< Enable property flag(s)
 	View& property(Property::t p, bool v);		///< Set property flag(s) to a specfic value	
 	View& toggle(Property::t p);				///< Toggle property flag(s)
 
 	View& bringToFront();						///< Brings to front of parent View
+	View& cacheDrawing(bool v);					///< Set whether to keep geometry between frames
+	bool cacheDrawing() const { return mCacheDrawing; }	///< Get whether geometry is kept between frames
 	View& cloneStyle();							///< Creates own copy of current style
 	void constrainWithinParent();				///< Force to remain in parent	
 
@@ -599,6 +610,8 @@ protected:
 	space_t mStretchX, mStretchY;	// Stretch factors when parent is resized				
 	std::string mName;				// Settable name identifier
 	std::string mDescriptor;		// String describing view
+	DrawCache mDrawCache;			// Geometry from last frame
+	bool mCacheDrawing = false;		// Whether to reuse geometry between frames
 
 //	space_t mScale;
 //	space_t mTranslate[2];
@@ -614,6 +627,7 @@ protected:
 //	}
 
 	void doDraw(GLV& g);
+	bool drawingChanged();			// Whether geometry must be rebuilt, updates cache state
 //	bool doEventHandlers(View& v, Event::t e);
 	bool hasName() const { return ""!=mName; }
 	void reanchor(space_t dx, space_t dy);	// Reanchor when parent resizes
@@ -668,6 +682,9 @@ public:
 	/// Get reference to temporary graphics data for rendering
 	al::Mesh& graphicsData(int i=0){ return mGraphicsData[i]; }
 
+	/// Get geometry of all Views built by the last drawWidgets()
+	DrawBatch& drawBatch(){ return mDrawBatch; }
+
 
 	/// Sends an event to everyone in tree (including self)
 	void broadcastEvent(Event::t e);
@@ -680,7 +697,11 @@ public:
 	virtual void drawGLV(unsigned contextWidth, unsigned contextHeight, double dsec);
 	
 	/// Draws all active widgets in the GLV
-	
+
+	/// This builds the geometry of all Views into drawBatch() without
+	/// making any GL calls. Views with cached drawing only rebuild their
+	/// geometry when it changes.
+	///
 	/// @param[in] contextWidth		width of context, in pixels
 	/// @param[in] contextHeight	height of context, in pixels
 	/// @param[in] dsec				change in seconds from last call to this method
@@ -763,6 +784,7 @@ protected:
 	Event::t mEventType;	// current event type
 	// ModelManager mMM;
 	al::Mesh mGraphicsData[2];
+	DrawBatch mDrawBatch;
 
 	// Returns whether the event should be bubbled to parent
 	bool doEventCallbacks(View& target, Event::t e);
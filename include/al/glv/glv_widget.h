@@ -85,14 +85,14 @@ public:
 
 	/// Set interval for numerical values
 	Widget& interval(const double& max, const double& min=0){
-		mInterval.endpoints(min,max); return *this;
+		mInterval.endpoints(min,max); dirty(); return *this;
 	}
 
 	/// Set padding around elements
-	Widget& padding(space_t v){ for(int i=0; i<DIMS; ++i){ mPadding[i]=v; } onResize(0,0); return *this; }
+	Widget& padding(space_t v){ for(int i=0; i<DIMS; ++i){ mPadding[i]=v; } onResize(0,0); dirty(); return *this; }
 
 	/// Set padding around elements
-	Widget& padding(space_t v, int dim){ mPadding[dim]=v; onResize(0,0); return *this; }
+	Widget& padding(space_t v, int dim){ mPadding[dim]=v; onResize(0,0); dirty(); return *this; }
 
 	/// Set padding around elements in x direction
 	Widget& paddingX(space_t v){ return padding(v,0); }
@@ -0,0 +1,293 @@
+#ifndef INCLUDE_AL_BVH_HPP
+#define INCLUDE_AL_BVH_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012-2019. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+	File description:
+	Bounding volume hierarchy for ray queries over many axis aligned boxes
+*/
+
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <thread>
+#include <vector>
+
+#include "al/core/math/al_Vec.hpp"
+#include "al/util/al_Ray.hpp"
+
+namespace al {
+
+/**
+ * @brief Bounding volume hierarchy over a set of axis aligned boxes
+ *
+ * Items are identified by their index in the vector passed to build(). The
+ * tree is built top down using the surface area heuristic (SAH). When an
+ * item moves, update() refits the boxes on the path from its leaf to the
+ * root, which keeps queries correct but can make the tree less efficient
+ * over time. cost() measures this, and rebuildAsync() builds a new tree
+ * from the current boxes in a background thread, which is swapped in by
+ * finishRebuild().
+ *
+ * This class does not use OpenGL, and is not thread safe: all functions
+ * except the background build must be called from the same thread.
+ *
+ * @ingroup allocore
+ */
+class BVH {
+public:
+  struct Bounds {
+    Vec3f min {FLT_MAX, FLT_MAX, FLT_MAX};
+    Vec3f max {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    Bounds() {}
+    Bounds(const Vec3f &min_, const Vec3f &max_) : min(min_), max(max_) {}
+
+    void extend(const Bounds &b) {
+      for (int i = 0; i < 3; i++) {
+        if (b.min[i] < min[i]) min[i] = b.min[i];
+        if (b.max[i] > max[i]) max[i] = b.max[i];
+      }
+    }
+    void extend(const Vec3f &p) {
+      for (int i = 0; i < 3; i++) {
+        if (p[i] < min[i]) min[i] = p[i];
+        if (p[i] > max[i]) max[i] = p[i];
+      }
+    }
+    bool empty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+    Vec3f center() const { return (min + max) * 0.5f; }
+    float area() const {
+      if (empty()) return 0.0f;
+      Vec3f d = max - min;
+      return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+    bool operator==(const Bounds &b) const { return min == b.min && max == b.max; }
+    bool operator!=(const Bounds &b) const { return !(*this == b); }
+  };
+
+  struct Node {
+    Bounds bounds;
+    int first {0};  ///< First item for leaves, left child for inner nodes
+    int count {0};  ///< Number of items, 0 for inner nodes
+    int parent {-1};
+    bool leaf() const { return count > 0; }
+  };
+
+  /// Maximum number of items in a leaf
+  static const int maxLeafItems = 4;
+
+  BVH() {}
+  ~BVH();
+
+  BVH(const BVH &) = delete;
+  BVH &operator=(const BVH &) = delete;
+
+  /// Build the tree for the boxes given. Waits for a background build to finish
+  void build(const std::vector<Bounds> &bounds);
+
+  /// Set the box for item and refit the nodes that contain it
+  void update(int item, const Bounds &bounds);
+
+  /// Recompute the boxes of all nodes from the item boxes
+  void refit();
+
+  /**
+   * @brief Build a new tree from the current boxes in a background thread
+   *
+   * Queries keep using the current tree until finishRebuild() swaps in the
+   * new one. Returns false if a build is already in progress.
+   */
+  bool rebuildAsync();
+
+  /// true while a background build is running or waiting to be swapped in
+  bool rebuilding() const { return mRebuildThread.joinable(); }
+
+  /**
+   * @brief Swap in the tree built by rebuildAsync() if it is ready
+   *
+   * Boxes updated while the background build was running are refit into the
+   * new tree. Returns true if the tree was replaced.
+   *
+   * @param wait block until the background build finishes
+   */
+  bool finishRebuild(bool wait = false);
+
+  /// Number of items
+  size_t size() const { return mItemBounds.size(); }
+
+  /// Box for item
+  const Bounds &bounds(int item) const { return mItemBounds[item]; }
+
+  /// Box that contains all items
+  Bounds bounds() const { return mNodes.size() > 0 ? mNodes[0].bounds : Bounds(); }
+
+  const std::vector<Node> &nodes() const { return mNodes; }
+
+  /// Depth of the deepest leaf
+  int depth() const;
+
+  /// Expected cost of a ray query relative to testing one box (SAH cost)
+  float cost() const;
+
+  /// cost() of the tree when it was built
+  float buildCost() const { return mBuildCost; }
+
+  /**
+   * @brief Find the nearest item hit by a ray
+   *
+   * Only items whose boxes are hit are passed to test, which must return the
+   * ray parameter of the intersection with the item, or a value <= 0 if the
+   * item is not hit. The item's box must contain the item, so that the
+   * returned value is never smaller than where the ray enters the box.
+   *
+   * @param[in] ray the ray, does not need to be normalized
+   * @param[out] t ray parameter of the nearest hit
+   * @param[in] test function with signature double test(int item)
+   * @return index of the nearest item hit, -1 if no item is hit
+   */
+  template <class ItemTest>
+  int intersect(const Rayd &ray, double &t, ItemTest test) const;
+
+  /// Indices of items whose boxes are hit by a ray, in no particular order
+  void intersectBounds(const Rayd &ray, std::vector<int> &items) const;
+
+  /// Build nodes for boxes. Used by build() and the background build
+  static void buildNodes(const std::vector<Bounds> &bounds,
+                         std::vector<Node> &nodes, std::vector<int> &items);
+
+private:
+  struct RayData {
+    Vec3f o, invDir;
+    bool parallel[3];
+  };
+
+  static void rayData(const Rayd &ray, RayData &data);
+
+  // Ray parameter where the ray enters b, -1 if it misses
+  static float enter(const RayData &ray, const Bounds &b, float tMax);
+
+  void indexLeaves();
+
+  std::vector<Node> mNodes;
+  std::vector<int> mItems;      // Item indices, grouped by leaf
+  std::vector<int> mItemLeaf;   // Leaf node for each item
+  std::vector<Bounds> mItemBounds;
+  float mBuildCost {0};
+
+  std::thread mRebuildThread;
+  std::atomic<bool> mRebuildDone {false};
+  std::vector<Node> mRebuildNodes;
+  std::vector<int> mRebuildItems;
+  std::vector<Bounds> mRebuildBounds;
+};
+
+inline float BVH::enter(const RayData &ray, const Bounds &b, float tMax) {
+  float t0 = 0.0f;
+  float t1 = tMax;
+  for (int i = 0; i < 3; i++) {
+    if (ray.parallel[i]) {
+      if (ray.o[i] < b.min[i] || ray.o[i] > b.max[i]) return -1.0f;
+      continue;
+    }
+    float tNear = (b.min[i] - ray.o[i]) * ray.invDir[i];
+    float tFar = (b.max[i] - ray.o[i]) * ray.invDir[i];
+    if (tNear > tFar) std::swap(tNear, tFar);
+    if (tNear > t0) t0 = tNear;
+    if (tFar < t1) t1 = tFar;
+    if (t0 > t1) return -1.0f;
+  }
+  return t0;
+}
+
+template <class ItemTest>
+int BVH::intersect(const Rayd &ray, double &t, ItemTest test) const {
+  t = DBL_MAX;
+  if (mNodes.size() == 0) return -1;
+  RayData r;
+  rayData(ray, r);
+
+  int hitItem = -1;
+  float tNode = enter(r, mNodes[0].bounds, FLT_MAX);
+  if (tNode < 0) return -1;
+
+  // Depth is limited when building, so a fixed size stack is enough
+  struct Entry { int node; float t; };
+  Entry stack[64];
+  int top = 0;
+  stack[top++] = {0, tNode};
+
+  while (top > 0) {
+    Entry e = stack[--top];
+    if (e.t > t) continue;
+    const Node &node = mNodes[e.node];
+    if (node.leaf()) {
+      for (int i = node.first; i < node.first + node.count; i++) {
+        int item = mItems[i];
+        if (enter(r, mItemBounds[item], FLT_MAX) < 0) continue;
+        double tItem = test(item);
+        if (tItem > 0 && tItem < t) {
+          t = tItem;
+          hitItem = item;
+        }
+      }
+      continue;
+    }
+    float tMax = t < FLT_MAX ? float(t) : FLT_MAX;
+    float tLeft = enter(r, mNodes[node.first].bounds, tMax);
+    float tRight = enter(r, mNodes[node.first + 1].bounds, tMax);
+    // Push the far child first so the near one is visited first
+    if (tLeft >= 0 && tRight >= 0) {
+      if (tLeft < tRight) {
+        stack[top++] = {node.first + 1, tRight};
+        stack[top++] = {node.first, tLeft};
+      } else {
+        stack[top++] = {node.first, tLeft};
+        stack[top++] = {node.first + 1, tRight};
+      }
+    } else if (tLeft >= 0) {
+      stack[top++] = {node.first, tLeft};
+    } else if (tRight >= 0) {
+      stack[top++] = {node.first + 1, tRight};
+    }
+  }
+  if (hitItem < 0) t = -1.0;
+  return hitItem;
+}
+
+} // al::
+
+#endif
@@ -43,12 +43,14 @@
 */
 
 #include "al/util/al_Plane.hpp"
+#include "al/core/math/al_Mat.hpp"
 #include "al/core/math/al_Vec.hpp"
 
 
 namespace al {
 
 template <class T> class Frustum;
+typedef Frustum<float> Frustumf;   ///< Single precision frustrum
 typedef Frustum<double> Frustumd;  ///< Double precision frustrum
 
 
@@ -128,6 +130,16 @@ public:
   ///
   void computePlanes();
 
+  /// Set planes and corners from a projection matrix
+
+  /// The frustum is the clip volume of m, so m is usually the projection
+  /// matrix, or the projection matrix multiplied by the view matrix for a
+  /// frustum in world coordinates. The planes are extracted directly from
+  /// the rows of m (Gribb & Hartmann), so testing against them does not
+  /// depend on how well the corners could be computed.
+  template <class U>
+  void fromMatrix(const Mat<4,U>& m);
+
 private:
   template <class Tf, class Tv>
   static Tv lerp(Tf f, const Tv& x, const Tv& y){
@@ -163,6 +175,33 @@ void Frustum<T>::computePlanes(){
   pl[FARP  ].from3Points(ftr,ftl,fbl);
 }
 
+template <class T>
+template <class U>
+void Frustum<T>::fromMatrix(const Mat<4,U>& m){
+  // Planes are (row 3) +/- (row i)
+  for(int i=0; i<3; ++i){
+    T a = m(3,0), b = m(3,1), c = m(3,2), d = m(3,3);
+    T ai = m(i,0), bi = m(i,1), ci = m(i,2), di = m(i,3);
+    int lowPlane  = i==0 ? LEFT  : i==1 ? BOTTOM : NEARP;
+    int highPlane = i==0 ? RIGHT : i==1 ? TOP    : FARP;
+    pl[lowPlane ].fromCoefficients(a + ai, b + bi, c + ci, d + di);
+    pl[highPlane].fromCoefficients(a - ai, b - bi, c - ci, d - di);
+  }
+
+  // Corners are the corners of the clip cube transformed back
+  Mat<4,T> inv;
+  for(int i=0; i<16; ++i) inv[i] = m[i];
+  if(!invert(inv)) return;
+  for(int i=0; i<8; ++i){
+    Vec<4,T> ndc(T(i&1 ? 1 : -1), T(i&2 ? -1 : 1), T(i&4 ? 1 : -1), T(1));
+    Vec<4,T> v;
+    for(int r=0; r<4; ++r){
+      v[r] = inv(r,0)*ndc[0] + inv(r,1)*ndc[1] + inv(r,2)*ndc[2] + inv(r,3)*ndc[3];
+    }
+    (&ntl)[i] = Vec<3,T>(v[0], v[1], v[2]) / v[3];
+  }
+}
+
 template <class T>
 int Frustum<T>::testPoint(const Vec<3,T>& p) const {
   for(int i=0; i<6; ++i){
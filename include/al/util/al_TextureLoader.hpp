@@ -0,0 +1,295 @@
+#ifndef INCLUDE_AL_TEXTURELOADER_HPP
+#define INCLUDE_AL_TEXTURELOADER_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012-2019. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+
+	File description:
+	Loads images in background threads and streams them to textures
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "al/core/graphics/al_BufferObject.hpp"
+#include "al/core/graphics/al_Texture.hpp"
+#include "module/img/loadImage.hpp"
+
+namespace al {
+
+/**
+ * @brief Pool of reusable pixel buffers
+ *
+ * Released buffers keep their memory and are handed out again by acquire(),
+ * so loading images of similar sizes does not allocate once the pool is warm.
+ */
+class PixelBufferPool {
+public:
+  /**
+   * @brief Get a buffer with at least size bytes of capacity
+   *
+   * If size is 0 the largest free buffer is returned, or an empty buffer if
+   * there are none.
+   */
+  std::vector<uint8_t> acquire(size_t size = 0);
+
+  /// Return a buffer to the pool
+  void release(std::vector<uint8_t> &&buffer);
+
+  /// Memory held by the pool beyond which released buffers are freed
+  void maxPooledBytes(size_t bytes) { mMaxPooledBytes = bytes; }
+
+  /// Number of buffers ready to be reused
+  size_t available();
+
+  /// Number of times acquire() could not reuse a buffer
+  size_t misses() { return mMisses.load(); }
+
+private:
+  std::mutex mLock;
+  std::vector<std::vector<uint8_t>> mBuffers;
+  size_t mPooledBytes {0};
+  size_t mMaxPooledBytes {512 * 1024 * 1024};
+  std::atomic<size_t> mMisses {0};
+};
+
+/**
+ * @brief Splits texture uploads into slices that fit a per frame byte budget
+ *
+ * Textures are uploaded in the order they were added, a group of rows at a
+ * time. At least one row is scheduled every frame, so a single row larger
+ * than the budget still makes progress.
+ *
+ * This class does not use OpenGL.
+ */
+class TextureUploadScheduler {
+public:
+  struct Slice {
+    uint64_t job;
+    unsigned int firstRow;
+    unsigned int numRows;
+    size_t bytes;
+    bool last; ///< true if this slice completes the job
+  };
+
+  /// Set maximum bytes scheduled per frame
+  void budget(size_t bytesPerFrame) { mBudget = bytesPerFrame; }
+  size_t budget() const { return mBudget; }
+
+  /// Add an upload. Returns job id
+  uint64_t add(unsigned int width, unsigned int height, unsigned int bytesPerPixel);
+
+  /// Get the slices to upload this frame
+  std::vector<Slice> nextFrame();
+
+  /// Number of jobs not completely scheduled
+  size_t pending() const { return mJobs.size(); }
+
+  /// Bytes not yet scheduled
+  size_t pendingBytes() const;
+
+private:
+  struct Job {
+    uint64_t id;
+    size_t rowBytes;
+    unsigned int height;
+    unsigned int nextRow;
+  };
+
+  std::deque<Job> mJobs;
+  size_t mBudget {8 * 1024 * 1024};
+  uint64_t mNextId {0};
+};
+
+/**
+ * @brief Reference to a texture requested from a TextureLoader
+ *
+ * Copies of a handle refer to the same texture. The texture can only be
+ * drawn once ready() is true, use textureOr() to draw a placeholder while
+ * it is pending.
+ */
+class TextureHandle {
+public:
+  enum Status {
+    PENDING,    ///< Waiting to be decoded
+    DECODED,    ///< Decoded, waiting for upload
+    UPLOADING,  ///< Partially uploaded
+    READY,      ///< Texture can be used
+    FAILED      ///< Image could not be decoded
+  };
+
+  TextureHandle() {}
+
+  Status status() const { return mState ? (Status) mState->status.load() : FAILED; }
+  bool ready() const { return status() == READY; }
+  bool pending() const { Status s = status(); return s != READY && s != FAILED; }
+  bool failed() const { return status() == FAILED; }
+  bool valid() const { return mState != nullptr; }
+
+  /// Texture. Only use from the graphics thread once ready() is true
+  Texture &texture() { return mState->texture; }
+
+  /// Texture if ready, placeholder otherwise
+  Texture &textureOr(Texture &placeholder) { return ready() ? mState->texture : placeholder; }
+
+  /// Width in pixels. 0 before the image is decoded
+  unsigned int width() const { return mState ? mState->width.load() : 0; }
+  unsigned int height() const { return mState ? mState->height.load() : 0; }
+
+  std::string path() const { return mState ? mState->path : std::string(); }
+
+  /// Decoded pixels, RGBA 8 bit. Available while status() is DECODED or UPLOADING
+  const imgModule::ImageData &image() const { return mState->image; }
+
+private:
+  friend class TextureLoader;
+
+  struct State {
+    std::atomic<int> status {PENDING};
+    std::atomic<unsigned int> width {0};
+    std::atomic<unsigned int> height {0};
+    std::string path;
+    imgModule::ImageData image;
+    Texture texture;
+    uint64_t uploadJob {0};
+  };
+
+  TextureHandle(std::shared_ptr<State> state) : mState(state) {}
+
+  std::shared_ptr<State> mState;
+};
+
+/**
+ * @brief Loads images into textures without blocking the render loop
+ *
+ * Images are decoded by a pool of worker threads into buffers taken from a
+ * PixelBufferPool. Call update() once per frame from the graphics thread to
+ * upload decoded images. Uploads go through pixel buffer objects and are
+ * limited to uploadBudget() bytes per frame.
+ *
+ * @code
+    TextureLoader loader;
+    TextureHandle image = loader.load("photo.jpg");
+
+    void onAnimate(double dt) { loader.update(); }
+
+    void onDraw(Graphics &g) {
+      image.textureOr(placeholder).bind();
+      ...
+    }
+ * @endcode
+ *
+ * Decoding does not need a graphics context, so the loader can be used
+ * headless if update() is not called.
+ */
+class TextureLoader {
+public:
+  /// Decode image file into image. Must be safe to call from several threads.
+  typedef std::function<bool(const std::string &path, imgModule::ImageData &image)> DecodeFunction;
+
+  /// @param numThreads number of decode threads. 0 uses one less than the number of cores
+  TextureLoader(unsigned int numThreads = 0);
+
+  ~TextureLoader();
+
+  /// Request an image. Returns immediately
+  TextureHandle load(const std::string &path);
+
+  /// Maximum bytes uploaded to the GPU per call to update()
+  void uploadBudget(size_t bytesPerFrame) { mScheduler.budget(bytesPerFrame); }
+  size_t uploadBudget() const { return mScheduler.budget(); }
+
+  /// Generate mipmaps for textures when their upload completes
+  void mipmaps(bool generate) { mMipmaps = generate; }
+
+  /// Replace the image decoder. Default uses imgModule::loadImage()
+  void decodeFunction(DecodeFunction function);
+
+  /**
+   * @brief Upload decoded images to textures
+   *
+   * Must be called from the graphics thread, with a valid context.
+   */
+  void update();
+
+  /// Block until all requested images have been decoded
+  void waitForDecodes();
+
+  /// Number of images waiting to be decoded
+  size_t pendingDecodes();
+
+  /// Number of images decoded but not completely uploaded
+  size_t pendingUploads();
+
+  unsigned int numThreads() const { return (unsigned int) mThreads.size(); }
+
+  PixelBufferPool &bufferPool() { return mBufferPool; }
+
+private:
+  typedef std::shared_ptr<TextureHandle::State> StatePtr;
+
+  void decoderFunction();
+  void uploadSlice(TextureHandle::State &state, const TextureUploadScheduler::Slice &slice);
+
+  std::vector<std::thread> mThreads;
+  std::mutex mLock;
+  std::condition_variable mCondition;
+  std::condition_variable mIdleCondition;
+  std::deque<StatePtr> mRequests;
+  std::deque<StatePtr> mDecoded;
+  unsigned int mBusyThreads {0};
+  bool mRunning {true};
+
+  DecodeFunction mDecodeFunction;
+  PixelBufferPool mBufferPool;
+
+  // Graphics thread only
+  TextureUploadScheduler mScheduler;
+  std::deque<StatePtr> mUploads;
+  BufferObject mPixelBuffers[2];
+  unsigned int mCurrentPixelBuffer {0};
+  bool mMipmaps {false};
+};
+
+} // al::
+
+#endif
@@ -42,12 +42,15 @@
 	Andrés Cabrera mantaraya36@gmail.com
 */
 
+#include <cstdint>
 #include <memory>
 #include <thread>
 #include <condition_variable>
 
 #include "al/core/spatial/al_Pose.hpp"
+#include "al/core/math/al_Matrix4.hpp"
 #include "al/core/math/al_Vec.hpp"
+#include "al/util/al_Frustum.hpp"
 #include "al/core/spatial/al_DistAtten.hpp"
 #include "al/core/sound/al_Speaker.hpp"
 #include "al/util/scene/al_SynthSequencer.hpp"
@@ -63,6 +66,8 @@ namespace al
  */
 class PositionedVoice : public SynthVoice {
 public:
+    PositionedVoice() { mIsPositioned = true; }
+
     Pose &pose() {return mPose;}
 
     float &size() {return mSize;}
@@ -303,6 +308,74 @@ public:
         mBusRoutingCallback = std::make_shared<BusRoutingCallback>(cb);
     }
 
+    /**
+     * @brief Skip drawing voices that are outside the view frustum
+     *
+     * A PositionedVoice is culled when a sphere at its pose() with radius
+     * setCullingRadius() * size() is outside the frustum of the projection
+     * matrix current when render(Graphics &) is called. When rendering per
+     * projection, render(Graphics &) is called for each projection, so voices
+     * are culled for each projection. Voices that are not PositionedVoice are
+     * always drawn. Culled voices are still updated, only their
+     * onProcess(Graphics &) is skipped.
+     */
+    void setFrustumCulling(bool cull) { mFrustumCulling = cull; }
+    bool frustumCulling() { return mFrustumCulling; }
+
+    /**
+     * @brief Radius of the voices' geometry before it is scaled by PositionedVoice::size()
+     *
+     * Defaults to 1.0. Use a larger value if your voices draw outside the unit sphere.
+     */
+    void setCullingRadius(float radius) { mCullingRadius = radius; }
+
+    /**
+     * @brief Don't draw positioned voices further than distance from the viewer
+     * @param distance maximum distance. 0 (the default) draws voices at any distance
+     */
+    void setMaxDrawDistance(float distance) { mMaxDrawDistance = distance; }
+
+    typedef const std::function<bool (PositionedVoice &voice, float distance)> LodCallback;
+
+    /**
+     * @brief Set a function to choose the level of detail for positioned voices
+     * @param cb function called for every positioned voice that passes the culling tests
+     *
+     * The distance from the viewer to the voice is passed to the callback,
+     * which can store it in the voice to choose what to draw. The voice is only
+     * drawn if the callback returns true.
+     */
+    void setLodCallback(LodCallback cb)
+    {
+        mLodCallback = std::make_shared<LodCallback>(cb);
+    }
+
+    struct CullingStats {
+        uint64_t tested {0};         ///< Positioned voices tested
+        uint64_t frustumCulled {0};  ///< Outside the frustum
+        uint64_t distanceCulled {0}; ///< Further than the maximum draw distance
+        uint64_t lodCulled {0};      ///< Rejected by the LOD callback
+        uint64_t drawn {0};          ///< Voices drawn or found visible, including voices that are not positioned
+    };
+
+    /// Culling counters accumulated since the last call to resetCullingStats()
+    CullingStats cullingStats() { return mCullingStats; }
+    void resetCullingStats() { mCullingStats = CullingStats(); }
+
+    /**
+     * @brief Find the active voices that should be drawn
+     * @param modelView view matrix multiplied by model matrix
+     * @param projection projection matrix
+     *
+     * Called by render(Graphics &) with the current graphics matrices when
+     * culling is enabled. Can be called without a graphics context. The result
+     * is available from visibleVoices().
+     */
+    void cullVoices(const Matrix4f &modelView, const Matrix4f &projection);
+
+    /// Voices found by the last call to cullVoices()
+    const std::vector<SynthVoice *> &visibleVoices() { return mVisibleVoices; }
+
 protected:
 
 
@@ -347,6 +420,18 @@ private:
     bool mDrawWorldMarker {false};
     Mesh mWorldMarker;
 
+    // Graphics culling
+    bool mFrustumCulling {false};
+    float mCullingRadius {1.0f};
+    float mMaxDrawDistance {0.0f};
+    std::shared_ptr<LodCallback> mLodCallback;
+    CullingStats mCullingStats;
+    std::vector<SynthVoice *> mVisibleVoices;
+
+    bool cullingEnabled() { return mFrustumCulling || mMaxDrawDistance > 0 || mLodCallback; }
+    void cull(const Matrix4f &modelView, const Matrix4f &projection); // Requires mGraphicsLock
+    void drawVoice(Graphics &g, SynthVoice *voice);
+
 };
 
 }
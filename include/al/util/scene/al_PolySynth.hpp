@@ -143,6 +143,9 @@ public:
   /// Returns true if voice is currently active
   bool active() { return mActive;}
 
+  /// Returns true if this voice is a PositionedVoice. Avoids a dynamic_cast when rendering
+  bool isPositioned() const { return mIsPositioned; }
+
   /**
      * @brief Set parameter values
      * @param pFields array containing the values
@@ -430,7 +433,7 @@ public:
 
   SynthVoice& operator<<(ParameterMeta &param) {return registerTriggerParameter(param);}
 
-  std::vector<ParameterMeta *> triggerParameters() {return mTriggerParams;}
+  const std::vector<ParameterMeta *> &triggerParameters() {return mTriggerParams;}
 
   /**
    * @brief registerParameter
@@ -494,6 +497,8 @@ protected:
   std::vector<ParameterMeta *> mContinuousParameters;
 
   std::vector<std::shared_ptr<Parameter>> mInternalParameters;
+
+  bool mIsPositioned {false}; // Set by PositionedVoice
 private:
   int mId {-1};
   int mActive {false};
@@ -0,0 +1,169 @@
+#ifndef AL_SYNTHEVENTLOG_HPP
+#define AL_SYNTHEVENTLOG_HPP
+
+/*	Allocore --
+	Multimedia / virtual environment application class library
+
+	Copyright (C) 2009. AlloSphere Research Group, Media Arts & Technology, UCSB.
+	Copyright (C) 2012-2019. The Regents of the University of California.
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice,
+		this list of conditions and the following disclaimer.
+
+		Redistributions in binary form must reproduce the above copyright
+		notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+
+		Neither the name of the University of California nor the names of its
+		contributors may be used to endorse or promote products derived from
+		this software without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+
+	File description:
+	Streaming binary log of synth events
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+#include "al/core/types/al_LockFreeQueue.hpp"
+#include "al/util/scene/al_SynthSequencer.hpp"
+
+namespace al {
+
+/**
+ * @brief Fixed size event record stored in a SynthEventLog
+ *
+ * Up to maxFields trigger parameters are stored. String parameters are
+ * stored NUL separated in text, and marked in stringMask.
+ */
+struct SynthEventRecord {
+  static const int maxFields = 16;
+
+  double time {0};
+  int32_t id {-1};
+  uint16_t type {TRIGGER_ON}; // SynthEventType
+  uint16_t numFields {0};
+  uint32_t synthIndex {0}; // Index into the log's table of synth names
+  uint32_t stringMask {0};
+  float fields[maxFields];
+  char text[40];
+};
+
+/**
+ * @brief The SynthEventLog class streams synth events to a binary file
+ *
+ * Events are pushed as fixed size records into a lock-free queue, so
+ * logTriggerOn() and logTriggerOff() can be called from the audio thread.
+ * A writer thread drains the queue and appends chunks to the log file. Each
+ * chunk carries a CRC32 of its contents and is flushed as it is written, so
+ * if the application crashes only events from the last chunk are lost.
+ *
+ * Logs can be read back with read(), converted to text using
+ * SynthRecorder::convertLog() or played directly by SynthSequencer by using
+ * the ".synthLog" extension in the sequence name.
+ *
+ * Logging does not allocate or lock. ParameterMenu trigger parameters are
+ * logged as their index and converted to text by the writer thread. The
+ * writer thread also reads ParameterString trigger parameters, a few
+ * milliseconds after the event, so a voice that is retriggered with a
+ * different string before then will log the newer string. The voices must
+ * not be deleted while the log is open.
+ */
+class SynthEventLog {
+public:
+
+  SynthEventLog(size_t queueSize = 65536);
+
+  ~SynthEventLog();
+
+  /**
+   * @brief Open a log file and start the writer thread
+   * @param append if true, add events to an existing log
+   */
+  bool open(std::string fileName, bool append = false);
+
+  /// Write pending events, close file and stop writer thread
+  void close();
+
+  bool isOpen() { return mFile != nullptr; }
+
+  /// Time after which pending events are written even if a chunk is not full
+  void setFlushInterval(double seconds) { mFlushInterval = seconds; }
+
+  /// Log a trigger on event. Safe to call from the audio thread.
+  bool logTriggerOn(SynthVoice *voice, double time);
+
+  /// Log a trigger off event. Safe to call from the audio thread.
+  bool logTriggerOff(int id, double time);
+
+  /// Number of events written to file
+  uint64_t eventsWritten() { return mEventsWritten.load(); }
+
+  /// Number of events lost because the queue was full
+  uint64_t eventsDropped() { return mEventsDropped.load(); }
+
+  /**
+   * @brief Read events from a log file.
+   * @return false if file could not be opened or is not a synth event log.
+   *
+   * Reading stops at the first corrupt or incomplete chunk. Events read
+   * before that are kept.
+   */
+  static bool read(std::string fileName, std::vector<SynthEvent> &events);
+
+  static const int recordsPerChunk = 512;
+
+private:
+  struct Entry {
+    SynthEventRecord record;
+    const std::type_info *synthType {nullptr};
+    SynthVoice *voice {nullptr}; // Set if there are string fields to read
+    uint32_t menuMask {0}; // String fields holding a ParameterMenu index
+  };
+
+  void writerFunction();
+  void resolveStrings(Entry &entry);
+  void writeNames(std::vector<std::pair<uint32_t, std::string>> &names);
+  void writeRecords(std::vector<SynthEventRecord> &records);
+  void writeChunk(uint32_t type, uint32_t count, const std::vector<char> &payload);
+
+  LockFreeQueue<Entry> mQueue;
+  FILE *mFile {nullptr};
+  std::thread mWriterThread;
+  std::atomic<bool> mRunning {false};
+  std::mutex mWriterLock;
+  std::condition_variable mWriterCondition;
+  double mFlushInterval {0.25};
+
+  std::vector<const std::type_info *> mSynthTypes; // Only touched by writer thread
+
+  std::atomic<uint64_t> mEventsWritten {0};
+  std::atomic<uint64_t> mEventsDropped {0};
+};
+
+}
+
+#endif // AL_SYNTHEVENTLOG_HPP
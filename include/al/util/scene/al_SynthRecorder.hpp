@@ -42,11 +42,14 @@
 */
 
 
+#include <atomic>
 #include <chrono>
 #include <fstream>
+#include <memory>
 
 #include "al/core/io/al_File.hpp"
 #include "al/util/scene/al_SynthSequencer.hpp"
+#include "al/util/scene/al_SynthEventLog.hpp"
 
 /**
  * @brief The SynthRecorder class records the events arriving at a PolySynth
@@ -76,6 +79,12 @@
  * enough allocated polyphony for the whole sequence or alternatively that
  * the class has been registered to the PolySynth using registerSynthClass().
  *
+ * For long recordings use the BINARY_LOG format. Events are then streamed
+ * to a ".synthLog" file as they arrive through a SynthEventLog, instead
+ * of being held in memory until stopRecord(). This avoids locking and
+ * allocating in the trigger callbacks. The log can be converted to text
+ * with convertLog() or played directly by SynthSequencer.
+ *
  * @code
  * SynthSequencer seq;
  * // Pre allocate voices
@@ -95,6 +104,7 @@ public:
         SEQUENCER_EVENT, // Events have duration (uses '@' command only)
         SEQUENCER_TRIGGERS, // Store events as they were received trigger on and trigger off can be separate entries (uses '+' and '-' text commands)
         CPP_FORMAT, // Saves code that can be copy-pasted into C++
+        BINARY_LOG, // Streams events to a binary .synthLog file while recording
         NONE
     } TextFormat;
 
@@ -118,6 +128,24 @@ public:
     void verbose(bool verbose) {mVerbose = true;}
     bool verbose() {return mVerbose;}
 
+    /**
+     * @brief Write events to a text sequence file
+     * @param polySynth if not nullptr, used to list the parameter names of
+     * the instruments at the end of the file
+     */
+    static bool writeSequence(std::vector<SynthEvent> &sequence, std::string fileName,
+                              TextFormat format, PolySynth *polySynth = nullptr);
+
+    /**
+     * @brief Convert a binary log recorded with BINARY_LOG to a text sequence
+     */
+    static bool convertLog(std::string logFileName, std::string sequenceFileName,
+                           TextFormat format = SEQUENCER_EVENT, PolySynth *polySynth = nullptr);
+
+    /// Binary event log used for BINARY_LOG format. nullptr until the first
+    /// BINARY_LOG recording is started.
+    SynthEventLog *eventLog() { return mEventLog.get(); }
+
     //	std::string lastSequenceName();
     //	std::string lastSequenceSubDir();
 
@@ -138,13 +166,14 @@ public:
     {
         std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
         SynthRecorder *rec = static_cast<SynthRecorder *>(userData);
-        if (rec->mRecording) {
+        if (rec->mRecording && rec->mFormat == BINARY_LOG) {
+            rec->startOnEvent(now);
+            std::chrono::duration<double> diff = now - rec->mSequenceStart.load();
+            rec->mEventLog->logTriggerOn(voice, diff.count());
+        } else if (rec->mRecording) {
             std::unique_lock<std::mutex> lk(rec->mSequenceLock);
-            if (rec->mStartOnEvent) {
-                rec->mSequenceStart = now;
-                rec->mStartOnEvent = false;
-            }
-            std::chrono::duration<double> diff = now - rec->mSequenceStart;
+            rec->startOnEvent(now);
+            std::chrono::duration<double> diff = now - rec->mSequenceStart.load();
             std::vector<ParameterField> pFields = voice->getTriggerParams();
 
             SynthEvent event;
@@ -171,13 +200,16 @@ public:
     static bool onTriggerOff(int id, void *userData) {
         std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
         SynthRecorder *rec = static_cast<SynthRecorder *>(userData);
-        if (rec->mRecording) {
+        if (rec->mRecording && rec->mFormat == BINARY_LOG) {
+            std::chrono::duration<double> diff = now - rec->mSequenceStart.load();
+            rec->mEventLog->logTriggerOff(id, diff.count());
+        } else if (rec->mRecording) {
             std::unique_lock<std::mutex> lk(rec->mSequenceLock);
 //            if (rec->mStartOnEvent) {
 //                rec->mSequenceStart = now;
 //                rec->mStartOnEvent = false;
 //            }
-            std::chrono::duration<double> diff = now - rec->mSequenceStart;
+            std::chrono::duration<double> diff = now - rec->mSequenceStart.load();
 
             SynthEvent event;
             event.type = SynthEventType::TRIGGER_OFF;
@@ -198,6 +230,14 @@ public:
 
 private:
 
+    // Sets the start time to the first event when recording with startOnEvent
+    void startOnEvent(std::chrono::high_resolution_clock::time_point now) {
+        bool start = true;
+        if (mStartOnEvent.compare_exchange_strong(start, false)) {
+            mSequenceStart = now;
+        }
+    }
+
     std::string mDirectory;
     PolySynth *mPolySynth {nullptr};
     TextFormat mFormat;
@@ -208,12 +248,14 @@ private:
 
     std::mutex mSequenceLock;
 
-    bool mRecording {false};
-    bool mStartOnEvent {true};
+    // Read by the trigger callbacks on the audio thread
+    std::atomic<bool> mRecording {false};
+    std::atomic<bool> mStartOnEvent {true};
 
     al_sec mMaxRecordTime;
-    std::chrono::high_resolution_clock::time_point mSequenceStart;
+    std::atomic<std::chrono::high_resolution_clock::time_point> mSequenceStart;
     std::vector<SynthEvent> mSequence;
+    std::unique_ptr<SynthEventLog> mEventLog; // Created for BINARY_LOG, as it preallocates its queue
 };
 
 // Implementation
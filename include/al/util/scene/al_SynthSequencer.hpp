@@ -246,6 +246,12 @@ public:
 
     std::string buildFullPath(std::string sequenceName);
 
+    /**
+     * @brief Load events from a sequence file
+     *
+     * Binary logs recorded by SynthEventLog are read directly if the name
+     * ends in ".synthLog".
+     */
     std::list<SynthSequencerEvent> loadSequence(std::string sequenceName, double timeOffset = 0, double timeScale = 1.0);
 
     std::vector<std::string> getSequenceList();
@@ -292,6 +298,8 @@ private:
 
     void processEvents(double blockStartTime, double fps);
 
+    std::list<SynthSequencerEvent> loadEventLog(std::string fullName, double timeOffset, double timeScale);
+
 };
 
 //  Implementations -------------
@@ -53,8 +53,7 @@
 #include "al/core/io/al_AudioIO.hpp"
 #include "al/core/types/al_SingleRWRingBuffer.hpp"
 #include "al/core/system/al_Time.hpp"
-
-#include "Gamma/Filter.h"
+#include "al/core/sound/al_FilterBank.hpp"
 
 namespace al {
 
@@ -92,6 +91,13 @@ public:
     DoubleBuffering() {
     }
 
+    ~DoubleBuffering() {
+        if (m_bufferSize > 0) {
+            free(m_buffers[0]);
+            free(m_buffers[1]);
+        }
+    }
+
     void setSize(unsigned int size) {
         std::unique_lock<std::mutex> lk(m_meterMutex);
         if (m_bufferSize > 0) {
@@ -196,8 +202,8 @@ class OutputMaster : /*public osc::Recv,*/ public al::AudioCallback
     void setMeterUpdateFreq(double freq);
 
     /** Set bass management cross-over frequency. The signal from all channels will be run
-     * through a pair of linear-phase cross-over filters, and the signal from the low pass
-     * filters is sent to the subwoofers specified using setSwIndeces().
+     * through a pair of 4th order Linkwitz-Riley cross-over filters, and the signal from the
+     * low pass filters is sent to the subwoofers specified using setSwIndeces().
     */
     void setBassManagementFreq(double frequency);
 
@@ -290,8 +296,13 @@ private:
     DoubleBuffering<float> m_meterBuffer;
     int m_meterCounter {0}; /* count samples for level updates */
 
-    /* bass management filters */
-    std::vector<gam::Biquad<double>> m_lopass1, m_lopass2, m_hipass1, m_hipass2;
+    /* bass management filters, two Butterworth stages each */
+    BiquadBank m_lowpass, m_highpass;
+    /* Channels are filtered in chunks of BASS_CHUNK frames */
+    static const unsigned int BASS_CHUNK = 64;
+    std::vector<float> m_lowBuffers; /* low pass output, BASS_CHUNK frames per channel */
+    std::vector<double> m_bassBuffer; /* sum of low pass outputs */
+    std::vector<float *> m_chunkOut, m_chunkLow;
 
     double m_framesPerSec; // Sample rate
 
@@ -62,6 +62,9 @@ namespace al
     parameterMIDI.connectControl(Speed, 10, 1);
 @endcode
  *
+ * Messages are queued on the MIDI thread and applied from the worker thread
+ * of a MIDIMessageDispatcher, so parameter callbacks are not called on the
+ * MIDI thread.
  */
 class ParameterMIDI : public MIDIMessageHandler {
 public:
@@ -69,7 +72,8 @@ public:
 	ParameterMIDI() {}
 
 	ParameterMIDI(int deviceIndex, bool verbose = false) {
-		MIDIMessageHandler::bindTo(mMidiIn);
+		mDispatcher.queue().bindTo(mMidiIn);
+		mDispatcher.start();
 		mVerbose = verbose;
 		try {
 			mMidiIn.openPort(deviceIndex);
@@ -85,9 +89,14 @@ public:
         open(deviceIndex, verbose);
 	}
 
+	~ParameterMIDI() {
+		close();
+	}
+
     void open(int deviceIndex = 0, bool verbose = false) {
 
-        MIDIMessageHandler::bindTo(mMidiIn);
+        mDispatcher.queue().bindTo(mMidiIn);
+        mDispatcher.start();
 		mVerbose = verbose;
 		try {
 			mMidiIn.openPort(deviceIndex);
@@ -100,7 +109,8 @@ public:
 
     void close() {
         mMidiIn.closePort();
-        MIDIMessageHandler::clearBindings();
+        mDispatcher.queue().clearBindings();
+        mDispatcher.stop();
     }
 
 	void connectControl(Parameter &param, int controlNumber, int channel)
@@ -256,11 +266,12 @@ public:
 private:
 
 	MIDIIn mMidiIn;
-	bool mVerbose;
+	bool mVerbose {false};
 	std::vector<ControlBinding> mControlBindings;
 	std::vector<NoteBinding> mNoteBindings;
 	std::vector<ToggleBinding> mToggleBindings;
 	std::vector<IncrementBinding> mIncrementBindings;
+	MIDIMessageDispatcher mDispatcher {*this};
 };
 
 
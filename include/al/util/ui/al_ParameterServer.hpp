@@ -40,9 +40,12 @@
 	Andrés Cabrera mantaraya36@gmail.com
 */
 
+#include <algorithm>
+#include <iostream>
 #include <mutex>
 
 #include "al/core/protocol/al_OSC.hpp"
+#include "al/core/system/al_SharedMemory.hpp"
 #include "al/util/ui/al_Parameter.hpp"
 #include "al/util/ui/al_ParameterBundle.hpp"
 
@@ -118,6 +121,30 @@ public:
       }
     }
 
+    /**
+     * @brief addSharedMemoryListener publishes notifications to a shared memory ring
+     * @param ring ring created with SharedMemoryRing::create()
+     *
+     * Notifications are written as raw OSC packets, so a reader on the same
+     * host can pass them to osc::PacketHandler::parse() without going through
+     * the network stack.
+     */
+    void addSharedMemoryListener(SharedMemoryRing *ring) {
+      mListenerLock.lock();
+      mSharedMemoryRings.push_back(ring);
+      mListenerLock.unlock();
+    }
+
+    /// Stop publishing notifications to ring. Must be called before the ring is closed
+    void removeSharedMemoryListener(SharedMemoryRing *ring) {
+      mListenerLock.lock();
+      auto it = std::find(mSharedMemoryRings.begin(), mSharedMemoryRings.end(), ring);
+      if (it != mSharedMemoryRings.end()) {
+        mSharedMemoryRings.erase(it);
+      }
+      mListenerLock.unlock();
+    }
+
     /**
      * @brief Notify the listeners of value changes
      * @param OSCaddress The OSC path to send the value on
@@ -146,6 +173,7 @@ public:
             sender->send(p);
             std::cout << "Notifying " << sender->address() << ":" << sender->port() << std::endl;
         }
+        publishSharedMemory(p);
         mListenerLock.unlock();
     }
 
@@ -164,8 +192,37 @@ public:
     }
 
 protected:
+    // Must be called with mListenerLock held
+    template<class... Args>
+    void notifySharedMemory(const std::string &OSCaddress, Args... args) {
+        if (mSharedMemoryRings.size() == 0) {
+            return;
+        }
+        osc::Packet p;
+        p.beginMessage(OSCaddress);
+        int expand[] = {0, ((void) (p << args), 0)...};
+        (void) expand;
+        p.endMessage();
+        publishSharedMemory(p);
+    }
+
+    // Must be called with mListenerLock held. Packets larger than a ring's
+    // slot can not be passed through it and are reported.
+    void publishSharedMemory(osc::Packet &p) {
+        for(SharedMemoryRing *ring: mSharedMemoryRings) {
+            if ((size_t) p.size() > ring->slotSize()) {
+                std::cerr << "ERROR: OSC packet of " << p.size()
+                          << " bytes is larger than shared memory slot size "
+                          << ring->slotSize() << ". Not sent." << std::endl;
+            } else {
+                ring->publish(p.data(), p.size());
+            }
+        }
+    }
+
     std::mutex mListenerLock;
     std::vector<osc::Send *> mOSCSenders;
+    std::vector<SharedMemoryRing *> mSharedMemoryRings;
 
     class HandshakeHandler: public osc::PacketHandler {
     public:
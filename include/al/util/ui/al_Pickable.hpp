@@ -2,6 +2,7 @@
 #ifndef __PICKABLE_HPP__
 #define __PICKABLE_HPP__
 
+#include <functional>
 #include <vector>
 
 #include "al/util/al_Ray.hpp"
@@ -217,20 +218,33 @@ struct Pickable : PickableBase {
   Quatf selectQuat;
   float selectDist;
 
-  Pickable(std::string name = ""){ PickableState::name = name;}
-  Pickable(Mesh &m){set(m);}
+  /// called when the pose, scale or bounding box change. Used by PickableManager
+  std::function<void()> boundsChangeCallback;
+  /// called when the pickable is destroyed. Used by PickableManager to unregister it
+  std::function<void()> destroyCallback;
+
+  Pickable(std::string name = ""){ PickableState::name = name; registerBoundsCallbacks();}
+  Pickable(Mesh &m){ registerBoundsCallbacks(); set(m);}
+  ~Pickable(){ if(destroyCallback) destroyCallback(); }
+
+  // The parameter callbacks point to this pickable, a copy would call them
+  Pickable(const Pickable &) = delete;
+  Pickable &operator=(const Pickable &) = delete;
 
   /// initialize bounding box;
   void set(Mesh &m){
     mesh = &m;
     bb.set(*mesh);
+    if(boundsChangeCallback) boundsChangeCallback();
   }
 
   /// override base methods
   Hit intersect(Rayd &r){
     auto ray = transformRayLocal(r);
-    double t = intersectBB(ray) * scaleVec.get().x;
-    // auto r2 = Rayd(r.o*scaleVec.get(), r.d);
+    // t is measured along the normalized local ray, convert it to a distance along r.
+    // Exact for non-uniform scales, for uniform scales this is t * scale
+    Vec3d dirLocal = pose.get().quat().conj().rotate(r.d) / Vec3d(scaleVec.get());
+    double t = intersectBB(ray) / dirLocal.mag();
     if(t > 0) return Hit(true, r, t, this);
     else return Hit(false, r, t, this);
   }
@@ -345,14 +359,28 @@ struct Pickable : PickableBase {
 
   /// calculate Axis aligned bounding box from mesh bounding box and current transforms
   void updateAABB(){
+    Vec3d cen, dim;
+    worldBounds(cen, dim);
+    aabb.setCenterDim(cen, dim);
+  }
+
+  /// center and size of the world space axis aligned bounding box. Unlike
+  /// updateAABB() this does not generate the box meshes
+  void worldBounds(Vec3d &cen, Vec3d &dim){
     // thanks to http://zeuxcg.org/2010/10/17/aabb-from-obb-with-component-wise-abs/
     Matrix4d t,r,s;
     Matrix4d model = t.translation(pose.get().pos()) * r.fromQuat(pose.get().quat()) * s.scaling(scaleVec.get());
     Matrix4d absModel(model);
     for(int i=0; i<16; i++) absModel[i] = std::abs(absModel[i]);
-    Vec4d cen = model.transform(Vec4d(bb.cen, 1));
-    Vec4d dim = absModel.transform(Vec4d(bb.dim, 0));
-    aabb.setCenterDim(cen.sub<3>(0),dim.sub<3>(0));
+    cen = model.transform(Vec4d(bb.cen, 1)).sub<3>(0);
+    dim = absModel.transform(Vec4d(bb.dim, 0)).sub<3>(0);
+  }
+
+private:
+  void registerBoundsCallbacks(){
+    // callbacks run before the new value is stored, so only notify here
+    pose.registerChangeCallback([this](Pose){ if(boundsChangeCallback) boundsChangeCallback(); });
+    scaleVec.registerChangeCallback([this](Vec3f){ if(boundsChangeCallback) boundsChangeCallback(); });
   }
 
 };
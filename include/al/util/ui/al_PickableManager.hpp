@@ -2,16 +2,31 @@
 #ifndef __PICKABLEMANAGER_HPP__
 #define __PICKABLEMANAGER_HPP__
 
+#include <algorithm>
+#include <memory>
+#include <mutex>
 #include <vector>
 // #include <map>
 
 #include "al/core/graphics/al_Graphics.hpp"
+#include "al/core/graphics/al_Shapes.hpp"
+#include "al/core/io/al_Window.hpp"
+#include "al/util/al_BVH.hpp"
 #include "al/util/al_Ray.hpp"
 #include "al/util/ui/al_Pickable.hpp"
 
 namespace al {
 
 
+/// Handles pointing, picking and dragging a set of Pickables
+///
+/// Ray queries go through a bounding volume hierarchy (BVH) over the world
+/// space bounding boxes of the registered pickables, so they don't need to
+/// test every pickable. Changes to a pickable's pose or scale are refit into
+/// the BVH on the next query, and the BVH is rebuilt in a background thread
+/// when refitting has made it too inefficient.
+///
+/// @ingroup allocore
 class PickableManager {
 public:
 	PickableManager(){ 
@@ -19,13 +34,60 @@ public:
 		mRotating = mScaling = mZooming = false;
 	}
 
-	PickableManager& registerPickable(Pickable &p){ mPickables.push_back(&p); return *this; }
+	~PickableManager(){ mHandle.reset(); }
+
+	// Pickables hold callbacks to this manager
+	PickableManager(const PickableManager &) = delete;
+	PickableManager &operator=(const PickableManager &) = delete;
+	PickableManager(PickableManager &&) = delete;
+	PickableManager &operator=(PickableManager &&) = delete;
+
+	/// Pickables registered with the manager can be destroyed before or
+	/// after it. Their callbacks do nothing once the manager is destroyed.
+	PickableManager& registerPickable(Pickable &p){
+		int index = (int) mPickables.size();
+		mPickables.push_back(&p);
+		setCallbacks(p, index);
+		mBVHValid = false;
+		return *this;
+	}
+
+	/// Stop handling a pickable. Called when a registered pickable is destroyed
+	void unregisterPickable(Pickable &p){
+		auto it = std::find(mPickables.begin(), mPickables.end(), &p);
+		if(it == mPickables.end()) return;
+		p.boundsChangeCallback = nullptr;
+		p.destroyCallback = nullptr;
+		// Move the last pickable into the free index
+		int index = int(it - mPickables.begin());
+		mPickables[index] = mPickables.back();
+		mPickables.pop_back();
+		if(index < (int) mPickables.size()) setCallbacks(*mPickables[index], index);
+		if(mHovered == &p) mHovered = nullptr;
+		if(mSelected == &p) mSelected = nullptr;
+		if(mLastPoint.p == &p) mLastPoint = Hit();
+		if(mLastPick.p == &p) mLastPick = Hit();
+		mBVHValid = false;
+	}
 	PickableManager& operator <<(Pickable &p){ return registerPickable(p); }
 	PickableManager& operator <<(Pickable *p){ return registerPickable(*p); }
 
 	std::vector<Pickable *> pickables(){ return mPickables; }
 
+	/// Nearest pickable hit by ray
 	Hit intersect(Rayd r){
+		if(!mUseBVH) return intersectAll(r);
+		updateBVH();
+		double t;
+		int index = mBVH.intersect(r, t, [&](int i){
+			return mPickables[i]->intersect(r).t;
+		});
+		if(index < 0) return Hit(false, r, 1e10, NULL);
+		return Hit(true, r, t, mPickables[index]);
+	}
+
+	/// Nearest pickable hit by ray, testing every pickable
+	Hit intersectAll(Rayd r){
 		Hit hmin = Hit(false, r, 1e10, NULL);
 		for(Pickable *p : mPickables){
 			Hit h = p->intersect(r);
@@ -38,26 +100,81 @@ public:
 
 	bool point(Rayd &r){
 		Hit h = intersect(r);
-		for(Pickable *p : mPickables){
-			if(p == h.p){
-				p->point(r);
-				mLastPoint = h;
-			} else if(p->hover.get()) p->hover = false;
+		if(mHovered && mHovered != h.p && mHovered->hover.get()) mHovered->hover = false;
+		mHovered = nullptr;
+		if(h.hit){
+			Pickable *p = static_cast<Pickable *>(h.p);
+			p->point(r);
+			mLastPoint = h;
+			mHovered = p;
 		}
 		return true;
 	}
 
 	bool pick(Rayd &r){
 		Hit h = intersect(r);
-		for(Pickable *p : mPickables){
-			if(p == h.p){
-				p->pick(r);
-				mLastPick = h;
-			} else if(p->selected.get()) p->selected = false;
+		if(mSelected && mSelected != h.p && mSelected->selected.get()) mSelected->selected = false;
+		mSelected = nullptr;
+		if(h.hit){
+			Pickable *p = static_cast<Pickable *>(h.p);
+			p->pick(r);
+			mLastPick = h;
+			mSelected = p;
 		}
 		return true;
 	}
 
+	/// Use the BVH for ray queries. If false every pickable is tested
+	void useBVH(bool use){ mUseBVH = use; }
+	bool useBVH(){ return mUseBVH; }
+
+	/// Tell the manager that a pickable's bounds changed without its
+	/// parameter callbacks being called (e.g. through setNoCalls())
+	void boundsChanged(Pickable &p){
+		auto it = std::find(mPickables.begin(), mPickables.end(), &p);
+		if(it != mPickables.end()) boundsChanged(int(it - mPickables.begin()));
+	}
+
+	/// Recompute the bounds of all pickables
+	void boundsChangedAll(){ mBVHValid = false; }
+
+	/// Bring the BVH up to date with pickable bounds. Called by intersect()
+	void updateBVH(){
+		if(!mBVHValid){
+			std::vector<BVH::Bounds> bounds(mPickables.size());
+			{
+				std::unique_lock<std::mutex> lk(mDirtyLock);
+				mDirty.clear();
+				mIsDirty.assign(mPickables.size(), 0);
+			}
+			for(size_t i = 0; i < mPickables.size(); i++){
+				bounds[i] = worldBounds(*mPickables[i]);
+			}
+			mBVH.build(bounds);
+			mRefitsSinceBuild = 0;
+			mBVHValid = true;
+			return;
+		}
+		mBVH.finishRebuild();
+		{
+			std::unique_lock<std::mutex> lk(mDirtyLock);
+			mDirty.swap(mDirtyPending);
+			for(int i : mDirtyPending) mIsDirty[i] = 0;
+		}
+		for(int i : mDirtyPending){
+			mBVH.update(i, worldBounds(*mPickables[i]));
+		}
+		mRefitsSinceBuild += mDirtyPending.size();
+		mDirtyPending.clear();
+		// Check how much refitting has degraded the tree every so often
+		if(mRefitsSinceBuild > std::max(size_t(64), mPickables.size() / 4) && !mBVH.rebuilding()){
+			mRefitsSinceBuild = 0;
+			if(mBVH.cost() > mBVH.buildCost() * 1.5f) mBVH.rebuildAsync();
+		}
+	}
+
+	BVH &bvh(){ return mBVH; }
+
 	bool drag(Rayd &r, Vec3f dv){
 		for(Pickable *p : mPickables){
 			if(p->selected.get()){
@@ -224,10 +341,50 @@ protected:
 
 	Hit mLastPoint;
 	Hit mLastPick;
+	Pickable *mHovered {nullptr};
+	Pickable *mSelected {nullptr};
 	Vec3d selectOffset;
 
 	bool mTranslating, mRotating, mZooming, mScaling;
 
+	BVH mBVH;
+	bool mUseBVH {true};
+	bool mBVHValid {false};
+	size_t mRefitsSinceBuild {0};
+	std::mutex mDirtyLock; // pose callbacks can come from any thread
+	std::vector<int> mDirty;
+	std::vector<int> mDirtyPending;
+	std::vector<char> mIsDirty;
+	std::shared_ptr<PickableManager *> mHandle {std::make_shared<PickableManager *>(this)};
+
+	void setCallbacks(Pickable &p, int index){
+		// Callbacks hold a weak reference, so they do nothing after the
+		// manager is destroyed
+		std::weak_ptr<PickableManager *> handle = mHandle;
+		p.boundsChangeCallback = [handle, index](){
+			if(auto m = handle.lock()) (*m)->boundsChanged(index);
+		};
+		p.destroyCallback = [handle, &p](){
+			if(auto m = handle.lock()) (*m)->unregisterPickable(p);
+		};
+	}
+
+	void boundsChanged(int index){
+		std::unique_lock<std::mutex> lk(mDirtyLock);
+		if(index < (int) mIsDirty.size() && !mIsDirty[index]){
+			mIsDirty[index] = 1;
+			mDirty.push_back(index);
+		}
+	}
+
+	static BVH::Bounds worldBounds(Pickable &p){
+		Vec3d cen, dim;
+		p.worldBounds(cen, dim);
+		// Pad for rounding to float, the box must contain the pickable
+		Vec3d pad = (cen.mag() + dim.mag() + 1.0) * 1e-6;
+		return BVH::Bounds(cen - dim * 0.5 - pad, cen + dim * 0.5 + pad);
+	}
+
 	Vec3d unproject(Graphics &g, Vec3d screenPos, bool view=true){
 		auto v = Matrix4d::identity();
 		if(view) v = g.viewMatrix();
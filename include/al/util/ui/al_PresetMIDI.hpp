@@ -54,6 +54,8 @@ namespace al
 
 @endcode
  *
+ * Messages are queued on the MIDI thread and applied from the worker thread
+ * of a MIDIMessageDispatcher, so presets are not recalled on the MIDI thread.
  */
 class PresetMIDI : public MIDIMessageHandler {
 public:
@@ -61,7 +63,8 @@ public:
 	PresetMIDI() {}
 
 	PresetMIDI(int deviceIndex) : mPresetHandler(nullptr) {
-		MIDIMessageHandler::bindTo(mMidiIn);
+		mDispatcher.queue().bindTo(mMidiIn);
+		mDispatcher.start();
 		try {
 			mMidiIn.openPort(deviceIndex);
 			printf("PresetMIDI: Opened port to %s\n", mMidiIn.getPortName(deviceIndex).c_str());
@@ -79,6 +82,10 @@ public:
 		setPresetHandler(*mPresetHandler);
 	}
 
+	~PresetMIDI() {
+		close();
+	}
+
     void enable() {mEnabled = true;}
     void disable() {mEnabled = false;}
 
@@ -92,7 +99,8 @@ public:
 	}
 
     void open(int deviceIndex) {
-		MIDIMessageHandler::bindTo(mMidiIn);
+		mDispatcher.queue().bindTo(mMidiIn);
+		mDispatcher.start();
 
         if (mMidiIn.isPortOpen()) {
             mMidiIn.closePort();
@@ -112,7 +120,8 @@ public:
 
     void close() {
         mMidiIn.closePort();
-        MIDIMessageHandler::clearBindings();
+        mDispatcher.queue().clearBindings();
+        mDispatcher.stop();
     }
 
 
@@ -166,7 +175,7 @@ private:
 	MIDIIn mMidiIn;
 	std::vector<NoteBinding> mNoteBindings;
 	std::vector<ProgramBinding> mProgramBindings;
-
+	MIDIMessageDispatcher mDispatcher {*this};
 };
 
 
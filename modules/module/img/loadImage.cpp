@@ -1,5 +1,56 @@
+#include <cstdio>
+#include <cstdlib>
 #include <cstring> // memcpy
 
+namespace {
+
+// Buffer that stb_image decodes into for loadImage(const char*, ImageData&).
+// stb_image allocates its output with STBI_MALLOC, so allocations of the
+// size of the decoded image are given this buffer instead of new memory.
+// If an intermediate allocation of the same size takes the buffer first,
+// the result is copied as before.
+struct DecodeTarget {
+    void* data = nullptr;
+    size_t size = 0;
+    bool inUse = false;
+};
+
+thread_local DecodeTarget decodeTarget;
+
+void* decodeMalloc(size_t size) {
+    DecodeTarget& target = decodeTarget;
+    if (target.data && !target.inUse && size == target.size) {
+        target.inUse = true;
+        return target.data;
+    }
+    return malloc(size);
+}
+
+void decodeFree(void* p) {
+    if (p && p == decodeTarget.data) {
+        decodeTarget.inUse = false;
+        return;
+    }
+    free(p);
+}
+
+void* decodeRealloc(void* p, size_t newSize) {
+    if (p && p == decodeTarget.data) {
+        void* q = malloc(newSize);
+        if (q) {
+            memcpy(q, p, newSize < decodeTarget.size ? newSize : decodeTarget.size);
+            decodeTarget.inUse = false;
+        }
+        return q;
+    }
+    return realloc(p, newSize);
+}
+
+}
+
+#define STBI_MALLOC(sz) decodeMalloc(sz)
+#define STBI_REALLOC(p, newsz) decodeRealloc(p, newsz)
+#define STBI_FREE(p) decodeFree(p)
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_STATIC
 #include "stb_image.h"
@@ -26,3 +77,36 @@ img_module::ImageData img_module::loadImage(const char* filename) {
 img_module::ImageData img_module::loadImage(string &filename) {
     return img_module::loadImage(filename.c_str());
 }
+
+bool img_module::loadImage(const char* filename, ImageData& image) {
+    int w = 0, h = 0, n;
+    unsigned char* data = nullptr;
+    FILE* f = fopen(filename, "rb");
+    if (f) {
+        // Read the size from the header, then decode straight into
+        // image.data, which only allocates if its capacity is too small
+        if (stbi_info_from_file(f, &w, &h, &n) && w > 0 && h > 0) {
+            image.data.resize((size_t) w * h * 4);
+            decodeTarget.data = image.data.data();
+            decodeTarget.size = image.data.size();
+            decodeTarget.inUse = false;
+            data = stbi_load_from_file(f, &w, &h, &n, 4);
+            decodeTarget = DecodeTarget();
+        }
+        fclose(f);
+    }
+    if (!data) {
+        image.width = 0;
+        image.height = 0;
+        image.data.clear();
+        return false;
+    }
+    image.width = w;
+    image.height = h;
+    if (data != image.data.data()) {
+        image.data.resize((size_t) w * h * 4);
+        memcpy(image.data.data(), data, (size_t) w * h * 4);
+        stbi_image_free(data);
+    }
+    return true;
+}
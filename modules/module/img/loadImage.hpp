@@ -34,6 +34,10 @@ ImageData loadImage(const char* filename);
 // returns empty object (width and height 0, data empty) if failed to load
 ImageData loadImage(std::string &filename);
 
+// loads into an existing object, decoding into the memory in image.data if
+// it is large enough. returns false if failed to load
+bool loadImage(const char* filename, ImageData& image);
+
 }
 
 namespace imgModule = img_module;
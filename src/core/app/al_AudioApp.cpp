@@ -1,4 +1,6 @@
 #include "al/core/app/al_AudioApp.hpp"
+#include "al/core/io/al_File.hpp"
+#include "al/util/al_Toml.hpp"
 
 using namespace al;
 
@@ -22,9 +24,11 @@ void AudioApp::initAudio(AudioDevice &dev,
                          double audioRate, int audioBlockSize,
                          int audioOutputs, int audioInputs, int device)
 {
-
+  if (File::exists("audio.toml")) {
+    loadAudioConfig("audio.toml");
+  }
   mAudioIO.init(AppAudioCB, this, audioBlockSize, audioRate, audioOutputs, audioInputs);
-  if (device >= 0) {
+  if (device >= 0 && !mAudioIO.offline()) {
        mAudioIO.device(AudioDevice(device));
        // mAudioIO.device() sets the channels to the device default number
        mAudioIO.channelsIn(audioInputs);
@@ -36,10 +40,66 @@ void AudioApp::initAudio(AudioDevice &dev,
 void AudioApp::initAudio(AudioIOConfig config) {
     bool use_in = (config & IN_ONLY) ? true : false;
     bool use_out = (config & OUT_ONLY) ? true : false;
-    mAudioIO.initWithDefaults(AppAudioCB, this, use_out, use_in);
+    if (File::exists("audio.toml")) {
+      loadAudioConfig("audio.toml");
+    }
+    if (mAudioIO.offline()) {
+      // No device to take defaults from, so keep the settings made by the
+      // caller or audio.toml. Channels default to stereo.
+      int outChans = mAudioIO.channelsOut() > 0 ? mAudioIO.channelsOut() : 2;
+      int inChans = mAudioIO.channelsIn() > 0 ? mAudioIO.channelsIn() : 2;
+      mAudioIO.init(AppAudioCB, this, mAudioIO.framesPerBuffer(),
+                    mAudioIO.framesPerSecond(), use_out ? outChans : 0,
+                    use_in ? inChans : 0);
+    } else {
+      mAudioIO.initWithDefaults(AppAudioCB, this, use_out, use_in);
+    }
     mAudioIO.open();
 }
 
+bool AudioApp::loadAudioConfig(const std::string &fileName) {
+  if (!File::exists(fileName)) {
+    std::cerr << "ERROR: Audio config file not found: " << fileName << std::endl;
+    return false;
+  }
+  TomlLoader config(fileName);
+  if (!config.root) {
+    return false;
+  }
+  auto getNumber = [&](const char *key, double defaultValue) {
+    if (auto value = config.root->get_as<double>(key)) {
+      return *value;
+    }
+    if (auto value = config.root->get_as<int64_t>(key)) {
+      return double(*value);
+    }
+    return defaultValue;
+  };
+  auto getString = [&](const char *key) {
+    auto value = config.root->get_as<std::string>(key);
+    return value ? *value : std::string();
+  };
+
+  if (getString("backend") == "offline") {
+    OfflineAudioConfig offlineConfig;
+    offlineConfig.speed = getNumber("offlineSpeed", 0.0);
+    offlineConfig.duration = getNumber("offlineDuration", 0.0);
+    offlineConfig.outputFile = getString("offlineOutputFile");
+    offlineConfig.inputFile = getString("offlineInputFile");
+    if (auto value = config.root->get_as<bool>("offlineVerbose")) {
+      offlineConfig.verbose = *value;
+    }
+    mAudioIO.offline(offlineConfig);
+    mAudioIO.framesPerBuffer(
+        unsigned(getNumber("framesPerBuffer", mAudioIO.framesPerBuffer())));
+    mAudioIO.framesPerSecond(
+        getNumber("framesPerSecond", mAudioIO.framesPerSecond()));
+    mAudioIO.channelsOut(int(getNumber("channelsOut", mAudioIO.channelsOut())));
+    mAudioIO.channelsIn(int(getNumber("channelsIn", mAudioIO.channelsIn())));
+  }
+  return true;
+}
+
 bool AudioApp::usingAudio() const {
   return audioIO().callback == AppAudioCB;
 }
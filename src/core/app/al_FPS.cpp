@@ -1,11 +1,12 @@
 #include "al/core/app/al_FPS.hpp"
-
 #include <algorithm> // max
+#include <thread>
 
 using namespace al;
 
 void FPS::fps(double f) {
   mFPSWanted = f;
+  mDivisor = 1;
   interval = static_cast<al_nsec>(al_time_s2ns / f);
 }
 
@@ -13,16 +14,20 @@ double FPS::fpsWanted() {
   return mFPSWanted;
 }
 
+double FPS::fpsTarget() {
+  return mFPSWanted / mDivisor;
+}
+
 double FPS::fps() {
     return al_time_s2ns / deltaTime;
 }
 
 double FPS::sec() {
-  return al_steady_time_nsec() * al_time_ns2s;
+  return mNow() * al_time_ns2s;
 }
 
 double FPS::msec() {
-  return al_steady_time_nsec() * 1.0e-6;
+  return mNow() * 1.0e-6;
 }
 
 double FPS::dt() {
@@ -33,23 +38,67 @@ double FPS::dt_sec() {
   return static_cast<double>(deltaTime) / 1000000000.0;
 }
 
+void FPS::timeSource(std::function<al_nsec()> now, std::function<void(al_nsec)> sleep) {
+  mNow = now;
+  mSleep = sleep;
+  mProfiler.clock(now);
+}
+
 void FPS::startFPS() {
   deltaTime = interval;
   al_start_steady_clock();
+  start_of_loop = mNow();
+  mWindowFrames = mWindowLate = 0;
+  mWindowMaxTook = 0;
+  mLateFrames = 0;
+  mProfiler.reset();
+}
+
+void FPS::waitUntil(al_nsec t) {
+  al_nsec remaining = t - mNow();
+  if (remaining > spinTime) mSleep(remaining - spinTime);
+  while (mNow() < t) std::this_thread::yield();
+}
+
+void FPS::adapt(al_nsec took) {
+  ++mWindowFrames;
+  if (took > interval) ++mWindowLate;
+  mWindowMaxTook = std::max(mWindowMaxTook, took);
+  if (mWindowFrames < adaptWindow) return;
+
+  if (adaptive) {
+    al_nsec wanted = static_cast<al_nsec>(al_time_s2ns / mFPSWanted);
+    if (mWindowLate * 2 > mWindowFrames && mDivisor < maxDivisor) {
+      ++mDivisor;
+    }
+    // Keep some headroom before going faster, to avoid switching every window
+    else if (mDivisor > 1 && mWindowMaxTook < wanted * (mDivisor - 1) * 8 / 10) {
+      --mDivisor;
+    }
+    interval = wanted * mDivisor;
+  }
+  mWindowFrames = mWindowLate = 0;
+  mWindowMaxTook = 0;
 }
 
 void FPS::tickFPS() {
-    al_nsec after_loop = al_steady_time_nsec();
+    al_nsec after_loop = mNow();
     al_nsec time_took_to_loop = after_loop - start_of_loop;
-    if (time_took_to_loop < interval) {
+    al_nsec frame_interval = interval;
+    adapt(time_took_to_loop);
+    if (time_took_to_loop < frame_interval) {
       // have some time left
-      al_sleep_nsec(interval - time_took_to_loop);
-      deltaTime = interval;
-      start_of_loop += interval;
+      mProfiler.begin("sleep");
+      waitUntil(start_of_loop + frame_interval);
+      mProfiler.end();
+      deltaTime = frame_interval;
+      start_of_loop += frame_interval;
     }
     else {
       // no time to sleep
+      ++mLateFrames;
       deltaTime = time_took_to_loop;
       start_of_loop = after_loop;
     }
-}
\ No newline at end of file
+    mProfiler.endFrame();
+}
@@ -0,0 +1,32 @@
+#include "al/core/app/al_FramePipeline.hpp"
+#include <cstdio>
+
+using namespace al;
+
+void FrameStageStats::Stage::add(double seconds) {
+  last = seconds;
+  ++count;
+  mean += (seconds - mean) / count;
+  if (seconds > max) max = seconds;
+}
+
+void FrameStageStats::reset() {
+  simulate = Stage();
+  render = Stage();
+  wait = Stage();
+  present = Stage();
+  frame = Stage();
+}
+
+void FrameStageStats::print() const {
+  auto printStage = [](const char* name, const Stage& s) {
+    printf("%-9s mean %7.3f ms, max %7.3f ms, last %7.3f ms (%llu)\n", name,
+           s.mean * 1000.0, s.max * 1000.0, s.last * 1000.0,
+           (unsigned long long)s.count);
+  };
+  printStage("simulate", simulate);
+  printStage("render", render);
+  printStage("wait", wait);
+  printStage("present", present);
+  printStage("frame", frame);
+}
@@ -0,0 +1,168 @@
+#include "al/core/app/al_FrameProfiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace al;
+
+FrameProfiler::FrameProfiler(size_t historyFrames)
+:  mClock(al_steady_time_nsec),
+  mHistoryFrames(std::max(historyFrames, size_t(1)))
+{}
+
+void FrameProfiler::historyFrames(size_t n) {
+  mHistoryFrames = std::max(n, size_t(1));
+  reset();
+}
+
+int FrameProfiler::sectionIndex(const char* name) {
+  for (size_t i = 0; i < mSections.size(); i++) {
+    if (mSections[i].name == name) return int(i);
+  }
+  mSections.emplace_back();
+  mSections.back().name = name;
+  mSections.back().history.assign(mHistoryFrames, 0);
+  return int(mSections.size() - 1);
+}
+
+void FrameProfiler::begin(const char* name) {
+  // Sections begun while disabled are pushed untimed, so that end() always
+  // pops the section it matches if the profiler is enabled in between
+  if (!mEnabled) {
+    mOpen.push_back(Open{-1, 0});
+    return;
+  }
+  mOpen.push_back(Open{sectionIndex(name), mClock()});
+}
+
+void FrameProfiler::end() {
+  // Sections begun before disabling are still ended
+  if (mOpen.empty()) return;
+  Open o = mOpen.back();
+  mOpen.pop_back();
+  if (o.section < 0) return;
+  al_nsec t = mClock();
+  al_nsec dur = t - o.start;
+  mSections[o.section].frameTotal += dur;
+  if (mRecordTrace && mTrace.size() < mMaxTraceEvents) {
+    mTrace.push_back(TraceEvent{o.section, int(mOpen.size()), o.start, dur});
+  }
+}
+
+void FrameProfiler::endFrame() {
+  if (!mEnabled) return;
+  al_nsec t = mClock();
+  if (mLastFrameEnd >= 0) {
+    int frame = sectionIndex("frame");
+    mSections[frame].frameTotal = t - mLastFrameEnd;
+    if (mRecordTrace && mTrace.size() < mMaxTraceEvents) {
+      mTrace.push_back(TraceEvent{frame, -1, mLastFrameEnd, t - mLastFrameEnd});
+    }
+  }
+  mLastFrameEnd = t;
+
+  size_t slot = mFrames % mHistoryFrames;
+  for (auto& s : mSections) {
+    s.history[slot] = s.frameTotal;
+    s.frameTotal = 0;
+  }
+  mFrames++;
+}
+
+FrameProfiler::Stats FrameProfiler::summarize(const Section& s) const {
+  Stats st;
+  st.name = s.name;
+  size_t n = std::min(mFrames, mHistoryFrames);
+  if (0 == n) return st;
+  std::vector<al_nsec> sorted(s.history.begin(), s.history.begin() + n);
+  std::sort(sorted.begin(), sorted.end());
+  double sum = 0;
+  for (auto v : sorted) sum += v;
+  // Nearest rank percentile
+  auto pct = [&](double p) {
+    size_t rank = size_t(std::ceil(p * n));
+    return sorted[rank > 0 ? rank - 1 : 0] * 1e-9;
+  };
+  st.mean = sum / n * 1e-9;
+  st.p50 = pct(0.5);
+  st.p90 = pct(0.9);
+  st.p99 = pct(0.99);
+  st.max = sorted.back() * 1e-9;
+  st.frames = n;
+  return st;
+}
+
+FrameProfiler::Stats FrameProfiler::stats(const std::string& name) const {
+  for (auto& s : mSections) {
+    if (s.name == name) return summarize(s);
+  }
+  Stats st;
+  st.name = name;
+  return st;
+}
+
+std::vector<FrameProfiler::Stats> FrameProfiler::stats() const {
+  std::vector<Stats> all;
+  for (auto& s : mSections) all.push_back(summarize(s));
+  return all;
+}
+
+void FrameProfiler::print() const {
+  for (auto& st : stats()) {
+    printf("%-12s mean %7.3f  p50 %7.3f  p90 %7.3f  p99 %7.3f  max %7.3f ms\n",
+           st.name.c_str(), st.mean * 1e3, st.p50 * 1e3, st.p90 * 1e3,
+           st.p99 * 1e3, st.max * 1e3);
+  }
+}
+
+void FrameProfiler::reset() {
+  for (auto& s : mSections) {
+    s.history.assign(mHistoryFrames, 0);
+    s.frameTotal = 0;
+  }
+  mFrames = 0;
+  mLastFrameEnd = -1;
+  mTrace.clear();
+}
+
+void FrameProfiler::recordTrace(bool v, size_t maxEvents) {
+  mRecordTrace = v;
+  mMaxTraceEvents = maxEvents;
+  if (v) mTrace.reserve(std::min(maxEvents, size_t(1) << 16));
+}
+
+bool FrameProfiler::writeTrace(const std::string& path) const {
+  std::ofstream f(path);
+  if (!f.is_open()) {
+    std::cerr << "ERROR: FrameProfiler could not open " << path << std::endl;
+    return false;
+  }
+  // Complete ("X") events with times in microseconds. Frames go on their
+  // own row so that they do not hide the sections within them.
+  f << "{\"traceEvents\":[\n";
+  char buf[256];
+  for (size_t i = 0; i < mTrace.size(); i++) {
+    const TraceEvent& e = mTrace[i];
+    std::string name;
+    for (char c : mSections[e.section].name) {
+      if (c == '"' || c == '\\') name += '\\';
+      if (c >= 0 && c < 0x20) c = ' ';
+      name += c;
+    }
+    snprintf(buf, sizeof(buf),
+             "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+             name.c_str(), e.depth < 0 ? 0 : 1, e.start * 1e-3, e.duration * 1e-3,
+             i + 1 < mTrace.size() ? "," : "");
+    f << buf;
+  }
+  f << "],\"displayTimeUnit\":\"ms\"}\n";
+  if (!f.good()) {
+    std::cerr << "ERROR: FrameProfiler could not write " << path << std::endl;
+    return false;
+  }
+  return true;
+}
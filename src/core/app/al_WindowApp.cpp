@@ -37,10 +37,17 @@ void WindowApp::start() {
   Window::create(is_verbose);
   onCreate();
   FPS::startFPS();
+  FrameProfiler& prof = FPS::profiler();
   while (!shouldQuit()) {
+    prof.begin("animate");
     onAnimate(dt_sec());
+    prof.end();
+    prof.begin("draw");
     onDraw(mGraphics);
+    prof.end();
+    prof.begin("swap");
     Window::refresh();
+    prof.end();
     FPS::tickFPS();
   }
   onExit();
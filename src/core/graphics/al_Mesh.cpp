@@ -1,12 +1,14 @@
 #include <algorithm> // transform
+#include <atomic>
 #include <cctype> // tolower
-#include <map>
-#include <set>
 #include <string>
 #include <vector>
 #include <fstream>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
 #include "al/core/graphics/al_Mesh.hpp"
+#include "al/core/graphics/al_MeshTopology.hpp"
 #include "al/core/system/al_Printing.hpp"
 
 namespace al{
@@ -169,6 +171,124 @@ void Mesh::invertNormals() {
   for(int i=0; i<Nv; ++i) normals()[i] = -normals()[i];
 }
 
+namespace{
+
+// Integer cell of a quantized position
+struct WeldCell{
+  int32_t x, y, z;
+  bool operator==(const WeldCell& c) const { return x==c.x && y==c.y && z==c.z; }
+};
+
+uint32_t weldHash(const WeldCell& c){
+  uint32_t h = uint32_t(c.x)*73856093u ^ uint32_t(c.y)*19349663u ^ uint32_t(c.z)*83492791u;
+  return h * 0x9E3779B1u;
+}
+
+// Open addressing hash table from cells to lists of representative vertices.
+// Cells and list links are stored per vertex outside of the table.
+class WeldTable{
+public:
+  typedef Mesh::Index Index;
+  static const Index none = ~Index(0);
+
+  WeldTable(const std::vector<WeldCell>& cells, std::vector<Index>& next)
+  :  mCells(cells), mNext(next)
+  {
+    mSlots.assign(1024, Slot{0, none});
+    mMask = mSlots.size()-1;
+  }
+
+  // Get lowest representative in a cell for which match(rep) is true
+  template <class Match>
+  Index find(const WeldCell& c, uint32_t h, Match match) const {
+    for(size_t i = h & mMask; ; i = (i+1) & mMask){
+      const Slot& s = mSlots[i];
+      if(s.head == none) return none;
+      if(s.hash == h && mCells[s.head] == c){
+        Index best = none;
+        for(Index v = s.head; v != none; v = mNext[v]){
+          if(v < best && match(v)) best = v;
+        }
+        return best;
+      }
+    }
+  }
+
+  // Add a representative vertex to its cell
+  void insert(Index v, uint32_t h){
+    const WeldCell& c = mCells[v];
+    for(size_t i = h & mMask; ; i = (i+1) & mMask){
+      Slot& s = mSlots[i];
+      if(s.head == none){
+        mNext[v] = none;
+        s.hash = h;
+        s.head = v;
+        // The table grows with the number of cells, which for typical meshes
+        // is much smaller than the number of vertices
+        if(++mNumCells*4 > mSlots.size()) grow();
+        return;
+      }
+      if(s.hash == h && mCells[s.head] == c){
+        mNext[v] = s.head;
+        s.head = v;
+        return;
+      }
+    }
+  }
+
+private:
+  struct Slot{ uint32_t hash; Index head; };
+  const std::vector<WeldCell>& mCells;
+  std::vector<Index>& mNext;
+  std::vector<Slot> mSlots;
+  size_t mMask;
+  size_t mNumCells = 0;
+
+  void grow(){
+    std::vector<Slot> old(mSlots.size()*2, Slot{0, none});
+    old.swap(mSlots);
+    mMask = mSlots.size()-1;
+    for(const auto& s : old){
+      if(s.head == none) continue;
+      size_t i = s.hash & mMask;
+      while(mSlots[i].head != none) i = (i+1) & mMask;
+      mSlots[i] = s;
+    }
+  }
+};
+
+const WeldTable::Index WeldTable::none;
+
+template <int N>
+bool attributeClose(const Vec<N,float>& a, const Vec<N,float>& b, float eps){
+  for(int i=0; i<N; ++i){
+    if(!(std::abs(a[i] - b[i]) <= eps)) return false;
+  }
+  return true;
+}
+
+bool attributeClose(float a, float b, float eps){
+  return std::abs(a - b) <= eps;
+}
+
+bool attributeClose(const Color& a, const Color& b, float eps){
+  return attributeClose(Vec4f(a.r, a.g, a.b, a.a), Vec4f(b.r, b.g, b.b, b.a), eps);
+}
+
+// Keep elements of a buffer for vertices that were not merged. Those are
+// the vertices numbered in sequence, as merged vertices map to lower indices.
+template <class T>
+void compactBuffer(std::vector<T>& buf, const std::vector<Mesh::Index>& remap, size_t Nv, size_t count){
+  if(buf.size() != Nv) return;
+  size_t k = 0;
+  for(size_t i=0; i<Nv; ++i){
+    if(remap[i] == k) buf[k++] = buf[i];
+  }
+  buf.resize(count);
+}
+
+} // anonymous namespace
+
 void Mesh::compress() {
 
   int Ni = indices().size();
@@ -181,60 +301,169 @@ void Mesh::compress() {
     AL_WARN_ONCE("cannot compress Mesh with no vertices");
     return;
   }
+  weld(0);
+}
 
-  int Nc = colors().size();
-  int Nn = normals().size();
-  int Nt1 = texCoord1s().size();
-  int Nt2 = texCoord2s().size();
-  int Nt3 = texCoord3s().size();
-
-  // map tree to uniquely ID vertices with same values:
-  typedef std::map<float, int> Zmap;
-  typedef std::map<float, Zmap> Ymap;
-  typedef std::map<float, Ymap> Xmap;
-  Xmap xmap;
-
-  // copy current values:
-  Mesh old(*this);
+size_t Mesh::weld(float epsilon, int attributes, float attributeEpsilon, unsigned numThreads) {
+  typedef WeldTable::Index Idx;
+  const Idx none = WeldTable::none;
+  const size_t Nv = vertices().size();
+  if(0 == Nv) return 0;
+
+  // Attributes are compared only when they have one element per vertex
+  const bool cmpNormals = (attributes & WELD_NORMALS) && normals().size() == Nv;
+  const bool cmpColors = (attributes & WELD_COLORS) && colors().size() == Nv;
+  const bool cmpTex1 = (attributes & WELD_TEXCOORDS) && texCoord1s().size() == Nv;
+  const bool cmpTex2 = (attributes & WELD_TEXCOORDS) && texCoord2s().size() == Nv;
+  const bool cmpTex3 = (attributes & WELD_TEXCOORDS) && texCoord3s().size() == Nv;
+  const bool exact = epsilon <= 0;
+  const float eps2 = epsilon*epsilon;
+  const Vertices& verts = vertices();
+
+  auto matches = [&](Idx a, Idx b){
+    if(exact){
+      if(!(verts[a] == verts[b])) return false;
+    }
+    else if((verts[a] - verts[b]).magSqr() > eps2){
+      return false;
+    }
+    float ae = attributeEpsilon;
+    if(cmpNormals && !attributeClose(normals()[a], normals()[b], ae)) return false;
+    if(cmpColors && !attributeClose(colors()[a], colors()[b], ae)) return false;
+    if(cmpTex1 && !attributeClose(texCoord1s()[a], texCoord1s()[b], ae)) return false;
+    if(cmpTex2 && !attributeClose(texCoord2s()[a], texCoord2s()[b], ae)) return false;
+    if(cmpTex3 && !attributeClose(texCoord3s()[a], texCoord3s()[b], ae)) return false;
+    return true;
+  };
 
-  // walk backward through the vertex list
-  // create a ID for each one
-  for (int i=vertices().size()-1; i>=0; i--) {
-    Vertex& v = vertices()[i];
-    xmap[v.x][v.y][v.z] = i;
+  // Quantize positions. With a tolerance, cells are 2*epsilon wide so that
+  // vertices within epsilon are in the same cell or in the adjacent cell on
+  // the side of the nearer cell face, which is stored as one bit per axis.
+  std::vector<WeldCell> cells(Nv);
+  std::vector<uint32_t> hashes(Nv);
+  std::vector<uint8_t> sides(exact ? 0 : Nv);
+  const double invCell = exact ? 0 : 0.5/epsilon;
+  parallelRanges(Nv, numThreads, [&](size_t begin, size_t end){
+    for(size_t i=begin; i<end; ++i){
+      const Vertex& v = verts[i];
+      WeldCell& c = cells[i];
+      if(exact){
+        // Positions are used bitwise, with -0 the same as 0
+        int32_t k[3];
+        for(int j=0; j<3; ++j){
+          float x = v[j] == 0.f ? 0.f : v[j];
+          std::memcpy(&k[j], &x, 4);
+        }
+        c = WeldCell{k[0], k[1], k[2]};
+      }
+      else{
+        int32_t k[3];
+        uint8_t side = 0;
+        for(int j=0; j<3; ++j){
+          double q = v[j] * invCell;
+          double f = std::floor(q);
+          // Out of range positions share a cell and are still compared exactly
+          if(!(f > -2147483647.) ) f = -2147483647.;
+          if(f > 2147483646.) f = 2147483646.;
+          k[j] = int32_t(f);
+          if(q - f >= 0.5) side |= 1<<j;
+        }
+        c = WeldCell{k[0], k[1], k[2]};
+        sides[i] = side;
+      }
+      hashes[i] = weldHash(c);
+    }
+  });
+
+  // Each vertex is mapped to its representative, the first vertex it matches
+  std::vector<Idx> rep(Nv);
+  std::vector<Idx> next(Nv);
+
+  if(exact && attributeEpsilon <= 0){
+    // Matching is transitive, so chunks can be welded independently and then
+    // only chunk representatives welded together. This gives the same result
+    // as welding serially.
+    std::atomic<int> numChunks(0);
+    parallelRanges(Nv, numThreads, [&](size_t begin, size_t end){
+      ++numChunks;
+      WeldTable local(cells, next);
+      for(size_t i=begin; i<end; ++i){
+        Idx r = local.find(cells[i], hashes[i], [&](Idx j){ return matches(j, Idx(i)); });
+        if(r == none){
+          local.insert(Idx(i), hashes[i]);
+          rep[i] = Idx(i);
+        }
+        else rep[i] = r;
+      }
+    });
+    // With one chunk, there is nothing more to weld
+    WeldTable table(cells, next);
+    for(size_t i=0; i<Nv && numChunks > 1; ++i){
+      if(rep[i] != i){
+        rep[i] = rep[rep[i]];
+        continue;
+      }
+      Idx r = table.find(cells[i], hashes[i], [&](Idx j){ return matches(j, Idx(i)); });
+      if(r == none) table.insert(Idx(i), hashes[i]);
+      else rep[i] = r;
+    }
+  }
+  else{
+    WeldTable table(cells, next);
+    for(size_t i=0; i<Nv; ++i){
+      Idx r = none;
+      if(exact){
+        r = table.find(cells[i], hashes[i], [&](Idx j){ return matches(j, Idx(i)); });
+      }
+      else{
+        // Search the 8 cells on the sides nearest to the vertex
+        const WeldCell& c = cells[i];
+        uint8_t side = sides[i];
+        for(int n=0; n<8; ++n){
+          WeldCell nc = {
+            c.x + ((n&1) ? ((side&1) ? 1 : -1) : 0),
+            c.y + ((n&2) ? ((side&2) ? 1 : -1) : 0),
+            c.z + ((n&4) ? ((side&4) ? 1 : -1) : 0)
+          };
+          Idx cand = table.find(nc, n ? weldHash(nc) : hashes[i], [&](Idx j){ return j < r && matches(j, Idx(i)); });
+          if(cand != none) r = cand;
+        }
+      }
+      if(r == none){
+        table.insert(Idx(i), hashes[i]);
+        rep[i] = Idx(i);
+      }
+      else rep[i] = r;
+    }
   }
 
-  // map of old vertex index to new vertex index:
-  typedef std::map<int, int> Imap;
-  Imap imap;
-
+  // Number vertices in order. Representatives precede the vertices merged
+  // into them, so rep can be overwritten with the new index.
+  Idx count = 0;
+  for(size_t i=0; i<Nv; ++i){
+    Idx r = rep[i];
+    rep[i] = (r == i) ? count++ : rep[r];
+  }
 
-  // reset current mesh:
-  reset();
+  compactBuffer(vertices(), rep, Nv, count);
+  compactBuffer(normals(), rep, Nv, count);
+  compactBuffer(colors(), rep, Nv, count);
+  compactBuffer(texCoord1s(), rep, Nv, count);
+  compactBuffer(texCoord2s(), rep, Nv, count);
+  compactBuffer(texCoord3s(), rep, Nv, count);
 
-  // walk forward, inserting if
-  for (size_t i=0; i<old.vertices().size(); i++) {
-    Vertex& v = old.vertices()[i];
-    int idx = xmap[v.x][v.y][v.z];
-    Imap::iterator it = imap.find(idx);
-    if (it != imap.end()) {
-      // use existing
-      index(it->second);
-    } else {
-      // create new
-      int newidx = vertices().size();
-      vertex(v);
-      if (Nc) color(old.colors()[i]);
-      if (Nn) normal(old.normals()[i]);
-      if (Nt1) texCoord(old.texCoord1s()[i]);
-      if (Nt2) texCoord(old.texCoord2s()[i]);
-      if (Nt3) texCoord(old.texCoord3s()[i]);
-      // store new index:
-      imap[idx] = newidx;
-      // use new index:
-      index(newidx);
-    }
+  if(indices().empty()){
+    indices() = rep;
+  }
+  else{
+    Indices& inds = indices();
+    parallelRanges(inds.size(), numThreads, [&](size_t begin, size_t end){
+      for(size_t k=begin; k<end; ++k){
+        if(inds[k] < Nv) inds[k] = rep[inds[k]];
+      }
+    });
   }
+  return Nv - count;
 }
 
 void Mesh::generateNormals(bool normalize, bool equalWeightPerFace) {
@@ -471,54 +700,9 @@ void Mesh::ribbonize(float * widths, int widthsStride, bool faceBinormal){
 
 
 void Mesh::smooth(float amount, int weighting){
-  std::map<int, std::set<int>> nodes;
-
-  int Ni = indices().size();
-
-  // Build adjacency map
-  for(int i=0; i<Ni; i+=3){
-    int i0 = indices()[i  ];
-    int i1 = indices()[i+1];
-    int i2 = indices()[i+2];
-    nodes[i0].insert(i1);
-    nodes[i0].insert(i2);
-    nodes[i1].insert(i2);
-    nodes[i1].insert(i0);
-    nodes[i2].insert(i0);
-    nodes[i2].insert(i1);
-  }
-
-  Mesh::Vertices vertsCopy(vertices());
-
-  for(const auto& node: nodes){
-    Mesh::Vertex sum(0,0,0);
-    const auto& adjs = node.second;
-
-    switch(weighting){
-    case 0: { // equal weighting
-      for(auto adj : adjs){
-        sum += vertsCopy[adj];
-      }
-      sum /= adjs.size();
-    } break;
-
-    case 1: { // inverse distance weights; reduces vertex sliding
-      float sumw = 0;
-      for(auto adj : adjs){
-        const auto& v = vertsCopy[adj];
-        const auto& c = vertsCopy[node.first];
-        float dist = (v-c).mag();
-        float w = 1./dist;
-        sumw += w;
-        sum += v * w;
-      }
-      sum /= sumw;
-    } break;
-    }
-
-    auto& orig = vertices()[node.first];
-    orig = (sum-orig)*amount + orig;
-  }
+  MeshTopology topology;
+  topology.build(indices().data(), indices().size(), vertices().size());
+  topology.smooth(*this, amount, weighting);
 }
 
 
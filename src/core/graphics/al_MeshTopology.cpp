@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <thread>
+#include "al/core/graphics/al_MeshTopology.hpp"
+
+namespace al{
+
+const MeshTopology::Index MeshTopology::none;
+
+void parallelRanges(size_t n, unsigned numThreads, const std::function<void(size_t, size_t)>& f){
+  if(0 == numThreads) numThreads = std::thread::hardware_concurrency();
+  // Starting a thread costs about as much as processing a few thousand items
+  size_t maxThreads = (n + 4095) / 4096;
+  if(numThreads > maxThreads) numThreads = unsigned(maxThreads);
+
+  if(numThreads <= 1){
+    if(n) f(0, n);
+    return;
+  }
+
+  size_t chunk = (n + numThreads - 1) / numThreads;
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads - 1);
+  for(unsigned t=1; t<numThreads; ++t){
+    size_t begin = std::min(n, t*chunk);
+    size_t end = std::min(n, begin + chunk);
+    threads.emplace_back(f, begin, end);
+  }
+  f(0, chunk);
+  for(auto& t : threads) t.join();
+}
+
+
+bool MeshTopology::build(const Mesh& m){
+  if(m.primitive() != Mesh::TRIANGLES || m.indices().empty()){
+    build(nullptr, 0, m.vertices().size());
+    return false;
+  }
+  build(m.indices().data(), m.indices().size(), m.vertices().size());
+  return true;
+}
+
+void MeshTopology::build(const Index * indices, size_t numIndices, size_t numVertices){
+  size_t Nc = numIndices - numIndices%3; // number of face corners
+  mNumVertices = numVertices;
+  mFaces.assign(indices, indices + Nc);
+
+  // Sort the edge leaving each corner by its lower, then its higher vertex to
+  // find unique edges. A counting sort on the lower vertex leaves only a few
+  // corners per bucket, which are then insertion sorted on the higher vertex.
+  // Both sorts are stable, so corners of an edge stay in ascending order.
+  mSortOffsets.assign(numVertices + 1, 0);
+  mCornerMin.resize(Nc);
+  mCornerMax.resize(Nc);
+  for(size_t f=0; f<Nc; f+=3){
+    for(int i=0; i<3; ++i){
+      Index a = mFaces[f + i];
+      Index b = mFaces[f + (i==2 ? 0 : i+1)];
+      if(a > b) std::swap(a, b);
+      mCornerMin[f + i] = a;
+      mCornerMax[f + i] = b;
+      ++mSortOffsets[a + 1];
+    }
+  }
+  for(size_t v=0; v<numVertices; ++v) mSortOffsets[v+1] += mSortOffsets[v];
+  mSortedCorners.resize(Nc);
+  for(size_t c=0; c<Nc; ++c){
+    mSortedCorners[mSortOffsets[mCornerMin[c]]++] = Index(c);
+  }
+  // Offsets were advanced to the end of each bucket
+  for(size_t v=numVertices; v>0; --v) mSortOffsets[v] = mSortOffsets[v-1];
+  mSortOffsets[0] = 0;
+  for(size_t v=0; v<numVertices; ++v){
+    Index * bucket = &mSortedCorners[0] + mSortOffsets[v];
+    Index n = mSortOffsets[v+1] - mSortOffsets[v];
+    for(Index i=1; i<n; ++i){
+      Index c = bucket[i];
+      Index key = mCornerMax[c];
+      Index j = i;
+      for(; j>0 && mCornerMax[bucket[j-1]] > key; --j) bucket[j] = bucket[j-1];
+      bucket[j] = c;
+    }
+  }
+
+  mEdges.clear();
+  mEdges.reserve(Nc/2 + 1);
+  mEdgeCorners.clear();
+  mEdgeCorners.reserve(Nc + 2);
+  mFaceEdges.resize(Nc);
+  unsigned edgeFaces = 0;
+  Edge prev{none, none};
+  for(size_t i=0; i<Nc; ++i){
+    Index c = mSortedCorners[i];
+    Edge e{mCornerMin[c], mCornerMax[c]};
+    if(e.v0 != prev.v0 || e.v1 != prev.v1){
+      mEdges.push_back(e);
+      mEdgeCorners.push_back(c);
+      mEdgeCorners.push_back(none);
+      edgeFaces = 1;
+      prev = e;
+    }
+    else{
+      // A third face makes the edge non-manifold, which is treated as boundary
+      mEdgeCorners.back() = (++edgeFaces == 2) ? c : none;
+    }
+    mFaceEdges[c] = Index(mEdges.size() - 1);
+  }
+
+  // Vertex neighbors. Edges are sorted, so each vertex receives its lower
+  // neighbors, then its higher neighbors, both in ascending order.
+  mNeighborOffsets.assign(numVertices + 1, 0);
+  for(const auto& e : mEdges){
+    if(e.v0 == e.v1) continue;
+    ++mNeighborOffsets[e.v0 + 1];
+    ++mNeighborOffsets[e.v1 + 1];
+  }
+  for(size_t v=0; v<numVertices; ++v) mNeighborOffsets[v+1] += mNeighborOffsets[v];
+  mNeighbors.resize(mNeighborOffsets[numVertices]);
+  for(const auto& e : mEdges){
+    if(e.v0 == e.v1) continue;
+    mNeighbors[mNeighborOffsets[e.v0]++] = e.v1;
+    mNeighbors[mNeighborOffsets[e.v1]++] = e.v0;
+  }
+  // Offsets were advanced to the end of each range; shift them back
+  for(size_t v=numVertices; v>0; --v) mNeighborOffsets[v] = mNeighborOffsets[v-1];
+  mNeighborOffsets[0] = 0;
+
+  // Faces around each vertex, in ascending order
+  mVertexFaceOffsets.assign(numVertices + 1, 0);
+  for(size_t c=0; c<Nc; ++c) ++mVertexFaceOffsets[mFaces[c] + 1];
+  for(size_t v=0; v<numVertices; ++v) mVertexFaceOffsets[v+1] += mVertexFaceOffsets[v];
+  mVertexFaces.resize(Nc);
+  for(size_t c=0; c<Nc; ++c) mVertexFaces[mVertexFaceOffsets[mFaces[c]]++] = Index(c/3);
+  for(size_t v=numVertices; v>0; --v) mVertexFaceOffsets[v] = mVertexFaceOffsets[v-1];
+  mVertexFaceOffsets[0] = 0;
+}
+
+
+void MeshTopology::smooth(Mesh& m, float amount, int weighting, unsigned numThreads) const {
+  const Mesh::Vertices vertsCopy(m.vertices());
+  Mesh::Vertices& verts = m.vertices();
+  size_t Nv = std::min(mNumVertices, verts.size());
+
+  parallelRanges(Nv, numThreads, [&](size_t begin, size_t end){
+    for(size_t v=begin; v<end; ++v){
+      unsigned n = valence(Index(v));
+      if(0 == n) continue;
+      const Index * adjs = neighbors(Index(v));
+      Mesh::Vertex sum(0,0,0);
+
+      switch(weighting){
+      case 0: { // equal weighting
+        for(unsigned k=0; k<n; ++k){
+          sum += vertsCopy[adjs[k]];
+        }
+        sum /= n;
+      } break;
+
+      case 1: { // inverse distance weights; reduces vertex sliding
+        float sumw = 0;
+        const auto& c = vertsCopy[v];
+        for(unsigned k=0; k<n; ++k){
+          const auto& a = vertsCopy[adjs[k]];
+          float dist = (a-c).mag();
+          float w = 1./dist;
+          sumw += w;
+          sum += a * w;
+        }
+        sum /= sumw;
+      } break;
+      }
+
+      auto& orig = verts[v];
+      orig = (sum-orig)*amount + orig;
+    }
+  });
+}
+
+
+void MeshTopology::generateNormals(Mesh& m, bool normalize, bool equalWeightPerFace, unsigned numThreads) const {
+  const Mesh::Vertices& verts = m.vertices();
+  size_t Nv = verts.size();
+
+  // need at least one triangle
+  if(Nv < 3) return;
+
+  m.normals().assign(Nv, Mesh::Normal(0,0,0));
+
+  std::vector<Mesh::Normal> faceNormals(numFaces());
+  parallelRanges(numFaces(), numThreads, [&](size_t begin, size_t end){
+    for(size_t f=begin; f<end; ++f){
+      const Index * corner = &mFaces[f*3];
+      const auto& v1 = verts[corner[0]];
+      Mesh::Normal vn = cross(verts[corner[1]]-v1, verts[corner[2]]-v1);
+      if(equalWeightPerFace) vn.normalize();
+      faceNormals[f] = vn;
+    }
+  });
+
+  // Summing faces in ascending order gives the same result as Mesh
+  parallelRanges(Nv, numThreads, [&](size_t begin, size_t end){
+    size_t endTopo = std::min(end, mNumVertices);
+    for(size_t v=begin; v<endTopo; ++v){
+      Mesh::Normal& n = m.normals()[v];
+      const Index * faces = vertexFaces(Index(v));
+      for(unsigned k=0, N=numVertexFaces(Index(v)); k<N; ++k){
+        n += faceNormals[faces[k]];
+      }
+    }
+    if(normalize) for(size_t v=begin; v<end; ++v) m.normals()[v].normalize();
+  });
+}
+
+} // al::
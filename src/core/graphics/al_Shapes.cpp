@@ -1,6 +1,6 @@
-#include <map>
 #include <math.h>
 #include "al/core/math/al_Constants.hpp"
+#include "al/core/graphics/al_MeshTopology.hpp"
 #include "al/core/graphics/al_Shapes.hpp"
 
 /*
@@ -281,39 +281,34 @@ int addIcosahedron(Mesh& m, float radius){
 // TODO: add as method to Mesh?
 void subdivide(Mesh& m, unsigned iterations, bool normalize){
 
-  typedef std::map<uint64_t, unsigned> PointToIndex;
-
   if(m.primitive() != Mesh::TRIANGLES) return;
 
+  MeshTopology topology;
+  std::vector<Mesh::Index> midIndex;
+
   for(unsigned k=0; k<iterations; ++k){
 
-    PointToIndex middlePointIndexCache;
+    topology.build(m.indices().data(), m.indices().size(), m.vertices().size());
+    const Mesh::Indices& oldIndices = topology.faces();
 
+    // Midpoints are numbered in the order their edges are first used
     Mesh::Index newIndex = m.vertices().size();
-    Mesh::Indices oldIndices(m.indices());
+    midIndex.assign(topology.numEdges(), MeshTopology::none);
+    m.vertices().reserve(m.vertices().size() + topology.numEdges());
     m.indices().clear();
+    m.indices().reserve(oldIndices.size()*4);
 
     // Iterate through triangles
     for(unsigned j=0; j<(unsigned)oldIndices.size(); j+=3){
 
-      //printf("%u %u\n", k, j);
-
-      Mesh::Index * corner = &oldIndices[j];
+      const Mesh::Index * corner = &oldIndices[j];
       Mesh::Index mid[3];
 
       for(unsigned i=0; i<3; ++i){
-        uint64_t i1 = corner[ i     ];
-        uint64_t i2 = corner[(i+1)%3];
-        uint64_t key = i1 < i2 ? (i1<<32) | i2 : (i2<<32) | i1;
-
-        PointToIndex::iterator it = middlePointIndexCache.find(key);
-        if(it != middlePointIndexCache.end()){
-          mid[i] = it->second;
-        }
-        else{
-          middlePointIndexCache.insert(std::make_pair(key, newIndex));
-          Mesh::Vertex v1 = m.vertices()[i1];
-          Mesh::Vertex v2 = m.vertices()[i2];
+        Mesh::Index e = topology.faceEdge(j/3, i);
+        if(midIndex[e] == MeshTopology::none){
+          Mesh::Vertex v1 = m.vertices()[corner[ i     ]];
+          Mesh::Vertex v2 = m.vertices()[corner[(i+1)%3]];
           Mesh::Vertex vm;
           if(normalize){
             vm = v1 + v2;
@@ -326,9 +321,10 @@ void subdivide(Mesh& m, unsigned iterations, bool normalize){
           }
           m.vertex(vm);
           // TODO: other attributes (colors, normals, etc.)
-          mid[i] = newIndex;
+          midIndex[e] = newIndex;
           ++newIndex;
         }
+        mid[i] = midIndex[e];
       }
 
       Mesh::Index newIndices[] = {
@@ -343,6 +339,98 @@ void subdivide(Mesh& m, unsigned iterations, bool normalize){
   }
 }
 
+void subdivideLoop(Mesh& m, unsigned iterations, unsigned numThreads){
+
+  if(m.primitive() != Mesh::TRIANGLES) return;
+
+  typedef Mesh::Index Index;
+  MeshTopology topology;
+  Mesh::Vertices newVertices;
+  Mesh::Indices newIndices;
+  std::vector<unsigned> boundaryCount;
+  std::vector<Index> boundaryNeighbors;
+
+  for(unsigned k=0; k<iterations; ++k){
+
+    topology.build(m.indices().data(), m.indices().size(), m.vertices().size());
+    const Mesh::Vertices& V = m.vertices();
+    const size_t Nv = V.size();
+    const size_t Ne = topology.numEdges();
+    const size_t Nf = topology.numFaces();
+
+    // Neighbors of each vertex along boundary edges
+    boundaryCount.assign(Nv, 0);
+    boundaryNeighbors.assign(Nv*2, MeshTopology::none);
+    for(size_t e=0; e<Ne; ++e){
+      const auto& edge = topology.edges()[e];
+      if(!topology.isBoundary(e) || edge.v0 == edge.v1) continue;
+      Index ends[2] = {edge.v0, edge.v1};
+      for(int i=0; i<2; ++i){
+        Index v = ends[i];
+        if(boundaryCount[v] < 2) boundaryNeighbors[v*2 + boundaryCount[v]] = ends[1-i];
+        ++boundaryCount[v];
+      }
+    }
+
+    newVertices.resize(Nv + Ne);
+
+    // Even vertices: old vertices moved towards their neighbors
+    parallelRanges(Nv, numThreads, [&](size_t begin, size_t end){
+      for(size_t v=begin; v<end; ++v){
+        unsigned n = topology.valence(v);
+        if(boundaryCount[v] == 0 && n > 0){
+          const Index * adjs = topology.neighbors(v);
+          Mesh::Vertex sum(0,0,0);
+          for(unsigned i=0; i<n; ++i) sum += V[adjs[i]];
+          double c = 3./8. + cos(2.*M_PI/n)/4.;
+          float beta = (5./8. - c*c)/n;
+          newVertices[v] = V[v]*(1.f - n*beta) + sum*beta;
+        }
+        else if(boundaryCount[v] == 2){
+          const Index * b = &boundaryNeighbors[v*2];
+          newVertices[v] = V[v]*0.75f + (V[b[0]] + V[b[1]])*0.125f;
+        }
+        else{ // isolated vertex or corner where boundaries meet
+          newVertices[v] = V[v];
+        }
+      }
+    });
+
+    // Odd vertices: one on each edge
+    parallelRanges(Ne, numThreads, [&](size_t begin, size_t end){
+      for(size_t e=begin; e<end; ++e){
+        const auto& edge = topology.edges()[e];
+        Mesh::Vertex& vm = newVertices[Nv + e];
+        if(topology.isBoundary(e)){
+          vm = (V[edge.v0] + V[edge.v1])*0.5f;
+        }
+        else{
+          vm = (V[edge.v0] + V[edge.v1])*0.375f
+             + (V[topology.edgeOpposite(e,0)] + V[topology.edgeOpposite(e,1)])*0.125f;
+        }
+      }
+    });
+
+    // Each triangle is split into four
+    newIndices.resize(Nf*12);
+    parallelRanges(Nf, numThreads, [&](size_t begin, size_t end){
+      for(size_t f=begin; f<end; ++f){
+        const Index * corner = &topology.faces()[f*3];
+        Index mid[3];
+        for(int i=0; i<3; ++i) mid[i] = Index(Nv + topology.faceEdge(f, i));
+        Index * dst = &newIndices[f*12];
+        dst[ 0] = corner[0]; dst[ 1] = mid[0]; dst[ 2] = mid[2];
+        dst[ 3] = corner[1]; dst[ 4] = mid[1]; dst[ 5] = mid[0];
+        dst[ 6] = corner[2]; dst[ 7] = mid[2]; dst[ 8] = mid[1];
+        dst[ 9] = mid[0];    dst[10] = mid[1]; dst[11] = mid[2];
+      }
+    });
+
+    m.vertices().swap(newVertices);
+    m.indices().swap(newIndices);
+  }
+}
+
 int addIcosphere(Mesh& m, double radius, int divisions){
   int Nv = m.vertices().size();
   addIcosahedron(m, radius);
@@ -268,6 +268,20 @@ void Texture::submit(const void *pixels, unsigned int format, unsigned int type)
   unbind_temp();
 }
 
+void Texture::submitRegion(const void *pixels, unsigned int x, unsigned int y,
+                           unsigned int w, unsigned int h,
+                           unsigned int format, unsigned int type) {
+  if (target() != GL_TEXTURE_2D) {
+    AL_WARN("invalid texture target %d", target());
+    return;
+  }
+  bind_temp();
+  glTexSubImage2D(target(), 0, x, y, w, h, format, type, pixels);
+  update_filter();
+  update_wrap();
+  unbind_temp();
+}
+
 bool Texture::resize(unsigned int w, unsigned int h, int internalFormat, unsigned int format, unsigned int type) {
   if (target() != GL_TEXTURE_2D) {
     AL_WARN("invalid geometry for texture 2D target");
@@ -0,0 +1,208 @@
+#include "al/core/io/al_AudioCallbackProfiler.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace al;
+
+const int AudioCallbackProfiler::maxSections;
+const int AudioCallbackProfiler::histogramBins;
+const int AudioCallbackProfiler::maxXrunTimes;
+
+AudioCallbackProfiler::AudioCallbackProfiler() : mStartTime(now()) {
+  for (auto &bin : mHistogram) {
+    bin.store(0);
+  }
+  for (auto &time : mXrunTimes) {
+    time.store(0.0);
+  }
+  mSections[VOICES].name = "voices";
+  mSections[SPATIALIZER].name = "spatializer";
+  mSections[POST_PROCESSING].name = "postProcessing";
+  mSections[OUTPUT_MASTER].name = "outputMaster";
+}
+
+int AudioCallbackProfiler::addSection(const std::string &name) {
+  std::unique_lock<std::mutex> lk(mSectionLock);
+  int index = mNumSections.load();
+  if (index >= maxSections) {
+    return -1;
+  }
+  mSections[index].name = name;
+  mNumSections.store(index + 1);
+  return index;
+}
+
+void AudioCallbackProfiler::endCallback(double periodSeconds) {
+  // Only the audio thread writes these, so load and store is enough
+  int64_t duration = now() - mCallbackStart;
+  applyReset();
+  double load = duration * 1e-9 / periodSeconds;
+  int bin = std::min(int(load * (histogramBins - 1) / 2.0), histogramBins - 1);
+  mHistogram[bin].store(mHistogram[bin].load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+  if (load > 1.0) {
+    mLateCallbacks.store(mLateCallbacks.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+  }
+  mLoadSum.store(mLoadSum.load(std::memory_order_relaxed) + load,
+                 std::memory_order_relaxed);
+  if (load > mMaxLoad.load(std::memory_order_relaxed)) {
+    mMaxLoad.store(load, std::memory_order_relaxed);
+  }
+
+  int numSections = mNumSections.load(std::memory_order_relaxed);
+  for (int i = 0; i < numSections; i++) {
+    SectionData &section = mSections[i];
+    int64_t time = section.current.exchange(0, std::memory_order_relaxed);
+    if (time > 0) {
+      section.callbacks.store(section.callbacks.load(std::memory_order_relaxed) + 1,
+                              std::memory_order_relaxed);
+      section.totalNanos.store(section.totalNanos.load(std::memory_order_relaxed) + time,
+                               std::memory_order_relaxed);
+      if (uint64_t(time) > section.maxNanos.load(std::memory_order_relaxed)) {
+        section.maxNanos.store(time, std::memory_order_relaxed);
+      }
+    }
+  }
+  mCallbacks.store(mCallbacks.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+}
+
+void AudioCallbackProfiler::reportXrun() {
+  applyReset();
+  uint64_t count = mXruns.load(std::memory_order_relaxed);
+  mXrunTimes[count % maxXrunTimes].store((now() - mStartTime) * 1e-9,
+                                         std::memory_order_relaxed);
+  mXruns.store(count + 1, std::memory_order_release);
+}
+
+AudioCallbackProfiler::Stats AudioCallbackProfiler::stats() const {
+  Stats s;
+  if (mResetRequested.load(std::memory_order_acquire)) {
+    // Not cleared by the audio thread yet
+    s.callbacks = s.lateCallbacks = s.xruns = 0;
+    s.meanLoad = s.maxLoad = 0.0;
+    s.histogram.assign(histogramBins, 0);
+    int numSections = mNumSections.load();
+    for (int i = 0; i < numSections; i++) {
+      s.sections.push_back({mSections[i].name, 0, 0.0, 0.0});
+    }
+    return s;
+  }
+  s.callbacks = mCallbacks.load(std::memory_order_acquire);
+  s.lateCallbacks = mLateCallbacks.load(std::memory_order_relaxed);
+  s.meanLoad = s.callbacks > 0 ? mLoadSum.load(std::memory_order_relaxed) / s.callbacks : 0.0;
+  s.maxLoad = mMaxLoad.load(std::memory_order_relaxed);
+  for (auto &bin : mHistogram) {
+    s.histogram.push_back(bin.load(std::memory_order_relaxed));
+  }
+  s.xruns = mXruns.load(std::memory_order_acquire);
+  uint64_t numTimes = std::min<uint64_t>(s.xruns, maxXrunTimes);
+  for (uint64_t i = s.xruns - numTimes; i < s.xruns; i++) {
+    s.xrunTimes.push_back(mXrunTimes[i % maxXrunTimes].load(std::memory_order_relaxed));
+  }
+  int numSections = mNumSections.load();
+  for (int i = 0; i < numSections; i++) {
+    const SectionData &section = mSections[i];
+    SectionStats sectionStats;
+    sectionStats.name = section.name;
+    sectionStats.callbacks = section.callbacks.load(std::memory_order_relaxed);
+    sectionStats.meanSeconds =
+        sectionStats.callbacks > 0
+            ? section.totalNanos.load(std::memory_order_relaxed) * 1e-9 / sectionStats.callbacks
+            : 0.0;
+    sectionStats.maxSeconds = section.maxNanos.load(std::memory_order_relaxed) * 1e-9;
+    s.sections.push_back(sectionStats);
+  }
+  return s;
+}
+
+void AudioCallbackProfiler::reset() {
+  mResetRequested.store(true, std::memory_order_release);
+}
+
+void AudioCallbackProfiler::applyReset() {
+  // Exchanged first so that a reset requested while clearing is not lost
+  if (!mResetRequested.exchange(false, std::memory_order_acq_rel)) {
+    return;
+  }
+  mCallbacks.store(0, std::memory_order_relaxed);
+  mLateCallbacks.store(0, std::memory_order_relaxed);
+  mLoadSum.store(0.0, std::memory_order_relaxed);
+  mMaxLoad.store(0.0, std::memory_order_relaxed);
+  for (auto &bin : mHistogram) {
+    bin.store(0, std::memory_order_relaxed);
+  }
+  mXruns.store(0, std::memory_order_relaxed);
+  for (auto &section : mSections) {
+    section.callbacks.store(0, std::memory_order_relaxed);
+    section.totalNanos.store(0, std::memory_order_relaxed);
+    section.maxNanos.store(0, std::memory_order_relaxed);
+  }
+}
+
+void AudioCallbackProfiler::replyAddress(const std::string &address) {
+  std::unique_lock<std::mutex> lk(mReplyLock);
+  mReplyAddress = address;
+}
+
+void AudioCallbackProfiler::send(osc::Send &sender, const std::string &rootOSCPath) {
+  Stats s = stats();
+  // OSC has no unsigned 64 bit type, counts are sent as 32 bit ints
+  sender.send(rootOSCPath + "/callbacks", int(s.callbacks), int(s.lateCallbacks));
+  sender.send(rootOSCPath + "/load", float(s.meanLoad), float(s.maxLoad));
+  sender.beginMessage(rootOSCPath + "/histogram");
+  for (auto count : s.histogram) {
+    sender << int(count);
+  }
+  sender.endMessage();
+  sender.send();
+  sender.beginMessage(rootOSCPath + "/xruns");
+  sender << int(s.xruns);
+  for (auto time : s.xrunTimes) {
+    sender << float(time);
+  }
+  sender.endMessage();
+  sender.send();
+  for (auto &section : s.sections) {
+    sender.send(rootOSCPath + "/section", section.name, int(section.callbacks),
+                float(section.meanSeconds), float(section.maxSeconds));
+  }
+}
+
+bool AudioCallbackProfiler::consumeMessage(osc::Message &m, std::string rootOSCPath) {
+  if (m.addressPattern() == rootOSCPath + "/enable" && m.typeTags() == "i") {
+    int value;
+    m >> value;
+    enable(value != 0);
+    return true;
+  } else if (m.addressPattern() == rootOSCPath + "/reset") {
+    reset();
+    return true;
+  } else if (m.addressPattern() == rootOSCPath + "/request") {
+    // Only reply to the sender or to the configured address, so that the
+    // server can't be used to send packets to arbitrary hosts
+    std::string address = m.senderAddress();
+    int port;
+    if (m.typeTags() == "si") {
+      std::string requested;
+      m >> requested >> port;
+      std::unique_lock<std::mutex> lk(mReplyLock);
+      if (requested != address && (mReplyAddress.empty() || requested != mReplyAddress)) {
+        std::cerr << "ERROR: AudioCallbackProfiler: request from " << address
+                  << " to send stats to " << requested << " ignored" << std::endl;
+        return true;
+      }
+      address = requested;
+    } else if (m.typeTags() == "i") {
+      m >> port;
+    } else {
+      return false;
+    }
+    osc::Send sender(port, address.c_str());
+    send(sender, rootOSCPath);
+    return true;
+  }
+  return false;
+}
@@ -10,6 +10,7 @@
 #include <string>
 
 #include "al/core/io/al_AudioIO.hpp"
+#include "al/core/io/al_AudioOutputStage.hpp"
 
 #ifdef AL_AUDIO_RTAUDIO
 #include "RtAudio.h"
@@ -403,6 +404,10 @@ static int paCallback(const void *input, void *output, unsigned long frameCount,
   AudioIO &io = *(AudioIO *)userData;
 
   assert(frameCount == (unsigned)io.framesPerBuffer());
+  if (statusFlags & (paInputOverflow | paOutputUnderflow)) {
+    io.reportUnderflow();
+  }
+
   const float **inBuffers = (const float **)input;
   for (int i = 0; i < io.channelsInDevice(); i++) {
     memcpy(const_cast<float *>(&io.in(i, 0)), inBuffers[i],
@@ -413,49 +418,11 @@ static int paCallback(const void *input, void *output, unsigned long frameCount,
 
   io.processAudio();  // call callback
 
-  // apply smoothly-ramped gain to all output channels
-  if (io.usingGain()) {
-    float dgain = (io.mGain - io.mGainPrev) / frameCount;
-
-    for (int j = 0; j < io.channelsOutDevice(); ++j) {
-      float *out = io.outBuffer(j);
-      float gain = io.mGainPrev;
-
-      for (unsigned i = 0; i < frameCount; ++i) {
-        out[i] *= gain;
-        gain += dgain;
-      }
-    }
-
-    io.mGainPrev = io.mGain;
-  }
-
-  // kill pesky nans so we don't hurt anyone's ears
-  if (io.zeroNANs()) {
-    for (unsigned i = 0; i < unsigned(frameCount * io.channelsOutDevice());
-         ++i) {
-      float &s = (&io.out(0, 0))[i];
-      // if(isnan(s)) s = 0.f;
-      if (s != s) s = 0.f;  // portable isnan; only nans do not equal themselves
-    }
-  }
-
-  if (io.clipOut()) {
-    for (unsigned i = 0; i < unsigned(frameCount * io.channelsOutDevice());
-         ++i) {
-      float &s = (&io.out(0, 0))[i];
-      if (s < -1.f)
-        s = -1.f;
-      else if (s > 1.f)
-        s = 1.f;
-    }
-  }
-
-  float **outBuffers = (float **)output;
-  for (int i = 0; i < io.channelsOutDevice(); i++) {
-    memcpy(outBuffers[i], const_cast<float *>(&io.out(i, 0)),
-           frameCount * sizeof(float));
-  }
+  // apply smoothly-ramped gain, kill pesky nans and clip in a single pass
+  AudioOutputStage::planar(io.outputStageFlags(), io.outBuffer(0),
+                           (float **)output, io.channelsOutDevice(),
+                           frameCount, io.mGainPrev, io.mGain);
+  io.mGainPrev = io.mGain;
 
   return 0;
 }
@@ -662,74 +629,30 @@ int AudioBackend::numDevices() {
 static int rtaudioCallback(void *output, void *input, unsigned int frameCount,
                            double streamTime, RtAudioStreamStatus status,
                            void *userData) {
+  AudioIO &io = *(AudioIO *)userData;
+
   if (status) {
-    std::cout << "Stream underflow detected!" << std::endl;
+    io.reportUnderflow();
   }
 
-  AudioIO &io = *(AudioIO *)userData;
-
   assert(frameCount == (unsigned)io.framesPerBuffer());
 
   if (input != NULL) {
-	  const float *inBuffers = (const float *)input;
-	  float *hwInBuffer = const_cast<float *>(io.inBuffer(0));
-      for (unsigned int frame = 0; frame < io.framesPerBuffer(); frame++) {
-		  for (int i = 0; i < io.channelsInDevice(); i++) {
-			  hwInBuffer[i * frameCount + frame] = *inBuffers++;
-		  }
-	  }
+    AudioOutputStage::deinterleave((const float *)input,
+                                   const_cast<float *>(io.inBuffer(0)),
+                                   io.channelsInDevice(), frameCount);
   }
 
   if (io.autoZeroOut()) io.zeroOut();
 
   io.processAudio();  // call callback
 
-  // apply smoothly-ramped gain to all output channels
-  if (io.usingGain()) {
-    float dgain = (io.mGain - io.mGainPrev) / frameCount;
-
-    for (int j = 0; j < io.channelsOutDevice(); ++j) {
-      float *out = io.outBuffer(j);
-      float gain = io.mGainPrev;
-
-      for (unsigned i = 0; i < frameCount; ++i) {
-        out[i] *= gain;
-        gain += dgain;
-      }
-    }
-
-    io.mGainPrev = io.mGain;
-  }
-
-  // kill pesky nans so we don't hurt anyone's ears
-  if (io.zeroNANs()) {
-    for (unsigned i = 0; i < unsigned(frameCount * io.channelsOutDevice());
-         ++i) {
-      float &s = (&io.out(0, 0))[i];
-      // if(isnan(s)) s = 0.f;
-      if (s != s) s = 0.f;  // portable isnan; only nans do not equal themselves
-    }
-  }
-
-  if (io.clipOut()) {
-    for (unsigned i = 0; i < unsigned(frameCount * io.channelsOutDevice());
-         ++i) {
-      float &s = (&io.out(0, 0))[i];
-      if (s < -1.f)
-        s = -1.f;
-      else if (s > 1.f)
-        s = 1.f;
-    }
-  }
-
-  float *outBuffers = (float *)output;
-
-  float *finalOutBuffer = const_cast<float *>(io.outBuffer(0));
-  for (unsigned int frame = 0; frame < io.framesPerBuffer(); frame++) {
-    for (int i = 0; i < io.channelsOutDevice(); i++) {
-      *outBuffers++ = finalOutBuffer[i * frameCount + frame];
-    }
-  }
+  // apply smoothly-ramped gain, kill pesky nans, clip and interleave in a
+  // single pass
+  AudioOutputStage::interleave(io.outputStageFlags(), io.outBuffer(0),
+                               (float *)output, io.channelsOutDevice(),
+                               frameCount, io.mGainPrev, io.mGain);
+  io.mGainPrev = io.mGain;
 
   return 0;
 }
@@ -942,7 +865,9 @@ AudioIO::AudioIO()
       mClipOut(true),
       mAutoZeroOut(true),
       mBackend{std::make_unique<AudioBackend>()}
-{}
+{
+  mProfiler = &mCallbackProfiler;
+}
 
 AudioIO::~AudioIO() { close(); }
 
@@ -1081,7 +1006,7 @@ void AudioIO::device(const AudioDevice &v) {
 }
 
 void AudioIO::channelsBus(int num) {
-  if (mBackend->isOpen()) {
+  if (isOpen()) {
     warn("the number of channels cannnot be set with the stream open",
          "AudioIO");
     return;
@@ -1093,12 +1018,16 @@ void AudioIO::channelsBus(int num) {
 void AudioIO::channels(int num, bool forOutput) {
   // printf("Requested %d %s channels\n", num, forOutput?"output":"input");
 
-  if (mBackend->isOpen()) {
+  if (isOpen()) {
     warn("the number of channels cannnot be set with the stream open",
          "AudioIO");
     return;
   }
-  mBackend->channels(num, forOutput);
+  if (mOffline) {
+    mOffline->channels(num, forOutput);
+  } else {
+    mBackend->channels(num, forOutput);
+  }
 
   if (num == -1) { // Open all device channels?
     num = (forOutput ? channelsOutDevice() : channelsInDevice());
@@ -1107,12 +1036,35 @@ void AudioIO::channels(int num, bool forOutput) {
   AudioIOData::channels(num, forOutput);
 }
 
-int AudioIO::channelsInDevice() const { return (int)mBackend->inDeviceChans(); }
+int AudioIO::channelsInDevice() const {
+  if (mOffline) return mOffline->inDeviceChans();
+  return (int)mBackend->inDeviceChans();
+}
 int AudioIO::channelsOutDevice() const {
+  if (mOffline) return mOffline->outDeviceChans();
   return (int)mBackend->outDeviceChans();
 }
 
+void AudioIO::offline(const OfflineAudioConfig &config) {
+  int chansIn = channelsInDevice();
+  int chansOut = channelsOutDevice();
+  close();
+  mOffline = std::make_unique<OfflineAudioBackend>(config);
+  mOffline->channels(chansIn, false);
+  mOffline->channels(chansOut, true);
+}
+
+void AudioIO::online() {
+  if (mOffline) {
+    mOffline->close();
+    mOffline = nullptr;
+  }
+}
+
 bool AudioIO::close() {
+  if (mOffline) {
+    return mOffline->close();
+  }
   if (mBackend != nullptr) {
     return mBackend->close();
   } else {
@@ -1121,14 +1073,17 @@ bool AudioIO::close() {
 }
 
 bool AudioIO::open() {
+  if (mOffline) {
+    return mOffline->open(mFramesPerSecond, mFramesPerBuffer, this);
+  }
   return mBackend->open(mFramesPerSecond, mFramesPerBuffer, this);
 }
 
 void AudioIO::reopen() {
-  if (mBackend->isRunning()) {
+  if (isRunning()) {
     close();
     start();
-  } else if (mBackend->isOpen()) {
+  } else if (isOpen()) {
     close();
     open();
   }
@@ -1143,7 +1098,7 @@ void AudioIO::framesPerSecond(double v) {  // printf("AudioIO::fps(%f)\n", v);
 }
 
 void AudioIO::framesPerBuffer(unsigned int n) {
-  if (mBackend->isOpen()) {
+  if (isOpen()) {
     warn("the number of frames/buffer cannnot be set with the stream open",
          "AudioIO");
     return;
@@ -1153,13 +1108,26 @@ void AudioIO::framesPerBuffer(unsigned int n) {
 }
 
 bool AudioIO::start() {
-  if (!mBackend->isOpen()) open();
+  if (!isOpen()) open();
+  if (mOffline) {
+    return mOffline->start();
+  }
   return mBackend->start(mFramesPerSecond, mFramesPerBuffer, this);
 }
 
-bool AudioIO::stop() { return mBackend->stop(); }
+bool AudioIO::stop() {
+  if (mOffline) {
+    return mOffline->stop();
+  }
+  return mBackend->stop();
+}
 
-bool AudioIO::supportsFPS(double fps) { return mBackend->supportsFPS(fps); }
+bool AudioIO::supportsFPS(double fps) {
+  if (mOffline) {
+    return fps > 0;
+  }
+  return mBackend->supportsFPS(fps);
+}
 
 void AudioIO::print() const {
   if (mInDevice.id() == mOutDevice.id()) {
@@ -1183,6 +1151,9 @@ void AudioIO::print() const {
 
 // void AudioIO::processAudio(){ frame(0); if(callback) callback(*this); }
 void AudioIO::processAudio() {
+  bool profiling = mCallbackProfiler.enabled();
+  if (profiling) mCallbackProfiler.beginCallback();
+
   frame(0);
   if (callback) callback(*this);
 
@@ -1191,26 +1162,50 @@ void AudioIO::processAudio() {
     frame(0);
     (*iter++)->onAudioCB(*this);
   }
+
+  if (profiling) {
+    mCallbackProfiler.endCallback(mFramesPerBuffer / mFramesPerSecond);
+  }
 }
 
 bool AudioIO::isOpen()
 {
+    if (mOffline) {
+      return mOffline->isOpen();
+    }
     return mBackend->isOpen();
 }
 
 bool AudioIO::isRunning()
 {
+    if (mOffline) {
+      return mOffline->isRunning();
+    }
     return mBackend->isRunning();
 }
 
-double AudioIO::cpu() const { return mBackend->cpu(); }
+double AudioIO::cpu() const {
+  if (mOffline) {
+    return mOffline->cpu();
+  }
+  return mBackend->cpu();
+}
 bool AudioIO::zeroNANs() const { return mZeroNANs; }
 
+int AudioIO::outputStageFlags() const {
+  return (usingGain() ? AudioOutputStage::GAIN : 0) |
+         (mZeroNANs ? AudioOutputStage::ZERO_NANS : 0) |
+         (mClipOut ? AudioOutputStage::CLIP : 0);
+}
+
 void AudioIO::clipOut(bool v) {
     mClipOut = v;
 }
 
 double AudioIO::time() const {
+  if (mOffline) {
+    return mOffline->time();
+  }
   assert(mBackend);
   return mBackend->time();
 }
@@ -0,0 +1,271 @@
+#include "al/core/io/al_AudioOutputStage.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AL_OUTPUT_STAGE_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AL_OUTPUT_STAGE_NEON
+#endif
+
+using namespace al;
+
+namespace {
+
+// Scalar version of the processing, used for remainders and as fallback.
+// Clipping lets NaNs through, as the original comparisons did.
+template <int F>
+inline float processSample(float s, float gain) {
+  if (F & AudioOutputStage::GAIN) s *= gain;
+  if (F & AudioOutputStage::ZERO_NANS) {
+    if (s != s) s = 0.f;  // only nans do not equal themselves
+  }
+  if (F & AudioOutputStage::CLIP) {
+    if (s < -1.f)
+      s = -1.f;
+    else if (s > 1.f)
+      s = 1.f;
+  }
+  return s;
+}
+
+#if defined(AL_OUTPUT_STAGE_SSE)
+
+typedef __m128 Vec4;
+
+inline Vec4 load4(const float *p) { return _mm_loadu_ps(p); }
+inline void store4(float *p, Vec4 v) { _mm_storeu_ps(p, v); }
+inline Vec4 ramp4(float start, float step) {
+  return _mm_set_ps(start + 3 * step, start + 2 * step, start + step, start);
+}
+
+template <int F>
+inline Vec4 process4(Vec4 v, Vec4 gain) {
+  if (F & AudioOutputStage::GAIN) v = _mm_mul_ps(v, gain);
+  if (F & AudioOutputStage::ZERO_NANS) v = _mm_and_ps(v, _mm_cmpeq_ps(v, v));
+  if (F & AudioOutputStage::CLIP) {
+    // With a NaN operand min/max return the second operand, so NaNs pass
+    v = _mm_max_ps(_mm_set1_ps(-1.f), v);
+    v = _mm_min_ps(_mm_set1_ps(1.f), v);
+  }
+  return v;
+}
+
+inline void transpose4(Vec4 &r0, Vec4 &r1, Vec4 &r2, Vec4 &r3) {
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+inline void zip2(Vec4 &r0, Vec4 &r1) {
+  Vec4 low = _mm_unpacklo_ps(r0, r1);
+  r1 = _mm_unpackhi_ps(r0, r1);
+  r0 = low;
+}
+
+#elif defined(AL_OUTPUT_STAGE_NEON)
+
+typedef float32x4_t Vec4;
+
+inline Vec4 load4(const float *p) { return vld1q_f32(p); }
+inline void store4(float *p, Vec4 v) { vst1q_f32(p, v); }
+inline Vec4 ramp4(float start, float step) {
+  float values[4] = {start, start + step, start + 2 * step, start + 3 * step};
+  return vld1q_f32(values);
+}
+
+template <int F>
+inline Vec4 process4(Vec4 v, Vec4 gain) {
+  if (F & AudioOutputStage::GAIN) v = vmulq_f32(v, gain);
+  if (F & AudioOutputStage::ZERO_NANS) {
+    v = vreinterpretq_f32_u32(
+        vandq_u32(vreinterpretq_u32_f32(v), vceqq_f32(v, v)));
+  }
+  if (F & AudioOutputStage::CLIP) {
+    // NEON min/max propagate NaNs
+    v = vmaxq_f32(v, vdupq_n_f32(-1.f));
+    v = vminq_f32(v, vdupq_n_f32(1.f));
+  }
+  return v;
+}
+
+inline void transpose4(Vec4 &r0, Vec4 &r1, Vec4 &r2, Vec4 &r3) {
+  float32x4x2_t t01 = vtrnq_f32(r0, r1);
+  float32x4x2_t t23 = vtrnq_f32(r2, r3);
+  r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+  r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+  r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+  r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+inline void zip2(Vec4 &r0, Vec4 &r1) {
+  float32x4x2_t z = vzipq_f32(r0, r1);
+  r0 = z.val[0];
+  r1 = z.val[1];
+}
+
+#endif
+
+#if defined(AL_OUTPUT_STAGE_SSE) || defined(AL_OUTPUT_STAGE_NEON)
+#define AL_OUTPUT_STAGE_SIMD
+#endif
+
+template <int F>
+void interleaveKernel(const float *src, float *dst, int channels, int frames,
+                      float gain, float dgain) {
+  int frame = 0;
+#ifdef AL_OUTPUT_STAGE_SIMD
+  // Process blocks of 4 channels x 4 frames, transposing each block so both
+  // reads and writes are contiguous
+  for (; frame + 4 <= frames; frame += 4) {
+    float frameGain = gain + dgain * frame;
+    Vec4 gains = ramp4(frameGain, dgain);
+    float *out = dst + frame * channels;
+    int chan = 0;
+    for (; chan + 4 <= channels; chan += 4) {
+      const float *in = src + chan * frames + frame;
+      Vec4 r0 = process4<F>(load4(in), gains);
+      Vec4 r1 = process4<F>(load4(in + frames), gains);
+      Vec4 r2 = process4<F>(load4(in + 2 * frames), gains);
+      Vec4 r3 = process4<F>(load4(in + 3 * frames), gains);
+      transpose4(r0, r1, r2, r3);
+      store4(out + chan, r0);
+      store4(out + channels + chan, r1);
+      store4(out + 2 * channels + chan, r2);
+      store4(out + 3 * channels + chan, r3);
+    }
+    if (chan + 2 == channels) {
+      // Stereo, or two channels left over
+      const float *in = src + chan * frames + frame;
+      Vec4 r0 = process4<F>(load4(in), gains);
+      Vec4 r1 = process4<F>(load4(in + frames), gains);
+      zip2(r0, r1);
+      float low[4], high[4];
+      store4(low, r0);
+      store4(high, r1);
+      if (channels == 2) {
+        store4(out, r0);
+        store4(out + 4, r1);
+      } else {
+        for (int i = 0; i < 2; i++) {
+          out[i * channels + chan] = low[2 * i];
+          out[i * channels + chan + 1] = low[2 * i + 1];
+          out[(i + 2) * channels + chan] = high[2 * i];
+          out[(i + 2) * channels + chan + 1] = high[2 * i + 1];
+        }
+      }
+      chan += 2;
+    }
+    for (; chan < channels; chan++) {
+      const float *in = src + chan * frames + frame;
+      for (int i = 0; i < 4; i++) {
+        out[i * channels + chan] = processSample<F>(in[i], frameGain + dgain * i);
+      }
+    }
+  }
+#endif
+  for (; frame < frames; frame++) {
+    float frameGain = gain + dgain * frame;
+    float *out = dst + frame * channels;
+    for (int chan = 0; chan < channels; chan++) {
+      out[chan] = processSample<F>(src[chan * frames + frame], frameGain);
+    }
+  }
+}
+
+template <int F>
+void planarKernel(const float *src, float *const *dst, int channels,
+                  int frames, float gain, float dgain) {
+  for (int chan = 0; chan < channels; chan++) {
+    const float *in = src + chan * frames;
+    float *out = dst[chan];
+    if (F == 0) {
+      memcpy(out, in, frames * sizeof(float));
+      continue;
+    }
+    int frame = 0;
+#ifdef AL_OUTPUT_STAGE_SIMD
+    for (; frame + 4 <= frames; frame += 4) {
+      Vec4 gains = ramp4(gain + dgain * frame, dgain);
+      store4(out + frame, process4<F>(load4(in + frame), gains));
+    }
+#endif
+    for (; frame < frames; frame++) {
+      out[frame] = processSample<F>(in[frame], gain + dgain * frame);
+    }
+  }
+}
+
+typedef void (*InterleaveKernel)(const float *, float *, int, int, float, float);
+typedef void (*PlanarKernel)(const float *, float *const *, int, int, float, float);
+
+const InterleaveKernel interleaveKernels[8] = {
+    interleaveKernel<0>, interleaveKernel<1>, interleaveKernel<2>,
+    interleaveKernel<3>, interleaveKernel<4>, interleaveKernel<5>,
+    interleaveKernel<6>, interleaveKernel<7>};
+
+const PlanarKernel planarKernels[8] = {
+    planarKernel<0>, planarKernel<1>, planarKernel<2>, planarKernel<3>,
+    planarKernel<4>, planarKernel<5>, planarKernel<6>, planarKernel<7>};
+
+}  // namespace
+
+void AudioOutputStage::interleave(int flags, const float *src, float *dst,
+                                  int channels, int frames, float gainStart,
+                                  float gainEnd) {
+  if (frames <= 0) return;
+  float dgain = (gainEnd - gainStart) / frames;
+  interleaveKernels[flags & 7](src, dst, channels, frames, gainStart, dgain);
+}
+
+void AudioOutputStage::planar(int flags, const float *src, float *const *dst,
+                              int channels, int frames, float gainStart,
+                              float gainEnd) {
+  if (frames <= 0) return;
+  float dgain = (gainEnd - gainStart) / frames;
+  planarKernels[flags & 7](src, dst, channels, frames, gainStart, dgain);
+}
+
+void AudioOutputStage::deinterleave(const float *src, float *dst,
+                                    int channels, int frames) {
+  int frame = 0;
+#ifdef AL_OUTPUT_STAGE_SIMD
+  for (; frame + 4 <= frames; frame += 4) {
+    const float *in = src + frame * channels;
+    int chan = 0;
+    for (; chan + 4 <= channels; chan += 4) {
+      Vec4 r0 = load4(in + chan);
+      Vec4 r1 = load4(in + channels + chan);
+      Vec4 r2 = load4(in + 2 * channels + chan);
+      Vec4 r3 = load4(in + 3 * channels + chan);
+      transpose4(r0, r1, r2, r3);
+      float *out = dst + chan * frames + frame;
+      store4(out, r0);
+      store4(out + frames, r1);
+      store4(out + 2 * frames, r2);
+      store4(out + 3 * frames, r3);
+    }
+    for (; chan < channels; chan++) {
+      for (int i = 0; i < 4; i++) {
+        dst[chan * frames + frame + i] = in[i * channels + chan];
+      }
+    }
+  }
+#endif
+  for (; frame < frames; frame++) {
+    for (int chan = 0; chan < channels; chan++) {
+      dst[chan * frames + frame] = src[frame * channels + chan];
+    }
+  }
+}
+
+const char *AudioOutputStage::instructionSet() {
+#if defined(AL_OUTPUT_STAGE_SSE)
+  return "SSE2";
+#elif defined(AL_OUTPUT_STAGE_NEON)
+  return "NEON";
+#else
+  return "scalar";
+#endif
+}
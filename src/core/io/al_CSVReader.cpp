@@ -1,13 +1,223 @@
 #include <cassert>
 #include <cctype>
+#include <cstdlib>
+#include <functional>
+#include <thread>
 
 #include "al/core/io/al_CSVReader.hpp"
 
-CSVReader::~CSVReader() {
-  for (auto row: mData) {
-    delete[] row;
+#ifndef AL_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Read only view of a whole file. Uses mmap where available, otherwise
+// reads the file into memory.
+class MappedFile {
+public:
+  ~MappedFile() {
+#ifndef AL_WINDOWS
+    if (mMapped) {
+      munmap(mMapped, mSize);
+    }
+#endif
+  }
+
+  bool open(const std::string &fileName) {
+#ifndef AL_WINDOWS
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      ::close(fd);
+      return false;
+    }
+    mSize = info.st_size;
+    if (mSize > 0) {
+      void *mem = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mem == MAP_FAILED) {
+        ::close(fd);
+        return false;
+      }
+      mMapped = static_cast<char *>(mem);
+      madvise(mMapped, mSize, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+    mData = mMapped;
+    return true;
+#else
+    std::ifstream f(fileName, std::ios::binary | std::ios::ate);
+    if (!f.is_open()) {
+      return false;
+    }
+    mSize = (size_t) f.tellg();
+    f.seekg(0, std::ios::beg);
+    mBuffer.resize(mSize);
+    f.read(mBuffer.data(), mSize);
+    mData = mBuffer.data();
+    return !f.bad();
+#endif
   }
-  mData.clear();
+
+  const char *data() const { return mData; }
+  size_t size() const { return mSize; }
+
+private:
+  const char *mData {nullptr};
+  size_t mSize {0};
+#ifndef AL_WINDOWS
+  char *mMapped {nullptr};
+#else
+  std::vector<char> mBuffer;
+#endif
+};
+
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+inline bool isBlank(char c) { return c == ' ' || c == '\t'; }
+
+// End of line without trailing carriage return
+inline const char *lineEnd(const char *begin, const char *end, const char **next) {
+  const char *newline = static_cast<const char *>(memchr(begin, '\n', end - begin));
+  if (!newline) {
+    newline = end;
+    *next = end;
+  } else {
+    *next = newline + 1;
+  }
+  if (newline > begin && *(newline - 1) == '\r') {
+    newline--;
+  }
+  return newline;
+}
+
+double parseRealSlow(const char *begin, const char *end) {
+  char buffer[64];
+  size_t length = end - begin;
+  if (length < sizeof(buffer)) {
+    memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+    return std::strtod(buffer, nullptr);
+  }
+  return std::strtod(std::string(begin, end).c_str(), nullptr);
+}
+
+// Exact for values whose significant digits and power of ten are both
+// exactly representable as doubles, which covers most data written with a
+// fixed number of decimals. Other values are passed to strtod.
+double parseReal(const char *begin, const char *end) {
+  static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const char *p = begin;
+  while (p < end && isBlank(*p)) {
+    p++;
+  }
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+  }
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool anyDigits = false;
+  while (p < end && isDigit(*p)) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      if (mantissa) {
+        digits++;
+      }
+    } else {
+      return parseRealSlow(begin, end);
+    }
+    anyDigits = true;
+    p++;
+  }
+  if (p < end && *p == '.') {
+    p++;
+    while (p < end && isDigit(*p)) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa) {
+          digits++;
+        }
+        exponent--;
+      } else {
+        return parseRealSlow(begin, end);
+      }
+      anyDigits = true;
+      p++;
+    }
+  }
+  if (!anyDigits) {
+    return parseRealSlow(begin, end); // inf, nan or not a number
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    bool negativeExponent = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      negativeExponent = *p == '-';
+      p++;
+    }
+    if (p == end || !isDigit(*p)) {
+      return parseRealSlow(begin, end);
+    }
+    int value = 0;
+    while (p < end && isDigit(*p)) {
+      if (value > 10000) {
+        return parseRealSlow(begin, end);
+      }
+      value = value * 10 + (*p - '0');
+      p++;
+    }
+    exponent += negativeExponent ? -value : value;
+  }
+  if (mantissa > (uint64_t(1) << 53) || exponent < -22 || exponent > 22) {
+    return parseRealSlow(begin, end);
+  }
+  double value = (double) mantissa;
+  if (exponent < 0) {
+    value /= powersOfTen[-exponent];
+  } else {
+    value *= powersOfTen[exponent];
+  }
+  return negative ? -value : value;
+}
+
+int64_t parseInteger(const char *begin, const char *end) {
+  const char *p = begin;
+  while (p < end && isBlank(*p)) {
+    p++;
+  }
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+  }
+  int64_t value = 0;
+  while (p < end && isDigit(*p)) {
+    value = value * 10 + (*p - '0');
+    p++;
+  }
+  return negative ? -value : value;
+}
+
+bool fieldEquals(const char *begin, const char *end, const char *text) {
+  size_t length = strlen(text);
+  return (size_t) (end - begin) == length && memcmp(begin, text, length) == 0;
+}
+
+} // namespace
+
+CSVReader::~CSVReader() {
 }
 
 bool CSVReader::readFile(std::string fileName, bool hasColumnNames) {
@@ -18,207 +228,201 @@ bool CSVReader::readFile(std::string fileName, bool hasColumnNames) {
       fileName = mBasePath + "/" + fileName;
     }
   }
-  std::ifstream f(fileName);
-  if (!f.is_open()) {
+  MappedFile f;
+  if (!f.open(fileName)) {
     std::cout << "Could not open:" << fileName << std::endl;
     return false;
   }
 
   mColumnNames.clear();
-  mData.clear();
+  mColumns.clear();
+  mColumnTypes = mDataTypes;
+  mNumRows = 0;
 
-  std::string line;
-  size_t rowLength = calculateRowLength();
+  if (f.size() == 0) {
+    return true;
+  }
+  const char *data = f.data();
+  const char *end = data + f.size();
+  const char *next;
+
+  const char *namesBegin = data;
+  const char *namesEnd = data;
+  if (hasColumnNames) {
+    namesEnd = lineEnd(data, end, &next);
+    data = next;
+  }
 
+  // Infer separator from first line of data
+  const char *firstLineEnd = lineEnd(data, end, &next);
+  bool commaSeparated = std::find(data, firstLineEnd, ',') != firstLineEnd;
 
-  // Infer separator
-  bool commaSeparated = false;
-  {
-    if (hasColumnNames) {
-      getline(f, line);
-    }
-    getline(f, line); // Infer from first line of data
-    if (std::count(line.begin(), line.end(), ',') > 0) {
-      commaSeparated = true;
+  const char *p = namesBegin;
+  while (p < namesEnd) {
+    const char *fieldEnd = std::find(p, namesEnd, commaSeparated ? ',' : ' ');
+    if (commaSeparated || fieldEnd > p) {
+      mColumnNames.push_back(std::string(p, fieldEnd));
     }
-    // Reset file
-    f.clear();
-    f.seekg(0, std::ios::beg);
+    p = fieldEnd + 1;
   }
 
-  if (hasColumnNames) {
-    getline(f, line);
-    std::stringstream columnNameStream(line);
-    std::string columnName;
-    if (commaSeparated) {
-      while (std::getline(columnNameStream, columnName, ',')) {
-        mColumnNames.push_back(columnName);
-      }
-    } else {
-      while (std::getline(columnNameStream, columnName, ' ')) {
-        if (columnName.size() > 0) {
-          mColumnNames.push_back(columnName);
-        }
+  // Split into chunks that start at the beginning of a line
+  unsigned int numThreads = mNumThreads > 0 ? mNumThreads : std::thread::hardware_concurrency();
+  const size_t minChunkSize = 1 << 20;
+  size_t dataSize = end - data;
+  if (numThreads == 0 || dataSize < minChunkSize * 2) {
+    numThreads = 1;
+  }
+  numThreads = (unsigned int) std::min<size_t>(numThreads, dataSize / minChunkSize + 1);
+  std::vector<const char *> chunkStart {data};
+  for (unsigned int i = 1; i < numThreads; i++) {
+    const char *p = std::max(data + dataSize * i / numThreads, chunkStart.back());
+    const char *newline = static_cast<const char *>(memchr(p, '\n', end - p));
+    chunkStart.push_back(newline ? newline + 1 : end);
+  }
+  chunkStart.push_back(end);
+
+  auto runChunks = [&](std::function<void(size_t)> function) {
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; i++) {
+      threads.push_back(std::thread(function, i));
+    }
+    function(0);
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  };
+
+  // Count rows in each chunk to know where each chunk writes in the columns
+  std::vector<size_t> chunkRows(numThreads + 1, 0);
+  runChunks([&](size_t chunk) {
+    size_t count = 0;
+    const char *p = chunkStart[chunk];
+    while (p < chunkStart[chunk + 1]) {
+      const char *lineNext;
+      if (lineEnd(p, chunkStart[chunk + 1], &lineNext) > p) {
+        count++;
       }
+      p = lineNext;
     }
+    chunkRows[chunk + 1] = count;
+  });
+  for (unsigned int i = 0; i < numThreads; i++) {
+    chunkRows[i + 1] += chunkRows[i];
   }
+  mNumRows = chunkRows.back();
 
-  //	std::cout << line << std::endl;
-  while (getline(f, line)) {
-    if (line.size() == 0) {
+  for (auto type : mColumnTypes) {
+    mColumns.push_back(std::vector<char>(mNumRows * typeSize(type), 0));
+  }
+
+  runChunks([&](size_t chunk) {
+    parseLines(chunkStart[chunk], chunkStart[chunk + 1], chunkRows[chunk], commaSeparated);
+  });
+  return true;
+}
+
+void CSVReader::parseLines(const char *begin, const char *end, size_t firstRow, bool commaSeparated) {
+  size_t row = firstRow;
+  const char *p = begin;
+  while (p < end) {
+    const char *next;
+    const char *lineEndPos = lineEnd(p, end, &next);
+    if (lineEndPos == p) {
+      p = next;
       continue;
     }
-    std::stringstream ss(line);
-    char * row = new char[rowLength];
-    memset(row, 0, rowLength);
-    mData.push_back(row);
     if (commaSeparated) {
-      if ((unsigned long) std::count(line.begin(), line.end(), ',') == mDataTypes.size() - 1) { // Check that we have enough commas
-        int byteCount = 0;
-        for(auto type:mDataTypes) {
-          std::string field;
-          std::getline(ss, field, ',');
-          size_t stringLen = std::min(maxStringSize - 1, field.size());
-          int32_t intValue;
-          double doubleValue;
-          bool booleanValue;
-          auto data = row + byteCount;
-          assert((size_t)(data - mData.back()) < rowLength);
-          switch (type){
-          case STRING:
-            std::memcpy(data, field.data(), stringLen * sizeof (char));
-            byteCount += maxStringSize * sizeof (char);
-            break;
-          case INTEGER:
-            intValue = std::atoi(field.data());
-            std::memcpy(data, &intValue, sizeof (int64_t));
-            byteCount += sizeof (int64_t);
-            break;
-          case REAL:
-            doubleValue = std::atof(field.data());
-            std::memcpy(data, &doubleValue, sizeof (double));
-            byteCount += sizeof (double);
-            break;
-          case BOOLEAN:
-            booleanValue = field == "True" || field == "true" || field == "1";
-            std::memcpy(data, &booleanValue, sizeof (bool));
-            byteCount += sizeof (bool);
-            break;
-          case IGNORE_COLUMN:
-            break;
-          }
+      // Rows without the right number of fields are left empty
+      if ((size_t) std::count(p, lineEndPos, ',') == mColumnTypes.size() - 1) {
+        const char *field = p;
+        for (size_t column = 0; column < mColumnTypes.size(); column++) {
+          const char *fieldEnd = std::find(field, lineEndPos, ',');
+          parseField(field, fieldEnd, column, row);
+          field = fieldEnd + 1;
         }
       }
     } else { // Space separated
-      int byteCount = 0;
-      for(auto type:mDataTypes) {
-        std::string field;
-        while (field.size() == 0) {
-          std::getline(ss, field, ' ');
-          if (ss.eof()) {
-            break;
-          }
+      const char *field = p;
+      for (size_t column = 0; column < mColumnTypes.size(); column++) {
+        while (field < lineEndPos && isBlank(*field)) {
+          field++;
         }
-        if (field.size() == 0) {
+        if (field >= lineEndPos) {
           break;
         }
-        // Trim white space from start
-        field.erase(field.begin(), std::find_if(field.begin(), field.end(), [](int ch) {
-          return !std::isspace(ch);
-        }));
-        // Trim white space from end
-        field.erase(std::find_if(field.rbegin(), field.rend(), [](int ch) {
-          return !std::isspace(ch);
-        }).base(), field.end());
-        size_t stringLen = std::min(maxStringSize - 1, field.size());
-        int32_t intValue;
-        double doubleValue;
-        bool booleanValue;
-
-        auto data = row + byteCount;
-        assert((size_t) (data - mData.back()) < rowLength);
-        switch (type){
-        case STRING:
-          std::memcpy(data, field.data(), stringLen * sizeof (char));
-          byteCount += maxStringSize * sizeof (char);
-          break;
-        case INTEGER:
-          intValue = std::atoi(field.data());
-          std::memcpy(data, &intValue, sizeof (int64_t));
-          byteCount += sizeof (int64_t);
-          break;
-        case REAL:
-          doubleValue = std::atof(field.data());
-          std::memcpy(data, &doubleValue, sizeof (double));
-          byteCount += sizeof (double);
-          break;
-        case BOOLEAN:
-          booleanValue = field == "True" || field == "true" || field == "1";
-          std::memcpy(data, &booleanValue, sizeof (bool));
-          byteCount += sizeof (bool);
-          break;
-        case IGNORE_COLUMN:
-          break;
+        const char *fieldEnd = field;
+        while (fieldEnd < lineEndPos && !isBlank(*fieldEnd)) {
+          fieldEnd++;
         }
+        parseField(field, fieldEnd, column, row);
+        field = fieldEnd;
       }
     }
+    row++;
+    p = next;
   }
-  f.close();
-  //        if (f.bad()) {
-  //                std::cout << "Error ____ reading:" << fileName << std::endl;
-  //        }
-  return !f.bad();
 }
 
-std::vector<double> CSVReader::getColumn(int index) {
-	std::vector<double> out;
-	int offset = 0;
-	for (int i = 0; i < index; i++) {
-		switch (mDataTypes[i]){
-		case STRING:
-			offset += maxStringSize * sizeof (char);
-			break;
-		case INTEGER:
-			offset += sizeof (int64_t);
-			break;
-		case REAL:
-			offset += sizeof (double);
-			break;
-		case BOOLEAN:
-			offset += sizeof (bool);
-			break;
-        case IGNORE_COLUMN:
-			break;
-		}
-	}
-//	std::cout << offset << std::endl;
-	for (auto row: mData) {
-		double *val = (double *)(row + offset);
-		out.push_back(*val);
+void CSVReader::parseField(const char *begin, const char *end, size_t column, size_t row) {
+  char *data = mColumns[column].data();
+  switch (mColumnTypes[column]) {
+  case STRING:
+    std::memcpy(data + row * maxStringSize, begin,
+                std::min(maxStringSize - 1, (size_t) (end - begin)));
+    break;
+  case INTEGER:
+    reinterpret_cast<int64_t *>(data)[row] = parseInteger(begin, end);
+    break;
+  case REAL:
+    reinterpret_cast<double *>(data)[row] = parseReal(begin, end);
+    break;
+  case BOOLEAN:
+    reinterpret_cast<bool *>(data)[row] = fieldEquals(begin, end, "True")
+        || fieldEquals(begin, end, "true") || fieldEquals(begin, end, "1");
+    break;
+  case IGNORE_COLUMN:
+    break;
+  }
+}
+
+const char *CSVReader::getString(int index, size_t row) {
+  if (index < 0 || index >= (int) mColumns.size() || mColumnTypes[index] != STRING
+      || row >= mNumRows) {
+    return nullptr;
+  }
+  return mColumns[index].data() + row * maxStringSize;
+}
+
+void CSVReader::copyRow(size_t row, char *dest) {
+  size_t offset = 0;
+  for (size_t column = 0; column < mColumns.size(); column++) {
+    size_t size = typeSize(mColumnTypes[column]);
+    std::memcpy(dest + offset, mColumns[column].data() + row * size, size);
+    offset += size;
+  }
+}
+
+size_t CSVReader::typeSize(DataType type) {
+	switch(type) {
+	case STRING:
+		return maxStringSize * sizeof (char);
+	case INTEGER:
+		return sizeof (int64_t);
+	case REAL:
+		return sizeof (double);
+	case BOOLEAN:
+		return sizeof (bool);
+	case IGNORE_COLUMN:
+		break;
 	}
-	return out;
+	return 0;
 }
 
 size_t CSVReader::calculateRowLength() {
-	size_t len = 0;;
-	for(auto type:mDataTypes) {
-		switch(type) {
-		case STRING:
-			len += maxStringSize * sizeof (char);
-			break;
-		case INTEGER:
-			len += sizeof (int64_t);
-			break;
-		case REAL:
-			len += sizeof (double);
-			break;
-		case BOOLEAN:
-			len += sizeof (bool);
-			break;
-        case IGNORE_COLUMN:
-			break;
-		}
+	size_t len = 0;
+	for(auto type:mColumnTypes) {
+		len += typeSize(type);
 	}
-//	std::cout << len << std::endl;
 	return len;
 }
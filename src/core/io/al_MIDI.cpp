@@ -117,3 +117,139 @@ void MIDIMessageHandler::bindTo(RtMidiIn& midiIn, unsigned port){
 }
 
 
+
+
+MIDIMessageQueue::MIDIMessageQueue(unsigned capacity)
+:	mSlots(new Slot[capacity > 0 ? capacity : 1]),
+	mCapacity(capacity > 0 ? capacity : 1)
+{
+	for(size_t i=0; i<mCapacity; ++i) mSlots[i].sequence.store(i);
+}
+
+void MIDIMessageQueue::onMIDIMessage(const MIDIMessage& m){
+	push(m, al_steady_time());
+}
+
+bool MIDIMessageQueue::push(const MIDIMessage& m, al_sec hostTime){
+	// Reserve a slot first, so a write ticket is only taken when its slot
+	// is free. Every step is a single atomic operation, writers never wait.
+	if(mUsed.fetch_add(1) >= mCapacity){
+		mUsed.fetch_sub(1);
+		mDropped++;
+		return false;
+	}
+	size_t w = mWrite.fetch_add(1);
+	Slot& slot = mSlots[w % mCapacity];
+	// The reservation guarantees that the reader released the slot. Loading
+	// its sequence orders the writes below after the read of its last event.
+	slot.sequence.load();
+	slot.event.time = hostTime;
+	slot.event.port = m.port();
+	for(int i=0; i<3; ++i) slot.event.bytes[i] = m.bytes[i];
+	slot.sequence.store(w + 1, std::memory_order_release);
+	return true;
+}
+
+bool MIDIMessageQueue::read(Event& e){
+	Slot& slot = mSlots[mRead % mCapacity];
+	// A writer that took an earlier ticket and has not finished holds back
+	// the messages after it until the next read
+	if(slot.sequence.load(std::memory_order_acquire) != mRead + 1) return false;
+	e = slot.event;
+	slot.sequence.store(mRead + mCapacity);
+	++mRead;
+	mUsed.fetch_sub(1);
+	return true;
+}
+
+void MIDIMessageQueue::audioBlock(unsigned framesPerBuffer, double framesPerSecond, al_sec hostTime){
+	al_sec period = framesPerBuffer / framesPerSecond;
+	if(period != mClock.period_ideal()){
+		mClock = DelayLockedLoop(period, mBandwidth);
+	}
+	mClock.step(hostTime);
+	// Messages received in the buffer period before this callback, less the
+	// margin, are due in this buffer at the same position relative to its start
+	al_sec t0 = mClock.realtime_interp(0.);
+	mBlockEnd = t0 - mJitterMargin;
+	mBlockStart = mBlockEnd - (mClock.realtime_interp(1.) - t0);
+	mFramesPerBuffer = framesPerBuffer;
+}
+
+bool MIDIMessageQueue::pop(MIDIMessage& m, int& offsetFrames){
+	if(!mHasPending){
+		if(!read(mPending)) return false;
+		mHasPending = true;
+	}
+	if(mFramesPerBuffer == 0 || mPending.time >= mBlockEnd){
+		return false; // Received after this callback started, due in the next buffer
+	}
+	mHasPending = false;
+
+	double pos = (mPending.time - mBlockStart) / (mBlockEnd - mBlockStart) * mFramesPerBuffer;
+	// Late messages, e.g. after an xrun, start at the beginning of the buffer
+	offsetFrames = pos < 0. ? 0 : int(pos);
+	if(offsetFrames >= int(mFramesPerBuffer)) offsetFrames = mFramesPerBuffer - 1;
+	m = MIDIMessage(mPending.time, mPending.port,
+		mPending.bytes[0], mPending.bytes[1], mPending.bytes[2]);
+	return true;
+}
+
+bool MIDIMessageQueue::pop(MIDIMessage& m){
+	if(!mHasPending && !read(mPending)) return false;
+	mHasPending = false;
+	m = MIDIMessage(mPending.time, mPending.port,
+		mPending.bytes[0], mPending.bytes[1], mPending.bytes[2]);
+	return true;
+}
+
+
+MIDIMessageDispatcher::MIDIMessageDispatcher(MIDIMessageHandler& handler, al_sec pollInterval)
+:	mHandler(handler), mPollInterval(pollInterval)
+{}
+
+MIDIMessageDispatcher::~MIDIMessageDispatcher(){
+	stop();
+}
+
+void MIDIMessageDispatcher::start(){
+	if(mRunning.exchange(true)) return;
+	mThread = std::thread([this](){
+		auto timeout = std::chrono::duration<double>(mPollInterval);
+		std::unique_lock<std::mutex> lk(mLock);
+		while(mRunning.load()){
+			mCondition.wait_for(lk, timeout, [this](){
+				return mPending.exchange(false) || !mRunning.load();
+			});
+			lk.unlock();
+			process();
+			lk.lock();
+		}
+		lk.unlock();
+		process();
+	});
+}
+
+void MIDIMessageDispatcher::stop(){
+	{
+		std::lock_guard<std::mutex> lk(mLock);
+		mRunning = false;
+	}
+	mCondition.notify_one();
+	if(mThread.joinable()) mThread.join();
+}
+
+void MIDIMessageDispatcher::wake(){
+	// Called on the MIDI thread, so the lock is not taken. A notification
+	// sent while the worker is about to wait is missed, and the worker then
+	// wakes up after pollInterval.
+	mPending = true;
+	mCondition.notify_one();
+}
+
+void MIDIMessageDispatcher::process(){
+	MIDIMessage m(0, 0, 0);
+	while(mQueue.pop(m)){
+		mHandler.onMIDIMessage(m);
+	}
+}
@@ -0,0 +1,364 @@
+#include "al/core/io/al_OfflineAudioBackend.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "al/core/io/al_AudioIO.hpp"
+#include "al/core/io/al_AudioOutputStage.hpp"
+
+using namespace al;
+
+namespace {
+
+enum InputFormat { INPUT_RAW_FLOAT = 0, INPUT_PCM = 1, INPUT_FLOAT = 3 };
+
+bool endsWith(const std::string &s, const std::string &suffix) {
+  if (s.size() < suffix.size()) return false;
+  for (size_t i = 0; i < suffix.size(); i++) {
+    if (tolower(s[s.size() - suffix.size() + i]) != suffix[i]) return false;
+  }
+  return true;
+}
+
+// WAV files are little endian
+void write16(FILE *f, uint16_t v) {
+  uint8_t b[2] = {uint8_t(v), uint8_t(v >> 8)};
+  fwrite(b, 1, 2, f);
+}
+
+void write32(FILE *f, uint32_t v) {
+  uint8_t b[4] = {uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24)};
+  fwrite(b, 1, 4, f);
+}
+
+uint32_t read32(const uint8_t *b) {
+  return b[0] | (b[1] << 8) | (b[2] << 16) | (uint32_t(b[3]) << 24);
+}
+
+uint16_t read16(const uint8_t *b) { return uint16_t(b[0] | (b[1] << 8)); }
+
+// Size of the header written by writeWavHeader
+const long wavHeaderSize = 68;
+
+void writeWavHeader(FILE *f, int channels, int framesPerSecond,
+                    uint64_t dataBytes) {
+  if (dataBytes > 0xFFFFFFFFull - wavHeaderSize) {
+    dataBytes = 0xFFFFFFFFull - wavHeaderSize;  // RIFF size limit
+  }
+  fwrite("RIFF", 1, 4, f);
+  write32(f, uint32_t(wavHeaderSize - 8 + dataBytes));
+  fwrite("WAVE", 1, 4, f);
+  // WAVE_FORMAT_EXTENSIBLE, so any number of channels is valid
+  fwrite("fmt ", 1, 4, f);
+  write32(f, 40);
+  write16(f, 0xFFFE);
+  write16(f, uint16_t(channels));
+  write32(f, uint32_t(framesPerSecond));
+  write32(f, uint32_t(framesPerSecond * channels * 4));
+  write16(f, uint16_t(channels * 4));
+  write16(f, 32);
+  write16(f, 22);
+  write16(f, 32);
+  write32(f, 0);  // no speaker positions
+  // KSDATAFORMAT_SUBTYPE_IEEE_FLOAT
+  const uint8_t floatGuid[16] = {0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+                                 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+  fwrite(floatGuid, 1, 16, f);
+  fwrite("data", 1, 4, f);
+  write32(f, uint32_t(dataBytes));
+}
+
+}  // namespace
+
+OfflineAudioBackend::OfflineAudioBackend(const OfflineAudioConfig &config)
+    : mConfig(config) {}
+
+OfflineAudioBackend::~OfflineAudioBackend() { close(); }
+
+void OfflineAudioBackend::channels(int num, bool forOutput) {
+  if (num < 0) num = 2;
+  if (forOutput) {
+    mChannelsOut = num;
+  } else {
+    mChannelsIn = num;
+  }
+}
+
+bool OfflineAudioBackend::open(int framesPerSecond, int framesPerBuffer,
+                               AudioIO *io) {
+  if (mOpen) {
+    close();
+  }
+  mFramesPerSecond = framesPerSecond;
+  mFramesPerBuffer = framesPerBuffer;
+  mIO = io;
+  if (!openInput() || !openOutput()) {
+    closeOutput();
+    if (mInputFile) {
+      fclose(mInputFile);
+      mInputFile = nullptr;
+    }
+    return false;
+  }
+  mFramesRendered = 0;
+  mOpen = true;
+  return true;
+}
+
+bool OfflineAudioBackend::close() {
+  stop();
+  if (mOpen) {
+    closeOutput();
+    if (mInputFile) {
+      fclose(mInputFile);
+      mInputFile = nullptr;
+    }
+    mOpen = false;
+  }
+  return true;
+}
+
+bool OfflineAudioBackend::start() {
+  if (!mOpen) {
+    return false;
+  }
+  if (mRunning) {
+    return true;
+  }
+  if (mThread.joinable()) {
+    mThread.join();  // Previous render finished on its own
+  }
+  mStopRequested = false;
+  mRunning = true;
+  mThread = std::thread(&OfflineAudioBackend::renderThread, this);
+  return true;
+}
+
+bool OfflineAudioBackend::stop() {
+  mStopRequested = true;
+  if (mThread.joinable()) {
+    mThread.join();
+  }
+  return true;
+}
+
+double OfflineAudioBackend::time() const {
+  return double(mFramesRendered.load()) / mFramesPerSecond;
+}
+
+bool OfflineAudioBackend::wait() {
+  if (mConfig.duration <= 0) {
+    return false;
+  }
+  std::unique_lock<std::mutex> lk(mLock);
+  mDoneCondition.wait(lk, [&]() { return !mRunning; });
+  return true;
+}
+
+void OfflineAudioBackend::renderThread() {
+  AudioIO &io = *mIO;
+  uint64_t durationFrames = uint64_t(mConfig.duration * mFramesPerSecond);
+  std::vector<float> interleavedIn(size_t(mFramesPerBuffer) * mChannelsIn);
+  std::vector<float> interleavedOut(size_t(mFramesPerBuffer) * mChannelsOut);
+  double bufferDuration = double(mFramesPerBuffer) / mFramesPerSecond;
+
+  auto startTime = std::chrono::steady_clock::now();
+  uint64_t startFrames = mFramesRendered;
+  while (!mStopRequested) {
+    uint64_t frames = mFramesRendered;
+    if (durationFrames > 0 && frames >= durationFrames) {
+      break;
+    }
+    auto bufferStart = std::chrono::steady_clock::now();
+
+    if (mChannelsIn > 0) {
+      size_t framesRead = readInput(interleavedIn.data(), mFramesPerBuffer);
+      std::fill(interleavedIn.begin() + framesRead * mChannelsIn,
+                interleavedIn.end(), 0.0f);
+      AudioOutputStage::deinterleave(interleavedIn.data(),
+                                     const_cast<float *>(io.inBuffer(0)),
+                                     mChannelsIn, mFramesPerBuffer);
+    }
+
+    if (io.autoZeroOut()) io.zeroOut();
+
+    io.processAudio();
+
+    AudioOutputStage::interleave(io.outputStageFlags(), io.outBuffer(0),
+                                 interleavedOut.data(), mChannelsOut,
+                                 mFramesPerBuffer, io.mGainPrev, io.mGain);
+    io.mGainPrev = io.mGain;
+
+    if (mOutputFile) {
+      size_t framesToWrite = mFramesPerBuffer;
+      if (durationFrames > 0 && frames + framesToWrite > durationFrames) {
+        framesToWrite = size_t(durationFrames - frames);
+      }
+      size_t written = fwrite(interleavedOut.data(), sizeof(float) * mChannelsOut,
+                              framesToWrite, mOutputFile);
+      mOutputBytes += written * sizeof(float) * mChannelsOut;
+      if (written != framesToWrite) {
+        std::cerr << "ERROR: OfflineAudioBackend could not write to "
+                  << mConfig.outputFile << std::endl;
+        break;
+      }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    mCpu = std::chrono::duration<double>(now - bufferStart).count() / bufferDuration;
+    mFramesRendered = frames + mFramesPerBuffer;
+    double elapsed = std::chrono::duration<double>(now - startTime).count();
+    double rendered = double(mFramesRendered - startFrames) / mFramesPerSecond;
+    if (elapsed > 0) {
+      mRealtimeFactor = rendered / elapsed;
+    }
+
+    if (mConfig.speed > 0) {
+      auto target = startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                    std::chrono::duration<double>(rendered / mConfig.speed));
+      std::this_thread::sleep_until(target);
+    }
+  }
+
+  if (durationFrames > 0 && mFramesRendered > durationFrames) {
+    mFramesRendered = durationFrames;
+  }
+  if (mConfig.verbose) {
+    std::cout << "Offline audio rendered " << time() << " s at "
+              << realtimeFactor() << "x real time" << std::endl;
+  }
+  {
+    std::unique_lock<std::mutex> lk(mLock);
+    mRunning = false;
+  }
+  mDoneCondition.notify_all();
+}
+
+bool OfflineAudioBackend::openInput() {
+  if (mConfig.inputFile.empty() || mChannelsIn == 0) {
+    return true;
+  }
+  mInputFile = fopen(mConfig.inputFile.c_str(), "rb");
+  if (!mInputFile) {
+    std::cerr << "ERROR: OfflineAudioBackend could not open input file "
+              << mConfig.inputFile << std::endl;
+    return false;
+  }
+  uint8_t riff[12];
+  if (fread(riff, 1, 12, mInputFile) == 12 && memcmp(riff, "RIFF", 4) == 0 &&
+      memcmp(riff + 8, "WAVE", 4) == 0) {
+    // Walk chunks to find format and data
+    bool haveFormat = false;
+    uint8_t chunk[8];
+    while (fread(chunk, 1, 8, mInputFile) == 8) {
+      uint32_t size = read32(chunk + 4);
+      if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+        std::vector<uint8_t> format(size);
+        if (fread(format.data(), 1, size, mInputFile) != size) break;
+        uint16_t tag = read16(format.data());
+        mInputChannels = read16(format.data() + 2);
+        int bits = read16(format.data() + 14);
+        if (tag == 0xFFFE && size >= 26) {
+          tag = read16(format.data() + 24);  // Sub format
+        }
+        mInputBytesPerSample = bits / 8;
+        if (tag == 3 && bits == 32) {
+          mInputFormat = INPUT_FLOAT;
+        } else if (tag == 1 && (bits == 16 || bits == 24 || bits == 32)) {
+          mInputFormat = INPUT_PCM;
+        } else {
+          std::cerr << "ERROR: OfflineAudioBackend unsupported WAV format in "
+                    << mConfig.inputFile << std::endl;
+          return false;
+        }
+        haveFormat = true;
+        if (size & 1) fseek(mInputFile, 1, SEEK_CUR);
+      } else if (memcmp(chunk, "data", 4) == 0) {
+        if (!haveFormat) break;
+        mInputBytesLeft = size;
+        return true;
+      } else {
+        fseek(mInputFile, size + (size & 1), SEEK_CUR);
+      }
+    }
+    std::cerr << "ERROR: OfflineAudioBackend invalid WAV file "
+              << mConfig.inputFile << std::endl;
+    return false;
+  }
+  // Raw interleaved floats with as many channels as the input
+  fseek(mInputFile, 0, SEEK_SET);
+  mInputFormat = INPUT_RAW_FLOAT;
+  mInputChannels = mChannelsIn;
+  mInputBytesPerSample = 4;
+  mInputBytesLeft = UINT64_MAX;
+  return true;
+}
+
+size_t OfflineAudioBackend::readInput(float *interleaved, size_t frames) {
+  if (!mInputFile || mInputChannels == 0) {
+    return 0;
+  }
+  size_t frameBytes = size_t(mInputChannels) * mInputBytesPerSample;
+  size_t bytes = size_t(std::min<uint64_t>(frames * frameBytes, mInputBytesLeft));
+  mInputRaw.resize(frames * frameBytes);
+  size_t framesRead = fread(mInputRaw.data(), 1, bytes, mInputFile) / frameBytes;
+  mInputBytesLeft -= std::min<uint64_t>(mInputBytesLeft, framesRead * frameBytes);
+
+  for (size_t frame = 0; frame < framesRead; frame++) {
+    const uint8_t *in = (const uint8_t *)mInputRaw.data() + frame * frameBytes;
+    float *out = interleaved + frame * mChannelsIn;
+    for (int chan = 0; chan < mChannelsIn; chan++) {
+      if (chan >= mInputChannels) {
+        out[chan] = 0.0f;
+        continue;
+      }
+      const uint8_t *s = in + chan * mInputBytesPerSample;
+      if (mInputFormat != INPUT_PCM) {
+        uint32_t bits = read32(s);
+        memcpy(&out[chan], &bits, 4);
+      } else if (mInputBytesPerSample == 2) {
+        out[chan] = int16_t(read16(s)) / 32768.0f;
+      } else if (mInputBytesPerSample == 3) {
+        int32_t v = int32_t(uint32_t(s[0] << 8) | uint32_t(s[1] << 16) | (uint32_t(s[2]) << 24));
+        out[chan] = (v >> 8) / 8388608.0f;
+      } else {
+        out[chan] = int32_t(read32(s)) / 2147483648.0f;
+      }
+    }
+  }
+  return framesRead;
+}
+
+bool OfflineAudioBackend::openOutput() {
+  if (mConfig.outputFile.empty()) {
+    return true;
+  }
+  mOutputFile = fopen(mConfig.outputFile.c_str(), "wb");
+  if (!mOutputFile) {
+    std::cerr << "ERROR: OfflineAudioBackend could not open output file "
+              << mConfig.outputFile << std::endl;
+    return false;
+  }
+  mOutputWav = endsWith(mConfig.outputFile, ".wav");
+  mOutputBytes = 0;
+  if (mOutputWav) {
+    writeWavHeader(mOutputFile, mChannelsOut, mFramesPerSecond, 0);
+  }
+  return true;
+}
+
+void OfflineAudioBackend::closeOutput() {
+  if (!mOutputFile) {
+    return;
+  }
+  if (mOutputWav) {
+    // Fill in sizes now that they are known
+    fseek(mOutputFile, 0, SEEK_SET);
+    writeWavHeader(mOutputFile, mChannelsOut, mFramesPerSecond, mOutputBytes);
+  }
+  fclose(mOutputFile);
+  mOutputFile = nullptr;
+}
@@ -0,0 +1,304 @@
+#include "al/core/math/al_Random.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AL_RANDOM_SSE
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__aarch64__)
+#include <arm_neon.h>
+#define AL_RANDOM_NEON
+#endif
+
+using namespace al;
+
+namespace {
+
+// Operations used by the normal conversion, one value at a time. The SIMD
+// versions below provide the same operations on four values, so all paths
+// share the same approximation.
+struct ScalarOps {
+  typedef float F;
+  typedef uint32_t U;
+  static F set(float v) { return v; }
+  static U setU(uint32_t v) { return v; }
+  static F add(F a, F b) { return a + b; }
+  static F sub(F a, F b) { return a - b; }
+  static F mul(F a, F b) { return a * b; }
+  static F div(F a, F b) { return a / b; }
+  static F sqrt(F a) { return std::sqrt(a); }
+  static U bits(F a) { U u; std::memcpy(&u, &a, 4); return u; }
+  static F fromBits(U a) { F f; std::memcpy(&f, &a, 4); return f; }
+  static F toFloat(U a) { return float(int32_t(a)); }
+  static U toInt(F a) { return uint32_t(int32_t(a)); }
+  static U andU(U a, U b) { return a & b; }
+  static U orU(U a, U b) { return a | b; }
+  static U xorU(U a, U b) { return a ^ b; }
+  static U addU(U a, U b) { return a + b; }
+  static U subU(U a, U b) { return a - b; }
+  template <int S> static U shr(U a) { return a >> S; }
+  template <int S> static U shl(U a) { return a << S; }
+  static U greater(F a, F b) { return a > b ? 0xffffffff : 0; }
+  static U equal(U a, U b) { return a == b ? 0xffffffff : 0; }
+  static F select(U mask, F a, F b) {
+    return fromBits((bits(a) & mask) | (bits(b) & ~mask));
+  }
+};
+
+#if defined(AL_RANDOM_SSE)
+struct SIMDOps {
+  typedef __m128 F;
+  typedef __m128i U;
+  static F set(float v) { return _mm_set1_ps(v); }
+  static U setU(uint32_t v) { return _mm_set1_epi32(int(v)); }
+  static F add(F a, F b) { return _mm_add_ps(a, b); }
+  static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+  static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+  static F div(F a, F b) { return _mm_div_ps(a, b); }
+  static F sqrt(F a) { return _mm_sqrt_ps(a); }
+  static U bits(F a) { return _mm_castps_si128(a); }
+  static F fromBits(U a) { return _mm_castsi128_ps(a); }
+  static F toFloat(U a) { return _mm_cvtepi32_ps(a); }
+  static U toInt(F a) { return _mm_cvttps_epi32(a); }
+  static U andU(U a, U b) { return _mm_and_si128(a, b); }
+  static U orU(U a, U b) { return _mm_or_si128(a, b); }
+  static U xorU(U a, U b) { return _mm_xor_si128(a, b); }
+  static U addU(U a, U b) { return _mm_add_epi32(a, b); }
+  static U subU(U a, U b) { return _mm_sub_epi32(a, b); }
+  template <int S> static U shr(U a) { return _mm_srli_epi32(a, S); }
+  template <int S> static U shl(U a) { return _mm_slli_epi32(a, S); }
+  static U greater(F a, F b) { return _mm_castps_si128(_mm_cmpgt_ps(a, b)); }
+  static U equal(U a, U b) { return _mm_cmpeq_epi32(a, b); }
+  static F select(U mask, F a, F b) {
+    F m = _mm_castsi128_ps(mask);
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+  }
+
+  // Four pairs of integers, separated into first and second of each pair
+  static void load(const uint32_t *src, U &first, U &second) {
+    F a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)src));
+    F b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(src + 4)));
+    first = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    second = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  static void store(float *dst, F first, F second) {
+    _mm_storeu_ps(dst, _mm_unpacklo_ps(first, second));
+    _mm_storeu_ps(dst + 4, _mm_unpackhi_ps(first, second));
+  }
+};
+#elif defined(AL_RANDOM_NEON)
+struct SIMDOps {
+  typedef float32x4_t F;
+  typedef uint32x4_t U;
+  static F set(float v) { return vdupq_n_f32(v); }
+  static U setU(uint32_t v) { return vdupq_n_u32(v); }
+  static F add(F a, F b) { return vaddq_f32(a, b); }
+  static F sub(F a, F b) { return vsubq_f32(a, b); }
+  static F mul(F a, F b) { return vmulq_f32(a, b); }
+  static F div(F a, F b) { return vdivq_f32(a, b); }
+  static F sqrt(F a) { return vsqrtq_f32(a); }
+  static U bits(F a) { return vreinterpretq_u32_f32(a); }
+  static F fromBits(U a) { return vreinterpretq_f32_u32(a); }
+  static F toFloat(U a) { return vcvtq_f32_s32(vreinterpretq_s32_u32(a)); }
+  static U toInt(F a) { return vreinterpretq_u32_s32(vcvtq_s32_f32(a)); }
+  static U andU(U a, U b) { return vandq_u32(a, b); }
+  static U orU(U a, U b) { return vorrq_u32(a, b); }
+  static U xorU(U a, U b) { return veorq_u32(a, b); }
+  static U addU(U a, U b) { return vaddq_u32(a, b); }
+  static U subU(U a, U b) { return vsubq_u32(a, b); }
+  template <int S> static U shr(U a) { return vshrq_n_u32(a, S); }
+  template <int S> static U shl(U a) { return vshlq_n_u32(a, S); }
+  static U greater(F a, F b) { return vcgtq_f32(a, b); }
+  static U equal(U a, U b) { return vceqq_u32(a, b); }
+  static F select(U mask, F a, F b) { return vbslq_f32(mask, a, b); }
+
+  static void load(const uint32_t *src, U &first, U &second) {
+    uint32x4x2_t v = vld2q_u32(src);
+    first = v.val[0];
+    second = v.val[1];
+  }
+  static void store(float *dst, F first, F second) {
+    float32x4x2_t v;
+    v.val[0] = first;
+    v.val[1] = second;
+    vst2q_f32(dst, v);
+  }
+};
+#endif
+
+// Box-Muller transform of a pair of uniform integers into two normal
+// variates. log uses the exponent bits and an atanh series of the mantissa,
+// sin and cos use polynomials over the nearest quarter turn.
+template <class O>
+inline void boxMuller(typename O::U b1, typename O::U b2, typename O::F &y1,
+                      typename O::F &y2) {
+  typedef typename O::F F;
+  typedef typename O::U U;
+
+  // u1 in (0, 1], so the log is finite
+  F u1 = O::mul(O::add(O::toFloat(O::template shr<8>(b1)), O::set(1.f)),
+                O::set(1.f / 16777216.f));
+  U ub = O::bits(u1);
+  F e = O::toFloat(O::subU(O::template shr<23>(ub), O::setU(127)));
+  F m = O::fromBits(O::orU(O::andU(ub, O::setU(0x7fffff)), O::setU(0x3f800000)));
+  // Mantissa in [sqrt(1/2), sqrt(2)) so the series converges quickly
+  U big = O::greater(m, O::set(1.41421356f));
+  m = O::select(big, O::mul(m, O::set(0.5f)), m);
+  e = O::select(big, O::add(e, O::set(1.f)), e);
+  F s = O::div(O::sub(m, O::set(1.f)), O::add(m, O::set(1.f)));
+  F s2 = O::mul(s, s);
+  F p = O::add(O::set(1.f / 7.f), O::mul(s2, O::set(1.f / 9.f)));
+  p = O::add(O::set(1.f / 5.f), O::mul(s2, p));
+  p = O::add(O::set(1.f / 3.f), O::mul(s2, p));
+  p = O::add(O::set(1.f), O::mul(s2, p));
+  F logU1 = O::add(O::mul(e, O::set(0.693147181f)), O::mul(O::mul(s, O::set(2.f)), p));
+  F r = O::sqrt(O::mul(logU1, O::set(-2.f)));
+
+  // Angle in quarter turns in [0, 4), split into the nearest quarter q and
+  // a remainder in [-pi/4, pi/4]
+  F t = O::mul(O::toFloat(O::template shr<8>(b2)), O::set(4.f / 16777216.f));
+  U q = O::toInt(O::add(t, O::set(0.5f)));
+  F a = O::mul(O::sub(t, O::toFloat(q)), O::set(1.57079633f));
+  F a2 = O::mul(a, a);
+  p = O::add(O::set(-1.f / 5040.f), O::mul(a2, O::set(1.f / 362880.f)));
+  p = O::add(O::set(1.f / 120.f), O::mul(a2, p));
+  p = O::add(O::set(-1.f / 6.f), O::mul(a2, p));
+  F sn = O::mul(a, O::add(O::set(1.f), O::mul(a2, p)));
+  p = O::add(O::set(1.f / 40320.f), O::mul(a2, O::set(-1.f / 3628800.f)));
+  p = O::add(O::set(-1.f / 720.f), O::mul(a2, p));
+  p = O::add(O::set(1.f / 24.f), O::mul(a2, p));
+  p = O::add(O::set(-0.5f), O::mul(a2, p));
+  F cs = O::add(O::set(1.f), O::mul(a2, p));
+
+  // Rotate by q quarter turns: odd quarters swap sin and cos, cos is
+  // negative in quarters 1 and 2, sin in quarters 2 and 3
+  U one = O::setU(1);
+  U swap = O::equal(O::andU(q, one), one);
+  U cosSign = O::template shl<30>(O::andU(O::addU(q, one), O::setU(2)));
+  U sinSign = O::template shl<30>(O::andU(q, O::setU(2)));
+  y1 = O::mul(r, O::fromBits(O::xorU(O::bits(O::select(swap, sn, cs)), cosSign)));
+  y2 = O::mul(r, O::fromBits(O::xorU(O::bits(O::select(swap, cs, sn)), sinSign)));
+}
+
+#if defined(AL_RANDOM_SSE)
+// One Philox round on four blocks: multiplies give 64 bit products of the
+// even lanes, so odd lanes are shifted down and the halves reassembled
+inline void mulHiLo(__m128i x, __m128i mul, __m128i &lo, __m128i &hi) {
+  __m128i even = _mm_mul_epu32(x, mul);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), mul);
+  even = _mm_shuffle_epi32(even, _MM_SHUFFLE(3, 1, 2, 0));
+  odd = _mm_shuffle_epi32(odd, _MM_SHUFFLE(3, 1, 2, 0));
+  lo = _mm_unpacklo_epi32(even, odd);
+  hi = _mm_unpackhi_epi32(even, odd);
+}
+
+void philoxBlocks4(const uint32_t *key, uint64_t stream, uint64_t counter,
+                   uint32_t *out) {
+  uint64_t c[4] = {counter, counter + 1, counter + 2, counter + 3};
+  __m128i c0 = _mm_set_epi32(int(c[3]), int(c[2]), int(c[1]), int(c[0]));
+  __m128i c1 = _mm_set_epi32(int(c[3] >> 32), int(c[2] >> 32), int(c[1] >> 32),
+                             int(c[0] >> 32));
+  __m128i c2 = _mm_set1_epi32(int(uint32_t(stream)));
+  __m128i c3 = _mm_set1_epi32(int(uint32_t(stream >> 32)));
+  const __m128i m0 = _mm_set1_epi32(int(0xD2511F53));
+  const __m128i m1 = _mm_set1_epi32(int(0xCD9E8D57));
+  uint32_t k0 = key[0], k1 = key[1];
+  for (int r = 0; r < 10; ++r) {
+    __m128i lo0, hi0, lo1, hi1;
+    mulHiLo(c0, m0, lo0, hi0);
+    mulHiLo(c2, m1, lo1, hi1);
+    c0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), _mm_set1_epi32(int(k0)));
+    c1 = lo1;
+    c2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), _mm_set1_epi32(int(k1)));
+    c3 = lo0;
+    k0 += 0x9E3779B9;
+    k1 += 0xBB67AE85;
+  }
+  // Transpose lanes back to consecutive blocks
+  __m128i t0 = _mm_unpacklo_epi32(c0, c1);
+  __m128i t1 = _mm_unpacklo_epi32(c2, c3);
+  __m128i t2 = _mm_unpackhi_epi32(c0, c1);
+  __m128i t3 = _mm_unpackhi_epi32(c2, c3);
+  _mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi64(t0, t1));
+  _mm_storeu_si128((__m128i *)(out + 4), _mm_unpackhi_epi64(t0, t1));
+  _mm_storeu_si128((__m128i *)(out + 8), _mm_unpacklo_epi64(t2, t3));
+  _mm_storeu_si128((__m128i *)(out + 12), _mm_unpackhi_epi64(t2, t3));
+}
+#elif defined(AL_RANDOM_NEON)
+inline void mulHiLo(uint32x4_t x, uint32x2_t mul, uint32x4_t &lo,
+                    uint32x4_t &hi) {
+  uint64x2_t pl = vmull_u32(vget_low_u32(x), mul);
+  uint64x2_t ph = vmull_u32(vget_high_u32(x), mul);
+  lo = vcombine_u32(vmovn_u64(pl), vmovn_u64(ph));
+  hi = vcombine_u32(vshrn_n_u64(pl, 32), vshrn_n_u64(ph, 32));
+}
+
+void philoxBlocks4(const uint32_t *key, uint64_t stream, uint64_t counter,
+                   uint32_t *out) {
+  uint32_t lowWords[4], highWords[4];
+  for (int l = 0; l < 4; ++l) {
+    lowWords[l] = uint32_t(counter + l);
+    highWords[l] = uint32_t((counter + l) >> 32);
+  }
+  uint32x4x4_t c;
+  c.val[0] = vld1q_u32(lowWords);
+  c.val[1] = vld1q_u32(highWords);
+  c.val[2] = vdupq_n_u32(uint32_t(stream));
+  c.val[3] = vdupq_n_u32(uint32_t(stream >> 32));
+  const uint32x2_t m0 = vdup_n_u32(0xD2511F53);
+  const uint32x2_t m1 = vdup_n_u32(0xCD9E8D57);
+  uint32_t k0 = key[0], k1 = key[1];
+  for (int r = 0; r < 10; ++r) {
+    uint32x4_t lo0, hi0, lo1, hi1;
+    mulHiLo(c.val[0], m0, lo0, hi0);
+    mulHiLo(c.val[2], m1, lo1, hi1);
+    c.val[0] = veorq_u32(veorq_u32(hi1, c.val[1]), vdupq_n_u32(k0));
+    c.val[1] = lo1;
+    c.val[2] = veorq_u32(veorq_u32(hi0, c.val[3]), vdupq_n_u32(k1));
+    c.val[3] = lo0;
+    k0 += 0x9E3779B9;
+    k1 += 0xBB67AE85;
+  }
+  vst4q_u32(out, c); // Interleaves lanes back to consecutive blocks
+}
+#endif
+
+}  // namespace
+
+void rnd::uintToNormal(const uint32_t *bits, float *dst, size_t n) {
+  size_t i = 0;
+#if defined(AL_RANDOM_SSE) || defined(AL_RANDOM_NEON)
+  for (; i + 8 <= n; i += 8) {
+    SIMDOps::U b1, b2;
+    SIMDOps::F y1, y2;
+    SIMDOps::load(bits + i, b1, b2);
+    boxMuller<SIMDOps>(b1, b2, y1, y2);
+    SIMDOps::store(dst + i, y1, y2);
+  }
+#endif
+  for (; i + 2 <= n; i += 2) {
+    boxMuller<ScalarOps>(bits[i], bits[i + 1], dst[i], dst[i + 1]);
+  }
+}
+
+void rnd::Philox::operator()(uint32_t *dst, size_t n) {
+  size_t i = 0;
+  for (; i < n && mIndex < 4; ++i) dst[i] = mBuffer[mIndex++];
+
+  // Whole blocks are written straight to dst, several at a time
+  size_t numBlocks = (n - i) / 4;
+  size_t b = 0;
+#if defined(AL_RANDOM_SSE) || defined(AL_RANDOM_NEON)
+  for (; b + 4 <= numBlocks; b += 4) {
+    philoxBlocks4(mKey, mStream, mCounter + b, dst + i + b * 4);
+  }
+#else
+  for (; b + 8 <= numBlocks; b += 8) blocks<8>(mCounter + b, dst + i + b * 4);
+#endif
+  for (; b < numBlocks; ++b) blocks<1>(mCounter + b, dst + i + b * 4);
+  mCounter += numBlocks;
+  i += numBlocks * 4;
+
+  for (; i < n; ++i) dst[i] = (*this)();
+}
@@ -0,0 +1,177 @@
+#include "al/core/math/al_VecBatch.hpp"
+
+#include <atomic>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+#include "al_VecBatchKernels.hpp"
+
+using namespace al;
+
+static_assert(sizeof(Vec3f) == 3 * sizeof(float), "Vec3f must be packed");
+static_assert(sizeof(Vec3d) == 3 * sizeof(double), "Vec3d must be packed");
+static_assert(sizeof(Quatf) == 4 * sizeof(float), "Quatf must be packed");
+static_assert(sizeof(Quatd) == 4 * sizeof(double), "Quatd must be packed");
+
+namespace {
+
+const VecBatchKernels scalarKernels = makeKernels<float, double>("scalar");
+
+#if defined(AL_VEC_BATCH_SSE)
+const VecBatchKernels simdKernels = makeKernels<F4, D2>("SSE2");
+#elif defined(AL_VEC_BATCH_NEON_DOUBLE)
+const VecBatchKernels simdKernels = makeKernels<F4, D2>("NEON");
+#elif defined(AL_VEC_BATCH_NEON)
+const VecBatchKernels simdKernels = makeKernels<F4, double>("NEON");
+#endif
+
+// Checks that both the CPU and the operating system support AVX
+bool cpuHasAVX() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int info[4];
+  __cpuid(info, 1);
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  return osxsave && avx && (_xgetbv(0) & 6) == 6;
+#elif (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx");
+#else
+  return false;
+#endif
+}
+
+// Available kernels, fastest first
+std::vector<const VecBatchKernels *> availableKernels() {
+  std::vector<const VecBatchKernels *> kernels;
+  const VecBatchKernels *avx = vecBatchAVXKernels();
+  if (avx && cpuHasAVX()) kernels.push_back(avx);
+#if defined(AL_VEC_BATCH_SSE) || defined(AL_VEC_BATCH_NEON)
+  kernels.push_back(&simdKernels);
+#endif
+  kernels.push_back(&scalarKernels);
+  return kernels;
+}
+
+std::atomic<const VecBatchKernels *> &activeKernels() {
+  static std::atomic<const VecBatchKernels *> active(availableKernels()[0]);
+  return active;
+}
+
+inline const VecBatchKernels &kernels() {
+  return *activeKernels().load(std::memory_order_relaxed);
+}
+
+// Arrays of vectors and quaternions as arrays of their components. Pointer
+// arithmetic only, so empty arrays may be null.
+template <int N, class T>
+inline T *flat(Vec<N, T> *v) { return reinterpret_cast<T *>(v); }
+template <int N, class T>
+inline const T *flat(const Vec<N, T> *v) { return reinterpret_cast<const T *>(v); }
+template <class T>
+inline T *flat(Quat<T> *q) { return reinterpret_cast<T *>(q); }
+template <class T>
+inline const T *flat(const Quat<T> *q) { return reinterpret_cast<const T *>(q); }
+
+}  // namespace
+
+void VecBatch::rotate(const Quatf &q, const Vec3f *in, Vec3f *out, size_t n) {
+  size_t done = kernels().rotatef(q.components, flat(in), flat(out), n);
+  scalarKernels.rotatef(q.components, flat(in + done), flat(out + done), n - done);
+}
+
+void VecBatch::rotate(const Quatd &q, const Vec3d *in, Vec3d *out, size_t n) {
+  size_t done = kernels().rotated(q.components, flat(in), flat(out), n);
+  scalarKernels.rotated(q.components, flat(in + done), flat(out + done), n - done);
+}
+
+void VecBatch::rotate(const Quatf *q, const Vec3f *in, Vec3f *out, size_t n) {
+  size_t done = kernels().rotateEachf(flat(q), flat(in), flat(out), n);
+  scalarKernels.rotateEachf(flat(q + done), flat(in + done), flat(out + done),
+                            n - done);
+}
+
+void VecBatch::rotate(const Quatd *q, const Vec3d *in, Vec3d *out, size_t n) {
+  size_t done = kernels().rotateEachd(flat(q), flat(in), flat(out), n);
+  scalarKernels.rotateEachd(flat(q + done), flat(in + done), flat(out + done),
+                            n - done);
+}
+
+void VecBatch::transform(const Mat4f &m, const Vec3f *in, Vec3f *out,
+                         size_t n, float w) {
+  size_t done = kernels().transformf(m.elems(), flat(in), flat(out), n, w);
+  scalarKernels.transformf(m.elems(), flat(in + done), flat(out + done),
+                           n - done, w);
+}
+
+void VecBatch::transform(const Mat4d &m, const Vec3d *in, Vec3d *out,
+                         size_t n, double w) {
+  size_t done = kernels().transformd(m.elems(), flat(in), flat(out), n, w);
+  scalarKernels.transformd(m.elems(), flat(in + done), flat(out + done),
+                           n - done, w);
+}
+
+void VecBatch::normalize(Vec3f *v, size_t n) {
+  size_t done = kernels().normalizef(flat(v), n);
+  scalarKernels.normalizef(flat(v + done), n - done);
+}
+
+void VecBatch::normalize(Vec3d *v, size_t n) {
+  size_t done = kernels().normalized(flat(v), n);
+  scalarKernels.normalized(flat(v + done), n - done);
+}
+
+void VecBatch::normalize(Quatf *q, size_t n) {
+  size_t done = kernels().normalizeQuatf(flat(q), n);
+  scalarKernels.normalizeQuatf(flat(q + done), n - done);
+}
+
+void VecBatch::normalize(Quatd *q, size_t n) {
+  size_t done = kernels().normalizeQuatd(flat(q), n);
+  scalarKernels.normalizeQuatd(flat(q + done), n - done);
+}
+
+void VecBatch::dot(const Vec3f *a, const Vec3f *b, float *out, size_t n) {
+  size_t done = kernels().dotf(flat(a), flat(b), out, n);
+  scalarKernels.dotf(flat(a + done), flat(b + done), out + done, n - done);
+}
+
+void VecBatch::dot(const Vec3d *a, const Vec3d *b, double *out, size_t n) {
+  size_t done = kernels().dotd(flat(a), flat(b), out, n);
+  scalarKernels.dotd(flat(a + done), flat(b + done), out + done, n - done);
+}
+
+void VecBatch::multiply(const Quatf *a, const Quatf *b, Quatf *out, size_t n) {
+  size_t done = kernels().multiplyf(flat(a), flat(b), flat(out), n);
+  scalarKernels.multiplyf(flat(a + done), flat(b + done), flat(out + done),
+                          n - done);
+}
+
+void VecBatch::multiply(const Quatd *a, const Quatd *b, Quatd *out, size_t n) {
+  size_t done = kernels().multiplyd(flat(a), flat(b), flat(out), n);
+  scalarKernels.multiplyd(flat(a + done), flat(b + done), flat(out + done),
+                          n - done);
+}
+
+const char *VecBatch::instructionSet() { return kernels().name; }
+
+std::vector<const char *> VecBatch::instructionSets() {
+  std::vector<const char *> names;
+  for (auto *k : availableKernels()) names.push_back(k->name);
+  return names;
+}
+
+bool VecBatch::useInstructionSet(const char *name) {
+  for (auto *k : availableKernels()) {
+    if (strcmp(k->name, name) == 0) {
+      activeKernels().store(k);
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,183 @@
+// AVX kernels of VecBatch. This file is compiled with AVX enabled (see
+// CMakeLists.txt) and its kernels are only selected at runtime when the CPU
+// supports AVX. Without the compiler flag it only provides a null table.
+
+#include "al_VecBatchKernels.hpp"
+
+#if defined(__AVX__)
+
+#include <immintrin.h>
+
+namespace al {
+
+namespace {
+
+struct F8 {
+  __m256 v;
+};
+
+inline F8 operator+(F8 a, F8 b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline F8 operator-(F8 a, F8 b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline F8 operator*(F8 a, F8 b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline F8 operator/(F8 a, F8 b) { return {_mm256_div_ps(a.v, b.v)}; }
+inline F8 operator-(F8 a) { return {_mm256_xor_ps(a.v, _mm256_set1_ps(-0.f))}; }
+inline F8 vsqrt(F8 a) { return {_mm256_sqrt_ps(a.v)}; }
+inline F8 vgreater(F8 a, F8 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+inline F8 vless(F8 a, F8 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+inline F8 vor(F8 a, F8 b) { return {_mm256_or_ps(a.v, b.v)}; }
+inline F8 vselect(F8 mask, F8 a, F8 b) {
+  return {_mm256_blendv_ps(b.v, a.v, mask.v)};
+}
+
+inline __m256 load2x4(const float *lo, const float *hi) {
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)),
+                              _mm_loadu_ps(hi), 1);
+}
+
+inline void store2x4(float *lo, float *hi, __m256 v) {
+  _mm_storeu_ps(lo, _mm256_castps256_ps128(v));
+  _mm_storeu_ps(hi, _mm256_extractf128_ps(v, 1));
+}
+
+template <>
+struct Pack<F8> {
+  typedef float Scalar;
+  typedef F8 Mask;
+  static const int width = 8;
+  static F8 splat(float v) { return {_mm256_set1_ps(v)}; }
+  static F8 load(const float *p) { return {_mm256_loadu_ps(p)}; }
+  static void store(float *p, F8 v) { _mm256_storeu_ps(p, v.v); }
+};
+
+// AVX shuffles work within 128 bit lanes, so structures 0-3 go to the low
+// lanes and 4-7 to the high lanes, then the shuffles are the same as in
+// deinterleave3() and interleave3()
+inline void loadAoS(const float *p, F8 (&v)[3]) {
+  __m256 a = load2x4(p, p + 12), b = load2x4(p + 4, p + 16),
+         c = load2x4(p + 8, p + 20);
+  __m256 t = _mm256_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+  v[0].v = _mm256_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+  t = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+  __m256 u = _mm256_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+  v[1].v = _mm256_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0));
+  t = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+  u = _mm256_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+  v[2].v = _mm256_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0));
+}
+inline void storeAoS(float *p, const F8 (&v)[3]) {
+  __m256 x = v[0].v, y = v[1].v, z = v[2].v;
+  __m256 lo = _mm256_unpacklo_ps(x, y);
+  __m256 hi = _mm256_unpackhi_ps(x, y);
+  __m256 s = _mm256_shuffle_ps(z, lo, _MM_SHUFFLE(2, 2, 0, 0));
+  store2x4(p, p + 12, _mm256_shuffle_ps(lo, s, _MM_SHUFFLE(2, 0, 1, 0)));
+  s = _mm256_shuffle_ps(lo, z, _MM_SHUFFLE(1, 1, 3, 3));
+  store2x4(p + 4, p + 16, _mm256_shuffle_ps(s, hi, _MM_SHUFFLE(1, 0, 2, 0)));
+  s = _mm256_shuffle_ps(z, hi, _MM_SHUFFLE(2, 2, 2, 2));
+  __m256 u = _mm256_shuffle_ps(hi, z, _MM_SHUFFLE(3, 3, 3, 3));
+  store2x4(p + 8, p + 20, _mm256_shuffle_ps(s, u, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+inline void loadAoS(const float *p, F8 (&v)[4]) {
+  __m256 r[4];
+  for (int c = 0; c < 4; c++) r[c] = load2x4(p + 4 * c, p + 16 + 4 * c);
+  // Transpose each 128 bit lane, as _MM_TRANSPOSE4_PS
+  __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpacklo_ps(r[2], r[3]);
+  __m256 t2 = _mm256_unpackhi_ps(r[0], r[1]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+  v[0].v = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+  v[1].v = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+  v[2].v = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  v[3].v = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+inline void storeAoS(float *p, const F8 (&v)[4]) {
+  __m256 t0 = _mm256_unpacklo_ps(v[0].v, v[1].v), t1 = _mm256_unpacklo_ps(v[2].v, v[3].v);
+  __m256 t2 = _mm256_unpackhi_ps(v[0].v, v[1].v), t3 = _mm256_unpackhi_ps(v[2].v, v[3].v);
+  store2x4(p, p + 16, _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0)));
+  store2x4(p + 4, p + 20, _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2)));
+  store2x4(p + 8, p + 24, _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0)));
+  store2x4(p + 12, p + 28, _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2)));
+}
+
+struct D4 {
+  __m256d v;
+};
+
+inline D4 operator+(D4 a, D4 b) { return {_mm256_add_pd(a.v, b.v)}; }
+inline D4 operator-(D4 a, D4 b) { return {_mm256_sub_pd(a.v, b.v)}; }
+inline D4 operator*(D4 a, D4 b) { return {_mm256_mul_pd(a.v, b.v)}; }
+inline D4 operator/(D4 a, D4 b) { return {_mm256_div_pd(a.v, b.v)}; }
+inline D4 operator-(D4 a) { return {_mm256_xor_pd(a.v, _mm256_set1_pd(-0.))}; }
+inline D4 vsqrt(D4 a) { return {_mm256_sqrt_pd(a.v)}; }
+inline D4 vgreater(D4 a, D4 b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ)}; }
+inline D4 vless(D4 a, D4 b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)}; }
+inline D4 vor(D4 a, D4 b) { return {_mm256_or_pd(a.v, b.v)}; }
+inline D4 vselect(D4 mask, D4 a, D4 b) {
+  return {_mm256_blendv_pd(b.v, a.v, mask.v)};
+}
+
+template <>
+struct Pack<D4> {
+  typedef double Scalar;
+  typedef D4 Mask;
+  static const int width = 4;
+  static D4 splat(double v) { return {_mm256_set1_pd(v)}; }
+  static D4 load(const double *p) { return {_mm256_loadu_pd(p)}; }
+  static void store(double *p, D4 v) { _mm256_storeu_pd(p, v.v); }
+};
+
+inline __m256d load2x2(const double *lo, const double *hi) {
+  return _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(lo)),
+                              _mm_loadu_pd(hi), 1);
+}
+
+inline void store2x2(double *lo, double *hi, __m256d v) {
+  _mm_storeu_pd(lo, _mm256_castpd256_pd128(v));
+  _mm_storeu_pd(hi, _mm256_extractf128_pd(v, 1));
+}
+
+// [x0 y0 | x2 y2] [z0 x1 | z2 x3] [y1 z1 | y3 z3] <-> [x0..x3] [y0..y3] [z0..z3]
+inline void loadAoS(const double *p, D4 (&v)[3]) {
+  __m256d a = load2x2(p, p + 6), b = load2x2(p + 2, p + 8),
+          c = load2x2(p + 4, p + 10);
+  v[0].v = _mm256_shuffle_pd(a, b, 10);
+  v[1].v = _mm256_shuffle_pd(a, c, 5);
+  v[2].v = _mm256_shuffle_pd(b, c, 10);
+}
+inline void storeAoS(double *p, const D4 (&v)[3]) {
+  store2x2(p, p + 6, _mm256_shuffle_pd(v[0].v, v[1].v, 0));
+  store2x2(p + 2, p + 8, _mm256_shuffle_pd(v[2].v, v[0].v, 10));
+  store2x2(p + 4, p + 10, _mm256_shuffle_pd(v[1].v, v[2].v, 15));
+}
+
+inline void transpose4(__m256d &r0, __m256d &r1, __m256d &r2, __m256d &r3) {
+  __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+  __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+  __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+  __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+  r0 = _mm256_permute2f128_pd(t0, t2, 0x20);
+  r1 = _mm256_permute2f128_pd(t1, t3, 0x20);
+  r2 = _mm256_permute2f128_pd(t0, t2, 0x31);
+  r3 = _mm256_permute2f128_pd(t1, t3, 0x31);
+}
+
+inline void loadAoS(const double *p, D4 (&v)[4]) {
+  for (int c = 0; c < 4; c++) v[c].v = _mm256_loadu_pd(p + 4 * c);
+  transpose4(v[0].v, v[1].v, v[2].v, v[3].v);
+}
+inline void storeAoS(double *p, const D4 (&v)[4]) {
+  __m256d r[4] = {v[0].v, v[1].v, v[2].v, v[3].v};
+  transpose4(r[0], r[1], r[2], r[3]);
+  for (int c = 0; c < 4; c++) _mm256_storeu_pd(p + 4 * c, r[c]);
+}
+
+const VecBatchKernels avxKernels = makeKernels<F8, D4>("AVX");
+
+}  // namespace
+
+const VecBatchKernels *vecBatchAVXKernels() { return &avxKernels; }
+
+}  // al::
+
+#else
+
+const al::VecBatchKernels *al::vecBatchAVXKernels() { return nullptr; }
+
+#endif
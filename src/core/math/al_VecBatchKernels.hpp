@@ -0,0 +1,542 @@
+#ifndef INCLUDE_AL_VECBATCHKERNELS_HPP
+#define INCLUDE_AL_VECBATCHKERNELS_HPP
+
+// Kernels of VecBatch, written once over a "pack" of lanes. A pack is either
+// a plain float or double, used for the scalar fallback and the remainders,
+// or a wrapper around a SIMD register. Both al_VecBatch.cpp and
+// al_VecBatchAVX.cpp, which is compiled with AVX enabled, include this file.
+// Everything in here has internal linkage, so the kernels compiled for AVX
+// can not end up being called on machines without it.
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AL_VEC_BATCH_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AL_VEC_BATCH_NEON
+#endif
+
+namespace al {
+
+/// Kernels for one instruction set. Arrays are passed as scalars, with 3
+/// per Vec3 and 4 per Quat (w, x, y, z). Each kernel processes as many
+/// blocks of its width as fit in n elements and returns the number of
+/// elements processed, the rest is left to the scalar kernels.
+struct VecBatchKernels {
+  const char *name;
+  size_t (*rotatef)(const float *q, const float *in, float *out, size_t n);
+  size_t (*rotated)(const double *q, const double *in, double *out, size_t n);
+  size_t (*rotateEachf)(const float *q, const float *in, float *out, size_t n);
+  size_t (*rotateEachd)(const double *q, const double *in, double *out, size_t n);
+  size_t (*transformf)(const float *m, const float *in, float *out, size_t n,
+                       float w);
+  size_t (*transformd)(const double *m, const double *in, double *out,
+                       size_t n, double w);
+  size_t (*normalizef)(float *v, size_t n);
+  size_t (*normalized)(double *v, size_t n);
+  size_t (*normalizeQuatf)(float *q, size_t n);
+  size_t (*normalizeQuatd)(double *q, size_t n);
+  size_t (*dotf)(const float *a, const float *b, float *out, size_t n);
+  size_t (*dotd)(const double *a, const double *b, double *out, size_t n);
+  size_t (*multiplyf)(const float *a, const float *b, float *out, size_t n);
+  size_t (*multiplyd)(const double *a, const double *b, double *out, size_t n);
+};
+
+/// AVX kernels, nullptr if the library was built without them
+const VecBatchKernels *vecBatchAVXKernels();
+
+namespace {
+
+// Pack traits: scalar type, number of lanes, and loading and storing lanes
+template <class P>
+struct Pack;
+
+template <class T>
+struct ScalarPack {
+  typedef T Scalar;
+  typedef bool Mask;
+  static const int width = 1;
+  static T splat(T v) { return v; }
+  static T load(const T *p) { return *p; }
+  static void store(T *p, T v) { *p = v; }
+};
+
+template <>
+struct Pack<float> : ScalarPack<float> {};
+template <>
+struct Pack<double> : ScalarPack<double> {};
+
+template <class T>
+inline T vsqrt(T v) { return std::sqrt(v); }
+template <class T>
+inline bool vgreater(T a, T b) { return a > b; }
+template <class T>
+inline bool vless(T a, T b) { return a < b; }
+inline bool vor(bool a, bool b) { return a || b; }
+template <class T>
+inline T vselect(bool mask, T a, T b) { return mask ? a : b; }
+
+// Load C component structures (Vec3 or Quat) from p into one pack per
+// component. Overloaded with shuffles for the common SIMD cases.
+template <class P, int C>
+inline void loadAoS(const typename Pack<P>::Scalar *p, P (&v)[C]) {
+  typedef typename Pack<P>::Scalar S;
+  const int W = Pack<P>::width;
+  S lanes[C][W];
+  for (int i = 0; i < W; i++) {
+    for (int c = 0; c < C; c++) lanes[c][i] = p[i * C + c];
+  }
+  for (int c = 0; c < C; c++) v[c] = Pack<P>::load(lanes[c]);
+}
+
+template <class P, int C>
+inline void storeAoS(typename Pack<P>::Scalar *p, const P (&v)[C]) {
+  typedef typename Pack<P>::Scalar S;
+  const int W = Pack<P>::width;
+  S lanes[C][W];
+  for (int c = 0; c < C; c++) Pack<P>::store(lanes[c], v[c]);
+  for (int i = 0; i < W; i++) {
+    for (int c = 0; c < C; c++) p[i * C + c] = lanes[c][i];
+  }
+}
+
+#if defined(AL_VEC_BATCH_SSE)
+
+// [x0 y0 z0 x1] [y1 z1 x2 y2] [z2 x3 y3 z3] <-> [x0..x3] [y0..y3] [z0..z3]
+inline void deinterleave3(const float *p, __m128 &x, __m128 &y, __m128 &z) {
+  __m128 a = _mm_loadu_ps(p), b = _mm_loadu_ps(p + 4), c = _mm_loadu_ps(p + 8);
+  __m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+  x = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+  t = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+  __m128 u = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+  y = _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0));
+  t = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+  u = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+  z = _mm_shuffle_ps(t, u, _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+inline void interleave3(float *p, __m128 x, __m128 y, __m128 z) {
+  __m128 lo = _mm_unpacklo_ps(x, y);  // x0 y0 x1 y1
+  __m128 hi = _mm_unpackhi_ps(x, y);  // x2 y2 x3 y3
+  __m128 s = _mm_shuffle_ps(z, lo, _MM_SHUFFLE(2, 2, 0, 0));
+  _mm_storeu_ps(p, _mm_shuffle_ps(lo, s, _MM_SHUFFLE(2, 0, 1, 0)));
+  s = _mm_shuffle_ps(lo, z, _MM_SHUFFLE(1, 1, 3, 3));
+  _mm_storeu_ps(p + 4, _mm_shuffle_ps(s, hi, _MM_SHUFFLE(1, 0, 2, 0)));
+  s = _mm_shuffle_ps(z, hi, _MM_SHUFFLE(2, 2, 2, 2));
+  __m128 u = _mm_shuffle_ps(hi, z, _MM_SHUFFLE(3, 3, 3, 3));
+  _mm_storeu_ps(p + 8, _mm_shuffle_ps(s, u, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+inline void deinterleave4(const float *p, __m128 &w, __m128 &x, __m128 &y,
+                          __m128 &z) {
+  w = _mm_loadu_ps(p);
+  x = _mm_loadu_ps(p + 4);
+  y = _mm_loadu_ps(p + 8);
+  z = _mm_loadu_ps(p + 12);
+  _MM_TRANSPOSE4_PS(w, x, y, z);
+}
+
+inline void interleave4(float *p, __m128 w, __m128 x, __m128 y, __m128 z) {
+  _MM_TRANSPOSE4_PS(w, x, y, z);
+  _mm_storeu_ps(p, w);
+  _mm_storeu_ps(p + 4, x);
+  _mm_storeu_ps(p + 8, y);
+  _mm_storeu_ps(p + 12, z);
+}
+
+struct F4 {
+  __m128 v;
+};
+
+inline F4 operator+(F4 a, F4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline F4 operator-(F4 a, F4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline F4 operator*(F4 a, F4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline F4 operator/(F4 a, F4 b) { return {_mm_div_ps(a.v, b.v)}; }
+inline F4 operator-(F4 a) { return {_mm_xor_ps(a.v, _mm_set1_ps(-0.f))}; }
+inline F4 vsqrt(F4 a) { return {_mm_sqrt_ps(a.v)}; }
+inline F4 vgreater(F4 a, F4 b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+inline F4 vless(F4 a, F4 b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+inline F4 vor(F4 a, F4 b) { return {_mm_or_ps(a.v, b.v)}; }
+inline F4 vselect(F4 mask, F4 a, F4 b) {
+  return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+}
+
+template <>
+struct Pack<F4> {
+  typedef float Scalar;
+  typedef F4 Mask;
+  static const int width = 4;
+  static F4 splat(float v) { return {_mm_set1_ps(v)}; }
+  static F4 load(const float *p) { return {_mm_loadu_ps(p)}; }
+  static void store(float *p, F4 v) { _mm_storeu_ps(p, v.v); }
+};
+
+inline void loadAoS(const float *p, F4 (&v)[3]) {
+  deinterleave3(p, v[0].v, v[1].v, v[2].v);
+}
+inline void storeAoS(float *p, const F4 (&v)[3]) {
+  interleave3(p, v[0].v, v[1].v, v[2].v);
+}
+inline void loadAoS(const float *p, F4 (&v)[4]) {
+  deinterleave4(p, v[0].v, v[1].v, v[2].v, v[3].v);
+}
+inline void storeAoS(float *p, const F4 (&v)[4]) {
+  interleave4(p, v[0].v, v[1].v, v[2].v, v[3].v);
+}
+
+struct D2 {
+  __m128d v;
+};
+
+inline D2 operator+(D2 a, D2 b) { return {_mm_add_pd(a.v, b.v)}; }
+inline D2 operator-(D2 a, D2 b) { return {_mm_sub_pd(a.v, b.v)}; }
+inline D2 operator*(D2 a, D2 b) { return {_mm_mul_pd(a.v, b.v)}; }
+inline D2 operator/(D2 a, D2 b) { return {_mm_div_pd(a.v, b.v)}; }
+inline D2 operator-(D2 a) { return {_mm_xor_pd(a.v, _mm_set1_pd(-0.))}; }
+inline D2 vsqrt(D2 a) { return {_mm_sqrt_pd(a.v)}; }
+inline D2 vgreater(D2 a, D2 b) { return {_mm_cmpgt_pd(a.v, b.v)}; }
+inline D2 vless(D2 a, D2 b) { return {_mm_cmplt_pd(a.v, b.v)}; }
+inline D2 vor(D2 a, D2 b) { return {_mm_or_pd(a.v, b.v)}; }
+inline D2 vselect(D2 mask, D2 a, D2 b) {
+  return {_mm_or_pd(_mm_and_pd(mask.v, a.v), _mm_andnot_pd(mask.v, b.v))};
+}
+
+template <>
+struct Pack<D2> {
+  typedef double Scalar;
+  typedef D2 Mask;
+  static const int width = 2;
+  static D2 splat(double v) { return {_mm_set1_pd(v)}; }
+  static D2 load(const double *p) { return {_mm_loadu_pd(p)}; }
+  static void store(double *p, D2 v) { _mm_storeu_pd(p, v.v); }
+};
+
+// [x0 y0] [z0 x1] [y1 z1] <-> [x0 x1] [y0 y1] [z0 z1]
+inline void loadAoS(const double *p, D2 (&v)[3]) {
+  __m128d a = _mm_loadu_pd(p), b = _mm_loadu_pd(p + 2), c = _mm_loadu_pd(p + 4);
+  v[0].v = _mm_shuffle_pd(a, b, 2);
+  v[1].v = _mm_shuffle_pd(a, c, 1);
+  v[2].v = _mm_shuffle_pd(b, c, 2);
+}
+inline void storeAoS(double *p, const D2 (&v)[3]) {
+  _mm_storeu_pd(p, _mm_shuffle_pd(v[0].v, v[1].v, 0));
+  _mm_storeu_pd(p + 2, _mm_shuffle_pd(v[2].v, v[0].v, 2));
+  _mm_storeu_pd(p + 4, _mm_shuffle_pd(v[1].v, v[2].v, 3));
+}
+
+#elif defined(AL_VEC_BATCH_NEON)
+
+struct F4 {
+  float32x4_t v;
+};
+
+struct M4 {
+  uint32x4_t v;
+};
+
+inline F4 operator+(F4 a, F4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline F4 operator-(F4 a, F4 b) { return {vsubq_f32(a.v, b.v)}; }
+inline F4 operator*(F4 a, F4 b) { return {vmulq_f32(a.v, b.v)}; }
+inline F4 operator-(F4 a) { return {vnegq_f32(a.v)}; }
+#if defined(__aarch64__)
+inline F4 operator/(F4 a, F4 b) { return {vdivq_f32(a.v, b.v)}; }
+inline F4 vsqrt(F4 a) { return {vsqrtq_f32(a.v)}; }
+#else
+// ARMv7 NEON has no division or square root
+inline F4 operator/(F4 a, F4 b) {
+  float x[4], y[4];
+  vst1q_f32(x, a.v);
+  vst1q_f32(y, b.v);
+  for (int i = 0; i < 4; i++) x[i] /= y[i];
+  return {vld1q_f32(x)};
+}
+inline F4 vsqrt(F4 a) {
+  float x[4];
+  vst1q_f32(x, a.v);
+  for (int i = 0; i < 4; i++) x[i] = std::sqrt(x[i]);
+  return {vld1q_f32(x)};
+}
+#endif
+inline M4 vgreater(F4 a, F4 b) { return {vcgtq_f32(a.v, b.v)}; }
+inline M4 vless(F4 a, F4 b) { return {vcltq_f32(a.v, b.v)}; }
+inline M4 vor(M4 a, M4 b) { return {vorrq_u32(a.v, b.v)}; }
+inline F4 vselect(M4 mask, F4 a, F4 b) { return {vbslq_f32(mask.v, a.v, b.v)}; }
+
+template <>
+struct Pack<F4> {
+  typedef float Scalar;
+  typedef M4 Mask;
+  static const int width = 4;
+  static F4 splat(float v) { return {vdupq_n_f32(v)}; }
+  static F4 load(const float *p) { return {vld1q_f32(p)}; }
+  static void store(float *p, F4 v) { vst1q_f32(p, v.v); }
+};
+
+inline void loadAoS(const float *p, F4 (&v)[3]) {
+  float32x4x3_t t = vld3q_f32(p);
+  for (int c = 0; c < 3; c++) v[c].v = t.val[c];
+}
+inline void storeAoS(float *p, const F4 (&v)[3]) {
+  float32x4x3_t t;
+  for (int c = 0; c < 3; c++) t.val[c] = v[c].v;
+  vst3q_f32(p, t);
+}
+inline void loadAoS(const float *p, F4 (&v)[4]) {
+  float32x4x4_t t = vld4q_f32(p);
+  for (int c = 0; c < 4; c++) v[c].v = t.val[c];
+}
+inline void storeAoS(float *p, const F4 (&v)[4]) {
+  float32x4x4_t t;
+  for (int c = 0; c < 4; c++) t.val[c] = v[c].v;
+  vst4q_f32(p, t);
+}
+
+#if defined(__aarch64__)
+#define AL_VEC_BATCH_NEON_DOUBLE
+
+struct D2 {
+  float64x2_t v;
+};
+
+struct M2 {
+  uint64x2_t v;
+};
+
+inline D2 operator+(D2 a, D2 b) { return {vaddq_f64(a.v, b.v)}; }
+inline D2 operator-(D2 a, D2 b) { return {vsubq_f64(a.v, b.v)}; }
+inline D2 operator*(D2 a, D2 b) { return {vmulq_f64(a.v, b.v)}; }
+inline D2 operator/(D2 a, D2 b) { return {vdivq_f64(a.v, b.v)}; }
+inline D2 operator-(D2 a) { return {vnegq_f64(a.v)}; }
+inline D2 vsqrt(D2 a) { return {vsqrtq_f64(a.v)}; }
+inline M2 vgreater(D2 a, D2 b) { return {vcgtq_f64(a.v, b.v)}; }
+inline M2 vless(D2 a, D2 b) { return {vcltq_f64(a.v, b.v)}; }
+inline M2 vor(M2 a, M2 b) { return {vorrq_u64(a.v, b.v)}; }
+inline D2 vselect(M2 mask, D2 a, D2 b) { return {vbslq_f64(mask.v, a.v, b.v)}; }
+
+template <>
+struct Pack<D2> {
+  typedef double Scalar;
+  typedef M2 Mask;
+  static const int width = 2;
+  static D2 splat(double v) { return {vdupq_n_f64(v)}; }
+  static D2 load(const double *p) { return {vld1q_f64(p)}; }
+  static void store(double *p, D2 v) { vst1q_f64(p, v.v); }
+};
+
+inline void loadAoS(const double *p, D2 (&v)[3]) {
+  float64x2x3_t t = vld3q_f64(p);
+  for (int c = 0; c < 3; c++) v[c].v = t.val[c];
+}
+inline void storeAoS(double *p, const D2 (&v)[3]) {
+  float64x2x3_t t;
+  for (int c = 0; c < 3; c++) t.val[c] = v[c].v;
+  vst3q_f64(p, t);
+}
+#endif
+
+#endif
+
+// Kernels for one block of width lanes. The arithmetic is written in the
+// same order as in Vec, Quat and Mat, so all lanes and the scalar
+// remainder give the same results.
+
+// Same as Quat::eps(), accuracyMax() and accuracyMin(). Inline functions of
+// the math classes are not called here, as the copies compiled for AVX could
+// be the ones kept by the linker.
+const double quatEps = 0.0000001;
+const double quatAccuracyMax = 1.000001;
+const double quatAccuracyMin = 0.999999;
+
+template <class P>
+inline void rotateBlock(const P (&q)[4], const typename Pack<P>::Scalar *in,
+                        typename Pack<P>::Scalar *out) {
+  const P &w = q[0], &x = q[1], &y = q[2], &z = q[3];
+  P v[3];
+  loadAoS(in, v);
+  P pw = -x * v[0] - y * v[1] - z * v[2];
+  P px = w * v[0] + y * v[2] - z * v[1];
+  P py = w * v[1] - x * v[2] + z * v[0];
+  P pz = w * v[2] + x * v[1] - y * v[0];
+  P r[3] = {px * w - pw * x + pz * y - py * z,
+            py * w - pw * y + px * z - pz * x,
+            pz * w - pw * z + py * x - px * y};
+  storeAoS(out, r);
+}
+
+template <class P>
+inline void transformBlock(const P (&m)[16], const P &w,
+                           const typename Pack<P>::Scalar *in,
+                           typename Pack<P>::Scalar *out) {
+  P v[3];
+  loadAoS(in, v);
+  P r[3];
+  for (int i = 0; i < 3; i++) {
+    r[i] = m[i] * v[0] + m[4 + i] * v[1] + m[8 + i] * v[2] + m[12 + i] * w;
+  }
+  storeAoS(out, r);
+}
+
+template <class P>
+inline void normalizeBlock(typename Pack<P>::Scalar *p) {
+  typedef Pack<P> Tr;
+  P v[3];
+  loadAoS(p, v);
+  P mag = vsqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  P scale = Tr::splat(1) / mag;
+  typename Tr::Mask valid = vgreater(mag, Tr::splat(1e-20));
+  P r[3] = {vselect(valid, v[0] * scale, Tr::splat(1)),
+            vselect(valid, v[1] * scale, Tr::splat(0)),
+            vselect(valid, v[2] * scale, Tr::splat(0))};
+  storeAoS(p, r);
+}
+
+template <class P>
+inline void normalizeQuatBlock(typename Pack<P>::Scalar *p) {
+  typedef Pack<P> Tr;
+  P q[4];
+  loadAoS(p, q);
+  P unit = q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3];
+  typename Tr::Mask identity = vless(unit * unit, Tr::splat(quatEps));
+  typename Tr::Mask scale = vor(vgreater(unit, Tr::splat(quatAccuracyMax)),
+                                vless(unit, Tr::splat(quatAccuracyMin)));
+  P s = vselect(scale, Tr::splat(1) / vsqrt(unit), Tr::splat(1));
+  for (int c = 0; c < 4; c++) {
+    q[c] = vselect(identity, Tr::splat(c == 0 ? 1 : 0), q[c] * s);
+  }
+  storeAoS(p, q);
+}
+
+template <class P>
+inline void dotBlock(const typename Pack<P>::Scalar *a,
+                     const typename Pack<P>::Scalar *b,
+                     typename Pack<P>::Scalar *out) {
+  P u[3], v[3];
+  loadAoS(a, u);
+  loadAoS(b, v);
+  Pack<P>::store(out, u[0] * v[0] + u[1] * v[1] + u[2] * v[2]);
+}
+
+template <class P>
+inline void multiplyBlock(const typename Pack<P>::Scalar *a,
+                          const typename Pack<P>::Scalar *b,
+                          typename Pack<P>::Scalar *out) {
+  P p[4], q[4];
+  loadAoS(a, p);
+  loadAoS(b, q);
+  const P &w = p[0], &x = p[1], &y = p[2], &z = p[3];
+  P r[4] = {w * q[0] - x * q[1] - y * q[2] - z * q[3],
+            w * q[1] + x * q[0] + y * q[3] - z * q[2],
+            w * q[2] + y * q[0] + z * q[1] - x * q[3],
+            w * q[3] + z * q[0] + x * q[2] - y * q[1]};
+  storeAoS(out, r);
+}
+
+// Whole array kernels, see VecBatchKernels
+
+template <class P>
+size_t rotateKernel(const typename Pack<P>::Scalar *q,
+                    const typename Pack<P>::Scalar *in,
+                    typename Pack<P>::Scalar *out, size_t n) {
+  const size_t W = Pack<P>::width;
+  P qp[4];
+  for (int c = 0; c < 4; c++) qp[c] = Pack<P>::splat(q[c]);
+  size_t i = 0;
+  for (; i + W <= n; i += W) rotateBlock(qp, in + 3 * i, out + 3 * i);
+  return i;
+}
+
+template <class P>
+size_t rotateEachKernel(const typename Pack<P>::Scalar *q,
+                        const typename Pack<P>::Scalar *in,
+                        typename Pack<P>::Scalar *out, size_t n) {
+  const size_t W = Pack<P>::width;
+  size_t i = 0;
+  for (; i + W <= n; i += W) {
+    P qp[4];
+    loadAoS(q + 4 * i, qp);
+    rotateBlock(qp, in + 3 * i, out + 3 * i);
+  }
+  return i;
+}
+
+template <class P>
+size_t transformKernel(const typename Pack<P>::Scalar *m,
+                       const typename Pack<P>::Scalar *in,
+                       typename Pack<P>::Scalar *out, size_t n,
+                       typename Pack<P>::Scalar w) {
+  const size_t W = Pack<P>::width;
+  P mp[16];
+  for (int j = 0; j < 16; j++) mp[j] = Pack<P>::splat(m[j]);
+  P wp = Pack<P>::splat(w);
+  size_t i = 0;
+  for (; i + W <= n; i += W) transformBlock(mp, wp, in + 3 * i, out + 3 * i);
+  return i;
+}
+
+template <class P>
+size_t normalizeKernel(typename Pack<P>::Scalar *v, size_t n) {
+  const size_t W = Pack<P>::width;
+  size_t i = 0;
+  for (; i + W <= n; i += W) normalizeBlock<P>(v + 3 * i);
+  return i;
+}
+
+template <class P>
+size_t normalizeQuatKernel(typename Pack<P>::Scalar *q, size_t n) {
+  const size_t W = Pack<P>::width;
+  size_t i = 0;
+  for (; i + W <= n; i += W) normalizeQuatBlock<P>(q + 4 * i);
+  return i;
+}
+
+template <class P>
+size_t dotKernel(const typename Pack<P>::Scalar *a,
+                 const typename Pack<P>::Scalar *b,
+                 typename Pack<P>::Scalar *out, size_t n) {
+  const size_t W = Pack<P>::width;
+  size_t i = 0;
+  for (; i + W <= n; i += W) dotBlock<P>(a + 3 * i, b + 3 * i, out + i);
+  return i;
+}
+
+template <class P>
+size_t multiplyKernel(const typename Pack<P>::Scalar *a,
+                      const typename Pack<P>::Scalar *b,
+                      typename Pack<P>::Scalar *out, size_t n) {
+  const size_t W = Pack<P>::width;
+  size_t i = 0;
+  for (; i + W <= n; i += W) multiplyBlock<P>(a + 4 * i, b + 4 * i, out + 4 * i);
+  return i;
+}
+
+/// Table of the kernels for float packs F and double packs D
+template <class F, class D>
+VecBatchKernels makeKernels(const char *name) {
+  VecBatchKernels k;
+  k.name = name;
+  k.rotatef = rotateKernel<F>;
+  k.rotated = rotateKernel<D>;
+  k.rotateEachf = rotateEachKernel<F>;
+  k.rotateEachd = rotateEachKernel<D>;
+  k.transformf = transformKernel<F>;
+  k.transformd = transformKernel<D>;
+  k.normalizef = normalizeKernel<F>;
+  k.normalized = normalizeKernel<D>;
+  k.normalizeQuatf = normalizeQuatKernel<F>;
+  k.normalizeQuatd = normalizeQuatKernel<D>;
+  k.dotf = dotKernel<F>;
+  k.dotd = dotKernel<D>;
+  k.multiplyf = multiplyKernel<F>;
+  k.multiplyd = multiplyKernel<D>;
+  return k;
+}
+
+}  // namespace
+
+}  // al::
+
+#endif
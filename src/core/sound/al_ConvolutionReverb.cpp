@@ -0,0 +1,352 @@
+#include "al/core/sound/al_ConvolutionReverb.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+#include "Gamma/FFT.h"
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define AL_CONVOLUTION_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AL_CONVOLUTION_NEON
+#endif
+
+using namespace al;
+
+namespace {
+
+// acc += x * h for n complex values in split format, n a multiple of 4
+inline void complexMultiplyAccumulate(float *accRe, float *accIm,
+                                      const float *xRe, const float *xIm,
+                                      const float *hRe, const float *hIm,
+                                      size_t n) {
+#if defined(AL_CONVOLUTION_SSE)
+  for (size_t i = 0; i < n; i += 4) {
+    __m128 xr = _mm_loadu_ps(xRe + i), xi = _mm_loadu_ps(xIm + i);
+    __m128 hr = _mm_loadu_ps(hRe + i), hi = _mm_loadu_ps(hIm + i);
+    __m128 re = _mm_sub_ps(_mm_mul_ps(xr, hr), _mm_mul_ps(xi, hi));
+    __m128 im = _mm_add_ps(_mm_mul_ps(xr, hi), _mm_mul_ps(xi, hr));
+    _mm_storeu_ps(accRe + i, _mm_add_ps(_mm_loadu_ps(accRe + i), re));
+    _mm_storeu_ps(accIm + i, _mm_add_ps(_mm_loadu_ps(accIm + i), im));
+  }
+#elif defined(AL_CONVOLUTION_NEON)
+  for (size_t i = 0; i < n; i += 4) {
+    float32x4_t xr = vld1q_f32(xRe + i), xi = vld1q_f32(xIm + i);
+    float32x4_t hr = vld1q_f32(hRe + i), hi = vld1q_f32(hIm + i);
+    float32x4_t re = vld1q_f32(accRe + i), im = vld1q_f32(accIm + i);
+    re = vmlsq_f32(vmlaq_f32(re, xr, hr), xi, hi);
+    im = vmlaq_f32(vmlaq_f32(im, xr, hi), xi, hr);
+    vst1q_f32(accRe + i, re);
+    vst1q_f32(accIm + i, im);
+  }
+#else
+  for (size_t i = 0; i < n; i++) {
+    accRe[i] += xRe[i] * hRe[i] - xIm[i] * hIm[i];
+    accIm[i] += xRe[i] * hIm[i] + xIm[i] * hRe[i];
+  }
+#endif
+}
+
+// Positive modulo for block numbers, which start negative in the delay line
+inline size_t slot(int64_t block, size_t size) {
+  int64_t s = block % int64_t(size);
+  return size_t(s < 0 ? s + int64_t(size) : s);
+}
+
+}  // namespace
+
+ConvolutionReverb::ConvolutionReverb() {}
+
+ConvolutionReverb::~ConvolutionReverb() { stopWorker(); }
+
+bool ConvolutionReverb::configure(uint32_t partitionSize,
+                                  std::vector<float *> IRs, uint32_t IRlength,
+                                  bool tailThread, uint32_t headPartitions) {
+  stopWorker();
+  mChannelIR.clear();
+  mNumPartitions = 0;
+  if (partitionSize < 4 || (partitionSize & (partitionSize - 1)) != 0) {
+    std::cerr << "ERROR ConvolutionReverb: partition size " << partitionSize
+              << " is not a power of two" << std::endl;
+    return false;
+  }
+  if (IRs.size() == 0 || IRlength == 0) {
+    std::cerr << "ERROR ConvolutionReverb: no IRs" << std::endl;
+    return false;
+  }
+
+  mPartitionSize = partitionSize;
+  mNumPartitions = (IRlength + partitionSize - 1) / partitionSize;
+  mHeadPartitions = mNumPartitions;
+  if (tailThread && headPartitions > 0 && headPartitions < mNumPartitions) {
+    mHeadPartitions = headPartitions;
+  }
+  // Bins 0 to partitionSize, padded to a multiple of 4
+  mSpectrumStride = partitionSize + 4;
+  size_t fftSize = 2 * partitionSize;
+  mFFT.reset(new gam::RFFT<float>(int(fftSize)));
+  mFFTBuffer.assign(fftSize + 2, 0.0f);
+  mAccum.assign(2 * mSpectrumStride, 0.0f);
+
+  // Transform each partition, zero padded to the FFT size. The inverse
+  // transform is not normalized, so the IR spectra are scaled instead.
+  mIRSpectra.clear();
+  std::map<const float *, uint32_t> irIndices;
+  float scale = 1.0f / fftSize;
+  for (auto ir : IRs) {
+    auto found = irIndices.find(ir);
+    if (found != irIndices.end()) {
+      mChannelIR.push_back(found->second);
+      continue;
+    }
+    uint32_t index = uint32_t(mIRSpectra.size());
+    irIndices[ir] = index;
+    mChannelIR.push_back(index);
+    mIRSpectra.emplace_back(mNumPartitions * 2 * mSpectrumStride, 0.0f);
+    for (uint32_t p = 0; p < mNumPartitions; p++) {
+      std::fill(mFFTBuffer.begin(), mFFTBuffer.end(), 0.0f);
+      uint32_t start = p * partitionSize;
+      uint32_t count = std::min(partitionSize, IRlength - start);
+      // Real input starts at index 1 for complex output
+      std::memcpy(mFFTBuffer.data() + 1, ir + start, count * sizeof(float));
+      mFFT->forward(mFFTBuffer.data(), true, false);
+      float *spectrum = mIRSpectra.back().data() + p * 2 * mSpectrumStride;
+      for (uint32_t k = 0; k <= partitionSize; k++) {
+        spectrum[k] = mFFTBuffer[2 * k] * scale;
+        spectrum[mSpectrumStride + k] = mFFTBuffer[2 * k + 1] * scale;
+      }
+    }
+  }
+
+  size_t numChannels = mChannelIR.size();
+  mFDL.assign(numChannels, std::vector<float>(mNumPartitions * 2 * mSpectrumStride, 0.0f));
+  mHistory.assign(numChannels, std::vector<float>(partitionSize, 0.0f));
+  mTails.clear();
+  if (mHeadPartitions < mNumPartitions) {
+    mTails.assign(numChannels, std::vector<float>(mHeadPartitions * 2 * mSpectrumStride, 0.0f));
+    mTailReady.reset(new std::atomic<int64_t>[mHeadPartitions]);
+  }
+  mBuffers.assign(numChannels, nullptr);
+  mBlockBuffers.assign(numChannels, nullptr);
+  mBufferSizeReported = false;
+  reset();
+  if (mHeadPartitions < mNumPartitions) {
+    startWorker();
+  }
+  return true;
+}
+
+void ConvolutionReverb::reset() {
+  bool restart = mWorkerRunning;
+  stopWorker();
+  for (auto &fdl : mFDL) {
+    std::fill(fdl.begin(), fdl.end(), 0.0f);
+  }
+  for (auto &history : mHistory) {
+    std::fill(history.begin(), history.end(), 0.0f);
+  }
+  mBlock = 0;
+  mBlocksDone = 0;
+  // The tails of the first blocks only have silence before the start
+  if (mTails.size() > 0) {
+    for (auto &tail : mTails) {
+      std::fill(tail.begin(), tail.end(), 0.0f);
+    }
+    for (uint32_t s = 0; s < mHeadPartitions; s++) {
+      mTailReady[s] = s;
+    }
+  }
+  mTailClaimed = int64_t(mHeadPartitions) - 1;
+  if (restart) {
+    startWorker();
+  }
+}
+
+float *ConvolutionReverb::fdlSpectrum(size_t channel, int64_t block) {
+  return mFDL[channel].data() + slot(block, mNumPartitions) * 2 * mSpectrumStride;
+}
+
+float *ConvolutionReverb::irSpectrum(size_t channel, uint32_t partition) {
+  return mIRSpectra[mChannelIR[channel]].data() + partition * 2 * mSpectrumStride;
+}
+
+float *ConvolutionReverb::tailSpectrum(size_t channel, int64_t block) {
+  return mTails[channel].data() + slot(block, mHeadPartitions) * 2 * mSpectrumStride;
+}
+
+void ConvolutionReverb::multiplyPartitions(size_t channel, int64_t block,
+                                           uint32_t begin, uint32_t end,
+                                           float *accum) {
+  size_t stride = mSpectrumStride;
+  for (uint32_t p = begin; p < end; p++) {
+    // Blocks before the first are zero in the delay line
+    const float *x = fdlSpectrum(channel, block - p);
+    const float *h = irSpectrum(channel, p);
+    complexMultiplyAccumulate(accum, accum + stride, x, x + stride, h,
+                              h + stride, stride);
+  }
+}
+
+void ConvolutionReverb::computeTail(int64_t block) {
+  for (size_t c = 0; c < mChannelIR.size(); c++) {
+    float *tail = tailSpectrum(c, block);
+    std::fill(tail, tail + 2 * mSpectrumStride, 0.0f);
+    multiplyPartitions(c, block, mHeadPartitions, mNumPartitions, tail);
+  }
+  mTailReady[slot(block, mHeadPartitions)] = block;
+}
+
+bool ConvolutionReverb::process(float *const *buffers,
+                                unsigned int numChannels,
+                                unsigned int numFrames) {
+  if (mNumPartitions == 0 || numFrames % mPartitionSize != 0) {
+    return false;
+  }
+  numChannels = std::min(numChannels, (unsigned int)mChannelIR.size());
+  for (unsigned int offset = 0; offset < numFrames; offset += mPartitionSize) {
+    for (unsigned int c = 0; c < numChannels; c++) {
+      mBlockBuffers[c] = buffers[c] + offset;
+    }
+    processBlock(mBlockBuffers.data(), numChannels);
+  }
+  return true;
+}
+
+void ConvolutionReverb::processBlock(float *const *buffers,
+                                     unsigned int numChannels) {
+  size_t n = mPartitionSize;
+  size_t stride = mSpectrumStride;
+  float *fftBuffer = mFFTBuffer.data();
+  bool useTail = mTails.size() > 0;
+
+  bool lateTail = false;
+  if (useTail && mTailReady[slot(mBlock, mHeadPartitions)].load() != mBlock) {
+    // The worker is late. Compute the tail here, into the accumulator rather
+    // than the tail slot, which the worker may be writing. The worker only
+    // reads delay line slots of earlier blocks, so the two don't conflict.
+    // Claiming the tail keeps the worker from starting it now.
+    int64_t expected = mBlock - 1;
+    mTailClaimed.compare_exchange_strong(expected, mBlock);
+    lateTail = true;
+    mLateTails++;
+  }
+
+  for (size_t c = 0; c < mChannelIR.size(); c++) {
+    // Channels not passed are processed as silence to keep their state
+    float *io = c < numChannels ? buffers[c] : nullptr;
+    std::vector<float> &history = mHistory[c];
+
+    // Overlap-save: transform the previous and the current block
+    fftBuffer[0] = 0.0f;
+    std::memcpy(fftBuffer + 1, history.data(), n * sizeof(float));
+    if (io) {
+      std::memcpy(fftBuffer + 1 + n, io, n * sizeof(float));
+      std::memcpy(history.data(), io, n * sizeof(float));
+    } else {
+      std::fill(fftBuffer + 1 + n, fftBuffer + 1 + 2 * n, 0.0f);
+      std::fill(history.begin(), history.end(), 0.0f);
+    }
+    mFFT->forward(fftBuffer, true, false);
+    float *x = fdlSpectrum(c, mBlock);
+    for (size_t k = 0; k <= n; k++) {
+      x[k] = fftBuffer[2 * k];
+      x[stride + k] = fftBuffer[2 * k + 1];
+    }
+
+    float *accum = mAccum.data();
+    if (useTail && !lateTail) {
+      std::memcpy(accum, tailSpectrum(c, mBlock), 2 * stride * sizeof(float));
+      multiplyPartitions(c, mBlock, 0, mHeadPartitions, accum);
+    } else {
+      std::fill(mAccum.begin(), mAccum.end(), 0.0f);
+      multiplyPartitions(c, mBlock, 0, mNumPartitions, accum);
+    }
+
+    for (size_t k = 0; k <= n; k++) {
+      fftBuffer[2 * k] = accum[k];
+      fftBuffer[2 * k + 1] = accum[stride + k];
+    }
+    mFFT->inverse(fftBuffer, true);
+    if (io) {
+      // The second half of the output is the linear convolution
+      const float *wet = fftBuffer + 1 + n;
+      for (size_t i = 0; i < n; i++) {
+        io[i] = mDry * io[i] + mWet * wet[i];
+      }
+    }
+  }
+  mBlock++;
+  // The worker may now use this block, and the tail slot can be reused
+  mBlocksDone = mBlock;
+}
+
+void ConvolutionReverb::onAudioCB(AudioIOData &io) {
+  unsigned int numChannels =
+      std::min((unsigned int)io.channelsOut(), (unsigned int)mChannelIR.size());
+  for (unsigned int c = 0; c < numChannels; c++) {
+    mBuffers[c] = io.outBuffer(c);
+  }
+  if (!process(mBuffers.data(), numChannels, io.framesPerBuffer())
+      && mNumPartitions > 0 && !mBufferSizeReported) {
+    mBufferSizeReported = true;
+    std::cerr << "ERROR ConvolutionReverb: " << io.framesPerBuffer()
+              << " frames per buffer is not a multiple of the partition size "
+              << mPartitionSize << ". Output is not processed." << std::endl;
+  }
+}
+
+void ConvolutionReverb::startWorker() {
+  if (mWorkerRunning) {
+    return;
+  }
+  mWorkerRunning = true;
+  mWorker = std::thread(&ConvolutionReverb::workerFunction, this);
+}
+
+void ConvolutionReverb::stopWorker() {
+  {
+    std::lock_guard<std::mutex> lk(mWorkerLock);
+    if (!mWorkerRunning) {
+      return;
+    }
+    mWorkerRunning = false;
+  }
+  mWorkerCondVar.notify_one();
+  mWorker.join();
+}
+
+void ConvolutionReverb::workerFunction() {
+  std::unique_lock<std::mutex> lk(mWorkerLock);
+  while (mWorkerRunning) {
+    // The tail of a block needs input up to headPartitions blocks before it.
+    // Its slot is free once the block headPartitions before has been output.
+    int64_t next = mTailClaimed.load() + 1;
+    if (next < mBlocksDone.load() + mHeadPartitions) {
+      int64_t expected = next - 1;
+      if (mTailClaimed.compare_exchange_strong(expected, next)) {
+        lk.unlock();
+        computeTail(next);
+        lk.lock();
+      }
+      continue;
+    }
+    // The audio thread doesn't signal, so poll for new input
+    mWorkerCondVar.wait_for(lk, std::chrono::milliseconds(1));
+  }
+}
+
+const char *ConvolutionReverb::instructionSet() {
+#if defined(AL_CONVOLUTION_SSE)
+  return "SSE";
+#elif defined(AL_CONVOLUTION_NEON)
+  return "NEON";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,316 @@
+#include "al/core/sound/al_FilterBank.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+#include "al/core/sound/al_Crossover.hpp"
+#include "al_FilterBankKernels.hpp"
+
+using namespace al;
+
+namespace {
+
+const FilterBankKernels scalarKernels = makeKernels<float>("scalar");
+
+#if defined(AL_FILTER_BANK_SSE)
+const FilterBankKernels simdKernels = makeKernels<F4>("SSE2");
+#elif defined(AL_FILTER_BANK_NEON)
+const FilterBankKernels simdKernels = makeKernels<F4>("NEON");
+#endif
+
+// Checks that both the CPU and the operating system support AVX
+bool cpuHasAVX() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int info[4];
+  __cpuid(info, 1);
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  return osxsave && avx && (_xgetbv(0) & 6) == 6;
+#elif (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx");
+#else
+  return false;
+#endif
+}
+
+// Available kernels, fastest first
+std::vector<const FilterBankKernels *> availableKernels() {
+  std::vector<const FilterBankKernels *> kernels;
+  const FilterBankKernels *avx = filterBankAVXKernels();
+  if (avx && cpuHasAVX()) kernels.push_back(avx);
+#if defined(AL_FILTER_BANK_SSE) || defined(AL_FILTER_BANK_NEON)
+  kernels.push_back(&simdKernels);
+#endif
+  kernels.push_back(&scalarKernels);
+  return kernels;
+}
+
+std::atomic<const FilterBankKernels *> &activeKernels() {
+  static std::atomic<const FilterBankKernels *> active(availableKernels()[0]);
+  return active;
+}
+
+// Samples of the channels [first, first + lanes) interleaved in groups of W
+// channels. Missing channels are zero.
+void interleave(const float *const *in, unsigned int first, unsigned int lanes,
+                unsigned int W, unsigned int offset, unsigned int frames,
+                float *x) {
+  for (unsigned int lane = 0; lane < W; lane++) {
+    if (lane < lanes) {
+      const float *src = in[first + lane] + offset;
+      for (unsigned int f = 0; f < frames; f++) x[f * W + lane] = src[f];
+    } else {
+      for (unsigned int f = 0; f < frames; f++) x[f * W + lane] = 0.0f;
+    }
+  }
+}
+
+void deinterleave(const float *x, unsigned int first, unsigned int lanes,
+                  unsigned int W, unsigned int offset, unsigned int frames,
+                  float *const *out) {
+  for (unsigned int lane = 0; lane < lanes; lane++) {
+    float *dst = out[first + lane] + offset;
+    for (unsigned int f = 0; f < frames; f++) dst[f] = x[f * W + lane];
+  }
+}
+
+// The kernels run all lanes of a group. The states of channels of the bank
+// that were not passed to process() are restored afterwards, as if they had
+// not been processed.
+void restoreLanes(const float *saved, float *states, unsigned int numStates,
+                  unsigned int lanes, unsigned int W) {
+  for (unsigned int k = 0; k < numStates; k++) {
+    for (unsigned int lane = lanes; lane < W; lane++) {
+      states[k * W + lane] = saved[k * W + lane];
+    }
+  }
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// FilterBank
+
+const unsigned int FilterBank::CHUNK;
+
+FilterBank::FilterBank() : mKernels(activeKernels().load()) {}
+
+unsigned int FilterBank::lanes() const { return mKernels->width; }
+
+unsigned int FilterBank::setup(unsigned int numChannels) {
+  mKernels = activeKernels().load();
+  mChannels = numChannels;
+  return (numChannels + lanes() - 1) / lanes();
+}
+
+const char *FilterBank::instructionSet() { return activeKernels().load()->name; }
+
+std::vector<const char *> FilterBank::instructionSets() {
+  std::vector<const char *> names;
+  for (auto *k : availableKernels()) names.push_back(k->name);
+  return names;
+}
+
+bool FilterBank::useInstructionSet(const char *name) {
+  for (auto *k : availableKernels()) {
+    if (strcmp(k->name, name) == 0) {
+      activeKernels().store(k);
+      return true;
+    }
+  }
+  return false;
+}
+
+// ---------------------------------------------------------------------------
+// BiquadBank
+
+BiquadBank::BiquadBank(unsigned int numChannels, unsigned int numStages) {
+  resize(numChannels, numStages);
+}
+
+void BiquadBank::resize(unsigned int numChannels, unsigned int numStages) {
+  unsigned int groups = setup(numChannels);
+  mStages = numStages;
+  mCoefs.assign(groups * mStages * 5 * lanes(), 0.0f);
+  mStates.assign(groups * mStages * 2 * lanes(), 0.0f);
+  // Pass through until coefficients are set
+  for (unsigned int i = 0; i < groups * mStages; i++) {
+    std::fill_n(mCoefs.data() + i * 5 * lanes(), lanes(), 1.0f);
+  }
+}
+
+float *BiquadBank::coef(unsigned int channel, unsigned int stage) {
+  unsigned int W = lanes();
+  return mCoefs.data() + ((channel / W) * mStages + stage) * 5 * W + channel % W;
+}
+
+float *BiquadBank::state(unsigned int channel, unsigned int stage) {
+  unsigned int W = lanes();
+  return mStates.data() + ((channel / W) * mStages + stage) * 2 * W + channel % W;
+}
+
+void BiquadBank::coefficients(unsigned int channel, unsigned int stage,
+                              float b0, float b1, float b2, float a1,
+                              float a2) {
+  if (channel >= mChannels || stage >= mStages) return;
+  unsigned int W = lanes();
+  float *c = coef(channel, stage);
+  c[0] = b0;
+  c[W] = b1;
+  c[2 * W] = b2;
+  c[3 * W] = a1;
+  c[4 * W] = a2;
+}
+
+void BiquadBank::butterworth(double frequency, double sampleRate,
+                             bool lowpass) {
+  // Bilinear transform of a second order Butterworth filter
+  const double K = std::tan(M_PI * frequency / sampleRate);
+  const double K2 = K * K;
+  const double norm = 1.0 / (1.0 + std::sqrt(2.0) * K + K2);
+  const double b0 = lowpass ? K2 * norm : norm;
+  const double b1 = lowpass ? 2.0 * b0 : -2.0 * b0;
+  const double a1 = 2.0 * (K2 - 1.0) * norm;
+  const double a2 = (1.0 - std::sqrt(2.0) * K + K2) * norm;
+  for (unsigned int chan = 0; chan < mChannels; chan++) {
+    for (unsigned int stage = 0; stage < mStages; stage++) {
+      coefficients(chan, stage, b0, b1, b0, a1, a2);
+    }
+  }
+}
+
+void BiquadBank::lowpass(double frequency, double sampleRate) {
+  butterworth(frequency, sampleRate, true);
+}
+
+void BiquadBank::highpass(double frequency, double sampleRate) {
+  butterworth(frequency, sampleRate, false);
+}
+
+void BiquadBank::clear() { std::fill(mStates.begin(), mStates.end(), 0.0f); }
+
+float BiquadBank::next(unsigned int channel, float in) {
+  unsigned int W = lanes();
+  float x = in;
+  for (unsigned int stage = 0; stage < mStages; stage++) {
+    const float *c = coef(channel, stage);
+    float *z = state(channel, stage);
+    const float y = c[0] * x + z[0];
+    z[0] = c[W] * x - c[3 * W] * y + z[W];
+    z[W] = c[2 * W] * x - c[4 * W] * y;
+    x = y;
+  }
+  return x;
+}
+
+void BiquadBank::process(const float *const *in, float *const *out,
+                         unsigned int numChannels, unsigned int numFrames) {
+  const unsigned int W = lanes();
+  numChannels = std::min(numChannels, mChannels);
+  float x[CHUNK * 8];
+  for (unsigned int first = 0; first < numChannels; first += W) {
+    const unsigned int count = std::min(W, numChannels - first);
+    const unsigned int group = first / W;
+    float *coefs = mCoefs.data() + group * mStages * 5 * W;
+    float *states = mStates.data() + group * mStages * 2 * W;
+    float savedStates[2 * 8];
+    const bool partial = count < W && first + count < mChannels;
+    for (unsigned int offset = 0; offset < numFrames; offset += CHUNK) {
+      const unsigned int frames = std::min(CHUNK, numFrames - offset);
+      interleave(in, first, count, W, offset, frames, x);
+      for (unsigned int stage = 0; stage < mStages; stage++) {
+        float *z = states + stage * 2 * W;
+        if (partial) std::memcpy(savedStates, z, 2 * W * sizeof(float));
+        mKernels->biquad(x, frames, 1, coefs + stage * 5 * W, z);
+        if (partial) restoreLanes(savedStates, z, 2, count, W);
+      }
+      deinterleave(x, first, count, W, offset, frames, out);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// CrossoverBank
+
+CrossoverBank::CrossoverBank(unsigned int numChannels) { resize(numChannels); }
+
+void CrossoverBank::resize(unsigned int numChannels) {
+  unsigned int groups = setup(numChannels);
+  mCoefs.assign(groups * 2 * lanes(), 0.0f);
+  mStates.assign(groups * 3 * lanes(), 0.0f);
+  freq(1000.0f, 44100.0f);
+}
+
+void CrossoverBank::freq(float frequency, float sampleRate) {
+  for (unsigned int chan = 0; chan < mChannels; chan++) {
+    freq(chan, frequency, sampleRate);
+  }
+}
+
+void CrossoverBank::freq(unsigned int channel, float frequency,
+                         float sampleRate) {
+  if (channel >= mChannels) return;
+  // Same coefficients as the single channel filter
+  Crossover<float> crossover(frequency, sampleRate);
+  unsigned int W = lanes();
+  float *c = mCoefs.data() + (channel / W) * 2 * W + channel % W;
+  c[0] = crossover.c0();
+  c[W] = crossover.c1();
+}
+
+void CrossoverBank::clear() { std::fill(mStates.begin(), mStates.end(), 0.0f); }
+
+void CrossoverBank::next(unsigned int channel, float in, float &lo,
+                         float &hi) {
+  unsigned int W = lanes();
+  const float *c = mCoefs.data() + (channel / W) * 2 * W + channel % W;
+  float *z = mStates.data() + (channel / W) * 3 * W + channel % W;
+  const float c0 = c[0], c1 = c[W];
+  const float d = Crossover<float>::denormOffset();
+  const float v0 = in - c0 * z[0];
+  const float x0 = z[0] + c0 * v0;
+  const float v1 = c1 * (in - z[W]);
+  const float x1 = v1 + z[W];
+  const float v2 = c1 * (x1 - z[2 * W]);
+  const float x2 = v2 + z[2 * W];
+  z[0] = v0 + d;
+  z[W] = v1 + x1 + d;
+  z[2 * W] = v2 + x2 + d;
+  lo = x2;
+  hi = x0 - x2;
+}
+
+void CrossoverBank::process(const float *const *in, float *const *lo,
+                            float *const *hi, unsigned int numChannels,
+                            unsigned int numFrames) {
+  const unsigned int W = lanes();
+  const float d = Crossover<float>::denormOffset();
+  numChannels = std::min(numChannels, mChannels);
+  float x[CHUNK * 8], xlo[CHUNK * 8], xhi[CHUNK * 8];
+  for (unsigned int first = 0; first < numChannels; first += W) {
+    const unsigned int count = std::min(W, numChannels - first);
+    const unsigned int group = first / W;
+    const float *coefs = mCoefs.data() + group * 2 * W;
+    float *states = mStates.data() + group * 3 * W;
+    float savedStates[3 * 8];
+    const bool partial = count < W && first + count < mChannels;
+    for (unsigned int offset = 0; offset < numFrames; offset += CHUNK) {
+      const unsigned int frames = std::min(CHUNK, numFrames - offset);
+      interleave(in, first, count, W, offset, frames, x);
+      if (partial) std::memcpy(savedStates, states, 3 * W * sizeof(float));
+      mKernels->crossover(x, xlo, xhi, frames, coefs, states, d);
+      if (partial) restoreLanes(savedStates, states, 3, count, W);
+      deinterleave(xlo, first, count, W, offset, frames, lo);
+      deinterleave(xhi, first, count, W, offset, frames, hi);
+    }
+  }
+}
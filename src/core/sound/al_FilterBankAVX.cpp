@@ -0,0 +1,44 @@
+// AVX kernels of BiquadBank and CrossoverBank, processing 8 channels at a
+// time. This file is compiled with AVX enabled (see CMakeLists.txt) and its
+// kernels are only selected at runtime when the CPU supports AVX. Without the
+// compiler flag it only provides a null table.
+
+#include "al_FilterBankKernels.hpp"
+
+#if defined(__AVX__)
+
+#include <immintrin.h>
+
+namespace al {
+
+namespace {
+
+struct F8 {
+  __m256 v;
+};
+
+inline F8 operator+(F8 a, F8 b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline F8 operator-(F8 a, F8 b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline F8 operator*(F8 a, F8 b) { return {_mm256_mul_ps(a.v, b.v)}; }
+
+template <>
+struct Pack<F8> {
+  static const int width = 8;
+  static F8 splat(float v) { return {_mm256_set1_ps(v)}; }
+  static F8 load(const float *p) { return {_mm256_loadu_ps(p)}; }
+  static void store(float *p, F8 v) { _mm256_storeu_ps(p, v.v); }
+};
+
+const FilterBankKernels avxKernels = makeKernels<F8>("AVX");
+
+}  // namespace
+
+const FilterBankKernels *filterBankAVXKernels() { return &avxKernels; }
+
+}  // namespace al
+
+#else
+
+const al::FilterBankKernels *al::filterBankAVXKernels() { return nullptr; }
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef INCLUDE_AL_FILTERBANKKERNELS_HPP
+#define INCLUDE_AL_FILTERBANKKERNELS_HPP
+
+// Kernels of BiquadBank and CrossoverBank, written once over a "pack" of
+// lanes, one channel per lane. A pack is a plain float for the scalar
+// fallback or a wrapper around a SIMD register. Both al_FilterBank.cpp and
+// al_FilterBankAVX.cpp, which is compiled with AVX enabled, include this
+// file. Everything in here has internal linkage, so the kernels compiled for
+// AVX can not end up being called on machines without it.
+//
+// The operations are the same, in the same order, as in the per-sample
+// functions, so every lane gives bit-identical results.
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AL_FILTER_BANK_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AL_FILTER_BANK_NEON
+#endif
+
+namespace al {
+
+/// Kernels for one instruction set. Samples are interleaved in groups of
+/// width channels, x[frame * width + lane]. Coefficients and states of a
+/// group are stored one array of width values after the other.
+struct FilterBankKernels {
+  const char *name;
+  int width;
+  /// Cascade of biquads in transposed direct form II, in place. Five
+  /// coefficients (b0, b1, b2, a1, a2) and two states per stage
+  void (*biquad)(float *x, int frames, int stages, const float *coefs,
+                 float *states);
+  /// Crossover filter. Two coefficients (c0, c1) and three states
+  void (*crossover)(const float *x, float *lo, float *hi, int frames,
+                    const float *coefs, float *states, float denormOffset);
+};
+
+/// AVX kernels, nullptr if the library was built without them
+const FilterBankKernels *filterBankAVXKernels();
+
+namespace {
+
+template <class P>
+struct Pack;
+
+template <>
+struct Pack<float> {
+  static const int width = 1;
+  static float splat(float v) { return v; }
+  static float load(const float *p) { return *p; }
+  static void store(float *p, float v) { *p = v; }
+};
+
+#if defined(AL_FILTER_BANK_SSE)
+
+struct F4 {
+  __m128 v;
+};
+
+inline F4 operator+(F4 a, F4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline F4 operator-(F4 a, F4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline F4 operator*(F4 a, F4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+
+template <>
+struct Pack<F4> {
+  static const int width = 4;
+  static F4 splat(float v) { return {_mm_set1_ps(v)}; }
+  static F4 load(const float *p) { return {_mm_loadu_ps(p)}; }
+  static void store(float *p, F4 v) { _mm_storeu_ps(p, v.v); }
+};
+
+#elif defined(AL_FILTER_BANK_NEON)
+
+struct F4 {
+  float32x4_t v;
+};
+
+// vmlaq_f32 may be fused, so multiplies and adds are kept separate
+inline F4 operator+(F4 a, F4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline F4 operator-(F4 a, F4 b) { return {vsubq_f32(a.v, b.v)}; }
+inline F4 operator*(F4 a, F4 b) { return {vmulq_f32(a.v, b.v)}; }
+
+template <>
+struct Pack<F4> {
+  static const int width = 4;
+  static F4 splat(float v) { return {vdupq_n_f32(v)}; }
+  static F4 load(const float *p) { return {vld1q_f32(p)}; }
+  static void store(float *p, F4 v) { vst1q_f32(p, v.v); }
+};
+
+#endif
+
+template <class P>
+void biquadKernel(float *x, int frames, int stages, const float *coefs,
+                  float *states) {
+  typedef Pack<P> K;
+  const int W = K::width;
+  // Each stage runs over all frames, keeping its state in registers
+  for (int s = 0; s < stages; s++) {
+    const float *c = coefs + s * 5 * W;
+    const P b0 = K::load(c), b1 = K::load(c + W), b2 = K::load(c + 2 * W);
+    const P a1 = K::load(c + 3 * W), a2 = K::load(c + 4 * W);
+    float *z = states + s * 2 * W;
+    P z1 = K::load(z), z2 = K::load(z + W);
+    for (int f = 0; f < frames; f++) {
+      const P in = K::load(x + f * W);
+      const P y = b0 * in + z1;
+      z1 = b1 * in - a1 * y + z2;
+      z2 = b2 * in - a2 * y;
+      K::store(x + f * W, y);
+    }
+    K::store(z, z1);
+    K::store(z + W, z2);
+  }
+}
+
+template <class P>
+void crossoverKernel(const float *x, float *lo, float *hi, int frames,
+                     const float *coefs, float *states, float denormOffset) {
+  typedef Pack<P> K;
+  const int W = K::width;
+  const P c0 = K::load(coefs), c1 = K::load(coefs + W);
+  const P d = K::splat(denormOffset);
+  P z0 = K::load(states), z1 = K::load(states + W), z2 = K::load(states + 2 * W);
+  for (int f = 0; f < frames; f++) {
+    const P in = K::load(x + f * W);
+    const P v0 = in - c0 * z0;
+    const P x0 = z0 + c0 * v0;
+    const P v1 = c1 * (in - z1);
+    const P x1 = v1 + z1;
+    const P v2 = c1 * (x1 - z2);
+    const P x2 = v2 + z2;
+    z0 = v0 + d;
+    z1 = v1 + x1 + d;
+    z2 = v2 + x2 + d;
+    K::store(lo + f * W, x2);
+    K::store(hi + f * W, x0 - x2);
+  }
+  K::store(states, z0);
+  K::store(states + W, z1);
+  K::store(states + 2 * W, z2);
+}
+
+template <class P>
+FilterBankKernels makeKernels(const char *name) {
+  return {name, Pack<P>::width, biquadKernel<P>, crossoverKernel<P>};
+}
+
+}  // namespace
+
+}  // namespace al
+
+#endif
@@ -0,0 +1,475 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#include "al/core/system/al_SharedMemory.hpp"
+
+#ifndef AL_WINDOWS
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef AL_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+using namespace al;
+
+namespace {
+
+constexpr uint32_t kRingMagic = 0x414c5352; // "ALSR"
+constexpr uint32_t kRingVersion = 2;
+constexpr size_t kCacheLine = 64;
+
+size_t roundUp(size_t value, size_t multiple) {
+  return ((value + multiple - 1) / multiple) * multiple;
+}
+
+#ifdef AL_LINUX
+// Futexes are not marked private as the word lives in memory shared between
+// processes.
+void futexWait(std::atomic<uint32_t> *word, uint32_t expected, double timeoutSec) {
+  struct timespec ts;
+  ts.tv_sec = (time_t) timeoutSec;
+  ts.tv_nsec = (long) ((timeoutSec - ts.tv_sec) * 1.0e9);
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+void futexWakeAll(std::atomic<uint32_t> *word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+#else
+void futexWait(std::atomic<uint32_t> *word, uint32_t expected, double timeoutSec) {
+  // No cross-process futex available. Poll with short sleeps instead.
+  auto sleepTime = std::min(timeoutSec, 0.0002);
+  if (word->load(std::memory_order_acquire) == expected) {
+    std::this_thread::sleep_for(std::chrono::duration<double>(sleepTime));
+  }
+}
+
+void futexWakeAll(std::atomic<uint32_t> *word) { (void) word; }
+#endif
+
+#ifndef AL_WINDOWS
+// A reader slot whose process has exited without removing it
+bool processIsGone(int32_t pid) {
+  return pid > 0 && kill(pid, 0) != 0 && errno == ESRCH;
+}
+#endif
+
+} // namespace
+
+struct SharedMemoryRing::Header {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t slotSize;
+  uint64_t slotStride;
+  uint32_t numSlots;
+  uint32_t maxReaders;
+  uint64_t readersOffset;
+  uint64_t slotsOffset;
+  uint64_t totalSize;
+  alignas(kCacheLine) std::atomic<uint64_t> writeIndex;
+  alignas(kCacheLine) std::atomic<uint32_t> futexWord;
+  std::atomic<uint32_t> waiters; // Readers blocked in wait()
+  std::atomic<uint32_t> closed; // Set when the writer closes the segment
+};
+
+struct alignas(kCacheLine) SharedMemoryRing::Reader {
+  std::atomic<uint32_t> active;
+  std::atomic<int32_t> pid; // Process that added the reader
+  std::atomic<uint64_t> cursor;
+  std::atomic<uint64_t> overruns;
+};
+
+struct alignas(kCacheLine) SharedMemoryRing::Slot {
+  std::atomic<uint32_t> sequence; // Odd while the writer is copying
+  std::atomic<uint32_t> size;
+  std::atomic<uint64_t> frame;
+
+  char *data() { return reinterpret_cast<char *>(this) + sizeof(Slot); }
+};
+
+SharedMemoryRing::~SharedMemoryRing() {
+  close();
+}
+
+bool SharedMemoryRing::create(std::string name, size_t slotSize,
+                              unsigned int numSlots, unsigned int maxReaders) {
+#ifdef AL_WINDOWS
+  (void) name; (void) slotSize; (void) numSlots; (void) maxReaders;
+  std::cerr << "ERROR: SharedMemoryRing not supported on Windows" << std::endl;
+  return false;
+#else
+  close();
+  if (name.size() == 0 || slotSize == 0 || numSlots == 0 || maxReaders == 0) {
+    return false;
+  }
+  if (name[0] != '/') {
+    name = "/" + name;
+  }
+
+  size_t readersOffset = roundUp(sizeof(Header), kCacheLine);
+  size_t slotsOffset = roundUp(readersOffset + sizeof(Reader) * maxReaders, kCacheLine);
+  size_t slotStride = roundUp(sizeof(Slot) + slotSize, kCacheLine);
+  size_t totalSize = slotsOffset + slotStride * numSlots;
+
+  shm_unlink(name.c_str()); // Remove stale segment from previous run
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+  if (fd < 0) {
+    std::cerr << "ERROR: SharedMemoryRing could not create " << name << std::endl;
+    return false;
+  }
+  struct stat info;
+  if (ftruncate(fd, totalSize) != 0 || fstat(fd, &info) != 0) {
+    ::close(fd);
+    shm_unlink(name.c_str());
+    std::cerr << "ERROR: SharedMemoryRing could not size " << name << std::endl;
+    return false;
+  }
+  void *mem = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mem == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    std::cerr << "ERROR: SharedMemoryRing could not map " << name << std::endl;
+    return false;
+  }
+
+  char *base = static_cast<char *>(mem);
+  Header *header = new (base) Header;
+  header->slotSize = slotSize;
+  header->slotStride = slotStride;
+  header->numSlots = numSlots;
+  header->maxReaders = maxReaders;
+  header->readersOffset = readersOffset;
+  header->slotsOffset = slotsOffset;
+  header->totalSize = totalSize;
+  header->writeIndex.store(0);
+  header->futexWord.store(0);
+  header->waiters.store(0);
+  header->closed.store(0);
+  for (unsigned int i = 0; i < maxReaders; i++) {
+    Reader *r = new (base + readersOffset + i * sizeof(Reader)) Reader;
+    r->active.store(0);
+    r->pid.store(0);
+    r->cursor.store(0);
+    r->overruns.store(0);
+  }
+  for (unsigned int i = 0; i < numSlots; i++) {
+    Slot *s = new (base + slotsOffset + i * slotStride) Slot;
+    s->sequence.store(0);
+    s->size.store(0);
+    s->frame.store(UINT64_MAX);
+  }
+  header->version = kRingVersion;
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = kRingMagic;
+
+  mName = name;
+  mHeader = header;
+  mMappedSize = totalSize;
+  mOwner = true;
+  mDevice = info.st_dev;
+  mInode = info.st_ino;
+  return true;
+#endif
+}
+
+bool SharedMemoryRing::open(std::string name) {
+#ifdef AL_WINDOWS
+  (void) name;
+  return false;
+#else
+  close();
+  if (name.size() == 0) {
+    return false;
+  }
+  if (name[0] != '/') {
+    name = "/" + name;
+  }
+  int fd = shm_open(name.c_str(), O_RDWR, 0666);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(Header)) {
+    ::close(fd);
+    return false;
+  }
+  void *mem = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mem == MAP_FAILED) {
+    return false;
+  }
+  Header *header = static_cast<Header *>(mem);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (header->magic != kRingMagic || header->version != kRingVersion
+      || header->totalSize != (uint64_t) info.st_size) {
+    munmap(mem, info.st_size);
+    return false;
+  }
+  mName = name;
+  mHeader = header;
+  mMappedSize = info.st_size;
+  mOwner = false;
+  mDevice = info.st_dev;
+  mInode = info.st_ino;
+  return true;
+#endif
+}
+
+void SharedMemoryRing::close() {
+#ifndef AL_WINDOWS
+  if (mHeader) {
+    for (int index : mReaders) {
+      reader(index)->pid.store(0);
+      reader(index)->active.store(0);
+    }
+    if (mOwner) {
+      mHeader->closed.store(1);
+    }
+    munmap(mHeader, mMappedSize);
+    if (mOwner) {
+      shm_unlink(mName.c_str());
+    }
+  }
+#endif
+  mReaders.clear();
+  mHeader = nullptr;
+  mMappedSize = 0;
+  mOwner = false;
+}
+
+bool SharedMemoryRing::replaced() const {
+#ifdef AL_WINDOWS
+  return false;
+#else
+  if (!mHeader || mOwner) {
+    return false;
+  }
+  if (mHeader->closed.load(std::memory_order_acquire)) {
+    return true;
+  }
+  // The writer may have exited without closing and created a new segment
+  // with the same name. The old mapping stays valid but is never written.
+  int fd = shm_open(mName.c_str(), O_RDONLY, 0666);
+  if (fd < 0) {
+    return true;
+  }
+  struct stat info;
+  bool same = fstat(fd, &info) == 0 && info.st_dev == mDevice && info.st_ino == mInode;
+  ::close(fd);
+  return !same;
+#endif
+}
+
+size_t SharedMemoryRing::slotSize() const {
+  return mHeader ? mHeader->slotSize : 0;
+}
+
+unsigned int SharedMemoryRing::numSlots() const {
+  return mHeader ? mHeader->numSlots : 0;
+}
+
+unsigned int SharedMemoryRing::maxReaders() const {
+  return mHeader ? mHeader->maxReaders : 0;
+}
+
+bool SharedMemoryRing::publish(const void *data, size_t size) {
+  if (!mHeader || size > mHeader->slotSize) {
+    return false;
+  }
+  uint64_t frame = mHeader->writeIndex.load(std::memory_order_relaxed);
+  Slot *s = slot(frame);
+  uint32_t seq = s->sequence.load(std::memory_order_relaxed);
+  s->sequence.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(s->data(), data, size);
+  s->size.store((uint32_t) size, std::memory_order_relaxed);
+  s->frame.store(frame, std::memory_order_relaxed);
+  s->sequence.store(seq + 2, std::memory_order_release);
+  mHeader->writeIndex.store(frame + 1, std::memory_order_release);
+  // Sequentially consistent with the waiter count update in wait(), so
+  // either a waiter is seen here or the waiter sees the new frame
+  mHeader->futexWord.fetch_add(1);
+  if (mHeader->waiters.load() > 0) {
+    futexWakeAll(&mHeader->futexWord);
+  }
+  return true;
+}
+
+uint64_t SharedMemoryRing::framesPublished() const {
+  return mHeader ? mHeader->writeIndex.load(std::memory_order_acquire) : 0;
+}
+
+int SharedMemoryRing::addReader() {
+  if (!mHeader) {
+    return -1;
+  }
+#ifdef AL_WINDOWS
+  int32_t pid = 0;
+#else
+  int32_t pid = (int32_t) getpid();
+#endif
+  int index = -1;
+  for (unsigned int i = 0; i < mHeader->maxReaders && index < 0; i++) {
+    uint32_t expected = 0;
+    if (reader(i)->active.compare_exchange_strong(expected, 1)) {
+      index = (int) i;
+    }
+  }
+#ifndef AL_WINDOWS
+  // All slots taken. Reclaim one left by a process that exited without
+  // removing its reader.
+  for (unsigned int i = 0; i < mHeader->maxReaders && index < 0; i++) {
+    int32_t owner = reader(i)->pid.load();
+    if (processIsGone(owner) && reader(i)->pid.compare_exchange_strong(owner, pid)) {
+      index = (int) i;
+    }
+  }
+#endif
+  if (index < 0) {
+    return -1;
+  }
+  Reader *r = reader(index);
+  r->pid.store(pid);
+  r->cursor.store(mHeader->writeIndex.load(std::memory_order_acquire));
+  r->overruns.store(0);
+  mReaders.push_back(index);
+  return index;
+}
+
+void SharedMemoryRing::removeReader(int index) {
+  if (mHeader && index >= 0 && index < (int) mHeader->maxReaders) {
+    auto it = std::find(mReaders.begin(), mReaders.end(), index);
+    if (it != mReaders.end()) {
+      mReaders.erase(it);
+    }
+    reader(index)->pid.store(0);
+    reader(index)->active.store(0);
+  }
+}
+
+bool SharedMemoryRing::consume(int index, void *dest, size_t maxSize, size_t *size) {
+  if (!mHeader || index < 0 || index >= (int) mHeader->maxReaders) {
+    return false;
+  }
+  Reader *r = reader(index);
+  uint64_t cursor = r->cursor.load(std::memory_order_relaxed);
+  while (true) {
+    uint64_t written = mHeader->writeIndex.load(std::memory_order_acquire);
+    if (cursor >= written) {
+      return false;
+    }
+    if (written - cursor > mHeader->numSlots) {
+      // Writer has lapped this reader. Skip to the oldest frame still held.
+      r->overruns.fetch_add(written - mHeader->numSlots - cursor, std::memory_order_relaxed);
+      cursor = written - mHeader->numSlots;
+    }
+    if (readFrame(cursor, dest, maxSize, size)) {
+      r->cursor.store(cursor + 1, std::memory_order_release);
+      return true;
+    }
+    // Frame was overwritten while copying. Loop and re-evaluate position.
+  }
+}
+
+int SharedMemoryRing::consumeLatest(int index, void *dest, size_t maxSize, size_t *size) {
+  if (!mHeader || index < 0 || index >= (int) mHeader->maxReaders) {
+    return 0;
+  }
+  Reader *r = reader(index);
+  uint64_t cursor = r->cursor.load(std::memory_order_relaxed);
+  while (true) {
+    uint64_t written = mHeader->writeIndex.load(std::memory_order_acquire);
+    if (cursor >= written) {
+      return 0;
+    }
+    if (readFrame(written - 1, dest, maxSize, size)) {
+      r->cursor.store(written, std::memory_order_release);
+      return (int) std::min<uint64_t>(written - cursor, INT_MAX);
+    }
+  }
+}
+
+uint64_t SharedMemoryRing::pending(int index) const {
+  if (!mHeader || index < 0 || index >= (int) mHeader->maxReaders) {
+    return 0;
+  }
+  uint64_t written = mHeader->writeIndex.load(std::memory_order_acquire);
+  uint64_t cursor = reader(index)->cursor.load(std::memory_order_relaxed);
+  return written > cursor ? written - cursor : 0;
+}
+
+uint64_t SharedMemoryRing::overruns(int index) const {
+  if (!mHeader || index < 0 || index >= (int) mHeader->maxReaders) {
+    return 0;
+  }
+  return reader(index)->overruns.load(std::memory_order_relaxed);
+}
+
+bool SharedMemoryRing::wait(int index, double timeoutSec) {
+  if (!mHeader) {
+    return false;
+  }
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeoutSec);
+  mHeader->waiters.fetch_add(1);
+  bool available = false;
+  while (true) {
+    uint32_t word = mHeader->futexWord.load();
+    if (pending(index) > 0) {
+      available = true;
+      break;
+    }
+    double remaining = std::chrono::duration<double>(deadline - std::chrono::steady_clock::now()).count();
+    if (remaining <= 0.0) {
+      break;
+    }
+    futexWait(&mHeader->futexWord, word, remaining);
+  }
+  mHeader->waiters.fetch_sub(1);
+  return available;
+}
+
+SharedMemoryRing::Reader *SharedMemoryRing::reader(int index) const {
+  char *base = reinterpret_cast<char *>(mHeader);
+  return reinterpret_cast<Reader *>(base + mHeader->readersOffset + index * sizeof(Reader));
+}
+
+SharedMemoryRing::Slot *SharedMemoryRing::slot(uint64_t frame) const {
+  char *base = reinterpret_cast<char *>(mHeader);
+  size_t index = frame % mHeader->numSlots;
+  return reinterpret_cast<Slot *>(base + mHeader->slotsOffset + index * mHeader->slotStride);
+}
+
+bool SharedMemoryRing::readFrame(uint64_t frame, void *dest, size_t maxSize, size_t *size) {
+  Slot *s = slot(frame);
+  uint32_t seq = s->sequence.load(std::memory_order_acquire);
+  if (seq & 1) {
+    return false;
+  }
+  if (s->frame.load(std::memory_order_relaxed) != frame) {
+    return false;
+  }
+  size_t frameSize = s->size.load(std::memory_order_relaxed);
+  std::memcpy(dest, s->data(), std::min(frameSize, maxSize));
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (s->sequence.load(std::memory_order_relaxed) != seq) {
+    return false;
+  }
+  if (size) {
+    *size = frameSize;
+  }
+  return true;
+}
@@ -1,42 +1,16 @@
 #include "al/glv/al_GLV.hpp"
 
 #include "al/core/graphics/al_Mesh.hpp" // GraphicsData
-#include "al/core/graphics/al_Shapes.hpp"
-#include "al/core/graphics/al_DefaultShaders.hpp"
+#include "al/core/graphics/al_VAOMesh.hpp"
 
 
 #include <cmath>
 #include <iostream>
-#include <memory>
-#include <iostream>
 
 using namespace al;
 
 namespace glv {
 
-struct GraphicsHolder {
-    Graphics* mGraphics;
-    std::unique_ptr<ShaderProgram> mShaderPtr;
-    void set(Graphics& g) {
-        mGraphics = &g;
-    }
-    Graphics& get() {
-        return *mGraphics;
-    }
-    ShaderProgram& shader() {
-        if (!mShaderPtr) {
-            mShaderPtr = std::make_unique<ShaderProgram>();
-            mShaderPtr->compile(al_color_vert_shader(), al_color_frag_shader());
-        }
-        return *mShaderPtr;
-    }
-};
-
-GraphicsHolder& graphicsHolder() {
-    static GraphicsHolder graphicsHolder;
-    return graphicsHolder;
-}
-
 /// Returns closest pixel coordinate
 int pix(float v) {
     return v >= 0 ? (int)(v+0.5f) : (int)(v-0.5f);
@@ -46,84 +20,28 @@ float pixc(float v) {
     return pix(v) + 0.5f;
 }
 
-void rectangle(float l, float t, float r, float b) {
-    static VAOMesh mesh = [&](){
-        VAOMesh mesh {Mesh::TRIANGLES};
-        // reserve 6 vertices
-        mesh.vertices().reserve(6);
-        for (int i = 0; i < 6; i += 1) {
-            mesh.vertices().emplace_back();
-        }
-        return mesh;
-    }();
-
-    float x = l;
-    float y = t;
-    float w = r - l;
-    float h = b - t;
-
-    mesh.vertices()[0].set(x, y, 0);
-    mesh.vertices()[1].set(x + w, y, 0);
-    mesh.vertices()[2].set(x, y + h, 0);
-    mesh.vertices()[3].set(x, y + h, 0);
-    mesh.vertices()[4].set(x + w, y, 0);
-    mesh.vertices()[5].set(x + w, y + h, 0);
-    mesh.update();
+// Batch receiving the primitives of the GLV currently being drawn
+static DrawBatch * currentBatch = nullptr;
 
-    graphicsHolder().get().draw(mesh);
+DrawBatch& batch() {
+    static DrawBatch fallback; // used when drawing outside of drawWidgets
+    return currentBatch ? *currentBatch : fallback;
 }
 
-void frame(float l, float t, float r, float b) {
-    static VAOMesh mesh = [&](){
-        VAOMesh mesh {Mesh::LINE_STRIP};
-        // reserve 5 vertices
-        mesh.vertices().reserve(5);
-        for (int i = 0; i < 5; i += 1) {
-            mesh.vertices().emplace_back();
-        }
-        return mesh;
-    }();
-
-    float x = l;
-    float y = t;
-    float w = r - l;
-    float h = b - t;
-    // mesh.reset();
-    // mesh.primitive(LINE_STRIP);
-    mesh.vertices()[0].set(x, y, 0);
-    mesh.vertices()[1].set(x + w, y, 0);
-    mesh.vertices()[2].set(x + w, y + h, 0);
-    mesh.vertices()[3].set(x, y + h, 0);
-    mesh.vertices()[4].set(x, y, 0);
-    mesh.update();
+void rectangle(float l, float t, float r, float b) {
+    batch().rectangle(l, t, r, b);
+}
 
-    graphicsHolder().get().draw(mesh);
+void frame(float l, float t, float r, float b) {
+    batch().frame(l, t, r, b);
 }
 
 void line(float x0, float y0, float x1, float y1) {
-    static VAOMesh mesh = [&](){
-        VAOMesh mesh {Mesh::LINES};
-        // reserve 5 vertices
-        mesh.vertices().reserve(2);
-        for (int i = 0; i < 2; i += 1) {
-            mesh.vertices().emplace_back();
-        }
-        return mesh;
-    }();
-
-    mesh.vertices()[0].set(x0, y0, 0);
-    mesh.vertices()[1].set(x1, y1, 0);
-    mesh.update();
-
-    graphicsHolder().get().draw(mesh);
+    batch().line(x0, y0, x1, y1);
 }
 
 void lines(Mesh& gd) {
-    static EasyVAO vao;
-    // vao.primitive(GL_LINES);
-    vao.primitive(Mesh::LINES);
-    vao.updatePosition(gd.vertices().data(), gd.vertices().size());
-    graphicsHolder().get().draw(vao);
+    batch().lines(gd.vertices().data(), int(gd.vertices().size()));
 }
 
 void grid (
@@ -131,75 +49,35 @@ void grid (
     float divx, float divy,
     bool incEnds=true
 ) {
-    static VAOMesh mesh {Mesh::LINES};
-
-    mesh.reset();
-    float inc, r=l+w, b=t+h;
-
-    if(divy > 0 && h>0){
-        inc = (float)h/(float)divy;
-        float i = incEnds ? t-0.0001f : t-0.0001f+inc;
-        float e = incEnds ? b : b-inc;
-        for(; i<e; i+=inc) {
-            mesh.vertex(l, i);
-            mesh.vertex(r, i);
-        }
-    }
-
-    if(divx > 0 && w>0){
-        inc = (float)w/(float)divx;
-        float i = incEnds ? l-0.0001f : l-0.0001f+inc;
-        float e = incEnds ? r : r-inc;
-        for(; i<e; i+=inc) {
-            mesh.vertex(i, t);
-            mesh.vertex(i, b);
-        }
-    }
-    mesh.update();
-    graphicsHolder().get().draw(mesh);
-}
-
-decltype(auto) currentMatrix() {
-    return graphicsHolder().get().modelMatrix();
+    batch().grid(l, t, w, h, divx, divy, incEnds);
 }
 
 void pushMatrix() {
-    graphicsHolder().get().pushMatrix();
+    batch().pushMatrix();
 }
 void popMatrix() {
-    graphicsHolder().get().popMatrix();
+    batch().popMatrix();
 }
 
 void loadIdentity() {
-    graphicsHolder().get().loadIdentity();
+    batch().loadIdentity();
 }
 
 void translate(float x, float y) {
-    graphicsHolder().get().translate(x, y);
+    batch().translate(x, y);
 }
 
 void rotate(float angleX, float angleY, float angleZ) {
-    graphicsHolder().get().rotate(angleX, angleY, angleZ);
-}
-
-void scale(float scaleX, float scaleY) {
-    graphicsHolder().get().scale(scaleX, scaleY);
-}
-
-void scissorTest(bool doScissor) {
-    graphicsHolder().get().scissorTest(doScissor);
-}
-
-void scissor(int x, int y, int w, int h) {
-    graphicsHolder().get().scissor(x, y, w, h);
+    // GUI geometry is planar, so only rotation about z applies
+    batch().rotate(angleZ);
 }
 
 void color(float r, float g, float b, float a) {
-    graphicsHolder().get().shader().uniform("col0", Color(r, g, b, a));
+    batch().color(Color(r, g, b, a));
 }
 
 void color(Color const& c) {
-    color(c.r, c.g, c.b, c.a);
+    batch().color(c);
 }
 
 void text(
@@ -216,15 +94,6 @@ void text(
 
 void drawContext (float tx, float ty, View * v, float& cx, float& cy, View *& c) {
     cx += tx; cy += ty; // update absolute coordinates of drawing context
-
-    // clear model matrix (assumed set already)
-    // it was loadIdentity() before but
-    // pop then push preserves previous matrix (the one before pushing)
-    popMatrix();
-    pushMatrix();
-
-    // pix: round position to nearest pixel coordinates
-    translate(float(pix(cx)), float(pix(cy)));
     c = v;
 }
 
@@ -278,16 +147,34 @@ void GLV::drawWidgets(unsigned int ww, unsigned int wh, double dsec) {
     // } animateViews(dsec);
     // traverseDepth(animateViews);
 
-    graphicsData().reset();
-    doDraw(*this);
+    mDrawBatch.reset();
+    currentBatch = &mDrawBatch;
+
+    // Geometry is built in view coordinates and cached by views whose drawing
+    // has not changed, then offset to the view's pixel position in the frame
+    auto drawView = [this](View * v, float x, float y){
+        DrawCache& cache = v->mDrawCache;
+        if(v->drawingChanged()){
+            cache.vertices.clear();
+            mDrawBatch.target(&cache.vertices);
+            mDrawBatch.loadIdentity();
+            mDrawBatch.color(Color(1.f));
+            mDrawBatch.lineWidth(1.f);
+            graphicsData().reset();
+            v->doDraw(*this);
+            mDrawBatch.target(nullptr);
+            mDrawBatch.countRebuilt();
+        }
+        mDrawBatch.append(cache.vertices, float(pix(x)), float(pix(y)));
+    };
+
+    drawView(root, cx, cy);
 
-    //scissorTest(true);
     while(true){
 
         cv->onDataModelSync(); // update state based on attached model variables
         cv->rectifyGeometry();
 
-        pushMatrix();
         // find the next view to draw
 
         // go to child node if exists and I'm drawable
@@ -310,7 +197,6 @@ void GLV::drawWidgets(unsigned int ww, unsigned int wh, double dsec) {
                 computeCrop(cropRects, lvl, cx, cy, cv);
             }
             else {
-                popMatrix();
                 break; // break the loop when the traversal returns to the root
             }
         }
@@ -319,39 +205,42 @@ void GLV::drawWidgets(unsigned int ww, unsigned int wh, double dsec) {
         if(cv->visible()){
             Rect r = cropRects[lvl-1]; // cropping region comes from parent context
 
-            
-            
             // if(cv->enabled(CropSelf)) { // crop my own draw?
             //     r.intersection(Rect(cx, cy, cv->w, cv->h), r);
             // }
-            
 
             if(r.h<=0.f || r.w <= 0.f) { // bypass if drawing area outside of crop region
-                // std::cout << "bypassing" << std::endl;
-                popMatrix();
                 continue;
             }
 
-            // int sx = pix(r.l);
-            // int sy = wh - (pix(r.t) + pix(r.h)) + 0.99; // scissor coord has origin at bottom left
-            // int sw = pix(r.w);
-            // int sh = r.h + 0.5;
-            // if(sy < 0) sy=0;
+            drawView(cv, cx, cy);
+        }
+    }
 
-            // glScissor takes size in framebuffer dimension
-            //scissor(
-            //  sx * windowHighresFactorX(),
-            //  sy * windowHighresFactorY(),
-            //  sw * windowHighresFactorX(),
-            //  sh * windowHighresFactorY()
-            //);
+    currentBatch = nullptr;
+}
 
-            graphicsData().reset();
-            cv->doDraw(*this);
+bool View::drawingChanged(){
+    DrawCache& c = mDrawCache;
+    const StyleColor& sc = colors();
+    const Color * cols[5] = { &sc.back, &sc.border, &sc.fore, &sc.selection, &sc.text };
+
+    bool changed = !mCacheDrawing || c.dirty
+        || c.flags != unsigned(mFlags) || c.w != w || c.h != h;
+    for(int i=0; i<5; ++i){
+        const Color& a = *cols[i];
+        const Color& b = c.colors[i];
+        if(a.r != b.r || a.g != b.g || a.b != b.b || a.a != b.a){
+            c.colors[i] = a;
+            changed = true;
         }
-        popMatrix();
     }
-    //scissorTest(false);
+
+    c.dirty = false;
+    c.flags = unsigned(mFlags);
+    c.w = w;
+    c.h = h;
+    return changed;
 }
 
 void View::doDraw(GLV& glv){
@@ -728,24 +617,32 @@ void al::al_draw_glv(
     g.polygonMode(Graphics::FILL);
     g.cullFace(false);
 
-    g.shader(glv::graphicsHolder().shader());
+    // Build geometry of the whole GUI, then stream it into one vertex buffer
+    glv.drawWidgets(w, h, 0); // 0 for dsec: animation disabled...
+
+    static VAOMesh mesh {Mesh::TRIANGLES};
+    const glv::BatchVertices& v = glv.drawBatch().vertices();
+    mesh.vertices() = v.positions;
+    mesh.colors() = v.colors;
+    mesh.update();
+
+    g.meshColor();
 
     g.pushViewport(x, y, w, h);
     g.pushCamera(Viewpoint::ORTHO_FOR_2D);
 
-    glv::graphicsHolder().set(g);
-
     g.pushMatrix();
     g.loadIdentity();
     g.translate(0.0f, float(h)); // move to top-left
     g.scale(1, -1); // flip y
-    glv.drawWidgets(w, h, 0); // 0 for dsec: animation disabled...
+    g.draw(mesh); // single draw call for all views
 
     g.popMatrix();
     g.popCamera();
+    g.popViewport();
 }
 
-void al_draw_glv(glv::GLV& glv, Graphics& g, Window* w) {
+void al::al_draw_glv(glv::GLV& glv, Graphics& g, Window* w) {
     // animation is disabled...
     al_draw_glv(glv, g, 0, 0, w->fbWidth(), w->fbHeight());
 }
\ No newline at end of file
@@ -0,0 +1,133 @@
+/*	Graphics Library of Views (GLV) - GUI Building Toolkit
+	See COPYRIGHT file for authors and license information */
+
+#include <cmath>
+#include "al/glv/glv_batch.h"
+
+namespace glv{
+
+DrawBatch::DrawBatch()
+:	mTarget(&mFrame), mColor(1.f), mLineWidth(1.f), mRebuilt(0)
+{
+	reset();
+}
+
+void DrawBatch::reset(){
+	mFrame.clear();
+	mTarget = &mFrame;
+	mStack.clear();
+	mStack.push_back(Transform{{1,0,0, 0,1,0}});
+	mColor = al::Color(1.f);
+	mLineWidth = 1.f;
+	mRebuilt = 0;
+}
+
+void DrawBatch::pushMatrix(){ mStack.push_back(mStack.back()); }
+
+void DrawBatch::popMatrix(){
+	if(mStack.size() > 1) mStack.pop_back();
+}
+
+void DrawBatch::loadIdentity(){ mStack.back() = Transform{{1,0,0, 0,1,0}}; }
+
+void DrawBatch::translate(float x, float y){
+	float * m = mStack.back().m;
+	m[2] += m[0]*x + m[1]*y;
+	m[5] += m[3]*x + m[4]*y;
+}
+
+void DrawBatch::rotate(float degrees){
+	float a = degrees * float(M_PI / 180.);
+	float c = std::cos(a), s = std::sin(a);
+	float * m = mStack.back().m;
+	float m0 = m[0], m1 = m[1], m3 = m[3], m4 = m[4];
+	m[0] = m0*c + m1*s;	m[1] = m1*c - m0*s;
+	m[3] = m3*c + m4*s;	m[4] = m4*c - m3*s;
+}
+
+void DrawBatch::quad(
+	float x0, float y0, float x1, float y1,
+	float x2, float y2, float x3, float y3
+){
+	const Transform& t = mStack.back();
+	t.apply(x0,y0); t.apply(x1,y1); t.apply(x2,y2); t.apply(x3,y3);
+	std::vector<al::Vec3f>& p = mTarget->positions;
+	p.emplace_back(x0,y0,0.f);
+	p.emplace_back(x1,y1,0.f);
+	p.emplace_back(x2,y2,0.f);
+	p.emplace_back(x2,y2,0.f);
+	p.emplace_back(x1,y1,0.f);
+	p.emplace_back(x3,y3,0.f);
+	mTarget->colors.insert(mTarget->colors.end(), 6, mColor);
+}
+
+void DrawBatch::rectangle(float l, float t, float r, float b){
+	quad(l,t, r,t, l,b, r,b);
+}
+
+void DrawBatch::frame(float l, float t, float r, float b){
+	// Four non-overlapping edges, so translucent borders blend evenly
+	float d = mLineWidth * 0.5f;
+	rectangle(l-d, t-d, r+d, t+d);
+	rectangle(l-d, b-d, r+d, b+d);
+	rectangle(l-d, t+d, l+d, b-d);
+	rectangle(r-d, t+d, r+d, b-d);
+}
+
+void DrawBatch::line(float x0, float y0, float x1, float y1){
+	// Quad around the segment, extended by half the width at both ends
+	float dx = x1-x0, dy = y1-y0;
+	float len = std::sqrt(dx*dx + dy*dy);
+	float d = mLineWidth * 0.5f;
+	if(len > 0.f){
+		dx *= d/len; dy *= d/len;
+	}
+	else{
+		dx = d; dy = 0.f;
+	}
+	x0 -= dx; y0 -= dy;
+	x1 += dx; y1 += dy;
+	// (nx, ny) = (-dy, dx) is the normal scaled to half the width
+	quad(x0+dy, y0-dx, x1+dy, y1-dx, x0-dy, y0+dx, x1-dy, y1+dx);
+}
+
+void DrawBatch::lines(const al::Vec3f * v, int count){
+	for(int i=0; i+1<count; i+=2){
+		line(v[i].x, v[i].y, v[i+1].x, v[i+1].y);
+	}
+}
+
+void DrawBatch::grid(
+	float l, float t, float w, float h,
+	float divx, float divy, bool incEnds
+){
+	float inc, r=l+w, b=t+h;
+
+	if(divy > 0 && h>0){
+		inc = h/divy;
+		float i = incEnds ? t-0.0001f : t-0.0001f+inc;
+		float e = incEnds ? b : b-inc;
+		for(; i<e; i+=inc) line(l, i, r, i);
+	}
+
+	if(divx > 0 && w>0){
+		inc = w/divx;
+		float i = incEnds ? l-0.0001f : l-0.0001f+inc;
+		float e = incEnds ? r : r-inc;
+		for(; i<e; i+=inc) line(i, t, i, b);
+	}
+}
+
+void DrawBatch::append(const BatchVertices& v, float dx, float dy){
+	size_t n = v.positions.size();
+	size_t start = mFrame.positions.size();
+	mFrame.positions.resize(start + n);
+	al::Vec3f * dst = &mFrame.positions[start];
+	const al::Vec3f * src = v.positions.data();
+	for(size_t i=0; i<n; ++i){
+		dst[i].set(src[i].x + dx, src[i].y + dy, 0.f);
+	}
+	mFrame.colors.insert(mFrame.colors.end(), v.colors.begin(), v.colors.end());
+}
+
+} // glv::
@@ -51,6 +51,8 @@ bool GLV::doEventCallbacks(View& v, Event::t e){
 //	if(!v.enabled(Controllable)) return false;	// cancels all events w/o handling
 	if(!v.enabled(Controllable)) return true;	// bubbles all events w/o handling
 
+	v.dirty(); // events may change any state used for drawing
+
 //	bool bubble = v.onEvent(e, *this);					// Execute virtual callback
 //	
 //	if(bubble){
@@ -49,16 +49,18 @@ Label::Label(const std::string& str, Place::t p, space_t px, space_t py, bool ve
 #undef CTOR_LIST
 #undef CTOR_BODY
 
-Label& Label::align(float vx, float vy){ mAlignX=vx; mAlignY=vy; return *this; }
+Label& Label::align(float vx, float vy){ mAlignX=vx; mAlignY=vy; dirty(); return *this; }
 
 Label& Label::size(float pixels){
 	font().size(pixels);
 	fitExtent();
+	dirty();
 	return *this;
 }
 
 Label& Label::stroke(float pixels){
 	mStroke = pixels*256.f;
+	dirty();
 	return *this;
 }
 
@@ -75,6 +77,7 @@ Label& Label::vertical(bool v){
 	if(v != mVertical){
 		rotateRect();
 		mVertical = v;
+		dirty();
 	}
 	return *this;
 }
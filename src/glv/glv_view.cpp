@@ -317,6 +317,8 @@ View& View::anchor(Place::t p){
 
 View& View::bringToFront(){ makeLastSibling(); return *this; }
 
+View& View::cacheDrawing(bool v){ mCacheDrawing = v; return dirty(); }
+
 
 View& View::cloneStyle(){
 	if(mStyle){		
@@ -527,6 +529,7 @@ View& View::name(const std::string& v){
 
 
 void View::onResizeRect(space_t dx, space_t dy){
+	dirty();
 	onResize(dx,dy);
 	// Move/resize anchored children
 	// This will recursively call onResize's through the entire descendency tree
@@ -23,6 +23,7 @@ Widget::Widget(
 :	View(r), sx(0), sy(0), mInterval(0,1), mPrevVal(0), mUseInterval(true)
 {
 	padding(pad);
+	cacheDrawing(true);
 	property(DrawGrid, drawGrid);
 	property(MutualExc, mutExc);
 	property(Momentary, moment);
@@ -123,6 +124,7 @@ bool Widget::onAssignData(Data& d, int ind1, int ind2){
 
 	if(d != modelOffset){
 		data().assign(d, ind1, ind2);
+		dirty();
 		ModelChange modelChange(data(), idx);
 		notify(this, Update::Value, &modelChange);
 	}
@@ -149,6 +151,7 @@ Widget& Widget::select(int ix, int iy){
 		notify(this, Update::Selection, &csel);
 		sx=ix; sy=iy;
 		mPrevVal = data().at<double>(selected());
+		dirty();
 	}
 	return *this;
 }
@@ -0,0 +1,264 @@
+#include <algorithm>
+
+#include "al/util/al_BVH.hpp"
+
+using namespace al;
+
+const int BVH::maxLeafItems;
+
+namespace {
+
+const int numBins = 16;
+const int maxDepth = 48; // Leaves the traversal stack in intersect() some headroom
+
+float sahCost(const std::vector<BVH::Node> &nodes) {
+  if (nodes.size() == 0) return 0.0f;
+  float rootArea = nodes[0].bounds.area();
+  if (rootArea <= 0.0f) return float(nodes[0].count);
+  float cost = 0.0f;
+  for (auto &node : nodes) {
+    cost += node.bounds.area() * (node.leaf() ? node.count : 1);
+  }
+  return cost / rootArea;
+}
+
+} // namespace
+
+BVH::~BVH() {
+  if (mRebuildThread.joinable()) {
+    mRebuildThread.join();
+  }
+}
+
+void BVH::build(const std::vector<Bounds> &bounds) {
+  if (mRebuildThread.joinable()) {
+    mRebuildThread.join(); // Result is discarded, it was built from old boxes
+    mRebuildDone = false;
+  }
+  mItemBounds = bounds;
+  buildNodes(mItemBounds, mNodes, mItems);
+  indexLeaves();
+  mBuildCost = cost();
+}
+
+void BVH::buildNodes(const std::vector<Bounds> &bounds,
+                     std::vector<Node> &nodes, std::vector<int> &items) {
+  int numItems = (int) bounds.size();
+  nodes.clear();
+  items.resize(numItems);
+  if (numItems == 0) return;
+  nodes.reserve(2 * numItems);
+
+  std::vector<Vec3f> centers(numItems);
+  for (int i = 0; i < numItems; i++) {
+    items[i] = i;
+    centers[i] = bounds[i].center();
+  }
+
+  struct Task { int node, begin, end, depth; };
+  std::vector<Task> tasks;
+  nodes.push_back(Node());
+  tasks.push_back({0, 0, numItems, 0});
+
+  while (tasks.size() > 0) {
+    Task task = tasks.back();
+    tasks.pop_back();
+    int count = task.end - task.begin;
+
+    Bounds nodeBounds, centerBounds;
+    for (int i = task.begin; i < task.end; i++) {
+      nodeBounds.extend(bounds[items[i]]);
+      centerBounds.extend(centers[items[i]]);
+    }
+    nodes[task.node].bounds = nodeBounds;
+    nodes[task.node].first = task.begin;
+    nodes[task.node].count = count;
+
+    if (count <= 1 || task.depth >= maxDepth) continue;
+
+    // Binned SAH: find the axis and bin boundary with the lowest cost
+    int bestAxis = -1, bestSplit = 0;
+    float bestCost = FLT_MAX;
+    for (int axis = 0; axis < 3; axis++) {
+      float extent = centerBounds.max[axis] - centerBounds.min[axis];
+      if (extent <= 0.0f) continue;
+      float scale = numBins / extent;
+      int binCount[numBins] = {0};
+      Bounds binBounds[numBins];
+      for (int i = task.begin; i < task.end; i++) {
+        int bin = std::min(numBins - 1, int((centers[items[i]][axis] - centerBounds.min[axis]) * scale));
+        binCount[bin]++;
+        binBounds[bin].extend(bounds[items[i]]);
+      }
+      // Sweep from the right to get the area and count right of each split
+      float rightArea[numBins];
+      int rightCount[numBins];
+      Bounds accum;
+      int accumCount = 0;
+      for (int b = numBins - 1; b > 0; b--) {
+        accum.extend(binBounds[b]);
+        accumCount += binCount[b];
+        rightArea[b] = accum.area();
+        rightCount[b] = accumCount;
+      }
+      accum = Bounds();
+      accumCount = 0;
+      for (int b = 0; b < numBins - 1; b++) {
+        accum.extend(binBounds[b]);
+        accumCount += binCount[b];
+        if (accumCount == 0 || rightCount[b + 1] == 0) continue;
+        float cost = accum.area() * accumCount + rightArea[b + 1] * rightCount[b + 1];
+        if (cost < bestCost) {
+          bestCost = cost;
+          bestAxis = axis;
+          bestSplit = b + 1;
+        }
+      }
+    }
+
+    int mid;
+    if (bestAxis < 0) {
+      // All centers are in the same place, split in the middle of the list
+      if (count <= maxLeafItems) continue;
+      mid = task.begin + count / 2;
+    } else {
+      // Cost of traversing the node relative to testing an item is 1
+      float area = nodeBounds.area();
+      float splitCost = area > 0.0f ? 1.0f + bestCost / area : FLT_MAX;
+      if (count <= maxLeafItems && splitCost >= count) continue;
+      float scale = numBins / (centerBounds.max[bestAxis] - centerBounds.min[bestAxis]);
+      float minCenter = centerBounds.min[bestAxis];
+      int *split = std::partition(items.data() + task.begin, items.data() + task.end,
+                                  [&](int item) {
+        int bin = std::min(numBins - 1, int((centers[item][bestAxis] - minCenter) * scale));
+        return bin < bestSplit;
+      });
+      mid = int(split - items.data());
+    }
+
+    int left = (int) nodes.size();
+    nodes.push_back(Node());
+    nodes.push_back(Node());
+    nodes[left].parent = task.node;
+    nodes[left + 1].parent = task.node;
+    nodes[task.node].first = left;
+    nodes[task.node].count = 0;
+    tasks.push_back({left, task.begin, mid, task.depth + 1});
+    tasks.push_back({left + 1, mid, task.end, task.depth + 1});
+  }
+}
+
+void BVH::indexLeaves() {
+  mItemLeaf.resize(mItemBounds.size());
+  for (size_t n = 0; n < mNodes.size(); n++) {
+    const Node &node = mNodes[n];
+    for (int i = node.first; i < node.first + node.count; i++) {
+      mItemLeaf[mItems[i]] = (int) n;
+    }
+  }
+}
+
+void BVH::update(int item, const Bounds &bounds) {
+  if (mItemBounds[item] == bounds) return;
+  mItemBounds[item] = bounds;
+  int n = mItemLeaf[item];
+  Bounds leafBounds;
+  for (int i = mNodes[n].first; i < mNodes[n].first + mNodes[n].count; i++) {
+    leafBounds.extend(mItemBounds[mItems[i]]);
+  }
+  mNodes[n].bounds = leafBounds;
+  // Walk up until a node does not change
+  n = mNodes[n].parent;
+  while (n >= 0) {
+    Bounds b = mNodes[mNodes[n].first].bounds;
+    b.extend(mNodes[mNodes[n].first + 1].bounds);
+    if (b == mNodes[n].bounds) break;
+    mNodes[n].bounds = b;
+    n = mNodes[n].parent;
+  }
+}
+
+void BVH::refit() {
+  // Children are always stored after their parent
+  for (int n = (int) mNodes.size() - 1; n >= 0; n--) {
+    Node &node = mNodes[n];
+    Bounds b;
+    if (node.leaf()) {
+      for (int i = node.first; i < node.first + node.count; i++) {
+        b.extend(mItemBounds[mItems[i]]);
+      }
+    } else {
+      b = mNodes[node.first].bounds;
+      b.extend(mNodes[node.first + 1].bounds);
+    }
+    node.bounds = b;
+  }
+}
+
+bool BVH::rebuildAsync() {
+  if (mRebuildThread.joinable()) return false;
+  mRebuildBounds = mItemBounds;
+  mRebuildDone = false;
+  mRebuildThread = std::thread([this]() {
+    buildNodes(mRebuildBounds, mRebuildNodes, mRebuildItems);
+    mRebuildDone = true;
+  });
+  return true;
+}
+
+bool BVH::finishRebuild(bool wait) {
+  if (!mRebuildThread.joinable()) return false;
+  if (!wait && !mRebuildDone) return false;
+  mRebuildThread.join();
+  mRebuildDone = false;
+  mNodes.swap(mRebuildNodes);
+  mItems.swap(mRebuildItems);
+  indexLeaves();
+  refit(); // Boxes may have moved during the build
+  mBuildCost = cost();
+  return true;
+}
+
+int BVH::depth() const {
+  std::vector<int> depths(mNodes.size(), 0);
+  int deepest = 0;
+  for (size_t n = 1; n < mNodes.size(); n++) {
+    depths[n] = depths[mNodes[n].parent] + 1;
+    deepest = std::max(deepest, depths[n]);
+  }
+  return deepest;
+}
+
+float BVH::cost() const { return sahCost(mNodes); }
+
+void BVH::intersectBounds(const Rayd &ray, std::vector<int> &items) const {
+  items.clear();
+  if (mNodes.size() == 0) return;
+  RayData r;
+  rayData(ray, r);
+  int stack[64];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const Node &node = mNodes[stack[--top]];
+    if (enter(r, node.bounds, FLT_MAX) < 0) continue;
+    if (node.leaf()) {
+      for (int i = node.first; i < node.first + node.count; i++) {
+        if (enter(r, mItemBounds[mItems[i]], FLT_MAX) >= 0) {
+          items.push_back(mItems[i]);
+        }
+      }
+    } else {
+      stack[top++] = node.first;
+      stack[top++] = node.first + 1;
+    }
+  }
+}
+
+void BVH::rayData(const Rayd &ray, RayData &data) {
+  for (int i = 0; i < 3; i++) {
+    data.o[i] = float(ray.o[i]);
+    data.parallel[i] = ray.d[i] == 0.0;
+    data.invDir[i] = data.parallel[i] ? 0.0f : float(1.0 / ray.d[i]);
+  }
+}
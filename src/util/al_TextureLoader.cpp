@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "al/core/graphics/al_OpenGL.hpp"
+#include "al/util/al_TextureLoader.hpp"
+
+using namespace al;
+
+std::vector<uint8_t> PixelBufferPool::acquire(size_t size) {
+  std::unique_lock<std::mutex> lk(mLock);
+  // Smallest buffer that fits, or largest buffer if no size requested
+  int best = -1;
+  for (size_t i = 0; i < mBuffers.size(); i++) {
+    size_t capacity = mBuffers[i].capacity();
+    if (size == 0) {
+      if (best < 0 || capacity > mBuffers[best].capacity()) {
+        best = (int) i;
+      }
+    } else if (capacity >= size && (best < 0 || capacity < mBuffers[best].capacity())) {
+      best = (int) i;
+    }
+  }
+  std::vector<uint8_t> buffer;
+  if (best >= 0) {
+    buffer = std::move(mBuffers[best]);
+    mBuffers.erase(mBuffers.begin() + best);
+    mPooledBytes -= buffer.capacity();
+  } else {
+    mMisses++;
+  }
+  lk.unlock();
+  buffer.resize(size);
+  return buffer;
+}
+
+void PixelBufferPool::release(std::vector<uint8_t> &&buffer) {
+  if (buffer.capacity() == 0) {
+    return;
+  }
+  std::unique_lock<std::mutex> lk(mLock);
+  if (mPooledBytes + buffer.capacity() > mMaxPooledBytes) {
+    return; // Buffer is freed
+  }
+  buffer.clear();
+  mPooledBytes += buffer.capacity();
+  mBuffers.push_back(std::move(buffer));
+}
+
+size_t PixelBufferPool::available() {
+  std::unique_lock<std::mutex> lk(mLock);
+  return mBuffers.size();
+}
+
+uint64_t TextureUploadScheduler::add(unsigned int width, unsigned int height, unsigned int bytesPerPixel) {
+  Job job;
+  job.id = mNextId++;
+  job.rowBytes = (size_t) width * bytesPerPixel;
+  job.height = height;
+  job.nextRow = 0;
+  mJobs.push_back(job);
+  return job.id;
+}
+
+std::vector<TextureUploadScheduler::Slice> TextureUploadScheduler::nextFrame() {
+  std::vector<Slice> slices;
+  size_t remaining = mBudget;
+  while (mJobs.size() > 0) {
+    Job &job = mJobs.front();
+    unsigned int rowsLeft = job.height - job.nextRow;
+    unsigned int rows = job.rowBytes > 0 ? (unsigned int) std::min<size_t>(rowsLeft, remaining / job.rowBytes) : rowsLeft;
+    if (rows == 0) {
+      if (slices.size() > 0) {
+        break;
+      }
+      rows = 1; // Always make progress
+    }
+    Slice slice;
+    slice.job = job.id;
+    slice.firstRow = job.nextRow;
+    slice.numRows = rows;
+    slice.bytes = rows * job.rowBytes;
+    slice.last = rows == rowsLeft;
+    slices.push_back(slice);
+    job.nextRow += rows;
+    remaining -= std::min(remaining, slice.bytes);
+    if (slice.last) {
+      mJobs.pop_front();
+    } else {
+      break;
+    }
+  }
+  return slices;
+}
+
+size_t TextureUploadScheduler::pendingBytes() const {
+  size_t bytes = 0;
+  for (auto &job : mJobs) {
+    bytes += (job.height - job.nextRow) * job.rowBytes;
+  }
+  return bytes;
+}
+
+TextureLoader::TextureLoader(unsigned int numThreads) {
+  if (numThreads == 0) {
+    // hardware_concurrency() returns 0 when unknown
+    unsigned int hc = std::thread::hardware_concurrency();
+    numThreads = hc > 1 ? hc - 1 : 1;
+  }
+  mDecodeFunction = [](const std::string &path, imgModule::ImageData &image) {
+    return imgModule::loadImage(path.c_str(), image);
+  };
+  for (unsigned int i = 0; i < numThreads; i++) {
+    mThreads.push_back(std::thread(&TextureLoader::decoderFunction, this));
+  }
+}
+
+TextureLoader::~TextureLoader() {
+  {
+    std::unique_lock<std::mutex> lk(mLock);
+    mRunning = false;
+  }
+  mCondition.notify_all();
+  for (auto &thread : mThreads) {
+    thread.join();
+  }
+}
+
+TextureHandle TextureLoader::load(const std::string &path) {
+  StatePtr state = std::make_shared<TextureHandle::State>();
+  state->path = path;
+  {
+    std::unique_lock<std::mutex> lk(mLock);
+    mRequests.push_back(state);
+  }
+  mCondition.notify_one();
+  return TextureHandle(state);
+}
+
+void TextureLoader::decodeFunction(DecodeFunction function) {
+  std::unique_lock<std::mutex> lk(mLock);
+  mDecodeFunction = function;
+}
+
+void TextureLoader::decoderFunction() {
+  std::unique_lock<std::mutex> lk(mLock);
+  while (true) {
+    mCondition.wait(lk, [&]() { return !mRunning || mRequests.size() > 0; });
+    if (!mRunning) {
+      break;
+    }
+    StatePtr state = mRequests.front();
+    mRequests.pop_front();
+    mBusyThreads++;
+    DecodeFunction decode = mDecodeFunction;
+    lk.unlock();
+
+    state->image.data = mBufferPool.acquire();
+    bool ok = decode(state->path, state->image);
+    if (ok) {
+      state->width = state->image.width;
+      state->height = state->image.height;
+    } else {
+      mBufferPool.release(std::move(state->image.data));
+      state->image.data = std::vector<uint8_t>();
+    }
+
+    lk.lock();
+    if (ok) {
+      state->status = TextureHandle::DECODED;
+      mDecoded.push_back(state);
+    } else {
+      std::cerr << "ERROR: TextureLoader could not decode " << state->path << std::endl;
+      state->status = TextureHandle::FAILED;
+    }
+    mBusyThreads--;
+    if (mBusyThreads == 0 && mRequests.size() == 0) {
+      mIdleCondition.notify_all();
+    }
+  }
+}
+
+void TextureLoader::waitForDecodes() {
+  std::unique_lock<std::mutex> lk(mLock);
+  mIdleCondition.wait(lk, [&]() { return mBusyThreads == 0 && mRequests.size() == 0; });
+}
+
+size_t TextureLoader::pendingDecodes() {
+  std::unique_lock<std::mutex> lk(mLock);
+  return mRequests.size() + mBusyThreads;
+}
+
+size_t TextureLoader::pendingUploads() {
+  std::unique_lock<std::mutex> lk(mLock);
+  return mUploads.size() + mDecoded.size();
+}
+
+void TextureLoader::update() {
+  std::deque<StatePtr> decoded;
+  {
+    std::unique_lock<std::mutex> lk(mLock);
+    decoded.swap(mDecoded);
+  }
+  for (auto &state : decoded) {
+    state->texture.create2D(state->width, state->height, Texture::RGBA8, Texture::RGBA, Texture::UBYTE);
+    state->uploadJob = mScheduler.add(state->width, state->height, 4);
+    state->status = TextureHandle::UPLOADING;
+    mUploads.push_back(state);
+  }
+
+  for (auto &slice : mScheduler.nextFrame()) {
+    auto it = std::find_if(mUploads.begin(), mUploads.end(), [&](const StatePtr &state) {
+      return state->uploadJob == slice.job;
+    });
+    if (it == mUploads.end()) {
+      continue;
+    }
+    StatePtr state = *it;
+    uploadSlice(*state, slice);
+    if (slice.last) {
+      if (mMipmaps) {
+        state->texture.generateMipmap();
+      }
+      mBufferPool.release(std::move(state->image.data));
+      state->image.data = std::vector<uint8_t>();
+      state->status = TextureHandle::READY;
+      mUploads.erase(it);
+    }
+  }
+}
+
+void TextureLoader::uploadSlice(TextureHandle::State &state, const TextureUploadScheduler::Slice &slice) {
+  size_t rowBytes = (size_t) state.width * 4;
+  const uint8_t *src = state.image.data.data() + slice.firstRow * rowBytes;
+
+  // Alternate between two buffers so mapping does not wait for the previous upload
+  BufferObject &pixelBuffer = mPixelBuffers[mCurrentPixelBuffer];
+  mCurrentPixelBuffer = (mCurrentPixelBuffer + 1) % 2;
+  if (!pixelBuffer.created()) {
+    pixelBuffer.bufferType(GL_PIXEL_UNPACK_BUFFER);
+    pixelBuffer.usage(GL_STREAM_DRAW);
+    pixelBuffer.create();
+  }
+  pixelBuffer.bind();
+  pixelBuffer.data(slice.bytes, nullptr); // Orphan previous storage
+  void *dest = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, slice.bytes,
+                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  if (dest) {
+    memcpy(dest, src, slice.bytes);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    state.texture.submitRegion(nullptr, 0, slice.firstRow, state.width, slice.numRows,
+                               Texture::RGBA, Texture::UBYTE);
+    pixelBuffer.unbind();
+  } else {
+    pixelBuffer.unbind();
+    state.texture.submitRegion(src, 0, slice.firstRow, state.width, slice.numRows,
+                               Texture::RGBA, Texture::UBYTE);
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
@@ -1,4 +1,5 @@
 #include "al/util/scene/al_DynamicScene.hpp"
+#include "al/core/io/al_AudioCallbackProfiler.hpp"
 #include "al/core/graphics/al_Shapes.hpp"
 
 using namespace std;
@@ -138,32 +139,96 @@ void DynamicScene::render(Graphics &g) {
         processVoiceTurnOff();
     }
     std::unique_lock<std::mutex> lk(mGraphicsLock);
+    if (cullingEnabled()) {
+        cull(g.viewMatrix() * g.modelMatrix(), g.projMatrix());
+        for (auto *voice: mVisibleVoices) {
+            drawVoice(g, voice);
+        }
+    } else {
+        SynthVoice *voice = mActiveVoices;
+        while (voice) {
+            // TODO implement offset?
+            if (voice->active()) {
+                drawVoice(g, voice);
+                mCullingStats.drawn++;
+            }
+            voice = voice->next;
+        }
+    }
+    if (mMasterMode == TIME_MASTER_GRAPHICS) {
+        processInactiveVoices();
+    }
+}
+
+void DynamicScene::drawVoice(Graphics &g, SynthVoice *voice) {
+    g.pushMatrix();
+    if (voice->isPositioned()) {
+        PositionedVoice *posVoice = static_cast<PositionedVoice *>(voice);
+        Pose &pose = posVoice->pose();
+        g.translate(pose.x(), pose.y(), pose.z());
+        g.rotate(pose.quat());
+        g.scale(posVoice->size());
+    }
+    voice->onProcess(g);
+    g.popMatrix();
+}
+
+void DynamicScene::cullVoices(const Matrix4f &modelView, const Matrix4f &projection) {
+    std::unique_lock<std::mutex> lk(mGraphicsLock);
+    cull(modelView, projection);
+}
+
+void DynamicScene::cull(const Matrix4f &modelView, const Matrix4f &projection) {
+    mVisibleVoices.clear();
+    // Voices are tested in eye coordinates, so the frustum only depends on the projection
+    Frustumf frustum;
+    if (mFrustumCulling) {
+        frustum.fromMatrix(projection);
+    }
+    // The model view matrix can scale, include that in the radius
+    float radiusScale = mCullingRadius * std::max(std::max(modelView.col(0).sub<3>().mag(),
+                                                           modelView.col(1).sub<3>().mag()),
+                                                  modelView.col(2).sub<3>().mag());
     SynthVoice *voice = mActiveVoices;
     while (voice) {
-        // TODO implement offset?
         if (voice->active()) {
-            g.pushMatrix();
-            if (dynamic_cast<PositionedVoice *>(voice)) {
+            if (voice->isPositioned()) {
                 PositionedVoice *posVoice = static_cast<PositionedVoice *>(voice);
-                Pose &pose = posVoice->pose();
-                g.translate(pose.x(), pose.y(), pose.z());
-                g.rotate(pose.quat());
-                g.scale(posVoice->size());
+                mCullingStats.tested++;
+                Vec3f pos = posVoice->pose().pos();
+                Vec3f eyePos;
+                for (int i = 0; i < 3; i++) {
+                    eyePos[i] = modelView(i, 0) * pos.x + modelView(i, 1) * pos.y
+                            + modelView(i, 2) * pos.z + modelView(i, 3);
+                }
+                float radius = radiusScale * std::abs(posVoice->size());
+                float distance = eyePos.mag();
+                if (mMaxDrawDistance > 0 && distance - radius > mMaxDrawDistance) {
+                    mCullingStats.distanceCulled++;
+                } else if (mFrustumCulling && frustum.testSphere(eyePos, radius) == Frustumf::OUTSIDE) {
+                    mCullingStats.frustumCulled++;
+                } else if (mLodCallback && !(*mLodCallback)(*posVoice, distance)) {
+                    mCullingStats.lodCulled++;
+                } else {
+                    mVisibleVoices.push_back(voice);
+                }
+            } else {
+                mVisibleVoices.push_back(voice);
             }
-            voice->onProcess(g);
-            g.popMatrix();
         }
         voice = voice->next;
     }
-    if (mMasterMode == TIME_MASTER_GRAPHICS) {
-        processInactiveVoices();
-    }
+    mCullingStats.drawn += mVisibleVoices.size();
 }
 
 void DynamicScene::render(AudioIOData &io) {
     assert(mSpatializer && "ERROR: call setSpatializer before starting audio");
     io.frame(0);
-    mSpatializer->prepare(io);
+    AudioCallbackProfiler *profiler = io.profiler();
+    {
+        AudioSectionTimer timer(profiler, AudioCallbackProfiler::SPATIALIZER);
+        mSpatializer->prepare(io);
+    }
     if (mMasterMode == TIME_MASTER_AUDIO) {
         processVoices();
         // Turn off voices
@@ -186,10 +251,13 @@ void DynamicScene::render(AudioIOData &io) {
                     internalAudioIO.zeroOut();
                     internalAudioIO.zeroBus();
                     internalAudioIO.frame(offset);
-                    voice->onProcess(internalAudioIO);
+                    {
+                        AudioSectionTimer timer(profiler, AudioCallbackProfiler::VOICES);
+                        voice->onProcess(internalAudioIO);
+                    }
                     Vec3d listeningDir;
                     vector<Vec3f> posOffsets;
-                    if (dynamic_cast<PositionedVoice *>(voice)) {
+                    if (voice->isPositioned()) {
                         PositionedVoice *posVoice = static_cast<PositionedVoice *>(voice);
                         Vec3d direction = posVoice->pose().vec() - mListenerPose.vec();
 
@@ -226,6 +294,7 @@ void DynamicScene::render(AudioIOData &io) {
                             }
                         }
                     }
+                    AudioSectionTimer spatializerTimer(profiler, AudioCallbackProfiler::SPATIALIZER);
                     for (unsigned int i = 0; i < voice->numOutChannels(); i++) {
                         io.frame(offset);
                         internalAudioIO.frame(offset);
@@ -258,18 +327,27 @@ void DynamicScene::render(AudioIOData &io) {
             }
             voice = voice->next;
         }
+        // Voice processing and spatialization happen together in the worker
+        // threads, so they are reported as voices
+        AudioSectionTimer timer(profiler, AudioCallbackProfiler::VOICES);
         externalAudioIO = &io;
         mThreadTrigger.notify_all();
         std::unique_lock<std::mutex> lk(mThreadTriggerLock);
         mAudioThreadDone.wait(lk, [this](){ return mAudioBusy == 0; });
     }
-    mSpatializer->finalize(io);
+    {
+        AudioSectionTimer timer(profiler, AudioCallbackProfiler::SPATIALIZER);
+        mSpatializer->finalize(io);
+    }
     processGain(io);
 
     // Run post processing callbacks
-    for (auto cb: mPostProcessing) {
-        io.frame(0);
-        cb->onAudioCB(io);
+    if (mPostProcessing.size() > 0) {
+        AudioSectionTimer timer(profiler, AudioCallbackProfiler::POST_PROCESSING);
+        for (auto cb: mPostProcessing) {
+            io.frame(0);
+            cb->onAudioCB(io);
+        }
     }
     if (mMasterMode == TIME_MASTER_AUDIO) {
         processInactiveVoices();
@@ -366,7 +444,7 @@ void DynamicScene::audioThreadFunc(DynamicScene *scene, int id) {
                     voice->onProcess(internalAudioIO);
                     Vec3d listeningDir;
                     vector<Vec3f> posOffsets;
-                    if (dynamic_cast<PositionedVoice *>(voice)) {
+                    if (voice->isPositioned()) {
                         PositionedVoice *posVoice = static_cast<PositionedVoice *>(voice);
                         Vec3d direction = posVoice->pose().vec() - scene->mListenerPose.vec();
 
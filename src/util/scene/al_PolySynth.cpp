@@ -1,6 +1,7 @@
 #include <memory>
 
 #include "al/util/scene/al_PolySynth.hpp"
+#include "al/core/io/al_AudioCallbackProfiler.hpp"
 
 using namespace al;
 
@@ -267,26 +268,32 @@ void PolySynth::render(AudioIOData &io) {
     // Render active voices
     auto voice = mActiveVoices;
     int fpb = io.framesPerBuffer();
-    while (voice) {
-        if (voice->active()) {
-            int offset = voice->getStartOffsetFrames(fpb);
-            if (offset < fpb) {
-                io.frame(offset);
-                int endOffsetFrames = voice->getEndOffsetFrames(fpb);
-                if (endOffsetFrames > 0 && endOffsetFrames <= fpb) {
-                    voice->triggerOff(endOffsetFrames);
+    {
+        AudioSectionTimer timer(io.profiler(), AudioCallbackProfiler::VOICES);
+        while (voice) {
+            if (voice->active()) {
+                int offset = voice->getStartOffsetFrames(fpb);
+                if (offset < fpb) {
+                    io.frame(offset);
+                    int endOffsetFrames = voice->getEndOffsetFrames(fpb);
+                    if (endOffsetFrames > 0 && endOffsetFrames <= fpb) {
+                        voice->triggerOff(endOffsetFrames);
+                    }
+                    voice->onProcess(io);
                 }
-                voice->onProcess(io);
             }
+            voice = voice->next;
         }
-        voice = voice->next;
     }
     processGain(io);
 
     // Run post processing callbacks
-    for (auto cb: mPostProcessing) {
-        io.frame(0);
-        cb->onAudioCB(io);
+    if (mPostProcessing.size() > 0) {
+        AudioSectionTimer timer(io.profiler(), AudioCallbackProfiler::POST_PROCESSING);
+        for (auto cb: mPostProcessing) {
+            io.frame(0);
+            cb->onAudioCB(io);
+        }
     }
     if (mMasterMode == TIME_MASTER_AUDIO) {
         processInactiveVoices();
@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "al/util/scene/al_SynthEventLog.hpp"
+
+using namespace al;
+
+static_assert(sizeof(SynthEventRecord) == 128, "SynthEventRecord layout is part of the file format");
+
+namespace {
+
+const char kLogMagic[8] = {'A', 'L', 'S', 'Y', 'N', 'L', 'O', 'G'};
+const uint32_t kLogVersion = 1;
+const uint32_t kChunkMagic = 0x4b4e4843; // "CHNK"
+const uint32_t kChunkNames = 1;
+const uint32_t kChunkRecords = 2;
+
+struct ChunkHeader {
+  uint32_t magic;
+  uint32_t type;
+  uint32_t count;
+  uint32_t payloadSize;
+  uint32_t crc;
+};
+
+struct Crc32Table {
+  Crc32Table() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      values[i] = c;
+    }
+  }
+  uint32_t values[256];
+};
+
+uint32_t crc32(const char *data, size_t size) {
+  static const Crc32Table crcTable;
+  const uint32_t *table = crcTable.values;
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < size; i++) {
+    crc = table[(crc ^ (uint8_t) data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFu;
+}
+
+} // namespace
+
+SynthEventLog::SynthEventLog(size_t queueSize) :
+  mQueue(queueSize)
+{
+}
+
+SynthEventLog::~SynthEventLog() {
+  close();
+}
+
+bool SynthEventLog::open(std::string fileName, bool append) {
+  close();
+  if (append) {
+    mFile = fopen(fileName.c_str(), "ab");
+  } else {
+    mFile = fopen(fileName.c_str(), "wb");
+  }
+  if (!mFile) {
+    std::cerr << "ERROR: Could not open synth event log: " << fileName << std::endl;
+    return false;
+  }
+  fseek(mFile, 0, SEEK_END);
+  if (ftell(mFile) == 0) {
+    fwrite(kLogMagic, 1, sizeof(kLogMagic), mFile);
+    uint32_t header[2] = {kLogVersion, (uint32_t) sizeof(SynthEventRecord)};
+    fwrite(header, sizeof(uint32_t), 2, mFile);
+    fflush(mFile);
+  }
+  // Names are written again in every session, so indices in appended
+  // sessions are remapped when the log is read.
+  mSynthTypes.clear();
+  mRunning = true;
+  mWriterThread = std::thread(&SynthEventLog::writerFunction, this);
+  return true;
+}
+
+void SynthEventLog::close() {
+  if (mRunning) {
+    {
+      std::unique_lock<std::mutex> lk(mWriterLock);
+      mRunning = false;
+    }
+    mWriterCondition.notify_one();
+    mWriterThread.join();
+  }
+  if (mFile) {
+    fclose(mFile);
+    mFile = nullptr;
+  }
+}
+
+bool SynthEventLog::logTriggerOn(SynthVoice *voice, double time) {
+  Entry entry;
+  SynthEventRecord &record = entry.record;
+  record.type = TRIGGER_ON;
+  record.id = voice->id();
+  record.time = time;
+  entry.synthType = &typeid(*voice);
+  // Strings are not copied here, as that allocates and locks the parameter.
+  // Menus are stored as their index and strings are read by the writer.
+  for (auto *param : voice->triggerParameters()) {
+    if (record.numFields == SynthEventRecord::maxFields) {
+      break;
+    }
+    uint32_t bit = 1u << record.numFields;
+    if (auto *menu = dynamic_cast<ParameterMenu *>(param)) {
+      record.fields[record.numFields] = (float) menu->get();
+      record.stringMask |= bit;
+      entry.menuMask |= bit;
+    } else if (dynamic_cast<ParameterString *>(param)) {
+      record.fields[record.numFields] = 0.0f;
+      record.stringMask |= bit;
+    } else {
+      record.fields[record.numFields] = param ? param->toFloat() : 0.0f;
+    }
+    record.numFields++;
+  }
+  if (record.stringMask) {
+    entry.voice = voice;
+  }
+  if (!mQueue.push(entry)) {
+    mEventsDropped++;
+    return false;
+  }
+  return true;
+}
+
+bool SynthEventLog::logTriggerOff(int id, double time) {
+  Entry entry;
+  entry.record.type = TRIGGER_OFF;
+  entry.record.id = id;
+  entry.record.time = time;
+  if (!mQueue.push(entry)) {
+    mEventsDropped++;
+    return false;
+  }
+  return true;
+}
+
+void SynthEventLog::writerFunction() {
+  std::vector<SynthEventRecord> records;
+  records.reserve(recordsPerChunk);
+  std::vector<std::pair<uint32_t, std::string>> newNames;
+  auto lastWrite = std::chrono::steady_clock::now();
+  bool running = true;
+  while (running) {
+    {
+      // Producers never notify, as that is not safe on the audio thread.
+      // Poll the queue instead.
+      std::unique_lock<std::mutex> lk(mWriterLock);
+      mWriterCondition.wait_for(lk, std::chrono::milliseconds(5));
+      running = mRunning;
+    }
+    Entry entry;
+    while (mQueue.pop(entry)) {
+      if (entry.record.type == TRIGGER_ON) {
+        uint32_t index = 0;
+        while (index < mSynthTypes.size() && *mSynthTypes[index] != *entry.synthType) {
+          index++;
+        }
+        if (index == mSynthTypes.size()) {
+          mSynthTypes.push_back(entry.synthType);
+          newNames.push_back({index, demangle(entry.synthType->name())});
+        }
+        entry.record.synthIndex = index;
+        if (entry.voice) {
+          resolveStrings(entry);
+        }
+      }
+      records.push_back(entry.record);
+      if (records.size() == recordsPerChunk) {
+        writeNames(newNames);
+        writeRecords(records);
+        lastWrite = std::chrono::steady_clock::now();
+      }
+    }
+    std::chrono::duration<double> sinceWrite = std::chrono::steady_clock::now() - lastWrite;
+    if (records.size() > 0 && (sinceWrite.count() >= mFlushInterval || !running)) {
+      writeNames(newNames);
+      writeRecords(records);
+      lastWrite = std::chrono::steady_clock::now();
+    }
+  }
+}
+
+void SynthEventLog::resolveStrings(Entry &entry) {
+  SynthEventRecord &record = entry.record;
+  size_t textPos = 0;
+  int field = 0;
+  for (auto *param : entry.voice->triggerParameters()) {
+    if (field == record.numFields) {
+      break;
+    }
+    uint32_t bit = 1u << field++;
+    if (!(record.stringMask & bit)) {
+      continue;
+    }
+    std::string value;
+    if (entry.menuMask & bit) {
+      if (auto *menu = dynamic_cast<ParameterMenu *>(param)) {
+        std::vector<std::string> elements = menu->getElements();
+        int index = (int) record.fields[field - 1];
+        if (index >= 0 && index < (int) elements.size()) {
+          value = elements[index];
+        }
+      }
+    } else if (auto *string = dynamic_cast<ParameterString *>(param)) {
+      value = string->get();
+    }
+    if (textPos < sizeof(record.text)) {
+      size_t length = std::min(value.size(), sizeof(record.text) - 1 - textPos);
+      memcpy(record.text + textPos, value.c_str(), length);
+      record.text[textPos + length] = '\0';
+      textPos += length + 1;
+    }
+  }
+}
+
+void SynthEventLog::writeNames(std::vector<std::pair<uint32_t, std::string>> &names) {
+  if (names.size() == 0) {
+    return;
+  }
+  std::vector<char> payload;
+  for (auto &name : names) {
+    uint32_t header[2] = {name.first, (uint32_t) name.second.size()};
+    payload.insert(payload.end(), (char *) header, (char *) header + sizeof(header));
+    payload.insert(payload.end(), name.second.begin(), name.second.end());
+  }
+  writeChunk(kChunkNames, (uint32_t) names.size(), payload);
+  names.clear();
+}
+
+void SynthEventLog::writeRecords(std::vector<SynthEventRecord> &records) {
+  std::vector<char> payload((char *) records.data(),
+                            (char *) (records.data() + records.size()));
+  writeChunk(kChunkRecords, (uint32_t) records.size(), payload);
+  mEventsWritten += records.size();
+  records.clear();
+}
+
+void SynthEventLog::writeChunk(uint32_t type, uint32_t count, const std::vector<char> &payload) {
+  ChunkHeader header;
+  header.magic = kChunkMagic;
+  header.type = type;
+  header.count = count;
+  header.payloadSize = (uint32_t) payload.size();
+  header.crc = crc32(payload.data(), payload.size());
+  fwrite(&header, sizeof(ChunkHeader), 1, mFile);
+  fwrite(payload.data(), 1, payload.size(), mFile);
+  fflush(mFile);
+}
+
+bool SynthEventLog::read(std::string fileName, std::vector<SynthEvent> &events) {
+  FILE *f = fopen(fileName.c_str(), "rb");
+  if (!f) {
+    std::cerr << "ERROR: Could not open synth event log: " << fileName << std::endl;
+    return false;
+  }
+  char magic[8];
+  uint32_t header[2];
+  if (fread(magic, 1, sizeof(magic), f) != sizeof(magic)
+      || memcmp(magic, kLogMagic, sizeof(magic)) != 0
+      || fread(header, sizeof(uint32_t), 2, f) != 2
+      || header[0] != kLogVersion || header[1] != sizeof(SynthEventRecord)) {
+    std::cerr << "ERROR: Not a synth event log: " << fileName << std::endl;
+    fclose(f);
+    return false;
+  }
+
+  long dataStart = ftell(f);
+  fseek(f, 0, SEEK_END);
+  long fileSize = ftell(f);
+  fseek(f, dataStart, SEEK_SET);
+
+  // The CRC only covers the payload, so the chunk header and the sizes in the
+  // payload are checked before they are used.
+  std::vector<std::string> names;
+  std::vector<char> payload;
+  ChunkHeader chunk;
+  while (fread(&chunk, sizeof(ChunkHeader), 1, f) == 1) {
+    if (chunk.magic != kChunkMagic) {
+      std::cerr << "WARNING: Corrupt chunk in synth event log: " << fileName << std::endl;
+      break;
+    }
+    if (chunk.payloadSize > (uint64_t) (fileSize - ftell(f))) {
+      std::cerr << "WARNING: Incomplete chunk at end of synth event log: " << fileName << std::endl;
+      break;
+    }
+    if (chunk.type == kChunkRecords
+        && (uint64_t) chunk.count * sizeof(SynthEventRecord) > chunk.payloadSize) {
+      std::cerr << "WARNING: Corrupt chunk in synth event log: " << fileName << std::endl;
+      break;
+    }
+    payload.resize(chunk.payloadSize);
+    if (fread(payload.data(), 1, chunk.payloadSize, f) != chunk.payloadSize) {
+      std::cerr << "WARNING: Incomplete chunk at end of synth event log: " << fileName << std::endl;
+      break;
+    }
+    if (crc32(payload.data(), payload.size()) != chunk.crc) {
+      std::cerr << "WARNING: CRC mismatch in synth event log: " << fileName << std::endl;
+      break;
+    }
+    bool corrupt = false;
+    if (chunk.type == kChunkNames) {
+      size_t pos = 0;
+      for (uint32_t i = 0; i < chunk.count; i++) {
+        uint32_t entry[2];
+        if (pos + sizeof(entry) > payload.size()) {
+          corrupt = true;
+          break;
+        }
+        memcpy(entry, payload.data() + pos, sizeof(entry));
+        pos += sizeof(entry);
+        // Indices are assigned in order, so one far past the known names is
+        // corrupt
+        if (entry[1] > payload.size() - pos || entry[0] > names.size() + chunk.count) {
+          corrupt = true;
+          break;
+        }
+        if (names.size() <= entry[0]) {
+          names.resize(entry[0] + 1);
+        }
+        names[entry[0]] = std::string(payload.data() + pos, entry[1]);
+        pos += entry[1];
+      }
+    } else if (chunk.type == kChunkRecords) {
+      for (uint32_t i = 0; i < chunk.count; i++) {
+        SynthEventRecord record;
+        memcpy(&record, payload.data() + i * sizeof(SynthEventRecord), sizeof(SynthEventRecord));
+        if (record.numFields > SynthEventRecord::maxFields) {
+          corrupt = true;
+          break;
+        }
+        SynthEvent event;
+        event.type = (SynthEventType) record.type;
+        event.id = record.id;
+        event.time = record.time;
+        if (record.type == TRIGGER_ON) {
+          if (record.synthIndex < names.size()) {
+            event.synthName = names[record.synthIndex];
+          }
+          size_t textPos = 0;
+          for (int field = 0; field < record.numFields; field++) {
+            if (record.stringMask & (1u << field)) {
+              std::string value;
+              if (textPos < sizeof(record.text)) {
+                size_t length = strnlen(record.text + textPos, sizeof(record.text) - textPos);
+                value = std::string(record.text + textPos, length);
+                textPos += length + 1;
+              }
+              event.pFields.push_back(value);
+            } else {
+              event.pFields.push_back(record.fields[field]);
+            }
+          }
+        }
+        events.push_back(event);
+      }
+    }
+    if (corrupt) {
+      std::cerr << "WARNING: Corrupt chunk in synth event log: " << fileName << std::endl;
+      break;
+    }
+  }
+  fclose(f);
+  return true;
+}
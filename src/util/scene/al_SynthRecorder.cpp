@@ -6,14 +6,34 @@ using namespace al;
 void SynthRecorder::startRecord(std::string name, bool overwrite, bool startOnEvent) {
     mOverwrite = overwrite;
     mStartOnEvent = startOnEvent;
-    mRecording = true;
     mSequenceStart = std::chrono::high_resolution_clock::now();
     mSequenceName = name;
+    if (mFormat == BINARY_LOG) {
+        std::string fileName = File::conformDirectory(mDirectory) + mSequenceName + ".synthLog";
+        // Append to an existing log rather than replace it, as a log may
+        // hold days of events from a previous run.
+        if (!mEventLog) {
+            mEventLog.reset(new SynthEventLog);
+        }
+        if (!mEventLog->open(fileName, !mOverwrite)) {
+            return;
+        }
+    }
+    mRecording = true;
 }
 
 void SynthRecorder::stopRecord() {
     mRecording = false;
     std::string path = File::conformDirectory(mDirectory);
+    if (mFormat == BINARY_LOG) {
+        if (mEventLog) {
+            mEventLog->close();
+            std::cout << "Recorded: " << path + mSequenceName + ".synthLog"
+                      << " (" << mEventLog->eventsWritten() << " events written, "
+                      << mEventLog->eventsDropped() << " dropped)" << std::endl;
+        }
+        return;
+    }
     std::string fileName = path + mSequenceName + ".synthSequence";
 
     std::string newSequenceName = mSequenceName;
@@ -26,14 +46,34 @@ void SynthRecorder::stopRecord() {
         }
         fileName = newFileName;
     }
+    std::unique_lock<std::mutex> lk(mSequenceLock);
+    if (writeSequence(mSequence, fileName, mFormat, mPolySynth)) {
+        std::cout << "Recorded: " << fileName << std::endl;
+    }
+    mSequence.clear();
+    //        recorder->mLastSequenceName = newSequenceName;
+    //        recorder->mLastSequenceSubDir = recorder->mPresetHandler->getSubDirectory();
+}
+
+bool SynthRecorder::convertLog(std::string logFileName, std::string sequenceFileName,
+                               TextFormat format, PolySynth *polySynth) {
+    std::vector<SynthEvent> sequence;
+    if (!SynthEventLog::read(logFileName, sequence)) {
+        return false;
+    }
+    return writeSequence(sequence, sequenceFileName, format, polySynth);
+}
+
+bool SynthRecorder::writeSequence(std::vector<SynthEvent> &sequence, std::string fileName,
+                                  TextFormat format, PolySynth *polySynth) {
     std::vector<std::string> usedInstruments;
     std::ofstream f(fileName);
     if (!f.is_open()) {
         std::cout << "Error while opening sequence file: " << fileName << std::endl;
-        return;
+        return false;
     }
-    if (mFormat == CPP_FORMAT) {
-        for (SynthEvent &event: mSequence) {
+    if (format == CPP_FORMAT) {
+        for (SynthEvent &event: sequence) {
             f << "s.add<" << event.synthName << ">("  << event.time << ").set(";
             for (unsigned int i = 0; i < event.pFields.size(); i++) {
                 if (event.pFields[i].type() == ParameterField::STRING) {
@@ -50,9 +90,9 @@ void SynthRecorder::stopRecord() {
                 usedInstruments.push_back(event.synthName);
             }
         }
-    } else if (mFormat == SEQUENCER_EVENT) {
+    } else if (format == SEQUENCER_EVENT) {
         std::map<int, SynthEvent *> eventStack;
-        for (SynthEvent &event: mSequence) {
+        for (SynthEvent &event: sequence) {
             if (event.type == SynthEventType::TRIGGER_ON) {
                 eventStack[event.id] = &event;
             } else if (event.type == SynthEventType::TRIGGER_OFF) {
@@ -79,8 +119,8 @@ void SynthRecorder::stopRecord() {
         }
 
 
-    } else if (mFormat == SEQUENCER_TRIGGERS) {
-        for (SynthEvent &event: mSequence) {
+    } else if (format == SEQUENCER_TRIGGERS) {
+        for (SynthEvent &event: sequence) {
             if (event.type == SynthEventType::TRIGGER_ON) {
                 f << "+ " << event.time << " " << event.id << " " << event.synthName << " ";
                 for (auto field : event.pFields) {
@@ -110,23 +150,26 @@ void SynthRecorder::stopRecord() {
 
     if (f.bad()) {
         std::cout << "Error while writing sequence file: " << fileName << std::endl;
+        return false;
     }
-    mSequence.clear();
     for (auto &instr: usedInstruments) {
-        f << "# " << instr << " ";
+        if (!polySynth || instr.size() == 0) {
+            continue;
+        }
         // Hack to get the parameter names. Get a voice from the polysynth and then check the parameters. Should there be a better way?
-        auto *voice = mPolySynth->getVoice(instr);
+        auto *voice = polySynth->getVoice(instr);
+        if (!voice) {
+            continue;
+        }
+        f << "# " << instr << " ";
         for (auto p: voice->triggerParameters()) {
             f << p->getName() << " ";
         }
         f << std::endl;
-        mPolySynth->insertFreeVoice(voice);
+        polySynth->insertFreeVoice(voice);
     }
     f.close();
-
-    std::cout << "Recorded: " << fileName << std::endl;
-    //        recorder->mLastSequenceName = newSequenceName;
-    //        recorder->mLastSequenceSubDir = recorder->mPresetHandler->getSubDirectory();
+    return true;
 }
 
 void SynthRecorder::registerPolySynth(PolySynth &polySynth) {
@@ -1,5 +1,8 @@
+#include <algorithm>
+#include <map>
 
 #include "al/util/scene/al_SynthSequencer.hpp"
+#include "al/util/scene/al_SynthEventLog.hpp"
 
 using namespace al;
 
@@ -90,7 +93,8 @@ std::string SynthSequencer::buildFullPath(std::string sequenceName)
   if (fullName.back() != '/') {
     fullName += "/";
   }
-  if (sequenceName.size() < 14 || sequenceName.substr(sequenceName.size() - 14) != ".synthSequence") {
+  bool isLog = sequenceName.size() >= 9 && sequenceName.substr(sequenceName.size() - 9) == ".synthLog";
+  if (!isLog && (sequenceName.size() < 14 || sequenceName.substr(sequenceName.size() - 14) != ".synthSequence")) {
     sequenceName += ".synthSequence";
   }
   fullName += sequenceName;
@@ -101,6 +105,9 @@ std::list<SynthSequencerEvent> SynthSequencer::loadSequence(std::string sequence
   std::unique_lock<std::mutex> lk(mLoadingLock);
   std::list<SynthSequencerEvent> events;
   std::string fullName = buildFullPath(sequenceName);
+  if (fullName.size() >= 9 && fullName.substr(fullName.size() - 9) == ".synthLog") {
+    return loadEventLog(fullName, timeOffset, timeScale);
+  }
   std::ifstream f(fullName);
   if (!f.is_open()) {
     std::cout << "Could not open:" << fullName << std::endl;
@@ -447,3 +454,40 @@ void SynthSequencer::processEvents(double blockStartTime, double fpsAdjusted) {
     mEventLock.unlock();
   }
 }
+
+std::list<SynthSequencerEvent> SynthSequencer::loadEventLog(std::string fullName, double timeOffset, double timeScale) {
+  std::list<SynthSequencerEvent> events;
+  std::vector<SynthEvent> logEvents;
+  if (!SynthEventLog::read(fullName, logEvents)) {
+    return events;
+  }
+  double endTime = 0;
+  for (auto &logEvent : logEvents) {
+    endTime = std::max(endTime, logEvent.time);
+  }
+  std::map<int, SynthSequencerEvent *> openEvents; // Trigger on events waiting for trigger off
+  for (auto &logEvent : logEvents) {
+    if (logEvent.type == TRIGGER_ON) {
+      events.push_back(SynthSequencerEvent());
+      SynthSequencerEvent &event = events.back();
+      event.type = SynthSequencerEvent::EVENT_PFIELDS;
+      event.startTime = timeOffset + logEvent.time * timeScale;
+      // Events without a trigger off last until the end of the log
+      event.duration = (endTime - logEvent.time) * timeScale;
+      event.fields.name = logEvent.synthName;
+      event.fields.pFields = logEvent.pFields;
+      openEvents[logEvent.id] = &event;
+    } else if (logEvent.type == TRIGGER_OFF) {
+      auto match = openEvents.find(logEvent.id);
+      if (match != openEvents.end()) {
+        double startTime = match->second->startTime;
+        match->second->duration = std::max(0.0, timeOffset + logEvent.time * timeScale - startTime);
+        openEvents.erase(match);
+      }
+    }
+  }
+  events.sort([](const SynthSequencerEvent &a, const SynthSequencerEvent &b) {
+    return a.startTime < b.startTime;
+  });
+  return events;
+}
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -7,28 +8,7 @@
 
 using namespace al;
 
-template<class DataType>
-void butter_set_fc(DataType fc, DataType sr, DataType *a, DataType *b, bool lp = true)
-{
-    DataType lambda;
-    DataType const0 = M_PI/(double) sr;
-    if (lp) { // low pass
-        lambda = 1/tan(fc * const0);
-    } else {
-        lambda = tan(fc * const0);
-    }
-    DataType lambda_2 = lambda * lambda;
-    a[0] = 1.0/(1.0 + (sqrt(DataType(2.0))*lambda) + (lambda_2));
-    a[2] =a[0];
-    b[2] =a[0] * (1.0 - (sqrt(DataType(2.0))*lambda) + (lambda_2));
-    if (lp) {
-        a[1] = 2.0 * a[0];
-        b[1] = 2.0 * a[0] * (1.0 - lambda_2);
-    } else {
-        a[1] = - 2.0 * a[0];
-        b[1] = 2.0 * a[0] * (lambda_2 - 1.0);
-    }
-}
+const unsigned int OutputMaster::BASS_CHUNK;
 
 OutputMaster::OutputMaster(unsigned int num_chnls, double sampleRate):
 	m_numChnls(num_chnls), m_framesPerSec(sampleRate)
@@ -71,12 +51,8 @@ void OutputMaster::setMeterUpdateFreq(double freq)
 void OutputMaster::setBassManagementFreq(double frequency)
 {
 	if (frequency > 0) {
-		for (unsigned int i = 0; i < m_numChnls; i++) {
-			butter_set_fc<float>(frequency, m_framesPerSec, m_lopass1[i].a(), m_lopass1[i].a());
-			butter_set_fc<float>(frequency, m_framesPerSec, m_lopass2[i].a(), m_lopass2[i].a());
-			butter_set_fc<float>(frequency, m_framesPerSec, m_hipass1[i].a(), m_hipass1[i].a(), false);
-			butter_set_fc<float>(frequency, m_framesPerSec, m_hipass2[i].a(), m_hipass2[i].a(), false);
-		}
+		m_lowpass.lowpass(frequency, m_framesPerSec);
+		m_highpass.highpass(frequency, m_framesPerSec);
 	}
 }
 
@@ -90,9 +66,9 @@ void OutputMaster::setBassManagementMode(bass_mgmt_mode_t mode)
 void OutputMaster::setSwIndeces(int i1, int i2, int i3, int i4)
 {
 	swIndex[0] = i1;
-	swIndex[1] = i1;
-	swIndex[2] = i1;
-	swIndex[3] = i1;
+	swIndex[1] = i2;
+	swIndex[2] = i3;
+	swIndex[3] = i4;
 }
 
 void OutputMaster::setMeterOn(bool meterOn)
@@ -108,76 +84,88 @@ int OutputMaster::getNumChnls()
 
 void OutputMaster::onAudioCB(AudioIOData &io)
 {
+	AudioSectionTimer timer(io.profiler(), AudioCallbackProfiler::OUTPUT_MASTER);
 	unsigned int nframes = io.framesPerBuffer();
-	double filt_out;
-	double filt_low = 0.0;
 	double master_gain;
 
 //	m_parameterQueue.update(0);
 	master_gain = m_masterGain * (m_muteAll ? 0.0 : 1.0);
-    io.frame(0);
-    while (io()) {
-        double bassbuf = 0.0; // Accumulate sw signals
-        for (unsigned int chan = 0; chan < m_numChnls; chan++) {
-            double gain = master_gain * m_gains[chan];
-            double filt_temp;
-
-            switch (m_BassManagementMode) {
-            case BASSMODE_NONE:
-                break;
-            case BASSMODE_MIX:
-                filt_low = io.out(chan);
-                break;
-            case BASSMODE_LOWPASS:
-                filt_temp = m_lopass1[chan](io.out(chan));
-                filt_low = m_lopass1[chan](filt_temp);
-                break;
-            case BASSMODE_HIGHPASS:
-                filt_temp = m_hipass1[chan](io.out(chan));
-                filt_out = m_hipass1[chan](filt_temp);
-                io.out(chan) = filt_out;
-                break;
-            case BASSMODE_FULL:
-                filt_temp = m_lopass1[chan](io.out(chan));
-                filt_low = m_lopass1[chan](filt_temp);
-                filt_temp = m_hipass1[chan](io.out(chan));
-                filt_out = m_hipass1[chan](filt_temp);
-                io.out(chan) = filt_out;
-                break;
-            default:
-                filt_low = 0.0;
-                break;
-            }
-            bassbuf += filt_low;
-            io.out(chan) *= gain;
-            if (m_clipperOn && io.out(chan) > master_gain) {
-                io.out(chan) = master_gain;
-            }
-        }
-        if (m_BassManagementMode != BASSMODE_NONE) {
-            int sw;
-            for(sw = 0; sw < 4; sw++) {
-                if (swIndex[sw] < 0) continue;
-                io.out(swIndex[sw]) = bassbuf * m_gains[swIndex[sw]];
-            }
-        }
-        if (m_meterOn) {
-            for (unsigned int chan = 0; chan < m_numChnls; chan++) {
-                float out = io.out(chan);
-                float absValue = fabs(out);
-                if (m_meterMax[chan] < absValue) {
-                    m_meterMax[chan] = absValue;
-                }
-            }
-            m_meterCounter++;
-            if (m_meterCounter >= m_meterUpdateSamples) {
-                m_meterBuffer.write(m_meterMax.data());
-                m_meterCounter = m_meterCounter - m_meterUpdateSamples;
-                for (unsigned int chan = 0; chan < m_numChnls; chan++) {
-                    m_meterMax[chan] = 0.0;
-                }
-            }
-        }
+	// The filter banks process all channels a block at a time, so the bass
+	// signal is computed for a chunk of frames before gains are applied
+	for (unsigned int offset = 0; offset < nframes; offset += BASS_CHUNK) {
+		unsigned int frames = std::min(BASS_CHUNK, nframes - offset);
+		for (unsigned int chan = 0; chan < m_numChnls; chan++) {
+			m_chunkOut[chan] = io.outBuffer(chan) + offset;
+		}
+		double *bassbuf = m_bassBuffer.data(); // Accumulate sw signals
+		std::fill_n(bassbuf, frames, 0.0);
+
+		switch (m_BassManagementMode) {
+		case BASSMODE_NONE:
+			break;
+		case BASSMODE_MIX:
+			for (unsigned int chan = 0; chan < m_numChnls; chan++) {
+				for (unsigned int i = 0; i < frames; i++) {
+					bassbuf[i] += m_chunkOut[chan][i];
+				}
+			}
+			break;
+		case BASSMODE_LOWPASS:
+		case BASSMODE_FULL:
+			m_lowpass.process(m_chunkOut.data(), m_chunkLow.data(), m_numChnls, frames);
+			for (unsigned int chan = 0; chan < m_numChnls; chan++) {
+				for (unsigned int i = 0; i < frames; i++) {
+					bassbuf[i] += m_chunkLow[chan][i];
+				}
+			}
+			if (m_BassManagementMode == BASSMODE_FULL) {
+				m_highpass.process(m_chunkOut.data(), m_chunkOut.data(), m_numChnls, frames);
+			}
+			break;
+		case BASSMODE_HIGHPASS:
+			m_highpass.process(m_chunkOut.data(), m_chunkOut.data(), m_numChnls, frames);
+			break;
+		default:
+			break;
+		}
+		for (unsigned int chan = 0; chan < m_numChnls; chan++) {
+			double gain = master_gain * m_gains[chan];
+			float *out = m_chunkOut[chan];
+			for (unsigned int i = 0; i < frames; i++) {
+				out[i] *= gain;
+				if (m_clipperOn && out[i] > master_gain) {
+					out[i] = master_gain;
+				}
+			}
+		}
+		if (m_BassManagementMode != BASSMODE_NONE) {
+			int sw;
+			for(sw = 0; sw < 4; sw++) {
+				if (swIndex[sw] < 0) continue;
+				float *out = m_chunkOut[swIndex[sw]];
+				for (unsigned int i = 0; i < frames; i++) {
+					out[i] = bassbuf[i] * m_gains[swIndex[sw]];
+				}
+			}
+		}
+		if (m_meterOn) {
+			for (unsigned int i = 0; i < frames; i++) {
+				for (unsigned int chan = 0; chan < m_numChnls; chan++) {
+					float absValue = fabs(m_chunkOut[chan][i]);
+					if (m_meterMax[chan] < absValue) {
+						m_meterMax[chan] = absValue;
+					}
+				}
+				m_meterCounter++;
+				if (m_meterCounter >= m_meterUpdateSamples) {
+					m_meterBuffer.write(m_meterMax.data());
+					m_meterCounter = m_meterCounter - m_meterUpdateSamples;
+					for (unsigned int chan = 0; chan < m_numChnls; chan++) {
+						m_meterMax[chan] = 0.0;
+					}
+				}
+			}
+		}
 	}
 }
 
@@ -271,10 +259,15 @@ void OutputMaster::allocateChannels(unsigned int numChnls)
 	m_meterBuffer.setSize(numChnls);
     m_meterMax.resize(numChnls);
 
-	m_lopass1.resize(numChnls);
-	m_lopass2.resize(numChnls);
-	m_hipass1.resize(numChnls);
-	m_hipass2.resize(numChnls);
+	m_lowpass.resize(numChnls, 2);
+	m_highpass.resize(numChnls, 2);
+	m_lowBuffers.resize(numChnls * BASS_CHUNK);
+	m_bassBuffer.resize(BASS_CHUNK);
+	m_chunkOut.resize(numChnls);
+	m_chunkLow.resize(numChnls);
+	for (unsigned int i = 0; i < numChnls; i++) {
+		m_chunkLow[i] = m_lowBuffers.data() + i * BASS_CHUNK;
+	}
 	swIndex[0] = numChnls - 1;
 	swIndex[1] =  swIndex[2] = swIndex[3] = -1;
 
@@ -26,6 +26,7 @@ void OSCNotifier::notifyListeners(std::string OSCaddress, float value)
         sender->send(OSCaddress, value);
 //		std::cout << "Notifying " << sender->address() << ":" << sender->port() << " -- " << OSCaddress << std::endl;
     }
+    notifySharedMemory(OSCaddress, value);
     mListenerLock.unlock();
 }
 
@@ -36,6 +37,7 @@ void OSCNotifier::notifyListeners(std::string OSCaddress, int value)
         sender->send(OSCaddress, value);
 //        std::cout << "Notifying " << sender->address() << ":" << sender->port() << " -- " << OSCaddress << std::endl;
     }
+    notifySharedMemory(OSCaddress, value);
     mListenerLock.unlock();
 }
 
@@ -46,6 +48,7 @@ void OSCNotifier::notifyListeners(std::string OSCaddress, std::string value)
         sender->send(OSCaddress, value);
         std::cout << "Notifying " << sender->address() << ":" << sender->port() << " -- " << OSCaddress << std::endl;
     }
+    notifySharedMemory(OSCaddress, value);
     mListenerLock.unlock();
 }
 
@@ -56,6 +59,7 @@ void OSCNotifier::notifyListeners(std::string OSCaddress, Vec3f value)
         sender->send(OSCaddress, value[0], value[1], value[2]);
 //		std::cout << "Notifying " << sender->address() << ":" << sender->port() << " -- " << OSCaddress << std::endl;
     }
+    notifySharedMemory(OSCaddress, value[0], value[1], value[2]);
     mListenerLock.unlock();
 }
 
@@ -66,6 +70,7 @@ void OSCNotifier::notifyListeners(std::string OSCaddress, Vec4f value)
                 sender->send(OSCaddress, value[0], value[1], value[2], value[3]);
 //		std::cout << "Notifying " << sender->address() << ":" << sender->port() << " -- " << OSCaddress << std::endl;
     }
+    notifySharedMemory(OSCaddress, value[0], value[1], value[2], value[3]);
     mListenerLock.unlock();
 }
 
@@ -77,6 +82,8 @@ void OSCNotifier::notifyListeners(std::string OSCaddress, Pose value)
                 (float) value.quat().w, (float) value.quat().x, (float) value.quat().y, (float) value.quat().z);
 //		std::cout << "Notifying " << sender->address() << ":" << sender->port() << " -- " << OSCaddress << std::endl;
     }
+    notifySharedMemory(OSCaddress, (float) value.pos()[0], (float) value.pos()[1], (float) value.pos()[2],
+            (float) value.quat().w, (float) value.quat().x, (float) value.quat().y, (float) value.quat().z);
     mListenerLock.unlock();
 }
 
@@ -87,6 +94,7 @@ void OSCNotifier::notifyListeners(std::string OSCaddress, Color value)
         sender->send(OSCaddress, float(value.r), float(value.g), float(value.b));
 //		std::cout << "Notifying " << sender->address() << ":" << sender->port() << " -- " << OSCaddress << std::endl;
     }
+    notifySharedMemory(OSCaddress, float(value.r), float(value.g), float(value.b));
     mListenerLock.unlock();
 }
 
@@ -1,14 +1,323 @@
 
+#include <atomic>
 #include <cmath>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
 
 #include "catch.hpp"
 
 #include "al/core/io/al_AudioIO.hpp"
+#include "al/core/io/al_AudioOutputStage.hpp"
 #include "al/core/system/al_Time.hpp"
 
 
 using namespace al;
 
+// Reference for AudioOutputStage, equivalent to the separate passes the
+// backends used to make
+static float referenceSample(int flags, float s, float gain) {
+    if (flags & AudioOutputStage::GAIN) s *= gain;
+    if ((flags & AudioOutputStage::ZERO_NANS) && s != s) s = 0.f;
+    if (flags & AudioOutputStage::CLIP) {
+        if (s < -1.f) s = -1.f;
+        else if (s > 1.f) s = 1.f;
+    }
+    return s;
+}
+
+static bool sameSample(float a, float b) {
+    if (a != a || b != b) return a != a && b != b;
+    return std::abs(a - b) <= 1e-5f;
+}
+
+TEST_CASE( "Audio output stage" ) {
+    for (int channels : {1, 2, 3, 4, 5, 6, 8, 9, 16}) {
+        for (int frames : {1, 3, 4, 7, 64, 67}) {
+            std::vector<float> src(channels * frames);
+            for (size_t i = 0; i < src.size(); i++) {
+                src[i] = 3.f * std::sin(0.37f * i);
+            }
+            src[src.size() / 2] = NAN;
+            src[src.size() - 1] = NAN;
+            std::vector<float> srcCopy = src;
+
+            for (int flags = 0; flags < 8; flags++) {
+                float gainStart = 0.5f, gainEnd = 1.5f;
+                float dgain = (gainEnd - gainStart) / frames;
+                std::vector<float> interleaved(channels * frames);
+                std::vector<float> planar(channels * frames);
+                std::vector<float *> planarPointers;
+                for (int c = 0; c < channels; c++) {
+                    planarPointers.push_back(planar.data() + c * frames);
+                }
+                AudioOutputStage::interleave(flags, src.data(), interleaved.data(),
+                                             channels, frames, gainStart, gainEnd);
+                AudioOutputStage::planar(flags, src.data(), planarPointers.data(),
+                                         channels, frames, gainStart, gainEnd);
+                bool ok = true;
+                for (int f = 0; f < frames; f++) {
+                    for (int c = 0; c < channels; c++) {
+                        float expected = referenceSample(flags, src[c * frames + f],
+                                                         gainStart + dgain * f);
+                        ok = ok && sameSample(interleaved[f * channels + c], expected);
+                        ok = ok && sameSample(planar[c * frames + f], expected);
+                    }
+                }
+                REQUIRE(ok);
+            }
+            REQUIRE(memcmp(src.data(), srcCopy.data(), src.size() * sizeof(float)) == 0);
+
+            std::vector<float> deinterleaved(channels * frames);
+            AudioOutputStage::deinterleave(src.data(), deinterleaved.data(), channels, frames);
+            bool ok = true;
+            for (int f = 0; f < frames; f++) {
+                for (int c = 0; c < channels; c++) {
+                    ok = ok && sameSample(deinterleaved[c * frames + f], src[f * channels + c]);
+                }
+            }
+            REQUIRE(ok);
+        }
+    }
+}
+
+static void offlineRampCallback(AudioIOData &io) {
+    static int sample = 0;
+    while (io()) {
+        float value = (sample++ % 1000) / 1000.0f;
+        io.out(0) = value;
+        io.out(1) = -0.5f * value;
+    }
+}
+
+static void offlineThroughCallback(AudioIOData &io) {
+    while (io()) {
+        io.out(0) = io.in(0);
+    }
+}
+
+static std::vector<char> readFile(const std::string &path) {
+    std::vector<char> data;
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f) {
+        char buffer[4096];
+        size_t bytes;
+        while ((bytes = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+            data.insert(data.end(), buffer, buffer + bytes);
+        }
+        fclose(f);
+    }
+    return data;
+}
+
+TEST_CASE( "Offline audio render" ) {
+    const char *outputFile = "test_offline.wav";
+    {
+        AudioIO io;
+        OfflineAudioConfig config;
+        config.duration = 2.0;
+        config.outputFile = outputFile;
+        io.offline(config);
+        io.init(offlineRampCallback, nullptr, 256, 44100, 2, 0);
+        REQUIRE(io.offline());
+        REQUIRE(io.channelsOutDevice() == 2);
+        REQUIRE(io.open());
+        REQUIRE(io.start());
+        REQUIRE(io.offlineBackend().wait());
+        REQUIRE(!io.isRunning());
+        REQUIRE(io.offlineBackend().framesRendered() == 88200);
+        REQUIRE(io.time() == Approx(2.0));
+        REQUIRE(io.offlineBackend().realtimeFactor() > 1.0);
+        io.close();
+    }
+    std::vector<char> data = readFile(outputFile);
+    REQUIRE(data.size() == 68 + 88200 * 2 * sizeof(float));
+    REQUIRE(memcmp(data.data(), "RIFF", 4) == 0);
+    REQUIRE(memcmp(data.data() + 60, "data", 4) == 0);
+    uint32_t dataBytes;
+    memcpy(&dataBytes, data.data() + 64, 4);
+    REQUIRE(dataBytes == 88200 * 2 * sizeof(float));
+    const float *samples = (const float *)(data.data() + 68);
+    bool ok = true;
+    for (int i = 0; i < 88200; i++) {
+        float value = (i % 1000) / 1000.0f;
+        ok = ok && samples[2 * i] == value && samples[2 * i + 1] == -0.5f * value;
+    }
+    REQUIRE(ok);
+    std::remove(outputFile);
+}
+
+TEST_CASE( "Offline audio input file" ) {
+    const char *inputFile = "test_offline_in.raw";
+    const char *outputFile = "test_offline_out.raw";
+    std::vector<float> input(1000);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = 0.9f * std::sin(0.1f * i);
+    }
+    FILE *f = fopen(inputFile, "wb");
+    REQUIRE(f);
+    fwrite(input.data(), sizeof(float), input.size(), f);
+    fclose(f);
+
+    {
+        AudioIO io;
+        OfflineAudioConfig config;
+        config.duration = 2048 / 44100.0;
+        config.inputFile = inputFile;
+        config.outputFile = outputFile;
+        io.offline(config);
+        io.init(offlineThroughCallback, nullptr, 64, 44100, 1, 1);
+        REQUIRE(io.channelsInDevice() == 1);
+        REQUIRE(io.start());
+        REQUIRE(io.offlineBackend().wait());
+        io.close();
+    }
+    std::vector<char> data = readFile(outputFile);
+    REQUIRE(data.size() == 2048 * sizeof(float));
+    const float *samples = (const float *)data.data();
+    bool ok = true;
+    for (size_t i = 0; i < 2048; i++) {
+        ok = ok && samples[i] == (i < input.size() ? input[i] : 0.0f); // Silence after input ends
+    }
+    REQUIRE(ok);
+    std::remove(inputFile);
+    std::remove(outputFile);
+}
+
+static int profilerSection = -1;
+
+static void profiledCallback(AudioIOData &io) {
+    static int buffer = 0;
+    AudioSectionTimer timer(io.profiler(), profilerSection);
+    if (buffer++ < 5) {
+        // Miss the deadline (64 frames at 44100 is 1.45 ms)
+        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    }
+    while (io()) {
+        io.out(0) = 0.1f;
+    }
+}
+
+TEST_CASE( "Audio callback profiler" ) {
+    AudioIO io;
+    REQUIRE(io.profiler() != nullptr);
+    AudioCallbackProfiler &profiler = *io.profiler();
+    REQUIRE(!profiler.enabled());
+    profilerSection = profiler.addSection("test");
+    REQUIRE(profilerSection == AudioCallbackProfiler::NUM_BUILTIN_SECTIONS);
+
+    OfflineAudioConfig config;
+    config.duration = 6400 / 44100.0;
+    io.offline(config);
+    io.init(profiledCallback, nullptr, 64, 44100, 1, 0);
+    profiler.enable();
+    io.start();
+    io.offlineBackend().wait();
+    io.close();
+
+    auto stats = profiler.stats();
+    REQUIRE(stats.callbacks == 100);
+    REQUIRE(stats.lateCallbacks >= 5);
+    REQUIRE(stats.maxLoad > 1.0);
+    uint64_t histogramTotal = 0;
+    uint64_t histogramLate = 0;
+    for (size_t i = 0; i < stats.histogram.size(); i++) {
+        histogramTotal += stats.histogram[i];
+        if (i >= 20) histogramLate += stats.histogram[i];
+    }
+    REQUIRE(histogramTotal == 100);
+    REQUIRE(histogramLate >= 5);
+    REQUIRE(stats.sections.size() == AudioCallbackProfiler::NUM_BUILTIN_SECTIONS + 1);
+    REQUIRE(stats.sections[AudioCallbackProfiler::VOICES].callbacks == 0);
+    REQUIRE(stats.sections[profilerSection].name == "test");
+    REQUIRE(stats.sections[profilerSection].callbacks == 100);
+    REQUIRE(stats.sections[profilerSection].maxSeconds >= 0.003);
+
+    REQUIRE(stats.xruns == 0);
+    for (int i = 0; i < 100; i++) {
+        io.reportUnderflow();
+    }
+    REQUIRE(io.underflows() == 100);
+    stats = profiler.stats();
+    REQUIRE(stats.xruns == 100);
+    REQUIRE(stats.xrunTimes.size() == AudioCallbackProfiler::maxXrunTimes);
+    REQUIRE(stats.xrunTimes.front() <= stats.xrunTimes.back());
+
+    profiler.reset();
+    stats = profiler.stats();
+    REQUIRE(stats.callbacks == 0);
+    REQUIRE(stats.sections[profilerSection].callbacks == 0);
+
+    // Disabled profiler records nothing
+    profiler.enable(false);
+    io.processAudio();
+    REQUIRE(profiler.stats().callbacks == 0);
+
+    // The reset is applied by the next callback
+    profiler.enable();
+    io.processAudio();
+    REQUIRE(profiler.stats().callbacks == 1);
+}
+
+class ProfilerStatsHandler : public osc::PacketHandler {
+public:
+    void onMessage(osc::Message &m) override {
+        if (m.addressPattern() == "/profiler/callbacks") {
+            received++;
+        } else if (m.addressPattern() == "/fence/callbacks") {
+            fences++;
+        }
+    }
+    std::atomic<int> received {0};
+    std::atomic<int> fences {0};
+};
+
+TEST_CASE( "Audio callback profiler replies only to allowed addresses" ) {
+    AudioCallbackProfiler profiler;
+    ProfilerStatsHandler handler;
+    osc::Recv server;
+    // Use the first free port, the default one may be taken
+    uint16_t port = 10830;
+    while (!server.open(port, "127.0.0.1", 0.0) && port < 10930) {
+        port++;
+    }
+    REQUIRE(server.isOpen());
+    server.handler(handler);
+    server.start();
+
+    auto request = [&](const char *sender, const char *replyTo, std::string root) {
+        osc::Packet packet;
+        packet.beginMessage(root + "/request");
+        packet << replyTo << port;
+        packet.endMessage();
+        osc::Message m(packet.data(), packet.size(), 1, sender);
+        return profiler.consumeMessage(m, root);
+    };
+    auto waitFor = [](std::atomic<int> &count, int value) {
+        al_sec start = al_steady_time();
+        while (count.load() < value && al_steady_time() - start < 5.0) {
+            al_sleep(0.001);
+        }
+        return count.load() == value;
+    };
+
+    REQUIRE(request("127.0.0.1", "127.0.0.1", "/profiler"));
+    REQUIRE(waitFor(handler.received, 1));
+
+    // Another host can't redirect the stats. Replies are sent before
+    // consumeMessage() returns, so once the reply to a later allowed
+    // request has arrived a reply to the ignored one would have too.
+    REQUIRE(request("10.0.0.9", "127.0.0.1", "/profiler"));
+    REQUIRE(request("127.0.0.1", "127.0.0.1", "/fence"));
+    REQUIRE(waitFor(handler.fences, 1));
+    REQUIRE(handler.received == 1);
+
+    profiler.replyAddress("127.0.0.1");
+    REQUIRE(request("10.0.0.9", "127.0.0.1", "/profiler"));
+    REQUIRE(waitFor(handler.received, 2));
+}
+
 #ifndef TRAVIS_BUILD
 
 TEST_CASE( "Audio Device Enum" ) {
@@ -0,0 +1,162 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "al/core/sound/al_ConvolutionReverb.hpp"
+#include "al/util/scene/al_PolySynth.hpp"
+
+using namespace al;
+
+static std::vector<float> randomSignal(size_t length, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(-1, 1);
+    std::vector<float> signal(length);
+    for (auto &s : signal) s = uniform(rng);
+    return signal;
+}
+
+static std::vector<float> directConvolution(const std::vector<float> &x,
+                                            const std::vector<float> &h) {
+    std::vector<float> y(x.size(), 0.0f);
+    for (size_t n = 0; n < x.size(); n++) {
+        double sum = 0;
+        for (size_t k = 0; k < h.size() && k <= n; k++) {
+            sum += double(h[k]) * x[n - k];
+        }
+        y[n] = float(sum);
+    }
+    return y;
+}
+
+static float maxDifference(const std::vector<float> &a, const std::vector<float> &b) {
+    float diff = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        diff = std::max(diff, std::fabs(a[i] - b[i]));
+    }
+    return diff;
+}
+
+// Convolves two channels of noise in blocks, returning the output
+static std::vector<std::vector<float>> convolveNoise(ConvolutionReverb &reverb,
+                                                     size_t length, unsigned int blockSize) {
+    std::vector<std::vector<float>> signals = {randomSignal(length, 1), randomSignal(length, 2)};
+    for (size_t offset = 0; offset < length; offset += blockSize) {
+        float *buffers[2] = {signals[0].data() + offset, signals[1].data() + offset};
+        REQUIRE(reverb.process(buffers, 2, blockSize));
+    }
+    return signals;
+}
+
+TEST_CASE( "ConvolutionReverb matches direct convolution" ) {
+    // Lengths that are not a multiple of the partition size
+    const uint32_t irLength = 1000;
+    std::vector<float> irLeft = randomSignal(irLength, 3);
+    std::vector<float> irRight = randomSignal(irLength, 4);
+    for (uint32_t i = 0; i < irLength; i++) {
+        float decay = std::exp(-5.0f * i / irLength);
+        irLeft[i] *= decay;
+        irRight[i] *= decay;
+    }
+    const size_t length = 64 * 60;
+    std::vector<float> expectedLeft = directConvolution(randomSignal(length, 1), irLeft);
+    std::vector<float> expectedRight = directConvolution(randomSignal(length, 2), irRight);
+
+    // All partitions in the calling thread, and the tail in the worker
+    for (bool tailThread : {false, true}) {
+        ConvolutionReverb reverb;
+        REQUIRE(reverb.configure(64, {irLeft.data(), irRight.data()}, irLength, tailThread, 2));
+        REQUIRE(reverb.numChannels() == 2);
+        REQUIRE(reverb.numPartitions() == 16);
+        REQUIRE(reverb.headPartitions() == (tailThread ? 2u : 16u));
+
+        // Several partitions per call
+        auto output = convolveNoise(reverb, length, 128);
+        REQUIRE(maxDifference(output[0], expectedLeft) < 1e-4f);
+        REQUIRE(maxDifference(output[1], expectedRight) < 1e-4f);
+
+        // Starts again from silence
+        reverb.reset();
+        output = convolveNoise(reverb, length, 64);
+        REQUIRE(maxDifference(output[0], expectedLeft) < 1e-4f);
+        if (!tailThread) {
+            REQUIRE(reverb.lateTails() == 0);
+        }
+    }
+}
+
+TEST_CASE( "ConvolutionReverb parameters" ) {
+    std::vector<float> ir(100, 0.0f);
+    ir[3] = 0.5f;
+    ConvolutionReverb reverb;
+    REQUIRE(!reverb.configure(100, {ir.data()}, 100));
+    REQUIRE(!reverb.configure(64, {}, 100));
+    std::vector<float> buffer(64, 1.0f);
+    float *buffers[1] = {buffer.data()};
+    REQUIRE(!reverb.process(buffers, 1, 64));
+
+    // Channels share an IR, and blocks must be whole partitions
+    REQUIRE(reverb.configure(32, {ir.data(), ir.data()}, 100));
+    REQUIRE(reverb.numChannels() == 2);
+    REQUIRE(!reverb.process(buffers, 1, 48));
+    REQUIRE(buffer[0] == 1.0f);
+    AudioIOData io;
+    io.framesPerBuffer(48);
+    io.channelsOut(1);
+    io.outBuffer(0)[0] = 1.0f;
+    reverb.onAudioCB(io);  // Reports the error
+    reverb.onAudioCB(io);
+    REQUIRE(io.outBuffer(0)[0] == 1.0f);
+
+    // Dry and wet mix
+    reverb.dry(0.25f);
+    reverb.wet(2.0f);
+    REQUIRE(reverb.process(buffers, 1, 64));
+    REQUIRE(buffer[0] == Approx(0.25f));
+    REQUIRE(buffer[3] == Approx(1.25f).margin(1e-5));
+    REQUIRE(buffer[63] == Approx(1.25f).margin(1e-5));
+}
+
+class ImpulseVoice : public SynthVoice {
+public:
+    void onProcess(AudioIOData &io) override {
+        io.outBuffer(0)[0] += 1.0f;
+        io.outBuffer(1)[0] += 0.5f;
+        free();
+    }
+};
+
+TEST_CASE( "ConvolutionReverb in PolySynth" ) {
+    const uint32_t irLength = 300;
+    std::vector<float> ir = randomSignal(irLength, 5);
+    ConvolutionReverb reverb;
+    REQUIRE(reverb.configure(64, {ir.data(), ir.data()}, irLength));
+
+    PolySynth synth;
+    synth.allocatePolyphony<ImpulseVoice>(1);
+    synth.append(reverb);
+    synth.triggerOn(synth.getVoice<ImpulseVoice>());
+
+    AudioIOData io;
+    io.framesPerBuffer(128);
+    io.framesPerSecond(44100);
+    io.channelsIn(0);
+    io.channelsOut(2);
+    std::vector<float> left, right;
+    for (int block = 0; block < 4; block++) {
+        io.zeroOut();
+        io.frame(0);
+        synth.render(io);
+        left.insert(left.end(), io.outBuffer(0), io.outBuffer(0) + 128);
+        right.insert(right.end(), io.outBuffer(1), io.outBuffer(1) + 128);
+    }
+    // The impulse response of each channel
+    bool match = true;
+    for (uint32_t i = 0; i < left.size(); i++) {
+        float expected = i < irLength ? ir[i] : 0.0f;
+        match &= std::fabs(left[i] - expected) < 1e-5f;
+        match &= std::fabs(right[i] - 0.5f * expected) < 1e-5f;
+    }
+    REQUIRE(match);
+}
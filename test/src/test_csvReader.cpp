@@ -0,0 +1,71 @@
+#include <cstdio>
+
+#include "catch.hpp"
+
+#include "al/core/io/al_CSVReader.hpp"
+
+typedef struct {
+    char s[32];
+    int64_t id;
+    double x, y;
+    bool b;
+} CSVTestRow;
+
+TEST_CASE( "CSVReader parallel parsing" ) {
+    std::string fileName = "test_csvreader.csv";
+    const int numRows = 100000; // Large enough to be split in chunks
+    FILE *f = fopen(fileName.c_str(), "w");
+    REQUIRE(f);
+    fprintf(f, "name,id,x,y,flag\r\n");
+    for (int i = 0; i < numRows; i++) {
+        fprintf(f, "row%d,%d,%.17g,%.4f,%s\r\n", i, -i, i * 0.1, i * 0.25,
+                (i % 2) ? "True" : "False");
+        if (i == 10) {
+            fprintf(f, "\n"); // Empty lines are skipped
+        }
+    }
+    fclose(f);
+
+    for (unsigned int numThreads : {1, 4}) {
+        CSVReader reader;
+        reader.setNumThreads(numThreads);
+        reader.addType(CSVReader::STRING);
+        reader.addType(CSVReader::INTEGER);
+        reader.addType(CSVReader::REAL);
+        reader.addType(CSVReader::REAL);
+        reader.addType(CSVReader::BOOLEAN);
+        REQUIRE(reader.readFile(fileName));
+
+        auto names = reader.getColumnNames();
+        REQUIRE(names.size() == 5);
+        REQUIRE(names[0] == "name");
+        REQUIRE(names[4] == "flag");
+        REQUIRE(reader.numRows() == numRows);
+
+        auto x = reader.getColumn(2);
+        auto y = reader.getColumn(3);
+        auto ids = reader.getIntegerColumn(1);
+        auto flags = reader.getBooleanColumn(4);
+        REQUIRE(x.size() == numRows);
+        REQUIRE(reader.getColumn(1).empty());
+        for (int i = 0; i < numRows; i++) {
+            REQUIRE(x[i] == i * 0.1);
+            REQUIRE(y[i] == i * 0.25);
+            REQUIRE(ids[i] == -i);
+            REQUIRE(flags[i] == (i % 2 == 1));
+            REQUIRE(std::string(reader.getString(0, i)) == "row" + std::to_string(i));
+        }
+
+        std::vector<double> copy = reader.getColumn(3);
+        REQUIRE(copy.size() == numRows);
+
+        auto rows = reader.copyToStruct<CSVTestRow>();
+        REQUIRE(rows.size() == numRows);
+        REQUIRE(std::string(rows[12345].s) == "row12345");
+        REQUIRE(rows[12345].id == -12345);
+        REQUIRE(rows[12345].x == 12345 * 0.1);
+        REQUIRE(rows[12345].y == 12345 * 0.25);
+        REQUIRE(rows[12345].b);
+    }
+    std::remove(fileName.c_str());
+}
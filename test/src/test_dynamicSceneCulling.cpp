@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cmath>
+
+#include "catch.hpp"
+
+#include "al/util/al_Frustum.hpp"
+#include "al/util/scene/al_DynamicScene.hpp"
+
+using namespace al;
+
+class CulledVoice : public PositionedVoice {
+public:
+    virtual void update(double dt) override { updates++; }
+    int updates {0};
+};
+
+class UnpositionedVoice : public SynthVoice {
+public:
+    virtual void update(double dt) override { updates++; }
+    int updates {0};
+};
+
+TEST_CASE( "Frustum from projection matrix" ) {
+    Matrix4f projection = Matrix4f::perspective(90.0f, 1.0f, 0.1f, 100.0f);
+    Frustumf frustum;
+    frustum.fromMatrix(projection);
+
+    REQUIRE(frustum.testPoint(Vec3f(0, 0, -1)) == Frustumf::INSIDE);
+    REQUIRE(frustum.testPoint(Vec3f(0, 0, 1)) == Frustumf::OUTSIDE);     // Behind
+    REQUIRE(frustum.testPoint(Vec3f(0, 0, -0.05f)) == Frustumf::OUTSIDE); // Before near plane
+    REQUIRE(frustum.testPoint(Vec3f(0, 0, -200)) == Frustumf::OUTSIDE);  // Beyond far plane
+    REQUIRE(frustum.testPoint(Vec3f(0.9f, 0, -1)) == Frustumf::INSIDE);  // 90 degree field of view
+    REQUIRE(frustum.testPoint(Vec3f(1.1f, 0, -1)) == Frustumf::OUTSIDE);
+    REQUIRE(frustum.testPoint(Vec3f(0, -1.1f, -1)) == Frustumf::OUTSIDE);
+
+    REQUIRE(frustum.testSphere(Vec3f(1.1f, 0, -1), 0.5f) == Frustumf::INTERSECT);
+    REQUIRE(frustum.testSphere(Vec3f(0, 0, -10), 1.0f) == Frustumf::INSIDE);
+
+    // Corners
+    REQUIRE(frustum.ntl.z == Approx(-0.1f));
+    REQUIRE(frustum.ntl.x == Approx(-0.1f));
+    REQUIRE(frustum.ntl.y == Approx(0.1f));
+    REQUIRE(frustum.fbr.z == Approx(-100.0f).epsilon(1e-4));
+    REQUIRE(frustum.fbr.x == Approx(100.0f).epsilon(1e-4));
+    REQUIRE(frustum.fbr.y == Approx(-100.0f).epsilon(1e-4));
+}
+
+TEST_CASE( "Dynamic Scene graphics culling" ) {
+    DynamicScene scene(0, PolySynth::TIME_MASTER_ASYNC);
+
+    CulledVoice *front = scene.getVoice<CulledVoice>();
+    front->pose().pos() = Vec3d(0, 0, -5);
+    CulledVoice *behind = scene.getVoice<CulledVoice>();
+    behind->pose().pos() = Vec3d(0, 0, 5);
+    CulledVoice *far = scene.getVoice<CulledVoice>();
+    far->pose().pos() = Vec3d(0, 0, -500);
+    CulledVoice *edge = scene.getVoice<CulledVoice>(); // Center outside, but its size reaches into view
+    edge->pose().pos() = Vec3d(6, 0, -5);
+    edge->size() = 2.0f;
+    UnpositionedVoice *unpositioned = scene.getVoice<UnpositionedVoice>();
+    REQUIRE(front->isPositioned());
+    REQUIRE(!unpositioned->isPositioned());
+
+    scene.triggerOn(front);
+    scene.triggerOn(behind);
+    scene.triggerOn(far);
+    scene.triggerOn(edge);
+    scene.triggerOn(unpositioned);
+    scene.update(0.1); // Moves triggered voices to the active list
+
+    Matrix4f view = Matrix4f::identity();
+    Matrix4f projection = Matrix4f::perspective(90.0f, 1.0f, 0.1f, 1000.0f);
+    auto visible = [&](SynthVoice *voice) {
+        auto &voices = scene.visibleVoices();
+        return std::find(voices.begin(), voices.end(), voice) != voices.end();
+    };
+
+    scene.setFrustumCulling(true);
+    scene.cullVoices(view, projection);
+    REQUIRE(visible(front));
+    REQUIRE(!visible(behind));
+    REQUIRE(visible(far));
+    REQUIRE(visible(edge));
+    REQUIRE(visible(unpositioned));
+    REQUIRE(scene.visibleVoices().size() == 4);
+
+    // Turn the view around
+    view = Matrix4f::rotate(M_PI, 0, 1, 0);
+    scene.cullVoices(view, projection);
+    REQUIRE(!visible(front));
+    REQUIRE(visible(behind));
+    REQUIRE(visible(unpositioned));
+    view = Matrix4f::identity();
+
+    scene.setMaxDrawDistance(100);
+    scene.cullVoices(view, projection);
+    REQUIRE(!visible(far));
+    REQUIRE(visible(front));
+
+    // LOD callback receives the distance and can reject voices
+    std::vector<float> distances;
+    scene.setLodCallback([&](PositionedVoice &voice, float distance) {
+        distances.push_back(distance);
+        return &voice != front;
+    });
+    scene.resetCullingStats();
+    scene.cullVoices(view, projection);
+    REQUIRE(!visible(front));
+    REQUIRE(visible(edge));
+    REQUIRE(distances.size() == 2); // front and edge
+    REQUIRE(distances[0] + distances[1] == Approx(5.0f + std::sqrt(61.0f)));
+
+    auto stats = scene.cullingStats();
+    REQUIRE(stats.tested == 4);
+    REQUIRE(stats.frustumCulled == 1);
+    REQUIRE(stats.distanceCulled == 1);
+    REQUIRE(stats.lodCulled == 1);
+    REQUIRE(stats.drawn == 2);
+
+    // Culled voices are still updated
+    scene.update(0.1);
+    REQUIRE(front->updates == 2);
+    REQUIRE(behind->updates == 2);
+    REQUIRE(far->updates == 2);
+    REQUIRE(unpositioned->updates == 2);
+}
@@ -0,0 +1,200 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "al/core/sound/al_Crossover.hpp"
+#include "al/core/sound/al_FilterBank.hpp"
+#include "al/core/sound/al_Reverb.hpp"
+#include "al/util/sound/al_OutputMaster.hpp"
+
+using namespace al;
+
+static std::vector<float> randomSignal(size_t length, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(-1, 1);
+    std::vector<float> signal(length);
+    for (auto &s : signal) s = uniform(rng);
+    return signal;
+}
+
+// Block sizes that make runs end at every kind of position
+static const int blockSizes[] = {1, 7, 64, 333, 1, 1024, 5, 4099};
+
+TEST_CASE("Reverb block processing") {
+    size_t length = 0;
+    for (int n : blockSizes) length += n;
+    std::vector<float> in = randomSignal(length, 1);
+
+    Reverb<float> perSample, block;
+    perSample.decay(0.9f).damping(0.3f);
+    block.decay(0.9f).damping(0.3f);
+
+    std::vector<float> out1(length), out2(length);
+    size_t offset = 0;
+    for (int n : blockSizes) {
+        block.process(in.data() + offset, out1.data() + offset, out2.data() + offset, n, 0.5f);
+        offset += n;
+    }
+    for (size_t i = 0; i < length; i++) {
+        float o1, o2;
+        perSample(in[i], o1, o2, 0.5f);
+        REQUIRE(out1[i] == o1);
+        REQUIRE(out2[i] == o2);
+    }
+}
+
+TEST_CASE("Crossover block processing") {
+    std::vector<float> in = randomSignal(1000, 2);
+    Crossover<float> perSample(300, 44100), block(300, 44100);
+    std::vector<float> lo(in.size()), hi(in.size());
+    block.process(in.data(), lo.data(), hi.data(), 500);
+    block.process(in.data() + 500, lo.data() + 500, hi.data() + 500, 500);
+    for (size_t i = 0; i < in.size(); i++) {
+        float l, h;
+        perSample.next(in[i], &l, &h);
+        REQUIRE(lo[i] == l);
+        REQUIRE(hi[i] == h);
+    }
+}
+
+// Every instruction set must give the same output as the per-sample filters,
+// including channel counts that leave groups partially filled
+TEST_CASE("CrossoverBank") {
+    const unsigned int numChannels = 13;
+    const unsigned int numFrames = 300;
+    for (const char *name : FilterBank::instructionSets()) {
+        INFO(name);
+        REQUIRE(FilterBank::useInstructionSet(name));
+        CrossoverBank bank(numChannels);
+        std::vector<Crossover<float>> reference(numChannels);
+        std::vector<std::vector<float>> in, lo, hi;
+        std::vector<const float *> inPtrs;
+        std::vector<float *> loPtrs, hiPtrs;
+        for (unsigned int c = 0; c < numChannels; c++) {
+            bank.freq(c, 100.0f + 50.0f * c, 48000.0f);
+            reference[c].freq(100.0f + 50.0f * c, 48000.0f);
+            in.push_back(randomSignal(numFrames, 10 + c));
+            lo.emplace_back(numFrames);
+            hi.emplace_back(numFrames);
+        }
+        for (unsigned int c = 0; c < numChannels; c++) {
+            inPtrs.push_back(in[c].data());
+            loPtrs.push_back(lo[c].data());
+            hiPtrs.push_back(hi[c].data());
+        }
+        // Processing fewer channels must leave the others untouched
+        bank.process(inPtrs.data(), loPtrs.data(), hiPtrs.data(), numChannels - 2, 100);
+        for (unsigned int c = numChannels - 2; c < numChannels; c++) {
+            for (unsigned int i = 0; i < 100; i++) {
+                bank.next(c, in[c][i], lo[c][i], hi[c][i]);
+            }
+        }
+        for (unsigned int c = 0; c < numChannels; c++) {
+            loPtrs[c] += 100;
+            hiPtrs[c] += 100;
+            inPtrs[c] += 100;
+        }
+        bank.process(inPtrs.data(), loPtrs.data(), hiPtrs.data(), numChannels, numFrames - 100);
+
+        for (unsigned int c = 0; c < numChannels; c++) {
+            for (unsigned int i = 0; i < numFrames; i++) {
+                float l, h;
+                reference[c].next(in[c][i], &l, &h);
+                REQUIRE(lo[c][i] == l);
+                REQUIRE(hi[c][i] == h);
+            }
+        }
+    }
+    FilterBank::useInstructionSet(FilterBank::instructionSets()[0]);
+}
+
+TEST_CASE("BiquadBank") {
+    const unsigned int numChannels = 11;
+    const unsigned int numFrames = 200;
+    std::vector<std::vector<float>> in;
+    for (unsigned int c = 0; c < numChannels; c++) {
+        in.push_back(randomSignal(numFrames, 20 + c));
+    }
+
+    std::vector<std::vector<float>> expected;
+    for (const char *name : FilterBank::instructionSets()) {
+        INFO(name);
+        REQUIRE(FilterBank::useInstructionSet(name));
+        BiquadBank bank(numChannels, 2), perSample(numChannels, 2);
+        bank.lowpass(120, 48000);
+        perSample.lowpass(120, 48000);
+        bank.coefficients(3, 1, 0.2f, 0.1f, -0.05f, -0.4f, 0.1f);
+        perSample.coefficients(3, 1, 0.2f, 0.1f, -0.05f, -0.4f, 0.1f);
+
+        std::vector<std::vector<float>> out(in);
+        std::vector<float *> ptrs;
+        for (auto &o : out) ptrs.push_back(o.data());
+        // In place
+        bank.process(ptrs.data(), ptrs.data(), numChannels, numFrames);
+        for (unsigned int c = 0; c < numChannels; c++) {
+            for (unsigned int i = 0; i < numFrames; i++) {
+                REQUIRE(out[c][i] == perSample.next(c, in[c][i]));
+            }
+        }
+        // Same results with every instruction set
+        if (expected.empty()) {
+            expected = out;
+        }
+        for (unsigned int c = 0; c < numChannels; c++) {
+            REQUIRE(out[c] == expected[c]);
+        }
+    }
+    FilterBank::useInstructionSet(FilterBank::instructionSets()[0]);
+
+    // Fourth order Linkwitz-Riley: -6 dB at the crossover frequency and the
+    // low and high pass sum to an allpass
+    const double sampleRate = 48000, freq = 1200;
+    BiquadBank lowpass(1, 2), highpass(1, 2);
+    lowpass.lowpass(freq, sampleRate);
+    highpass.highpass(freq, sampleRate);
+    double peakLow = 0, peakSum = 0;
+    for (int i = 0; i < 48000; i++) {
+        float x = std::sin(2 * M_PI * freq * i / sampleRate);
+        float low = lowpass.next(0, x);
+        float high = highpass.next(0, x);
+        if (i > 24000) {
+            peakLow = std::max(peakLow, std::fabs(double(low)));
+            peakSum = std::max(peakSum, std::fabs(double(low) + high));
+        }
+    }
+    REQUIRE(peakLow == Approx(0.5).epsilon(0.01));
+    REQUIRE(peakSum == Approx(1.0).epsilon(0.01));
+}
+
+TEST_CASE("OutputMaster bass management") {
+    const unsigned int numChannels = 6;
+    const unsigned int framesPerBuffer = 256;
+    const double sampleRate = 48000;
+    AudioIOData io;
+    io.framesPerBuffer(framesPerBuffer);
+    io.channelsOut(numChannels);
+
+    OutputMaster master(numChannels, sampleRate);
+    master.setBassManagementFreq(150);
+    master.setBassManagementMode(BASSMODE_FULL);
+    master.setClipperOn(false);
+
+    // DC goes to the subwoofer, the last channel by default, and a tone at
+    // Nyquist to the other channels
+    float sub = 0, high = 0;
+    for (int b = 0; b < 100; b++) {
+        for (unsigned int c = 0; c < numChannels; c++) {
+            float *out = io.outBuffer(c);
+            for (unsigned int i = 0; i < framesPerBuffer; i++) {
+                out[i] = 0.1f + ((i % 2) ? 0.1f : -0.1f);
+            }
+        }
+        master.onAudioCB(io);
+        sub = io.outBuffer(numChannels - 1)[framesPerBuffer - 1];
+        high = io.outBuffer(0)[framesPerBuffer - 1];
+    }
+    REQUIRE(sub == Approx(0.1 * numChannels).epsilon(0.001));
+    REQUIRE(std::fabs(high) == Approx(0.1).epsilon(0.001));
+}
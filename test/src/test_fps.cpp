@@ -0,0 +1,260 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "catch.hpp"
+
+#include "al/core/app/al_FPS.hpp"
+
+using namespace al;
+
+// Clock advanced by hand. Reading it advances it slightly, so that spin
+// loops terminate.
+struct FakeClock {
+    al_nsec time = 0;
+    al_nsec readStep = 1000;
+    al_nsec oversleep = 0;
+    al_nsec slept = 0;
+    int sleeps = 0;
+
+    al_nsec now() { return time += readStep; }
+    void sleep(al_nsec dt) {
+        slept += dt;
+        sleeps++;
+        time += dt + oversleep;
+    }
+    void install(FPS &fps) {
+        fps.timeSource([this]() { return now(); }, [this](al_nsec dt) { sleep(dt); });
+    }
+    void install(FrameProfiler &p) {
+        p.clock([this]() { return time; });
+    }
+};
+
+static const al_nsec ms = 1000000;
+
+TEST_CASE("FPS pacing with sleep and spin") {
+    FPS fps;
+    FakeClock clock;
+    clock.install(fps);
+    fps.fps(50); // 20 ms
+    fps.startFPS();
+    al_nsec frameStart = fps.start_of_loop;
+
+    // Sleep wakes up late, but the spin absorbs it
+    clock.oversleep = 200000;
+    for (int i = 0; i < 10; i++) {
+        clock.time += 5 * ms;
+        fps.tickFPS();
+        REQUIRE(fps.deltaTime == 20 * ms);
+        REQUIRE(fps.start_of_loop == frameStart + 20 * ms * (i + 1));
+        REQUIRE(clock.time >= fps.start_of_loop);
+        REQUIRE(clock.time < fps.start_of_loop + 10000);
+    }
+    REQUIRE(clock.sleeps == 10);
+    REQUIRE(fps.lateFrames() == 0);
+
+    // Without spinning, each frame ends as late as the sleep overshoots
+    fps.spinTime = 0;
+    clock.time += 5 * ms;
+    fps.tickFPS();
+    REQUIRE(clock.time >= fps.start_of_loop + 200000);
+
+    // Frames that take too long are not paced
+    fps.spinTime = 300000;
+    int sleeps = clock.sleeps;
+    al_nsec start = fps.start_of_loop;
+    clock.time = start + 30 * ms;
+    fps.tickFPS();
+    REQUIRE(clock.sleeps == sleeps);
+    REQUIRE(fps.deltaTime >= 30 * ms);
+    REQUIRE(fps.lateFrames() == 1);
+
+    // Profiler records time spent waiting
+    auto sleep = fps.profiler().stats("sleep");
+    REQUIRE(sleep.frames == 12);
+    REQUIRE(sleep.p50 == Approx(0.015).epsilon(0.01));
+    REQUIRE(sleep.max < 0.0155 + 0.0002);
+}
+
+TEST_CASE("FPS adapts target rate") {
+    FPS fps;
+    FakeClock clock;
+    clock.install(fps);
+    fps.fps(60);
+    fps.adaptiveFPS(true);
+    fps.adaptWindow = 10;
+    fps.startFPS();
+
+    auto runFrames = [&](int n, al_nsec work) {
+        for (int i = 0; i < n; i++) {
+            clock.time += work;
+            fps.tickFPS();
+        }
+    };
+
+    // Consistently late at 60 fps, so drop to 30
+    runFrames(10, 25 * ms);
+    REQUIRE(fps.fpsTarget() == 30);
+    REQUIRE(fps.interval == 33333332);
+
+    // Frames now fit, and are paced at 30 fps
+    runFrames(10, 25 * ms);
+    REQUIRE(fps.fpsTarget() == 30);
+    REQUIRE(fps.deltaTime == fps.interval);
+
+    // Occasional late frames do not change the rate
+    runFrames(7, 10 * ms);
+    runFrames(3, 40 * ms);
+    REQUIRE(fps.fpsTarget() == 30);
+
+    // Down to the lowest allowed rate
+    runFrames(40, 100 * ms);
+    REQUIRE(fps.fpsTarget() == 15);
+
+    // Recovers one step per window once frames are fast again
+    runFrames(10, 5 * ms);
+    REQUIRE(fps.fpsTarget() == 20);
+    runFrames(20, 5 * ms);
+    REQUIRE(fps.fpsTarget() == 60);
+
+    // Not adaptive: stays at the wanted rate however late
+    FPS fixed;
+    clock.install(fixed);
+    fixed.fps(60);
+    fixed.adaptWindow = 10;
+    fixed.startFPS();
+    for (int i = 0; i < 30; i++) {
+        clock.time += 25 * ms;
+        fixed.tickFPS();
+    }
+    REQUIRE(fixed.fpsTarget() == 60);
+    REQUIRE(fixed.lateFrames() == 30);
+}
+
+TEST_CASE("FrameProfiler sections and percentiles") {
+    FrameProfiler prof(100);
+    FakeClock clock;
+    clock.install(prof);
+
+    // Frame i spends i ms in "draw", with a nested "upload" of 1 ms called
+    // twice, and "animate" only in even frames
+    for (int i = 1; i <= 100; i++) {
+        if (i % 2 == 0) {
+            FrameProfiler::Scope s(prof, "animate");
+            clock.time += 2 * ms;
+        }
+        prof.begin("draw");
+        for (int k = 0; k < 2; k++) {
+            FrameProfiler::Scope s(prof, "upload");
+            clock.time += ms;
+        }
+        clock.time += (i - 2) * ms;
+        prof.end();
+        clock.time += ms;
+        prof.endFrame();
+    }
+
+    auto draw = prof.stats("draw");
+    REQUIRE(draw.frames == 100);
+    REQUIRE(draw.mean == Approx(0.0505));
+    REQUIRE(draw.p50 == Approx(0.050));
+    REQUIRE(draw.p90 == Approx(0.090));
+    REQUIRE(draw.p99 == Approx(0.099));
+    REQUIRE(draw.max == Approx(0.100));
+
+    auto upload = prof.stats("upload");
+    REQUIRE(upload.p50 == Approx(0.002));
+    REQUIRE(upload.max == Approx(0.002));
+
+    auto animate = prof.stats("animate");
+    REQUIRE(animate.mean == Approx(0.001));
+    REQUIRE(animate.p50 == 0);
+    REQUIRE(animate.max == Approx(0.002));
+
+    // Frame time is measured between frame ends
+    auto frame = prof.stats("frame");
+    REQUIRE(frame.frames == 100);
+    REQUIRE(frame.max == Approx(0.103));
+
+    REQUIRE(prof.stats().size() == 4);
+    REQUIRE(prof.stats("unknown").frames == 0);
+
+    // History is a rolling window
+    prof.historyFrames(10);
+    for (int i = 0; i < 25; i++) {
+        prof.begin("draw");
+        clock.time += (i < 15 ? 50 : 1) * ms;
+        prof.end();
+        prof.endFrame();
+    }
+    REQUIRE(prof.stats("draw").frames == 10);
+    REQUIRE(prof.stats("draw").max == Approx(0.001));
+
+    // Disabled profiler records nothing
+    prof.reset();
+    prof.enable(false);
+    prof.begin("draw");
+    clock.time += ms;
+    prof.end();
+    prof.endFrame();
+    REQUIRE(prof.stats("draw").frames == 0);
+
+    // Toggling between a nested begin() and end() keeps sections matched
+    prof.reset();
+    prof.enable(true);
+    prof.begin("draw");
+    prof.enable(false);
+    prof.begin("skipped");
+    clock.time += ms;
+    prof.end();
+    prof.enable(true);
+    clock.time += ms;
+    prof.end();
+    prof.endFrame();
+    REQUIRE(prof.stats("draw").max == Approx(0.002));
+    REQUIRE(prof.stats("skipped").frames == 0);
+}
+
+TEST_CASE("FrameProfiler Chrome trace") {
+    FrameProfiler prof;
+    FakeClock clock;
+    clock.install(prof);
+    prof.recordTrace(true, 7);
+    for (int i = 0; i < 3; i++) {
+        {
+            FrameProfiler::Scope s(prof, "draw \"main\"");
+            clock.time += 2 * ms;
+        }
+        clock.time += ms;
+        prof.endFrame();
+    }
+    // 3 sections and 2 frames, then 2 more sections limited by maxEvents
+    prof.recordTrace(true, 7);
+    {
+        FrameProfiler::Scope s(prof, "draw \"main\"");
+        clock.time += ms;
+    }
+    REQUIRE(prof.traceSize() == 6);
+
+    std::string path = "test_fps_trace.json";
+    REQUIRE(prof.writeTrace(path));
+    std::ifstream f(path);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    std::string json = ss.str();
+    REQUIRE(json.find("{\"traceEvents\":[") == 0);
+    size_t events = 0;
+    for (size_t p = json.find("\"ph\":\"X\""); p != std::string::npos;
+         p = json.find("\"ph\":\"X\"", p + 1)) {
+        events++;
+    }
+    REQUIRE(events == 6);
+    REQUIRE(json.find("\"name\":\"draw \\\"main\\\"\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                      "\"ts\":0.000,\"dur\":2000.000}") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":3000.000,"
+                      "\"dur\":3000.000}") != std::string::npos);
+    std::remove(path.c_str());
+
+    REQUIRE(!prof.writeTrace("/nonexistent_directory/trace.json"));
+}
@@ -0,0 +1,173 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "al/core/app/al_FramePipeline.hpp"
+
+using namespace al;
+
+// Stands in for a window, closing after a number of frames
+struct FakeWindow : FrameLoopTarget {
+    int framesLeft;
+    int presented = 0;
+    FakeWindow(int frames) : framesLeft(frames) {}
+    bool loopShouldStop() override { return framesLeft <= 0; }
+    void presentFrame() override {
+        presented++;
+        framesLeft--;
+    }
+};
+
+struct SimState {
+    int frame = 0;
+    int values[64] = {0};
+};
+
+static void sleepMs(int ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+TEST_CASE("TripleBuffer") {
+    TripleBuffer<int> buffer(-1);
+    REQUIRE(!buffer.update());
+    REQUIRE(buffer.readBuffer() == -1);
+
+    buffer.writeBuffer() = 1;
+    buffer.publish();
+    buffer.writeBuffer() = 2;
+    buffer.publish();
+    REQUIRE(buffer.update());
+    REQUIRE(buffer.readBuffer() == 2);
+    REQUIRE(!buffer.update());
+    REQUIRE(buffer.readBuffer() == 2);
+
+    // The reader only sees complete states, in order
+    TripleBuffer<SimState> states;
+    const int numStates = 20000;
+    std::thread writer([&]() {
+        for (int i = 1; i <= numStates; i++) {
+            SimState &s = states.writeBuffer();
+            s.frame = i;
+            for (auto &v : s.values) v = i;
+            states.publish();
+        }
+    });
+    int last = 0;
+    bool consistent = true;
+    while (last < numStates) {
+        if (states.update()) {
+            const SimState &s = states.readBuffer();
+            consistent &= s.frame > last;
+            for (auto v : s.values) consistent &= v == s.frame;
+            last = s.frame;
+        }
+    }
+    writer.join();
+    REQUIRE(consistent);
+}
+
+TEST_CASE("FramePipeline runs simulation ahead of rendering") {
+    FramePipeline<SimState> pipeline;
+    std::vector<int> rendered;
+    std::thread::id simThread;
+    pipeline.onSimulate([&](double dt, SimState &s) {
+        s.frame++;
+        simThread = std::this_thread::get_id();
+    });
+    pipeline.onRender([&](double dt, const SimState &s) { rendered.push_back(s.frame); });
+
+    SimState initial;
+    initial.frame = 100;
+    pipeline.start(initial);
+    FakeWindow window(10);
+    FPS fps;
+    fps.fps(1000);
+    pipeline.run(window, fps);
+
+    // Each frame shows the state simulated during the previous frame
+    REQUIRE(window.presented == 10);
+    REQUIRE(rendered.size() == 10);
+    for (int i = 0; i < 10; i++) {
+        REQUIRE(rendered[i] == 100 + i);
+    }
+    REQUIRE(pipeline.simulatedFrames() == 10);
+    REQUIRE(simThread != std::this_thread::get_id());
+    REQUIRE(!pipeline.running());
+
+    auto &stats = pipeline.stats();
+    REQUIRE(stats.render.count == 10);
+    REQUIRE(stats.present.count == 10);
+    REQUIRE(stats.wait.count == 10);
+    REQUIRE(stats.frame.count == 9);
+    REQUIRE(stats.simulate.count >= 9);
+
+    // Serial loop renders each state in the frame it is simulated
+    FramePipeline<SimState> serial;
+    rendered.clear();
+    serial.pipelined(false);
+    serial.onSimulate([&](double dt, SimState &s) {
+        s.frame++;
+        simThread = std::this_thread::get_id();
+    });
+    serial.onRender([&](double dt, const SimState &s) { rendered.push_back(s.frame); });
+    serial.start(SimState());
+    for (int i = 0; i < 5; i++) serial.frame(0.01);
+    serial.stop();
+    REQUIRE(rendered == std::vector<int>({1, 2, 3, 4, 5}));
+    REQUIRE(simThread == std::this_thread::get_id());
+}
+
+TEST_CASE("FramePipeline overlaps simulation and rendering") {
+    auto runFrames = [](bool pipelined) {
+        FramePipeline<SimState> pipeline;
+        pipeline.pipelined(pipelined);
+        pipeline.onSimulate([](double dt, SimState &s) {
+            sleepMs(20);
+            s.frame++;
+        });
+        pipeline.onRender([](double dt, const SimState &s) { sleepMs(20); });
+        pipeline.start(SimState());
+        FakeWindow window(8);
+        FPS fps;
+        fps.fps(1000);
+        auto start = std::chrono::steady_clock::now();
+        pipeline.run(window, fps);
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        REQUIRE(pipeline.stats().simulate.mean >= 0.019);
+        REQUIRE(pipeline.stats().render.mean >= 0.019);
+        return seconds;
+    };
+    double serial = runFrames(false);
+    double pipelined = runFrames(true);
+    REQUIRE(serial >= 8 * 0.04);
+    REQUIRE(pipelined < serial * 0.8);
+}
+
+TEST_CASE("FramePipeline without waiting for simulation") {
+    FramePipeline<SimState> pipeline;
+    pipeline.waitForSimulation(false);
+    pipeline.onSimulate([](double dt, SimState &s) {
+        sleepMs(15);
+        s.frame++;
+    });
+    std::vector<int> rendered;
+    pipeline.onRender([&](double dt, const SimState &s) {
+        sleepMs(1);
+        rendered.push_back(s.frame);
+    });
+    pipeline.start(SimState());
+    FakeWindow window(40);
+    FPS fps;
+    fps.fps(1000);
+    pipeline.run(window, fps);
+
+    // Rendering did not block on the slow simulation, and repeated states
+    REQUIRE(rendered.size() == 40);
+    REQUIRE(pipeline.simulatedFrames() < 30);
+    REQUIRE(rendered.back() > 0);
+    for (size_t i = 1; i < rendered.size(); i++) {
+        REQUIRE(rendered[i] >= rendered[i - 1]);
+    }
+    REQUIRE(pipeline.stats().wait.count == 0);
+}
@@ -0,0 +1,176 @@
+#include <map>
+#include <random>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "al/core/graphics/al_Shapes.hpp"
+
+using namespace al;
+
+// Mesh::compress as it was implemented with a tree of maps
+static void referenceCompress(Mesh &m) {
+    typedef std::map<float, int> Zmap;
+    typedef std::map<float, Zmap> Ymap;
+    typedef std::map<float, Ymap> Xmap;
+    Xmap xmap;
+    Mesh old(m);
+    for (int i = m.vertices().size() - 1; i >= 0; i--) {
+        Mesh::Vertex &v = m.vertices()[i];
+        xmap[v.x][v.y][v.z] = i;
+    }
+    std::map<int, int> imap;
+    m.reset();
+    for (size_t i = 0; i < old.vertices().size(); i++) {
+        Mesh::Vertex &v = old.vertices()[i];
+        int idx = xmap[v.x][v.y][v.z];
+        auto it = imap.find(idx);
+        if (it != imap.end()) {
+            m.index(it->second);
+        } else {
+            int newidx = m.vertices().size();
+            m.vertex(v);
+            if (old.normals().size()) m.normal(old.normals()[i]);
+            imap[idx] = newidx;
+            m.index(newidx);
+        }
+    }
+}
+
+// Weld by comparing each vertex with all previous representatives
+static std::vector<int> referenceWeld(const Mesh::Vertices &verts, float epsilon) {
+    std::vector<int> rep(verts.size());
+    for (size_t i = 0; i < verts.size(); i++) {
+        rep[i] = i;
+        for (size_t j = 0; j < i; j++) {
+            if (rep[j] == int(j) && (verts[i] - verts[j]).mag() <= epsilon) {
+                rep[i] = j;
+                break;
+            }
+        }
+    }
+    return rep;
+}
+
+TEST_CASE("Mesh compress") {
+    Mesh m;
+    addIcosphere(m, 1, 4);
+    m.generateNormals();
+    m.decompress();
+    REQUIRE(m.indices().empty());
+
+    Mesh expected = m;
+    referenceCompress(expected);
+    Mesh compressed = m;
+    compressed.compress();
+    REQUIRE(compressed.vertices().size() == 2562);
+    REQUIRE(compressed.vertices() == expected.vertices());
+    REQUIRE(compressed.normals() == expected.normals());
+    REQUIRE(compressed.indices() == expected.indices());
+
+    // Chunked welding gives the same result
+    for (unsigned threads : {3u, 0u}) {
+        Mesh welded = m;
+        welded.weld(0, 0, 0, threads);
+        REQUIRE(welded.vertices() == expected.vertices());
+        REQUIRE(welded.indices() == expected.indices());
+    }
+
+    // Negative zero is the same position as zero
+    Mesh zeros(Mesh::POINTS);
+    zeros.vertex(0, 0, 0);
+    zeros.vertex(-0.f, 0, -0.f);
+    zeros.compress();
+    REQUIRE(zeros.vertices().size() == 1);
+}
+
+TEST_CASE("Mesh weld") {
+    // Points on a coarse grid, jittered so that some are within epsilon of
+    // points in neighboring cells and chains of near points form
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> grid(0, 9);
+    std::uniform_real_distribution<float> jitter(-0.04f, 0.04f);
+    Mesh points(Mesh::POINTS);
+    for (int i = 0; i < 2000; i++) {
+        points.vertex(grid(rng) * 0.1f + jitter(rng), grid(rng) * 0.1f + jitter(rng),
+                      jitter(rng));
+    }
+    const float epsilon = 0.03f;
+    auto rep = referenceWeld(points.vertices(), epsilon);
+    std::vector<Mesh::Vertex> expected;
+    std::vector<unsigned> expectedIndices;
+    std::vector<int> newIndex(rep.size());
+    for (size_t i = 0; i < rep.size(); i++) {
+        if (rep[i] == int(i)) {
+            newIndex[i] = expected.size();
+            expected.push_back(points.vertices()[i]);
+        }
+        expectedIndices.push_back(newIndex[rep[i]]);
+    }
+    REQUIRE(expected.size() < 1000);
+
+    for (unsigned threads : {1u, 0u}) {
+        Mesh welded = points;
+        size_t removed = welded.weld(epsilon, 0, 0, threads);
+        REQUIRE(removed == points.vertices().size() - expected.size());
+        REQUIRE(welded.vertices() == expected);
+        REQUIRE(welded.indices() == expectedIndices);
+    }
+
+    // Indexed meshes have their indices remapped
+    Mesh sphere;
+    addIcosphere(sphere, 1, 2);
+    Mesh split = sphere;
+    split.decompress();
+    split.indices().clear();
+    for (size_t i = 0; i < split.vertices().size(); i++) {
+        split.vertices()[i] += Vec3f(jitter(rng), jitter(rng), jitter(rng)) * 0.001f;
+        split.index(i);
+    }
+    split.weld(0.001f);
+    REQUIRE(split.vertices().size() == sphere.vertices().size());
+    REQUIRE(split.indices().size() == sphere.indices().size());
+    for (size_t i = 0; i < split.indices().size(); i++) {
+        float d = (split.vertices()[split.indices()[i]] -
+                   sphere.vertices()[sphere.indices()[i]]).mag();
+        REQUIRE(d < 0.001f);
+    }
+}
+
+TEST_CASE("Mesh weld with attributes") {
+    // A cube with one normal per face keeps its hard edges
+    Mesh cube;
+    addCube(cube);
+    cube.decompress();
+    cube.generateNormals();
+    Mesh flat(Mesh::TRIANGLES);
+    for (size_t i = 0; i < cube.vertices().size(); i += 3) {
+        Vec3f n = cross(cube.vertices()[i + 1] - cube.vertices()[i],
+                        cube.vertices()[i + 2] - cube.vertices()[i]).normalize();
+        for (int k = 0; k < 3; k++) {
+            flat.vertex(cube.vertices()[i + k]);
+            flat.normal(n);
+            flat.texCoord(float(k), 0.f);
+        }
+    }
+
+    Mesh byPosition = flat;
+    byPosition.weld();
+    REQUIRE(byPosition.vertices().size() == 8);
+    REQUIRE(byPosition.normals().size() == 8);
+
+    Mesh byNormal = flat;
+    byNormal.weld(0, Mesh::WELD_NORMALS);
+    REQUIRE(byNormal.vertices().size() == 24);
+
+    // Tolerance on attributes
+    Mesh nearNormal = flat;
+    nearNormal.normals()[1] += Vec3f(0.01f, 0, 0);
+    nearNormal.weld(0, Mesh::WELD_NORMALS, 0.02f);
+    REQUIRE(nearNormal.vertices().size() == 24);
+
+    Mesh byTexCoord = flat;
+    byTexCoord.weld(0, Mesh::WELD_NORMALS | Mesh::WELD_TEXCOORDS);
+    REQUIRE(byTexCoord.vertices().size() > 24);
+    REQUIRE(byTexCoord.texCoord2s().size() == byTexCoord.vertices().size());
+}
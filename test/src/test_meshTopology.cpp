@@ -0,0 +1,250 @@
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "al/core/graphics/al_MeshTopology.hpp"
+#include "al/core/graphics/al_Shapes.hpp"
+
+using namespace al;
+
+// Adjacency sets built the way Mesh::smooth used to
+static std::map<int, std::set<int>> referenceAdjacency(const Mesh &m) {
+    std::map<int, std::set<int>> nodes;
+    for (size_t i = 0; i + 2 < m.indices().size(); i += 3) {
+        int i0 = m.indices()[i], i1 = m.indices()[i + 1], i2 = m.indices()[i + 2];
+        nodes[i0].insert(i1);
+        nodes[i0].insert(i2);
+        nodes[i1].insert(i2);
+        nodes[i1].insert(i0);
+        nodes[i2].insert(i0);
+        nodes[i2].insert(i1);
+    }
+    return nodes;
+}
+
+// Midpoint subdivision using a map of edges, as subdivide used to
+static void referenceSubdivide(Mesh &m) {
+    std::map<uint64_t, unsigned> cache;
+    Mesh::Index newIndex = m.vertices().size();
+    Mesh::Indices oldIndices(m.indices());
+    m.indices().clear();
+    for (unsigned j = 0; j < oldIndices.size(); j += 3) {
+        Mesh::Index *corner = &oldIndices[j];
+        Mesh::Index mid[3];
+        for (unsigned i = 0; i < 3; ++i) {
+            uint64_t i1 = corner[i];
+            uint64_t i2 = corner[(i + 1) % 3];
+            uint64_t key = i1 < i2 ? (i1 << 32) | i2 : (i2 << 32) | i1;
+            auto it = cache.find(key);
+            if (it != cache.end()) {
+                mid[i] = it->second;
+            } else {
+                cache[key] = newIndex;
+                m.vertex((m.vertices()[i1] + m.vertices()[i2]) * 0.5);
+                mid[i] = newIndex++;
+            }
+        }
+        Mesh::Index newIndices[] = {corner[0], mid[0], mid[2], corner[1], mid[1], mid[0],
+                                    corner[2], mid[2], mid[1], mid[0],    mid[1], mid[2]};
+        m.index(newIndices, 12);
+    }
+}
+
+// Icosphere with jittered vertices
+static Mesh noisySphere(int divisions) {
+    Mesh m;
+    addIcosphere(m, 1, divisions);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+    for (auto &v : m.vertices()) v += Vec3f(jitter(rng), jitter(rng), jitter(rng));
+    return m;
+}
+
+TEST_CASE("MeshTopology structure") {
+    Mesh m;
+    addIcosahedron(m);
+    MeshTopology topology(m);
+    REQUIRE(topology.numVertices() == 12);
+    REQUIRE(topology.numFaces() == 20);
+    REQUIRE(topology.numEdges() == 30);
+
+    for (size_t e = 0; e < topology.numEdges(); e++) {
+        const auto &edge = topology.edges()[e];
+        REQUIRE(edge.v0 < edge.v1);
+        REQUIRE(!topology.isBoundary(e));
+        if (e > 0) {
+            const auto &prev = topology.edges()[e - 1];
+            REQUIRE((prev.v0 < edge.v0 || (prev.v0 == edge.v0 && prev.v1 < edge.v1)));
+        }
+        // Opposite vertices are the third corners of the two faces
+        for (int side = 0; side < 2; side++) {
+            Mesh::Index f = topology.edgeFace(e, side);
+            Mesh::Index o = topology.edgeOpposite(e, side);
+            REQUIRE(o != edge.v0);
+            REQUIRE(o != edge.v1);
+            int found = 0;
+            for (int i = 0; i < 3; i++) {
+                Mesh::Index v = topology.faces()[f * 3 + i];
+                found += (v == edge.v0 || v == edge.v1 || v == o);
+            }
+            REQUIRE(found == 3);
+        }
+    }
+
+    for (size_t f = 0; f < topology.numFaces(); f++) {
+        for (int i = 0; i < 3; i++) {
+            const auto &edge = topology.edges()[topology.faceEdge(f, i)];
+            Mesh::Index a = topology.faces()[f * 3 + i];
+            Mesh::Index b = topology.faces()[f * 3 + (i + 1) % 3];
+            REQUIRE(std::min(a, b) == edge.v0);
+            REQUIRE(std::max(a, b) == edge.v1);
+        }
+    }
+
+    auto reference = referenceAdjacency(m);
+    for (Mesh::Index v = 0; v < 12; v++) {
+        REQUIRE(topology.valence(v) == 5);
+        REQUIRE(topology.numVertexFaces(v) == 5);
+        std::vector<int> expected(reference[v].begin(), reference[v].end());
+        std::vector<int> neighbors(topology.neighbors(v), topology.neighbors(v) + 5);
+        REQUIRE(neighbors == expected);
+    }
+
+    // A single triangle has only boundary edges
+    Mesh tri;
+    tri.vertex(0, 0, 0);
+    tri.vertex(1, 0, 0);
+    tri.vertex(0, 1, 0);
+    tri.index(0, 1, 2);
+    topology.build(tri);
+    REQUIRE(topology.numEdges() == 3);
+    for (int e = 0; e < 3; e++) {
+        REQUIRE(topology.isBoundary(e));
+        REQUIRE(topology.edgeFace(e, 1) == MeshTopology::none);
+    }
+
+    Mesh lines(Mesh::LINES);
+    lines.vertex(0, 0, 0);
+    lines.vertex(1, 0, 0);
+    lines.index(0);
+    lines.index(1);
+    REQUIRE(!topology.build(lines));
+    REQUIRE(topology.numEdges() == 0);
+}
+
+TEST_CASE("MeshTopology matches previous mesh processing") {
+    // Large enough to be split between threads
+    Mesh m = noisySphere(5);
+
+    // Neighbors match adjacency sets
+    MeshTopology topology(m);
+    auto reference = referenceAdjacency(m);
+    for (const auto &node : reference) {
+        std::vector<int> expected(node.second.begin(), node.second.end());
+        const Mesh::Index *adjs = topology.neighbors(node.first);
+        std::vector<int> neighbors(adjs, adjs + topology.valence(node.first));
+        REQUIRE(neighbors == expected);
+    }
+
+    // Smoothing gives identical results with any number of threads
+    for (int weighting = 0; weighting < 2; weighting++) {
+        Mesh expected = m;
+        Mesh::Vertices vertsCopy(m.vertices());
+        for (const auto &node : reference) {
+            Mesh::Vertex sum(0, 0, 0);
+            float sumw = 0;
+            for (auto adj : node.second) {
+                if (weighting == 0) {
+                    sum += vertsCopy[adj];
+                } else {
+                    float w = 1. / (vertsCopy[adj] - vertsCopy[node.first]).mag();
+                    sumw += w;
+                    sum += vertsCopy[adj] * w;
+                }
+            }
+            if (weighting == 0) sum /= node.second.size();
+            else sum /= sumw;
+            auto &orig = expected.vertices()[node.first];
+            orig = (sum - orig) * 0.7f + orig;
+        }
+
+        Mesh smoothed = m;
+        smoothed.smooth(0.7f, weighting);
+        REQUIRE(smoothed.vertices() == expected.vertices());
+        for (unsigned threads : {2u, 7u, 0u}) {
+            smoothed = m;
+            topology.smooth(smoothed, 0.7f, weighting, threads);
+            REQUIRE(smoothed.vertices() == expected.vertices());
+        }
+    }
+
+    // Normals
+    Mesh expected = m;
+    expected.generateNormals();
+    Mesh normals = m;
+    topology.generateNormals(normals, true, false, 3);
+    REQUIRE(normals.normals() == expected.normals());
+    expected.generateNormals(false, true);
+    topology.generateNormals(normals, false, true, 0);
+    REQUIRE(normals.normals() == expected.normals());
+
+    // Subdivision gives the same vertices and indices
+    Mesh sub = m;
+    subdivide(sub, 2);
+    expected = m;
+    referenceSubdivide(expected);
+    referenceSubdivide(expected);
+    REQUIRE(sub.vertices() == expected.vertices());
+    REQUIRE(sub.indices() == expected.indices());
+}
+
+TEST_CASE("Loop subdivision") {
+    Mesh m;
+    addIcosahedron(m);
+    subdivideLoop(m, 2);
+    MeshTopology topology(m);
+    REQUIRE(topology.numFaces() == 20 * 16);
+    REQUIRE(topology.numVertices() == 162);
+    REQUIRE(topology.numEdges() == 480);
+    for (size_t e = 0; e < topology.numEdges(); e++) {
+        REQUIRE(!topology.isBoundary(e));
+    }
+    // The surface shrinks inside the icosahedron, symmetrically
+    float r = m.vertices()[0].mag();
+    REQUIRE(r < 1.f);
+    for (Mesh::Index v = 0; v < 12; v++) {
+        REQUIRE(m.vertices()[v].mag() == Approx(r));
+    }
+
+    // Results are independent of the number of threads
+    Mesh a = noisySphere(5);
+    Mesh b = a;
+    subdivideLoop(a, 1, 1);
+    subdivideLoop(b, 1, 0);
+    REQUIRE(a.vertices() == b.vertices());
+    REQUIRE(a.indices() == b.indices());
+
+    // Boundary vertices follow the boundary curve, corners stay in place and
+    // a flat mesh stays flat
+    Mesh quad;
+    quad.vertex(0, 0, 0);
+    quad.vertex(1, 0, 0);
+    quad.vertex(1, 1, 0);
+    quad.vertex(0, 1, 0);
+    quad.vertex(0.5, 0.5, 0);
+    quad.index(0, 1, 4);
+    quad.index(1, 2, 4);
+    quad.index(2, 3, 4);
+    quad.index(3, 0, 4);
+    subdivideLoop(quad, 1);
+    REQUIRE(quad.vertices().size() == 5 + 8);
+    REQUIRE(quad.vertices()[0] == Vec3f(0.125f, 0.125f, 0));
+    REQUIRE(quad.vertices()[4].x == Approx(0.5f));
+    REQUIRE(quad.vertices()[4].y == Approx(0.5f));
+    for (const auto &v : quad.vertices()) {
+        REQUIRE(v.z == 0);
+    }
+}
@@ -1,10 +1,214 @@
+#include <atomic>
+
+#include <random>
+#include <thread>
+#include <vector>
 
 #include "catch.hpp"
 
 #include "al/core/io/al_MIDI.hpp"
+#include "al/core/io/al_AudioIOData.hpp"
+#include "al/util/scene/al_PolySynth.hpp"
 
 using namespace al;
 
+// Writes a single sample at the frame it is triggered on
+class ClickVoice : public SynthVoice {
+public:
+    void onProcess(AudioIOData& io) override {
+        if (io()) {
+            io.out(0) += 1.f;
+        }
+        free();
+    }
+};
+
+// Simulates audio callbacks at jittered host times and regularly spaced MIDI
+// messages, and returns the absolute frame each message is processed at,
+// minus the frame of its host time
+static std::vector<double> simulateCallbacks(MIDIMessageQueue &queue, double jitter,
+                                             PolySynth *synth = nullptr,
+                                             AudioIOData *io = nullptr,
+                                             std::vector<long> *clickFrames = nullptr) {
+    const unsigned fpb = 512;
+    const double sr = 48000;
+    const double period = fpb / sr;
+    const double start = 1000;
+    const int numBlocks = 2000;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> uniform(-jitter, jitter);
+
+    std::vector<double> errors;
+    double nextEvent = start + 0.05;
+    int note = 0;
+    for (int k = 0; k < numBlocks; k++) {
+        double callbackTime = start + k * period + uniform(rng);
+        while (nextEvent < callbackTime) {
+            queue.push(MIDIMessage(0, 0, MIDIByte::NOTE_ON, note++ % 128, 100), nextEvent);
+            nextEvent += 0.0073;
+        }
+        queue.audioBlock(fpb, sr, callbackTime);
+        MIDIMessage m(0, 0, 0);
+        int offsetFrames;
+        while (queue.pop(m, offsetFrames)) {
+            REQUIRE(offsetFrames >= 0);
+            REQUIRE(offsetFrames < int(fpb));
+            if (k > 100) { // Allow the loop to settle
+                errors.push_back(k * double(fpb) + offsetFrames - (m.timeStamp() - start) * sr);
+            }
+            if (synth) {
+                synth->triggerOn(synth->getVoice<ClickVoice>(), offsetFrames);
+                clickFrames->push_back(long(k) * fpb + offsetFrames);
+            }
+        }
+        if (synth) {
+            io->zeroOut();
+            synth->render(*io);
+            for (unsigned i = 0; i < fpb; i++) {
+                if (io->outBuffer(0)[i] != 0.f) {
+                    REQUIRE(!clickFrames->empty());
+                    REQUIRE(long(k) * fpb + i == clickFrames->front());
+                    clickFrames->erase(clickFrames->begin());
+                }
+            }
+        }
+    }
+    return errors;
+}
+
+TEST_CASE( "MIDI message queue timing" ) {
+    // Callbacks jittered by up to 2 ms would move messages by more than a
+    // whole buffer if they were processed at the start of the buffer
+    MIDIMessageQueue queue;
+    queue.jitterMargin(0.002);
+    auto errors = simulateCallbacks(queue, 0.002);
+    REQUIRE(errors.size() > 1000);
+    double minError = errors[0], maxError = errors[0];
+    for (double e : errors) {
+        minError = std::min(minError, e);
+        maxError = std::max(maxError, e);
+    }
+    // Constant latency of one buffer and the margin, with jitter under 1 ms
+    REQUIRE(minError > 512);
+    REQUIRE(maxError < 512 + 0.002 * 48000 + 48);
+    REQUIRE(maxError - minError < 48);
+    REQUIRE(queue.dropped() == 0);
+
+    // Without callback jitter timing is exact to the frame
+    MIDIMessageQueue steadyQueue;
+    errors = simulateCallbacks(steadyQueue, 0);
+    for (double e : errors) {
+        REQUIRE(e == Approx(errors[0]).margin(1.0));
+    }
+
+    // Full queue drops messages
+    MIDIMessageQueue smallQueue(4);
+    for (int i = 0; i < 10; i++) {
+        smallQueue.push(MIDIMessage(0, 0, MIDIByte::NOTE_ON, 60, 100), i);
+    }
+    REQUIRE(smallQueue.dropped() == 6);
+}
+
+TEST_CASE( "MIDI message queue triggers voices at offsets" ) {
+    AudioIOData io;
+    io.framesPerBuffer(512);
+    io.framesPerSecond(48000);
+    io.channelsIn(0);
+    io.channelsOut(1);
+    PolySynth synth;
+    synth.allocatePolyphony<ClickVoice>(16);
+
+    MIDIMessageQueue queue;
+    queue.jitterMargin(0.002);
+    std::vector<long> clickFrames;
+    simulateCallbacks(queue, 0.002, &synth, &io, &clickFrames);
+    REQUIRE(clickFrames.empty());
+}
+
+TEST_CASE( "MIDI message queue with concurrent writers" ) {
+    const int numWriters = 4;
+    const int numMessages = 20000;
+    MIDIMessageQueue queue(64);
+    std::vector<std::thread> writers;
+    for (int w = 0; w < numWriters; w++) {
+        writers.emplace_back([&queue, w]() {
+            for (int i = 0; i < numMessages; i++) {
+                // Message index in the time stamp, writer in the port
+                MIDIMessage m(0, w, MIDIByte::CONTROL_CHANGE, 1, i % 128);
+                while (!queue.push(m, i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    std::vector<int> next(numWriters, 0);
+    int received = 0;
+    bool inOrder = true;
+    MIDIMessage m(0, 0, 0);
+    while (received < numWriters * numMessages) {
+        if (queue.pop(m)) {
+            int w = m.port();
+            inOrder = inOrder && m.timeStamp() == next[w]
+                      && m.bytes[2] == next[w] % 128;
+            next[w]++;
+            received++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    for (auto &t : writers) {
+        t.join();
+    }
+    REQUIRE(inOrder);
+    REQUIRE(!queue.pop(m));
+}
+
+struct ThreadRecorder : public MIDIMessageHandler {
+    void onMIDIMessage(const MIDIMessage& m) override {
+        notes.push_back(m.noteNumber());
+        threadId = std::this_thread::get_id();
+    }
+    std::vector<int> notes;
+    std::thread::id threadId;
+};
+
+TEST_CASE( "MIDI message dispatcher" ) {
+    ThreadRecorder recorder;
+    MIDIMessageDispatcher dispatcher(recorder);
+    for (int note = 60; note < 64; note++) {
+        dispatcher.queue().onMIDIMessage(MIDIMessage(0, 0, MIDIByte::NOTE_ON, note, 100));
+    }
+    dispatcher.start();
+    REQUIRE(dispatcher.running());
+    dispatcher.stop();
+    REQUIRE(recorder.notes == std::vector<int>({60, 61, 62, 63}));
+    REQUIRE(recorder.threadId != std::this_thread::get_id());
+}
+
+struct CountingHandler : public MIDIMessageHandler {
+    void onMIDIMessage(const MIDIMessage& m) override { count++; }
+    std::atomic<int> count {0};
+};
+
+TEST_CASE( "MIDI message dispatcher wakes on new messages" ) {
+    CountingHandler handler;
+    // The worker would sleep for 10 s if a message did not wake it
+    MIDIMessageDispatcher dispatcher(handler, 10.0);
+    dispatcher.start();
+    al_sleep(0.05); // let the worker start waiting
+    al_sec start = al_steady_time();
+    std::thread midiThread([&]() {
+        dispatcher.queue().onMIDIMessage(MIDIMessage(0, 0, MIDIByte::NOTE_ON, 60, 100));
+    });
+    midiThread.join();
+    while (handler.count.load() == 0 && al_steady_time() - start < 5.0) {
+        al_sleep(0.001);
+    }
+    REQUIRE(handler.count.load() == 1);
+    REQUIRE(al_steady_time() - start < 1.0);
+    dispatcher.stop();
+}
+
 #ifndef TRAVIS_BUILD
 
 TEST_CASE( "MIDI test" ) {
@@ -0,0 +1,220 @@
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "al/util/al_BVH.hpp"
+#include "al/util/ui/al_PickableManager.hpp"
+
+using namespace al;
+
+static BVH::Bounds randomBox(std::mt19937 &rng) {
+    std::uniform_real_distribution<float> pos(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> size(0.01f, 0.5f);
+    Vec3f min(pos(rng), pos(rng), pos(rng));
+    return BVH::Bounds(min, min + Vec3f(size(rng), size(rng), size(rng)));
+}
+
+static Rayd randomRay(std::mt19937 &rng) {
+    std::uniform_real_distribution<double> pos(-10.0, 10.0);
+    Vec3d o(pos(rng), pos(rng), 20.0);
+    Vec3d target(pos(rng) * 0.5, pos(rng) * 0.5, 0.0);
+    return Rayd(o, (target - o).normalize());
+}
+
+// Nearest box hit, testing every box
+static int nearestBox(const std::vector<BVH::Bounds> &boxes, const Rayd &ray, double &t) {
+    int nearest = -1;
+    t = 1e10;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        Rayd r = ray;
+        double ti = r.intersectBox(Vec3d(boxes[i].center()), Vec3d(boxes[i].max - boxes[i].min));
+        if (ti > 0 && ti < t) {
+            t = ti;
+            nearest = (int) i;
+        }
+    }
+    return nearest;
+}
+
+static void checkQueries(BVH &bvh, const std::vector<BVH::Bounds> &boxes, std::mt19937 &rng) {
+    int hits = 0;
+    for (int q = 0; q < 500; q++) {
+        Rayd ray = randomRay(rng);
+        double tExpected, t;
+        int expected = nearestBox(boxes, ray, tExpected);
+        int item = bvh.intersect(ray, t, [&](int i) {
+            Rayd r = ray;
+            return r.intersectBox(Vec3d(boxes[i].center()), Vec3d(boxes[i].max - boxes[i].min));
+        });
+        REQUIRE(item == expected);
+        if (item >= 0) {
+            REQUIRE(t == Approx(tExpected));
+            hits++;
+        }
+    }
+    REQUIRE(hits > 0);
+}
+
+TEST_CASE( "BVH nearest hit" ) {
+    std::mt19937 rng(1);
+    std::vector<BVH::Bounds> boxes;
+    for (int i = 0; i < 2000; i++) {
+        boxes.push_back(randomBox(rng));
+    }
+    BVH bvh;
+    bvh.build(boxes);
+    REQUIRE(bvh.size() == 2000);
+    REQUIRE(bvh.depth() < 48);
+    REQUIRE(bvh.cost() > 0.0f);
+    REQUIRE(bvh.cost() < 200.0f); // Far fewer tests than the 2000 of a linear search
+    checkQueries(bvh, boxes, rng);
+
+    // Every box is contained by the nodes above it
+    for (size_t n = 0; n < bvh.nodes().size(); n++) {
+        auto &node = bvh.nodes()[n];
+        if (node.parent >= 0) {
+            auto parent = bvh.nodes()[node.parent].bounds;
+            parent.extend(node.bounds);
+            REQUIRE(parent == bvh.nodes()[node.parent].bounds);
+        }
+    }
+
+    // Empty tree
+    BVH empty;
+    double t;
+    REQUIRE(empty.intersect(randomRay(rng), t, [](int) { return 1.0; }) == -1);
+}
+
+TEST_CASE( "BVH refit and rebuild" ) {
+    std::mt19937 rng(2);
+    std::vector<BVH::Bounds> boxes;
+    for (int i = 0; i < 1000; i++) {
+        boxes.push_back(randomBox(rng));
+    }
+    BVH bvh;
+    bvh.build(boxes);
+
+    // Move half of the boxes
+    for (int i = 0; i < 1000; i += 2) {
+        boxes[i] = randomBox(rng);
+        bvh.update(i, boxes[i]);
+    }
+    checkQueries(bvh, boxes, rng);
+    REQUIRE(bvh.cost() > bvh.buildCost());
+
+    REQUIRE(bvh.rebuildAsync());
+    REQUIRE(!bvh.rebuildAsync());
+    REQUIRE(bvh.rebuilding());
+    // Boxes that move during the rebuild are refit into the new tree
+    for (int i = 1; i < 1000; i += 2) {
+        boxes[i] = randomBox(rng);
+        bvh.update(i, boxes[i]);
+    }
+    REQUIRE(bvh.finishRebuild(true));
+    REQUIRE(!bvh.rebuilding());
+    checkQueries(bvh, boxes, rng);
+
+    for (int i = 0; i < 1000; i++) {
+        REQUIRE(bvh.bounds(i) == boxes[i]);
+    }
+}
+
+TEST_CASE( "PickableManager BVH picking" ) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+    Mesh box;
+    box.vertex(-0.1f, -0.1f, -0.1f);
+    box.vertex(0.1f, 0.1f, 0.1f);
+
+    const int numPickables = 300;
+    std::unique_ptr<Pickable[]> pickables(new Pickable[numPickables]);
+    PickableManager manager;
+    for (int i = 0; i < numPickables; i++) {
+        Pickable &p = pickables[i];
+        p.set(box);
+        p.pose = Pose(Vec3f(uniform(rng), uniform(rng), uniform(rng)) * 5.0f,
+                      Quatf().fromEuler(uniform(rng), uniform(rng), uniform(rng)));
+        p.scale = 1.0f + 0.5f * uniform(rng);
+        manager << p;
+    }
+
+    auto compare = [&]() {
+        int hits = 0;
+        for (int q = 0; q < 200; q++) {
+            Rayd ray(Vec3d(uniform(rng) * 5, uniform(rng) * 5, 20),
+                     Vec3d(uniform(rng) * 0.1, uniform(rng) * 0.1, -1).normalize());
+            Hit expected = manager.intersectAll(ray);
+            Hit h = manager.intersect(ray);
+            REQUIRE(h.hit == expected.hit);
+            if (h.hit) {
+                REQUIRE(h.p == expected.p);
+                REQUIRE(h.t == Approx(expected.t));
+                hits++;
+            }
+        }
+        REQUIRE(hits > 0);
+    };
+    compare();
+
+    // Changing poses and scales through the parameters refits the BVH
+    for (int i = 0; i < numPickables; i += 3) {
+        pickables[i].pose.setPos(Vec3f(uniform(rng), uniform(rng), uniform(rng)) * 5.0f);
+        pickables[i + 1].scale = 2.0f;
+        pickables[i + 2].scaleVec = Vec3f(0.5f, 2.0f, 1.0f);
+    }
+    compare();
+
+    // Pointing only hovers the pickable hit
+    Rayd ray(Vec3d(pickables[0].pose.get().pos()) + Vec3d(0, 0, 20), Vec3d(0, 0, -1));
+    Hit h = manager.intersect(ray);
+    REQUIRE(h.hit);
+    manager.point(ray);
+    REQUIRE(static_cast<Pickable *>(h.p)->hover.get());
+    Rayd miss(Vec3d(100, 100, 20), Vec3d(0, 0, -1));
+    manager.point(miss);
+    for (int i = 0; i < numPickables; i++) {
+        REQUIRE(!pickables[i].hover.get());
+    }
+}
+
+TEST_CASE( "PickableManager pickable lifetime" ) {
+    Mesh box;
+    box.vertex(-0.1f, -0.1f, -0.1f);
+    box.vertex(0.1f, 0.1f, 0.1f);
+
+    std::vector<std::unique_ptr<Pickable>> pickables;
+    std::unique_ptr<PickableManager> manager(new PickableManager);
+    for (int i = 0; i < 4; i++) {
+        pickables.emplace_back(new Pickable);
+        pickables.back()->set(box);
+        pickables.back()->pose.setPos(Vec3f(i, 0, 0));
+        *manager << *pickables.back();
+    }
+    Rayd ray(Vec3d(3, 0, 20), Vec3d(0, 0, -1));
+    Rayd ray1(Vec3d(1, 0, 20), Vec3d(0, 0, -1));
+    REQUIRE(manager->intersect(ray).p == pickables[3].get());
+    manager->point(ray);
+
+    // A destroyed pickable unregisters itself, the last one takes its index
+    pickables[1].reset();
+    REQUIRE(manager->pickables().size() == 3);
+    pickables[3]->pose.setPos(Vec3f(1, 0, 0));
+    Hit h = manager->intersect(ray1);
+    REQUIRE(h.p == pickables[3].get());
+    REQUIRE(!manager->intersect(ray).hit);
+
+    // A hovered pickable can be destroyed
+    manager->point(ray1);
+    pickables[3].reset();
+    REQUIRE(manager->pickables().size() == 2);
+    manager->point(ray);
+
+    // Pickables outliving the manager can still be changed and destroyed
+    manager.reset();
+    pickables[0]->pose.setPos(Vec3f(5, 0, 0));
+    pickables[2]->scale = 2.0f;
+    pickables.clear();
+}
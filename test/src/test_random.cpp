@@ -0,0 +1,184 @@
+#include <cmath>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "al/core/math/al_Random.hpp"
+#include "al/core/math/al_Vec.hpp"
+
+using namespace al;
+
+// Bulk generation must give the same values as repeated single calls,
+// including when it starts or ends partway through the generator's blocks
+template <class RNG>
+static void requireSameSequence(RNG a, RNG b) {
+    for (size_t n : {0, 1, 3, 7, 8, 33, 100, 1000}) {
+        std::vector<uint32_t> bulk(n);
+        a(bulk.data(), n);
+        for (size_t i = 0; i < n; i++) {
+            REQUIRE(bulk[i] == b());
+        }
+    }
+    REQUIRE(a() == b());
+}
+
+TEST_CASE( "Random engines bulk generation" ) {
+    requireSameSequence(rnd::LinCon(17), rnd::LinCon(17));
+    requireSameSequence(rnd::MulLinCon(17), rnd::MulLinCon(17));
+    requireSameSequence(rnd::Tausworthe(17), rnd::Tausworthe(17));
+    requireSameSequence(rnd::Philox(17, 3), rnd::Philox(17, 3));
+}
+
+TEST_CASE( "Philox counter based generator" ) {
+    // Known answers from the Random123 library
+    uint32_t out[4];
+    rnd::Philox zero(0, 0);
+    zero.blocks<1>(0, out);
+    REQUIRE(out[0] == 0x6627e8d5);
+    REQUIRE(out[1] == 0xe169c58d);
+    REQUIRE(out[2] == 0xbc57ac4c);
+    REQUIRE(out[3] == 0x9b00dbd8);
+    rnd::Philox ones(0xffffffffffffffffULL, 0xffffffffffffffffULL);
+    ones.blocks<1>(0xffffffffffffffffULL, out);
+    REQUIRE(out[0] == 0x408f276d);
+    REQUIRE(out[1] == 0x41c83b0e);
+    REQUIRE(out[2] == 0xa20bc7c6);
+    REQUIRE(out[3] == 0x6d5451fd);
+    rnd::Philox pi(0x299f31d0a4093822ULL, 0x0370734413198a2eULL);
+    pi.blocks<1>(0x85a308d3243f6a88ULL, out);
+    REQUIRE(out[0] == 0xd16cfe09);
+    REQUIRE(out[1] == 0x94fdcceb);
+    REQUIRE(out[2] == 0x5001e420);
+    REQUIRE(out[3] == 0x24126ea1);
+
+    // Jumping to a position gives the same values as generating up to it
+    rnd::Philox a(5, 1), b(5, 1);
+    std::vector<uint32_t> values(103);
+    a(values.data(), values.size());
+    for (uint64_t p : {0, 1, 4, 6, 99}) {
+        b.position(p);
+        REQUIRE(b.position() == p);
+        REQUIRE(b() == values[p]);
+        REQUIRE(b.position() == p + 1);
+    }
+
+    // Streams are independent, and reseeding restarts the stream
+    rnd::Philox s0(5, 0), s1(5, 1);
+    int equal = 0;
+    for (int i = 0; i < 1000; i++) {
+        equal += s0() == s1() ? 1 : 0;
+    }
+    REQUIRE(equal < 2);
+    s1.seed(5);
+    REQUIRE(s1.stream() == 1);
+    REQUIRE(s1() == values[0]);
+}
+
+TEST_CASE( "Random uniform integers to normal conversion" ) {
+    // Compare with the Box-Muller transform in double precision
+    rnd::Tausworthe rng(99);
+    const size_t n = 10006; // Leaves pairs after the SIMD blocks
+    std::vector<uint32_t> bits(n);
+    rng(bits.data(), n);
+    bits[0] = 0xffffffff; // Zero radius
+    bits[2] = 0;          // Largest radius
+    std::vector<float> y(n);
+    rnd::uintToNormal(bits.data(), y.data(), n);
+    int far = 0;
+    for (size_t i = 0; i < n; i += 2) {
+        double u1 = ((bits[i] >> 8) + 1) / 16777216.0;
+        double angle = 2 * M_PI * (bits[i + 1] >> 8) / 16777216.0;
+        double r = std::sqrt(-2 * std::log(u1));
+        far += std::abs(y[i] - r * std::cos(angle)) > 2e-6 * (1 + r) ? 1 : 0;
+        far += std::abs(y[i + 1] - r * std::sin(angle)) > 2e-6 * (1 + r) ? 1 : 0;
+    }
+    REQUIRE(far == 0);
+    REQUIRE(y[0] == 0.f);
+    REQUIRE(std::abs(y[2]) + std::abs(y[3]) > 5.7f);
+}
+
+// Mean, variance and histogram checks. Bounds are several standard errors
+// wide, so they only fail for broken generators.
+template <class RNG>
+static void checkDistributions() {
+    rnd::Random<RNG> rng(1234);
+    const size_t n = 1000000;
+    std::vector<float> v(n);
+
+    rng.uniform(v.data(), n);
+    double sum = 0, sumSqr = 0;
+    const int numBins = 100;
+    std::vector<int> bins(numBins, 0);
+    int outside = 0;
+    for (float x : v) {
+        outside += (x < 0.f || x >= 1.f) ? 1 : 0;
+        if (outside) break;
+        sum += x;
+        sumSqr += x * x;
+        bins[int(x * numBins)]++;
+    }
+    REQUIRE(outside == 0);
+    double mean = sum / n;
+    REQUIRE(mean == Approx(0.5).margin(0.002));
+    REQUIRE(sumSqr / n - mean * mean == Approx(1.0 / 12.0).margin(0.001));
+    double chiSquare = 0;
+    for (int count : bins) {
+        double expected = double(n) / numBins;
+        chiSquare += (count - expected) * (count - expected) / expected;
+    }
+    REQUIRE(chiSquare < 160); // 99.99% quantile for 99 degrees of freedom
+
+    rng.uniformS(v.data(), n);
+    sum = 0;
+    for (float x : v) {
+        outside += (x < -1.f || x >= 1.f) ? 1 : 0;
+        sum += x;
+    }
+    REQUIRE(outside == 0);
+    REQUIRE(sum / n == Approx(0).margin(0.004));
+
+    rng.normal(v.data(), n);
+    double moments[4] = {0, 0, 0, 0};
+    int withinOne = 0, infinite = 0;
+    for (float x : v) {
+        infinite += std::isfinite(x) ? 0 : 1;
+        double p = 1;
+        for (int k = 0; k < 4; k++) {
+            p *= x;
+            moments[k] += p;
+        }
+        withinOne += std::abs(x) < 1.f ? 1 : 0;
+    }
+    REQUIRE(infinite == 0);
+    for (auto &m : moments) m /= n;
+    REQUIRE(moments[0] == Approx(0).margin(0.005));
+    REQUIRE(moments[1] == Approx(1).margin(0.01));
+    REQUIRE(moments[2] == Approx(0).margin(0.02));
+    REQUIRE(moments[3] == Approx(3).margin(0.05));
+    REQUIRE(double(withinOne) / n == Approx(0.682689).margin(0.003));
+
+    // Odd lengths fill every value
+    std::vector<float> odd(7, NAN);
+    rng.normal(odd.data(), odd.size());
+    for (float x : odd) REQUIRE(std::isfinite(x));
+
+    std::vector<Vec3f> points(100000);
+    rng.ball(points.data(), points.size());
+    int inner = 0;
+    Vec3f center(0, 0, 0);
+    for (auto &p : points) {
+        outside += p.magSqr() < 1.f ? 0 : 1;
+        inner += p.mag() < 0.5f ? 1 : 0;
+        center += p;
+    }
+    REQUIRE(outside == 0);
+    // The inner half radius ball has an eighth of the volume
+    REQUIRE(double(inner) / points.size() == Approx(0.125).margin(0.005));
+    REQUIRE(center.mag() / points.size() < 0.01f);
+}
+
+TEST_CASE( "Random bulk distributions" ) {
+    checkDistributions<rnd::Tausworthe>();
+    checkDistributions<rnd::LinCon>();
+    checkDistributions<rnd::Philox>();
+}
@@ -0,0 +1,123 @@
+#include <thread>
+
+#include "catch.hpp"
+
+#include "al/core/system/al_SharedMemory.hpp"
+
+using namespace al;
+
+#ifndef AL_WINDOWS
+
+TEST_CASE( "SharedMemoryRing consume in order" ) {
+    SharedMemoryRing writer;
+    REQUIRE(writer.create("al_test_ring", sizeof(int), 4, 2));
+
+    SharedMemoryRing reader;
+    REQUIRE(reader.open("al_test_ring"));
+    REQUIRE(reader.slotSize() == sizeof(int));
+    int id = reader.addReader();
+    REQUIRE(id >= 0);
+
+    int value = 0;
+    REQUIRE(!reader.consume(id, &value, sizeof(int)));
+
+    for (int i = 0; i < 3; i++) {
+        writer.publish(&i, sizeof(int));
+    }
+    REQUIRE(reader.pending(id) == 3);
+    for (int i = 0; i < 3; i++) {
+        size_t size = 0;
+        REQUIRE(reader.consume(id, &value, sizeof(int), &size));
+        REQUIRE(value == i);
+        REQUIRE(size == sizeof(int));
+    }
+    REQUIRE(!reader.consume(id, &value, sizeof(int)));
+
+    // Lap the reader. Oldest frames are dropped and counted.
+    for (int i = 0; i < 10; i++) {
+        writer.publish(&i, sizeof(int));
+    }
+    REQUIRE(reader.consume(id, &value, sizeof(int)));
+    REQUIRE(value == 6);
+    REQUIRE(reader.overruns(id) == 6);
+
+    REQUIRE(reader.consumeLatest(id, &value, sizeof(int)) == 3);
+    REQUIRE(value == 9);
+    REQUIRE(reader.consumeLatest(id, &value, sizeof(int)) == 0);
+
+    REQUIRE(reader.addReader() >= 0);
+    REQUIRE(reader.addReader() == -1);
+}
+
+TEST_CASE( "SharedMemoryRing releases readers and detects new segments" ) {
+    SharedMemoryRing writer;
+    REQUIRE(writer.create("al_test_ring", sizeof(int), 4, 2));
+
+    // Readers are released when their ring is closed, so restarting a reader
+    // more times than there are slots keeps working
+    for (int i = 0; i < 10; i++) {
+        SharedMemoryRing reader;
+        REQUIRE(reader.open("al_test_ring"));
+        REQUIRE(reader.addReader() >= 0);
+    }
+    {
+        SharedStateTaker<int> taker("al_test_ring");
+        REQUIRE(taker.start());
+        SharedStateTaker<int> taker2("al_test_ring");
+        REQUIRE(taker2.start());
+    }
+
+    SharedMemoryRing reader;
+    REQUIRE(reader.open("al_test_ring"));
+    REQUIRE(!reader.replaced());
+
+    // Writer restarted without closing the old segment
+    SharedMemoryRing restarted;
+    REQUIRE(restarted.create("al_test_ring", sizeof(int), 4, 2));
+    REQUIRE(reader.replaced());
+    REQUIRE(reader.open("al_test_ring"));
+    REQUIRE(!reader.replaced());
+
+    restarted.close();
+    REQUIRE(reader.replaced());
+}
+
+TEST_CASE( "SharedMemoryRing wait across threads" ) {
+    struct State {
+        double values[64];
+    };
+
+    SharedStateMaker<State> maker("al_test_state");
+    REQUIRE(maker.start());
+    SharedStateTaker<State> taker("al_test_state");
+    REQUIRE(taker.start());
+
+    const int numFrames = 1000;
+    std::thread writerThread([&]() {
+        State s;
+        for (int frame = 1; frame <= numFrames; frame++) {
+            for (auto &v : s.values) {
+                v = frame;
+            }
+            maker.set(s);
+            std::this_thread::yield();
+        }
+    });
+
+    State received;
+    int lastFrame = 0;
+    while (lastFrame < numFrames) {
+        if (taker.wait(1.0) && taker.get(received) > 0) {
+            // A torn frame would have mixed values
+            for (auto &v : received.values) {
+                REQUIRE(v == received.values[0]);
+            }
+            REQUIRE(received.values[0] > lastFrame);
+            lastFrame = (int) received.values[0];
+        }
+    }
+    writerThread.join();
+    REQUIRE(lastFrame == numFrames);
+}
+
+#endif
@@ -0,0 +1,117 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "catch.hpp"
+
+#include "al/util/scene/al_SynthEventLog.hpp"
+
+using namespace al;
+
+class LogTestVoice : public SynthVoice {
+public:
+    Parameter freq {"freq", "", 440.0};
+    Parameter amp {"amp", "", 0.5};
+    ParameterString label {"label", "", "lead"};
+    ParameterMenu wave {"wave"};
+
+    LogTestVoice() {
+        wave.setElements({"sine", "saw", "square"});
+        wave.set(1);
+        registerTriggerParameters(freq, amp, label, wave);
+    }
+};
+
+TEST_CASE( "SynthEventLog write and read" ) {
+    std::string fileName = "test_events.synthLog";
+    LogTestVoice voice;
+    voice.id(7);
+    voice.freq.set(220.0);
+
+    SynthEventLog log;
+    // Longer than the test, so only full chunks are written until close()
+    log.setFlushInterval(1000.0);
+    REQUIRE(log.open(fileName));
+    const int numEvents = 2000;
+    for (int i = 0; i < numEvents; i++) {
+        REQUIRE(log.logTriggerOn(&voice, i * 0.01));
+        REQUIRE(log.logTriggerOff(7, i * 0.01 + 0.005));
+    }
+    log.close();
+    REQUIRE(log.eventsWritten() == 2 * numEvents);
+    REQUIRE(log.eventsDropped() == 0);
+
+    std::vector<SynthEvent> events;
+    REQUIRE(SynthEventLog::read(fileName, events));
+    REQUIRE(events.size() == 2 * numEvents);
+    REQUIRE(events[0].type == TRIGGER_ON);
+    REQUIRE(events[0].id == 7);
+    REQUIRE(events[0].synthName == demangle(typeid(LogTestVoice).name()));
+    REQUIRE(events[0].pFields.size() == 4);
+    REQUIRE(events[0].pFields[0].get<float>() == 220.0f);
+    REQUIRE(events[0].pFields[1].get<float>() == 0.5f);
+    REQUIRE(events[0].pFields[2].get<std::string>() == "lead");
+    REQUIRE(events[0].pFields[3].get<std::string>() == "saw");
+    REQUIRE(events[1].type == TRIGGER_OFF);
+    REQUIRE(events[1].time == Approx(0.005));
+
+    // Simulate a crash in the middle of writing the last chunk
+    std::ifstream in(fileName, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), contents.size() - 100);
+    out.close();
+
+    events.clear();
+    REQUIRE(SynthEventLog::read(fileName, events));
+    // Only the partial chunk written by close() is lost
+    const int fullChunks = 2 * numEvents / SynthEventLog::recordsPerChunk;
+    REQUIRE(events.size() == (size_t) (fullChunks * SynthEventLog::recordsPerChunk));
+    std::remove(fileName.c_str());
+}
+
+TEST_CASE( "SynthEventLog rejects corrupt chunk headers" ) {
+    std::string fileName = "test_corrupt.synthLog";
+    LogTestVoice voice;
+    SynthEventLog log;
+    REQUIRE(log.open(fileName));
+    for (int i = 0; i < SynthEventLog::recordsPerChunk; i++) {
+        REQUIRE(log.logTriggerOn(&voice, i * 0.01));
+    }
+    log.close();
+
+    std::ifstream in(fileName, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    // The chunk headers (magic, type, count, payload size, crc) are not
+    // covered by the CRC. The names chunk follows the 16 byte file header.
+    const size_t namesChunk = 16;
+    uint32_t namesSize;
+    memcpy(&namesSize, contents.data() + namesChunk + 12, sizeof(namesSize));
+    const size_t recordsChunk = namesChunk + 20 + namesSize;
+    REQUIRE(recordsChunk + 20 < contents.size());
+
+    auto readCorrupted = [&](size_t offset, uint32_t value) {
+        std::string corrupted = contents;
+        memcpy(&corrupted[offset], &value, sizeof(value));
+        std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+        out.write(corrupted.data(), corrupted.size());
+        out.close();
+        std::vector<SynthEvent> events;
+        REQUIRE(SynthEventLog::read(fileName, events));
+        return events.size();
+    };
+    // Record count larger than the payload
+    REQUIRE(readCorrupted(recordsChunk + 8, 0xFFFFFFFF) == 0);
+    // Payload larger than the file
+    REQUIRE(readCorrupted(recordsChunk + 12, 0xFFFFFFF0) == 0);
+    // Name count larger than the names in the payload. The names read are
+    // kept but no records follow.
+    REQUIRE(readCorrupted(namesChunk + 8, 1000) == 0);
+    // Unmodified
+    REQUIRE(readCorrupted(namesChunk, 0x4b4e4843) == (size_t) SynthEventLog::recordsPerChunk);
+    std::remove(fileName.c_str());
+}
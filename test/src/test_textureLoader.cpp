@@ -0,0 +1,139 @@
+#include <atomic>
+#include <cstdio>
+
+#include "catch.hpp"
+
+#include "al/util/al_TextureLoader.hpp"
+
+using namespace al;
+
+TEST_CASE( "TextureUploadScheduler budget" ) {
+    TextureUploadScheduler scheduler;
+    scheduler.budget(1000);
+    scheduler.add(10, 100, 4); // 40 bytes per row, 4000 bytes
+    scheduler.add(1000, 2, 4); // Row larger than budget
+    REQUIRE(scheduler.pendingBytes() == 12000);
+
+    unsigned int rows = 0;
+    int frames = 0;
+    while (rows < 100) {
+        auto slices = scheduler.nextFrame();
+        REQUIRE(slices.size() == 1);
+        REQUIRE(slices[0].job == 0);
+        REQUIRE(slices[0].firstRow == rows);
+        REQUIRE(slices[0].bytes <= 1000);
+        rows += slices[0].numRows;
+        frames++;
+        REQUIRE(slices[0].last == (rows == 100));
+    }
+    REQUIRE(frames == 4);
+
+    // At least one row per frame
+    auto slices = scheduler.nextFrame();
+    REQUIRE(slices.size() == 1);
+    REQUIRE(slices[0].job == 1);
+    REQUIRE(slices[0].numRows == 1);
+    REQUIRE(!slices[0].last);
+    slices = scheduler.nextFrame();
+    REQUIRE(slices[0].last);
+    REQUIRE(scheduler.pending() == 0);
+    REQUIRE(scheduler.nextFrame().size() == 0);
+
+    // Small jobs share a frame
+    scheduler.add(2, 2, 4);
+    scheduler.add(2, 2, 4);
+    slices = scheduler.nextFrame();
+    REQUIRE(slices.size() == 2);
+    REQUIRE(slices[1].last);
+}
+
+TEST_CASE( "PixelBufferPool reuse" ) {
+    PixelBufferPool pool;
+    auto buffer = pool.acquire(1000);
+    REQUIRE(buffer.size() == 1000);
+    REQUIRE(pool.misses() == 1);
+    const uint8_t *data = buffer.data();
+    pool.release(std::move(buffer));
+    REQUIRE(pool.available() == 1);
+
+    auto reused = pool.acquire(500);
+    REQUIRE(reused.data() == data);
+    REQUIRE(pool.misses() == 1);
+    pool.release(std::move(reused));
+
+    REQUIRE(pool.acquire(2000).size() == 2000); // Too small to reuse
+    REQUIRE(pool.misses() == 2);
+
+    pool.maxPooledBytes(100);
+    pool.release(pool.acquire(0));
+    REQUIRE(pool.available() == 0);
+}
+
+TEST_CASE( "TextureLoader decode" ) {
+    TextureLoader loader(3);
+    REQUIRE(loader.numThreads() == 3);
+    std::atomic<int> decodes {0};
+    loader.decodeFunction([&](const std::string &path, imgModule::ImageData &image) {
+        decodes++;
+        if (path == "missing") {
+            return false;
+        }
+        image.width = 16;
+        image.height = 8;
+        image.data.resize(16 * 8 * 4);
+        for (size_t i = 0; i < image.data.size(); i++) {
+            image.data[i] = (uint8_t) i;
+        }
+        return true;
+    });
+
+    std::vector<TextureHandle> handles;
+    for (int i = 0; i < 20; i++) {
+        handles.push_back(loader.load("image" + std::to_string(i)));
+    }
+    TextureHandle missing = loader.load("missing");
+    loader.waitForDecodes();
+
+    REQUIRE(decodes == 21);
+    REQUIRE(loader.pendingDecodes() == 0);
+    REQUIRE(loader.pendingUploads() == 20);
+    for (auto &handle : handles) {
+        REQUIRE(handle.status() == TextureHandle::DECODED);
+        REQUIRE(handle.pending());
+        REQUIRE(handle.width() == 16);
+        REQUIRE(handle.height() == 8);
+        REQUIRE(handle.image().data[5] == 5);
+    }
+    REQUIRE(missing.failed());
+    REQUIRE(missing.width() == 0);
+    REQUIRE(!TextureHandle().valid());
+}
+
+TEST_CASE( "loadImage decodes into existing memory" ) {
+    // 3x2 RGB image, converted to RGBA when loaded
+    const char *fileName = "test_loadImage.ppm";
+    FILE *f = fopen(fileName, "wb");
+    REQUIRE(f);
+    fprintf(f, "P6\n3 2\n255\n");
+    for (int i = 0; i < 6; i++) {
+        unsigned char pixel[3] = {(unsigned char) (i * 10), 20, 30};
+        fwrite(pixel, 1, 3, f);
+    }
+    fclose(f);
+
+    imgModule::ImageData image;
+    image.data.reserve(1024);
+    const uint8_t *memory = image.data.data();
+    REQUIRE(imgModule::loadImage(fileName, image));
+    REQUIRE(image.width == 3);
+    REQUIRE(image.height == 2);
+    REQUIRE(image.data.size() == 3 * 2 * 4);
+    REQUIRE(image.data.data() == memory);
+    REQUIRE(image.data[4 * 5] == 50);
+    REQUIRE(image.data[4 * 5 + 1] == 20);
+    REQUIRE(image.data[4 * 5 + 3] == 255);
+
+    REQUIRE(!imgModule::loadImage("missing.ppm", image));
+    REQUIRE(image.data.empty());
+    std::remove(fileName);
+}
@@ -0,0 +1,109 @@
+#include <random>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "al/core/math/al_VecBatch.hpp"
+
+using namespace al;
+
+template <class T>
+static void requireClose(const Vec<3, T> &a, const Vec<3, T> &b) {
+    for (int c = 0; c < 3; c++) {
+        REQUIRE(a[c] == Approx(b[c]).margin(1e-6));
+    }
+}
+
+template <class T>
+static void requireClose(const Quat<T> &a, const Quat<T> &b) {
+    for (int c = 0; c < 4; c++) {
+        REQUIRE(a.components[c] == Approx(b.components[c]).margin(1e-6));
+    }
+}
+
+// Compares every operation with the scalar Vec, Quat and Mat functions, for
+// sizes that leave all possible remainders after the SIMD blocks
+template <class T>
+static void compareWithScalar(std::mt19937 &rng) {
+    std::uniform_real_distribution<T> uniform(-2, 2);
+    auto randomVec = [&]() { return Vec<3, T>(uniform(rng), uniform(rng), uniform(rng)); };
+    auto randomQuat = [&]() {
+        return Quat<T>().fromEuler(uniform(rng), uniform(rng), uniform(rng));
+    };
+
+    Mat<4, T> m;
+    for (int i = 0; i < 16; i++) m[i] = uniform(rng);
+    Quat<T> q = randomQuat();
+
+    for (size_t n = 0; n < 20; n++) {
+        std::vector<Vec<3, T>> a(n), b(n), out(n);
+        std::vector<Quat<T>> qa(n), qb(n), qout(n);
+        for (size_t i = 0; i < n; i++) {
+            a[i] = randomVec();
+            b[i] = randomVec();
+            qa[i] = randomQuat();
+            qb[i] = randomQuat();
+        }
+
+        VecBatch::rotate(q, a.data(), out.data(), n);
+        for (size_t i = 0; i < n; i++) requireClose(out[i], q.rotate(a[i]));
+
+        VecBatch::rotate(qa.data(), a.data(), out.data(), n);
+        for (size_t i = 0; i < n; i++) requireClose(out[i], qa[i].rotate(a[i]));
+
+        VecBatch::transform(m, a.data(), out.data(), n);
+        for (size_t i = 0; i < n; i++) {
+            requireClose(out[i], Vec<3, T>(m * Vec<4, T>(a[i], 1)));
+        }
+        VecBatch::transform(m, a.data(), out.data(), n, T(0));
+        for (size_t i = 0; i < n; i++) {
+            requireClose(out[i], Vec<3, T>(m * Vec<4, T>(a[i], 0)));
+        }
+
+        std::vector<T> dots(n);
+        VecBatch::dot(a.data(), b.data(), dots.data(), n);
+        for (size_t i = 0; i < n; i++) REQUIRE(dots[i] == Approx(a[i].dot(b[i])));
+
+        VecBatch::multiply(qa.data(), qb.data(), qout.data(), n);
+        for (size_t i = 0; i < n; i++) requireClose(qout[i], qa[i] * qb[i]);
+
+        // In place
+        out = a;
+        VecBatch::normalize(out.data(), n);
+        for (size_t i = 0; i < n; i++) requireClose(out[i], a[i].normalized());
+        out = a;
+        VecBatch::rotate(q, out.data(), out.data(), n);
+        for (size_t i = 0; i < n; i++) requireClose(out[i], q.rotate(a[i]));
+
+        for (size_t i = 0; i < n; i++) qout[i] = qa[i] * T(1.5);
+        VecBatch::normalize(qout.data(), n);
+        for (size_t i = 0; i < n; i++) requireClose(qout[i], qa[i]);
+    }
+
+    // Degenerate values behave like the scalar functions
+    std::vector<Vec<3, T>> zeros(9, Vec<3, T>(0, 0, 0));
+    VecBatch::normalize(zeros.data(), zeros.size());
+    for (auto &v : zeros) REQUIRE((v == Vec<3, T>(1, 0, 0)));
+    std::vector<Quat<T>> quats(9, Quat<T>(0, 0, 0, 0));
+    quats[4] = Quat<T>(2, 0, 0, 0);
+    VecBatch::normalize(quats.data(), quats.size());
+    for (auto &quat : quats) requireClose(quat, Quat<T>::identity());
+}
+
+TEST_CASE( "VecBatch matches scalar math" ) {
+    auto sets = VecBatch::instructionSets();
+    REQUIRE(sets.size() >= 1);
+    REQUIRE(std::string(sets.back()) == "scalar");
+    REQUIRE(std::string(VecBatch::instructionSet()) == sets.front());
+    REQUIRE(!VecBatch::useInstructionSet("unknown"));
+
+    std::mt19937 rng(1);
+    for (auto set : sets) {
+        INFO(set);
+        REQUIRE(VecBatch::useInstructionSet(set));
+        REQUIRE(std::string(VecBatch::instructionSet()) == set);
+        compareWithScalar<float>(rng);
+        compareWithScalar<double>(rng);
+    }
+    VecBatch::useInstructionSet(sets.front());
+}